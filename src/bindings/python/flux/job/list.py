@@ -25,6 +25,13 @@ class JobListRPC(RPC):
         for job in self.get_jobs():
             yield JobInfo(job)
 
+    def get_cursor(self):
+        """
+        Return the cursor for the next page of results, or None if
+        max_entries was not reached.
+        """
+        return self.get().get("cursor")
+
 
 # Due to subtleties in the python bindings and this call, this binding
 # is more of a reimplementation of flux_job_list() instead of calling
@@ -44,6 +51,7 @@ def job_list(
     since=0.0,
     name=None,
     queue=None,
+    cursor=None,
 ):
     payload = {
         "max_entries": int(max_entries),
@@ -57,6 +65,8 @@ def job_list(
         payload["name"] = name
     if queue:
         payload["queue"] = queue
+    if cursor:
+        payload["cursor"] = int(cursor)
     return JobListRPC(flux_handle, "job-list.list", payload)
 
 
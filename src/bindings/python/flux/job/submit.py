@@ -8,6 +8,7 @@
 # SPDX-License-Identifier: LGPL-3.0
 ###############################################################
 import errno
+import os
 
 from _flux._core import ffi, lib
 from flux import constants
@@ -26,6 +27,30 @@ class SubmitFuture(Future):
         return submit_get_id(self)
 
 
+class SubmitBulkFuture(Future):
+    """Future subclass representing the job IDs of a bulk submission."""
+
+    def get_ids(self):
+        """Return a list of job IDs in the order the jobs were submitted.
+
+        A job that was rejected is represented by an OSError instance.
+        """
+        return submit_bulk_get_ids(self)
+
+
+def _submit_flags(waitable, debug, pre_signed, novalidate):
+    flags = 0
+    if waitable:
+        flags |= constants.FLUX_JOB_WAITABLE
+    if debug:
+        flags |= constants.FLUX_JOB_DEBUG
+    if pre_signed:
+        flags |= constants.FLUX_JOB_PRE_SIGNED
+    if novalidate:
+        flags |= constants.FLUX_JOB_NOVALIDATE
+    return flags
+
+
 def submit_async(
     flux_handle,
     jobspec,
@@ -66,15 +91,7 @@ def submit_async(
     :rtype: SubmitFuture
     """
     jobspec = _convert_jobspec_arg_to_string(jobspec)
-    flags = 0
-    if waitable:
-        flags |= constants.FLUX_JOB_WAITABLE
-    if debug:
-        flags |= constants.FLUX_JOB_DEBUG
-    if pre_signed:
-        flags |= constants.FLUX_JOB_PRE_SIGNED
-    if novalidate:
-        flags |= constants.FLUX_JOB_NOVALIDATE
+    flags = _submit_flags(waitable, debug, pre_signed, novalidate)
     future_handle = RAW.submit(flux_handle, jobspec, urgency, flags)
     return SubmitFuture(future_handle)
 
@@ -135,3 +152,99 @@ def submit(
     """
     future = submit_async(flux_handle, jobspec, urgency, waitable, debug, pre_signed)
     return future.get_id()
+
+
+def submit_bulk_async(
+    flux_handle,
+    jobspecs,
+    urgency=lib.FLUX_JOB_URGENCY_DEFAULT,
+    waitable=False,
+    debug=False,
+    pre_signed=False,
+    novalidate=False,
+):
+    """Ask Flux to run a list of jobs in one request, without waiting
+
+    Submit jobs to Flux with a single job-ingest request.  All jobs are
+    submitted with the same urgency and flags.  This method returns
+    immediately with a Flux Future, which can be used obtain the job IDs
+    later.  See submit_async() for a description of the parameters.
+
+    :param jobspecs: list of jobspecs defining the job requests
+    :type jobspecs: list of Jobspec or their string encodings
+    :returns: a Flux Future object for obtaining the assigned jobids
+    :rtype: SubmitBulkFuture
+    """
+    specs = []
+    for jobspec in jobspecs:
+        jobspec = _convert_jobspec_arg_to_string(jobspec)
+        if isinstance(jobspec, str):
+            jobspec = jobspec.encode("utf-8", errors="surrogateescape")
+        specs.append(ffi.new("char[]", jobspec))
+    flags = _submit_flags(waitable, debug, pre_signed, novalidate)
+    future_handle = RAW.submit_bulk(
+        flux_handle, len(specs), ffi.new("const char *[]", specs), urgency, flags
+    )
+    return SubmitBulkFuture(future_handle)
+
+
+@check_future_error
+def submit_bulk_get_ids(future):
+    """Get job IDs from a Future returned by job.submit_bulk_async()
+
+    Process a response to a Flux bulk job submit request.  This method
+    blocks until the response is received, then decodes the result to
+    obtain the assigned job IDs.
+
+    :param future: a Flux future object returned by job.submit_bulk_async()
+    :type future: Future
+    :returns: list of job IDs in the order the jobs were submitted, with
+        an OSError instance in place of each job that was rejected
+    :rtype: list
+    """
+    if future is None or future == ffi.NULL:
+        raise EnvironmentError(errno.EINVAL, "future must not be None/NULL")
+    future.wait_for()  # ensure the future is fulfilled
+    count = RAW.submit_bulk_count(future)
+    jobid = ffi.new("flux_jobid_t[1]")
+    errstr = ffi.new("const char *[1]")
+    result = []
+    for index in range(count):
+        errstr[0] = ffi.NULL
+        ffi.errno = 0
+        if lib.flux_job_submit_bulk_get_id(future.handle, index, jobid, errstr) < 0:
+            errnum = ffi.errno
+            if errstr[0] != ffi.NULL:
+                errmsg = ffi.string(errstr[0]).decode("utf-8", errors="replace")
+            else:
+                errmsg = os.strerror(errnum)
+            result.append(OSError(errnum, errmsg))
+        else:
+            result.append(JobID(jobid[0]))
+    return result
+
+
+def submit_bulk(
+    flux_handle,
+    jobspecs,
+    urgency=lib.FLUX_JOB_URGENCY_DEFAULT,
+    waitable=False,
+    debug=False,
+    pre_signed=False,
+    novalidate=False,
+):
+    """Submit a list of jobs to Flux in one request
+
+    Ask Flux to run a list of jobs, blocking until job IDs are assigned.
+    See submit_async() for a description of the parameters.
+
+    :param jobspecs: list of jobspecs defining the job requests
+    :type jobspecs: list of Jobspec or their string encodings
+    :returns: list of job IDs in the order the jobs were submitted, with
+        an OSError instance in place of each job that was rejected
+    :rtype: list
+    """
+    future = submit_bulk_async(
+        flux_handle, jobspecs, urgency, waitable, debug, pre_signed, novalidate
+    )
+    return future.get_ids()
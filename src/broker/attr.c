@@ -304,6 +304,39 @@ int attr_add_active_uint32 (attr_t *attrs, const char *name, uint32_t *val,
     return attr_add_active (attrs, name, flags, get_uint32, set_uint32, val);
 }
 
+static int get_uint64 (const char *name, const char **val, void *arg)
+{
+    uint64_t *i = arg;
+    static char s[32];
+    int n = snprintf (s, sizeof (s), "%" PRIu64, *i);
+
+    assert (n <= sizeof (s));
+    *val = s;
+    return 0;
+}
+
+static int set_uint64 (const char *name, const char *val, void *arg)
+{
+    uint64_t *i = arg;
+    char *endptr;
+    unsigned long long n;
+
+    errno = 0;
+    n = strtoull (val, &endptr, 0);
+    if (errno != 0 || *endptr != '\0') {
+        errno = EINVAL;
+        return -1;
+    }
+    *i = n;
+    return 0;
+}
+
+int attr_add_active_uint64 (attr_t *attrs, const char *name, uint64_t *val,
+                            int flags)
+{
+    return attr_add_active (attrs, name, flags, get_uint64, set_uint64, val);
+}
+
 int attr_get_uint32 (attr_t *attrs, const char *name, uint32_t *value)
 {
     const char *s;
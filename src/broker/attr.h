@@ -71,6 +71,8 @@ int attr_add_active_int (attr_t *attrs, const char *name, int *val,
                          int flags);
 int attr_add_active_uint32 (attr_t *attrs, const char *name, uint32_t *val,
                             int flags);
+int attr_add_active_uint64 (attr_t *attrs, const char *name, uint64_t *val,
+                            int flags);
 
 /* Get an attribute and parse it as an integer value.
  */
@@ -14,6 +14,7 @@
 #include "config.h"
 #endif
 #include <inttypes.h>
+#include <limits.h>
 #include <assert.h>
 #include <flux/core.h>
 
@@ -41,6 +42,16 @@ static const char *default_hash = "sha1";
 static const uint32_t default_cache_purge_target_size = 1024*1024*16;
 static const uint32_t default_cache_purge_old_entry = 10; // seconds
 
+/* The clean (valid, not dirty) entries are kept in a segmented LRU.
+ * New entries enter the probationary segment and are promoted to the
+ * protected segment on their first hit.  When content.purge-max-size is
+ * nonzero, the protected segment is limited to this percentage of it, and
+ * entries that overflow it are demoted back to probation.  Eviction takes
+ * from the tail of probation first, so one-time loads (e.g. a large KVS
+ * walk) cannot flush out the working set.
+ */
+static const int protected_percent = 80;
+
 /* Raise the max blob size value to 1GB so that large KVS values
  * (including KVS directories) can be supported while the KVS transitions
  * to the RFC 11 treeobj data representation.
@@ -50,13 +61,26 @@ static const uint32_t default_blob_size_limit = 1048576*1024;
 
 static const uint32_t default_flush_batch_limit = 256;
 
+/* Dirty entries are flushed to the backing store in content-backing.store-batch
+ * requests of at most this many blobs / bytes (a larger blob is sent alone).
+ */
+static const int store_batch_max = 64;
+static const int store_batch_max_bytes = 1048576*16;
+
 /* Hash digests are used as zhashx keys.  The digest size needs to be
  * available to zhashx comparator so make this global.
  */
 static int content_hash_size;
 
+struct content_batch;
+
+/* A request waiting on a cache entry:  either a request message, or
+ * slot 'index' of a content.load-batch or content.store-batch request.
+ */
 struct msgstack {
     const flux_msg_t *msg;
+    struct content_batch *batch;
+    int index;
     struct msgstack *next;
 };
 
@@ -72,6 +96,9 @@ struct cache_entry {
     uint8_t load_pending:1;
     uint8_t store_pending:1;
     uint8_t mmapped:1;
+    uint8_t copied:1;               // data_container is a malloc'd copy
+    uint8_t lru:1;                  // entry is on one of the LRU segments
+    uint8_t protected:1;            //   and that segment is 'protected'
     struct msgstack *load_requests;
     struct msgstack *store_requests;
     double lastused;
@@ -79,6 +106,14 @@ struct cache_entry {
     struct list_node list;
 };
 
+struct lru_segment {
+    struct list_head list;          // most recently used at the head
+    uint64_t size;                  // sum of entry sizes
+    uint32_t count;
+    uint64_t hits;
+    uint64_t evictions;
+};
+
 struct content_cache {
     flux_t *h;
     flux_reactor_t *reactor;
@@ -87,64 +122,280 @@ struct content_cache {
     uint32_t rank;
     zhashx_t *entries;
     uint8_t backing:1;              // 'content.backing' service available
+    uint8_t backing_nobatch:1;      //   but it does not support batches
     char *backing_name;
     const char *hash_name;
     struct msgstack *flush_requests;
 
-    struct list_head lru;           // LRU is for valid, clean entries only
+    struct lru_segment probation;   // LRU is for valid, clean entries only
+    struct lru_segment protected;
     struct list_head flush;         // dirties queued due to batch limit
 
     uint32_t blob_size_limit;
     uint32_t flush_batch_limit;
     uint32_t flush_batch_count;
+    int flush_errnum;               // store failed, hold off retrying
 
     uint32_t purge_target_size;
     uint32_t purge_old_entry;
+    uint64_t purge_max_size;        // hard limit on acct_size (0=unlimited)
 
     uint64_t acct_size;             // total size of all cache entries
     uint32_t acct_valid;            // count of valid cache entries
     uint32_t acct_dirty;            // count of dirty cache entries
+    uint64_t acct_misses;           // load requests not satisfied from cache
 
     struct content_checkpoint *checkpoint;
     struct content_mmap *mmap;
+
+    flux_watcher_t *prep_w;         // rank 0: batch stores made during
+    flux_watcher_t *check_w;        //   one reactor loop iteration
+    flux_watcher_t *idle_w;
+};
+
+/* A content.load-batch or content.store-batch request is answered once
+ * all of its slots have been fulfilled.  Load results are copied into the
+ * slots since the cache entries may be evicted before the batch completes.
+ */
+struct batch_slot {
+    int errnum;
+    int flags;
+    void *data;
+    int len;
+};
+
+struct content_batch {
+    struct content_cache *cache;
+    const flux_msg_t *msg;
+    bool store;
+    int pending;                    // unfulfilled slots (+1 during setup)
+    int count;
+    uint8_t *hashes;                // store: count digests for response
+    struct batch_slot slots[];
 };
 
 static void flush_respond (struct content_cache *cache);
 static int cache_flush (struct content_cache *cache);
 
+static void batch_destroy (struct content_batch *b)
+{
+    if (b) {
+        int saved_errno = errno;
+        int i;
+        for (i = 0; i < b->count; i++)
+            free (b->slots[i].data);
+        free (b->hashes);
+        flux_msg_decref (b->msg);
+        free (b);
+        errno = saved_errno;
+    }
+}
+
+/* Create a batch with 'count' slots.  The caller holds a reference
+ * (counted in 'pending') that must be dropped with batch_decref() once
+ * all slots have been fulfilled or queued on cache entries.
+ */
+static struct content_batch *batch_create (struct content_cache *cache,
+                                           const flux_msg_t *msg,
+                                           int count,
+                                           bool store)
+{
+    struct content_batch *b;
+
+    if (!(b = calloc (1, sizeof (*b) + count * sizeof (b->slots[0]))))
+        return NULL;
+    b->cache = cache;
+    b->store = store;
+    b->count = count;
+    b->pending = count + 1;
+    if (store && !(b->hashes = malloc (count * content_hash_size))) {
+        batch_destroy (b);
+        return NULL;
+    }
+    b->msg = flux_msg_incref (msg);
+    return b;
+}
+
+static void batch_respond_load (struct content_batch *b)
+{
+    flux_t *h = b->cache->h;
+    size_t size = 0;
+    size_t offset = 0;
+    char *payload;
+    int i;
+
+    for (i = 0; i < b->count; i++)
+        size += CONTENT_BATCH_RESULT_OVERHEAD + b->slots[i].len;
+    if (size > INT_MAX) {
+        errno = EOVERFLOW;
+        goto error;
+    }
+    if (!(payload = malloc (size)))
+        goto error;
+    for (i = 0; i < b->count; i++) {
+        offset += content_batch_encode_result (payload + offset,
+                                               b->slots[i].errnum,
+                                               b->slots[i].flags,
+                                               b->slots[i].data,
+                                               b->slots[i].len);
+    }
+    if (flux_respond_raw (h, b->msg, payload, size) < 0)
+        flux_log_error (h, "content load-batch: flux_respond_raw");
+    free (payload);
+    return;
+error:
+    if (flux_respond_error (h, b->msg, errno, NULL) < 0)
+        flux_log_error (h, "content load-batch: flux_respond_error");
+}
+
+/* A store batch is all-or-nothing from the requester's point of view.
+ */
+static void batch_respond_store (struct content_batch *b)
+{
+    flux_t *h = b->cache->h;
+    int i;
+
+    for (i = 0; i < b->count; i++) {
+        if (b->slots[i].errnum != 0) {
+            if (flux_respond_error (h, b->msg, b->slots[i].errnum, NULL) < 0)
+                flux_log_error (h, "content store-batch: flux_respond_error");
+            return;
+        }
+    }
+    if (flux_respond_raw (h,
+                          b->msg,
+                          b->hashes,
+                          b->count * content_hash_size) < 0)
+        flux_log_error (h, "content store-batch: flux_respond_raw");
+}
+
+static void batch_decref (struct content_batch *b)
+{
+    if (b && --b->pending == 0) {
+        if (b->store)
+            batch_respond_store (b);
+        else
+            batch_respond_load (b);
+        batch_destroy (b);
+    }
+}
+
+/* Fulfill batch slot 'index'.  On success, a load slot takes a copy of
+ * the data in valid cache entry 'e'.
+ */
+static void batch_fulfill (struct content_batch *b,
+                           int index,
+                           int errnum,
+                           const struct cache_entry *e)
+{
+    struct batch_slot *slot = &b->slots[index];
+
+    if (errnum == 0 && !b->store) {
+        if (e->len > 0) {
+            if (!(slot->data = malloc (e->len)))
+                errnum = ENOMEM;
+            else {
+                memcpy (slot->data, e->data, e->len);
+                slot->len = e->len;
+            }
+        }
+        if (e->ephemeral)
+            slot->flags |= CONTENT_BATCH_FLAG_EPHEMERAL;
+    }
+    slot->errnum = errnum;
+    batch_decref (b);
+}
+
 static int msgstack_push (struct msgstack **msp, const flux_msg_t *msg)
 {
     struct msgstack *ms;
     if (!(ms = malloc (sizeof (*ms))))
         return -1;
     ms->msg = flux_msg_incref (msg);
+    ms->batch = NULL;
+    ms->next = *msp;
+    *msp = ms;
+    return 0;
+}
+
+static int msgstack_push_batch (struct msgstack **msp,
+                                struct content_batch *batch,
+                                int index)
+{
+    struct msgstack *ms;
+    if (!(ms = malloc (sizeof (*ms))))
+        return -1;
+    ms->msg = NULL;
+    ms->batch = batch;
+    ms->index = index;
     ms->next = *msp;
     *msp = ms;
     return 0;
 }
 
-static const flux_msg_t *msgstack_pop (struct msgstack **msp)
+/* Pop the top node from the stack.  The caller must free it.
+ */
+static struct msgstack *msgstack_pop (struct msgstack **msp)
 {
     struct msgstack *ms;
-    const flux_msg_t *msg = NULL;
 
-    if ((ms = *msp)) {
+    if ((ms = *msp))
         *msp = ms->next;
-        msg = ms->msg;
-        free (ms);
-    }
-    return msg;
+    return ms;
 }
 
 static void msgstack_destroy (struct msgstack **msp)
 {
-    const flux_msg_t *msg;
-    while ((msg = msgstack_pop (msp)))
-        flux_msg_decref (msg);
+    struct msgstack *ms;
+    while ((ms = msgstack_pop (msp))) {
+        flux_msg_decref (ms->msg);
+        free (ms);
+    }
 }
 
 
+/* Set the payload of 'response' to 'data', 'len'.  If that is the
+ * content of cache entry 'e', share it rather than copying, so that a
+ * large blob is handed to the overlay without a copy.  A blob whose
+ * container is a message is shared with that message; a mmapped blob
+ * pins its mapping.
+ */
+static int response_set_payload (flux_msg_t *response,
+                                 const void *data,
+                                 int len,
+                                 const struct cache_entry *e)
+{
+    if (e && len > 0 && data == e->data && len == e->len) {
+        if (e->mmapped) {
+            void *pin;
+            if ((pin = content_mmap_region_pin (e->data_container,
+                                                data,
+                                                len))) {
+                if (flux_msg_set_payload_ref (response,
+                                              data,
+                                              len,
+                                              content_mmap_unpin,
+                                              pin) < 0) {
+                    ERRNO_SAFE_WRAP (content_mmap_unpin, pin);
+                    return -1;
+                }
+                return 0;
+            }
+        }
+        else if (!e->copied && e->data_container) {
+            const void *buf;
+            int size;
+            if (flux_msg_get_payload (e->data_container, &buf, &size) == 0
+                && buf == data
+                && size == len)
+                return flux_msg_set_payload_from (response, e->data_container);
+        }
+    }
+    return flux_msg_set_payload (response, data, len);
+}
+
 /* Respond identically to a list of requests.
+ * Batch slots on the list are fulfilled from 'e', if non-NULL.
  * The list is always run to completion.
  * On error, log at LOG_ERR level.
  */
@@ -153,18 +404,24 @@ static void request_list_respond_raw (struct msgstack **l,
                                       bool user1_flag,
                                       const void *data,
                                       int len,
+                                      const struct cache_entry *e,
                                       const char *type)
 {
-    const flux_msg_t *msg;
-    while ((msg = msgstack_pop (l))) {
-        flux_msg_t *response;
-        if (!(response = flux_response_derive (msg, 0))
-            || flux_msg_set_payload (response, data, len) < 0
-            || (user1_flag && flux_msg_set_user1 (response) < 0)
-            || flux_send (h, response, 0) < 0)
-            flux_log_error (h, "%s (%s):", __FUNCTION__, type);
-        flux_msg_decref (response);
-        flux_msg_decref (msg);
+    struct msgstack *ms;
+    while ((ms = msgstack_pop (l))) {
+        if (ms->batch)
+            batch_fulfill (ms->batch, ms->index, 0, e);
+        else {
+            flux_msg_t *response;
+            if (!(response = flux_response_derive (ms->msg, 0))
+                || response_set_payload (response, data, len, e) < 0
+                || (user1_flag && flux_msg_set_user1 (response) < 0)
+                || flux_send (h, response, 0) < 0)
+                flux_log_error (h, "%s (%s):", __FUNCTION__, type);
+            flux_msg_decref (response);
+            flux_msg_decref (ms->msg);
+        }
+        free (ms);
     }
 }
 
@@ -176,11 +433,16 @@ static void request_list_respond_error (struct msgstack **l,
                                         const char *errmsg,
                                         const char *type)
 {
-    const flux_msg_t *msg;
-    while ((msg = msgstack_pop (l))) {
-        if (flux_respond_error (h, msg, errnum, errmsg) < 0)
-            flux_log_error (h, "%s (%s):", __FUNCTION__, type);
-        flux_msg_decref (msg);
+    struct msgstack *ms;
+    while ((ms = msgstack_pop (l))) {
+        if (ms->batch)
+            batch_fulfill (ms->batch, ms->index, errnum, NULL);
+        else {
+            if (flux_respond_error (h, ms->msg, errnum, errmsg) < 0)
+                flux_log_error (h, "%s (%s):", __FUNCTION__, type);
+            flux_msg_decref (ms->msg);
+        }
+        free (ms);
     }
 }
 
@@ -194,6 +456,8 @@ static void cache_entry_destroy (struct cache_entry *e)
         assert (e->store_requests == NULL);
         if (e->mmapped)
             content_mmap_region_decref (e->data_container);
+        else if (e->copied)
+            free (e->data_container);
         else
             flux_msg_decref (e->data_container);
         free (e);
@@ -239,6 +503,120 @@ static struct cache_entry *cache_entry_create (const void *hash)
     return e;
 }
 
+static void lru_segment_init (struct lru_segment *seg)
+{
+    list_head_init (&seg->list);
+    seg->size = 0;
+    seg->count = 0;
+    seg->hits = 0;
+    seg->evictions = 0;
+}
+
+static void lru_segment_add (struct lru_segment *seg, struct cache_entry *e)
+{
+    list_add (&seg->list, &e->list);
+    seg->size += e->len;
+    seg->count++;
+}
+
+static void lru_segment_del (struct lru_segment *seg, struct cache_entry *e)
+{
+    list_del_from (&seg->list, &e->list);
+    seg->size -= e->len;
+    seg->count--;
+}
+
+/* Add a newly clean entry to the head of the probationary segment.
+ */
+static void lru_insert (struct content_cache *cache, struct cache_entry *e)
+{
+    assert (e->valid);
+    assert (!e->dirty);
+    assert (!e->lru);
+    lru_segment_add (&cache->probation, e);
+    e->lru = 1;
+    e->protected = 0;
+    e->lastused = flux_reactor_now (cache->reactor);
+}
+
+static void lru_remove (struct content_cache *cache, struct cache_entry *e)
+{
+    if (e->lru) {
+        lru_segment_del (e->protected ? &cache->protected : &cache->probation,
+                         e);
+        e->lru = 0;
+        e->protected = 0;
+    }
+}
+
+/* Demote entries from the tail of the protected segment to the head of
+ * probation until the protected segment is within its share of
+ * content.purge-max-size.  If there is no limit, nothing is demoted.
+ */
+static void lru_rebalance (struct content_cache *cache)
+{
+    uint64_t limit;
+    struct cache_entry *e;
+
+    if (cache->purge_max_size == 0)
+        return;
+    limit = (cache->purge_max_size / 100) * protected_percent;
+    while (cache->protected.size > limit
+        && (e = list_tail (&cache->protected.list, struct cache_entry, list))) {
+        lru_segment_del (&cache->protected, e);
+        lru_segment_add (&cache->probation, e);
+        e->protected = 0;
+    }
+}
+
+/* Record a hit on a clean entry:  promote it to (or refresh it at) the
+ * head of the protected segment.
+ */
+static void lru_touch (struct content_cache *cache, struct cache_entry *e)
+{
+    if (e->protected) {
+        cache->protected.hits++;
+        list_del_from (&cache->protected.list, &e->list);
+        list_add (&cache->protected.list, &e->list);
+    }
+    else {
+        cache->probation.hits++;
+        lru_segment_del (&cache->probation, e);
+        lru_segment_add (&cache->protected, e);
+        e->protected = 1;
+        lru_rebalance (cache);
+    }
+    e->lastused = flux_reactor_now (cache->reactor);
+}
+
+static void cache_entry_remove (struct content_cache *cache,
+                                struct cache_entry *e);
+
+/* Synchronously evict clean entries, least valuable first, until the cache
+ * is within content.purge-max-size.  Each eviction is O(1).  Dirty entries
+ * cannot be evicted, so the limit may be exceeded while they are pending.
+ * N.B. this may remove any clean entry, so callers must not hold a pointer
+ * to one across this call.
+ */
+static void cache_evict (struct content_cache *cache)
+{
+    struct lru_segment *seg;
+    struct cache_entry *e;
+
+    if (cache->purge_max_size == 0)
+        return;
+    while (cache->acct_size > cache->purge_max_size) {
+        seg = &cache->probation;
+        if (!(e = list_tail (&seg->list, struct cache_entry, list))) {
+            seg = &cache->protected;
+            if (!(e = list_tail (&seg->list, struct cache_entry, list)))
+                break;
+        }
+        seg->evictions++;
+        cache_entry_remove (cache, e);
+    }
+}
+
 static void cache_entry_dirty_clear (struct content_cache *cache,
                                      struct cache_entry *e)
 {
@@ -247,14 +625,19 @@ static void cache_entry_dirty_clear (struct content_cache *cache,
         e->dirty = 0;
 
         assert (e->valid);
-        list_add (&cache->lru, &e->list);
-        e->lastused = flux_reactor_now (cache->reactor);
+        /* An entry with a load in flight is kept off the LRU so it cannot
+         * be evicted while the load continuation holds a pointer to it.
+         * The continuation adds it to the LRU.
+         */
+        if (!e->load_pending)
+            lru_insert (cache, e);
 
         request_list_respond_raw (&e->store_requests,
                                   cache->h,
                                   false,
                                   e->hash,
                                   content_hash_size,
+                                  e,
                                   "store");
     }
 }
@@ -283,8 +666,34 @@ static struct cache_entry *cache_entry_insert (struct content_cache *cache,
     return e;
 }
 
+/* Fill an invalid cache entry with a private copy of 'data'.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+static int cache_entry_fill_copy (struct content_cache *cache,
+                                  struct cache_entry *e,
+                                  const void *data,
+                                  int len)
+{
+    void *cpy;
+
+    assert (!e->valid);
+    assert (!e->data_container);
+    if (!(cpy = malloc (len > 0 ? len : 1)))
+        return -1;
+    if (len > 0)
+        memcpy (cpy, data, len);
+    e->data_container = cpy;
+    e->data = cpy;
+    e->len = len;
+    e->copied = 1;
+    e->valid = 1;
+    cache->acct_valid++;
+    cache->acct_size += e->len;
+    return 0;
+}
+
 /* Look up a cache entry.
- * Move to front of LRU because it was looked up.
+ * Promote in LRU because it was looked up.
  * Returns entry on success, NULL on failure.
  * N.B. errno is not set
  */
@@ -299,11 +708,8 @@ static struct cache_entry *cache_entry_lookup (struct content_cache *cache,
     if (!(e = zhashx_lookup (cache->entries, hash)))
         return NULL;
 
-    if (e->valid && !e->dirty) {
-        list_del_from (&cache->lru, &e->list);
-        list_add (&cache->lru, &e->list);
-        e->lastused = flux_reactor_now (cache->reactor);
-    }
+    if (e->lru)
+        lru_touch (cache, e);
 
     return e;
 }
@@ -316,7 +722,10 @@ static void cache_entry_remove (struct content_cache *cache,
     assert (e->load_requests == NULL);
     assert (e->store_requests == NULL);
     assert (!e->dirty);
-    list_del (&e->list);
+    if (e->lru)
+        lru_remove (cache, e);
+    else
+        list_del (&e->list);
     if (e->valid) {
         cache->acct_size -= e->len;
         cache->acct_valid--;
@@ -352,10 +761,14 @@ static void cache_load_continuation (flux_future_t *f, void *arg)
         goto error;
     }
     /* N.B. the entry may already be valid if a store filled it while
-     * we were waiting for this load completion.  Do nothing in that case.
-     * Any pending load requests would have been answered already.
+     * we were waiting for this load completion.  Any pending load requests
+     * would have been answered already, so just add it to the LRU if clean.
      */
-    if (!e->valid) {
+    if (e->valid) {
+        if (!e->dirty && !e->lru)
+            lru_insert (cache, e);
+    }
+    else {
         assert (!e->data_container);
         assert (!e->dirty);
         if (flux_response_decode_raw (msg, NULL, &e->data, &e->len) < 0) {
@@ -368,16 +781,17 @@ static void cache_load_continuation (flux_future_t *f, void *arg)
             e->ephemeral = 1;
         cache->acct_valid++;
         cache->acct_size += e->len;
-        list_add (&cache->lru, &e->list);
-        e->lastused = flux_reactor_now (cache->reactor);
+        lru_insert (cache, e);
         request_list_respond_raw (&e->load_requests,
                                   cache->h,
                                   e->ephemeral ? true : 0, // FLUX_MSGFLAG_USER1
                                   e->data,
                                   e->len,
+                                  e,
                                   "load");
     }
     flux_future_destroy (f);
+    cache_evict (cache);
     return;
 error:
     request_list_respond_error (&e->load_requests,
@@ -409,6 +823,193 @@ static int cache_load (struct content_cache *cache, struct cache_entry *e)
     return 0;
 }
 
+/* Respond to requests waiting on an entry whose load failed, and remove it.
+ */
+static void cache_entry_load_fail (struct content_cache *cache,
+                                   struct cache_entry *e,
+                                   int errnum,
+                                   const char *errmsg)
+{
+    e->load_pending = 0;
+    request_list_respond_error (&e->load_requests,
+                                cache->h,
+                                errnum,
+                                errmsg,
+                                "load");
+    cache_entry_remove (cache, e);
+}
+
+/* The digests of the entries in a load batch are saved in the future, and
+ * entries are looked up again when the response arrives.
+ */
+struct load_batch {
+    int count;
+    uint8_t hashes[];
+};
+
+static void cache_load_batch_continuation (flux_future_t *f, void *arg)
+{
+    struct content_cache *cache = arg;
+    struct load_batch *lb = flux_future_aux_get (f, "batch");
+    bool fallback = false;
+    int errnum = 0;
+    int i;
+
+    if (flux_future_get (f, NULL) < 0) {
+        errnum = errno;
+        if (errno == ENOSYS && cache->rank == 0) {
+            if (cache->backing) {
+                flux_log (cache->h,
+                          LOG_DEBUG,
+                          "content load: backing store does not support"
+                          " batches");
+                cache->backing_nobatch = 1;
+                fallback = true;
+            }
+            else
+                errnum = ENOENT;
+        }
+        if (errnum != ENOENT && !fallback)
+            flux_log_error (cache->h, "content load-batch");
+    }
+    for (i = 0; i < lb->count; i++) {
+        struct cache_entry *e;
+        const void *data;
+        int len;
+        int flags;
+
+        e = zhashx_lookup (cache->entries, lb->hashes + i * content_hash_size);
+        if (!e || !e->load_pending)
+            continue;
+        e->load_pending = 0;
+        if (e->valid) {
+            if (!e->dirty && !e->lru)
+                lru_insert (cache, e);
+            continue;
+        }
+        if (fallback) {
+            if (cache_load (cache, e) < 0)
+                cache_entry_load_fail (cache, e, errno, NULL);
+            continue;
+        }
+        if (errnum != 0) {
+            cache_entry_load_fail (cache, e, errnum, NULL);
+            continue;
+        }
+        if (content_load_batch_get (f, i, &data, &len, &flags) < 0
+            || cache_entry_fill_copy (cache, e, data, len) < 0) {
+            if (errno != ENOENT)
+                flux_log_error (cache->h, "content load-batch");
+            cache_entry_load_fail (cache, e, errno, NULL);
+            continue;
+        }
+        if ((flags & CONTENT_BATCH_FLAG_EPHEMERAL))
+            e->ephemeral = 1;
+        lru_insert (cache, e);
+        request_list_respond_raw (&e->load_requests,
+                                  cache->h,
+                                  e->ephemeral ? true : 0, // FLUX_MSGFLAG_USER1
+                                  e->data,
+                                  e->len,
+                                  e,
+                                  "load");
+    }
+    flux_future_destroy (f);
+    cache_evict (cache);
+}
+
+/* Load 'count' invalid entries, which the caller has marked load_pending,
+ * with one request to the next level of TBON or, on rank 0, to the backing
+ * store.  Fall back to individual loads if batches are not supported.
+ * Entries that cannot be loaded are failed and removed.
+ */
+static void cache_load_batch (struct content_cache *cache,
+                              struct cache_entry **entries,
+                              int count)
+{
+    struct load_batch *lb;
+    flux_future_t *f = NULL;
+    int flags = CONTENT_FLAG_UPSTREAM;
+    int i;
+
+    if (count == 1 || (cache->rank == 0 && cache->backing_nobatch))
+        goto fallback;
+    if (cache->rank == 0)
+        flags = CONTENT_FLAG_CACHE_BYPASS;
+    if (!(lb = malloc (sizeof (*lb) + count * content_hash_size)))
+        goto error;
+    lb->count = count;
+    for (i = 0; i < count; i++) {
+        memcpy (lb->hashes + i * content_hash_size,
+                entries[i]->hash,
+                content_hash_size);
+    }
+    if (!(f = content_load_batch (cache->h,
+                                  lb->hashes,
+                                  content_hash_size,
+                                  count,
+                                  flags))
+        || flux_future_aux_set (f, "batch", lb, free) < 0) {
+        ERRNO_SAFE_WRAP (free, lb);
+        goto error;
+    }
+    if (flux_future_then (f, -1., cache_load_batch_continuation, cache) < 0)
+        goto error;
+    return;
+error:
+    flux_log_error (cache->h, "content load-batch");
+    flux_future_destroy (f);
+fallback:
+    for (i = 0; i < count; i++) {
+        entries[i]->load_pending = 0;
+        if (cache_load (cache, entries[i]) < 0)
+            cache_entry_load_fail (cache, entries[i], errno, NULL);
+    }
+}
+
+/* Look up blob in the rank 0 mmap regions, or ensure that it could
+ * be loaded from upstream or the backing store, then insert a new entry.
+ * An entry filled from a mmapped region is valid.
+ * Returns entry on success, NULL on failure with errno set.
+ */
+static struct cache_entry *cache_entry_insert_load (struct content_cache *cache,
+                                                    const void *hash,
+                                                    int hash_size)
+{
+    struct content_region *region = NULL;
+    const void *data = NULL;
+    int len = 0;
+    struct cache_entry *e;
+
+    if (cache->rank == 0) {
+        region = content_mmap_region_lookup (cache->mmap,
+                                             hash,
+                                             hash_size,
+                                             &data,
+                                             &len);
+        if (!region && !cache->backing) {
+            errno = ENOENT;
+            return NULL;
+        }
+    }
+    if (!(e = cache_entry_insert (cache, hash, hash_size))) {
+        flux_log_error (cache->h, "content load");
+        return NULL;
+    }
+    if (region) {
+        e->data_container = content_mmap_region_incref (region);
+        e->data = data;
+        e->len = len;
+        e->valid = 1;
+        e->ephemeral = 1;
+        e->mmapped = 1;
+        cache->acct_valid++;
+        cache->acct_size += e->len;
+        lru_insert (cache, e);
+    }
+    return e;
+}
+
 static void content_load_request (flux_t *h, flux_msg_handler_t *mh,
                                   const flux_msg_t *msg, void *arg)
 {
@@ -424,39 +1025,11 @@ static void content_load_request (flux_t *h, flux_msg_handler_t *mh,
         errno = EPROTO;
         goto error;
     }
-    if (!(e = cache_entry_lookup (cache, hash, hash_size))) {
-        struct content_region *region = NULL;
-        const void *data = NULL;
-        int len = 0;
-
-        if (cache->rank == 0) {
-            region = content_mmap_region_lookup (cache->mmap,
-                                                 hash,
-                                                 hash_size,
-                                                 &data,
-                                                 &len);
-            if (!region && !cache->backing) {
-                errno = ENOENT;
-                goto error;
-            }
-        }
-        if (!(e = cache_entry_insert (cache, hash, hash_size))) {
-            flux_log_error (h, "content load");
-            goto error;
-        }
-        if (region) {
-            e->data_container = content_mmap_region_incref (region);
-            e->data = data;
-            e->len = len;
-            e->valid = 1;
-            e->ephemeral = 1;
-            e->mmapped = 1;
-            cache->acct_valid++;
-            cache->acct_size += e->len;
-            list_add (&cache->lru, &e->list);
-            e->lastused = flux_reactor_now (cache->reactor);
-        }
-    }
+    if (!(e = cache_entry_lookup (cache, hash, hash_size))
+        || !e->valid)
+        cache->acct_misses++;
+    if (!e && !(e = cache_entry_insert_load (cache, hash, hash_size)))
+        goto error;
     if (!e->valid) {
         if (cache_load (cache, e) < 0)
             goto error;
@@ -483,12 +1056,13 @@ static void content_load_request (flux_t *h, flux_msg_handler_t *mh,
      */
     flux_msg_t *response;
     if (!(response = flux_response_derive (msg, 0))
-        || flux_msg_set_payload (response, e->data, e->len) < 0
+        || response_set_payload (response, e->data, e->len, e) < 0
         || (e->ephemeral && flux_msg_set_user1 (response) < 0)
         || flux_send (h, response, 0) < 0) {
         flux_log_error (h, "content load: error sending response");
     }
     flux_msg_decref (response);
+    cache_evict (cache);
     return;
 error:
     if (flux_respond_error (h, msg, errno, errmsg) < 0)
@@ -522,7 +1096,7 @@ static void cache_resume_flush (struct content_cache *cache)
 {
     if (cache->acct_dirty == 0 || (cache->rank == 0 && !cache->backing))
         flush_respond (cache);
-    else
+    else if (!cache->flush_errnum)
         (void)cache_flush (cache); /* resume flushing, subject to limits */
 }
 
@@ -552,6 +1126,7 @@ static void cache_store_continuation (flux_future_t *f, void *arg)
     }
     cache_entry_dirty_clear (cache, e);
     flux_future_destroy (f);
+    cache_evict (cache);
     cache_resume_flush (cache);
     return;
 error:
@@ -576,22 +1151,16 @@ static void flush_list_append (struct content_cache *cache,
     list_add_tail (&cache->flush, &e->list);
 }
 
-static int cache_store (struct content_cache *cache, struct cache_entry *e)
+/* Send a store request for one dirty entry.
+ */
+static int cache_store_send (struct content_cache *cache,
+                             struct cache_entry *e)
 {
     flux_future_t *f;
     int flags = CONTENT_FLAG_UPSTREAM;
 
-    assert (e->valid);
-
-    if (e->store_pending)
-        return 0;
-    if (cache->rank == 0) {
-        if (cache->flush_batch_count >= cache->flush_batch_limit) {
-            flush_list_append (cache, e);
-            return 0;
-        }
+    if (cache->rank == 0)
         flags = CONTENT_FLAG_CACHE_BYPASS;
-    }
     if (!(f = content_store (cache->h, e->data, e->len, flags))
         || flux_future_aux_set (f, "entry", e, NULL) < 0
         || flux_future_then (f, -1., cache_store_continuation, cache) < 0) {
@@ -604,40 +1173,222 @@ static int cache_store (struct content_cache *cache, struct cache_entry *e)
     return 0;
 }
 
-static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
-                                   const flux_msg_t *msg, void *arg)
+/* On rank 0, dirty entries are queued on the flush list, and the flush
+ * list is drained in batches from the check watcher, once all the requests
+ * that arrived in a reactor loop iteration have been handled.
+ */
+static int cache_store (struct content_cache *cache, struct cache_entry *e)
+{
+    assert (e->valid);
+
+    if (e->store_pending)
+        return 0;
+    if (cache->rank == 0) {
+        flush_list_append (cache, e);
+        return 0;
+    }
+    return cache_store_send (cache, e);
+}
+
+/* The entries in a store batch are saved in the future.  Dirty entries
+ * are never removed from the cache, so these pointers remain valid.
+ */
+struct store_batch {
+    int count;
+    struct cache_entry *entries[];
+};
+
+/* Put the entries of a store batch back at the front of the flush list,
+ * in order, so they are retried.
+ */
+static void store_batch_requeue (struct content_cache *cache,
+                                 struct store_batch *sb)
+{
+    int i;
+
+    for (i = sb->count - 1; i >= 0; i--)
+        list_add (&cache->flush, &sb->entries[i]->list);
+}
+
+/* A batch could not be stored, and its entries were requeued.  Fail any
+ * flush requests, and hold off retrying until the next flush request or
+ * heartbeat so that a persistent error does not spin the reactor.
+ */
+static void store_batch_failed (struct content_cache *cache, int errnum)
+{
+    cache->flush_errnum = errnum;
+    request_list_respond_error (&cache->flush_requests,
+                                cache->h,
+                                errnum,
+                                NULL,
+                                "flush");
+}
+
+static void cache_store_batch_continuation (flux_future_t *f, void *arg)
 {
     struct content_cache *cache = arg;
-    const void *data;
-    int len;
-    struct cache_entry *e = NULL;
-    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
-    int hash_size;
+    struct store_batch *sb = flux_future_aux_get (f, "batch");
+    int count;
+    int i;
+
+    assert (cache->flush_batch_count >= sb->count);
+    cache->flush_batch_count -= sb->count;
+    for (i = 0; i < sb->count; i++)
+        sb->entries[i]->store_pending = 0;
+    if (flux_future_get (f, NULL) < 0) {
+        /* If the backing store does not support batches, or went away,
+         * requeue the entries at the front of the flush list in order.
+         */
+        if (errno == ENOSYS) {
+            if (cache->backing) {
+                flux_log (cache->h,
+                          LOG_DEBUG,
+                          "content store: backing store does not support"
+                          " batches");
+                cache->backing_nobatch = 1;
+            }
+            else
+                flux_log (cache->h, LOG_DEBUG, "content store: %s",
+                          "backing store service unavailable");
+            store_batch_requeue (cache, sb);
+        }
+        else {
+            int errnum = errno;
+
+            flux_log (cache->h, LOG_CRIT, "content store-batch: %s",
+                      strerror (errnum));
+            for (i = 0; i < sb->count; i++) {
+                request_list_respond_error (&sb->entries[i]->store_requests,
+                                            cache->h,
+                                            errnum,
+                                            NULL,
+                                            "store");
+            }
+            store_batch_requeue (cache, sb);
+            store_batch_failed (cache, errnum);
+        }
+        goto done;
+    }
+    /* Entries whose hash does not match stay dirty and are moved to the
+     * front of the batch, to be requeued.
+     */
+    count = 0;
+    for (i = 0; i < sb->count; i++) {
+        struct cache_entry *e = sb->entries[i];
+        const void *hash;
+        int hash_size;
 
-    if (flux_request_decode_raw (msg, NULL, &data, &len) < 0)
+        if (content_store_batch_get_hash (f, i, &hash, &hash_size) < 0
+            || hash_size != content_hash_size
+            || memcmp (hash, e->hash, content_hash_size) != 0) {
+            flux_log (cache->h, LOG_CRIT, "content store-batch: %s",
+                      "hash mismatch");
+            request_list_respond_error (&e->store_requests,
+                                        cache->h,
+                                        EIO,
+                                        NULL,
+                                        "store");
+            sb->entries[count++] = e;
+            continue;
+        }
+        cache_entry_dirty_clear (cache, e);
+    }
+    if (count > 0) {
+        sb->count = count;
+        store_batch_requeue (cache, sb);
+        store_batch_failed (cache, EIO);
+    }
+done:
+    flux_future_destroy (f);
+    cache_evict (cache);
+    cache_resume_flush (cache);
+}
+
+/* Remove up to 'limit' entries from the front of the flush list
+ * (bounded by store_batch_max_bytes) and store them to the backing
+ * store in one request.  On failure, the entries are put back.
+ */
+static int cache_store_batch (struct content_cache *cache, int limit)
+{
+    struct store_batch *sb;
+    const void **bufs = NULL;
+    int *lens = NULL;
+    flux_future_t *f = NULL;
+    struct cache_entry *e;
+    int bytes = 0;
+    int i;
+
+    if (!(sb = malloc (sizeof (*sb) + limit * sizeof (sb->entries[0]))))
         goto error;
-    if (len > cache->blob_size_limit) {
-        errno = EFBIG;
+    sb->count = 0;
+    if (!(bufs = malloc (limit * sizeof (bufs[0])))
+        || !(lens = malloc (limit * sizeof (lens[0]))))
         goto error;
+    while (sb->count < limit
+           && (e = list_top (&cache->flush, struct cache_entry, list))) {
+        if (sb->count > 0 && bytes + e->len > store_batch_max_bytes)
+            break;
+        list_del_init (&e->list);
+        bufs[sb->count] = e->data;
+        lens[sb->count] = e->len;
+        sb->entries[sb->count++] = e;
+        bytes += e->len;
     }
-    if ((hash_size = blobref_hash_raw (cache->hash_name,
-                                       data,
-                                       len,
-                                       hash,
-                                       sizeof (hash))) < 0)
+    if (!(f = content_store_batch (cache->h,
+                                   bufs,
+                                   lens,
+                                   sb->count,
+                                   CONTENT_FLAG_CACHE_BYPASS))
+        || flux_future_then (f, -1., cache_store_batch_continuation, cache) < 0
+        || flux_future_aux_set (f, "batch", sb, free) < 0)
         goto error;
+    for (i = 0; i < sb->count; i++)
+        sb->entries[i]->store_pending = 1;
+    cache->flush_batch_count += sb->count;
+    free (bufs);
+    free (lens);
+    return 0;
+error:
+    flux_log_error (cache->h, "content store-batch");
+    if (sb) {
+        store_batch_requeue (cache, sb);
+        ERRNO_SAFE_WRAP (store_batch_failed, cache, errno);
+    }
+    ERRNO_SAFE_WRAP (flux_future_destroy, f);
+    ERRNO_SAFE_WRAP (free, sb);
+    ERRNO_SAFE_WRAP (free, bufs);
+    ERRNO_SAFE_WRAP (free, lens);
+    return -1;
+}
+
+/* Fill the entry for a blob and initiate a store if it is dirty.
+ * If 'msg' is non-NULL, the entry references its payload, otherwise the
+ * blob is copied.  When the response must await an upstream store (rank > 0),
+ * the requester ('msg', or slot 'index' of 'batch') is queued on the entry.
+ * Returns 1 if queued, 0 if the store is complete, -1 on error.
+ */
+static int cache_store_blob (struct content_cache *cache,
+                             const flux_msg_t *msg,
+                             struct content_batch *batch,
+                             int index,
+                             const void *data,
+                             int len,
+                             const void *hash)
+{
+    struct cache_entry *e;
+
     /* If existing entry has the ephemeral bit set, remove it and let it be
      * replaced with a new entry.  N.B. it can be assumed that an entry with
      * the ephemeral bit set is valid and not dirty.
      */
-    if ((e = cache_entry_lookup (cache, hash, hash_size))
+    if ((e = cache_entry_lookup (cache, hash, content_hash_size))
         && e->ephemeral) {
         cache_entry_remove (cache, e);
         e = NULL;
     }
     if (!e) {
-        if (!(e = cache_entry_insert (cache, hash, hash_size)))
-            goto error;
+        if (!(e = cache_entry_insert (cache, hash, content_hash_size)))
+            return -1;
     }
     /* Fill invalid cache entry, which may have been just created above,
      * or could be there because a load was requested and it still awaits
@@ -645,30 +1396,41 @@ static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
      * requests after we fill the entry.
      */
     if (!e->valid) {
-        assert (!e->data_container);
-        e->data = data;
-        e->len = len;
-        e->data_container = (void *)flux_msg_incref (msg);
-        e->valid = 1;
+        if (msg) {
+            assert (!e->data_container);
+            e->data = data;
+            e->len = len;
+            e->data_container = (void *)flux_msg_incref (msg);
+            e->valid = 1;
+            cache->acct_valid++;
+            cache->acct_size += e->len;
+        }
+        else if (cache_entry_fill_copy (cache, e, data, len) < 0)
+            return -1;
         e->dirty = 1;
-        cache->acct_valid++;
-        cache->acct_size += e->len;
         cache->acct_dirty++;
         request_list_respond_raw (&e->load_requests,
                                   cache->h,
                                   false,
                                   e->data,
                                   e->len,
+                                  e,
                                   "load");
     }
     if (e->dirty) {
         if (cache->rank > 0 || cache->backing) {
             if (cache_store (cache, e) < 0)
-                goto error;
+                return -1;
             if (cache->rank > 0) {  /* write-through */
-                if (msgstack_push (&e->store_requests, msg) < 0)
-                    goto error;
-                return;
+                if (batch) {
+                    if (msgstack_push_batch (&e->store_requests,
+                                             batch,
+                                             index) < 0)
+                        return -1;
+                }
+                else if (msgstack_push (&e->store_requests, msg) < 0)
+                    return -1;
+                return 1;
             }
         }
         /* On rank 0, save to flush list in event backing module
@@ -678,14 +1440,179 @@ static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
         if (cache->rank == 0 && !cache->backing)
             flush_list_append (cache, e);
     }
-    if (flux_respond_raw (h, msg, hash, hash_size) < 0)
-        flux_log_error (h, "content store: flux_respond_raw");
+    return 0;
+}
+
+static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
+                                   const flux_msg_t *msg, void *arg)
+{
+    struct content_cache *cache = arg;
+    const void *data;
+    int len;
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_size;
+    int rc;
+
+    if (flux_request_decode_raw (msg, NULL, &data, &len) < 0)
+        goto error;
+    if (len > cache->blob_size_limit) {
+        errno = EFBIG;
+        goto error;
+    }
+    if ((hash_size = blobref_hash_raw (cache->hash_name,
+                                       data,
+                                       len,
+                                       hash,
+                                       sizeof (hash))) < 0)
+        goto error;
+    if ((rc = cache_store_blob (cache, msg, NULL, 0, data, len, hash)) < 0)
+        goto error;
+    if (rc == 0) {
+        if (flux_respond_raw (h, msg, hash, hash_size) < 0)
+            flux_log_error (h, "content store: flux_respond_raw");
+    }
+    cache_evict (cache);
     return;
 error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         flux_log_error (h, "content store: flux_respond_error");
 }
 
+/* Batched load and store operations
+ *
+ * Each slot of a content.load-batch or content.store-batch request is
+ * handled like an individual load or store, except that requests waiting
+ * on cache entries are batch slots, and the response is sent when all
+ * slots are fulfilled.  Cache misses are loaded with one batched request
+ * to the next level of the TBON, or on rank 0, to the backing store.
+ */
+
+static void content_load_batch_request (flux_t *h, flux_msg_handler_t *mh,
+                                        const flux_msg_t *msg, void *arg)
+{
+    struct content_cache *cache = arg;
+    const uint8_t *hashes;
+    int size;
+    int count;
+    struct content_batch *b = NULL;
+    struct cache_entry **fetch = NULL;
+    int nfetch = 0;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, (const void **)&hashes, &size) < 0)
+        goto error;
+    if (size == 0 || size % content_hash_size != 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    count = size / content_hash_size;
+    if (!(b = batch_create (cache, msg, count, false))
+        || !(fetch = calloc (count, sizeof (fetch[0]))))
+        goto error;
+    for (i = 0; i < count; i++) {
+        const void *hash = hashes + i * content_hash_size;
+        struct cache_entry *e;
+
+        if (!(e = cache_entry_lookup (cache, hash, content_hash_size))
+            || !e->valid)
+            cache->acct_misses++;
+        if (!e && !(e = cache_entry_insert_load (cache,
+                                                 hash,
+                                                 content_hash_size))) {
+            batch_fulfill (b, i, errno, NULL);
+            continue;
+        }
+        if (!e->valid) {
+            if (msgstack_push_batch (&e->load_requests, b, i) < 0) {
+                batch_fulfill (b, i, errno, NULL);
+                continue;
+            }
+            if (!e->load_pending) {
+                e->load_pending = 1;
+                fetch[nfetch++] = e;
+            }
+            continue;
+        }
+        if (e->mmapped && !content_mmap_validate (e->data_container,
+                                                  e->hash,
+                                                  content_hash_size,
+                                                  e->data,
+                                                  e->len)) {
+            batch_fulfill (b, i, EINVAL, NULL);
+            continue;
+        }
+        batch_fulfill (b, i, 0, e);
+    }
+    if (nfetch > 0)
+        cache_load_batch (cache, fetch, nfetch);
+    free (fetch);
+    batch_decref (b);
+    cache_evict (cache);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "content load-batch: flux_respond_error");
+    batch_destroy (b);
+}
+
+static void content_store_batch_request (flux_t *h, flux_msg_handler_t *mh,
+                                         const flux_msg_t *msg, void *arg)
+{
+    struct content_cache *cache = arg;
+    const void *payload;
+    int payload_size;
+    const void *cursor;
+    int remaining;
+    const void *data;
+    int len;
+    int count = 0;
+    struct content_batch *b;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &payload, &payload_size) < 0)
+        goto error;
+    cursor = payload;
+    remaining = payload_size;
+    while (remaining > 0) {
+        if (content_batch_decode_blob (&cursor, &remaining, &data, &len) < 0)
+            goto error;
+        if (len > cache->blob_size_limit) {
+            errno = EFBIG;
+            goto error;
+        }
+        count++;
+    }
+    if (count == 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(b = batch_create (cache, msg, count, true)))
+        goto error;
+    cursor = payload;
+    remaining = payload_size;
+    for (i = 0; i < count; i++) {
+        uint8_t *hash = b->hashes + i * content_hash_size;
+        int rc;
+
+        (void)content_batch_decode_blob (&cursor, &remaining, &data, &len);
+        if (blobref_hash_raw (cache->hash_name,
+                              data,
+                              len,
+                              hash,
+                              content_hash_size) < 0
+            || (rc = cache_store_blob (cache, NULL, b, i, data, len, hash)) < 0)
+            batch_fulfill (b, i, errno, NULL);
+        else if (rc == 0)
+            batch_fulfill (b, i, 0, NULL);
+    }
+    batch_decref (b);
+    cache_evict (cache);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "content store-batch: flux_respond_error");
+}
+
 /* Backing store is enabled/disabled by modules that provide the
  * 'content.backing' service.  At module load time, the backing module
  * informs the content service of its availability, and entries are
@@ -700,10 +1627,22 @@ static int cache_flush (struct content_cache *cache)
     int rc = 0;
 
     while (cache->flush_batch_count < cache->flush_batch_limit) {
+        int limit = cache->flush_batch_limit - cache->flush_batch_count;
+
+        if (limit > store_batch_max)
+            limit = store_batch_max;
         if (!(e = list_top (&cache->flush, struct cache_entry, list)))
             break;
-        if (cache_store (cache, e) < 0) { // incr flush_batch_count
-            last_errno = errno;           //   and continuation will decr
+        if (cache->rank == 0 && !cache->backing_nobatch && limit > 1) {
+            if (cache_store_batch (cache, limit) < 0) { // pops entries
+                last_errno = errno;         //   or puts them back on error
+                rc = -1;
+                break;
+            }
+            continue;
+        }
+        if (cache_store_send (cache, e) < 0) { // incr flush_batch_count
+            last_errno = errno;                //   and continuation will decr
             rc = -1;
             /* A few errors we will consider "unrecoverable", so break
              * out */
@@ -711,13 +1650,46 @@ static int cache_flush (struct content_cache *cache)
                 || errno == ENOMEM)
                 break;
         }
-        (void)list_pop (&cache->flush, struct cache_entry, list);
+        list_del_init (&e->list);
     }
     if (rc < 0)
         errno = last_errno;
     return rc;
 }
 
+/* Rank 0 drains the flush list when new entries have been queued on it.
+ * The prepare watcher keeps the reactor from blocking via the idle watcher
+ * so the check watcher runs immediately.
+ */
+static void flush_prep_cb (flux_reactor_t *r,
+                           flux_watcher_t *w,
+                           int revents,
+                           void *arg)
+{
+    struct content_cache *cache = arg;
+
+    if (cache->backing
+        && !cache->flush_errnum
+        && cache->flush_batch_count < cache->flush_batch_limit
+        && !list_empty (&cache->flush))
+        flux_watcher_start (cache->idle_w);
+}
+
+static void flush_check_cb (flux_reactor_t *r,
+                            flux_watcher_t *w,
+                            int revents,
+                            void *arg)
+{
+    struct content_cache *cache = arg;
+
+    flux_watcher_stop (cache->idle_w);
+    if (cache->backing
+        && !cache->flush_errnum
+        && cache->flush_batch_count < cache->flush_batch_limit
+        && !list_empty (&cache->flush))
+        (void)cache_flush (cache);
+}
+
 static void content_register_backing_request (flux_t *h,
                                               flux_msg_handler_t *mh,
                                               const flux_msg_t *msg,
@@ -754,6 +1726,7 @@ static void content_register_backing_request (flux_t *h,
         goto error;
     }
     cache->backing = 1;
+    cache->backing_nobatch = 0;
     flux_log (h, LOG_DEBUG, "content backing store: enabled %s", name);
     if (flux_respond (h, msg, NULL) < 0)
         flux_log_error (h, "error responding to register-backing request");
@@ -801,7 +1774,7 @@ error:
 }
 
 /* Forcibly drop all entries from the cache that can be dropped
- * without data loss.  Use the LRU for this since all entires are
+ * without data loss.  Use the LRU segments for this since all entires are
  * valid and clean.
  */
 
@@ -815,7 +1788,10 @@ static void content_dropcache_request (flux_t *h, flux_msg_handler_t *mh,
 
     orig_size = zhashx_size (cache->entries);
 
-    list_for_each_safe (&cache->lru, e, next, list) {
+    list_for_each_safe (&cache->probation.list, e, next, list) {
+        cache_entry_remove (cache, e);
+    }
+    list_for_each_safe (&cache->protected.list, e, next, list) {
         cache_entry_remove (cache, e);
     }
 
@@ -833,12 +1809,26 @@ static void content_stats_request (flux_t *h, flux_msg_handler_t *mh,
 {
     struct content_cache *cache = arg;
 
-    if (flux_respond_pack (h, msg, "{s:i s:i s:i s:I s:i}",
+    if (flux_respond_pack (h, msg,
+                           "{s:i s:i s:i s:I s:i s:I"
+                           " s:{s:i s:I s:I s:I}"
+                           " s:{s:i s:I s:I s:I}}",
                            "count", zhashx_size (cache->entries),
                            "valid", cache->acct_valid,
                            "dirty", cache->acct_dirty,
                            "size", cache->acct_size,
-                           "flush-batch-count", cache->flush_batch_count) < 0)
+                           "flush-batch-count", cache->flush_batch_count,
+                           "misses", cache->acct_misses,
+                           "probation",
+                             "count", cache->probation.count,
+                             "size", cache->probation.size,
+                             "hits", cache->probation.hits,
+                             "evictions", cache->probation.evictions,
+                           "protected",
+                             "count", cache->protected.count,
+                             "size", cache->protected.size,
+                             "hits", cache->protected.hits,
+                             "evictions", cache->protected.evictions) < 0)
         flux_log_error (h, "content stats");
 }
 
@@ -858,6 +1848,7 @@ static void flush_respond (struct content_cache *cache)
                                   false,
                                   NULL,
                                   0,
+                                  NULL,
                                   "flush");
     }
     else {
@@ -882,6 +1873,7 @@ static void content_flush_request (flux_t *h, flux_msg_handler_t *mh,
         goto error;
     }
     if (cache->acct_dirty > 0) {
+        cache->flush_errnum = 0; // retry stores that failed
         if (cache_flush (cache) < 0)
             goto error;
         if (msgstack_push (&cache->flush_requests, msg) < 0)
@@ -896,16 +1888,19 @@ error:
         flux_log_error (h, "error responding to content flush");
 }
 
-/* Heartbeat drives periodic cache purge
+/* Heartbeat drives periodic cache purge.
+ * Enforce content.purge-max-size in case it was lowered, then purge old
+ * entries down to content.purge-target-size, probationary segment first.
  */
 
-static void cache_purge (struct content_cache *cache)
+static void cache_purge_segment (struct content_cache *cache,
+                                 struct lru_segment *seg,
+                                 double now)
 {
-    double now = flux_reactor_now (cache->reactor);
     struct cache_entry *e = NULL;
     struct cache_entry *next;
 
-    list_for_each_rev_safe (&cache->lru, e, next, list) {
+    list_for_each_rev_safe (&seg->list, e, next, list) {
         if (cache->acct_size <= cache->purge_target_size
             || now - e->lastused < cache->purge_old_entry)
             break;
@@ -915,6 +1910,16 @@ static void cache_purge (struct content_cache *cache)
     }
 }
 
+static void cache_purge (struct content_cache *cache)
+{
+    double now = flux_reactor_now (cache->reactor);
+
+    lru_rebalance (cache);
+    cache_evict (cache);
+    cache_purge_segment (cache, &cache->probation, now);
+    cache_purge_segment (cache, &cache->protected, now);
+}
+
 static void update_stats (struct content_cache *cache)
 {
     flux_stats_gauge_set (cache->h, "content-cache.count",
@@ -927,6 +1932,10 @@ static void update_stats (struct content_cache *cache)
         cache->acct_size);
     flux_stats_gauge_set (cache->h, "content-cache.flush-batch-count",
         cache->flush_batch_count);
+    flux_stats_gauge_set (cache->h, "content-cache.probation-size",
+        cache->probation.size);
+    flux_stats_gauge_set (cache->h, "content-cache.protected-size",
+        cache->protected.size);
 }
 
 static void sync_cb (flux_future_t *f, void *arg)
@@ -937,6 +1946,7 @@ static void sync_cb (flux_future_t *f, void *arg)
         update_stats (cache);
 
     cache_purge (cache);
+    cache->flush_errnum = 0; // retry stores that failed
 
     flux_future_reset (f);
 }
@@ -962,6 +1972,18 @@ static const struct flux_msg_handler_spec htab[] = {
         content_store_request,
         0
     },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "content.load-batch",
+        content_load_batch_request,
+        0
+    },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "content.store-batch",
+        content_store_batch_request,
+        0
+    },
     {
         FLUX_MSGTYPE_REQUEST,
         "content.unregister-backing",
@@ -1049,6 +2071,9 @@ static int register_attrs (struct content_cache *cache, attr_t *attr)
     if (attr_add_active_uint32 (attr, "content.purge-old-entry",
                 &cache->purge_old_entry, 0) < 0)
         return -1;
+    if (attr_add_active_uint64 (attr, "content.purge-max-size",
+                &cache->purge_max_size, 0) < 0)
+        return -1;
     /* Misc
      */
     if (attr_add_active_uint32 (attr, "content.flush-batch-limit",
@@ -1069,6 +2094,9 @@ void content_cache_destroy (struct content_cache *cache)
     if (cache) {
         int saved_errno = errno;
         flux_future_destroy (cache->f_sync);
+        flux_watcher_destroy (cache->prep_w);
+        flux_watcher_destroy (cache->check_w);
+        flux_watcher_destroy (cache->idle_w);
         flux_msg_handler_delvec (cache->handlers);
         free (cache->backing_name);
         zhashx_destroy (&cache->entries);
@@ -1105,7 +2133,8 @@ struct content_cache *content_cache_create (flux_t *h, attr_t *attrs)
         goto error;
     cache->h = h;
     cache->reactor = flux_get_reactor (h);
-    list_head_init (&cache->lru);
+    lru_segment_init (&cache->probation);
+    lru_segment_init (&cache->protected);
     list_head_init (&cache->flush);
 
     if (register_attrs (cache, attrs) < 0)
@@ -1122,6 +2151,18 @@ struct content_cache *content_cache_create (flux_t *h, attr_t *attrs)
                                                  cache->hash_name,
                                                  content_hash_size)))
             goto error;
+        if (!(cache->prep_w = flux_prepare_watcher_create (cache->reactor,
+                                                           flush_prep_cb,
+                                                           cache))
+            || !(cache->check_w = flux_check_watcher_create (cache->reactor,
+                                                             flush_check_cb,
+                                                             cache))
+            || !(cache->idle_w = flux_idle_watcher_create (cache->reactor,
+                                                           NULL,
+                                                           NULL)))
+            goto error;
+        flux_watcher_start (cache->prep_w);
+        flux_watcher_start (cache->check_w);
     }
     if (flux_msg_handler_addvec (h, htab, cache, &cache->handlers) < 0)
         goto error;
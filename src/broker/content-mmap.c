@@ -62,7 +62,9 @@
  * it is inherently a time-of-check-time-of-use problem.  In fact we rate
  * limit the calls to stat(2) to avoid a "stat storm" when a file with many
  * blobrefs is accessed, which increases the window where it could have
- * changed.  But it's likely better than not checking at all.
+ * changed.  But it's likely better than not checking at all.  Rehashing
+ * is skipped while that stat(2) shows the file unmodified since it was
+ * mapped, so the same window applies to in-place content changes.
  */
 
 #if HAVE_CONFIG_H
@@ -99,8 +101,19 @@ struct cache_entry {
     void *hash;                             // contiguous with struct
 };
 
+/* Reference on a mapping held by messages whose payload points into it.
+ * Messages may be released by a zmq I/O thread, so unlike the region,
+ * the reference count is atomic and the struct is self-contained.
+ */
+struct content_pin {
+    int refcount;
+    void *base;
+    size_t size;
+};
+
 struct content_region {
     struct blobvec_mapinfo mapinfo;
+    struct content_pin *pin;                // created on first pin
     int refcount;
     json_t *fileref;
     void *fileref_data;                     // encoded fileref data
@@ -111,6 +124,9 @@ struct content_region {
 
     char *fullpath;                         // full path for stat(2) checking
     struct timespec last_check;             // rate limit stat(2) checking
+    struct stat sb;                         // stat(2) taken before mapping
+    bool have_sb;
+    bool unchanged;                         // last stat(2) matched 'sb'
 };
 
 struct content_mmap {
@@ -322,7 +338,9 @@ void content_mmap_region_decref (struct content_region *reg)
     if (reg && --reg->refcount == 0) {
         int saved_errno = errno;
         region_cache_remove (reg);
-        if (reg->mapinfo.base != MAP_FAILED)
+        if (reg->pin)
+            content_mmap_unpin (reg->pin);
+        else if (reg->mapinfo.base != MAP_FAILED)
             (void)munmap (reg->mapinfo.base, reg->mapinfo.size);
         json_decref (reg->fileref);
         free (reg->fullpath);
@@ -333,6 +351,40 @@ void content_mmap_region_decref (struct content_region *reg)
     }
 }
 
+void content_mmap_unpin (void *arg)
+{
+    struct content_pin *pin = arg;
+
+    if (pin && __atomic_sub_fetch (&pin->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        int saved_errno = errno;
+        (void)munmap (pin->base, pin->size);
+        free (pin);
+        errno = saved_errno;
+    }
+}
+
+void *content_mmap_region_pin (struct content_region *reg,
+                               const void *data,
+                               int data_size)
+{
+    if (!reg
+        || reg->mapinfo.base == MAP_FAILED
+        || data < reg->mapinfo.base
+        || data + data_size > reg->mapinfo.base + reg->mapinfo.size) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!reg->pin) {
+        if (!(reg->pin = calloc (1, sizeof (*reg->pin))))
+            return NULL;
+        reg->pin->refcount = 1; // held by region
+        reg->pin->base = reg->mapinfo.base;
+        reg->pin->size = reg->mapinfo.size;
+    }
+    __atomic_add_fetch (&reg->pin->refcount, 1, __ATOMIC_RELAXED);
+    return reg->pin;
+}
+
 // zhashx_destructor_fn footprint
 static void content_mmap_region_destructor (void **item)
 {
@@ -349,11 +401,25 @@ struct content_region *content_mmap_region_incref (struct content_region *reg)
     return reg;
 }
 
+static bool region_unchanged (struct content_region *reg, struct stat *sb)
+{
+    return reg->have_sb
+        && sb->st_dev == reg->sb.st_dev
+        && sb->st_ino == reg->sb.st_ino
+        && sb->st_size == reg->sb.st_size
+        && sb->st_mtim.tv_sec == reg->sb.st_mtim.tv_sec
+        && sb->st_mtim.tv_nsec == reg->sb.st_mtim.tv_nsec
+        && sb->st_ctim.tv_sec == reg->sb.st_ctim.tv_sec
+        && sb->st_ctim.tv_nsec == reg->sb.st_ctim.tv_nsec;
+}
+
 /* Validate mmapped blob before use, checking for:
  * - size has changed so mmmapped pages are no longer valid (SIGBUS if used!)
  * - content no longer matches hash
  * To avoid repeatedly calling stat(2) on a file, skip it if last check was
- * within max_check_age seconds.
+ * within max_check_age seconds.  The blobvec hashes were computed from the
+ * mapped pages when the region was created, so if the file has not been
+ * modified since then (as of the last stat), skip rehashing the blob.
  */
 bool content_mmap_validate (struct content_region *reg,
                             const void *hash,
@@ -378,8 +444,11 @@ bool content_mmap_validate (struct content_region *reg,
             || sb.st_size < reg->mapinfo.size)
             return false;
 
+        reg->unchanged = region_unchanged (reg, &sb);
         monotime (&reg->last_check);
     }
+    if (reg->unchanged)
+        return true;
 
     if (blobref_hash_raw (reg->mm->hash_name,
                           data,
@@ -453,6 +522,11 @@ static struct content_region *content_mmap_region_create (
     if (!(reg->fullpath = strdup (fpath)))
         goto error;
 
+    /* Take stat(2) before the file is mapped and hashed so that any later
+     * modification shows up as a change in content_mmap_validate().
+     */
+    if (stat (reg->fullpath, &reg->sb) == 0)
+        reg->have_sb = true;
     if (!(reg->fileref = fileref_create_ex (path,
                                             fpath,
                                             param,
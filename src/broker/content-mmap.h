@@ -35,6 +35,17 @@ bool content_mmap_validate (struct content_region *reg,
 void content_mmap_region_decref (struct content_region *reg);
 struct content_region *content_mmap_region_incref (struct content_region *reg);
 
+/* Keep the mapping containing 'data' of 'reg' valid, even after the region
+ * is destroyed, until content_mmap_unpin() is called on the returned pin.
+ * content_mmap_unpin() has the flux_free_f footprint and may be called from
+ * any thread, so the pin may be handed to flux_msg_set_payload_ref().
+ * Returns NULL with errno = EINVAL if 'data' is not mmapped by 'reg'.
+ */
+void *content_mmap_region_pin (struct content_region *reg,
+                               const void *data,
+                               int data_size);
+void content_mmap_unpin (void *pin);
+
 #endif /* !BROKER_CONTENT_MMAP_H */
 
 // vi:ts=4 sw=4 expandtab
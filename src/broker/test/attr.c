@@ -122,6 +122,7 @@ void active (void)
     const char *val;
     int a, c;
     uint32_t b;
+    uint64_t d;
 
     if (!(attrs = attr_create ()))
         BAIL_OUT ("attr_create failed");
@@ -179,6 +180,25 @@ void active (void)
     ok (attr_delete (attrs, "b", true) == 0,
         "attr_delete (force) works on active attr");
 
+    /* attr_add_active (uint64_t helper)
+     */
+    ok (attr_add_active_uint64 (attrs, "d", &d, 0) == 0,
+        "attr_add_active_uint64 works");
+    d = 0;
+    ok (attr_get (attrs, "d", &val, NULL) == 0 && val && !strcmp (val, "0"),
+        "attr_get on active uint64_t tracks val=0");
+    d = ULLONG_MAX - 1;
+    ok (attr_get (attrs, "d", &val, NULL) == 0
+        && strtoull (val, NULL, 10) == ULLONG_MAX - 1,
+        "attr_get on active uint64_t tracks val=ULLONG_MAX-1");
+    ok (attr_set (attrs, "d", "17179869184") == 0 && d == 17179869184ULL,
+        "attr_set on active uint64_t sets val=16G");
+    errno = 0;
+    ok (attr_set (attrs, "d", "16G") < 0 && errno == EINVAL,
+        "attr_set on active uint64_t fails on non-numeric value");
+    ok (attr_delete (attrs, "d", true) == 0,
+        "attr_delete (force) works on active attr");
+
     /* immutable active int works as expected
      */
     ok (attr_add_active_int (attrs, "c", &c, ATTR_IMMUTABLE) == 0,
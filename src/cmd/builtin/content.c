@@ -157,6 +157,27 @@ static int internal_content_dropcache (optparse_t *p, int ac, char *av[])
     return (0);
 }
 
+static int internal_content_gc (optparse_t *p, int ac, char *av[])
+{
+    flux_t *h;
+    flux_future_t *f = NULL;
+    const char *s;
+
+    if (optparse_option_index (p) != ac) {
+        optparse_print_usage (p);
+        exit (1);
+    }
+    if (!(h = builtin_get_flux_handle (p)))
+        log_err_exit ("flux_open");
+    if (!(f = flux_rpc (h, "content-backing.gc", NULL, 0, 0))
+        || flux_rpc_get (f, &s) < 0)
+        log_msg_exit ("content-backing.gc: %s", future_strerror (f, errno));
+    printf ("%s\n", s);
+    flux_future_destroy (f);
+    flux_close (h);
+    return (0);
+}
+
 int cmd_content (optparse_t *p, int ac, char *av[])
 {
     log_init ("flux-content");
@@ -209,6 +230,13 @@ static struct optparse_subcommand content_subcmds[] = {
       0,
       NULL,
     },
+    { "gc",
+      NULL,
+      "Remove unreachable blobs from the backing store",
+      internal_content_gc,
+      0,
+      NULL,
+    },
     OPTPARSE_SUBCMD_END
 };
 
@@ -249,6 +249,35 @@ static void dump_dir (struct archive *ar,
     }
 }
 
+static void dump_dirref (struct archive *ar,
+                         flux_t *h,
+                         const char *path,
+                         json_t *treeobj);
+
+/* Each shard of a sharded directory holds a subset of its entries,
+ * so dump them all under the directory's path.
+ */
+static void dump_hamt (struct archive *ar,
+                       flux_t *h,
+                       const char *path,
+                       json_t *treeobj)
+{
+    int index;
+
+    for (index = 0; index < TREEOBJ_HAMT_WIDTH; index++) {
+        json_t *shard;
+
+        if (!(shard = treeobj_get_shard (treeobj, index)))
+            continue;
+        if (treeobj_is_dirref (shard))
+            dump_dirref (ar, h, path, shard); // recurse
+        else if (treeobj_is_hamt (shard))
+            dump_hamt (ar, h, path, shard); // recurse
+        else
+            dump_dir (ar, h, path, shard); // recurse
+    }
+}
+
 static void dump_dirref (struct archive *ar,
                          flux_t *h,
                          const char *path,
@@ -271,9 +300,12 @@ static void dump_dirref (struct archive *ar,
     }
     if (!(treeobj_deref = treeobj_decodeb (buf, buflen)))
         log_err_exit ("%s: could not decode directory", path);
-    if (!treeobj_is_dir (treeobj_deref))
+    if (treeobj_is_hamt (treeobj_deref))
+        dump_hamt (ar, h, path, treeobj_deref); // recurse
+    else if (treeobj_is_dir (treeobj_deref))
+        dump_dir (ar, h, path, treeobj_deref); // recurse
+    else
         log_msg_exit ("%s: dirref references non-directory", path);
-    dump_dir (ar, h, path, treeobj_deref); // recurse
     json_decref (treeobj_deref);
     flux_future_destroy (f);
 }
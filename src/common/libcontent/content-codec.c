@@ -0,0 +1,249 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <lz4.h>
+#if HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "content-codec.h"
+
+/* Compression level passed to ZSTD_compress().  Level 1 is much faster
+ * than the default (3) and the ratio is still better than lz4.
+ */
+static const int zstd_level = 1;
+
+static const uint8_t header_magic[] = { 0x89, 'F', 'L', 'X', 'Z' };
+static const uint8_t header_version = 1;
+
+struct codec_name {
+    int codec;
+    const char *name;
+};
+
+static const struct codec_name codec_names[] = {
+    { CONTENT_CODEC_NONE, "none" },
+    { CONTENT_CODEC_LZ4, "lz4" },
+    { CONTENT_CODEC_ZSTD, "zstd" },
+};
+
+static bool codec_supported (int codec)
+{
+    switch (codec) {
+        case CONTENT_CODEC_NONE:
+        case CONTENT_CODEC_LZ4:
+            return true;
+#if HAVE_ZSTD
+        case CONTENT_CODEC_ZSTD:
+            return true;
+#endif
+    }
+    return false;
+}
+
+int content_codec_lookup (const char *name)
+{
+    int i;
+
+    if (!name) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (i = 0; i < sizeof (codec_names) / sizeof (codec_names[0]); i++) {
+        if (!strcmp (codec_names[i].name, name)) {
+            if (!codec_supported (codec_names[i].codec)) {
+                errno = ENOTSUP;
+                return -1;
+            }
+            return codec_names[i].codec;
+        }
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+const char *content_codec_name (int codec)
+{
+    int i;
+
+    for (i = 0; i < sizeof (codec_names) / sizeof (codec_names[0]); i++) {
+        if (codec_names[i].codec == codec)
+            return codec_names[i].name;
+    }
+    return NULL;
+}
+
+int content_codec_bound (int codec, int size)
+{
+    if (size < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    switch (codec) {
+        case CONTENT_CODEC_NONE:
+            return size;
+        case CONTENT_CODEC_LZ4:
+            return LZ4_compressBound (size);
+#if HAVE_ZSTD
+        case CONTENT_CODEC_ZSTD: {
+            size_t bound = ZSTD_compressBound (size);
+            if (bound > INT32_MAX) {
+                errno = EOVERFLOW;
+                return -1;
+            }
+            return bound;
+        }
+#endif
+    }
+    errno = ENOTSUP;
+    return -1;
+}
+
+int content_codec_compress (int codec,
+                            const void *src,
+                            int srcsize,
+                            void *dst,
+                            int dstsize)
+{
+    int r;
+
+    if (!src || srcsize < 0 || !dst || dstsize < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    switch (codec) {
+        case CONTENT_CODEC_NONE:
+            if (dstsize < srcsize) {
+                errno = EOVERFLOW;
+                return -1;
+            }
+            memcpy (dst, src, srcsize);
+            return srcsize;
+        case CONTENT_CODEC_LZ4:
+            if ((r = LZ4_compress_default (src, dst, srcsize, dstsize)) == 0) {
+                errno = EINVAL;
+                return -1;
+            }
+            return r;
+#if HAVE_ZSTD
+        case CONTENT_CODEC_ZSTD: {
+            size_t n = ZSTD_compress (dst, dstsize, src, srcsize, zstd_level);
+            if (ZSTD_isError (n)) {
+                errno = EINVAL;
+                return -1;
+            }
+            return n;
+        }
+#endif
+    }
+    errno = ENOTSUP;
+    return -1;
+}
+
+int content_codec_decompress (int codec,
+                              const void *src,
+                              int srcsize,
+                              void *dst,
+                              int dstsize)
+{
+    if (!src || srcsize < 0 || !dst || dstsize < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    switch (codec) {
+        case CONTENT_CODEC_NONE:
+            if (srcsize != dstsize) {
+                errno = EINVAL;
+                return -1;
+            }
+            memcpy (dst, src, srcsize);
+            return dstsize;
+        case CONTENT_CODEC_LZ4:
+            if (LZ4_decompress_safe (src, dst, srcsize, dstsize) != dstsize) {
+                errno = EINVAL;
+                return -1;
+            }
+            return dstsize;
+#if HAVE_ZSTD
+        case CONTENT_CODEC_ZSTD: {
+            size_t n = ZSTD_decompress (dst, dstsize, src, srcsize);
+            if (ZSTD_isError (n) || n != dstsize) {
+                errno = EINVAL;
+                return -1;
+            }
+            return dstsize;
+        }
+#endif
+    }
+    errno = ENOTSUP;
+    return -1;
+}
+
+void content_codec_header_encode (void *buf, int codec, int size)
+{
+    uint8_t *p = buf;
+    uint32_t nsize = htonl (size);
+
+    memcpy (p, header_magic, sizeof (header_magic));
+    p += sizeof (header_magic);
+    *p++ = header_version;
+    *p++ = codec;
+    *p++ = 0; // reserved
+    memcpy (p, &nsize, sizeof (nsize));
+}
+
+bool content_codec_header_check (const void *buf, int len)
+{
+    if (!buf
+        || len < sizeof (header_magic)
+        || memcmp (buf, header_magic, sizeof (header_magic)) != 0)
+        return false;
+    return true;
+}
+
+int content_codec_header_decode (const void *buf,
+                                 int len,
+                                 int *codecp,
+                                 int *sizep)
+{
+    const uint8_t *p = buf;
+    uint32_t nsize;
+
+    if (len < CONTENT_CODEC_HEADER_SIZE
+        || !content_codec_header_check (buf, len)
+        || p[sizeof (header_magic)] != header_version) {
+        errno = EINVAL;
+        return -1;
+    }
+    p += sizeof (header_magic) + 1;
+    if (codecp)
+        *codecp = *p;
+    p += 2;
+    memcpy (&nsize, p, sizeof (nsize));
+    if (ntohl (nsize) > INT32_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (sizep)
+        *sizep = ntohl (nsize);
+    return 0;
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,94 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Blob compression for content backing stores.
+ *
+ * The codec identifiers are stored persistently by backing stores,
+ * so they must not be renumbered.
+ *
+ * These functions do not use a flux_t handle and are safe to call
+ * from worker threads.
+ */
+
+#ifndef _FLUX_CONTENT_CODEC_H
+#define _FLUX_CONTENT_CODEC_H
+
+#include <stdbool.h>
+
+enum {
+    CONTENT_CODEC_NONE = 0,
+    CONTENT_CODEC_LZ4 = 1,
+    CONTENT_CODEC_ZSTD = 2,
+};
+
+/* Look up codec by name ("none", "lz4", "zstd").
+ * Returns codec id on success, or -1 with errno set to EINVAL if the name
+ * is unknown, or ENOTSUP if support was not compiled in.
+ */
+int content_codec_lookup (const char *name);
+
+/* Return name of 'codec', or NULL if unknown.
+ */
+const char *content_codec_name (int codec);
+
+/* Return the maximum size of 'size' bytes compressed with 'codec',
+ * or -1 with errno set on error.
+ */
+int content_codec_bound (int codec, int size);
+
+/* Compress 'src' into 'dst', which should be at least
+ * content_codec_bound() bytes.  Returns compressed size on success,
+ * or -1 with errno set on error.
+ */
+int content_codec_compress (int codec,
+                            const void *src,
+                            int srcsize,
+                            void *dst,
+                            int dstsize);
+
+/* Decompress 'src' into 'dst'.  'dstsize' must be the exact uncompressed
+ * size.  Returns 'dstsize' on success, or -1 with errno set on error.
+ */
+int content_codec_decompress (int codec,
+                              const void *src,
+                              int srcsize,
+                              void *dst,
+                              int dstsize);
+
+/* Header prepended to blobs by backing stores that have no other place
+ * to record the codec, such as content-files.  It consists of a magic
+ * number, a version, the codec id, and the uncompressed size.
+ */
+#define CONTENT_CODEC_HEADER_SIZE 12
+
+/* Encode a header into 'buf', which must have room for
+ * CONTENT_CODEC_HEADER_SIZE bytes.
+ */
+void content_codec_header_encode (void *buf, int codec, int size);
+
+/* Decode a header from the beginning of 'buf'.
+ * Returns 0 on success, or -1 with errno set to EINVAL if 'buf' does not
+ * begin with a valid header.
+ */
+int content_codec_header_decode (const void *buf,
+                                 int len,
+                                 int *codec,
+                                 int *size);
+
+/* Return true if 'buf' begins with the header magic number,
+ * and thus would be misinterpreted if stored without a header.
+ */
+bool content_codec_header_check (const void *buf, int len);
+
+#endif /* !_FLUX_CONTENT_CODEC_H */
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,775 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* content-gc.c - online mark and sweep for backing stores
+ *
+ * See content-gc.h for the protocol.  The live set is an open addressing
+ * hash table of raw digests, so it costs a little more than hash_size
+ * bytes per live object.  Objects waiting to be traversed are kept on
+ * a stack of digests.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/errno_safe.h"
+#include "src/common/libkvs/treeobj.h"
+
+#include "content-gc.h"
+
+static const double slice_time = 5.; // milliseconds of work per iteration
+static const int mark_chunk = 16;
+static const int stored_chunk = 64;
+static const int sweep_chunk = 64;
+static const size_t markset_min_slots = 1024;
+
+enum gc_state {
+    GC_IDLE,
+    GC_DROPCACHE,           // waiting for content.dropcache
+    GC_ROOTS,               // waiting for kvs.gc-roots
+    GC_STORED,              // backend is listing recently stored objects
+    GC_MARK,
+    GC_SWEEP,
+};
+
+static const char *state_name[] = {
+    "idle", "dropcache", "roots", "stored", "mark", "sweep",
+};
+
+struct markset {
+    uint8_t *slots;
+    uint8_t *used;
+    size_t nslots;          // power of 2
+    size_t count;
+};
+
+struct gc_cycle {
+    unsigned long roots;
+    unsigned long stored;   // roots that were recently stored objects
+    unsigned long loaded;
+    unsigned long missing;
+    unsigned long examined;
+    unsigned long removed;
+    unsigned long long reclaimed;
+    double duration;
+};
+
+struct content_gc {
+    flux_t *h;
+    const char *hashfun;
+    int hash_size;
+    const struct content_gc_ops *ops;
+    void *arg;
+
+    enum gc_state state;
+    bool marking;           // live set and write barrier are active
+    bool backend_started;   // ops->stored() or ops->sweep() was called
+    int barrier_errnum;     // write barrier failed, cycle must not sweep
+    struct markset live;
+    uint8_t *stack;         // digests waiting to be traversed
+    size_t stack_count;
+    size_t stack_alloc;
+
+    flux_future_t *f;
+    flux_watcher_t *prep_w;
+    flux_watcher_t *check_w;
+    flux_watcher_t *idle_w;
+    struct flux_msglist *requests;
+    struct timespec t0;
+
+    struct gc_cycle cycle;  // current or most recent cycle
+    unsigned long cycles;
+    unsigned long failures;
+    unsigned long long total_removed;
+    unsigned long long total_reclaimed;
+};
+
+static void gc_finish (struct content_gc *gc, int errnum, const char *errstr);
+
+static size_t markset_index (struct markset *ms,
+                             const void *hash,
+                             int hash_size)
+{
+    uint64_t h;
+
+    /* digests are uniformly distributed, so any 8 bytes will do */
+    memcpy (&h, hash, sizeof (h));
+    (void)hash_size;
+    return h & (ms->nslots - 1);
+}
+
+static void markset_free (struct markset *ms)
+{
+    free (ms->slots);
+    free (ms->used);
+    memset (ms, 0, sizeof (*ms));
+}
+
+static int markset_init (struct markset *ms, int hash_size, size_t nslots)
+{
+    memset (ms, 0, sizeof (*ms));
+    if (!(ms->slots = calloc (nslots, hash_size))
+        || !(ms->used = calloc (nslots, 1))) {
+        markset_free (ms);
+        errno = ENOMEM;
+        return -1;
+    }
+    ms->nslots = nslots;
+    return 0;
+}
+
+static bool markset_lookup (struct markset *ms,
+                            const void *hash,
+                            int hash_size,
+                            size_t *indexp)
+{
+    size_t i = markset_index (ms, hash, hash_size);
+
+    while (ms->used[i]) {
+        if (!memcmp (ms->slots + i * hash_size, hash, hash_size)) {
+            *indexp = i;
+            return true;
+        }
+        i = (i + 1) & (ms->nslots - 1);
+    }
+    *indexp = i;
+    return false;
+}
+
+static int markset_grow (struct markset *ms, int hash_size)
+{
+    struct markset new;
+    size_t i;
+
+    if (markset_init (&new, hash_size, ms->nslots * 2) < 0)
+        return -1;
+    for (i = 0; i < ms->nslots; i++) {
+        if (ms->used[i]) {
+            const uint8_t *hash = ms->slots + i * hash_size;
+            size_t j;
+
+            (void)markset_lookup (&new, hash, hash_size, &j);
+            memcpy (new.slots + j * hash_size, hash, hash_size);
+            new.used[j] = 1;
+        }
+    }
+    new.count = ms->count;
+    markset_free (ms);
+    *ms = new;
+    return 0;
+}
+
+/* Add 'hash' to the set.
+ * Returns 1 if it was added, 0 if it was already present, -1 on error.
+ */
+static int markset_add (struct markset *ms, const void *hash, int hash_size)
+{
+    size_t i;
+
+    if (markset_lookup (ms, hash, hash_size, &i))
+        return 0;
+    if ((ms->count + 1) * 10 > ms->nslots * 7) { // keep load factor <= 0.7
+        if (markset_grow (ms, hash_size) < 0)
+            return -1;
+        (void)markset_lookup (ms, hash, hash_size, &i);
+    }
+    memcpy (ms->slots + i * hash_size, hash, hash_size);
+    ms->used[i] = 1;
+    ms->count++;
+    return 1;
+}
+
+static int stack_push (struct content_gc *gc, const void *hash)
+{
+    if (gc->stack_count == gc->stack_alloc) {
+        size_t new_alloc = gc->stack_alloc ? gc->stack_alloc * 2 : 1024;
+        uint8_t *new_stack;
+
+        if (!(new_stack = realloc (gc->stack, new_alloc * gc->hash_size))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        gc->stack = new_stack;
+        gc->stack_alloc = new_alloc;
+    }
+    memcpy (gc->stack + gc->stack_count++ * gc->hash_size,
+            hash,
+            gc->hash_size);
+    return 0;
+}
+
+/* Mark 'hash' live.  If it was not already marked and is not a leaf,
+ * queue it to be traversed.
+ */
+static int mark_hash (struct content_gc *gc,
+                      const void *hash,
+                      int hash_size,
+                      bool leaf)
+{
+    int rc;
+
+    if (hash_size != gc->hash_size) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((rc = markset_add (&gc->live, hash, hash_size)) < 0)
+        return -1;
+    if (rc == 1 && !leaf && stack_push (gc, hash) < 0)
+        return -1;
+    return 0;
+}
+
+static int mark_blobref (struct content_gc *gc, const char *blobref, bool leaf)
+{
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_size;
+
+    if ((hash_size = blobref_strtohash (blobref, hash, sizeof (hash))) < 0)
+        return -1;
+    return mark_hash (gc, hash, hash_size, leaf);
+}
+
+/* Mark the objects referenced by treeobj 'o'.  Dirs and hamts that
+ * appear in place of dirrefs are walked.  Valref targets are leaves.
+ */
+static int mark_treeobj (struct content_gc *gc, json_t *o)
+{
+    if (treeobj_is_dirref (o) || treeobj_is_valref (o)) {
+        bool leaf = treeobj_is_valref (o);
+        int count = treeobj_get_count (o);
+        int i;
+
+        for (i = 0; i < count; i++) {
+            const char *blobref;
+
+            if (!(blobref = treeobj_get_blobref (o, i))
+                || mark_blobref (gc, blobref, leaf) < 0)
+                return -1;
+        }
+    }
+    else if (treeobj_is_dir (o) || treeobj_is_hamt (o)) {
+        json_t *data = treeobj_get_data (o);
+        const char *name;
+        json_t *entry;
+
+        json_object_foreach (data, name, entry) {
+            if (mark_treeobj (gc, entry) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/* Mark the objects referenced by blob 'data', if it is a treeobj.
+ * Anything else is a leaf.
+ */
+static int mark_blob (struct content_gc *gc, const void *data, int size)
+{
+    json_t *o;
+    int rc;
+
+    if (size == 0 || ((const char *)data)[0] != '{'
+        || !(o = treeobj_decodeb (data, size)))
+        return 0;
+    rc = mark_treeobj (gc, o);
+    ERRNO_SAFE_WRAP (json_decref, o);
+    return rc;
+}
+
+void content_gc_mark (struct content_gc *gc,
+                      const void *hash,
+                      int hash_size,
+                      const void *data,
+                      int size)
+{
+    int rc;
+
+    if (!gc || !gc->marking)
+        return;
+    if ((rc = markset_add (&gc->live, hash, hash_size)) == 1) {
+        if (data)
+            rc = mark_blob (gc, data, size);
+        else
+            rc = stack_push (gc, hash);
+    }
+    /* Don't end the cycle from here, since the barrier may be called
+     * from inside a sweep.  gc_slice() picks this up.
+     */
+    if (rc < 0 && gc->barrier_errnum == 0)
+        gc->barrier_errnum = errno;
+}
+
+bool content_gc_is_live (struct content_gc *gc,
+                         const void *hash,
+                         int hash_size)
+{
+    size_t i;
+
+    if (!gc || !gc->marking || hash_size != gc->hash_size)
+        return true;
+    return markset_lookup (&gc->live, hash, hash_size, &i);
+}
+
+void content_gc_swept (struct content_gc *gc,
+                       int examined,
+                       int removed,
+                       size_t size)
+{
+    if (gc) {
+        gc->cycle.examined += examined;
+        gc->cycle.removed += removed;
+        gc->cycle.reclaimed += size;
+    }
+}
+
+bool content_gc_active (struct content_gc *gc)
+{
+    return gc && gc->state != GC_IDLE;
+}
+
+int content_gc_mark_begin (struct content_gc *gc)
+{
+    if (!gc) {
+        errno = EINVAL;
+        return -1;
+    }
+    markset_free (&gc->live);
+    gc->stack_count = 0;
+    gc->barrier_errnum = 0;
+    if (markset_init (&gc->live, gc->hash_size, markset_min_slots) < 0)
+        return -1;
+    gc->marking = true;
+    return 0;
+}
+
+int content_gc_add_root (struct content_gc *gc,
+                         const void *hash,
+                         int hash_size,
+                         bool leaf)
+{
+    if (!gc || !gc->marking) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (mark_hash (gc, hash, hash_size, leaf) < 0)
+        return -1;
+    gc->cycle.roots++;
+    return 0;
+}
+
+int content_gc_add_stored (struct content_gc *gc,
+                           const void *hash,
+                           int hash_size)
+{
+    if (content_gc_add_root (gc, hash, hash_size, false) < 0)
+        return -1;
+    gc->cycle.stored++;
+    return 0;
+}
+
+int content_gc_mark_step (struct content_gc *gc, int max)
+{
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    int n = 0;
+
+    if (!gc || !gc->marking) {
+        errno = EINVAL;
+        return -1;
+    }
+    while (gc->stack_count > 0 && n++ < max) {
+        void *data;
+        int size;
+        int rc;
+
+        gc->stack_count--;
+        memcpy (hash, gc->stack + gc->stack_count * gc->hash_size,
+                gc->hash_size);
+        if (gc->ops->load (hash, gc->hash_size, &data, &size, gc->arg) < 0) {
+            if (errno != ENOENT)
+                return -1;
+            gc->cycle.missing++;
+            continue;
+        }
+        gc->cycle.loaded++;
+        rc = mark_blob (gc, data, size);
+        ERRNO_SAFE_WRAP (free, data);
+        if (rc < 0)
+            return -1;
+    }
+    return gc->stack_count;
+}
+
+static void gc_watchers_stop (struct content_gc *gc)
+{
+    flux_watcher_stop (gc->prep_w);
+    flux_watcher_stop (gc->check_w);
+    flux_watcher_stop (gc->idle_w);
+}
+
+static json_t *cycle_summary (struct content_gc *gc)
+{
+    return json_pack ("{s:i s:i s:I s:i s:i s:i s:i s:I s:f}",
+                      "roots", (int)gc->cycle.roots,
+                      "stored", (int)gc->cycle.stored,
+                      "marked", (json_int_t)gc->live.count,
+                      "loaded", (int)gc->cycle.loaded,
+                      "missing", (int)gc->cycle.missing,
+                      "examined", (int)gc->cycle.examined,
+                      "removed", (int)gc->cycle.removed,
+                      "reclaimed_bytes", (json_int_t)gc->cycle.reclaimed,
+                      "duration", gc->cycle.duration);
+}
+
+/* End the current cycle and respond to all waiting requests.
+ */
+static void gc_finish (struct content_gc *gc, int errnum, const char *errstr)
+{
+    const flux_msg_t *msg;
+    json_t *summary = NULL;
+
+    if (gc->state == GC_IDLE)
+        return;
+    gc->cycle.duration = monotime_since (gc->t0) * 1E-3;
+    if (gc->backend_started && gc->ops->finish)
+        gc->ops->finish (gc, errnum, gc->arg);
+    gc_watchers_stop (gc);
+    flux_future_destroy (gc->f);
+    gc->f = NULL;
+    gc->state = GC_IDLE;
+    gc->marking = false;
+    gc->backend_started = false;
+    gc->cycles++;
+    if (errnum) {
+        gc->failures++;
+        flux_log (gc->h,
+                  LOG_ERR,
+                  "gc: %s: %s",
+                  errstr ? errstr : "cycle failed",
+                  strerror (errnum));
+    }
+    else {
+        gc->total_removed += gc->cycle.removed;
+        gc->total_reclaimed += gc->cycle.reclaimed;
+        flux_log (gc->h,
+                  LOG_INFO,
+                  "gc: removed %lu of %lu objects (%llu bytes) in %.3fs",
+                  gc->cycle.removed,
+                  gc->cycle.examined,
+                  gc->cycle.reclaimed,
+                  gc->cycle.duration);
+        summary = cycle_summary (gc);
+    }
+    msg = flux_msglist_first (gc->requests);
+    while (msg) {
+        int rc;
+        if (errnum)
+            rc = flux_respond_error (gc->h, msg, errnum, errstr);
+        else
+            rc = flux_respond_pack (gc->h, msg, "O", summary);
+        if (rc < 0)
+            flux_log_error (gc->h, "error responding to gc request");
+        flux_msglist_delete (gc->requests);
+        msg = flux_msglist_next (gc->requests);
+    }
+    json_decref (summary);
+    markset_free (&gc->live);
+    free (gc->stack);
+    gc->stack = NULL;
+    gc->stack_count = gc->stack_alloc = 0;
+}
+
+/* Do a slice of stored, mark or sweep work.  Queued objects are
+ * traversed before the backend is asked for more stored objects, and
+ * during the sweep, objects marked by the write barrier are traversed
+ * before anything more is removed.
+ */
+static void gc_slice (struct content_gc *gc)
+{
+    struct timespec t0;
+    int n;
+
+    monotime (&t0);
+    do {
+        if (gc->barrier_errnum) {
+            gc_finish (gc, gc->barrier_errnum, "error marking live objects");
+            return;
+        }
+        if (gc->stack_count > 0 || gc->state == GC_MARK) {
+            if ((n = content_gc_mark_step (gc, mark_chunk)) < 0) {
+                gc_finish (gc, errno, "error marking live objects");
+                return;
+            }
+            if (n == 0 && gc->state == GC_MARK) {
+                gc->state = GC_SWEEP;
+                gc->backend_started = true;
+            }
+        }
+        else if (gc->state == GC_STORED) {
+            gc->backend_started = true;
+            if ((n = gc->ops->stored (gc, stored_chunk, gc->arg)) < 0) {
+                gc_finish (gc, errno, "error marking recently stored objects");
+                return;
+            }
+            if (n == 0)
+                gc->state = GC_MARK;
+        }
+        else {
+            if ((n = gc->ops->sweep (gc, sweep_chunk, gc->arg)) < 0) {
+                gc_finish (gc, errno, "error removing unreachable objects");
+                return;
+            }
+            if (n == 0) {
+                gc_finish (gc, 0, NULL);
+                return;
+            }
+        }
+    } while (monotime_since (t0) < slice_time);
+}
+
+static void prep_cb (flux_reactor_t *r,
+                     flux_watcher_t *w,
+                     int revents,
+                     void *arg)
+{
+    struct content_gc *gc = arg;
+
+    flux_watcher_start (gc->idle_w);
+}
+
+static void check_cb (flux_reactor_t *r,
+                      flux_watcher_t *w,
+                      int revents,
+                      void *arg)
+{
+    struct content_gc *gc = arg;
+
+    flux_watcher_stop (gc->idle_w);
+    if (gc->state == GC_STORED
+        || gc->state == GC_MARK
+        || gc->state == GC_SWEEP)
+        gc_slice (gc);
+}
+
+/* Mark the roots found in stored checkpoints.
+ */
+static int add_checkpoint_roots (struct content_gc *gc)
+{
+    json_t *values;
+    size_t index;
+    json_t *value;
+
+    if (!(values = gc->ops->checkpoints (gc->arg)))
+        return -1;
+    json_array_foreach (values, index, value) {
+        const char *rootref = NULL;
+        const char *snapshotref = NULL;
+
+        if (json_unpack (value,
+                         "{s?s s?s}",
+                         "rootref", &rootref,
+                         "snapshotref", &snapshotref) < 0)
+            continue;
+        if ((rootref && mark_blobref (gc, rootref, false) < 0)
+            || (snapshotref && mark_blobref (gc, snapshotref, true) < 0)) {
+            ERRNO_SAFE_WRAP (json_decref, values);
+            return -1;
+        }
+        if (rootref)
+            gc->cycle.roots++;
+        if (snapshotref)
+            gc->cycle.roots++;
+    }
+    json_decref (values);
+    return 0;
+}
+
+static void roots_continuation (flux_future_t *f, void *arg)
+{
+    struct content_gc *gc = arg;
+    const uint8_t *hashes;
+    int size = 0;
+    int i;
+
+    if (flux_rpc_get_raw (f, (const void **)&hashes, &size) < 0) {
+        if (errno != ENOSYS) {
+            gc_finish (gc, errno, "error fetching KVS roots");
+            return;
+        }
+        /* Without a KVS there are no KVS caches to protect.
+         */
+        flux_log (gc->h, LOG_DEBUG, "gc: kvs is not loaded");
+        size = 0;
+    }
+    if (size % gc->hash_size != 0) {
+        gc_finish (gc, EPROTO, "malformed kvs.gc-roots response");
+        return;
+    }
+    for (i = 0; i < size / gc->hash_size; i++) {
+        if (content_gc_add_root (gc,
+                                 hashes + i * gc->hash_size,
+                                 gc->hash_size,
+                                 false) < 0) {
+            gc_finish (gc, errno, "error marking KVS roots");
+            return;
+        }
+    }
+    if (add_checkpoint_roots (gc) < 0) {
+        gc_finish (gc, errno, "error marking checkpoint roots");
+        return;
+    }
+    flux_future_destroy (f);
+    gc->f = NULL;
+    gc->state = gc->ops->stored ? GC_STORED : GC_MARK;
+    flux_watcher_start (gc->prep_w);
+    flux_watcher_start (gc->check_w);
+}
+
+static void dropcache_continuation (flux_future_t *f, void *arg)
+{
+    struct content_gc *gc = arg;
+
+    if (flux_rpc_get (f, NULL) < 0) {
+        gc_finish (gc, errno, "error dropping content cache");
+        return;
+    }
+    flux_future_destroy (f);
+    if (!(gc->f = flux_rpc (gc->h, "kvs.gc-roots", NULL, 0, 0))
+        || flux_future_then (gc->f, -1., roots_continuation, gc) < 0) {
+        gc_finish (gc, errno, "error fetching KVS roots");
+        return;
+    }
+    gc->state = GC_ROOTS;
+}
+
+static int gc_start (struct content_gc *gc)
+{
+    memset (&gc->cycle, 0, sizeof (gc->cycle));
+    monotime (&gc->t0);
+    if (content_gc_mark_begin (gc) < 0)
+        return -1;
+    gc->state = GC_DROPCACHE;
+    if (!(gc->f = flux_rpc (gc->h, "content.dropcache", NULL, 0, 0))
+        || flux_future_then (gc->f, -1., dropcache_continuation, gc) < 0) {
+        gc_finish (gc, errno, "error dropping content cache");
+        return -1;
+    }
+    return 0;
+}
+
+void content_gc_request (struct content_gc *gc, const flux_msg_t *msg)
+{
+    if (!gc->h) {
+        errno = EINVAL;
+        goto error;
+    }
+    if (flux_msglist_append (gc->requests, msg) < 0)
+        goto error;
+    if (gc->state == GC_IDLE)
+        (void)gc_start (gc); // on failure, gc_finish() has responded
+    return;
+error:
+    if (flux_respond_error (gc->h, msg, errno, NULL) < 0)
+        flux_log_error (gc->h, "error responding to gc request");
+}
+
+json_t *content_gc_stats (struct content_gc *gc)
+{
+    json_t *o;
+
+    if (!(o = json_pack ("{s:s s:i s:i s:I s:I s:{s:i s:i s:I s:i s:i s:i"
+                         " s:i s:i s:I s:f}}",
+                         "state", state_name[gc->state],
+                         "cycles", (int)gc->cycles,
+                         "failures", (int)gc->failures,
+                         "removed", (json_int_t)gc->total_removed,
+                         "reclaimed_bytes", (json_int_t)gc->total_reclaimed,
+                         "cycle",
+                           "roots", (int)gc->cycle.roots,
+                           "stored", (int)gc->cycle.stored,
+                           "marked", (json_int_t)gc->live.count,
+                           "queued", (int)gc->stack_count,
+                           "loaded", (int)gc->cycle.loaded,
+                           "missing", (int)gc->cycle.missing,
+                           "examined", (int)gc->cycle.examined,
+                           "removed", (int)gc->cycle.removed,
+                           "reclaimed_bytes", (json_int_t)gc->cycle.reclaimed,
+                           "duration", gc->state == GC_IDLE
+                                       ? gc->cycle.duration
+                                       : monotime_since (gc->t0) * 1E-3))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
+void content_gc_destroy (struct content_gc *gc)
+{
+    if (gc) {
+        int saved_errno = errno;
+        if (gc->h)
+            gc_finish (gc, ECANCELED, "module is unloading");
+        flux_watcher_destroy (gc->prep_w);
+        flux_watcher_destroy (gc->check_w);
+        flux_watcher_destroy (gc->idle_w);
+        flux_msglist_destroy (gc->requests);
+        markset_free (&gc->live);
+        free (gc->stack);
+        free (gc);
+        errno = saved_errno;
+    }
+}
+
+struct content_gc *content_gc_create (flux_t *h,
+                                      const char *hashfun,
+                                      const struct content_gc_ops *ops,
+                                      void *arg)
+{
+    struct content_gc *gc;
+
+    if (!hashfun || !ops || !ops->load || !ops->checkpoints || !ops->sweep) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(gc = calloc (1, sizeof (*gc))))
+        return NULL;
+    gc->h = h;
+    gc->hashfun = hashfun;
+    gc->ops = ops;
+    gc->arg = arg;
+    if ((gc->hash_size = blobref_validate_hashtype (hashfun)) < 0)
+        goto error;
+    if (!(gc->requests = flux_msglist_create ()))
+        goto error;
+    if (h) {
+        flux_reactor_t *r = flux_get_reactor (h);
+
+        if (!(gc->prep_w = flux_prepare_watcher_create (r, prep_cb, gc))
+            || !(gc->check_w = flux_check_watcher_create (r, check_cb, gc))
+            || !(gc->idle_w = flux_idle_watcher_create (r, NULL, NULL)))
+            goto error;
+    }
+    return gc;
+error:
+    content_gc_destroy (gc);
+    return NULL;
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,171 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Online mark and sweep garbage collection for backing store modules.
+ *
+ * A collection cycle is started by a content-backing.gc request.
+ * Work is done in small slices from the reactor so that the backing
+ * store keeps serving requests while it runs:
+ *
+ * 1) A write barrier is enabled: every object the backing store loads
+ *    or stores is marked live until the cycle ends.  The broker content
+ *    cache is then dropped, so that any object it hands out from here
+ *    on passes through the barrier.
+ *
+ * 2) Roots are collected: the current root of each KVS namespace and
+ *    every object in the KVS cache (kvs.gc-roots), plus the "rootref"
+ *    and "snapshotref" of each stored checkpoint.  Every object stored
+ *    since the previous cycle reached this step is a root too, so a
+ *    client that stores blobs and commits references to them later
+ *    (e.g. flux-restore(1)) has until the next cycle to do so.  The
+ *    backend lists those from its own storage (e.g. by rowid or mtime),
+ *    so nothing is held in memory between cycles.
+ *
+ * 3) Mark: objects reachable from the roots through dirrefs, valrefs,
+ *    dirs and hamt shards are marked.  Valref targets are marked
+ *    without being loaded.
+ *
+ * 4) Sweep: the backend examines its stored objects a few at a time
+ *    and removes those that are not marked.
+ *
+ * Objects reachable only from older roots are garbage, so readers of
+ * an old root (e.g. flux kvs get --at) may see ENOENT afterwards.
+ * If any step before the sweep fails, the cycle ends without removing
+ * anything.
+ */
+
+#ifndef _FLUX_CONTENT_GC_H
+#define _FLUX_CONTENT_GC_H
+
+#include <stdbool.h>
+#include <flux/core.h>
+#include <jansson.h>
+
+struct content_gc;
+
+struct content_gc_ops {
+    /* Load blob 'hash' into a malloc'd buffer (*datap must be freed).
+     * Fail with ENOENT if it is not stored.
+     */
+    int (*load)(const void *hash,
+                int hash_size,
+                void **datap,
+                int *sizep,
+                void *arg);
+
+    /* Return a new JSON array of stored checkpoint values.
+     */
+    json_t *(*checkpoints)(void *arg);
+
+    /* List up to 'max' objects stored since the previous cycle called
+     * this, passing each to content_gc_add_stored().  Objects stored
+     * from the first call of a cycle on are listed by the next cycle.
+     * An object stored again while already present counts as stored.
+     * Return 1 if there is more to do, 0 when done, or -1 on error with
+     * errno set.  May be NULL.
+     */
+    int (*stored)(struct content_gc *gc, int max, void *arg);
+
+    /* Examine up to 'max' stored objects, removing those for which
+     * content_gc_is_live() is false, and report progress with
+     * content_gc_swept().  The backend may then compact its storage in
+     * further calls.  Return 1 if there is more to do, 0 when done,
+     * or -1 on error with errno set.
+     */
+    int (*sweep)(struct content_gc *gc, int max, void *arg);
+
+    /* Called at the end of each cycle that called stored() or sweep(),
+     * with 'errnum' set if it did not complete.  After a failed cycle,
+     * the next stored() must list the objects this cycle's did as well.
+     * May be NULL.
+     */
+    void (*finish)(struct content_gc *gc, int errnum, void *arg);
+};
+
+/* Create a collector for a backend using hash function 'hashfun'.
+ * If 'h' is NULL, cycles cannot be started but the marking functions
+ * below still work, which is useful for testing.
+ */
+struct content_gc *content_gc_create (flux_t *h,
+                                      const char *hashfun,
+                                      const struct content_gc_ops *ops,
+                                      void *arg);
+
+void content_gc_destroy (struct content_gc *gc);
+
+/* Handle a content-backing.gc request.  The response is sent when the
+ * cycle completes, with a summary of the cycle.  If a cycle is already
+ * running, the request is answered when it completes.
+ */
+void content_gc_request (struct content_gc *gc, const flux_msg_t *msg);
+
+/* Return true if a cycle is in progress.
+ */
+bool content_gc_active (struct content_gc *gc);
+
+/* Write barrier: mark 'hash' live if a cycle is in progress.  Pass the
+ * blob in 'data' and 'size' if it is at hand, so that the objects it
+ * references can be marked without loading it again.  Otherwise set
+ * 'data' to NULL.
+ */
+void content_gc_mark (struct content_gc *gc,
+                      const void *hash,
+                      int hash_size,
+                      const void *data,
+                      int size);
+
+/* Return true if 'hash' has been marked live in this cycle.
+ */
+bool content_gc_is_live (struct content_gc *gc,
+                         const void *hash,
+                         int hash_size);
+
+/* Account for 'examined' objects examined by the sweep, of which
+ * 'removed' were removed, reclaiming 'size' bytes as best the backend
+ * can tell.
+ */
+void content_gc_swept (struct content_gc *gc,
+                       int examined,
+                       int removed,
+                       size_t size);
+
+/* Start marking by hand, without the root collection protocol.
+ * Used for testing.
+ */
+int content_gc_mark_begin (struct content_gc *gc);
+
+/* Add root 'hash' to be marked and traversed.  If 'leaf' is true, it
+ * is marked without being loaded.
+ */
+int content_gc_add_root (struct content_gc *gc,
+                         const void *hash,
+                         int hash_size,
+                         bool leaf);
+
+/* Add recently stored object 'hash' as a root, from ops->stored().
+ */
+int content_gc_add_stored (struct content_gc *gc,
+                           const void *hash,
+                           int hash_size);
+
+/* Load and traverse up to 'max' objects queued for marking.
+ * Returns the number of objects still queued, or -1 on error.
+ */
+int content_gc_mark_step (struct content_gc *gc, int max);
+
+/* Return stats object for the backend's stats-get response.
+ */
+json_t *content_gc_stats (struct content_gc *gc);
+
+#endif /* !_FLUX_CONTENT_GC_H */
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
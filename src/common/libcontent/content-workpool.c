@@ -0,0 +1,239 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* content-workpool.c - worker threads with completion on the reactor
+ *
+ * Work items are queued on 'todo' and picked up by worker threads.
+ * Completed items are moved to 'done' and a byte is written to a pipe,
+ * whose fd watcher calls the 'done' functions on the reactor thread.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <flux/core.h>
+
+#include "content-workpool.h"
+
+struct work {
+    content_work_f work;
+    content_work_f done;
+    void *arg;
+    struct work *next;
+};
+
+struct workq {
+    struct work *head;
+    struct work *tail;
+};
+
+struct content_workpool {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct workq todo;
+    struct workq done;
+    bool shutdown;
+    int pending;
+    int nthreads;
+    pthread_t *threads;
+    int fds[2];
+    flux_watcher_t *w;
+};
+
+static void workq_push (struct workq *q, struct work *w)
+{
+    w->next = NULL;
+    if (q->tail)
+        q->tail->next = w;
+    else
+        q->head = w;
+    q->tail = w;
+}
+
+static struct work *workq_pop (struct workq *q)
+{
+    struct work *w;
+
+    if ((w = q->head)) {
+        if (!(q->head = w->next))
+            q->tail = NULL;
+    }
+    return w;
+}
+
+static void *worker (void *arg)
+{
+    struct content_workpool *wp = arg;
+    struct work *w;
+
+    pthread_mutex_lock (&wp->lock);
+    for (;;) {
+        while (!wp->todo.head && !wp->shutdown)
+            pthread_cond_wait (&wp->cond, &wp->lock);
+        if (!(w = workq_pop (&wp->todo)))
+            break; // shutdown and nothing left to do
+        pthread_mutex_unlock (&wp->lock);
+
+        w->work (w->arg);
+
+        pthread_mutex_lock (&wp->lock);
+        if (!wp->done.head) {
+            char c = 0;
+            if (write (wp->fds[1], &c, 1) < 0) {
+                // pipe is full, so the reactor is already notified
+            }
+        }
+        workq_push (&wp->done, w);
+    }
+    pthread_mutex_unlock (&wp->lock);
+    return NULL;
+}
+
+/* Call 'done' functions for all completed work.
+ */
+static void workpool_complete (struct content_workpool *wp)
+{
+    struct workq done;
+    struct work *w;
+    char buf[64];
+
+    pthread_mutex_lock (&wp->lock);
+    while (read (wp->fds[0], buf, sizeof (buf)) > 0)
+        ;
+    done = wp->done;
+    wp->done.head = wp->done.tail = NULL;
+    pthread_mutex_unlock (&wp->lock);
+
+    while ((w = workq_pop (&done))) {
+        wp->pending--;
+        if (w->done)
+            w->done (w->arg);
+        free (w);
+    }
+}
+
+static void workpool_cb (flux_reactor_t *r,
+                         flux_watcher_t *w,
+                         int revents,
+                         void *arg)
+{
+    workpool_complete (arg);
+}
+
+int content_workpool_submit (struct content_workpool *wp,
+                             content_work_f work,
+                             content_work_f done,
+                             void *arg)
+{
+    struct work *w;
+
+    if (!wp || !work) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(w = calloc (1, sizeof (*w))))
+        return -1;
+    w->work = work;
+    w->done = done;
+    w->arg = arg;
+    pthread_mutex_lock (&wp->lock);
+    workq_push (&wp->todo, w);
+    pthread_cond_signal (&wp->cond);
+    pthread_mutex_unlock (&wp->lock);
+    wp->pending++;
+    return 0;
+}
+
+int content_workpool_pending (struct content_workpool *wp)
+{
+    return wp ? wp->pending : 0;
+}
+
+int content_workpool_nthreads (struct content_workpool *wp)
+{
+    return wp ? wp->nthreads : 0;
+}
+
+void content_workpool_destroy (struct content_workpool *wp)
+{
+    if (wp) {
+        int saved_errno = errno;
+        int i;
+
+        pthread_mutex_lock (&wp->lock);
+        wp->shutdown = true;
+        pthread_cond_broadcast (&wp->cond);
+        pthread_mutex_unlock (&wp->lock);
+        for (i = 0; i < wp->nthreads; i++)
+            (void)pthread_join (wp->threads[i], NULL);
+        if (wp->fds[0] >= 0)
+            workpool_complete (wp);
+        flux_watcher_destroy (wp->w);
+        if (wp->fds[0] >= 0)
+            (void)close (wp->fds[0]);
+        if (wp->fds[1] >= 0)
+            (void)close (wp->fds[1]);
+        pthread_cond_destroy (&wp->cond);
+        pthread_mutex_destroy (&wp->lock);
+        free (wp->threads);
+        free (wp);
+        errno = saved_errno;
+    }
+}
+
+struct content_workpool *content_workpool_create (flux_reactor_t *r,
+                                                  int nthreads)
+{
+    struct content_workpool *wp;
+    int i;
+    int e;
+
+    if (!r || nthreads < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(wp = calloc (1, sizeof (*wp))))
+        return NULL;
+    pthread_mutex_init (&wp->lock, NULL);
+    pthread_cond_init (&wp->cond, NULL);
+    wp->fds[0] = wp->fds[1] = -1;
+    if (pipe2 (wp->fds, O_CLOEXEC | O_NONBLOCK) < 0)
+        goto error;
+    if (!(wp->w = flux_fd_watcher_create (r,
+                                          wp->fds[0],
+                                          FLUX_POLLIN,
+                                          workpool_cb,
+                                          wp)))
+        goto error;
+    flux_watcher_start (wp->w);
+    if (!(wp->threads = calloc (nthreads, sizeof (wp->threads[0]))))
+        goto error;
+    for (i = 0; i < nthreads; i++) {
+        if ((e = pthread_create (&wp->threads[i], NULL, worker, wp))) {
+            errno = e;
+            goto error;
+        }
+        wp->nthreads++;
+    }
+    return wp;
+error:
+    content_workpool_destroy (wp);
+    return NULL;
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
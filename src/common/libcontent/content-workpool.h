@@ -0,0 +1,50 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Small pool of worker threads for CPU-bound work such as compression,
+ * so that backing stores can keep it off the reactor thread.
+ *
+ * The 'work' function of a work item is called in a worker thread and
+ * must not use the flux_t handle.  The 'done' function is then called
+ * from the reactor, in the order that work completes.
+ */
+
+#ifndef _FLUX_CONTENT_WORKPOOL_H
+#define _FLUX_CONTENT_WORKPOOL_H
+
+#include <flux/core.h>
+
+typedef void (*content_work_f)(void *arg);
+
+struct content_workpool *content_workpool_create (flux_reactor_t *r,
+                                                  int nthreads);
+
+/* Wait for queued work to complete, call pending 'done' functions,
+ * and free the pool.
+ */
+void content_workpool_destroy (struct content_workpool *wp);
+
+int content_workpool_submit (struct content_workpool *wp,
+                             content_work_f work,
+                             content_work_f done,
+                             void *arg);
+
+/* Return the number of work items that have been submitted but whose
+ * 'done' function has not yet been called.
+ */
+int content_workpool_pending (struct content_workpool *wp);
+
+int content_workpool_nthreads (struct content_workpool *wp);
+
+#endif /* !_FLUX_CONTENT_WORKPOOL_H */
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
@@ -13,7 +13,10 @@
 #endif
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
+#include <limits.h>
+#include <arpa/inet.h>
 #include <flux/core.h>
 
 #include "content.h"
@@ -118,6 +121,287 @@ int content_store_get_blobref (flux_future_t *f, const char **blobref)
     return 0;
 }
 
+int content_batch_encode_blob (void *dst, const void *data, int len)
+{
+    uint32_t nlen = htonl (len);
+
+    memcpy (dst, &nlen, sizeof (nlen));
+    if (len > 0)
+        memcpy ((char *)dst + sizeof (nlen), data, len);
+    return sizeof (nlen) + len;
+}
+
+int content_batch_decode_blob (const void **cursor,
+                               int *remaining,
+                               const void **data,
+                               int *len)
+{
+    uint32_t nlen;
+    uint32_t n;
+
+    if (*remaining < sizeof (nlen))
+        goto eproto;
+    memcpy (&nlen, *cursor, sizeof (nlen));
+    n = ntohl (nlen);
+    if (n > *remaining - sizeof (nlen))
+        goto eproto;
+    *data = (const char *)*cursor + sizeof (nlen);
+    *len = n;
+    *cursor = (const char *)*cursor + sizeof (nlen) + n;
+    *remaining -= sizeof (nlen) + n;
+    return 0;
+eproto:
+    errno = EPROTO;
+    return -1;
+}
+
+int content_batch_encode_result (void *dst,
+                                 int errnum,
+                                 int flags,
+                                 const void *data,
+                                 int len)
+{
+    uint32_t hdr[2] = { htonl (errnum), htonl (flags) };
+
+    memcpy (dst, hdr, sizeof (hdr));
+    if (errnum != 0)
+        len = 0;
+    return sizeof (hdr)
+        + content_batch_encode_blob ((char *)dst + sizeof (hdr), data, len);
+}
+
+int content_batch_decode_result (const void **cursor,
+                                 int *remaining,
+                                 int *errnum,
+                                 int *flags,
+                                 const void **data,
+                                 int *len)
+{
+    uint32_t hdr[2];
+    const void *p;
+    int n;
+
+    if (*remaining < sizeof (hdr)) {
+        errno = EPROTO;
+        return -1;
+    }
+    memcpy (hdr, *cursor, sizeof (hdr));
+    p = (const char *)*cursor + sizeof (hdr);
+    n = *remaining - sizeof (hdr);
+    if (content_batch_decode_blob (&p, &n, data, len) < 0)
+        return -1;
+    *errnum = ntohl (hdr[0]);
+    *flags = ntohl (hdr[1]);
+    *cursor = p;
+    *remaining = n;
+    return 0;
+}
+
+/* The number of blobs in a batch request is stashed in the future
+ * so the response can be indexed.
+ */
+static int batch_count_set (flux_future_t *f, int count)
+{
+    int *cpy;
+
+    if (!(cpy = malloc (sizeof (*cpy))))
+        return -1;
+    *cpy = count;
+    if (flux_future_aux_set (f, "flux::batch_count", cpy, free) < 0) {
+        ERRNO_SAFE_WRAP (free, cpy);
+        return -1;
+    }
+    return 0;
+}
+
+static int batch_count_get (flux_future_t *f)
+{
+    int *count = flux_future_aux_get (f, "flux::batch_count");
+    return count ? *count : -1;
+}
+
+flux_future_t *content_load_batch (flux_t *h,
+                                   const void *hashes,
+                                   int hash_size,
+                                   int count,
+                                   int flags)
+{
+    const char *topic = "content.load-batch";
+    uint32_t rank = FLUX_NODEID_ANY;
+    flux_future_t *f;
+
+    if (!h || !hashes || hash_size <= 0 || count <= 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((flags & CONTENT_FLAG_UPSTREAM))
+        rank = FLUX_NODEID_UPSTREAM;
+    if ((flags & CONTENT_FLAG_CACHE_BYPASS)) {
+        topic = "content-backing.load-batch";
+        rank = 0;
+    }
+    if (!(f = flux_rpc_raw (h, topic, hashes, hash_size * count, rank, 0)))
+        return NULL;
+    if (batch_count_set (f, count) < 0) {
+        flux_future_destroy (f);
+        return NULL;
+    }
+    return f;
+}
+
+struct batch_result {
+    int errnum;
+    int flags;
+    const void *data;
+    int len;
+};
+
+/* Decode the load-batch response once and cache the result array in 'f'.
+ */
+static struct batch_result *load_batch_results (flux_future_t *f)
+{
+    const char *auxkey = "flux::batch_results";
+    struct batch_result *results;
+    const void *cursor;
+    int remaining;
+    int count;
+    int i;
+
+    if ((results = flux_future_aux_get (f, auxkey)))
+        return results;
+    if (flux_rpc_get_raw (f, &cursor, &remaining) < 0)
+        return NULL;
+    if ((count = batch_count_get (f)) < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(results = calloc (count, sizeof (*results))))
+        return NULL;
+    for (i = 0; i < count; i++) {
+        if (content_batch_decode_result (&cursor,
+                                         &remaining,
+                                         &results[i].errnum,
+                                         &results[i].flags,
+                                         &results[i].data,
+                                         &results[i].len) < 0)
+            goto error;
+    }
+    if (remaining != 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (flux_future_aux_set (f, auxkey, results, free) < 0)
+        goto error;
+    return results;
+error:
+    ERRNO_SAFE_WRAP (free, results);
+    return NULL;
+}
+
+int content_load_batch_get (flux_future_t *f,
+                            int index,
+                            const void **buf,
+                            int *len,
+                            int *flags)
+{
+    struct batch_result *results;
+
+    if (!f || index < 0 || index >= batch_count_get (f)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(results = load_batch_results (f)))
+        return -1;
+    if (results[index].errnum != 0) {
+        errno = results[index].errnum;
+        return -1;
+    }
+    if (buf)
+        *buf = results[index].data;
+    if (len)
+        *len = results[index].len;
+    if (flags)
+        *flags = results[index].flags;
+    return 0;
+}
+
+flux_future_t *content_store_batch (flux_t *h,
+                                    const void **bufs,
+                                    const int *lens,
+                                    int count,
+                                    int flags)
+{
+    const char *topic = "content.store-batch";
+    uint32_t rank = FLUX_NODEID_ANY;
+    flux_future_t *f = NULL;
+    char *payload = NULL;
+    size_t size = 0;
+    size_t offset = 0;
+    int i;
+
+    if (!h || !bufs || !lens || count <= 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((flags & CONTENT_FLAG_UPSTREAM))
+        rank = FLUX_NODEID_UPSTREAM;
+    if ((flags & CONTENT_FLAG_CACHE_BYPASS)) {
+        topic = "content-backing.store-batch";
+        rank = 0;
+    }
+    for (i = 0; i < count; i++) {
+        if (lens[i] < 0) {
+            errno = EINVAL;
+            return NULL;
+        }
+        size += CONTENT_BATCH_BLOB_OVERHEAD + lens[i];
+    }
+    if (size > INT_MAX) {
+        errno = EOVERFLOW;
+        return NULL;
+    }
+    if (!(payload = malloc (size)))
+        return NULL;
+    for (i = 0; i < count; i++)
+        offset += content_batch_encode_blob (payload + offset, bufs[i], lens[i]);
+    if (!(f = flux_rpc_raw (h, topic, payload, size, rank, 0))
+        || batch_count_set (f, count) < 0)
+        goto error;
+    free (payload);
+    return f;
+error:
+    ERRNO_SAFE_WRAP (free, payload);
+    flux_future_destroy (f);
+    return NULL;
+}
+
+int content_store_batch_get_hash (flux_future_t *f,
+                                  int index,
+                                  const void **hash,
+                                  int *hash_size)
+{
+    const void *buf;
+    int buf_size;
+    int count;
+
+    if (!f || (count = batch_count_get (f)) < 0
+        || index < 0 || index >= count) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flux_rpc_get_raw (f, &buf, &buf_size) < 0)
+        return -1;
+    if (buf_size == 0 || buf_size % count != 0) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (hash)
+        *hash = (const char *)buf + index * (buf_size / count);
+    if (hash_size)
+        *hash_size = buf_size / count;
+    return 0;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -45,6 +45,86 @@ flux_future_t *content_store (flux_t *h, const void *buf, int len, int flags);
 int content_store_get_hash (flux_future_t *f, const void **hash, int *hash_len);
 int content_store_get_blobref (flux_future_t *f, const char **blobref);
 
+/* Send request to load 'count' blobs by hash.  'hashes' is an array of
+ * 'count' digests, each 'hash_size' bytes long.
+ */
+flux_future_t *content_load_batch (flux_t *h,
+                                   const void *hashes,
+                                   int hash_size,
+                                   int count,
+                                   int flags);
+
+/* Get result of load batch request for blob at 'index'.
+ * Blobs that could not be loaded (e.g. ENOENT) fail individually
+ * without failing the batch:  -1 is returned with errno set.
+ * If non-NULL, 'flags' is set to the CONTENT_BATCH_FLAG values of the blob.
+ * Storage for 'buf' belongs to 'f' and is valid until 'f' is destroyed.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int content_load_batch_get (flux_future_t *f,
+                            int index,
+                            const void **buf,
+                            int *len,
+                            int *flags);
+
+/* Send request to store 'count' blobs.  The batch is stored all-or-nothing.
+ */
+flux_future_t *content_store_batch (flux_t *h,
+                                    const void **bufs,
+                                    const int *lens,
+                                    int count,
+                                    int flags);
+
+/* Get result of store batch request (hash of blob at 'index').
+ * Storage belongs to 'f' and is valid until 'f' is destroyed.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int content_store_batch_get_hash (flux_future_t *f,
+                                  int index,
+                                  const void **hash,
+                                  int *hash_len);
+
+/* Batch payload encoding, for use by content service providers.
+ *
+ * A load-batch request consists of concatenated hash digests.  The response
+ * consists of one result per digest, in order:  a 4 byte errno, 4 bytes of
+ * CONTENT_BATCH_FLAG values, and a 4 byte blob length, all in network byte
+ * order, followed by the blob data.
+ *
+ * A store-batch request consists of one record per blob:  a 4 byte blob
+ * length in network byte order followed by the blob data.  The response
+ * consists of concatenated hash digests, in order.
+ *
+ * The encode functions write to 'dst', which must have room for the data
+ * plus the overhead, and return the number of bytes written.  The decode
+ * functions consume one record from (*cursor, *remaining), returning 0 on
+ * success or -1 with errno=EPROTO if the payload is truncated.
+ */
+#define CONTENT_BATCH_BLOB_OVERHEAD     4
+#define CONTENT_BATCH_RESULT_OVERHEAD   12
+
+enum {
+    CONTENT_BATCH_FLAG_EPHEMERAL = 1, /* blob is not on the backing store */
+};
+
+int content_batch_encode_blob (void *dst, const void *data, int len);
+int content_batch_decode_blob (const void **cursor,
+                               int *remaining,
+                               const void **data,
+                               int *len);
+
+int content_batch_encode_result (void *dst,
+                                 int errnum,
+                                 int flags,
+                                 const void *data,
+                                 int len);
+int content_batch_decode_result (const void **cursor,
+                                 int *remaining,
+                                 int *errnum,
+                                 int *flags,
+                                 const void **data,
+                                 int *len);
+
 #endif /* !_FLUX_CONTENT_H */
 
 /*
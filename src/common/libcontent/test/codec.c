@@ -0,0 +1,141 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libcontent/content-codec.h"
+
+static char *make_blob (int size)
+{
+    char *buf;
+    int i;
+
+    if (!(buf = malloc (size)))
+        BAIL_OUT ("out of memory");
+    for (i = 0; i < size; i++)
+        buf[i] = "abcdefgh"[(i / 7) % 8];
+    return buf;
+}
+
+static void roundtrip (const char *name, int size)
+{
+    int codec = content_codec_lookup (name);
+    char *blob = make_blob (size);
+    int bound;
+    char *zbuf;
+    char *buf;
+    int zsize;
+
+    bound = content_codec_bound (codec, size);
+    ok (bound >= size || (codec != CONTENT_CODEC_NONE && bound > 0),
+        "%s: content_codec_bound size=%d works", name, size);
+    if (!(zbuf = malloc (bound)) || !(buf = malloc (size + 1)))
+        BAIL_OUT ("out of memory");
+    zsize = content_codec_compress (codec, blob, size, zbuf, bound);
+    ok (zsize >= 0,
+        "%s: content_codec_compress size=%d works", name, size);
+    if (codec != CONTENT_CODEC_NONE && size > 1024)
+        ok (zsize < size,
+            "%s: compressed size %d < %d", name, zsize, size);
+    ok (content_codec_decompress (codec, zbuf, zsize, buf, size) == size
+        && memcmp (buf, blob, size) == 0,
+        "%s: content_codec_decompress restores the original", name);
+    if (codec != CONTENT_CODEC_NONE) {
+        errno = 0;
+        ok (content_codec_decompress (codec, zbuf, zsize, buf, size + 1) < 0
+            && errno == EINVAL,
+            "%s: content_codec_decompress with wrong size fails", name);
+    }
+    free (buf);
+    free (zbuf);
+    free (blob);
+}
+
+static void test_lookup (void)
+{
+    ok (content_codec_lookup ("none") == CONTENT_CODEC_NONE,
+        "content_codec_lookup none works");
+    ok (content_codec_lookup ("lz4") == CONTENT_CODEC_LZ4,
+        "content_codec_lookup lz4 works");
+#if HAVE_ZSTD
+    ok (content_codec_lookup ("zstd") == CONTENT_CODEC_ZSTD,
+        "content_codec_lookup zstd works");
+#else
+    errno = 0;
+    ok (content_codec_lookup ("zstd") < 0 && errno == ENOTSUP,
+        "content_codec_lookup zstd fails with ENOTSUP");
+#endif
+    errno = 0;
+    ok (content_codec_lookup ("lzo") < 0 && errno == EINVAL,
+        "content_codec_lookup unknown fails with EINVAL");
+    errno = 0;
+    ok (content_codec_lookup (NULL) < 0 && errno == EINVAL,
+        "content_codec_lookup NULL fails with EINVAL");
+    ok (content_codec_name (CONTENT_CODEC_LZ4)
+        && !strcmp (content_codec_name (CONTENT_CODEC_LZ4), "lz4"),
+        "content_codec_name lz4 works");
+    ok (content_codec_name (42) == NULL,
+        "content_codec_name unknown returns NULL");
+}
+
+static void test_header (void)
+{
+    char buf[CONTENT_CODEC_HEADER_SIZE];
+    int codec;
+    int size;
+
+    content_codec_header_encode (buf, CONTENT_CODEC_LZ4, 1024*1024);
+    ok (content_codec_header_check (buf, sizeof (buf)),
+        "content_codec_header_check finds magic");
+    ok (content_codec_header_decode (buf, sizeof (buf), &codec, &size) == 0
+        && codec == CONTENT_CODEC_LZ4
+        && size == 1024*1024,
+        "content_codec_header_decode works");
+    errno = 0;
+    ok (content_codec_header_decode (buf, sizeof (buf) - 1, NULL, NULL) < 0
+        && errno == EINVAL,
+        "content_codec_header_decode short buffer fails with EINVAL");
+    ok (!content_codec_header_check ("hello world", 11),
+        "content_codec_header_check rejects plain data");
+    errno = 0;
+    ok (content_codec_header_decode ("hello world!", 12, NULL, NULL) < 0
+        && errno == EINVAL,
+        "content_codec_header_decode plain data fails with EINVAL");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_lookup ();
+    test_header ();
+    roundtrip ("none", 0);
+    roundtrip ("none", 4096);
+    roundtrip ("lz4", 1);
+    roundtrip ("lz4", 1024*1024);
+#if HAVE_ZSTD
+    roundtrip ("zstd", 1);
+    roundtrip ("zstd", 1024*1024);
+#endif
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,387 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libkvs/treeobj.h"
+#include "src/common/libcontent/content-gc.h"
+
+#define MAXOBJ 64
+
+/* A tiny content store.
+ */
+struct object {
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    char hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_size;
+    char *data;
+};
+
+static struct object store[MAXOBJ];
+static int store_count;
+static int load_count;
+
+static struct object *store_blob (const char *data)
+{
+    struct object *obj = &store[store_count++];
+
+    if (blobref_hash ("sha1",
+                      data,
+                      strlen (data),
+                      obj->ref,
+                      sizeof (obj->ref)) < 0
+        || (obj->hash_size = blobref_strtohash (obj->ref,
+                                                obj->hash,
+                                                sizeof (obj->hash))) < 0
+        || !(obj->data = strdup (data)))
+        BAIL_OUT ("error storing blob");
+    return obj;
+}
+
+static struct object *store_treeobj (json_t *o)
+{
+    struct object *obj;
+    char *s;
+
+    if (!(s = treeobj_encode (o)))
+        BAIL_OUT ("treeobj_encode failed");
+    obj = store_blob (s);
+    free (s);
+    json_decref (o);
+    return obj;
+}
+
+static void store_clear (void)
+{
+    int i;
+    for (i = 0; i < store_count; i++)
+        free (store[i].data);
+    store_count = 0;
+}
+
+static int load (const void *hash,
+                 int hash_size,
+                 void **datap,
+                 int *sizep,
+                 void *arg)
+{
+    int i;
+
+    for (i = 0; i < store_count; i++) {
+        if (!memcmp (store[i].hash, hash, hash_size)) {
+            load_count++;
+            *datap = strdup (store[i].data);
+            *sizep = strlen (store[i].data);
+            return 0;
+        }
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+static json_t *checkpoints (void *arg)
+{
+    return json_array ();
+}
+
+static int sweep (struct content_gc *gc, int max, void *arg)
+{
+    return 0;
+}
+
+static const struct content_gc_ops ops = {
+    .load = load,
+    .checkpoints = checkpoints,
+    .sweep = sweep,
+};
+
+/* Insert 'o' into 'dir', stealing the reference.
+ */
+static void insert (json_t *dir, const char *name, json_t *o)
+{
+    if (treeobj_insert_entry (dir, name, o) < 0)
+        BAIL_OUT ("treeobj_insert_entry failed");
+    json_decref (o);
+}
+
+static bool is_live (struct content_gc *gc, struct object *obj)
+{
+    return content_gc_is_live (gc, obj->hash, obj->hash_size);
+}
+
+static json_t *dirref (struct object *obj)
+{
+    return treeobj_create_dirref (obj->ref);
+}
+
+static json_t *valref (struct object *obj)
+{
+    return treeobj_create_valref (obj->ref);
+}
+
+static void mark_all (struct content_gc *gc)
+{
+    int n;
+    while ((n = content_gc_mark_step (gc, 4)) > 0)
+        ;
+    ok (n == 0,
+        "content_gc_mark_step ran until nothing was queued");
+}
+
+void test_badargs (void)
+{
+    struct content_gc_ops noops = { 0 };
+
+    errno = 0;
+    ok (content_gc_create (NULL, "sha1", &noops, NULL) == NULL
+        && errno == EINVAL,
+        "content_gc_create with missing ops fails with EINVAL");
+    errno = 0;
+    ok (content_gc_create (NULL, "nosuchhash", &ops, NULL) == NULL,
+        "content_gc_create with unknown hash function fails");
+    errno = 0;
+    ok (content_gc_mark_step (NULL, 1) < 0 && errno == EINVAL,
+        "content_gc_mark_step gc=NULL fails with EINVAL");
+    ok (content_gc_is_live (NULL, "x", 1) == true,
+        "content_gc_is_live gc=NULL returns true");
+    lives_ok ({content_gc_mark (NULL, "x", 1, NULL, 0);},
+        "content_gc_mark gc=NULL doesn't crash");
+    lives_ok ({content_gc_destroy (NULL);},
+        "content_gc_destroy gc=NULL doesn't crash");
+}
+
+void test_mark (void)
+{
+    struct content_gc *gc;
+    struct object *v1, *v2, *v3, *v4, *d1, *d2, *g1, *root;
+    json_t *o, *hamt;
+
+    v1 = store_blob ("value-1");
+    v2 = store_blob ("value-2");
+    v3 = store_blob ("value-3");
+    v4 = store_blob ("value-4");
+
+    o = treeobj_create_dir ();
+    insert (o, "x", valref (v2));
+    treeobj_append_blobref (treeobj_get_entry (o, "x"), v3->ref);
+    d2 = store_treeobj (o);
+
+    hamt = treeobj_create_hamt ();
+    o = dirref (d2);
+    treeobj_insert_shard (hamt, 3, o);
+    json_decref (o);
+    o = treeobj_create_dir ();
+    insert (o, "c", treeobj_create_val ("inline", 6));
+    insert (o, "h", hamt);
+    d1 = store_treeobj (o);
+
+    o = treeobj_create_dir ();
+    insert (o, "a", valref (v1));
+    insert (o, "b", dirref (d1));
+    root = store_treeobj (o);
+
+    o = treeobj_create_dir ();
+    insert (o, "y", valref (v4));
+    g1 = store_treeobj (o);
+
+    gc = content_gc_create (NULL, "sha1", &ops, NULL);
+    ok (gc != NULL,
+        "content_gc_create h=NULL works");
+    ok (content_gc_active (gc) == false,
+        "content_gc_active returns false");
+    ok (is_live (gc, g1) == true,
+        "content_gc_is_live returns true when not marking");
+    errno = 0;
+    ok (content_gc_add_root (gc, root->hash, root->hash_size, false) < 0
+        && errno == EINVAL,
+        "content_gc_add_root fails with EINVAL before content_gc_mark_begin");
+
+    ok (content_gc_mark_begin (gc) == 0,
+        "content_gc_mark_begin works");
+    errno = 0;
+    ok (content_gc_add_root (gc, root->hash, 3, false) < 0 && errno == EINVAL,
+        "content_gc_add_root with wrong hash size fails with EINVAL");
+    ok (content_gc_add_root (gc, root->hash, root->hash_size, false) == 0,
+        "content_gc_add_root works");
+    load_count = 0;
+    mark_all (gc);
+    ok (is_live (gc, root) && is_live (gc, d1) && is_live (gc, d2),
+        "directories reachable from root through dirrefs and hamt are live");
+    ok (is_live (gc, v1) && is_live (gc, v2) && is_live (gc, v3),
+        "valref targets are live");
+    ok (!is_live (gc, g1) && !is_live (gc, v4),
+        "unreachable objects are not live");
+    ok (load_count == 3,
+        "only the three directories were loaded");
+
+    content_gc_mark (gc, g1->hash, g1->hash_size, NULL, 0);
+    mark_all (gc);
+    ok (is_live (gc, g1) && is_live (gc, v4),
+        "content_gc_mark marks an object and what it references");
+
+    ok (content_gc_mark_begin (gc) == 0,
+        "content_gc_mark_begin starts over");
+    ok (!is_live (gc, root),
+        "previous marks are forgotten");
+    content_gc_mark (gc, g1->hash, g1->hash_size, g1->data, strlen (g1->data));
+    load_count = 0;
+    mark_all (gc);
+    ok (is_live (gc, g1) && is_live (gc, v4) && load_count == 0,
+        "content_gc_mark with data marks references without loading");
+    ok (content_gc_add_root (gc, v1->hash, v1->hash_size, false) == 0,
+        "content_gc_add_root a value that is not a treeobj works");
+    mark_all (gc);
+    ok (is_live (gc, v1),
+        "and it is live");
+
+    content_gc_destroy (gc);
+    store_clear ();
+}
+
+void test_missing (void)
+{
+    struct content_gc *gc;
+    struct object *root;
+    json_t *o;
+    json_t *stats;
+    int missing = -1;
+    int marked = -1;
+
+    o = treeobj_create_dir ();
+    insert (o,
+            "gone",
+            treeobj_create_dirref ("sha1-0123456789012345678901234567890123456789"));
+    root = store_treeobj (o);
+
+    if (!(gc = content_gc_create (NULL, "sha1", &ops, NULL)))
+        BAIL_OUT ("content_gc_create failed");
+    ok (content_gc_mark_begin (gc) == 0
+        && content_gc_add_root (gc, root->hash, root->hash_size, false) == 0,
+        "marking from a root with a dangling dirref");
+    mark_all (gc);
+    ok ((stats = content_gc_stats (gc)) != NULL,
+        "content_gc_stats works");
+    ok (json_unpack (stats,
+                     "{s:{s:i s:i}}",
+                     "cycle",
+                       "missing", &missing,
+                       "marked", &marked) == 0
+        && missing == 1 && marked == 2,
+        "missing object was counted and marking continued");
+    json_decref (stats);
+    content_gc_destroy (gc);
+    store_clear ();
+}
+
+void test_stored (void)
+{
+    struct content_gc *gc;
+    struct object *v1, *v2, *d;
+    json_t *dir;
+    json_t *stats;
+    int stored = -1;
+    int roots = -1;
+
+    v1 = store_blob ("v1");
+    v2 = store_blob ("v2");
+    if (!(dir = treeobj_create_dir ()))
+        BAIL_OUT ("treeobj_create_dir failed");
+    insert (dir, "a", valref (v1));
+    d = store_treeobj (dir);
+
+    if (!(gc = content_gc_create (NULL, "sha1", &ops, NULL)))
+        BAIL_OUT ("content_gc_create failed");
+    errno = 0;
+    ok (content_gc_add_stored (gc, d->hash, d->hash_size) < 0
+        && errno == EINVAL,
+        "content_gc_add_stored fails with EINVAL when not marking");
+
+    ok (content_gc_mark_begin (gc) == 0,
+        "content_gc_mark_begin works");
+    ok (content_gc_add_stored (gc, d->hash, d->hash_size) == 0,
+        "content_gc_add_stored works");
+    mark_all (gc);
+    ok (is_live (gc, d) && is_live (gc, v1) && !is_live (gc, v2),
+        "a stored object and the objects it references are live");
+    ok ((stats = content_gc_stats (gc)) != NULL
+        && json_unpack (stats,
+                        "{s:{s:i s:i}}",
+                        "cycle",
+                          "stored", &stored,
+                          "roots", &roots) == 0
+        && stored == 1 && roots == 1,
+        "the stored object is counted as a root");
+    json_decref (stats);
+
+    content_gc_destroy (gc);
+    store_clear ();
+}
+
+void test_many (void)
+{
+    struct content_gc *gc;
+    char hash[BLOBREF_MAX_DIGEST_SIZE];
+    int i;
+    int errors = 0;
+
+    if (!(gc = content_gc_create (NULL, "sha1", &ops, NULL))
+        || content_gc_mark_begin (gc) < 0)
+        BAIL_OUT ("error creating collector");
+    for (i = 0; i < 100000; i++) {
+        memset (hash, 0, sizeof (hash));
+        memcpy (hash, &i, sizeof (i));
+        memcpy (hash + 12, &i, sizeof (i));
+        if (content_gc_add_root (gc, hash, 20, true) < 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "marked 100000 leaf roots");
+    for (i = 0; i < 100000; i++) {
+        memset (hash, 0, sizeof (hash));
+        memcpy (hash, &i, sizeof (i));
+        memcpy (hash + 12, &i, sizeof (i));
+        if (!content_gc_is_live (gc, hash, 20))
+            errors++;
+    }
+    i = 100000;
+    memset (hash, 0, sizeof (hash));
+    memcpy (hash, &i, sizeof (i));
+    memcpy (hash + 12, &i, sizeof (i));
+    ok (errors == 0 && !content_gc_is_live (gc, hash, 20),
+        "all are live after the live set has grown, and no others");
+    content_gc_destroy (gc);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_badargs ();
+    test_mark ();
+    test_missing ();
+    test_stored ();
+    test_many ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
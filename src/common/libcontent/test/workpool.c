@@ -0,0 +1,159 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <pthread.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libcontent/content-workpool.h"
+
+#define NITEMS 100
+
+struct item {
+    int id;
+    pthread_t thread;
+    int result;
+    int *done_count;
+};
+
+static pthread_t reactor_thread;
+static bool done_in_reactor_thread = true;
+
+static void work_cb (void *arg)
+{
+    struct item *item = arg;
+    item->thread = pthread_self ();
+    item->result = item->id * 2;
+}
+
+static void done_cb (void *arg)
+{
+    struct item *item = arg;
+    if (!pthread_equal (pthread_self (), reactor_thread))
+        done_in_reactor_thread = false;
+    (*item->done_count)++;
+}
+
+static void test_basic (flux_reactor_t *r)
+{
+    struct content_workpool *wp;
+    struct item items[NITEMS];
+    int done_count = 0;
+    int errors = 0;
+    int offthread = 0;
+    int i;
+
+    reactor_thread = pthread_self ();
+    wp = content_workpool_create (r, 4);
+    ok (wp != NULL,
+        "content_workpool_create nthreads=4 works");
+    ok (content_workpool_nthreads (wp) == 4,
+        "content_workpool_nthreads returns 4");
+    for (i = 0; i < NITEMS; i++) {
+        items[i].id = i;
+        items[i].result = -1;
+        items[i].done_count = &done_count;
+        if (content_workpool_submit (wp, work_cb, done_cb, &items[i]) < 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "content_workpool_submit works for %d items", NITEMS);
+    ok (content_workpool_pending (wp) == NITEMS,
+        "content_workpool_pending returns %d", NITEMS);
+    while (done_count < NITEMS) {
+        if (flux_reactor_run (r, FLUX_REACTOR_ONCE) < 0)
+            BAIL_OUT ("flux_reactor_run failed");
+    }
+    ok (content_workpool_pending (wp) == 0,
+        "all done callbacks were called");
+    for (i = 0; i < NITEMS; i++) {
+        if (items[i].result != i * 2)
+            errors++;
+        if (!pthread_equal (items[i].thread, reactor_thread))
+            offthread++;
+    }
+    ok (errors == 0,
+        "all work functions ran");
+    ok (offthread == NITEMS,
+        "work functions ran in worker threads");
+    ok (done_in_reactor_thread,
+        "done functions ran in the reactor thread");
+    content_workpool_destroy (wp);
+}
+
+static void test_destroy_pending (flux_reactor_t *r)
+{
+    struct content_workpool *wp;
+    struct item items[NITEMS];
+    int done_count = 0;
+    int i;
+
+    if (!(wp = content_workpool_create (r, 2)))
+        BAIL_OUT ("content_workpool_create failed");
+    for (i = 0; i < NITEMS; i++) {
+        items[i].id = i;
+        items[i].done_count = &done_count;
+        if (content_workpool_submit (wp, work_cb, done_cb, &items[i]) < 0)
+            BAIL_OUT ("content_workpool_submit failed");
+    }
+    content_workpool_destroy (wp);
+    ok (done_count == NITEMS,
+        "content_workpool_destroy completes pending work");
+}
+
+static void test_inval (flux_reactor_t *r)
+{
+    struct content_workpool *wp;
+
+    errno = 0;
+    ok (content_workpool_create (NULL, 1) == NULL && errno == EINVAL,
+        "content_workpool_create r=NULL fails with EINVAL");
+    errno = 0;
+    ok (content_workpool_create (r, 0) == NULL && errno == EINVAL,
+        "content_workpool_create nthreads=0 fails with EINVAL");
+    if (!(wp = content_workpool_create (r, 1)))
+        BAIL_OUT ("content_workpool_create failed");
+    errno = 0;
+    ok (content_workpool_submit (wp, NULL, NULL, NULL) < 0 && errno == EINVAL,
+        "content_workpool_submit work=NULL fails with EINVAL");
+    errno = 0;
+    ok (content_workpool_submit (NULL, work_cb, NULL, NULL) < 0
+        && errno == EINVAL,
+        "content_workpool_submit wp=NULL fails with EINVAL");
+    content_workpool_destroy (wp);
+    lives_ok ({content_workpool_destroy (NULL);},
+        "content_workpool_destroy NULL doesn't crash");
+}
+
+int main (int argc, char *argv[])
+{
+    flux_reactor_t *r;
+
+    plan (NO_PLAN);
+
+    if (!(r = flux_reactor_create (0)))
+        BAIL_OUT ("flux_reactor_create failed");
+
+    test_basic (r);
+    test_destroy_pending (r);
+    test_inval (r);
+
+    flux_reactor_destroy (r);
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,351 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* eventlog_index.c - incrementally index an RFC 18 eventlog
+ *
+ * Complete entries are stored contiguously in 'buf', which is kept NUL
+ * terminated so that any suffix of it is a valid eventlog.  A trailing
+ * partial entry is held in 'partial' until its newline arrives.
+ * 'entries' records the offset and length of each complete entry in
+ * 'buf', plus the decoded entry once it has been accessed.
+ *
+ * eventlog_index_trim() discards leading entries.  Sequence numbers
+ * stay absolute: entries[0] is entry 'first'.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "eventlog.h"
+#include "eventlog_index.h"
+
+struct entry {
+    size_t offset;
+    size_t len;
+    json_t *o;
+};
+
+struct eventlog_index {
+    char *buf;
+    size_t buf_len;
+    size_t buf_size;
+
+    char *partial;
+    size_t partial_len;
+
+    struct entry *entries;
+    int count;
+    int size;
+    int first;
+};
+
+static const size_t buf_initial_size = 256;
+
+void eventlog_index_destroy (struct eventlog_index *idx)
+{
+    if (idx) {
+        int saved_errno = errno;
+        int i;
+
+        for (i = 0; i < idx->count; i++)
+            json_decref (idx->entries[i].o);
+        free (idx->entries);
+        free (idx->partial);
+        free (idx->buf);
+        free (idx);
+        errno = saved_errno;
+    }
+}
+
+struct eventlog_index *eventlog_index_create (void)
+{
+    struct eventlog_index *idx;
+
+    if (!(idx = calloc (1, sizeof (*idx))))
+        return NULL;
+    idx->buf_size = buf_initial_size;
+    if (!(idx->buf = malloc (idx->buf_size))) {
+        eventlog_index_destroy (idx);
+        return NULL;
+    }
+    idx->buf[0] = '\0';
+    return idx;
+}
+
+static int buf_reserve (struct eventlog_index *idx, size_t len)
+{
+    size_t size = idx->buf_size;
+    char *buf;
+
+    while (size < idx->buf_len + len + 1)
+        size *= 2;
+    if (size > idx->buf_size) {
+        if (!(buf = realloc (idx->buf, size)))
+            return -1;
+        idx->buf = buf;
+        idx->buf_size = size;
+    }
+    return 0;
+}
+
+static int entries_reserve (struct eventlog_index *idx, int count)
+{
+    int size = idx->size ? idx->size : 16;
+    struct entry *entries;
+
+    while (size < idx->count + count)
+        size *= 2;
+    if (size > idx->size) {
+        if (!(entries = realloc (idx->entries, size * sizeof (*entries))))
+            return -1;
+        idx->entries = entries;
+        idx->size = size;
+    }
+    return 0;
+}
+
+static int set_partial (struct eventlog_index *idx, const char *s, size_t len)
+{
+    char *partial = NULL;
+
+    if (len > 0) {
+        if (!(partial = malloc (len)))
+            return -1;
+        memcpy (partial, s, len);
+    }
+    free (idx->partial);
+    idx->partial = partial;
+    idx->partial_len = len;
+    return 0;
+}
+
+static const char *last_newline (const char *s, size_t len)
+{
+    while (len > 0) {
+        if (s[--len] == '\n')
+            return s + len;
+    }
+    return NULL;
+}
+
+static int count_newlines (const char *s, size_t len)
+{
+    const char *p = s;
+    const char *end = s + len;
+    int count = 0;
+
+    while ((p = memchr (p, '\n', end - p))) {
+        count++;
+        p++;
+    }
+    return count;
+}
+
+int eventlog_index_append (struct eventlog_index *idx,
+                           const char *s,
+                           size_t len)
+{
+    const char *last;
+    size_t complete;
+    size_t offset;
+    int count;
+
+    if (!idx || (!s && len > 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(last = last_newline (s, len))) {
+        char *partial;
+
+        if (len == 0)
+            return 0;
+        if (!(partial = realloc (idx->partial, idx->partial_len + len)))
+            return -1;
+        memcpy (partial + idx->partial_len, s, len);
+        idx->partial = partial;
+        idx->partial_len += len;
+        return 0;
+    }
+    complete = last - s + 1;
+    count = count_newlines (s, complete);
+    if (buf_reserve (idx, idx->partial_len + complete) < 0
+        || entries_reserve (idx, count) < 0)
+        return -1;
+
+    offset = idx->buf_len;
+    if (idx->partial_len > 0) {
+        memcpy (idx->buf + idx->buf_len, idx->partial, idx->partial_len);
+        idx->buf_len += idx->partial_len;
+    }
+    memcpy (idx->buf + idx->buf_len, s, complete);
+    idx->buf_len += complete;
+    idx->buf[idx->buf_len] = '\0';
+    if (set_partial (idx, last + 1, len - complete) < 0) {
+        idx->buf_len = offset;
+        idx->buf[idx->buf_len] = '\0';
+        return -1;
+    }
+
+    while (offset < idx->buf_len) {
+        char *nl = memchr (idx->buf + offset, '\n', idx->buf_len - offset);
+        struct entry *e = &idx->entries[idx->count++];
+
+        e->offset = offset;
+        e->len = nl - (idx->buf + offset) + 1;
+        e->o = NULL;
+        offset += e->len;
+    }
+    return count;
+}
+
+int eventlog_index_count (struct eventlog_index *idx)
+{
+    return idx ? idx->first + idx->count : 0;
+}
+
+int eventlog_index_first (struct eventlog_index *idx)
+{
+    return idx ? idx->first : 0;
+}
+
+void eventlog_index_trim (struct eventlog_index *idx, int seq)
+{
+    size_t offset;
+    int n;
+    int i;
+
+    if (!idx || seq <= idx->first)
+        return;
+    n = seq - idx->first;
+    if (n > idx->count)
+        n = idx->count;
+    offset = n < idx->count ? idx->entries[n].offset : idx->buf_len;
+
+    for (i = 0; i < n; i++)
+        json_decref (idx->entries[i].o);
+    memmove (idx->entries,
+             idx->entries + n,
+             (idx->count - n) * sizeof (idx->entries[0]));
+    idx->count -= n;
+    idx->first += n;
+    for (i = 0; i < idx->count; i++)
+        idx->entries[i].offset -= offset;
+
+    memmove (idx->buf, idx->buf + offset, idx->buf_len - offset + 1);
+    idx->buf_len -= offset;
+
+    /* Give back a buffer grown by a large append once it is empty.
+     */
+    if (idx->buf_len == 0 && idx->buf_size > buf_initial_size) {
+        char *buf;
+        if ((buf = realloc (idx->buf, buf_initial_size))) {
+            idx->buf = buf;
+            idx->buf_size = buf_initial_size;
+        }
+    }
+}
+
+json_t *eventlog_index_entry (struct eventlog_index *idx, int seq)
+{
+    struct entry *e;
+
+    if (!idx || seq < idx->first || seq >= idx->first + idx->count) {
+        errno = idx ? ENOENT : EINVAL;
+        return NULL;
+    }
+    e = &idx->entries[seq - idx->first];
+    if (!e->o) {
+        json_t *o;
+
+        /* An empty line is not a valid entry, and json_loadb()
+         * would accept the entry's trailing newline as whitespace.
+         */
+        if (e->len < 2
+            || !(o = json_loadb (idx->buf + e->offset,
+                                 e->len - 1,
+                                 JSON_ALLOW_NUL,
+                                 NULL))) {
+            errno = EINVAL;
+            return NULL;
+        }
+        if (eventlog_entry_parse (o, NULL, NULL, NULL) < 0) {
+            json_decref (o);
+            errno = EINVAL;
+            return NULL;
+        }
+        e->o = o;
+    }
+    return e->o;
+}
+
+const char *eventlog_index_entry_text (struct eventlog_index *idx,
+                                       int seq,
+                                       size_t *len)
+{
+    struct entry *e;
+
+    if (!idx || seq < idx->first || seq >= idx->first + idx->count) {
+        errno = idx ? ENOENT : EINVAL;
+        return NULL;
+    }
+    e = &idx->entries[seq - idx->first];
+    if (len)
+        *len = e->len;
+    return idx->buf + e->offset;
+}
+
+const char *eventlog_index_text (struct eventlog_index *idx,
+                                 int seq,
+                                 size_t *len)
+{
+    size_t offset;
+
+    if (!idx || seq < idx->first || seq > idx->first + idx->count) {
+        errno = EINVAL;
+        return NULL;
+    }
+    seq -= idx->first;
+    offset = seq < idx->count ? idx->entries[seq].offset : idx->buf_len;
+    if (len)
+        *len = idx->buf_len - offset;
+    return idx->buf + offset;
+}
+
+int eventlog_index_find (struct eventlog_index *idx,
+                         int seq,
+                         const char *name)
+{
+    if (!idx || seq < 0 || !name) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (seq < idx->first)
+        seq = idx->first;
+    for (; seq < idx->first + idx->count; seq++) {
+        json_t *o;
+        const char *s;
+
+        if ((o = eventlog_index_entry (idx, seq))
+            && eventlog_entry_parse (o, NULL, &s, NULL) == 0
+            && !strcmp (s, name))
+            return seq;
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
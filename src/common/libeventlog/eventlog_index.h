@@ -0,0 +1,96 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _EVENTLOG_INDEX_H
+#define _EVENTLOG_INDEX_H
+
+#include <stddef.h>
+#include <jansson.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* An eventlog_index holds the text of an RFC 18 eventlog as it is
+ * appended (e.g. by a FLUX_KVS_WATCH_APPEND lookup) along with the
+ * offset of each entry, so that entries can be accessed by sequence
+ * number.  Entries are decoded on first access and the decoded object
+ * is cached, so no entry is parsed more than once.
+ */
+struct eventlog_index;
+
+struct eventlog_index *eventlog_index_create (void);
+void eventlog_index_destroy (struct eventlog_index *idx);
+
+/* Append 'len' bytes of eventlog text.  The text need not end on an
+ * entry boundary - a trailing partial entry is held until the rest of
+ * it is appended.  Entries are not validated here.
+ * Returns the number of complete entries added, or -1 on error.
+ */
+int eventlog_index_append (struct eventlog_index *idx,
+                           const char *s,
+                           size_t len);
+
+/* Return the number of complete entries appended so far, including
+ * any discarded by eventlog_index_trim().
+ */
+int eventlog_index_count (struct eventlog_index *idx);
+
+/* Discard entries before 'seq', along with their text and decoded
+ * objects, e.g. once they have been sent to a watcher.  Sequence numbers
+ * of the remaining entries are unchanged.  A trailing partial entry is
+ * kept.  Discarded entries are no longer accessible (ENOENT/EINVAL).
+ */
+void eventlog_index_trim (struct eventlog_index *idx, int seq);
+
+/* Return the sequence number of the first entry not discarded.
+ */
+int eventlog_index_first (struct eventlog_index *idx);
+
+/* Return decoded entry 'seq' (owned by 'idx'), or NULL on error.
+ * Fails with ENOENT if 'seq' is out of range, or EINVAL if the entry
+ * is not a valid RFC 18 eventlog entry.
+ */
+json_t *eventlog_index_entry (struct eventlog_index *idx, int seq);
+
+/* Return the raw text of entry 'seq', including its trailing newline.
+ * The text is not NUL terminated.
+ */
+const char *eventlog_index_entry_text (struct eventlog_index *idx,
+                                       int seq,
+                                       size_t *len);
+
+/* Return the eventlog text starting at entry 'seq' through the last
+ * complete entry.  This is a valid RFC 18 eventlog, and is NUL
+ * terminated.  If 'seq' equals the entry count, an empty string is
+ * returned.  The pointer is invalidated by eventlog_index_append()
+ * and eventlog_index_trim().
+ */
+const char *eventlog_index_text (struct eventlog_index *idx,
+                                 int seq,
+                                 size_t *len);
+
+/* Return the sequence number of the first entry at or after 'seq'
+ * with 'name', or -1 with errno = ENOENT if there is none.  Entries
+ * that cannot be decoded or have been discarded are skipped.
+ */
+int eventlog_index_find (struct eventlog_index *idx,
+                         int seq,
+                         const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !_EVENTLOG_INDEX_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
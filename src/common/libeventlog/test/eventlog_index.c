@@ -0,0 +1,287 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libeventlog/eventlog.h"
+#include "src/common/libeventlog/eventlog_index.h"
+
+#define E1 "{\"timestamp\":42.0,\"name\":\"submit\"}\n"
+#define E2 "{\"timestamp\":43.0,\"name\":\"alloc\",\"context\":{\"a\":1}}\n"
+#define E3 "{\"timestamp\":44.0,\"name\":\"clean\"}\n"
+
+static void check_name (struct eventlog_index *idx, int seq, const char *name)
+{
+    json_t *o;
+    const char *s = NULL;
+
+    o = eventlog_index_entry (idx, seq);
+    ok (o != NULL
+        && eventlog_entry_parse (o, NULL, &s, NULL) == 0
+        && !strcmp (s, name),
+        "eventlog_index_entry %d is %s", seq, name);
+}
+
+static void basic (void)
+{
+    struct eventlog_index *idx;
+    const char *s;
+    size_t len;
+
+    idx = eventlog_index_create ();
+    ok (idx != NULL,
+        "eventlog_index_create works");
+    ok (eventlog_index_count (idx) == 0,
+        "eventlog_index_count is 0 initially");
+    s = eventlog_index_text (idx, 0, &len);
+    ok (s != NULL && len == 0 && !strcmp (s, ""),
+        "eventlog_index_text of empty index is empty");
+
+    ok (eventlog_index_append (idx, E1 E2, strlen (E1 E2)) == 2,
+        "eventlog_index_append of two entries returns 2");
+    ok (eventlog_index_count (idx) == 2,
+        "eventlog_index_count is 2");
+    check_name (idx, 0, "submit");
+    check_name (idx, 1, "alloc");
+    ok (eventlog_index_entry (idx, 1) == eventlog_index_entry (idx, 1),
+        "eventlog_index_entry returns the cached entry");
+
+    s = eventlog_index_entry_text (idx, 1, &len);
+    ok (s != NULL && len == strlen (E2) && !strncmp (s, E2, len),
+        "eventlog_index_entry_text returns the raw entry");
+    s = eventlog_index_text (idx, 0, &len);
+    ok (s != NULL && len == strlen (E1 E2) && !strcmp (s, E1 E2),
+        "eventlog_index_text 0 returns the whole eventlog");
+    s = eventlog_index_text (idx, 1, &len);
+    ok (s != NULL && !strcmp (s, E2),
+        "eventlog_index_text 1 returns the eventlog from entry 1");
+    s = eventlog_index_text (idx, 2, &len);
+    ok (s != NULL && len == 0,
+        "eventlog_index_text 2 returns an empty eventlog");
+
+    ok (eventlog_index_find (idx, 0, "alloc") == 1,
+        "eventlog_index_find alloc from 0 returns 1");
+    errno = 0;
+    ok (eventlog_index_find (idx, 2, "alloc") < 0 && errno == ENOENT,
+        "eventlog_index_find alloc from 2 fails with ENOENT");
+
+    ok (eventlog_index_append (idx, E3, strlen (E3)) == 1,
+        "eventlog_index_append of a third entry returns 1");
+    check_name (idx, 2, "clean");
+    check_name (idx, 0, "submit");
+    s = eventlog_index_text (idx, 0, NULL);
+    ok (s != NULL && !strcmp (s, E1 E2 E3),
+        "eventlog_index_text returns all three entries");
+
+    eventlog_index_destroy (idx);
+}
+
+/* Feed an eventlog one byte at a time.
+ */
+static void partial (void)
+{
+    struct eventlog_index *idx;
+    const char *log = E1 E2 E3;
+    const char *rest;
+    int total = 0;
+    int n;
+    int i;
+
+    if (!(idx = eventlog_index_create ()))
+        BAIL_OUT ("eventlog_index_create failed");
+    for (i = 0; i < strlen (log); i++) {
+        if ((n = eventlog_index_append (idx, log + i, 1)) < 0)
+            break;
+        total += n;
+        if (log[i] != '\n' && eventlog_index_count (idx) != total)
+            break;
+    }
+    ok (i == strlen (log) && total == 3,
+        "eventlog_index_append works one byte at a time");
+    ok (!strcmp (eventlog_index_text (idx, 0, NULL), log),
+        "eventlog_index_text matches the input");
+    check_name (idx, 1, "alloc");
+
+    ok (eventlog_index_append (idx, "{\"timest", 8) == 0
+        && eventlog_index_count (idx) == 3,
+        "a partial entry is not counted");
+    ok (!strcmp (eventlog_index_text (idx, 0, NULL), log),
+        "a partial entry is not included in eventlog_index_text");
+    rest = "amp\":45.0,\"name\":\"x\"}\n" E1;
+    ok (eventlog_index_append (idx, rest, strlen (rest)) == 2,
+        "completing the partial entry with another entry returns 2");
+    check_name (idx, 3, "x");
+    check_name (idx, 4, "submit");
+    ok (eventlog_index_append (idx, "", 0) == 0,
+        "eventlog_index_append of zero bytes returns 0");
+
+    eventlog_index_destroy (idx);
+}
+
+/* Append many entries to exercise buffer growth.
+ */
+static void many (void)
+{
+    struct eventlog_index *idx;
+    char entry[128];
+    int errors = 0;
+    int i;
+
+    if (!(idx = eventlog_index_create ()))
+        BAIL_OUT ("eventlog_index_create failed");
+    for (i = 0; i < 1000; i++) {
+        snprintf (entry,
+                  sizeof (entry),
+                  "{\"timestamp\":%d.0,\"name\":\"e%d\"}\n",
+                  i,
+                  i);
+        if (eventlog_index_append (idx, entry, strlen (entry)) != 1)
+            errors++;
+    }
+    ok (errors == 0 && eventlog_index_count (idx) == 1000,
+        "eventlog_index_append works for 1000 entries");
+    ok (eventlog_index_find (idx, 0, "e999") == 999,
+        "eventlog_index_find finds the last entry");
+    ok (eventlog_index_find (idx, 500, "e10") < 0,
+        "eventlog_index_find does not search before start");
+    ok (!strcmp (eventlog_index_text (idx, 999, NULL), entry),
+        "eventlog_index_text of the last entry works");
+    eventlog_index_destroy (idx);
+}
+
+static void trim (void)
+{
+    struct eventlog_index *idx;
+    const char *rest;
+    const char *s;
+    size_t len;
+
+    if (!(idx = eventlog_index_create ()))
+        BAIL_OUT ("eventlog_index_create failed");
+    if (eventlog_index_append (idx, E1 E2 E3, strlen (E1 E2 E3)) != 3)
+        BAIL_OUT ("eventlog_index_append failed");
+    check_name (idx, 1, "alloc");
+
+    eventlog_index_trim (idx, 1);
+    ok (eventlog_index_count (idx) == 3 && eventlog_index_first (idx) == 1,
+        "eventlog_index_trim 1 keeps count and advances first");
+    errno = 0;
+    ok (eventlog_index_entry (idx, 0) == NULL && errno == ENOENT,
+        "eventlog_index_entry of a discarded entry fails with ENOENT");
+    errno = 0;
+    ok (eventlog_index_entry_text (idx, 0, NULL) == NULL && errno == ENOENT,
+        "eventlog_index_entry_text of a discarded entry fails with ENOENT");
+    errno = 0;
+    ok (eventlog_index_text (idx, 0, NULL) == NULL && errno == EINVAL,
+        "eventlog_index_text of a discarded entry fails with EINVAL");
+    check_name (idx, 1, "alloc");
+    check_name (idx, 2, "clean");
+    s = eventlog_index_entry_text (idx, 2, &len);
+    ok (s != NULL && len == strlen (E3) && !strncmp (s, E3, len),
+        "eventlog_index_entry_text works after trim");
+    s = eventlog_index_text (idx, 1, &len);
+    ok (s != NULL && len == strlen (E2 E3) && !strcmp (s, E2 E3),
+        "eventlog_index_text returns the remaining entries");
+    ok (eventlog_index_find (idx, 0, "clean") == 2,
+        "eventlog_index_find skips discarded entries");
+
+    ok (eventlog_index_append (idx, "{\"timestamp\":4", 14) == 0,
+        "eventlog_index_append of a partial entry works");
+    eventlog_index_trim (idx, 10);
+    ok (eventlog_index_count (idx) == 3 && eventlog_index_first (idx) == 3,
+        "eventlog_index_trim past the end discards all entries");
+    s = eventlog_index_text (idx, 3, &len);
+    ok (s != NULL && len == 0,
+        "eventlog_index_text of an emptied index is empty");
+    rest = "5.0,\"name\":\"x\"}\n" E1;
+    ok (eventlog_index_append (idx, rest, strlen (rest)) == 2
+        && eventlog_index_count (idx) == 5,
+        "the partial entry is completed after trim");
+    check_name (idx, 3, "x");
+    check_name (idx, 4, "submit");
+    eventlog_index_trim (idx, 2);
+    ok (eventlog_index_first (idx) == 3,
+        "eventlog_index_trim before first is a no-op");
+    lives_ok ({eventlog_index_trim (NULL, 1);},
+              "eventlog_index_trim NULL doesn't crash");
+    eventlog_index_destroy (idx);
+}
+
+static void invalid (void)
+{
+    struct eventlog_index *idx;
+    const char *log = "foo\n\n{\"name\":\"x\"}\n" E3;
+
+    if (!(idx = eventlog_index_create ()))
+        BAIL_OUT ("eventlog_index_create failed");
+    ok (eventlog_index_append (idx, log, strlen (log)) == 4,
+        "eventlog_index_append does not validate entries");
+    errno = 0;
+    ok (eventlog_index_entry (idx, 0) == NULL && errno == EINVAL,
+        "eventlog_index_entry fails with EINVAL on non-JSON entry");
+    errno = 0;
+    ok (eventlog_index_entry (idx, 1) == NULL && errno == EINVAL,
+        "eventlog_index_entry fails with EINVAL on empty entry");
+    errno = 0;
+    ok (eventlog_index_entry (idx, 2) == NULL && errno == EINVAL,
+        "eventlog_index_entry fails with EINVAL on entry without timestamp");
+    ok (eventlog_index_find (idx, 0, "clean") == 3,
+        "eventlog_index_find skips invalid entries");
+    errno = 0;
+    ok (eventlog_index_entry (idx, 4) == NULL && errno == ENOENT,
+        "eventlog_index_entry fails with ENOENT on out of range seq");
+    errno = 0;
+    ok (eventlog_index_entry (idx, -1) == NULL && errno == ENOENT,
+        "eventlog_index_entry fails with ENOENT on negative seq");
+    errno = 0;
+    ok (eventlog_index_entry_text (idx, 4, NULL) == NULL && errno == ENOENT,
+        "eventlog_index_entry_text fails with ENOENT on out of range seq");
+    errno = 0;
+    ok (eventlog_index_text (idx, 5, NULL) == NULL && errno == EINVAL,
+        "eventlog_index_text fails with EINVAL on out of range seq");
+    errno = 0;
+    ok (eventlog_index_append (idx, NULL, 1) < 0 && errno == EINVAL,
+        "eventlog_index_append s=NULL fails with EINVAL");
+    eventlog_index_destroy (idx);
+
+    errno = 0;
+    ok (eventlog_index_append (NULL, E1, strlen (E1)) < 0 && errno == EINVAL,
+        "eventlog_index_append idx=NULL fails with EINVAL");
+    errno = 0;
+    ok (eventlog_index_entry (NULL, 0) == NULL && errno == EINVAL,
+        "eventlog_index_entry idx=NULL fails with EINVAL");
+    errno = 0;
+    ok (eventlog_index_find (NULL, 0, "x") < 0 && errno == EINVAL,
+        "eventlog_index_find idx=NULL fails with EINVAL");
+    ok (eventlog_index_count (NULL) == 0,
+        "eventlog_index_count idx=NULL returns 0");
+    lives_ok ({eventlog_index_destroy (NULL);},
+              "eventlog_index_destroy NULL doesn't crash");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    basic ();
+    partial ();
+    many ();
+    trim ();
+    invalid ();
+
+    done_testing ();
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -100,6 +100,76 @@ flux_msg_t *flux_msg_create (int type)
     return msg;
 }
 
+struct msg_payload *msg_payload_create (void *data,
+                                        flux_free_f free_fn,
+                                        void *arg)
+{
+    struct msg_payload *p;
+
+    if (!(p = calloc (1, sizeof (*p))))
+        return NULL;
+    p->refcount = 1;
+    p->data = data;
+    p->free_fn = free_fn;
+    p->arg = arg;
+    return p;
+}
+
+struct msg_payload *msg_payload_incref (struct msg_payload *p)
+{
+    if (p)
+        __atomic_add_fetch (&p->refcount, 1, __ATOMIC_RELAXED);
+    return p;
+}
+
+void msg_payload_decref (struct msg_payload *p)
+{
+    if (p && __atomic_sub_fetch (&p->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        int saved_errno = errno;
+        if (p->free_fn)
+            p->free_fn (p->arg);
+        else
+            free (p->data);
+        free (p);
+        errno = saved_errno;
+    }
+}
+
+/* N.B. const attribute of msg argument is defeated internally so that a
+ * msg-owned payload can be handed over to a shared reference.  The payload
+ * pointer and content are unchanged.
+ */
+struct msg_payload *msg_payload_share (const flux_msg_t *const_msg)
+{
+    flux_msg_t *msg = (flux_msg_t *)const_msg;
+
+    if (msg_validate (msg) < 0)
+        return NULL;
+    if (!msg_has_payload (msg)) {
+        errno = EPROTO;
+        return NULL;
+    }
+    if (!msg->payload_ref) {
+        if (!(msg->payload_ref = msg_payload_create (msg->payload,
+                                                     NULL,
+                                                     NULL)))
+            return NULL;
+    }
+    return msg_payload_incref (msg->payload_ref);
+}
+
+static void msg_payload_clear (flux_msg_t *msg)
+{
+    if (msg->payload_ref) {
+        msg_payload_decref (msg->payload_ref);
+        msg->payload_ref = NULL;
+    }
+    else
+        free (msg->payload);
+    msg->payload = NULL;
+    msg->payload_size = 0;
+}
+
 void flux_msg_destroy (flux_msg_t *msg)
 {
     if (msg && msg->refcount > 0 && --msg->refcount == 0) {
@@ -107,7 +177,7 @@ void flux_msg_destroy (flux_msg_t *msg)
         if (msg_has_route (msg))
             msg_route_clear (msg);
         free (msg->topic);
-        free (msg->payload);
+        msg_payload_clear (msg);
         json_decref (msg->json);
         aux_destroy (&msg->aux);
         free (msg->lasterr);
@@ -306,6 +376,8 @@ flux_msg_t *flux_msg_decode (const void *buf, size_t size)
         }
         iov[iovcnt].data = p;
         iov[iovcnt].size = n;
+        iov[iovcnt].transport_data = NULL;
+        iov[iovcnt].payload = NULL;
         iovcnt++;
         p += n;
     }
@@ -850,6 +922,20 @@ int flux_msg_set_payload (flux_msg_t *msg, const void *buf, int size)
                 return -1;
             }
         }
+        /* Shared payload memory is read-only, so replace it with a copy.
+         */
+        if (msg->payload_ref) {
+            void *ptr;
+            if (msg->payload == buf && msg->payload_size == size)
+                return 0;
+            if (!(ptr = malloc (size)))
+                return -1;
+            memcpy (ptr, buf, size);
+            msg_payload_clear (msg);
+            msg->payload = ptr;
+            msg->payload_size = size;
+            return 0;
+        }
         if (size > msg->payload_size) {
             void *ptr;
             if (!(ptr = realloc (msg->payload, size))) {
@@ -873,14 +959,62 @@ int flux_msg_set_payload (flux_msg_t *msg, const void *buf, int size)
      */
     } else if (msg_has_payload (msg) && (buf == NULL || size == 0)) {
         assert (msg->payload);
-        free (msg->payload);
-        msg->payload = NULL;
-        msg->payload_size = 0;
+        msg_payload_clear (msg);
         msg_clear_flag (msg, FLUX_MSGFLAG_PAYLOAD);
     }
     return 0;
 }
 
+static int msg_set_payload_shared (flux_msg_t *msg,
+                                   struct msg_payload *p,
+                                   const void *buf,
+                                   int size)
+{
+    json_decref (msg->json);            /* invalidate cached json object */
+    msg->json = NULL;
+    if (msg_has_payload (msg))
+        msg_payload_clear (msg);
+    msg->payload = (void *)buf;
+    msg->payload_size = size;
+    msg->payload_ref = p;
+    msg_set_flag (msg, FLUX_MSGFLAG_PAYLOAD);
+    return 0;
+}
+
+int flux_msg_set_payload_ref (flux_msg_t *msg,
+                              const void *buf,
+                              int size,
+                              flux_free_f free_fn,
+                              void *arg)
+{
+    struct msg_payload *p;
+
+    if (msg_validate (msg) < 0)
+        return -1;
+    if (!buf || size <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(p = msg_payload_create ((void *)buf, free_fn, arg)))
+        return -1;
+    return msg_set_payload_shared (msg, p, buf, size);
+}
+
+int flux_msg_set_payload_from (flux_msg_t *msg, const flux_msg_t *src)
+{
+    struct msg_payload *p;
+
+    if (msg_validate (msg) < 0 || msg_validate (src) < 0)
+        return -1;
+    if (msg == src)
+        return 0;
+    if (!msg_has_payload (src))
+        return flux_msg_set_payload (msg, NULL, 0);
+    if (!(p = msg_payload_share (src)))
+        return -1;
+    return msg_set_payload_shared (msg, p, src->payload, src->payload_size);
+}
+
 static inline void msg_lasterr_reset (flux_msg_t *msg)
 {
     if (msg_validate (msg) == 0) {
@@ -1146,10 +1280,10 @@ flux_msg_t *flux_msg_copy (const flux_msg_t *msg, bool payload)
     }
     if (msg->payload) {
         if (payload) {
-            cpy->payload_size = msg->payload_size;
-            if (!(cpy->payload = malloc (cpy->payload_size)))
+            if (!(cpy->payload_ref = msg_payload_share (msg)))
                 goto error;
-            memcpy (cpy->payload, msg->payload, msg->payload_size);
+            cpy->payload = msg->payload;
+            cpy->payload_size = msg->payload_size;
         }
         else
             msg_clear_flag (cpy, FLUX_MSGFLAG_PAYLOAD);
@@ -179,6 +179,23 @@ int flux_msg_get_payload (const flux_msg_t *msg, const void **buf, int *size);
 int flux_msg_set_payload (flux_msg_t *msg, const void *buf, int size);
 bool flux_msg_has_payload (const flux_msg_t *msg);
 
+/* Set payload without copying.
+ * flux_msg_set_payload_ref() makes 'buf' the payload of 'msg'.  The buffer
+ * must not be modified until 'free_fn' is called with 'arg', once the last
+ * message referencing it is destroyed.  Copies of the message share the
+ * buffer, and message transports may release it from another thread, so
+ * 'free_fn' must be thread safe.  On failure, the caller retains 'buf'.
+ * flux_msg_set_payload_from() sets the payload of 'msg' to a shared
+ * reference to the payload of 'src'.
+ * Modifying a shared payload with flux_msg_set_payload() makes a copy.
+ */
+int flux_msg_set_payload_ref (flux_msg_t *msg,
+                              const void *buf,
+                              int size,
+                              flux_free_f free_fn,
+                              void *arg);
+int flux_msg_set_payload_from (flux_msg_t *msg, const flux_msg_t *src);
+
 /* Get/set flags
  * Users should avoid using flux_msg_set_flags(), and instead use the
  * higher level functions that manipulate message flags.  It is exposed
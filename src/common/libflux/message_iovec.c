@@ -81,9 +81,15 @@ int iovec_to_msg (flux_msg_t *msg,
             return -1;
         }
         msg->payload_size = iov[index].size;
-        if (!(msg->payload = malloc (msg->payload_size)))
-            return -1;
-        memcpy (msg->payload, iov[index].data, msg->payload_size);
+        if (iov[index].payload) {
+            msg->payload = (void *)iov[index].data;
+            msg->payload_ref = msg_payload_incref (iov[index].payload);
+        }
+        else {
+            if (!(msg->payload = malloc (msg->payload_size)))
+                return -1;
+            memcpy (msg->payload, iov[index].data, msg->payload_size);
+        }
         if (index < iovcnt)
             index++;
     }
@@ -118,7 +124,7 @@ int msg_to_iovec (const flux_msg_t *msg,
 
     assert (frame_count);
 
-    if (!(iov = malloc (frame_count * sizeof (*iov))))
+    if (!(iov = calloc (frame_count, sizeof (*iov))))
         return -1;
 
     index = frame_count - 1;
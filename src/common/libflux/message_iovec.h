@@ -16,13 +16,34 @@
 /* 'transport_data' is for any auxiliary transport data user may wish
  * to associate with iovec, user is responsible to free/destroy the
  * field
+ *
+ * If 'payload' is non-NULL, 'data' lies within that shared payload
+ * memory and iovec_to_msg() takes a reference on it instead of copying.
+ * msg_to_iovec() sets it to NULL.
  */
 struct msg_iovec {
     const void *data;
     size_t size;
     void *transport_data;
+    struct msg_payload *payload;
 };
 
+/* Create a reference counted payload for 'data'.  When the last reference
+ * is dropped, free_fn (arg) is called, or free (data) if free_fn is NULL.
+ * References may be dropped from any thread.
+ */
+struct msg_payload *msg_payload_create (void *data,
+                                        flux_free_f free_fn,
+                                        void *arg);
+struct msg_payload *msg_payload_incref (struct msg_payload *p);
+void msg_payload_decref (struct msg_payload *p);
+
+/* Get a reference on the payload of 'msg' so that a transport can send it
+ * without copying.  A payload owned by 'msg' is converted to a shared one
+ * in place, leaving the message content unchanged.
+ */
+struct msg_payload *msg_payload_share (const flux_msg_t *msg);
+
 int iovec_to_msg (flux_msg_t *msg,
                   struct msg_iovec *iov,
                   int iovcnt);
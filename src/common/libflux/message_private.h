@@ -20,8 +20,20 @@
 #endif
 #include "src/common/libccan/ccan/list/list.h"
 
+#include "types.h"
 #include "message_proto.h"
 
+/* Payload memory that may be referenced by several messages and
+ * transports at once.  The reference count is updated atomically since
+ * a transport may drop its reference from another thread.
+ */
+struct msg_payload {
+    int refcount;
+    void *data;
+    flux_free_f free_fn;    // if NULL, data is released with free(3)
+    void *arg;
+};
+
 struct flux_msg {
     // optional route list, if FLUX_MSGFLAG_ROUTE
     struct list_head routes;
@@ -33,6 +45,8 @@ struct flux_msg {
     // optional payload frame, if FLUX_MSGFLAG_PAYLOAD
     void *payload;
     size_t payload_size;
+    // if non-NULL, payload is read-only memory shared via this reference
+    struct msg_payload *payload_ref;
 
     // required proto frame data
     struct proto proto;
@@ -0,0 +1,647 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* libflux-bench - time libflux hot paths
+ *
+ * Usage: libflux-bench [OPTIONS] [BENCHMARK...]
+ *
+ * Each benchmark times N iterations of one operation, excluding setup.
+ * Results are printed on stdout as a single JSON object so they can be
+ * recorded and compared across releases:
+ *
+ *   {"version":s, "iterations":i,
+ *    "results":[{"name":s, "count":i, "elapsed":f,
+ *                "ops_per_sec":f, "usec_per_op":f}, ...]}
+ *
+ * where "elapsed" is in seconds.  The rpc.loop and dispatch benchmarks
+ * use the self-contained loopback connector from libtestutil, which
+ * behaves like loop://.  The rpc.local benchmark pings the broker and
+ * only runs if --uri is given or FLUX_URI is set, e.g. under flux-start.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libtestutil/util.h"
+
+struct bench_ctx {
+    int iterations;
+    int handlers;
+    int payload_size;
+    const char *uri;
+};
+
+/* Run 'count' iterations and set 'elapsed' (in seconds).
+ * Return false if the benchmark was skipped.
+ */
+typedef bool (*bench_f)(struct bench_ctx *ctx, int count, double *elapsed);
+
+static flux_msg_t *request_create (const char *topic, int size)
+{
+    flux_msg_t *msg;
+    char *buf;
+
+    if (!(buf = malloc (size)))
+        log_err_exit ("malloc");
+    memset (buf, 'x', size);
+    if (!(msg = flux_request_encode_raw (topic, buf, size)))
+        log_err_exit ("flux_request_encode_raw");
+    free (buf);
+    return msg;
+}
+
+static bool bench_msg_create (struct bench_ctx *ctx, int count, double *elapsed)
+{
+    struct timespec t0;
+    int i;
+
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        flux_msg_t *msg;
+
+        if (!(msg = flux_request_encode ("bench.create", "{\"seq\":1}")))
+            log_err_exit ("flux_request_encode");
+        flux_msg_destroy (msg);
+    }
+    *elapsed = monotime_since (t0) * 1E-3;
+    return true;
+}
+
+static bool bench_msg_encode (struct bench_ctx *ctx, int count, double *elapsed)
+{
+    flux_msg_t *msg = request_create ("bench.encode", ctx->payload_size);
+    struct timespec t0;
+    ssize_t size;
+    void *buf;
+    int i;
+
+    if ((size = flux_msg_encode_size (msg)) < 0)
+        log_err_exit ("flux_msg_encode_size");
+    if (!(buf = malloc (size)))
+        log_err_exit ("malloc");
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        if (flux_msg_encode_size (msg) != size
+            || flux_msg_encode (msg, buf, size) < 0)
+            log_err_exit ("flux_msg_encode");
+    }
+    *elapsed = monotime_since (t0) * 1E-3;
+    free (buf);
+    flux_msg_destroy (msg);
+    return true;
+}
+
+static void *msg_encode_buf (const char *topic, int payload_size, size_t *sizep)
+{
+    flux_msg_t *msg = request_create (topic, payload_size);
+    ssize_t size;
+    void *buf;
+
+    if ((size = flux_msg_encode_size (msg)) < 0
+        || !(buf = malloc (size))
+        || flux_msg_encode (msg, buf, size) < 0)
+        log_err_exit ("error encoding %s", topic);
+    flux_msg_destroy (msg);
+    *sizep = size;
+    return buf;
+}
+
+static bool bench_msg_decode (struct bench_ctx *ctx, int count, double *elapsed)
+{
+    struct timespec t0;
+    size_t size;
+    void *buf;
+    int i;
+
+    buf = msg_encode_buf ("bench.decode", ctx->payload_size, &size);
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        flux_msg_t *msg;
+
+        if (!(msg = flux_msg_decode (buf, size)))
+            log_err_exit ("flux_msg_decode");
+        flux_msg_destroy (msg);
+    }
+    *elapsed = monotime_since (t0) * 1E-3;
+    free (buf);
+    return true;
+}
+
+/* Decode a request and unpack its JSON payload, as a service would.
+ */
+static bool bench_msg_unpack (struct bench_ctx *ctx, int count, double *elapsed)
+{
+    struct timespec t0;
+    flux_msg_t *msg;
+    ssize_t size;
+    void *buf;
+    int i;
+
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST))
+        || flux_msg_set_topic (msg, "bench.unpack") < 0
+        || flux_msg_pack (msg, "{s:i s:s}", "seq", 1, "name", "foo") < 0
+        || (size = flux_msg_encode_size (msg)) < 0
+        || !(buf = malloc (size))
+        || flux_msg_encode (msg, buf, size) < 0)
+        log_err_exit ("error encoding bench.unpack");
+    flux_msg_destroy (msg);
+
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        const char *name;
+        int seq;
+
+        if (!(msg = flux_msg_decode (buf, size))
+            || flux_request_unpack (msg,
+                                    NULL,
+                                    "{s:i s:s}",
+                                    "seq", &seq,
+                                    "name", &name) < 0)
+            log_err_exit ("error decoding bench.unpack");
+        flux_msg_destroy (msg);
+    }
+    *elapsed = monotime_since (t0) * 1E-3;
+    free (buf);
+    return true;
+}
+
+/* Issue RPCs one at a time, each from the continuation of the last,
+ * until 'count' have completed.
+ */
+struct rpc_ctx {
+    flux_t *h;
+    const char *topic;
+    int count;
+    int done;
+};
+
+static void rpc_send_next (struct rpc_ctx *rc);
+
+static void rpc_continuation (flux_future_t *f, void *arg)
+{
+    struct rpc_ctx *rc = arg;
+
+    if (flux_rpc_get (f, NULL) < 0)
+        log_err_exit ("%s", rc->topic);
+    flux_future_destroy (f);
+    if (++rc->done < rc->count)
+        rpc_send_next (rc);
+    else
+        flux_reactor_stop (flux_get_reactor (rc->h));
+}
+
+static void rpc_send_next (struct rpc_ctx *rc)
+{
+    flux_future_t *f;
+
+    if (!(f = flux_rpc_pack (rc->h,
+                             rc->topic,
+                             FLUX_NODEID_ANY,
+                             0,
+                             "{s:i}",
+                             "seq", rc->done))
+        || flux_future_then (f, -1., rpc_continuation, rc) < 0)
+        log_err_exit ("%s", rc->topic);
+}
+
+static double rpc_run (flux_t *h, const char *topic, int count)
+{
+    struct rpc_ctx rc = { .h = h, .topic = topic, .count = count };
+    struct timespec t0;
+
+    monotime (&t0);
+    rpc_send_next (&rc);
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0)
+        log_err_exit ("flux_reactor_run");
+    return monotime_since (t0) * 1E-3;
+}
+
+static void echo_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    if (flux_respond (h, msg, NULL) < 0)
+        log_err_exit ("flux_respond");
+}
+
+static bool bench_rpc_loop (struct bench_ctx *ctx, int count, double *elapsed)
+{
+    struct flux_match match = FLUX_MATCH_REQUEST;
+    flux_msg_handler_t *mh;
+    flux_t *h;
+
+    if (!(h = loopback_create (0)))
+        log_err_exit ("loopback_create");
+    match.topic_glob = "bench.echo";
+    if (!(mh = flux_msg_handler_create (h, match, echo_cb, NULL)))
+        log_err_exit ("flux_msg_handler_create");
+    flux_msg_handler_start (mh);
+
+    *elapsed = rpc_run (h, "bench.echo", count);
+
+    flux_msg_handler_destroy (mh);
+    flux_close (h);
+    return true;
+}
+
+static bool bench_rpc_local (struct bench_ctx *ctx, int count, double *elapsed)
+{
+    flux_t *h;
+
+    if (!ctx->uri)
+        return false;
+    if (!(h = flux_open (ctx->uri, 0)))
+        log_err_exit ("flux_open %s", ctx->uri);
+
+    *elapsed = rpc_run (h, "broker.ping", count);
+
+    flux_close (h);
+    return true;
+}
+
+/* Register many handlers with distinct topics, then send requests
+ * to ourselves, each from the handler of the last, spreading them
+ * across the handlers.
+ */
+struct dispatch_ctx {
+    flux_t *h;
+    flux_msg_t **msgs;
+    int handlers;
+    int count;
+    int done;
+};
+
+static void dispatch_send_next (struct dispatch_ctx *dc)
+{
+    int index = (int)(((long)dc->done * 7919) % dc->handlers);
+
+    if (flux_send (dc->h, dc->msgs[index], 0) < 0)
+        log_err_exit ("flux_send");
+}
+
+static void dispatch_cb (flux_t *h,
+                         flux_msg_handler_t *mh,
+                         const flux_msg_t *msg,
+                         void *arg)
+{
+    struct dispatch_ctx *dc = arg;
+
+    if (++dc->done < dc->count)
+        dispatch_send_next (dc);
+    else
+        flux_reactor_stop (flux_get_reactor (h));
+}
+
+static bool bench_dispatch (struct bench_ctx *ctx, int count, double *elapsed)
+{
+    struct dispatch_ctx dc = { .handlers = ctx->handlers, .count = count };
+    flux_msg_handler_t **mh;
+    struct timespec t0;
+    int i;
+
+    if (!(dc.h = loopback_create (0)))
+        log_err_exit ("loopback_create");
+    if (!(mh = calloc (dc.handlers, sizeof (mh[0])))
+        || !(dc.msgs = calloc (dc.handlers, sizeof (dc.msgs[0]))))
+        log_err_exit ("calloc");
+    for (i = 0; i < dc.handlers; i++) {
+        struct flux_match match = FLUX_MATCH_REQUEST;
+        char topic[64];
+
+        snprintf (topic, sizeof (topic), "bench.dispatch-%d", i);
+        match.topic_glob = topic;
+        if (!(mh[i] = flux_msg_handler_create (dc.h, match, dispatch_cb, &dc)))
+            log_err_exit ("flux_msg_handler_create");
+        flux_msg_handler_start (mh[i]);
+        if (!(dc.msgs[i] = flux_request_encode (topic, NULL)))
+            log_err_exit ("flux_request_encode");
+    }
+
+    monotime (&t0);
+    dispatch_send_next (&dc);
+    if (flux_reactor_run (flux_get_reactor (dc.h), 0) < 0)
+        log_err_exit ("flux_reactor_run");
+    *elapsed = monotime_since (t0) * 1E-3;
+
+    for (i = 0; i < dc.handlers; i++) {
+        flux_msg_handler_destroy (mh[i]);
+        flux_msg_destroy (dc.msgs[i]);
+    }
+    free (mh);
+    free (dc.msgs);
+    flux_close (dc.h);
+    return true;
+}
+
+static bool bench_future_fulfill (struct bench_ctx *ctx,
+                                  int count,
+                                  double *elapsed)
+{
+    struct timespec t0;
+    int i;
+
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        flux_future_t *f;
+        const void *result;
+
+        if (!(f = flux_future_create (NULL, NULL)))
+            log_err_exit ("flux_future_create");
+        flux_future_fulfill (f, ctx, NULL);
+        if (flux_future_get (f, &result) < 0 || result != ctx)
+            log_err_exit ("flux_future_get");
+        flux_future_destroy (f);
+    }
+    *elapsed = monotime_since (t0) * 1E-3;
+    return true;
+}
+
+/* Fulfill futures one at a time, each from the continuation of the last.
+ */
+struct then_ctx {
+    flux_reactor_t *r;
+    int count;
+    int done;
+};
+
+static void then_fulfill_next (struct then_ctx *tc);
+
+static void then_continuation (flux_future_t *f, void *arg)
+{
+    struct then_ctx *tc = arg;
+
+    if (flux_future_get (f, NULL) < 0)
+        log_err_exit ("flux_future_get");
+    flux_future_destroy (f);
+    if (++tc->done < tc->count)
+        then_fulfill_next (tc);
+}
+
+static void then_fulfill_next (struct then_ctx *tc)
+{
+    flux_future_t *f;
+
+    if (!(f = flux_future_create (NULL, NULL)))
+        log_err_exit ("flux_future_create");
+    flux_future_set_reactor (f, tc->r);
+    if (flux_future_then (f, -1., then_continuation, tc) < 0)
+        log_err_exit ("flux_future_then");
+    flux_future_fulfill (f, NULL, NULL);
+}
+
+static bool bench_future_then (struct bench_ctx *ctx,
+                               int count,
+                               double *elapsed)
+{
+    struct then_ctx tc = { .count = count };
+    struct timespec t0;
+
+    if (!(tc.r = flux_reactor_create (0)))
+        log_err_exit ("flux_reactor_create");
+    monotime (&t0);
+    then_fulfill_next (&tc);
+    if (flux_reactor_run (tc.r, 0) < 0)
+        log_err_exit ("flux_reactor_run");
+    *elapsed = monotime_since (t0) * 1E-3;
+    if (tc.done != count)
+        log_msg_exit ("future.then: only %d of %d completed", tc.done, count);
+    flux_reactor_destroy (tc.r);
+    return true;
+}
+
+static void timer_cb (flux_reactor_t *r,
+                      flux_watcher_t *w,
+                      int revents,
+                      void *arg)
+{
+}
+
+/* Create, start, stop, and destroy a timer watcher, as a future or
+ * RPC with a timeout does.
+ */
+static bool bench_watcher_churn (struct bench_ctx *ctx,
+                                 int count,
+                                 double *elapsed)
+{
+    flux_reactor_t *r;
+    struct timespec t0;
+    int i;
+
+    if (!(r = flux_reactor_create (0)))
+        log_err_exit ("flux_reactor_create");
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        flux_watcher_t *w;
+
+        if (!(w = flux_timer_watcher_create (r, 60., 0., timer_cb, NULL)))
+            log_err_exit ("flux_timer_watcher_create");
+        flux_watcher_start (w);
+        flux_watcher_stop (w);
+        flux_watcher_destroy (w);
+    }
+    *elapsed = monotime_since (t0) * 1E-3;
+    flux_reactor_destroy (r);
+    return true;
+}
+
+static void idle_cb (flux_reactor_t *r,
+                     flux_watcher_t *w,
+                     int revents,
+                     void *arg)
+{
+    int *remaining = arg;
+
+    if (--(*remaining) == 0)
+        flux_watcher_stop (w);
+}
+
+/* Run the reactor with one idle watcher, timing loop iterations.
+ */
+static bool bench_reactor_loop (struct bench_ctx *ctx,
+                                int count,
+                                double *elapsed)
+{
+    flux_reactor_t *r;
+    flux_watcher_t *w;
+    struct timespec t0;
+    int remaining = count;
+
+    if (!(r = flux_reactor_create (0))
+        || !(w = flux_idle_watcher_create (r, idle_cb, &remaining)))
+        log_err_exit ("error creating reactor");
+    flux_watcher_start (w);
+    monotime (&t0);
+    if (flux_reactor_run (r, 0) < 0)
+        log_err_exit ("flux_reactor_run");
+    *elapsed = monotime_since (t0) * 1E-3;
+    flux_watcher_destroy (w);
+    flux_reactor_destroy (r);
+    return true;
+}
+
+static struct bench {
+    const char *name;
+    bench_f fn;
+    const char *desc;
+} benchmarks[] = {
+    { "msg.create", bench_msg_create,
+      "create and destroy a small request" },
+    { "msg.encode", bench_msg_encode,
+      "encode a request to a buffer" },
+    { "msg.decode", bench_msg_decode,
+      "decode a request from a buffer" },
+    { "msg.unpack", bench_msg_unpack,
+      "decode a request and unpack its JSON payload" },
+    { "rpc.loop", bench_rpc_loop,
+      "RPC round trip over the loopback connector" },
+    { "rpc.local", bench_rpc_local,
+      "broker.ping RPC round trip over the local connector" },
+    { "dispatch", bench_dispatch,
+      "dispatch a request among many message handlers" },
+    { "future.fulfill", bench_future_fulfill,
+      "create, fulfill, get, and destroy a future" },
+    { "future.then", bench_future_then,
+      "fulfill a future and run its continuation" },
+    { "reactor.watcher-churn", bench_watcher_churn,
+      "create, start, stop, and destroy a timer watcher" },
+    { "reactor.loop", bench_reactor_loop,
+      "one reactor loop iteration with an idle watcher" },
+    { NULL, NULL, NULL },
+};
+
+static struct bench *bench_lookup (const char *name)
+{
+    struct bench *b;
+
+    for (b = &benchmarks[0]; b->name != NULL; b++) {
+        if (!strcmp (b->name, name))
+            return b;
+    }
+    return NULL;
+}
+
+static void bench_run (struct bench *b, struct bench_ctx *ctx, json_t *results)
+{
+    double elapsed = 0.;
+    json_t *o;
+
+    if (!b->fn (ctx, ctx->iterations, &elapsed)) {
+        log_msg ("%s: skipped", b->name);
+        return;
+    }
+    if (!(o = json_pack ("{s:s s:i s:f s:f s:f}",
+                         "name", b->name,
+                         "count", ctx->iterations,
+                         "elapsed", elapsed,
+                         "ops_per_sec",
+                         elapsed > 0. ? ctx->iterations / elapsed : 0.,
+                         "usec_per_op",
+                         elapsed * 1E6 / ctx->iterations))
+        || json_array_append_new (results, o) < 0)
+        log_msg_exit ("error appending %s result", b->name);
+}
+
+static struct optparse_option opts[] = {
+    { .name = "iterations", .key = 'n', .has_arg = 1, .arginfo = "N",
+      .usage = "Run N iterations of each benchmark (default 100000)",
+    },
+    { .name = "handlers", .key = 'H', .has_arg = 1, .arginfo = "N",
+      .usage = "Register N message handlers for dispatch (default 4096)",
+    },
+    { .name = "payload-size", .key = 's', .has_arg = 1, .arginfo = "BYTES",
+      .usage = "Use BYTES sized payloads for msg.encode/decode (default 1024)",
+    },
+    { .name = "uri", .key = 'u', .has_arg = 1, .arginfo = "URI",
+      .usage = "Connect to URI for rpc.local (default $FLUX_URI)",
+    },
+    { .name = "list", .key = 'l', .has_arg = 0,
+      .usage = "List benchmarks and exit",
+    },
+    OPTPARSE_TABLE_END
+};
+
+int main (int argc, char *argv[])
+{
+    struct bench_ctx ctx;
+    optparse_t *p;
+    int optindex;
+    json_t *results;
+    json_t *o;
+    struct bench *b;
+
+    log_init ("libflux-bench");
+
+    if (!(p = optparse_create ("libflux-bench"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS
+        || optparse_set (p,
+                         OPTPARSE_USAGE,
+                         "[OPTIONS] [BENCHMARK...]") != OPTPARSE_SUCCESS)
+        log_msg_exit ("error setting up option parsing");
+    if ((optindex = optparse_parse_args (p, argc, argv)) < 0)
+        exit (1);
+
+    if (optparse_hasopt (p, "list")) {
+        for (b = &benchmarks[0]; b->name != NULL; b++)
+            printf ("%-24s%s\n", b->name, b->desc);
+        exit (0);
+    }
+
+    ctx.iterations = optparse_get_int (p, "iterations", 100000);
+    ctx.handlers = optparse_get_int (p, "handlers", 4096);
+    ctx.payload_size = optparse_get_int (p, "payload-size", 1024);
+    ctx.uri = optparse_get_str (p, "uri", getenv ("FLUX_URI"));
+    if (ctx.iterations <= 0 || ctx.handlers <= 0)
+        log_msg_exit ("iterations and handlers must be > 0");
+    if (ctx.payload_size < 0)
+        log_msg_exit ("payload-size must be >= 0");
+
+    if (!(results = json_array ()))
+        log_msg_exit ("out of memory");
+    if (optindex < argc) {
+        while (optindex < argc) {
+            if (!(b = bench_lookup (argv[optindex])))
+                log_msg_exit ("%s: unknown benchmark", argv[optindex]);
+            bench_run (b, &ctx, results);
+            optindex++;
+        }
+    }
+    else {
+        for (b = &benchmarks[0]; b->name != NULL; b++)
+            bench_run (b, &ctx, results);
+    }
+
+    if (!(o = json_pack ("{s:s s:i s:O}",
+                         "version", flux_core_version_string (),
+                         "iterations", ctx.iterations,
+                         "results", results))
+        || json_dumpf (o, stdout, JSON_COMPACT) < 0)
+        log_msg_exit ("error writing results");
+    printf ("\n");
+
+    json_decref (o);
+    json_decref (results);
+    optparse_destroy (p);
+    return 0;
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
@@ -1072,6 +1072,89 @@ void check_copy (void)
     flux_msg_destroy (msg);
 }
 
+static int reffree_count = 0;
+void reffree (void *arg)
+{
+    reffree_count++;
+    free (arg);
+}
+
+void check_payload_ref (void)
+{
+    flux_msg_t *msg, *cpy, *msg2;
+    const void *buf;
+    int len;
+    char *data;
+
+    if (!(data = strdup ("abcdefghijklmnopqrstuvwxyz")))
+        BAIL_OUT ("out of memory");
+    ok ((msg = flux_msg_create (FLUX_MSGTYPE_REQUEST)) != NULL,
+        "created request");
+    errno = 0;
+    ok (flux_msg_set_payload_ref (msg, NULL, 1, reffree, NULL) < 0
+        && errno == EINVAL,
+        "flux_msg_set_payload_ref buf=NULL fails with EINVAL");
+    ok (flux_msg_set_payload_ref (msg, data, 27, reffree, data) == 0,
+        "flux_msg_set_payload_ref works");
+    ok (flux_msg_get_payload (msg, &buf, &len) == 0
+        && buf == data
+        && len == 27,
+        "payload was not copied");
+    ok ((cpy = flux_msg_copy (msg, true)) != NULL
+        && flux_msg_get_payload (cpy, &buf, &len) == 0
+        && buf == data
+        && len == 27,
+        "flux_msg_copy shares referenced payload");
+    ok ((msg2 = flux_msg_create (FLUX_MSGTYPE_RESPONSE)) != NULL
+        && flux_msg_set_payload_from (msg2, cpy) == 0
+        && flux_msg_get_payload (msg2, &buf, &len) == 0
+        && buf == data
+        && len == 27,
+        "flux_msg_set_payload_from shares payload");
+    flux_msg_destroy (msg);
+    ok (reffree_count == 0,
+        "destroying original does not free shared payload");
+    ok (flux_msg_set_payload (cpy, "foo", 4) == 0
+        && flux_msg_get_payload (cpy, &buf, &len) == 0
+        && buf != data
+        && len == 4
+        && !strcmp (buf, "foo"),
+        "flux_msg_set_payload on shared payload makes a copy");
+    ok (flux_msg_get_payload (msg2, &buf, &len) == 0
+        && buf == data
+        && !strcmp (buf, "abcdefghijklmnopqrstuvwxyz"),
+        "other reference is unchanged");
+    ok (reffree_count == 0,
+        "shared payload is not freed while referenced");
+    flux_msg_destroy (msg2);
+    ok (reffree_count == 1,
+        "free function called once when last reference is dropped");
+    flux_msg_destroy (cpy);
+
+    /* payload owned by a message may be shared too */
+    ok ((msg = flux_msg_create (FLUX_MSGTYPE_REQUEST)) != NULL
+        && flux_msg_set_string (msg, "hello") == 0,
+        "created request with string payload");
+    ok ((cpy = flux_msg_copy (msg, true)) != NULL,
+        "flux_msg_copy works");
+    flux_msg_destroy (msg);
+    ok (flux_msg_get_payload (cpy, &buf, &len) == 0
+        && len == 6
+        && !strcmp (buf, "hello"),
+        "copy payload survives destruction of original");
+    ok (flux_msg_set_payload_from (cpy, cpy) == 0,
+        "flux_msg_set_payload_from msg=src is a no-op");
+    ok ((msg2 = flux_msg_create (FLUX_MSGTYPE_RESPONSE)) != NULL
+        && flux_msg_set_string (msg2, "goodbye") == 0
+        && (msg = flux_msg_create (FLUX_MSGTYPE_REQUEST)) != NULL
+        && flux_msg_set_payload_from (msg2, msg) == 0
+        && !flux_msg_has_payload (msg2),
+        "flux_msg_set_payload_from src without payload clears payload");
+    flux_msg_destroy (msg);
+    flux_msg_destroy (msg2);
+    flux_msg_destroy (cpy);
+}
+
 void check_print (void)
 {
     flux_msg_t *msg;
@@ -1395,6 +1478,7 @@ int main (int argc, char *argv[])
     check_security ();
     check_aux ();
     check_copy ();
+    check_payload_ref ();
     check_flags ();
 
     check_cmp ();
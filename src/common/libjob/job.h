@@ -126,6 +126,32 @@ flux_future_t *flux_job_submit (flux_t *h, const char *jobspec,
  */
 int flux_job_submit_get_id (flux_future_t *f, flux_jobid_t *id);
 
+/* Submit 'njobs' jobs in one request.  Each of 'jobspecs' is submitted
+ * as with flux_job_submit(), using the same 'urgency' and 'flags'.
+ */
+flux_future_t *flux_job_submit_bulk (flux_t *h,
+                                     int njobs,
+                                     const char **jobspecs,
+                                     int urgency,
+                                     int flags);
+
+/* Parse the jobid of the job at 'index' (in the order submitted) from
+ * the response to flux_job_submit_bulk().  If the job was rejected,
+ * return -1 with errno set and, if 'errstr' is non-NULL, set it to the
+ * error message.  If the whole request failed, return -1 with errno set,
+ * and an extended error message may be available with
+ * flux_future_error_string().
+ */
+int flux_job_submit_bulk_get_id (flux_future_t *f,
+                                 int index,
+                                 flux_jobid_t *id,
+                                 const char **errstr);
+
+/* Return the number of jobs in the response to flux_job_submit_bulk(),
+ * or -1 on failure with errno set.
+ */
+int flux_job_submit_bulk_count (flux_future_t *f);
+
 /* Wait for jobid to enter INACTIVE state.
  * If jobid=FLUX_JOBID_ANY, wait for the next waitable job.
  * Fails with ECHILD if there is nothing to wait for.
@@ -14,11 +14,12 @@
 #include <unistd.h>
 #include <sys/types.h>
 //#include <ctype.h>
+#include <string.h>
 #include <flux/core.h>
 #if HAVE_FLUX_SECURITY
 #include <flux/security/sign.h>
 #endif
-//#include <jansson.h>
+#include <jansson.h>
 
 #include "job.h"
 #include "sign_none.h"
@@ -70,6 +71,45 @@ error:
 }
 #endif
 
+/* Sign 'jobspec' and return a copy of J, which the caller must free.
+ * On failure return NULL with errno set.  If a textual error message
+ * is available, also set the value of 'f_error' to a future containing it.
+ */
+static char *sign_jobspec (flux_t *h,
+                           const char *jobspec,
+                           flux_future_t **f_error)
+{
+    char *J;
+#if HAVE_FLUX_SECURITY
+    flux_security_t *sec;
+    const char *mech = NULL;
+    const char *s;
+    uint32_t owner;
+
+    /* Security note:
+     * Instance owner jobs do not need a cryptographic signature since
+     * they do not require the IMP to be executed.  Force the signing
+     * mechanism to 'none' if the connector can provide owner userid and
+     * owner == getuid().  This side-steps the requirement that the
+     * munge daemon is running for single user instances compiled
+     * --with-flux-security, as described in flux-framework/flux-core#3305.
+     */
+    if (flux_opt_get (h, "flux::owner", &owner, sizeof (owner)) == 0
+            && getuid () == owner)
+        mech = "none";
+    if (!(sec = get_security_ctx (h, f_error)))
+        return NULL;
+    if (!(s = flux_sign_wrap (sec, jobspec, strlen (jobspec), mech, 0))) {
+        *f_error = get_security_error (sec);
+        return NULL;
+    }
+    J = strdup (s);
+#else
+    J = sign_none_wrap (jobspec, strlen (jobspec), getuid ());
+#endif
+    return J;
+}
+
 flux_future_t *flux_job_submit (flux_t *h, const char *jobspec, int urgency,
                                 int flags)
 {
@@ -83,31 +123,9 @@ flux_future_t *flux_job_submit (flux_t *h, const char *jobspec, int urgency,
         return NULL;
     }
     if (!(flags & FLUX_JOB_PRE_SIGNED)) {
-#if HAVE_FLUX_SECURITY
-        flux_security_t *sec;
-        const char *mech = NULL;
-        uint32_t owner;
-
-        /* Security note:
-         * Instance owner jobs do not need a cryptographic signature since
-         * they do not require the IMP to be executed.  Force the signing
-         * mechanism to 'none' if the connector can provide owner userid and
-         * owner == getuid().  This side-steps the requirement that the
-         * munge daemon is running for single user instances compiled
-         * --with-flux-security, as described in flux-framework/flux-core#3305.
-         */
-        if (flux_opt_get (h, "flux::owner", &owner, sizeof (owner)) == 0
-                && getuid () == owner)
-            mech = "none";
-        if (!(sec = get_security_ctx (h, &f)))
+        if (!(s = sign_jobspec (h, jobspec, &f)))
             return f;
-        if (!(J = flux_sign_wrap (sec, jobspec, strlen (jobspec), mech, 0)))
-            return get_security_error (sec);
-#else
-        if (!(s = sign_none_wrap (jobspec, strlen (jobspec), getuid ())))
-            goto error;
         J = s;
-#endif
     }
     else {
         J = jobspec;
@@ -119,6 +137,7 @@ flux_future_t *flux_job_submit (flux_t *h, const char *jobspec, int urgency,
                              "urgency", urgency,
                              "flags", flags)))
         goto error;
+    free (s);
     return f;
 error:
     saved_errno = errno;
@@ -143,6 +162,115 @@ int flux_job_submit_get_id (flux_future_t *f, flux_jobid_t *jobid)
     return 0;
 }
 
+flux_future_t *flux_job_submit_bulk (flux_t *h,
+                                     int njobs,
+                                     const char **jobspecs,
+                                     int urgency,
+                                     int flags)
+{
+    flux_future_t *f = NULL;
+    json_t *jobs;
+    bool pre_signed = (flags & FLUX_JOB_PRE_SIGNED);
+    int saved_errno;
+
+    if (!h || njobs < 0 || (njobs > 0 && !jobspecs)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    flags &= ~FLUX_JOB_PRE_SIGNED; // client only flag
+    if (!(jobs = json_array ()))
+        goto nomem;
+    for (int i = 0; i < njobs; i++) {
+        char *s = NULL;
+        json_t *entry;
+
+        if (!jobspecs[i]) {
+            errno = EINVAL;
+            goto error;
+        }
+        if (!pre_signed && !(s = sign_jobspec (h, jobspecs[i], &f)))
+            goto error;
+        entry = json_pack ("{s:s s:i s:i}",
+                           "J", s ? s : jobspecs[i],
+                           "urgency", urgency,
+                           "flags", flags);
+        free (s);
+        if (!entry || json_array_append_new (jobs, entry) < 0) {
+            json_decref (entry);
+            goto nomem;
+        }
+    }
+    if (!(f = flux_rpc_pack (h,
+                             "job-ingest.submit-bulk",
+                             FLUX_NODEID_ANY,
+                             0,
+                             "{s:O}",
+                             "jobs", jobs)))
+        goto error;
+    json_decref (jobs);
+    return f;
+nomem:
+    errno = ENOMEM;
+error:
+    saved_errno = errno;
+    json_decref (jobs);
+    errno = saved_errno;
+    return f; // NULL, or a future containing a signing error
+}
+
+int flux_job_submit_bulk_get_id (flux_future_t *f,
+                                 int index,
+                                 flux_jobid_t *jobid,
+                                 const char **errstr)
+{
+    json_t *jobs;
+    json_t *entry;
+    flux_jobid_t id;
+    int errnum;
+    const char *s;
+
+    if (!f || index < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flux_rpc_get_unpack (f, "{s:o}", "jobs", &jobs) < 0)
+        return -1;
+    if (!(entry = json_array_get (jobs, index))) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (json_unpack (entry, "{s:I}", "id", &id) == 0) {
+        if (jobid)
+            *jobid = id;
+        return 0;
+    }
+    if (json_unpack (entry,
+                     "{s:i s:s}",
+                     "errnum", &errnum,
+                     "errstr", &s) < 0
+        || errnum == 0) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (errstr)
+        *errstr = s;
+    errno = errnum;
+    return -1;
+}
+
+int flux_job_submit_bulk_count (flux_future_t *f)
+{
+    json_t *jobs;
+
+    if (!f) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flux_rpc_get_unpack (f, "{s:o}", "jobs", &jobs) < 0)
+        return -1;
+    return json_array_size (jobs);
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
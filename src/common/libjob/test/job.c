@@ -115,6 +115,34 @@ void check_corner_case (void)
     ok (flux_job_submit_get_id (NULL, NULL) < 0 && errno == EINVAL,
         "flux_job_submit_get_id with NULL args fails with EINVAL");
 
+    /* flux_job_submit_bulk */
+
+    const char *jobspecs[] = { "{}", NULL };
+
+    errno = 0;
+    ok (flux_job_submit_bulk (NULL, 1, jobspecs, 0, 0) == NULL
+        && errno == EINVAL,
+        "flux_job_submit_bulk h=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_job_submit_bulk (h, -1, jobspecs, 0, 0) == NULL
+        && errno == EINVAL,
+        "flux_job_submit_bulk njobs=-1 fails with EINVAL");
+    errno = 0;
+    ok (flux_job_submit_bulk (h, 1, NULL, 0, 0) == NULL && errno == EINVAL,
+        "flux_job_submit_bulk jobspecs=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_job_submit_bulk (h, 2, jobspecs, 0, FLUX_JOB_PRE_SIGNED) == NULL
+        && errno == EINVAL,
+        "flux_job_submit_bulk jobspecs[1]=NULL fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_submit_bulk_get_id (NULL, 0, NULL, NULL) < 0
+        && errno == EINVAL,
+        "flux_job_submit_bulk_get_id f=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_job_submit_bulk_count (NULL) < 0 && errno == EINVAL,
+        "flux_job_submit_bulk_count f=NULL fails with EINVAL");
+
     /* flux_job_list */
 
     errno = 0;
@@ -138,6 +138,18 @@ void test_valref (void)
     blobref = treeobj_get_blobref (valref, 1);
     ok (blobref != NULL && !strcmp (blobref, blobrefs[1]),
         "treeobj_get_blobref [1] returns expected blobref");
+    errno = 0;
+    ok (treeobj_truncate_blobrefs (valref, 3) < 0 && errno == EINVAL,
+        "treeobj_truncate_blobrefs count > blobref count fails with EINVAL");
+    errno = 0;
+    ok (treeobj_truncate_blobrefs (valref, -1) < 0 && errno == EINVAL,
+        "treeobj_truncate_blobrefs count=-1 fails with EINVAL");
+    ok (treeobj_truncate_blobrefs (valref, 1) == 0
+        && treeobj_get_count (valref) == 1,
+        "treeobj_truncate_blobrefs count=1 works");
+    blobref = treeobj_get_blobref (valref, 0);
+    ok (blobref != NULL && !strcmp (blobref, blobrefs[0]),
+        "treeobj_get_blobref [0] returns first blobref");
     diag_json (valref);
     json_decref (valref);
 
@@ -383,6 +395,107 @@ void test_dir (void)
     json_decref (dir);
 }
 
+void test_hamt (void)
+{
+    json_t *hamt, *nested, *dir, *dirref, *val, *cpy;
+    json_t *data;
+    const char *blobref = "sha1-508259c0f7fd50e47716b50ad1f0fc6ed46017f9";
+    int index;
+    int count;
+    int i;
+
+    if (!(dir = treeobj_create_dir ())
+        || !(dirref = treeobj_create_dirref (blobref))
+        || !(val = treeobj_create_val ("foo", 4)))
+        BAIL_OUT ("can't continue without test values");
+
+    ok ((hamt = treeobj_create_hamt ()) != NULL,
+        "treeobj_create_hamt works");
+    ok (treeobj_validate (hamt) == 0,
+        "treeobj_validate likes empty hamt");
+    ok (treeobj_is_hamt (hamt) && !treeobj_is_dir (hamt),
+        "treeobj_is_hamt returns true, treeobj_is_dir returns false");
+    ok ((data = treeobj_get_data (hamt)) != NULL && json_is_object (data),
+        "treeobj_get_data returns JSON_OBJECT type");
+    ok (treeobj_get_count (hamt) == 0,
+        "treeobj_get_count returns 0");
+
+    index = treeobj_hamt_index ("foo", 0);
+    ok (index >= 0 && index < TREEOBJ_HAMT_WIDTH
+        && treeobj_hamt_index ("foo", 0) == index,
+        "treeobj_hamt_index returns a stable index in range");
+    count = 0;
+    for (i = 0; i < TREEOBJ_HAMT_MAXLEVEL; i++) {
+        if (treeobj_hamt_index ("foo", i) != treeobj_hamt_index ("bar", i))
+            count++;
+    }
+    ok (count > 0,
+        "treeobj_hamt_index differs for different names at some level");
+    errno = 0;
+    ok (treeobj_hamt_index ("foo", TREEOBJ_HAMT_MAXLEVEL) < 0
+        && errno == EINVAL,
+        "treeobj_hamt_index fails with EINVAL beyond max level");
+
+    ok (treeobj_insert_shard (hamt, 0, dirref) == 0
+        && treeobj_get_shard (hamt, 0) == dirref,
+        "treeobj_insert_shard dirref works");
+    ok (treeobj_insert_shard (hamt, 15, dir) == 0
+        && treeobj_get_shard (hamt, 15) == dir
+        && treeobj_peek_shard (hamt, 15) == dir,
+        "treeobj_insert_shard dir works");
+    if (!(nested = treeobj_create_hamt ()))
+        BAIL_OUT ("treeobj_create_hamt failed");
+    ok (treeobj_insert_shard (hamt, 7, nested) == 0,
+        "treeobj_insert_shard hamt works");
+    json_decref (nested);
+    ok (treeobj_get_count (hamt) == 3 && treeobj_validate (hamt) == 0,
+        "treeobj_get_count returns 3 and hamt is valid");
+    ok ((cpy = treeobj_copy (hamt)) != NULL
+        && treeobj_is_hamt (cpy)
+        && treeobj_get_count (cpy) == 3
+        && treeobj_get_shard (cpy, 0) == dirref,
+        "treeobj_copy makes a shallow copy of hamt");
+    json_decref (cpy);
+    ok (treeobj_delete_shard (hamt, 7) == 0
+        && treeobj_get_count (hamt) == 2,
+        "treeobj_delete_shard works");
+    errno = 0;
+    ok (treeobj_delete_shard (hamt, 7) < 0 && errno == ENOENT,
+        "treeobj_delete_shard fails with ENOENT on missing shard");
+    errno = 0;
+    ok (treeobj_get_shard (hamt, 7) == NULL && errno == ENOENT,
+        "treeobj_get_shard fails with ENOENT on missing shard");
+    errno = 0;
+    ok (treeobj_get_shard (hamt, TREEOBJ_HAMT_WIDTH) == NULL
+        && errno == EINVAL,
+        "treeobj_get_shard fails with EINVAL on bad index");
+    errno = 0;
+    ok (treeobj_insert_shard (hamt, 1, val) < 0 && errno == EINVAL,
+        "treeobj_insert_shard fails with EINVAL on val shard");
+    errno = 0;
+    ok (treeobj_get_shard (dir, 0) == NULL && errno == EINVAL,
+        "treeobj_get_shard fails with EINVAL on dir");
+    errno = 0;
+    ok (treeobj_get_entry (hamt, "foo") == NULL && errno == EINVAL,
+        "treeobj_get_entry fails with EINVAL on hamt");
+
+    ok (json_object_set (data, "g", dirref) == 0
+        && treeobj_validate (hamt) < 0,
+        "treeobj_validate fails on bad shard key");
+    (void)json_object_del (data, "g");
+    ok (json_object_set (data, "1", val) == 0
+        && treeobj_validate (hamt) < 0,
+        "treeobj_validate fails on val shard");
+    (void)json_object_del (data, "1");
+    ok (treeobj_validate (hamt) == 0,
+        "treeobj_validate likes hamt again");
+
+    json_decref (hamt);
+    json_decref (dir);
+    json_decref (dirref);
+    json_decref (val);
+}
+
 void test_dir_peek (void)
 {
     json_t *dir;
@@ -810,6 +923,7 @@ int main(int argc, char** argv)
     test_dirref ();
     test_dir ();
     test_dir_peek ();
+    test_hamt ();
     test_copy ();
     test_deep_copy ();
     test_symlink ();
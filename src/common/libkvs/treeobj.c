@@ -17,6 +17,7 @@
 #include <string.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <jansson.h>
 
 #include "src/common/libccan/ccan/base64/base64.h"
@@ -71,6 +72,31 @@ static int treeobj_peek (const json_t *obj, const char **typep,
     return 0;
 }
 
+static const char shard_digits[] = "0123456789abcdef";
+
+/* hamt shards are keyed by a single lower case hex digit.
+ */
+static int shard_index (const char *key)
+{
+    const char *p;
+
+    if (!key || key[0] == '\0' || key[1] != '\0'
+        || !(p = strchr (shard_digits, key[0])))
+        return -1;
+    return p - shard_digits;
+}
+
+static int shard_key (int index, char key[2])
+{
+    if (index < 0 || index >= TREEOBJ_HAMT_WIDTH) {
+        errno = EINVAL;
+        return -1;
+    }
+    key[0] = shard_digits[index];
+    key[1] = '\0';
+    return 0;
+}
+
 int treeobj_validate (const json_t *obj)
 {
     const json_t *o;
@@ -103,6 +129,21 @@ int treeobj_validate (const json_t *obj)
                 goto inval;
         }
     }
+    else if (!strcmp (type, "hamt")) {
+        const char *key;
+        if (!json_is_object (data))
+            goto inval;
+        json_object_foreach ((json_t *)data, key, o) {
+            if (shard_index (key) < 0)
+                goto inval;
+            if (!treeobj_is_dirref (o)
+                && !treeobj_is_dir (o)
+                && !treeobj_is_hamt (o))
+                goto inval;
+            if (treeobj_validate (o) < 0)
+                goto inval;
+        }
+    }
     else if (!strcmp (type, "symlink")) {
         json_t *o;
         if (!json_is_object (data))
@@ -168,6 +209,12 @@ bool treeobj_is_dirref (const json_t *obj)
     return type && !strcmp (type, "dirref");
 }
 
+bool treeobj_is_hamt (const json_t *obj)
+{
+    const char *type = treeobj_get_type (obj);
+    return type && !strcmp (type, "hamt");
+}
+
 json_t *treeobj_get_data (json_t *obj)
 {
     json_t *data;
@@ -262,7 +309,7 @@ int treeobj_get_count (const json_t *obj)
     if (!strcmp (type, "valref") || !strcmp (type, "dirref")) {
         count = json_array_size (data);
     }
-    else if (!strcmp (type, "dir")) {
+    else if (!strcmp (type, "dir") || !strcmp (type, "hamt")) {
         count = json_object_size (data);
     }
     else if (!strcmp (type, "symlink") || !strcmp (type, "val")) {
@@ -366,6 +413,108 @@ const json_t *treeobj_peek_entry (const json_t *obj, const char *name)
     return obj2;
 }
 
+/* FNV-1a, chosen because shard placement is part of the stored format
+ * and so must never change.
+ */
+static uint32_t hash_name (const char *name)
+{
+    uint32_t hash = 2166136261U;
+
+    while (*name) {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+int treeobj_hamt_index (const char *name, int level)
+{
+    if (!name || level < 0 || level >= TREEOBJ_HAMT_MAXLEVEL) {
+        errno = EINVAL;
+        return -1;
+    }
+    return (hash_name (name) >> (level * 4)) & (TREEOBJ_HAMT_WIDTH - 1);
+}
+
+json_t *treeobj_get_shard (json_t *obj, int index)
+{
+    const char *type;
+    json_t *data, *shard;
+    char key[2];
+
+    if (treeobj_unpack (obj, &type, &data) < 0
+            || strcmp (type, "hamt") != 0
+            || shard_key (index, key) < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(shard = json_object_get (data, key))) {
+        errno = ENOENT;
+        return NULL;
+    }
+    return shard;
+}
+
+const json_t *treeobj_peek_shard (const json_t *obj, int index)
+{
+    const char *type;
+    const json_t *data, *shard;
+    char key[2];
+
+    if (treeobj_peek (obj, &type, &data) < 0
+            || strcmp (type, "hamt") != 0
+            || shard_key (index, key) < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(shard = json_object_get (data, key))) {
+        errno = ENOENT;
+        return NULL;
+    }
+    return shard;
+}
+
+int treeobj_insert_shard (json_t *obj, int index, json_t *shard)
+{
+    const char *type;
+    json_t *data;
+    char key[2];
+
+    if (!shard || treeobj_unpack (obj, &type, &data) < 0
+            || strcmp (type, "hamt") != 0
+            || shard_key (index, key) < 0
+            || (!treeobj_is_dirref (shard)
+                && !treeobj_is_dir (shard)
+                && !treeobj_is_hamt (shard))) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (json_object_set (data, key, shard) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int treeobj_delete_shard (json_t *obj, int index)
+{
+    const char *type;
+    json_t *data;
+    char key[2];
+
+    if (treeobj_unpack (obj, &type, &data) < 0
+            || strcmp (type, "hamt") != 0
+            || shard_key (index, key) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (json_object_del (data, key) < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    return 0;
+}
+
 json_t *treeobj_copy (json_t *obj)
 {
     json_t *data;
@@ -378,10 +527,14 @@ json_t *treeobj_copy (json_t *obj)
         return NULL;
     }
     /* shallow copy of treeobj data and deep copy of treeobj is
-     * identical except for dir object.
+     * identical except for dir and hamt objects.
      */
-    if (treeobj_is_dir (obj)) {
-        if (!(cpy = treeobj_create_dir ()))
+    if (treeobj_is_dir (obj) || treeobj_is_hamt (obj)) {
+        if (treeobj_is_dir (obj))
+            cpy = treeobj_create_dir ();
+        else
+            cpy = treeobj_create_hamt ();
+        if (!cpy)
             return NULL;
 
         if (!(datacpy = json_copy (data))) {
@@ -437,6 +590,28 @@ done:
     return rc;
 }
 
+int treeobj_truncate_blobrefs (json_t *obj, int count)
+{
+    const char *type;
+    json_t *data;
+
+    if (treeobj_unpack (obj, &type, &data) < 0
+        || (strcmp (type, "dirref") != 0
+            && strcmp (type, "valref") != 0)
+        || count < 0
+        || count > json_array_size (data)) {
+        errno = EINVAL;
+        return -1;
+    }
+    while (json_array_size (data) > count) {
+        if (json_array_remove (data, json_array_size (data) - 1) < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
 const char *treeobj_get_blobref (const json_t *obj, int index)
 {
     const json_t *data;
@@ -471,6 +646,19 @@ json_t *treeobj_create_dir (void)
     return obj;
 }
 
+json_t *treeobj_create_hamt (void)
+{
+    json_t *obj;
+
+    if (!(obj = json_pack ("{s:i s:s s:{}}", "ver", treeobj_version,
+                                            "type", "hamt",
+                                            "data"))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return obj;
+}
+
 json_t *treeobj_create_symlink (const char *ns, const char *target)
 {
     json_t *data, *obj;
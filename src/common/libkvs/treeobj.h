@@ -28,6 +28,7 @@ json_t *treeobj_create_val (const void *data, int len);
 json_t *treeobj_create_valref (const char *blobref);
 json_t *treeobj_create_dir (void);
 json_t *treeobj_create_dirref (const char *blobref);
+json_t *treeobj_create_hamt (void);
 
 /* Validate treeobj, recursively.
  * Return 0 if valid, -1 with errno = EINVAL if invalid.
@@ -45,10 +46,12 @@ bool treeobj_is_val (const json_t *obj);
 bool treeobj_is_valref (const json_t *obj);
 bool treeobj_is_dir (const json_t *obj);
 bool treeobj_is_dirref (const json_t *obj);
+bool treeobj_is_hamt (const json_t *obj);
 
 /* get type-specific value.
  * For dirref/valref, this is an array of blobrefs.
  * For directory, this is dictionary of treeobjs
+ * For hamt, this is a dictionary of shards indexed by hex digit
  * For symlink, this is an object with optinoal namespace and target.
  * For val this is string containing base64-encoded data.
  * Return JSON object on success, NULL on error with errno = EINVAL.
@@ -72,6 +75,7 @@ int treeobj_decode_val (const json_t *obj, void **data, int *len);
 /* get type-specific count.
  * For dirref/valref, this is the number of blobrefs.
  * For directory, this is number of entries
+ * For hamt, this is the number of shards (not entries)
  * For symlink or val, this is 1.
  * Return count on success, -1 on error with errno = EINVAL.
  */
@@ -101,10 +105,32 @@ int treeobj_insert_entry_novalidate (json_t *obj,
  */
 const json_t *treeobj_peek_entry (const json_t *obj, const char *name);
 
+/* Sharded directories
+ * A hamt (hash array mapped trie) is a directory whose entries are spread
+ * over up to TREEOBJ_HAMT_WIDTH shards by a 32 bit hash of the entry name.
+ * At nesting level N, the shard index is the Nth 4 bit digit of the hash.
+ * Each shard is a dirref to either a dir holding the entries, or to a
+ * nested hamt at the next level.  Within the KVS, dir and hamt shards
+ * may appear in place of dirrefs while a transaction is being applied.
+ *
+ * treeobj_hamt_index() returns the shard index for 'name' at 'level',
+ * or -1 with errno = EINVAL if level >= TREEOBJ_HAMT_MAXLEVEL.
+ * get/peek/insert/delete shard behave like the entry functions above.
+ */
+#define TREEOBJ_HAMT_WIDTH      16
+#define TREEOBJ_HAMT_MAXLEVEL   8
+
+int treeobj_hamt_index (const char *name, int level);
+json_t *treeobj_get_shard (json_t *obj, int index);
+const json_t *treeobj_peek_shard (const json_t *obj, int index);
+int treeobj_insert_shard (json_t *obj, int index, json_t *shard);
+int treeobj_delete_shard (json_t *obj, int index);
+
 /* Shallow copy a treeobj
  * Note that this is not a shallow copy on the json object, but is a
  * shallow copy on the data within a tree object.  For example, for a
  * dir object, the first level of directory entries will be copied.
+ * Similarly, for a hamt object, the first level of shards is copied.
  */
 json_t *treeobj_copy (json_t *obj);
 
@@ -116,6 +142,13 @@ json_t *treeobj_deep_copy (const json_t *obj);
  */
 int treeobj_append_blobref (json_t *obj, const char *blobref);
 
+/* remove all but the first 'count' blobrefs from dirref,valref object.
+ * If 'count' is 0, treeobj_append_blobref() must be called before the
+ * object is valid again.
+ * Return 0 on success, -1 on failure with errno set.
+ */
+int treeobj_truncate_blobrefs (json_t *obj, int count);
+
 /* get blobref entry at 'index'.
  * Return blobref on success, NULL on failure with errno set.
  */
@@ -17,12 +17,14 @@
 #include <assert.h>
 #include <errno.h>
 #include <string.h>
+#include <limits.h>
 #include <jansson.h>
 
 #include "src/common/libidset/idset.h"
 #include "src/common/libhostlist/hostlist.h"
 #include "src/common/libczmqcontainers/czmq_containers.h"
 #include "src/common/libutil/errprintf.h"
+#include "src/common/libutil/veb.h"
 
 #include "rnode.h"
 #include "match.h"
@@ -80,6 +82,164 @@ static void rank_hash_purge (struct rlist *rl)
     zhashx_purge (rl->rank_index);
 }
 
+/*  Index of nodes by available core count.
+ *
+ *  Every node is stored in a van Emde Boas tree under the key
+ *   (avail * nnodes + pos), where avail is rnode_avail() (0 for down nodes)
+ *   and pos is the position of the node in rank order. Successor and
+ *   predecessor queries then find the node with the fewest or most
+ *   available cores, ties broken by rank, without sorting the node list.
+ *
+ *  The index is built on first use and kept current as cores are
+ *   allocated and freed and nodes are marked up or down. Any change to
+ *   the set of nodes, their ranks, or their core counts invalidates it.
+ */
+struct avail_index {
+    Veb T;
+    unsigned int nnodes;
+    unsigned int maxavail;
+    struct rnode **nodes;   /* nodes in rank order */
+    unsigned int *keys;     /* current key of each node */
+};
+
+static int by_rank_ptr (const void *item1, const void *item2)
+{
+    return by_rank (*(struct rnode **)item1, *(struct rnode **)item2);
+}
+
+static void avail_index_destroy (struct avail_index *idx)
+{
+    if (idx) {
+        int saved_errno = errno;
+        free (idx->T.D);
+        free (idx->nodes);
+        free (idx->keys);
+        free (idx);
+        errno = saved_errno;
+    }
+}
+
+static struct avail_index *avail_index_create (struct rlist *rl)
+{
+    struct avail_index *idx;
+    struct rnode *n;
+    unsigned long long size;
+    unsigned int i = 0;
+
+    if (!(idx = calloc (1, sizeof (*idx))))
+        return NULL;
+    idx->nnodes = zlistx_size (rl->nodes);
+    if (!(idx->nodes = calloc (idx->nnodes + 1, sizeof (*idx->nodes)))
+        || !(idx->keys = calloc (idx->nnodes + 1, sizeof (*idx->keys))))
+        goto error;
+    n = zlistx_first (rl->nodes);
+    while (n) {
+        idx->nodes[i++] = n;
+        if (rnode_count (n) > idx->maxavail)
+            idx->maxavail = rnode_count (n);
+        n = zlistx_next (rl->nodes);
+    }
+    qsort (idx->nodes, idx->nnodes, sizeof (*idx->nodes), by_rank_ptr);
+
+    size = (unsigned long long) (idx->maxavail + 1) * idx->nnodes;
+    if (size >= UINT_MAX) {
+        errno = EOVERFLOW;
+        goto error;
+    }
+    /*  vebnew() requires a universe of at least 2 */
+    idx->T = vebnew (size < 2 ? 2 : size, 0);
+    if (!idx->T.D)
+        goto error;
+    for (i = 0; i < idx->nnodes; i++) {
+        idx->keys[i] = rnode_avail (idx->nodes[i]) * idx->nnodes + i;
+        vebput (idx->T, idx->keys[i]);
+    }
+    return idx;
+error:
+    avail_index_destroy (idx);
+    return NULL;
+}
+
+/*  Return the position of node 'n' in the index, or -1 if not found.
+ */
+static int avail_index_pos (struct avail_index *idx, struct rnode *n)
+{
+    int lo = 0;
+    int hi = idx->nnodes - 1;
+
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        struct rnode *x = idx->nodes[mid];
+        if (x->rank == n->rank)
+            return x == n ? mid : -1;
+        if (x->rank < n->rank)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return -1;
+}
+
+/*  Return the key of the lowest ranked node with the fewest available
+ *   cores not less than 'min', or T.M if there is none.
+ */
+static unsigned int avail_index_least (struct avail_index *idx,
+                                       unsigned int min)
+{
+    if (min > idx->maxavail)
+        return idx->T.M;
+    return vebsucc (idx->T, min * idx->nnodes);
+}
+
+/*  Return the key of the lowest ranked node with the most available
+ *   cores among keys less than 'below', or T.M if there is none.
+ */
+static unsigned int avail_index_most (struct avail_index *idx,
+                                      unsigned int below)
+{
+    unsigned int key;
+
+    if (below == 0 || (key = vebpred (idx->T, below - 1)) == idx->T.M)
+        return idx->T.M;
+    return vebsucc (idx->T, key - key % idx->nnodes);
+}
+
+static void rlist_index_invalidate (struct rlist *rl)
+{
+    avail_index_destroy (rl->avail_index);
+    rl->avail_index = NULL;
+}
+
+static struct avail_index *rlist_index_get (struct rlist *rl)
+{
+    if (!rl->avail_index)
+        rl->avail_index = avail_index_create (rl);
+    return rl->avail_index;
+}
+
+/*  Update the index after the available cores of node 'n' have changed.
+ */
+static void rlist_index_update (struct rlist *rl, struct rnode *n)
+{
+    struct avail_index *idx = rl->avail_index;
+    unsigned int key;
+    int pos;
+
+    if (!idx)
+        return;
+    if ((pos = avail_index_pos (idx, n)) < 0
+        || rnode_avail (n) > idx->maxavail) {
+        rlist_index_invalidate (rl);
+        return;
+    }
+    key = rnode_avail (n) * idx->nnodes + pos;
+    if (key != idx->keys[pos]) {
+        vebdel (idx->T, idx->keys[pos]);
+        vebput (idx->T, key);
+        idx->keys[pos] = key;
+    }
+}
+
 static int
 sprintfcat (char **s, size_t *sz, size_t *lenp, const char *fmt, ...)
 {
@@ -112,6 +272,7 @@ void rlist_destroy (struct rlist *rl)
         zlistx_destroy (&rl->nodes);
         zhashx_destroy (&rl->noremap);
         zhashx_destroy (&rl->rank_index);
+        avail_index_destroy (rl->avail_index);
         json_decref (rl->scheduling);
         free (rl);
         errno = saved_errno;
@@ -190,6 +351,7 @@ static int rlist_add_rnode_new (struct rlist *rl, struct rnode *n)
     if (rank_hash_insert (rl, n) < 0)
         return -1;
     rlist_update_totals (rl, n);
+    rlist_index_invalidate (rl);
     return 0;
 }
 
@@ -204,6 +366,7 @@ static int rlist_add_rnode (struct rlist *rl, struct rnode *n)
         if (rnode_add (found, n) < 0)
             return -1;
         rlist_update_totals (rl, n);
+        rlist_index_invalidate (rl);
         rnode_destroy (n);
     }
     else if (rlist_add_rnode_new (rl, n) < 0)
@@ -398,6 +561,7 @@ static int rlist_remove_rank (struct rlist *rl, int rank)
         return -1;
     }
     zlistx_delete (rl->nodes, handle);
+    rlist_index_invalidate (rl);
     return 0;
 }
 
@@ -420,6 +584,7 @@ int rlist_remap (struct rlist *rl)
     struct rnode *n;
 
     rank_hash_purge (rl);
+    rlist_index_invalidate (rl);
 
     /*   Sort list by ascending rank, then rerank starting at 0
      */
@@ -501,6 +666,7 @@ int rlist_rerank (struct rlist *rl, const char *hosts, flux_error_t *errp)
     }
 
     rank_hash_purge (rl);
+    rlist_index_invalidate (rl);
 
     /* Save original rank mapping in case of undo
      */
@@ -527,6 +693,7 @@ static struct rnode *rlist_detach_rank (struct rlist *rl, uint32_t rank)
     if (n) {
         zlistx_detach (rl->nodes, zlistx_find (rl->nodes, n));
         rank_hash_delete (rl, rank);
+        rlist_index_invalidate (rl);
     }
     return n;
 }
@@ -1795,6 +1962,7 @@ static int rlist_rnode_alloc (struct rlist *rl, struct rnode *n,
     if (!n || rnode_alloc (n, count, idsetp) < 0)
         return -1;
     rl->avail -= idset_count (*idsetp);
+    rlist_index_update (rl, n);
     return 0;
 }
 
@@ -1871,28 +2039,96 @@ unwind:
     return result;
 }
 
+/*
+ *  Allocate `slots` of size cores_per_slot from rlist `rl`, visiting
+ *   nodes in the same order as rlist_alloc_first_fit() would after sorting
+ *   with by_avail (worst_fit = false) or by_used (worst_fit = true), but
+ *   using the avail index to skip nodes that cannot hold a slot.
+ *
+ *  Each node is filled before moving on, which leaves it with fewer than
+ *   cores_per_slot available and thus below any key still to be visited.
+ */
+static struct rlist *rlist_alloc_indexed (struct rlist *rl,
+                                          struct avail_index *idx,
+                                          int cores_per_slot,
+                                          int slots,
+                                          bool worst_fit)
+{
+    struct rlist *result = NULL;
+    unsigned int min = cores_per_slot;
+    unsigned int key;
+
+    if (!(result = rlist_create ()))
+        return NULL;
+
+    if (worst_fit)
+        key = avail_index_most (idx, idx->T.M);
+    else
+        key = avail_index_least (idx, min);
+
+    while (slots && key < idx->T.M && key / idx->nnodes >= min) {
+        struct rnode *n = idx->nodes[key % idx->nnodes];
+        unsigned int avail = key / idx->nnodes;
+
+        while (slots && rnode_avail (n) >= min) {
+            struct idset *ids = NULL;
+            int rc;
+
+            if (rlist_rnode_alloc (rl, n, cores_per_slot, &ids) < 0)
+                goto unwind;
+            rc = rlist_append_cores (result, n->hostname, n->rank, ids);
+            idset_destroy (ids);
+            if (rc < 0)
+                goto unwind;
+            slots--;
+        }
+        /*  Next node with the same avail count, or for worst fit, the
+         *   first node with the next lower avail count.
+         */
+        key = vebsucc (idx->T, key + 1);
+        if (worst_fit && key >= (avail + 1) * idx->nnodes)
+            key = avail_index_most (idx, avail * idx->nnodes);
+    }
+    if (slots != 0) {
+unwind:
+        rlist_free (rl, result);
+        rlist_destroy (result);
+        errno = ENOSPC;
+        return NULL;
+    }
+    return result;
+}
+
 /*
  *  Allocate `slots` of size cores_per_slot from rlist `rl` and return
- *   the result. Sorts the node list by smallest available first, so that
+ *   the result. Uses nodes with smallest available first, so that
  *   we get something like "best fit". (minimize nodes used)
  */
 static struct rlist * rlist_alloc_best_fit (struct rlist *rl,
                                             int cores_per_slot,
                                             int slots)
 {
+    struct avail_index *idx;
+
+    if ((idx = rlist_index_get (rl)))
+        return rlist_alloc_indexed (rl, idx, cores_per_slot, slots, false);
     zlistx_set_comparator (rl->nodes, by_avail);
     return rlist_alloc_first_fit (rl, cores_per_slot, slots);
 }
 
 /*
  *  Allocate `slots` of size cores_per_slot from rlist `rl` and return
- *   the result. Sorts the node list by least utilized first, so that
+ *   the result. Uses least utilized nodes first, so that
  *   we get something like "worst fit". (Spread jobs across nodes)
  */
 static struct rlist * rlist_alloc_worst_fit (struct rlist *rl,
                                              int cores_per_slot,
                                              int slots)
 {
+    struct avail_index *idx;
+
+    if ((idx = rlist_index_get (rl)))
+        return rlist_alloc_indexed (rl, idx, cores_per_slot, slots, true);
     zlistx_set_comparator (rl->nodes, by_used);
     return rlist_alloc_first_fit (rl, cores_per_slot, slots);
 }
@@ -1971,6 +2207,7 @@ static struct rlist *rlist_alloc_nnodes (struct rlist *rl,
                 goto unwind;
             }
             rnode_alloc_idset (n, n->cores->ids);
+            rlist_index_update (rl, n);
             nleft--;
             n = zlistx_next (rl->nodes);
         }
@@ -2205,6 +2442,7 @@ static int rlist_free_rnode (struct rlist *rl, struct rnode *n)
         return -1;
     if (rnode->up)
         rl->avail += idset_count (n->cores->ids);
+    rlist_index_update (rl, rnode);
     return 0;
 }
 
@@ -2219,6 +2457,7 @@ static int rlist_alloc_rnode (struct rlist *rl, struct rnode *n)
         return -1;
     if (rnode->up)
         rl->avail -= idset_count (n->cores->avail);
+    rlist_index_update (rl, rnode);
     return 0;
 }
 
@@ -2303,6 +2542,7 @@ static int rlist_mark_all (struct rlist *rl, bool up)
         if (n->up != up)
             count += idset_count (n->cores->avail);
         n->up = up;
+        rlist_index_update (rl, n);
         n = zlistx_next (rl->nodes);
     }
     return count;
@@ -2321,6 +2561,7 @@ static int rlist_mark_state (struct rlist *rl, bool up, const char *ids)
         if (n->up != up)
             count += idset_count (n->cores->avail);
         n->up = up;
+        rlist_index_update (rl, n);
         i = idset_next (idset, i);
     }
     idset_destroy (idset);
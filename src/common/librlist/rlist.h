@@ -30,6 +30,11 @@ struct rlist {
 
     zhashx_t *rank_index;
 
+    /*  Index of nodes by available core count, built on demand by
+     *   the best-fit and worst-fit allocators
+     */
+    struct avail_index *avail_index;
+
     /*  hash of resources to ignore on remap */
     zhashx_t *noremap;
 
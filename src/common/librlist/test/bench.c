@@ -0,0 +1,162 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* rlist-bench - time rlist_alloc()/rlist_free() on a synthetic R
+ *
+ * Usage: rlist-bench [NNODES] [NCORES] [NALLOCS]
+ *
+ * Builds an R with NNODES nodes of NCORES cores (default 16384 x 64),
+ * then for each allocation mode runs NALLOCS allocations of random size,
+ * freeing the oldest outstanding allocations whenever the instance is
+ * full, so that the node list stays fragmented as on a busy system.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/tstat.h"
+#include "rlist.h"
+
+#define MAX_OUTSTANDING 4096
+
+static char *R_create (int nnodes, int ncores)
+{
+    char ranks[64];
+    char cores[64];
+    json_t *o;
+    char *s;
+
+    snprintf (ranks, sizeof (ranks), "0-%d", nnodes - 1);
+    snprintf (cores, sizeof (cores), "0-%d", ncores - 1);
+    if (!(o = json_pack ("{s:i s:{s:[{s:s s:{s:s}}]}}",
+                         "version", 1,
+                         "execution",
+                           "R_lite",
+                             "rank", ranks,
+                             "children", "core", cores))
+        || !(s = json_dumps (o, JSON_COMPACT)))
+        log_msg_exit ("failed to create R");
+    json_decref (o);
+    return s;
+}
+
+static void free_oldest (struct rlist *rl,
+                         struct rlist **allocs,
+                         int *head,
+                         int *count,
+                         tstat_t *ts)
+{
+    struct timespec t0;
+
+    monotime (&t0);
+    if (rlist_free (rl, allocs[*head]) < 0)
+        log_err_exit ("rlist_free");
+    tstat_push (ts, monotime_since (t0));
+    rlist_destroy (allocs[*head]);
+    allocs[*head] = NULL;
+    *head = (*head + 1) % MAX_OUTSTANDING;
+    (*count)--;
+}
+
+static void bench (const char *R, const char *mode, int nallocs, int ncores)
+{
+    struct rlist *rl;
+    struct rlist *allocs[MAX_OUTSTANDING] = { 0 };
+    int head = 0;
+    int count = 0;
+    int failed = 0;
+    tstat_t ts_alloc = { 0 };
+    tstat_t ts_free = { 0 };
+    struct timespec t0;
+    int i;
+
+    if (!(rl = rlist_from_R (R)))
+        log_err_exit ("rlist_from_R");
+
+    srand (42);
+    for (i = 0; i < nallocs; i++) {
+        struct rlist_alloc_info ai = {
+            .mode = mode,
+            .slot_size = 1 + rand () % ncores,
+            .nslots = 1 + rand () % 8,
+        };
+        flux_error_t error;
+        struct rlist *result;
+
+        if (count == MAX_OUTSTANDING)
+            free_oldest (rl, allocs, &head, &count, &ts_free);
+
+        monotime (&t0);
+        result = rlist_alloc (rl, &ai, &error);
+        tstat_push (&ts_alloc, monotime_since (t0));
+
+        while (!result && errno == ENOSPC && count > 0) {
+            free_oldest (rl, allocs, &head, &count, &ts_free);
+            monotime (&t0);
+            result = rlist_alloc (rl, &ai, &error);
+            tstat_push (&ts_alloc, monotime_since (t0));
+        }
+        if (!result) {
+            failed++;
+            continue;
+        }
+        allocs[(head + count) % MAX_OUTSTANDING] = result;
+        count++;
+    }
+    while (count > 0)
+        free_oldest (rl, allocs, &head, &count, &ts_free);
+
+    printf ("%-10s alloc: n=%d mean=%.3fms max=%.3fms"
+            " free: n=%d mean=%.3fms failed=%d\n",
+            mode,
+            tstat_count (&ts_alloc),
+            tstat_mean (&ts_alloc),
+            tstat_max (&ts_alloc),
+            tstat_count (&ts_free),
+            tstat_mean (&ts_free),
+            failed);
+    rlist_destroy (rl);
+}
+
+int main (int argc, char *argv[])
+{
+    const char *modes[] = { "worst-fit", "best-fit", "first-fit", NULL };
+    int nnodes = argc > 1 ? strtol (argv[1], NULL, 10) : 16384;
+    int ncores = argc > 2 ? strtol (argv[2], NULL, 10) : 64;
+    int nallocs = argc > 3 ? strtol (argv[3], NULL, 10) : 10000;
+    char *R;
+    int i;
+
+    log_init ("rlist-bench");
+
+    if (argc > 4 || nnodes <= 0 || ncores <= 0 || nallocs <= 0)
+        log_msg_exit ("Usage: rlist-bench [NNODES] [NCORES] [NALLOCS]");
+
+    R = R_create (nnodes, ncores);
+    printf ("%d nodes, %d cores/node, %d allocations\n",
+            nnodes,
+            ncores,
+            nallocs);
+    for (i = 0; modes[i] != NULL; i++)
+        bench (R, modes[i], nallocs, ncores);
+    free (R);
+    return 0;
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
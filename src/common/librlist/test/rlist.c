@@ -2079,6 +2079,76 @@ static void test_issue4290 (void)
     free (R);
 }
 
+static struct rlist *avail_alloc (struct rlist *rl,
+                                  const char *mode,
+                                  int nslots,
+                                  int slot_size,
+                                  const char *expected)
+{
+    struct rlist *a;
+    char *s = NULL;
+
+    a = rl_alloc (rl, mode, 0, nslots, slot_size, 0);
+    if (a)
+        s = rlist_dumps (a);
+    ok (a != NULL && s != NULL && strcmp (s, expected) == 0,
+        "avail_index: %s %dx%d got %s", mode, nslots, slot_size,
+        s ? s : strerror (errno));
+    free (s);
+    return a;
+}
+
+static void test_avail_index (void)
+{
+    char *R;
+    struct rlist *rl;
+    struct rlist *a[8];
+    struct rlist_alloc_info ai = {
+        .mode = "worst-fit",
+        .nslots = 1,
+        .slot_size = 2,
+    };
+    flux_error_t error;
+    int i;
+
+    if (!(R = R_create_num (4, 4)) || !(rl = rlist_from_R (R)))
+        BAIL_OUT ("avail_index: failed to create rlist");
+
+    a[0] = avail_alloc (rl, "best-fit", 1, 3, "rank0/core[0-2]");
+    a[1] = avail_alloc (rl, "best-fit", 1, 1, "rank0/core3");
+    a[2] = avail_alloc (rl, "worst-fit", 1, 2, "rank1/core[0-1]");
+    a[3] = avail_alloc (rl, "worst-fit", 1, 2, "rank2/core[0-1]");
+
+    ok (rlist_free (rl, a[0]) == 0,
+        "avail_index: rlist_free works");
+    rlist_destroy (a[0]);
+    a[0] = avail_alloc (rl, "best-fit", 1, 2, "rank1/core[2-3]");
+
+    ok (rlist_mark_down (rl, "2") == 0,
+        "avail_index: mark rank 2 down");
+    a[4] = avail_alloc (rl, "best-fit", 1, 2, "rank0/core[0-1]");
+    ok (rlist_mark_up (rl, "2") == 0,
+        "avail_index: mark rank 2 up");
+    a[5] = avail_alloc (rl, "worst-fit", 1, 3, "rank3/core[0-2]");
+    a[6] = avail_alloc (rl, "worst-fit", 2, 1, "rank2/core[2-3]");
+
+    a[7] = rlist_alloc (rl, &ai, &error);
+    ok (a[7] == NULL && errno == ENOSPC,
+        "avail_index: worst-fit fails with ENOSPC when no node fits");
+
+    for (i = 0; i < 7; i++) {
+        if (a[i] && rlist_free (rl, a[i]) < 0)
+            BAIL_OUT ("avail_index: rlist_free failed");
+        rlist_destroy (a[i]);
+    }
+    ok (rl->avail == 16,
+        "avail_index: all cores available after free");
+    a[0] = avail_alloc (rl, "best-fit", 4, 4, "rank[0-3]/core[0-3]");
+    rlist_destroy (a[0]);
+    rlist_destroy (rl);
+    free (R);
+}
+
 static void test_rlist_config_inval (void)
 {
     flux_error_t error;
@@ -2138,6 +2208,7 @@ int main (int ac, char *av[])
     test_issue4184 ();
     test_properties ();
     test_issue4290 ();
+    test_avail_index ();
     test_rlist_config_inval ();
 
     done_testing ();
@@ -42,13 +42,22 @@
  * - sendfd/recvfd do not encrypt messages, therefore this transport
  *   is only appropriate for use on AF_LOCAL sockets or on file descriptors
  *   tunneled through a secure channel.
+ *
+ * - sendio/recvio apply the same encoding to any byte stream, given a
+ *   read(2) or write(2) like function.  The shared memory rings in shmring.c
+ *   use them.
+ *
+ * - sendfd_rights/recvfd_rights pass file descriptors along with a message
+ *   over an AF_LOCAL socket.  They are used for connection setup only.
  */
 
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <sys/socket.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <poll.h>
 #include <flux/core.h>
 
 #include "sendfd.h"
@@ -67,35 +76,46 @@ void iobuf_clean (struct iobuf *iobuf)
     memset (iobuf, 0, sizeof (*iobuf));
 }
 
-int sendfd (int fd, const flux_msg_t *msg, struct iobuf *iobuf)
+static int iobuf_encode (struct iobuf *io, const flux_msg_t *msg)
+{
+    ssize_t s;
+
+    if ((s = flux_msg_encode_size (msg)) < 0)
+        return -1;
+    io->size = s + 8;
+    if (io->size <= sizeof (io->buf_fixed))
+        io->buf = io->buf_fixed;
+    else if (!(io->buf = malloc (io->size)))
+        return -1;
+    *(uint32_t *)&io->buf[0] = IOBUF_MAGIC;
+    *(uint32_t *)&io->buf[4] = htonl (io->size - 8);
+    if (flux_msg_encode (msg, &io->buf[8], io->size - 8) < 0)
+        return -1;
+    io->done = 0;
+    return 0;
+}
+
+int sendio (iobuf_io_f writefn,
+            void *arg,
+            const flux_msg_t *msg,
+            struct iobuf *iobuf)
 {
     struct iobuf local;
     struct iobuf *io = iobuf ? iobuf : &local;
     int rc = -1;
 
-    if (fd < 0 || !msg) {
+    if (!writefn || !msg) {
         errno = EINVAL;
         return -1;
     }
     if (!iobuf)
         iobuf_init (&local);
     if (!io->buf) {
-        ssize_t s;
-        if ((s = flux_msg_encode_size (msg)) < 0)
+        if (iobuf_encode (io, msg) < 0)
             goto done;
-        io->size = s + 8;
-        if (io->size <= sizeof (io->buf_fixed))
-            io->buf = io->buf_fixed;
-        else if (!(io->buf = malloc (io->size)))
-            goto done;
-        *(uint32_t *)&io->buf[0] = IOBUF_MAGIC;
-        *(uint32_t *)&io->buf[4] = htonl (io->size - 8);
-        if (flux_msg_encode (msg, &io->buf[8], io->size - 8) < 0)
-            goto done;
-        io->done = 0;
     }
     do {
-        rc = write (fd, io->buf + io->done, io->size - io->done);
+        rc = writefn (arg, io->buf + io->done, io->size - io->done);
         if (rc < 0)
             goto done;
         io->done += rc;
@@ -113,14 +133,14 @@ done:
     return rc;
 }
 
-flux_msg_t *recvfd (int fd, struct iobuf *iobuf)
+flux_msg_t *recvio (iobuf_io_f readfn, void *arg, struct iobuf *iobuf)
 {
     struct iobuf local;
     struct iobuf *io = iobuf ? iobuf : &local;
     flux_msg_t *msg = NULL;
     int rc = -1;
 
-    if (fd < 0) {
+    if (!readfn) {
         errno = EINVAL;
         return NULL;
     }
@@ -132,7 +152,7 @@ flux_msg_t *recvfd (int fd, struct iobuf *iobuf)
     }
     do {
         if (io->done < 8) {
-            rc = read (fd, io->buf + io->done, 8 - io->done);
+            rc = readfn (arg, io->buf + io->done, 8 - io->done);
             if (rc < 0)
                 goto done;
             if (rc == 0) {
@@ -154,7 +174,7 @@ flux_msg_t *recvfd (int fd, struct iobuf *iobuf)
             }
         }
         if (io->done >= 8 && io->done < io->size) {
-            rc = read (fd, io->buf + io->done, io->size - io->done);
+            rc = readfn (arg, io->buf + io->done, io->size - io->done);
             if (rc < 0)
                 goto done;
             if (rc == 0) {
@@ -178,6 +198,191 @@ done:
     return msg;
 }
 
+static ssize_t fd_write (void *arg, void *buf, size_t size)
+{
+    return write (*(int *)arg, buf, size);
+}
+
+static ssize_t fd_read (void *arg, void *buf, size_t size)
+{
+    return read (*(int *)arg, buf, size);
+}
+
+int sendfd (int fd, const flux_msg_t *msg, struct iobuf *iobuf)
+{
+    if (fd < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return sendio (fd_write, &fd, msg, iobuf);
+}
+
+flux_msg_t *recvfd (int fd, struct iobuf *iobuf)
+{
+    if (fd < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return recvio (fd_read, &fd, iobuf);
+}
+
+int sendfd_rights (int fd, const flux_msg_t *msg, const int *fds, int nfds)
+{
+    struct iobuf io;
+    struct msghdr mh = { 0 };
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    union {
+        char buf[CMSG_SPACE (sizeof (int) * SENDFD_MAX_RIGHTS)];
+        struct cmsghdr align;
+    } u;
+    ssize_t n;
+    int rc = -1;
+
+    if (fd < 0 || !msg || !fds || nfds < 1 || nfds > SENDFD_MAX_RIGHTS) {
+        errno = EINVAL;
+        return -1;
+    }
+    iobuf_init (&io);
+    if (iobuf_encode (&io, msg) < 0)
+        goto done;
+    iov.iov_base = io.buf;
+    iov.iov_len = io.size;
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = u.buf;
+    mh.msg_controllen = CMSG_SPACE (sizeof (int) * nfds);
+    cmsg = CMSG_FIRSTHDR (&mh);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (int) * nfds);
+    memcpy (CMSG_DATA (cmsg), fds, sizeof (int) * nfds);
+    if ((n = sendmsg (fd, &mh, MSG_NOSIGNAL)) < 0)
+        goto done;
+    io.done = n;
+    while (io.done < io.size) {
+        if ((n = write (fd, io.buf + io.done, io.size - io.done)) < 0)
+            goto done;
+        io.done += n;
+    }
+    rc = 0;
+done:
+    iobuf_clean (&io);
+    return rc;
+}
+
+/* Read up to 'size' bytes from 'fd' with recvmsg(2), polling if the
+ * socket is non-blocking, and collect any file descriptors that arrive.
+ */
+static ssize_t recv_rights (int fd,
+                            void *buf,
+                            size_t size,
+                            int *fds,
+                            int maxfds,
+                            int *nfds)
+{
+    struct msghdr mh = { 0 };
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    union {
+        char buf[CMSG_SPACE (sizeof (int) * SENDFD_MAX_RIGHTS)];
+        struct cmsghdr align;
+    } u;
+    ssize_t n;
+
+    iov.iov_base = buf;
+    iov.iov_len = size;
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = u.buf;
+    mh.msg_controllen = sizeof (u.buf);
+    while ((n = recvmsg (fd, &mh, MSG_CMSG_CLOEXEC)) < 0) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            return -1;
+        if (poll (&pfd, 1, -1) < 0)
+            return -1;
+    }
+    for (cmsg = CMSG_FIRSTHDR (&mh);
+         cmsg != NULL;
+         cmsg = CMSG_NXTHDR (&mh, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int count = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+            int i;
+            for (i = 0; i < count; i++) {
+                int rfd;
+                memcpy (&rfd, CMSG_DATA (cmsg) + i * sizeof (int), sizeof (rfd));
+                if (*nfds < maxfds)
+                    fds[(*nfds)++] = rfd;
+                else
+                    (void)close (rfd);
+            }
+        }
+    }
+    if (n == 0) {
+        errno = ECONNRESET;
+        return -1;
+    }
+    return n;
+}
+
+flux_msg_t *recvfd_rights (int fd, int *fds, int *nfds)
+{
+    struct iobuf io;
+    flux_msg_t *msg = NULL;
+    int maxfds;
+    ssize_t n;
+
+    if (fd < 0 || !fds || !nfds || *nfds < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    maxfds = *nfds;
+    *nfds = 0;
+    iobuf_init (&io);
+    io.buf = io.buf_fixed;
+    while (io.done < 8) {
+        if ((n = recv_rights (fd,
+                              io.buf + io.done,
+                              8 - io.done,
+                              fds,
+                              maxfds,
+                              nfds)) < 0)
+            goto done;
+        io.done += n;
+    }
+    if (*(uint32_t *)&io.buf[0] != IOBUF_MAGIC) {
+        errno = EPROTO;
+        goto done;
+    }
+    io.size = ntohl (*(uint32_t *)&io.buf[4]) + 8;
+    if (io.size > sizeof (io.buf_fixed)) {
+        if (!(io.buf = malloc (io.size)))
+            goto done;
+        memcpy (io.buf, io.buf_fixed, 8);
+    }
+    while (io.done < io.size) {
+        if ((n = recv_rights (fd,
+                              io.buf + io.done,
+                              io.size - io.done,
+                              fds,
+                              maxfds,
+                              nfds)) < 0)
+            goto done;
+        io.done += n;
+    }
+    msg = flux_msg_decode (io.buf + 8, io.size - 8);
+done:
+    if (!msg) {
+        int saved_errno = errno;
+        while (*nfds > 0)
+            (void)close (fds[--(*nfds)]);
+        errno = saved_errno;
+    }
+    iobuf_clean (&io);
+    return msg;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -32,6 +32,32 @@ int sendfd (int fd, const flux_msg_t *msg, struct iobuf *iobuf);
  */
 flux_msg_t *recvfd (int fd, struct iobuf *iobuf);
 
+/* Like sendfd() and recvfd(), but call 'fn' to write or read 'size' bytes
+ * of the encoded message, as write(2) or read(2) would.
+ */
+typedef ssize_t (*iobuf_io_f)(void *arg, void *buf, size_t size);
+
+int sendio (iobuf_io_f writefn,
+            void *arg,
+            const flux_msg_t *msg,
+            struct iobuf *iobuf);
+flux_msg_t *recvio (iobuf_io_f readfn, void *arg, struct iobuf *iobuf);
+
+/* Send message with file descriptors attached (SCM_RIGHTS) to AF_LOCAL
+ * socket 'fd'.  This is meant for small messages on an otherwise idle
+ * socket:  if the message cannot be written immediately, it fails with
+ * EAGAIN and the stream is left in an undefined state.
+ */
+#define SENDFD_MAX_RIGHTS 8
+int sendfd_rights (int fd, const flux_msg_t *msg, const int *fds, int nfds);
+
+/* Receive message with file descriptors attached, polling as needed if
+ * 'fd' is non-blocking.  On entry, '*nfds' is the size of the 'fds' array.
+ * On success it is set to the number of descriptors received, which the
+ * caller must close.  Extra descriptors are closed.
+ */
+flux_msg_t *recvfd_rights (int fd, int *fds, int *nfds);
+
 /* Initialize iobuf members.
  */
 void iobuf_init (struct iobuf *iobuf);
@@ -0,0 +1,422 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* shmring.c - message transport over shared memory rings
+ *
+ * A ring pair is a memfd containing a header and two single-producer,
+ * single-consumer byte rings, one for each direction.  Each ring carries
+ * a stream of messages with the same encoding as sendfd.c.  The server
+ * creates the memfd and passes it to the client over the AF_LOCAL socket
+ * that was used to authenticate the client, so the client can only gain
+ * access to rings created for it.
+ *
+ * Each side has an eventfd "doorbell" that its peer signals when
+ * - it writes to a ring that was empty, or
+ * - it reads from a ring whose producer is waiting for space.
+ * Both checks are done after updating the ring index, with sequentially
+ * consistent ordering, so that either the peer sees the update or the
+ * doorbell is signaled.  Most messages in a burst therefore require no
+ * system calls at all.
+ *
+ * The server cannot trust anything in shared memory.  Each side keeps a
+ * private copy of the index it owns, rejects peer indices that are out
+ * of range with EPROTO, and copies data out of the ring before decoding.
+ * The memfd is sealed so the client cannot resize it under the server.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/errno_safe.h"
+
+#include "shmring.h"
+
+#define SHMRING_MAGIC   0x53484d52  // "SHMR"
+#define SHMRING_VERSION 1
+#define CACHELINE_SIZE  64
+
+enum {
+    RING_C2S = 0,   // client to server
+    RING_S2C = 1,   // server to client
+};
+
+/* Producer and consumer indices count bytes since creation, and are
+ * kept on separate cache lines.
+ */
+struct ring_ctl {
+    uint64_t head __attribute__ ((aligned (CACHELINE_SIZE)));
+    uint32_t want_space;    // producer is waiting for space
+    uint64_t tail __attribute__ ((aligned (CACHELINE_SIZE)));
+};
+
+struct shmring_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t size;          // size of each ring
+    uint64_t offset;        // offset of first ring from start of mapping
+    struct ring_ctl ctl[2];
+};
+
+struct ring {
+    struct ring_ctl *ctl;
+    uint8_t *data;
+    uint64_t pos;           // private copy of our head (out) or tail (in)
+};
+
+struct shmring {
+    void *base;
+    size_t mapsize;
+    uint64_t size;
+    struct ring in;
+    struct ring out;
+    int fds[SHMRING_NFDS];
+    int doorbell;           // signaled by peer
+    int peer_doorbell;
+};
+
+static void doorbell_ring (int fd)
+{
+    uint64_t val = 1;
+    int saved_errno = errno;
+
+    (void)write (fd, &val, sizeof (val));
+    errno = saved_errno;
+}
+
+static void doorbell_reset (int fd)
+{
+    uint64_t val;
+    int saved_errno = errno;
+
+    (void)read (fd, &val, sizeof (val));
+    errno = saved_errno;
+}
+
+static size_t header_size (void)
+{
+    long pagesize = sysconf (_SC_PAGESIZE);
+
+    if (pagesize <= 0)
+        pagesize = 4096;
+    return ((sizeof (struct shmring_header) + pagesize - 1) / pagesize)
+           * pagesize;
+}
+
+void shmring_destroy (struct shmring *ring)
+{
+    if (ring) {
+        int saved_errno = errno;
+        int i;
+        if (ring->base && ring->base != MAP_FAILED)
+            (void)munmap (ring->base, ring->mapsize);
+        for (i = 0; i < SHMRING_NFDS; i++) {
+            if (ring->fds[i] >= 0)
+                (void)close (ring->fds[i]);
+        }
+        free (ring);
+        errno = saved_errno;
+    }
+}
+
+static struct shmring *ring_alloc (void)
+{
+    struct shmring *ring;
+    int i;
+
+    if (!(ring = calloc (1, sizeof (*ring))))
+        return NULL;
+    ring->base = MAP_FAILED;
+    for (i = 0; i < SHMRING_NFDS; i++)
+        ring->fds[i] = -1;
+    return ring;
+}
+
+static void ring_init (struct shmring *ring, bool server)
+{
+    struct shmring_header *hdr = ring->base;
+    uint8_t *data = (uint8_t *)ring->base + hdr->offset;
+    int in = server ? RING_C2S : RING_S2C;
+    int out = server ? RING_S2C : RING_C2S;
+
+    ring->in.ctl = &hdr->ctl[in];
+    ring->in.data = data + in * ring->size;
+    ring->in.pos = __atomic_load_n (&ring->in.ctl->tail, __ATOMIC_SEQ_CST);
+    ring->out.ctl = &hdr->ctl[out];
+    ring->out.data = data + out * ring->size;
+    ring->out.pos = __atomic_load_n (&ring->out.ctl->head, __ATOMIC_SEQ_CST);
+    ring->doorbell = ring->fds[server ? SHMRING_FD_SERVER : SHMRING_FD_CLIENT];
+    ring->peer_doorbell = ring->fds[server ? SHMRING_FD_CLIENT
+                                           : SHMRING_FD_SERVER];
+}
+
+struct shmring *shmring_create (size_t size)
+{
+    struct shmring *ring;
+    struct shmring_header *hdr;
+    uint64_t ringsize = CACHELINE_SIZE;
+
+    if (size == 0 || size > (1UL << 30)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    while (ringsize < size)
+        ringsize <<= 1;
+    if (!(ring = ring_alloc ()))
+        return NULL;
+    ring->size = ringsize;
+    ring->mapsize = header_size () + 2 * ringsize;
+    if ((ring->fds[SHMRING_FD_MEM] = memfd_create ("flux-shmring",
+                                                   MFD_CLOEXEC
+                                                   | MFD_ALLOW_SEALING)) < 0
+        || ftruncate (ring->fds[SHMRING_FD_MEM], ring->mapsize) < 0
+        || fcntl (ring->fds[SHMRING_FD_MEM],
+                  F_ADD_SEALS,
+                  F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0)
+        goto error;
+    if ((ring->base = mmap (NULL,
+                            ring->mapsize,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED,
+                            ring->fds[SHMRING_FD_MEM],
+                            0)) == MAP_FAILED)
+        goto error;
+    if ((ring->fds[SHMRING_FD_SERVER] = eventfd (0, EFD_NONBLOCK
+                                                    | EFD_CLOEXEC)) < 0
+        || (ring->fds[SHMRING_FD_CLIENT] = eventfd (0, EFD_NONBLOCK
+                                                       | EFD_CLOEXEC)) < 0)
+        goto error;
+    hdr = ring->base;
+    hdr->magic = SHMRING_MAGIC;
+    hdr->version = SHMRING_VERSION;
+    hdr->size = ringsize;
+    hdr->offset = header_size ();
+    ring_init (ring, true);
+    return ring;
+error:
+    shmring_destroy (ring);
+    return NULL;
+}
+
+void shmring_get_fds (struct shmring *ring, int fds[SHMRING_NFDS])
+{
+    int i;
+
+    for (i = 0; i < SHMRING_NFDS; i++)
+        fds[i] = ring ? ring->fds[i] : -1;
+}
+
+struct shmring *shmring_attach (const int fds[SHMRING_NFDS])
+{
+    struct shmring *ring;
+    struct shmring_header hdr;
+    struct stat sb;
+    int i;
+
+    if (!fds) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (fstat (fds[SHMRING_FD_MEM], &sb) < 0)
+        return NULL;
+    if (sb.st_size < sizeof (hdr)
+        || pread (fds[SHMRING_FD_MEM], &hdr, sizeof (hdr), 0) != sizeof (hdr)
+        || hdr.magic != SHMRING_MAGIC
+        || hdr.version != SHMRING_VERSION
+        || hdr.size == 0
+        || (hdr.size & (hdr.size - 1)) != 0
+        || hdr.offset < sizeof (hdr)
+        || sb.st_size != hdr.offset + 2 * hdr.size) {
+        errno = EPROTO;
+        return NULL;
+    }
+    if (!(ring = ring_alloc ()))
+        return NULL;
+    ring->size = hdr.size;
+    ring->mapsize = sb.st_size;
+    if ((ring->base = mmap (NULL,
+                            ring->mapsize,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED,
+                            fds[SHMRING_FD_MEM],
+                            0)) == MAP_FAILED) {
+        ERRNO_SAFE_WRAP (free, ring);
+        return NULL;
+    }
+    for (i = 0; i < SHMRING_NFDS; i++)
+        ring->fds[i] = fds[i];
+    ring_init (ring, false);
+    return ring;
+}
+
+int shmring_pollfd (struct shmring *ring)
+{
+    if (!ring) {
+        errno = EINVAL;
+        return -1;
+    }
+    return ring->doorbell;
+}
+
+void shmring_wakeup (struct shmring *ring)
+{
+    if (ring)
+        doorbell_ring (ring->doorbell);
+}
+
+int shmring_pollevents (struct shmring *ring)
+{
+    uint64_t head, tail;
+    int revents = 0;
+
+    if (!ring)
+        return FLUX_POLLERR;
+    doorbell_reset (ring->doorbell);
+
+    head = __atomic_load_n (&ring->in.ctl->head, __ATOMIC_SEQ_CST);
+    if (head - ring->in.pos > ring->size)
+        return FLUX_POLLERR;
+    if (head != ring->in.pos)
+        revents |= FLUX_POLLIN;
+
+    tail = __atomic_load_n (&ring->out.ctl->tail, __ATOMIC_SEQ_CST);
+    if (ring->out.pos - tail > ring->size)
+        return FLUX_POLLERR;
+    if (ring->out.pos - tail < ring->size)
+        revents |= FLUX_POLLOUT;
+
+    return revents;
+}
+
+ssize_t shmring_write (struct shmring *ring, const void *buf, size_t size)
+{
+    struct ring *r;
+    uint64_t used;
+    uint64_t prev;
+    size_t n, offset, chunk;
+
+    if (!ring || !buf) {
+        errno = EINVAL;
+        return -1;
+    }
+    r = &ring->out;
+    used = r->pos - __atomic_load_n (&r->ctl->tail, __ATOMIC_SEQ_CST);
+    if (used == ring->size) {
+        /* Full.  Ask the consumer for a wakeup, then check again in
+         * case it read everything before seeing the request.
+         */
+        __atomic_store_n (&r->ctl->want_space, 1, __ATOMIC_SEQ_CST);
+        used = r->pos - __atomic_load_n (&r->ctl->tail, __ATOMIC_SEQ_CST);
+        if (used == ring->size) {
+            errno = EAGAIN;
+            return -1;
+        }
+    }
+    if (used > ring->size) {
+        errno = EPROTO;
+        return -1;
+    }
+    n = ring->size - used;
+    if (n > size)
+        n = size;
+    offset = r->pos & (ring->size - 1);
+    chunk = ring->size - offset;
+    if (chunk > n)
+        chunk = n;
+    memcpy (r->data + offset, buf, chunk);
+    memcpy (r->data, (const uint8_t *)buf + chunk, n - chunk);
+
+    prev = r->pos;
+    r->pos += n;
+    __atomic_store_n (&r->ctl->head, r->pos, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n (&r->ctl->tail, __ATOMIC_SEQ_CST) == prev)
+        doorbell_ring (ring->peer_doorbell);
+    return n;
+}
+
+ssize_t shmring_read (struct shmring *ring, void *buf, size_t size)
+{
+    struct ring *r;
+    uint64_t avail;
+    size_t n, offset, chunk;
+
+    if (!ring || !buf) {
+        errno = EINVAL;
+        return -1;
+    }
+    r = &ring->in;
+    avail = __atomic_load_n (&r->ctl->head, __ATOMIC_SEQ_CST) - r->pos;
+    if (avail > ring->size) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (avail == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    n = avail;
+    if (n > size)
+        n = size;
+    offset = r->pos & (ring->size - 1);
+    chunk = ring->size - offset;
+    if (chunk > n)
+        chunk = n;
+    memcpy (buf, r->data + offset, chunk);
+    memcpy ((uint8_t *)buf + chunk, r->data, n - chunk);
+
+    r->pos += n;
+    __atomic_store_n (&r->ctl->tail, r->pos, __ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n (&r->ctl->want_space, 0, __ATOMIC_SEQ_CST))
+        doorbell_ring (ring->peer_doorbell);
+    return n;
+}
+
+static ssize_t ring_write (void *arg, void *buf, size_t size)
+{
+    return shmring_write (arg, buf, size);
+}
+
+static ssize_t ring_read (void *arg, void *buf, size_t size)
+{
+    return shmring_read (arg, buf, size);
+}
+
+int shmring_sendmsg (struct shmring *ring,
+                     const flux_msg_t *msg,
+                     struct iobuf *iobuf)
+{
+    if (!ring) {
+        errno = EINVAL;
+        return -1;
+    }
+    return sendio (ring_write, ring, msg, iobuf);
+}
+
+flux_msg_t *shmring_recvmsg (struct shmring *ring, struct iobuf *iobuf)
+{
+    if (!ring) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return recvio (ring_read, ring, iobuf);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
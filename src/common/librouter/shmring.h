@@ -0,0 +1,79 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _ROUTER_SHMRING_H
+#define _ROUTER_SHMRING_H
+
+#include <sys/types.h>
+#include <flux/core.h>
+
+#include "sendfd.h"
+
+/* File descriptors that make up a ring pair, passed from server to client.
+ */
+enum {
+    SHMRING_FD_MEM = 0,     // memfd containing both rings
+    SHMRING_FD_SERVER = 1,  // eventfd signaled to wake the server
+    SHMRING_FD_CLIENT = 2,  // eventfd signaled to wake the client
+    SHMRING_NFDS = 3,
+};
+
+/* Server: create a ring pair with 'size' bytes in each direction
+ * ('size' is rounded up to a power of two).
+ */
+struct shmring *shmring_create (size_t size);
+
+/* Server: get the descriptors to pass to the client.  They remain owned
+ * by 'ring'.
+ */
+void shmring_get_fds (struct shmring *ring, int fds[SHMRING_NFDS]);
+
+/* Client: attach to a ring pair created by the server.  On success,
+ * 'ring' takes ownership of 'fds'.
+ */
+struct shmring *shmring_attach (const int fds[SHMRING_NFDS]);
+
+void shmring_destroy (struct shmring *ring);
+
+/* Get an fd that becomes readable when the peer writes to an empty ring
+ * or frees space in a full one.  Upon wakeup, call shmring_pollevents()
+ * to see what events occurred.
+ */
+int shmring_pollfd (struct shmring *ring);
+
+/* Reset the pollfd and return FLUX_POLLIN if data is available to read,
+ * FLUX_POLLOUT if there is space to write, and FLUX_POLLERR if the peer
+ * has corrupted the ring.
+ */
+int shmring_pollevents (struct shmring *ring);
+
+/* Make the pollfd readable, e.g. to resume reading later.
+ */
+void shmring_wakeup (struct shmring *ring);
+
+/* Write/read up to 'size' bytes, returning the number of bytes
+ * transferred, or -1 with errno set.  EAGAIN means the ring is full
+ * or empty.  EPROTO means the peer has corrupted the ring.
+ */
+ssize_t shmring_write (struct shmring *ring, const void *buf, size_t size);
+ssize_t shmring_read (struct shmring *ring, void *buf, size_t size);
+
+/* Send/receive messages, with sendfd()/recvfd() semantics.
+ */
+int shmring_sendmsg (struct shmring *ring,
+                     const flux_msg_t *msg,
+                     struct iobuf *iobuf);
+flux_msg_t *shmring_recvmsg (struct shmring *ring, struct iobuf *iobuf);
+
+#endif /* !_ROUTER_SHMRING_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
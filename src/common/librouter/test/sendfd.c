@@ -13,6 +13,7 @@
 #endif
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -292,6 +293,63 @@ next:
     free (buf);
 }
 
+/* Pass a pipe's write end along with a message over a socketpair.
+ */
+void test_rights (void)
+{
+    int sv[2];
+    int pfd[2];
+    int fds[2];
+    int nfds = 2;
+    flux_msg_t *msg, *msg2;
+    const char *topic;
+    char c = 0;
+
+    if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0)
+        BAIL_OUT ("socketpair failed");
+    if (pipe2 (pfd, O_CLOEXEC) < 0)
+        BAIL_OUT ("pipe2 failed");
+    if (!(msg = flux_request_encode ("foo.rights", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    ok (sendfd_rights (sv[0], msg, &pfd[1], 1) == 0,
+        "sendfd_rights works");
+    ok ((msg2 = recvfd_rights (sv[1], fds, &nfds)) != NULL,
+        "recvfd_rights works");
+    ok (flux_request_decode (msg2, &topic, NULL) == 0
+        && !strcmp (topic, "foo.rights"),
+        "received request has expected topic string");
+    ok (nfds == 1,
+        "received one file descriptor");
+    ok (nfds == 1
+        && write (fds[0], "x", 1) == 1
+        && read (pfd[0], &c, 1) == 1
+        && c == 'x',
+        "received file descriptor refers to the pipe");
+    if (nfds == 1)
+        close (fds[0]);
+    flux_msg_destroy (msg2);
+
+    ok (sendfd (sv[0], msg, NULL) == 0,
+        "sendfd works on the same socket");
+    nfds = 2;
+    ok ((msg2 = recvfd_rights (sv[1], fds, &nfds)) != NULL && nfds == 0,
+        "recvfd_rights works with no file descriptors");
+    flux_msg_destroy (msg2);
+
+    errno = 0;
+    ok (sendfd_rights (sv[0], msg, NULL, 0) < 0 && errno == EINVAL,
+        "sendfd_rights fds=NULL fails with EINVAL");
+    errno = 0;
+    ok (recvfd_rights (-1, fds, &nfds) == NULL && errno == EINVAL,
+        "recvfd_rights fd=-1 fails with EINVAL");
+
+    flux_msg_destroy (msg);
+    close (pfd[0]);
+    close (pfd[1]);
+    close (sv[0]);
+    close (sv[1]);
+}
+
 void test_inval (void)
 {
     flux_msg_t *msg;
@@ -324,6 +382,7 @@ int main (int argc, char *argv[])
     test_nonblock (4096, 256);
     test_nonblock (16384, 64);
     test_nonblock (1048586, 1);
+    test_rights ();
     test_inval ();
 
     done_testing();
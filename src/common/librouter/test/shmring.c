@@ -0,0 +1,224 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/mman.h>
+#include <unistd.h>
+#include <poll.h>
+#include <flux/core.h>
+
+#include "src/common/librouter/shmring.h"
+#include "src/common/libtap/tap.h"
+
+static bool is_readable (int fd)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+    return poll (&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+
+/* Create a server ring and attach a client to (copies of) its fds,
+ * as if the fds had been passed over a socket.
+ */
+static void create_pair (size_t size,
+                         struct shmring **server,
+                         struct shmring **client)
+{
+    int fds[SHMRING_NFDS];
+    int i;
+
+    if (!(*server = shmring_create (size)))
+        BAIL_OUT ("shmring_create failed");
+    shmring_get_fds (*server, fds);
+    for (i = 0; i < SHMRING_NFDS; i++) {
+        if ((fds[i] = dup (fds[i])) < 0)
+            BAIL_OUT ("dup failed");
+    }
+    if (!(*client = shmring_attach (fds)))
+        BAIL_OUT ("shmring_attach failed");
+}
+
+static void test_bytes (void)
+{
+    struct shmring *server;
+    struct shmring *client;
+    char buf[256];
+    char big[200];
+    int i;
+
+    create_pair (100, &server, &client);
+
+    ok (shmring_pollevents (server) == FLUX_POLLOUT,
+        "server: empty ring is writable, not readable");
+    ok (!is_readable (shmring_pollfd (server)),
+        "server: doorbell is not signaled");
+    ok (shmring_write (client, "hello", 6) == 6,
+        "client: shmring_write works");
+    ok (is_readable (shmring_pollfd (server)),
+        "server: doorbell is signaled on write to empty ring");
+    ok (shmring_write (client, "world", 6) == 6,
+        "client: second shmring_write works");
+    ok (shmring_pollevents (server) == (FLUX_POLLIN | FLUX_POLLOUT)
+        && !is_readable (shmring_pollfd (server)),
+        "server: shmring_pollevents returns POLLIN and resets doorbell");
+    ok (shmring_read (server, buf, sizeof (buf)) == 12
+        && !strcmp (buf, "hello")
+        && !strcmp (buf + 6, "world"),
+        "server: shmring_read returns both writes");
+    errno = 0;
+    ok (shmring_read (server, buf, sizeof (buf)) < 0 && errno == EAGAIN,
+        "server: shmring_read of empty ring fails with EAGAIN");
+
+    /* ring size was rounded up to 128 */
+    for (i = 0; i < sizeof (big); i++)
+        big[i] = i;
+    ok (shmring_write (server, big, sizeof (big)) == 128,
+        "server: shmring_write fills ring");
+    errno = 0;
+    ok (shmring_write (server, big + 128, sizeof (big) - 128) < 0
+        && errno == EAGAIN,
+        "server: shmring_write of full ring fails with EAGAIN");
+    ok (shmring_pollevents (server) == 0,
+        "server: full ring is not writable");
+    ok (shmring_pollevents (client) == (FLUX_POLLIN | FLUX_POLLOUT),
+        "client: full ring is readable");
+    ok (shmring_read (client, buf, 100) == 100
+        && !memcmp (buf, big, 100),
+        "client: shmring_read works");
+    ok (is_readable (shmring_pollfd (server)),
+        "server: doorbell is signaled when waiting for space");
+    ok (shmring_write (server, big + 128, sizeof (big) - 128) == 72,
+        "server: shmring_write wraps around");
+    ok (shmring_read (client, buf + 100, sizeof (buf) - 100) == 100
+        && !memcmp (buf, big, sizeof (big)),
+        "client: shmring_read returns data in order");
+
+    shmring_wakeup (client);
+    ok (is_readable (shmring_pollfd (client)),
+        "client: shmring_wakeup signals own doorbell");
+
+    shmring_destroy (client);
+    shmring_destroy (server);
+}
+
+static void test_messages (void)
+{
+    struct shmring *server;
+    struct shmring *client;
+    struct iobuf sbuf;
+    struct iobuf rbuf;
+    flux_msg_t *msg;
+    flux_msg_t *rmsg = NULL;
+    const char *topic;
+    const void *payload;
+    int payload_size;
+    char *data;
+    int size = 100000;
+    int count = 0;
+
+    create_pair (4096, &server, &client);
+    iobuf_init (&sbuf);
+    iobuf_init (&rbuf);
+
+    if (!(data = malloc (size)))
+        BAIL_OUT ("malloc failed");
+    memset (data, 'y', size);
+    if (!(msg = flux_request_encode_raw ("foo.bar", data, size)))
+        BAIL_OUT ("flux_request_encode_raw failed");
+
+    /* Alternate partial sends and receives, as two processes would.
+     */
+    while (!rmsg) {
+        if (shmring_sendmsg (client, msg, &sbuf) < 0) {
+            if (errno != EAGAIN)
+                break;
+        }
+        if (!(rmsg = shmring_recvmsg (server, &rbuf))) {
+            if (errno != EAGAIN)
+                break;
+        }
+        count++;
+    }
+    ok (rmsg != NULL,
+        "message larger than ring was received in %d steps", count);
+    ok (rmsg
+        && flux_request_decode_raw (rmsg,
+                                    &topic,
+                                    &payload,
+                                    &payload_size) == 0
+        && !strcmp (topic, "foo.bar")
+        && payload_size == size
+        && !memcmp (payload, data, size),
+        "received message matches sent");
+    flux_msg_destroy (rmsg);
+
+    ok (shmring_write (client, "garbage!", 8) == 8,
+        "client: wrote a bad message header");
+    errno = 0;
+    ok (shmring_recvmsg (server, &rbuf) == NULL && errno == EPROTO,
+        "server: shmring_recvmsg fails with EPROTO");
+
+    iobuf_clean (&sbuf);
+    iobuf_clean (&rbuf);
+    flux_msg_destroy (msg);
+    free (data);
+    shmring_destroy (client);
+    shmring_destroy (server);
+}
+
+static void test_inval (void)
+{
+    int fds[SHMRING_NFDS];
+
+    errno = 0;
+    ok (shmring_create (0) == NULL && errno == EINVAL,
+        "shmring_create size=0 fails with EINVAL");
+    errno = 0;
+    ok (shmring_attach (NULL) == NULL && errno == EINVAL,
+        "shmring_attach fds=NULL fails with EINVAL");
+
+    if ((fds[SHMRING_FD_MEM] = memfd_create ("test", MFD_CLOEXEC)) < 0
+        || ftruncate (fds[SHMRING_FD_MEM], 8192) < 0)
+        BAIL_OUT ("could not create memfd");
+    fds[SHMRING_FD_SERVER] = fds[SHMRING_FD_CLIENT] = -1;
+    errno = 0;
+    ok (shmring_attach (fds) == NULL && errno == EPROTO,
+        "shmring_attach of memfd without header fails with EPROTO");
+    close (fds[SHMRING_FD_MEM]);
+
+    errno = 0;
+    ok (shmring_write (NULL, "x", 1) < 0 && errno == EINVAL,
+        "shmring_write ring=NULL fails with EINVAL");
+    errno = 0;
+    ok (shmring_read (NULL, fds, 1) < 0 && errno == EINVAL,
+        "shmring_read ring=NULL fails with EINVAL");
+    ok (shmring_pollevents (NULL) == FLUX_POLLERR,
+        "shmring_pollevents ring=NULL returns FLUX_POLLERR");
+    lives_ok ({shmring_destroy (NULL);},
+        "shmring_destroy ring=NULL doesn't crash");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_bytes ();
+    test_messages ();
+    test_inval ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
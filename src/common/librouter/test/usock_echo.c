@@ -98,6 +98,7 @@ static int server_cb (flux_t *h, void *arg)
         return -1;
     }
     usock_server_set_acceptor (server, server_acceptor, NULL);
+    usock_server_set_shm (server, 65536);
 
     if (flux_reactor_run (r, 0) < 0) {
         diag ("flux_reactor_run failed");
@@ -213,6 +214,59 @@ static void test_one_echo (flux_t *h)
     flux_msg_destroy (msg);
 }
 
+/* Upgrade to shared memory and echo messages that fit in the ring,
+ * and one that does not.
+ */
+static void test_shm_echo (flux_t *h)
+{
+    char sockpath[PATH_MAX + 1];
+    int sizes[] = { 0, 1024, 65536, 1048576 };
+    struct usock_client *client;
+    char *buf;
+    int fd;
+    int i;
+
+    if (snprintf (sockpath,
+                  sizeof (sockpath),
+                  "%s/server",
+                  tmpdir) >= sizeof (sockpath))
+        BAIL_OUT ("buffer overflow");
+    fd = usock_client_connect (sockpath, USOCK_RETRY_DEFAULT);
+    if (fd < 0)
+        BAIL_OUT ("usock_client_connect failed");
+    if (!(client = usock_client_create (fd)))
+        BAIL_OUT ("usock_client_create failed");
+    ok (usock_client_attach_shm (client) == 0,
+        "usock_client_attach_shm works");
+    errno = 0;
+    ok (usock_client_attach_shm (client) < 0 && errno == EINVAL,
+        "usock_client_attach_shm fails with EINVAL the second time");
+
+    if (!(buf = malloc (sizes[3])))
+        BAIL_OUT ("malloc failed");
+    memset (buf, 0x0f, sizes[3]);
+    for (i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+        flux_msg_t *msg;
+        flux_msg_t *rmsg;
+
+        if (!(msg = flux_request_encode_raw ("a", buf, sizes[i])))
+            BAIL_OUT ("flux_request_encode_raw failed");
+        ok (usock_client_send (client, msg, 0) == 0,
+            "usock_client_send size=%d over shm works", sizes[i]);
+        ok ((rmsg = usock_client_recv (client, 0)) != NULL
+            && equal_message (msg, rmsg),
+            "usock_client_recv over shm returned matching message");
+        flux_msg_destroy (rmsg);
+        flux_msg_destroy (msg);
+    }
+
+    diag ("disconnecting");
+
+    usock_client_destroy (client);
+    (void)close (fd);
+    free (buf);
+}
+
 struct async_ctx {
     flux_reactor_t *r;
     flux_msg_t *msg;
@@ -305,6 +359,7 @@ int main (int argc, char *argv[])
 
     test_early_disconnect (h);
     test_one_echo (h);
+    test_shm_echo (h);
     test_async_stream (h, 1024, 1024);
     test_async_stream (h, 4096, 256);
     test_async_stream (h, 16384, 64);
@@ -31,6 +31,17 @@
  * - usock_conn_send() adds a message to a queue, starts fd (write) watcher.
  * - Register a receive callback to receive complete messages from client.
  * - Register an error callback to be notified when I/O errors occur.
+ *
+ * Shared memory:
+ * - If enabled with usock_server_set_shm(), a connected client may send
+ *   a "usock.shm-attach" request.  The server creates a shmring pair and
+ *   passes its descriptors back with the response, then all subsequent
+ *   messages in both directions use the rings.  The socket remains open
+ *   so that either side can detect disconnect, and credentials are those
+ *   of the socket peer, as before.
+ * - If the server does not support it, the request is passed through to
+ *   the receive callback like any other message, and the client falls
+ *   back to the socket when the (ENOSYS) error response arrives.
  */
 
 #if HAVE_CONFIG_H
@@ -39,6 +50,7 @@
 #include <sys/un.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
 #include <poll.h>
 #include <unistd.h>
 #include <errno.h>
@@ -54,9 +66,12 @@
 
 #include "usock.h"
 #include "sendfd.h"
+#include "shmring.h"
 
 #define LISTEN_BACKLOG 5
 
+static const char *shm_attach_topic = "usock.shm-attach";
+
 #ifndef UUID_STR_LEN
 #define UUID_STR_LEN 37     // defined in later libuuid headers
 #endif
@@ -69,6 +84,7 @@ struct usock_server {
     zlist_t *connections;
     usock_acceptor_f acceptor;
     void *arg;
+    size_t shm_size;
 };
 
 struct usock_io {
@@ -77,11 +93,20 @@ struct usock_io {
     struct iobuf iobuf;
 };
 
+struct usock_shm {
+    struct shmring *ring;
+    flux_watcher_t *w;
+    struct iobuf in_iobuf;
+    struct iobuf out_iobuf;
+};
+
 struct usock_conn {
     struct flux_msg_cred cred;
     struct usock_io in;
     struct usock_io out;
     zlist_t *outqueue;
+    flux_reactor_t *r;
+    struct usock_shm *shm;
 
     usock_conn_close_f close_cb;
     void *close_arg;
@@ -106,6 +131,8 @@ struct usock_client {
     int fd;
     struct iobuf in_iobuf;
     struct iobuf out_iobuf;
+    struct shmring *shm;
+    int epfd;           // polls fd and shm doorbell, if shm is attached
 };
 
 const struct flux_msg_cred *usock_conn_get_cred (struct usock_conn *conn)
@@ -180,6 +207,29 @@ static void conn_io_error (struct usock_conn *conn, int errnum)
     }
 }
 
+static int conn_outqueue_drop (struct usock_conn *conn);
+
+/* Write queued messages to the shm ring until it is full.
+ * A partially written message stays at the head of the queue, and the
+ * ring's doorbell is signaled when the client makes space.
+ */
+static int conn_shm_flush (struct usock_conn *conn)
+{
+    const flux_msg_t *msg;
+
+    while ((msg = zlist_head (conn->outqueue))) {
+        if (shmring_sendmsg (conn->shm->ring,
+                             msg,
+                             &conn->shm->out_iobuf) < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return -1;
+        }
+        (void)conn_outqueue_drop (conn);
+    }
+    return 0;
+}
+
 int usock_conn_send (struct usock_conn *conn, const flux_msg_t *msg)
 {
     if (!conn || !msg) {
@@ -191,10 +241,142 @@ int usock_conn_send (struct usock_conn *conn, const flux_msg_t *msg)
         errno = ENOMEM;
         return -1;
     }
+    if (conn->shm)
+        return conn_shm_flush (conn);
     flux_watcher_start (conn->out.w);
     return 0;
 }
 
+/* The client signaled the shm doorbell: it wrote to an empty ring or
+ * made space in a full one.  Like conn_read_cb(), deliver at most one
+ * message per callback, so the receive callback may destroy 'conn'.
+ * If more data is available, ring the doorbell to come back for it.
+ */
+static void conn_shm_cb (flux_reactor_t *r,
+                         flux_watcher_t *w,
+                         int revents,
+                         void *arg)
+{
+    struct usock_conn *conn = arg;
+    int events = shmring_pollevents (conn->shm->ring);
+    flux_msg_t *msg;
+
+    if ((events & FLUX_POLLERR)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if ((events & FLUX_POLLOUT)) {
+        if (conn_shm_flush (conn) < 0)
+            goto error;
+    }
+    if ((events & FLUX_POLLIN)) {
+        if (!(msg = shmring_recvmsg (conn->shm->ring, &conn->shm->in_iobuf))) {
+            if (errno != EWOULDBLOCK && errno != EAGAIN)
+                goto error;
+        }
+        else {
+            if (auth_init_message (msg, &conn->cred) < 0) {
+                flux_msg_destroy (msg);
+                goto error;
+            }
+            if ((shmring_pollevents (conn->shm->ring) & FLUX_POLLIN))
+                shmring_wakeup (conn->shm->ring);
+            if (conn->recv_cb)
+                conn->recv_cb (conn, msg, conn->recv_arg);
+            flux_msg_destroy (msg);
+        }
+    }
+    return;
+error:
+    conn_io_error (conn, errno);
+}
+
+static void conn_shm_destroy (struct usock_shm *shm)
+{
+    if (shm) {
+        int saved_errno = errno;
+        flux_watcher_destroy (shm->w);
+        iobuf_clean (&shm->in_iobuf);
+        iobuf_clean (&shm->out_iobuf);
+        shmring_destroy (shm->ring);
+        free (shm);
+        errno = saved_errno;
+    }
+}
+
+static struct usock_shm *conn_shm_create (flux_reactor_t *r,
+                                          struct usock_conn *conn,
+                                          size_t size)
+{
+    struct usock_shm *shm;
+
+    if (!(shm = calloc (1, sizeof (*shm))))
+        return NULL;
+    iobuf_init (&shm->in_iobuf);
+    iobuf_init (&shm->out_iobuf);
+    if (!(shm->ring = shmring_create (size))
+        || !(shm->w = flux_fd_watcher_create (r,
+                                              shmring_pollfd (shm->ring),
+                                              FLUX_POLLIN,
+                                              conn_shm_cb,
+                                              conn)))
+        goto error;
+    return shm;
+error:
+    conn_shm_destroy (shm);
+    return NULL;
+}
+
+/* Handle the client's request to move to shared memory.  The response,
+ * with the ring descriptors attached, is the last message sent over the
+ * socket.  The client waits for it before sending anything else, so the
+ * output queue is normally empty; if not, decline rather than reorder.
+ */
+static void conn_shm_attach (struct usock_conn *conn, const flux_msg_t *msg)
+{
+    struct usock_shm *shm = NULL;
+    flux_msg_t *response = NULL;
+    int fds[SHMRING_NFDS];
+
+    if (conn->shm || zlist_size (conn->outqueue) > 0) {
+        errno = EBUSY;
+        goto error;
+    }
+    if (!(shm = conn_shm_create (conn->r, conn, conn->server->shm_size))
+        || !(response = flux_response_derive (msg, 0)))
+        goto error;
+    shmring_get_fds (shm->ring, fds);
+    if (sendfd_rights (conn->out.fd, response, fds, SHMRING_NFDS) < 0) {
+        conn_shm_destroy (shm);
+        flux_msg_destroy (response);
+        conn_io_error (conn, errno);
+        return;
+    }
+    flux_msg_destroy (response);
+    conn->shm = shm;
+    flux_watcher_start (shm->w);
+    return;
+error:
+    conn_shm_destroy (shm);
+    if (!(response = flux_response_derive (msg, errno))
+        || usock_conn_send (conn, response) < 0)
+        conn_io_error (conn, errno);
+    flux_msg_destroy (response);
+}
+
+static bool is_shm_attach (struct usock_conn *conn, const flux_msg_t *msg)
+{
+    const char *topic;
+    int type;
+
+    return (conn->server != NULL
+            && conn->server->shm_size > 0
+            && flux_msg_get_type (msg, &type) == 0
+            && type == FLUX_MSGTYPE_REQUEST
+            && flux_msg_get_topic (msg, &topic) == 0
+            && !strcmp (topic, shm_attach_topic));
+}
+
 static void conn_read_cb (flux_reactor_t *r,
                           flux_watcher_t *w,
                           int revents,
@@ -219,7 +401,9 @@ static void conn_read_cb (flux_reactor_t *r,
             if (auth_init_message (msg, &conn->cred) < 0)
                 goto error;
 
-            if (conn->recv_cb)
+            if (is_shm_attach (conn, msg))
+                conn_shm_attach (conn, msg);
+            else if (conn->recv_cb)
                 conn->recv_cb (conn, msg, conn->recv_arg);
             flux_msg_destroy (msg);
         }
@@ -329,6 +513,7 @@ void usock_conn_destroy (struct usock_conn *conn)
         if (conn->close_cb)
             (*conn->close_cb) (conn, conn->close_arg);
         aux_destroy (&conn->aux);
+        conn_shm_destroy (conn->shm);
         flux_watcher_destroy (conn->in.w);
         iobuf_clean (&conn->in.iobuf);
         if (conn->outqueue) {
@@ -362,6 +547,12 @@ void usock_server_set_acceptor (struct usock_server *server,
     }
 }
 
+void usock_server_set_shm (struct usock_server *server, size_t size)
+{
+    if (server)
+        server->shm_size = size;
+}
+
 void usock_server_destroy (struct usock_server *server)
 {
     if (server) {
@@ -421,6 +612,7 @@ struct usock_conn *usock_conn_create (flux_reactor_t *r, int infd, int outfd)
     if (!(conn = calloc (1, sizeof (*conn))))
         return NULL;
 
+    conn->r = r;
     conn->in.fd = infd;
     conn->out.fd = outfd;
     conn->cred.userid = FLUX_USERID_UNKNOWN;
@@ -586,6 +778,18 @@ int usock_client_pollevents (struct usock_client *client)
     struct pollfd pfd;
     int flux_revents = 0;
 
+    /* With shm attached, nothing more is expected on the socket,
+     * so any socket event means the server has gone away.
+     */
+    if (client->shm) {
+        pfd.fd = client->fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll (&pfd, 1, 0) < 0 || pfd.revents != 0)
+            return FLUX_POLLERR;
+        return shmring_pollevents (client->shm);
+    }
+
     pfd.fd = client->fd;
     pfd.events = POLLIN | POLLOUT;
     pfd.revents = 0;
@@ -608,7 +812,7 @@ int usock_client_pollevents (struct usock_client *client)
  */
 int usock_client_pollfd (struct usock_client *client)
 {
-    return client->fd;
+    return client->shm ? client->epfd : client->fd;
 }
 
 /* Poll wrapper that blocks until the specified event occurs.
@@ -631,6 +835,65 @@ static int usock_client_poll (int fd, int events)
     return 0;
 }
 
+/* Block until the shm doorbell is signaled.  Fail with ECONNRESET
+ * if the server closes the socket.
+ */
+static int usock_client_poll_shm (struct usock_client *client)
+{
+    struct pollfd pfd[2];
+
+    memset (pfd, 0, sizeof (pfd));
+    pfd[0].fd = client->fd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = shmring_pollfd (client->shm);
+    pfd[1].events = POLLIN;
+
+    if (poll (pfd, 2, -1) < 0)
+        return -1;
+    if (pfd[0].revents != 0) {
+        errno = ECONNRESET;
+        return -1;
+    }
+    if (is_poll_error (pfd[1].revents)) {
+        errno = EIO;
+        return -1;
+    }
+    return 0;
+}
+
+static int usock_client_send_shm (struct usock_client *client,
+                                  const flux_msg_t *msg,
+                                  int flags)
+{
+    while (shmring_sendmsg (client->shm, msg, &client->out_iobuf) < 0) {
+        if (errno != EWOULDBLOCK && errno != EAGAIN)
+            return -1;
+        if ((flags & FLUX_O_NONBLOCK))
+            return -1;
+        if (usock_client_poll_shm (client) < 0)
+            return -1;
+        (void)shmring_pollevents (client->shm);
+    }
+    return 0;
+}
+
+static flux_msg_t *usock_client_recv_shm (struct usock_client *client,
+                                          int flags)
+{
+    flux_msg_t *msg;
+
+    while (!(msg = shmring_recvmsg (client->shm, &client->in_iobuf))) {
+        if (errno != EWOULDBLOCK && errno != EAGAIN)
+            return NULL;
+        if ((flags & FLUX_O_NONBLOCK))
+            return NULL;
+        if (usock_client_poll_shm (client) < 0)
+            return NULL;
+        (void)shmring_pollevents (client->shm);
+    }
+    return msg;
+}
+
 /* Try to send message.  If flags does not include FLUX_O_NONBLOCK,
  * and sendfd fails with EWOULDBLOCK/EAGAIN, then poll(POLLOUT) and
  * keep trying until the full message is sent.
@@ -639,6 +902,8 @@ int usock_client_send (struct usock_client *client,
                        const flux_msg_t *msg,
                        int flags)
 {
+    if (client->shm)
+        return usock_client_send_shm (client, msg, flags);
     while (sendfd (client->fd, msg, &client->out_iobuf) < 0) {
         if (errno != EWOULDBLOCK && errno != EAGAIN)
             return -1;
@@ -658,6 +923,8 @@ flux_msg_t *usock_client_recv (struct usock_client *client, int flags)
 {
     flux_msg_t *msg;
 
+    if (client->shm)
+        return usock_client_recv_shm (client, flags);
     while (!(msg = recvfd (client->fd, &client->in_iobuf))) {
         if (errno != EWOULDBLOCK && errno != EAGAIN)
             return NULL;
@@ -745,6 +1012,7 @@ struct usock_client *usock_client_create (int fd)
         return NULL;
 
     client->fd = fd;
+    client->epfd = -1;
     iobuf_init (&client->in_iobuf);
     iobuf_init (&client->out_iobuf);
 
@@ -758,12 +1026,71 @@ error:
     return NULL;
 }
 
+int usock_client_attach_shm (struct usock_client *client)
+{
+    flux_msg_t *msg;
+    flux_msg_t *rmsg = NULL;
+    int fds[SHMRING_NFDS];
+    int nfds = SHMRING_NFDS;
+    struct shmring *shm = NULL;
+    struct epoll_event ev = { .events = EPOLLIN };
+    int epfd = -1;
+    int i;
+
+    if (!client || client->shm) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(msg = flux_request_encode (shm_attach_topic, NULL)))
+        return -1;
+    if (usock_client_send (client, msg, 0) < 0
+        || !(rmsg = recvfd_rights (client->fd, fds, &nfds)))
+        goto error_nofds;
+    if (flux_response_decode (rmsg, NULL, NULL) < 0)
+        goto error;
+    if (nfds != SHMRING_NFDS) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(shm = shmring_attach (fds)))
+        goto error;
+    nfds = 0; // owned by shm now
+    if ((epfd = epoll_create1 (EPOLL_CLOEXEC)) < 0)
+        goto error;
+    ev.data.fd = client->fd;
+    if (epoll_ctl (epfd, EPOLL_CTL_ADD, client->fd, &ev) < 0)
+        goto error;
+    ev.data.fd = shmring_pollfd (shm);
+    if (epoll_ctl (epfd, EPOLL_CTL_ADD, shmring_pollfd (shm), &ev) < 0)
+        goto error;
+    client->shm = shm;
+    client->epfd = epfd;
+    flux_msg_destroy (msg);
+    flux_msg_destroy (rmsg);
+    return 0;
+error:
+    for (i = 0; i < nfds; i++)
+        ERRNO_SAFE_WRAP (close, fds[i]);
+    if (epfd >= 0)
+        ERRNO_SAFE_WRAP (close, epfd);
+    shmring_destroy (shm);
+error_nofds:
+    flux_msg_destroy (msg);
+    flux_msg_destroy (rmsg);
+    return -1;
+}
+
 void usock_client_destroy (struct usock_client *client)
 {
     if (client) {
+        int saved_errno = errno;
         iobuf_clean (&client->in_iobuf);
         iobuf_clean (&client->out_iobuf);
-        ERRNO_SAFE_WRAP (free, client);
+        shmring_destroy (client->shm);
+        if (client->epfd >= 0)
+            (void)close (client->epfd);
+        free (client);
+        errno = saved_errno;
     }
 }
 
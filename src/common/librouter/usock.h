@@ -61,6 +61,11 @@ void usock_server_set_acceptor (struct usock_server *server,
                                 usock_acceptor_f cb,
                                 void *arg);
 
+/* Allow clients to move to shared memory rings of 'size' bytes per
+ * direction with usock_client_attach_shm().  Disabled if 'size' is 0.
+ */
+void usock_server_set_shm (struct usock_server *server, size_t size);
+
 /* Server connection for one client
  */
 
@@ -114,6 +119,12 @@ int usock_client_connect (const char *sockpath,
 struct usock_client *usock_client_create (int fd);
 void usock_client_destroy (struct usock_client *client);
 
+/* Ask the server to move this connection to shared memory.  Call before
+ * any other messages are sent.  On failure, e.g. ENOSYS if the server
+ * does not support it, the client may continue to use the socket.
+ */
+int usock_client_attach_shm (struct usock_client *client);
+
 #endif /* !_ROUTER_USOCK_H */
 
 /*
@@ -0,0 +1,291 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Follows the structure of the BLAKE3 reference implementation:
+ * input is split into 1K chunks, each compressed 64 bytes at a time,
+ * and chunk chaining values are merged into a binary tree with a
+ * stack, as soon as a subtree is complete.  The last chunk is kept
+ * until finalization, since the root node is compressed differently.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdbool.h>
+#include <string.h>
+
+#include "blake3.h"
+
+enum {
+    CHUNK_START = 1,
+    CHUNK_END = 2,
+    PARENT = 4,
+    ROOT = 8,
+};
+
+static const uint32_t iv[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+    0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+};
+
+/* Message word order for each of the 7 rounds.
+ */
+static const uint8_t schedule[7][16] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 },
+    { 3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1 },
+    { 10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6 },
+    { 12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4 },
+    { 9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7 },
+    { 11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13 },
+};
+
+static inline uint32_t rotr32 (uint32_t w, int c)
+{
+    return (w >> c) | (w << (32 - c));
+}
+
+static inline uint32_t load32 (const uint8_t *p)
+{
+    return (uint32_t)p[0]
+        | ((uint32_t)p[1] << 8)
+        | ((uint32_t)p[2] << 16)
+        | ((uint32_t)p[3] << 24);
+}
+
+static inline void store32 (uint8_t *p, uint32_t w)
+{
+    p[0] = w;
+    p[1] = w >> 8;
+    p[2] = w >> 16;
+    p[3] = w >> 24;
+}
+
+#define G(a,b,c,d,x,y) do { \
+    s[a] = s[a] + s[b] + (x); \
+    s[d] = rotr32 (s[d] ^ s[a], 16); \
+    s[c] = s[c] + s[d]; \
+    s[b] = rotr32 (s[b] ^ s[c], 12); \
+    s[a] = s[a] + s[b] + (y); \
+    s[d] = rotr32 (s[d] ^ s[a], 8); \
+    s[c] = s[c] + s[d]; \
+    s[b] = rotr32 (s[b] ^ s[c], 7); \
+} while (0)
+
+/* Compress 'block' into the 16 word state 's', starting from chaining
+ * value 'cv'.  The new chaining value is the first 8 words of 's'.
+ */
+static void compress (const uint32_t cv[8],
+                      const uint8_t block[BLAKE3_BLOCK_LEN],
+                      uint8_t block_len,
+                      uint64_t counter,
+                      uint8_t flags,
+                      uint32_t s[16])
+{
+    uint32_t m[16];
+    int r;
+    int i;
+
+    for (i = 0; i < 16; i++)
+        m[i] = load32 (block + 4 * i);
+    memcpy (s, cv, 8 * sizeof (uint32_t));
+    s[8] = iv[0];
+    s[9] = iv[1];
+    s[10] = iv[2];
+    s[11] = iv[3];
+    s[12] = (uint32_t)counter;
+    s[13] = (uint32_t)(counter >> 32);
+    s[14] = block_len;
+    s[15] = flags;
+    for (r = 0; r < 7; r++) {
+        const uint8_t *sc = schedule[r];
+
+        G (0, 4, 8, 12, m[sc[0]], m[sc[1]]);
+        G (1, 5, 9, 13, m[sc[2]], m[sc[3]]);
+        G (2, 6, 10, 14, m[sc[4]], m[sc[5]]);
+        G (3, 7, 11, 15, m[sc[6]], m[sc[7]]);
+        G (0, 5, 10, 15, m[sc[8]], m[sc[9]]);
+        G (1, 6, 11, 12, m[sc[10]], m[sc[11]]);
+        G (2, 7, 8, 13, m[sc[12]], m[sc[13]]);
+        G (3, 4, 9, 14, m[sc[14]], m[sc[15]]);
+    }
+    for (i = 0; i < 8; i++) {
+        s[i] ^= s[i + 8];
+        s[i + 8] ^= cv[i];
+    }
+}
+
+static void chunk_init (struct blake3_chunk_state *cs, uint64_t counter)
+{
+    memcpy (cs->cv, iv, sizeof (cs->cv));
+    cs->chunk_counter = counter;
+    memset (cs->buf, 0, sizeof (cs->buf));
+    cs->buf_len = 0;
+    cs->blocks_compressed = 0;
+}
+
+static size_t chunk_len (const struct blake3_chunk_state *cs)
+{
+    return BLAKE3_BLOCK_LEN * (size_t)cs->blocks_compressed + cs->buf_len;
+}
+
+static uint8_t chunk_start_flag (const struct blake3_chunk_state *cs)
+{
+    return cs->blocks_compressed == 0 ? CHUNK_START : 0;
+}
+
+static void chunk_compress_block (struct blake3_chunk_state *cs,
+                                  const uint8_t *block)
+{
+    uint32_t s[16];
+
+    compress (cs->cv,
+              block,
+              BLAKE3_BLOCK_LEN,
+              cs->chunk_counter,
+              chunk_start_flag (cs),
+              s);
+    memcpy (cs->cv, s, sizeof (cs->cv));
+    cs->blocks_compressed++;
+}
+
+/* Add up to a chunk's worth of input.  A full block is only compressed
+ * once more input follows it, since the last block is flagged CHUNK_END.
+ */
+static void chunk_update (struct blake3_chunk_state *cs,
+                          const uint8_t *data,
+                          size_t len)
+{
+    if (cs->buf_len > 0) {
+        size_t take = BLAKE3_BLOCK_LEN - cs->buf_len;
+
+        if (take > len)
+            take = len;
+        memcpy (cs->buf + cs->buf_len, data, take);
+        cs->buf_len += take;
+        data += take;
+        len -= take;
+        if (len > 0) {
+            chunk_compress_block (cs, cs->buf);
+            memset (cs->buf, 0, sizeof (cs->buf));
+            cs->buf_len = 0;
+        }
+    }
+    while (len > BLAKE3_BLOCK_LEN) {
+        chunk_compress_block (cs, data);
+        data += BLAKE3_BLOCK_LEN;
+        len -= BLAKE3_BLOCK_LEN;
+    }
+    if (len > 0) {
+        memcpy (cs->buf + cs->buf_len, data, len);
+        cs->buf_len += len;
+    }
+}
+
+/* Compress the last block of a chunk.  If 'root' is true, the output
+ * is the hash; otherwise it is the chunk chaining value.
+ */
+static void chunk_output (const struct blake3_chunk_state *cs,
+                          bool root,
+                          uint32_t out[8])
+{
+    uint32_t s[16];
+
+    compress (cs->cv,
+              cs->buf,
+              cs->buf_len,
+              cs->chunk_counter,
+              chunk_start_flag (cs) | CHUNK_END | (root ? ROOT : 0),
+              s);
+    memcpy (out, s, 8 * sizeof (uint32_t));
+}
+
+static void parent_output (const uint32_t left[8],
+                           const uint32_t right[8],
+                           bool root,
+                           uint32_t out[8])
+{
+    uint8_t block[BLAKE3_BLOCK_LEN];
+    uint32_t s[16];
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        store32 (block + 4 * i, left[i]);
+        store32 (block + 32 + 4 * i, right[i]);
+    }
+    compress (iv, block, BLAKE3_BLOCK_LEN, 0, PARENT | (root ? ROOT : 0), s);
+    memcpy (out, s, 8 * sizeof (uint32_t));
+}
+
+/* Push the chaining value of a completed chunk, first merging the
+ * subtrees that it completes.  The number of completed subtrees is
+ * the number of trailing zero bits in the new chunk count.
+ */
+static void push_chunk_cv (BLAKE3_CTX *ctx, uint32_t cv[8], uint64_t total)
+{
+    while ((total & 1) == 0) {
+        ctx->cv_stack_len--;
+        parent_output (ctx->cv_stack[ctx->cv_stack_len], cv, false, cv);
+        total >>= 1;
+    }
+    memcpy (ctx->cv_stack[ctx->cv_stack_len], cv, 8 * sizeof (uint32_t));
+    ctx->cv_stack_len++;
+}
+
+void blake3_init (BLAKE3_CTX *ctx)
+{
+    chunk_init (&ctx->chunk, 0);
+    ctx->cv_stack_len = 0;
+}
+
+void blake3_update (BLAKE3_CTX *ctx, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+
+    while (len > 0) {
+        size_t take;
+
+        if (chunk_len (&ctx->chunk) == BLAKE3_CHUNK_LEN) {
+            uint32_t cv[8];
+            uint64_t total = ctx->chunk.chunk_counter + 1;
+
+            chunk_output (&ctx->chunk, false, cv);
+            push_chunk_cv (ctx, cv, total);
+            chunk_init (&ctx->chunk, total);
+        }
+        take = BLAKE3_CHUNK_LEN - chunk_len (&ctx->chunk);
+        if (take > len)
+            take = len;
+        chunk_update (&ctx->chunk, p, take);
+        p += take;
+        len -= take;
+    }
+}
+
+void blake3_final (BLAKE3_CTX *ctx, uint8_t hash[BLAKE3_OUT_LEN])
+{
+    uint32_t out[8];
+    int n = ctx->cv_stack_len;
+    int i;
+
+    if (n == 0)
+        chunk_output (&ctx->chunk, true, out);
+    else {
+        chunk_output (&ctx->chunk, false, out);
+        while (n-- > 0)
+            parent_output (ctx->cv_stack[n], out, n == 0, out);
+    }
+    for (i = 0; i < 8; i++)
+        store32 (hash + 4 * i, out[i]);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,48 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_BLAKE3_H
+#define _UTIL_BLAKE3_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*  Portable BLAKE3 hash with the default 32 byte output.
+ *   See https://github.com/BLAKE3-team/BLAKE3-specs
+ */
+
+#define BLAKE3_OUT_LEN      32
+#define BLAKE3_BLOCK_LEN    64
+#define BLAKE3_CHUNK_LEN    1024
+#define BLAKE3_MAX_DEPTH    54
+
+struct blake3_chunk_state {
+    uint32_t cv[8];
+    uint64_t chunk_counter;
+    uint8_t buf[BLAKE3_BLOCK_LEN];
+    uint8_t buf_len;
+    uint8_t blocks_compressed;
+};
+
+typedef struct {
+    struct blake3_chunk_state chunk;
+    uint8_t cv_stack_len;
+    uint32_t cv_stack[BLAKE3_MAX_DEPTH + 1][8];
+} BLAKE3_CTX;
+
+void blake3_init (BLAKE3_CTX *ctx);
+void blake3_update (BLAKE3_CTX *ctx, const void *data, size_t len);
+void blake3_final (BLAKE3_CTX *ctx, uint8_t hash[BLAKE3_OUT_LEN]);
+
+#endif /* !_UTIL_BLAKE3_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
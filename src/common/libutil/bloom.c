@@ -0,0 +1,200 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include "bloom.h"
+
+#define BLOCK_BITS  512
+#define BLOCK_WORDS (BLOCK_BITS / 64)
+
+struct bloom {
+    uint64_t *blocks;
+    size_t nblocks;
+    int k;                  /* bits set per key */
+    size_t count;
+    size_t capacity;
+};
+
+static inline uint64_t rotl64 (uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64 (uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+/* 64-bit hash in the style of MurmurHash3.
+ */
+static uint64_t hash64 (const void *key, size_t len)
+{
+    const uint8_t *p = key;
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ (len * 0x87c37b91114253d5ULL);
+    uint64_t k;
+
+    while (len >= 8) {
+        memcpy (&k, p, 8);
+        k *= 0x87c37b91114253d5ULL;
+        k = rotl64 (k, 31);
+        k *= 0x4cf5ad432745937fULL;
+        h ^= k;
+        h = rotl64 (h, 27) * 5 + 0x52dce729;
+        p += 8;
+        len -= 8;
+    }
+    if (len > 0) {
+        k = 0;
+        memcpy (&k, p, len);
+        k *= 0x87c37b91114253d5ULL;
+        k = rotl64 (k, 31);
+        k *= 0x4cf5ad432745937fULL;
+        h ^= k;
+    }
+    return fmix64 (h);
+}
+
+/* Select the block for 'key', and the start and stride of its bit
+ * positions within the block.  An odd stride visits k distinct bits.
+ */
+static uint64_t *key_block (struct bloom *b,
+                            const void *key,
+                            size_t len,
+                            unsigned int *start,
+                            unsigned int *stride)
+{
+    uint64_t h = hash64 (key, len);
+    uint64_t h2 = fmix64 (h ^ 0x9e3779b97f4a7c15ULL);
+
+    *start = h2 % BLOCK_BITS;
+    *stride = ((h2 >> 9) % BLOCK_BITS) | 1;
+    return b->blocks + (h % b->nblocks) * BLOCK_WORDS;
+}
+
+void bloom_add (struct bloom *b, const void *key, size_t len)
+{
+    unsigned int bit, stride;
+    uint64_t *block;
+    int i;
+
+    if (!b)
+        return;
+    block = key_block (b, key, len, &bit, &stride);
+    for (i = 0; i < b->k; i++) {
+        block[bit / 64] |= 1ULL << (bit % 64);
+        bit = (bit + stride) % BLOCK_BITS;
+    }
+    b->count++;
+}
+
+bool bloom_check (struct bloom *b, const void *key, size_t len)
+{
+    unsigned int bit, stride;
+    uint64_t *block;
+    int i;
+
+    if (!b)
+        return true;
+    block = key_block (b, key, len, &bit, &stride);
+    for (i = 0; i < b->k; i++) {
+        if (!(block[bit / 64] & (1ULL << (bit % 64))))
+            return false;
+        bit = (bit + stride) % BLOCK_BITS;
+    }
+    return true;
+}
+
+void bloom_clear (struct bloom *b)
+{
+    if (b) {
+        memset (b->blocks, 0, b->nblocks * BLOCK_WORDS * sizeof (uint64_t));
+        b->count = 0;
+    }
+}
+
+size_t bloom_count (struct bloom *b)
+{
+    return b ? b->count : 0;
+}
+
+size_t bloom_capacity (struct bloom *b)
+{
+    return b ? b->capacity : 0;
+}
+
+size_t bloom_size (struct bloom *b)
+{
+    return b ? b->nblocks * BLOCK_WORDS * sizeof (uint64_t) : 0;
+}
+
+double bloom_fp_rate (struct bloom *b)
+{
+    double m;
+
+    if (!b || b->count == 0)
+        return 0.;
+    m = (double)b->nblocks * BLOCK_BITS;
+    return pow (1. - exp (-b->k * (double)b->count / m), b->k);
+}
+
+struct bloom *bloom_create (size_t capacity, double fp_rate)
+{
+    struct bloom *b;
+    double bits_per_key;
+    size_t nbits;
+
+    if (capacity == 0 || fp_rate <= 0. || fp_rate >= 1.) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(b = calloc (1, sizeof (*b))))
+        return NULL;
+    bits_per_key = -log (fp_rate) / (M_LN2 * M_LN2);
+    b->k = (int)lround (bits_per_key * M_LN2);
+    if (b->k < 1)
+        b->k = 1;
+    if (b->k > 16)
+        b->k = 16;
+    nbits = (size_t)ceil (capacity * bits_per_key);
+    b->nblocks = (nbits + BLOCK_BITS - 1) / BLOCK_BITS;
+    b->capacity = capacity;
+    if (!(b->blocks = calloc (b->nblocks * BLOCK_WORDS, sizeof (uint64_t)))) {
+        free (b);
+        return NULL;
+    }
+    return b;
+}
+
+void bloom_destroy (struct bloom *b)
+{
+    if (b) {
+        int saved_errno = errno;
+        free (b->blocks);
+        free (b);
+        errno = saved_errno;
+    }
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,63 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_BLOOM_H
+#define _UTIL_BLOOM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*  Blocked Bloom filter.  All bits for a key are placed in a single
+ *   64 byte block, so a check touches one cache line.
+ *
+ *  bloom_check() never returns false for a key that was added, and
+ *   returns true for a key that was not added with a probability that
+ *   grows with the number of keys added.  The filter is sized so that
+ *   it is about 'fp_rate' when 'capacity' keys have been added.
+ *   Keys cannot be removed.
+ */
+
+struct bloom;
+
+/*  Create a filter for 'capacity' keys with false positive rate
+ *   'fp_rate' (0 < fp_rate < 1).  Returns NULL on error with errno set.
+ */
+struct bloom *bloom_create (size_t capacity, double fp_rate);
+
+void bloom_destroy (struct bloom *b);
+
+void bloom_add (struct bloom *b, const void *key, size_t len);
+
+/*  Return false if 'key' was definitely not added, true if it may
+ *   have been.
+ */
+bool bloom_check (struct bloom *b, const void *key, size_t len);
+
+/*  Remove all keys.
+ */
+void bloom_clear (struct bloom *b);
+
+/*  Return the number of keys added, the capacity the filter was
+ *   created with, and the size of the filter in bytes.
+ */
+size_t bloom_count (struct bloom *b);
+size_t bloom_capacity (struct bloom *b);
+size_t bloom_size (struct bloom *b);
+
+/*  Return the expected false positive rate for the number of keys
+ *   added so far.
+ */
+double bloom_fp_rate (struct bloom *b);
+
+#endif /* !_UTIL_BLOOM_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,275 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* The SHA extensions compute four rounds per instruction, and also the
+ * message schedule.  Functions using them are compiled with a target
+ * attribute, so the rest of the tree does not need -msha, and they are
+ * only called after a cpuid check.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <stdlib.h>
+
+#include "sha_accel.h"
+
+#if defined(__x86_64__) \
+    && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define HAVE_SHA_NI 1
+#endif
+
+#if HAVE_SHA_NI
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define SHA_NI_TARGET __attribute__ ((target ("sha,sse4.1,ssse3")))
+
+static const uint32_t sha1_init[5] = {
+    0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0,
+};
+
+static const uint32_t sha256_init[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/* Four rounds of SHA-1 (group 'g' of 20).  Message words for later
+ * groups are computed three groups ahead, in the w[] slots that are
+ * no longer needed.
+ */
+#define SHA1_ROUNDS4(g) do { \
+    if ((g) == 0) \
+        e = _mm_add_epi32 (e0, w[0]); \
+    else \
+        e = _mm_sha1nexte_epu32 (esave, w[(g) & 3]); \
+    esave = abcd; \
+    if ((g) >= 3 && (g) <= 18) \
+        w[((g) + 1) & 3] = _mm_sha1msg2_epu32 (w[((g) + 1) & 3], w[(g) & 3]); \
+    abcd = _mm_sha1rnds4_epu32 (abcd, e, (g) / 5); \
+    if ((g) >= 1 && (g) <= 16) \
+        w[((g) + 3) & 3] = _mm_sha1msg1_epu32 (w[((g) + 3) & 3], w[(g) & 3]); \
+    if ((g) >= 2 && (g) <= 17) \
+        w[((g) + 2) & 3] = _mm_xor_si128 (w[((g) + 2) & 3], w[(g) & 3]); \
+} while (0)
+
+SHA_NI_TARGET
+static void sha1_blocks (uint32_t state[5], const uint8_t *data, size_t n)
+{
+    const __m128i mask = _mm_set_epi64x (0x0001020304050607ULL,
+                                         0x08090a0b0c0d0e0fULL);
+    __m128i abcd, e0, e, esave, abcd_save;
+    __m128i w[4];
+    int i;
+
+    abcd = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *)state), 0x1B);
+    e0 = _mm_set_epi32 (state[4], 0, 0, 0);
+
+    while (n-- > 0) {
+        abcd_save = abcd;
+        for (i = 0; i < 4; i++) {
+            w[i] = _mm_loadu_si128 ((const __m128i *)(data + 16 * i));
+            w[i] = _mm_shuffle_epi8 (w[i], mask);
+        }
+        SHA1_ROUNDS4 (0);
+        SHA1_ROUNDS4 (1);
+        SHA1_ROUNDS4 (2);
+        SHA1_ROUNDS4 (3);
+        SHA1_ROUNDS4 (4);
+        SHA1_ROUNDS4 (5);
+        SHA1_ROUNDS4 (6);
+        SHA1_ROUNDS4 (7);
+        SHA1_ROUNDS4 (8);
+        SHA1_ROUNDS4 (9);
+        SHA1_ROUNDS4 (10);
+        SHA1_ROUNDS4 (11);
+        SHA1_ROUNDS4 (12);
+        SHA1_ROUNDS4 (13);
+        SHA1_ROUNDS4 (14);
+        SHA1_ROUNDS4 (15);
+        SHA1_ROUNDS4 (16);
+        SHA1_ROUNDS4 (17);
+        SHA1_ROUNDS4 (18);
+        SHA1_ROUNDS4 (19);
+        e0 = _mm_sha1nexte_epu32 (esave, e0);
+        abcd = _mm_add_epi32 (abcd, abcd_save);
+        data += 64;
+    }
+    _mm_storeu_si128 ((__m128i *)state, _mm_shuffle_epi32 (abcd, 0x1B));
+    state[4] = _mm_extract_epi32 (e0, 3);
+}
+
+SHA_NI_TARGET
+static void sha256_blocks (uint32_t state[8], const uint8_t *data, size_t n)
+{
+    const __m128i mask = _mm_set_epi64x (0x0c0d0e0f08090a0bULL,
+                                         0x0405060700010203ULL);
+    __m128i state0, state1, tmp, msg, abef_save, cdgh_save;
+    __m128i w[4];
+    int i;
+
+    tmp = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *)&state[0]),
+                             0xB1);                             // CDAB
+    state1 = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *)&state[4]),
+                                0x1B);                          // EFGH
+    state0 = _mm_alignr_epi8 (tmp, state1, 8);                  // ABEF
+    state1 = _mm_blend_epi16 (state1, tmp, 0xF0);               // CDGH
+
+    while (n-- > 0) {
+        abef_save = state0;
+        cdgh_save = state1;
+        for (i = 0; i < 16; i++) {
+            if (i < 4) {
+                w[i] = _mm_loadu_si128 ((const __m128i *)(data + 16 * i));
+                w[i] = _mm_shuffle_epi8 (w[i], mask);
+            }
+            else {
+                /* W[t] = s1(W[t-2]) + W[t-7] + s0(W[t-15]) + W[t-16]
+                 */
+                tmp = _mm_sha256msg1_epu32 (w[i & 3], w[(i + 1) & 3]);
+                tmp = _mm_add_epi32 (tmp, _mm_alignr_epi8 (w[(i + 3) & 3],
+                                                           w[(i + 2) & 3],
+                                                           4));
+                w[i & 3] = _mm_sha256msg2_epu32 (tmp, w[(i + 3) & 3]);
+            }
+            msg = _mm_add_epi32 (w[i & 3],
+                                 _mm_loadu_si128 ((const __m128i *)
+                                                  &sha256_k[4 * i]));
+            state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+            msg = _mm_shuffle_epi32 (msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32 (state0, state1, msg);
+        }
+        state0 = _mm_add_epi32 (state0, abef_save);
+        state1 = _mm_add_epi32 (state1, cdgh_save);
+        data += 64;
+    }
+    tmp = _mm_shuffle_epi32 (state0, 0x1B);                     // FEBA
+    state1 = _mm_shuffle_epi32 (state1, 0xB1);                  // DCHG
+    state0 = _mm_blend_epi16 (tmp, state1, 0xF0);               // DCBA
+    state1 = _mm_alignr_epi8 (state1, tmp, 8);                  // ABEF
+    _mm_storeu_si128 ((__m128i *)&state[0], state0);
+    _mm_storeu_si128 ((__m128i *)&state[4], state1);
+}
+
+static void store_be32 (uint8_t *p, uint32_t w)
+{
+    p[0] = w >> 24;
+    p[1] = w >> 16;
+    p[2] = w >> 8;
+    p[3] = w;
+}
+
+/* Hash the whole blocks of 'data', then the padded tail, which is one
+ * or two blocks.  SHA-1 and SHA-256 pad the same way.
+ */
+static void sha_accel_hash (void (*blocks)(uint32_t *, const uint8_t *, size_t),
+                            uint32_t *state,
+                            const uint8_t *data,
+                            size_t len)
+{
+    uint8_t tail[128];
+    size_t full = len / 64;
+    size_t rem = len % 64;
+    size_t tail_len = rem < 56 ? 64 : 128;
+    uint64_t bits = (uint64_t)len * 8;
+
+    if (full > 0)
+        blocks (state, data, full);
+    memset (tail, 0, sizeof (tail));
+    if (rem > 0)
+        memcpy (tail, data + full * 64, rem);
+    tail[rem] = 0x80;
+    store_be32 (tail + tail_len - 8, bits >> 32);
+    store_be32 (tail + tail_len - 4, bits);
+    blocks (state, tail, tail_len / 64);
+}
+
+void sha1_accel (const void *data, size_t len, uint8_t digest[20])
+{
+    uint32_t state[5];
+    int i;
+
+    memcpy (state, sha1_init, sizeof (state));
+    sha_accel_hash (sha1_blocks, state, data, len);
+    for (i = 0; i < 5; i++)
+        store_be32 (digest + 4 * i, state[i]);
+}
+
+void sha256_accel (const void *data, size_t len, uint8_t digest[32])
+{
+    uint32_t state[8];
+    int i;
+
+    memcpy (state, sha256_init, sizeof (state));
+    sha_accel_hash (sha256_blocks, state, data, len);
+    for (i = 0; i < 8; i++)
+        store_be32 (digest + 4 * i, state[i]);
+}
+
+bool sha_accel_available (void)
+{
+    static int available = -1;
+
+    if (available < 0) {
+        unsigned int eax, ebx, ecx, edx;
+        bool sha = false;
+        bool sse = false;
+
+        if (__get_cpuid (1, &eax, &ebx, &ecx, &edx))
+            sse = (ecx & bit_SSSE3) && (ecx & bit_SSE4_1);
+        if (__get_cpuid_count (7, 0, &eax, &ebx, &ecx, &edx))
+            sha = (ebx & bit_SHA);
+        available = (sha && sse) ? 1 : 0;
+    }
+    return available;
+}
+
+#else /* !HAVE_SHA_NI */
+
+bool sha_accel_available (void)
+{
+    return false;
+}
+
+void sha1_accel (const void *data, size_t len, uint8_t digest[20])
+{
+    abort ();
+}
+
+void sha256_accel (const void *data, size_t len, uint8_t digest[32])
+{
+    abort ();
+}
+
+#endif /* !HAVE_SHA_NI */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,35 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_SHA_ACCEL_H
+#define _UTIL_SHA_ACCEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*  SHA-1 and SHA-256 using the x86 SHA extensions (SHA-NI).
+ *
+ *  sha_accel_available() returns true if the CPU supports them and
+ *   the code was built for x86_64.  The hash functions must not be
+ *   called otherwise.  The result is identical to sha1.c and sha256.c.
+ */
+
+bool sha_accel_available (void);
+
+void sha1_accel (const void *data, size_t len, uint8_t digest[20]);
+
+void sha256_accel (const void *data, size_t len, uint8_t digest[32]);
+
+#endif /* !_UTIL_SHA_ACCEL_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
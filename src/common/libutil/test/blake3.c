@@ -0,0 +1,138 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/blake3.h"
+
+/* Test vectors from the BLAKE3 repository (test_vectors.json), which
+ * hash the byte sequence 0, 1, ..., 250, 0, 1, ... of each length.
+ */
+static struct {
+    size_t len;
+    const char *hash;
+} vectors[] = {
+    { 0,
+      "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262" },
+    { 1,
+      "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213" },
+    { 63,
+      "e9bc37a594daad83be9470df7f7b3798297c3d834ce80ba85d6e207627b7db7b" },
+    { 64,
+      "4eed7141ea4a5cd4b788606bd23f46e212af9cacebacdc7d1f4c6dc7f2511b98" },
+    { 65,
+      "de1e5fa0be70df6d2be8fffd0e99ceaa8eb6e8c93a63f2d8d1c30ecb6b263dee" },
+    { 1023,
+      "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11" },
+    { 1024,
+      "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7" },
+    { 1025,
+      "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444" },
+    { 2048,
+      "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a" },
+    { 2049,
+      "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030" },
+    { 3072,
+      "b98cb0ff3623be03326b373de6b9095218513e64f1ee2edd2525c7ad1e5cffd2" },
+    { 3073,
+      "7124b49501012f81cc7f11ca069ec9226cecb8a2c850cfe644e327d22d3e1cd3" },
+    { 4096,
+      "015094013f57a5277b59d8475c0501042c0b642e531b0a1c8f58d2163229e969" },
+    { 4097,
+      "9b4052b38f1c5fc8b1f9ff7ac7b27cd242487b3d890d15c96a1c25b8aa0fb995" },
+    { 5120,
+      "9cadc15fed8b5d854562b26a9536d9707cadeda9b143978f319ab34230535833" },
+    { 5121,
+      "628bd2cb2004694adaab7bbd778a25df25c47b9d4155a55f8fbd79f2fe154cff" },
+    { 8192,
+      "aae792484c8efe4f19e2ca7d371d8c467ffb10748d8a5a1ae579948f718a2a63" },
+    { 8193,
+      "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b" },
+    { 16384,
+      "f875d6646de28985646f34ee13be9a576fd515f76b5b0a26bb324735041ddde4" },
+    { 31744,
+      "62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47" },
+    { 102400,
+      "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085" },
+};
+
+static void tohex (const uint8_t *hash, char *s)
+{
+    int i;
+    for (i = 0; i < BLAKE3_OUT_LEN; i++)
+        sprintf (s + 2 * i, "%02x", hash[i]);
+}
+
+static void hash_chunked (const uint8_t *data,
+                          size_t len,
+                          size_t stride,
+                          uint8_t *hash)
+{
+    BLAKE3_CTX ctx;
+    size_t off = 0;
+
+    blake3_init (&ctx);
+    while (off < len) {
+        size_t n = len - off < stride ? len - off : stride;
+        blake3_update (&ctx, data + off, n);
+        off += n;
+    }
+    blake3_final (&ctx, hash);
+}
+
+int main (int argc, char *argv[])
+{
+    size_t maxlen = vectors[sizeof (vectors) / sizeof (vectors[0]) - 1].len;
+    uint8_t *data;
+    uint8_t hash[BLAKE3_OUT_LEN];
+    char s[BLAKE3_OUT_LEN * 2 + 1];
+    size_t strides[] = { 1, 63, 64, 65, 1024, 4099 };
+    size_t i, j;
+
+    plan (NO_PLAN);
+
+    if (!(data = malloc (maxlen)))
+        BAIL_OUT ("out of memory");
+    for (i = 0; i < maxlen; i++)
+        data[i] = i % 251;
+
+    for (i = 0; i < sizeof (vectors) / sizeof (vectors[0]); i++) {
+        hash_chunked (data, vectors[i].len, vectors[i].len + 1, hash);
+        tohex (hash, s);
+        ok (strcmp (s, vectors[i].hash) == 0,
+            "blake3 of %zu bytes is correct", vectors[i].len);
+    }
+    for (j = 0; j < sizeof (strides) / sizeof (strides[0]); j++) {
+        int errors = 0;
+        for (i = 0; i < sizeof (vectors) / sizeof (vectors[0]); i++) {
+            hash_chunked (data, vectors[i].len, strides[j], hash);
+            tohex (hash, s);
+            if (strcmp (s, vectors[i].hash) != 0)
+                errors++;
+        }
+        ok (errors == 0,
+            "blake3 is correct when updated %zu bytes at a time",
+            strides[j]);
+    }
+
+    free (data);
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
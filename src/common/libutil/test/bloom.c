@@ -0,0 +1,139 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/bloom.h"
+
+static void key_make (char *key, size_t len, int i)
+{
+    snprintf (key, len, "key-%d", i);
+}
+
+static void test_invalid (void)
+{
+    errno = 0;
+    ok (bloom_create (0, 0.01) == NULL && errno == EINVAL,
+        "bloom_create capacity=0 fails with EINVAL");
+    errno = 0;
+    ok (bloom_create (100, 0.) == NULL && errno == EINVAL,
+        "bloom_create fp_rate=0 fails with EINVAL");
+    errno = 0;
+    ok (bloom_create (100, 1.) == NULL && errno == EINVAL,
+        "bloom_create fp_rate=1 fails with EINVAL");
+    ok (bloom_check (NULL, "foo", 3) == true,
+        "bloom_check b=NULL returns true");
+    ok (bloom_count (NULL) == 0 && bloom_size (NULL) == 0,
+        "bloom_count/size b=NULL return 0");
+    lives_ok ({bloom_add (NULL, "foo", 3);},
+        "bloom_add b=NULL doesn't crash");
+    lives_ok ({bloom_destroy (NULL);},
+        "bloom_destroy b=NULL doesn't crash");
+}
+
+static void test_basic (void)
+{
+    const int capacity = 10000;
+    struct bloom *b;
+    char key[64];
+    int missing = 0;
+    int fp = 0;
+    int i;
+
+    b = bloom_create (capacity, 0.01);
+    ok (b != NULL,
+        "bloom_create capacity=%d fp_rate=0.01 works", capacity);
+    ok (bloom_capacity (b) == capacity,
+        "bloom_capacity returns capacity");
+    ok (bloom_size (b) > 0 && bloom_size (b) % 64 == 0,
+        "bloom_size returns a multiple of the block size");
+    ok (bloom_fp_rate (b) == 0.,
+        "bloom_fp_rate is 0 when empty");
+    ok (bloom_check (b, "foo", 3) == false,
+        "bloom_check on empty filter returns false");
+
+    for (i = 0; i < capacity; i++) {
+        key_make (key, sizeof (key), i);
+        bloom_add (b, key, strlen (key));
+    }
+    ok (bloom_count (b) == capacity,
+        "bloom_count returns %d", capacity);
+    for (i = 0; i < capacity; i++) {
+        key_make (key, sizeof (key), i);
+        if (!bloom_check (b, key, strlen (key)))
+            missing++;
+    }
+    ok (missing == 0,
+        "bloom_check returns true for all added keys");
+    for (i = capacity; i < capacity * 11; i++) {
+        key_make (key, sizeof (key), i);
+        if (bloom_check (b, key, strlen (key)))
+            fp++;
+    }
+    diag ("measured fp rate %.4f, expected %.4f",
+          (double)fp / (capacity * 10),
+          bloom_fp_rate (b));
+    ok ((double)fp / (capacity * 10) < 0.03,
+        "false positive rate is close to the requested rate");
+    ok (bloom_fp_rate (b) > 0.005 && bloom_fp_rate (b) < 0.02,
+        "bloom_fp_rate estimate is close to the requested rate");
+
+    bloom_clear (b);
+    ok (bloom_count (b) == 0,
+        "bloom_clear resets count");
+    ok (bloom_check (b, "key-0", 5) == false,
+        "bloom_check returns false after bloom_clear");
+
+    bloom_destroy (b);
+}
+
+static void test_binary_keys (void)
+{
+    struct bloom *b;
+    char key[20];
+    int missing = 0;
+    int i;
+
+    b = bloom_create (1000, 0.001);
+    ok (b != NULL,
+        "bloom_create capacity=1000 fp_rate=0.001 works");
+    memset (key, 0, sizeof (key));
+    for (i = 0; i < 1000; i++) {
+        memcpy (key + sizeof (key) - sizeof (i), &i, sizeof (i));
+        bloom_add (b, key, sizeof (key));
+    }
+    for (i = 0; i < 1000; i++) {
+        memcpy (key + sizeof (key) - sizeof (i), &i, sizeof (i));
+        if (!bloom_check (b, key, sizeof (key)))
+            missing++;
+    }
+    ok (missing == 0,
+        "bloom_check finds 20 byte keys differing only in the tail");
+    bloom_destroy (b);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_invalid ();
+    test_basic ();
+    test_binary_keys ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
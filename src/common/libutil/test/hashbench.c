@@ -0,0 +1,181 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* hashbench - compare blobref hash implementations
+ *
+ * Usage: hashbench [MBYTES]
+ *
+ * Hash about MBYTES (default 256) of data with each implementation,
+ * for a range of blob sizes, and print throughput in MB/s as a JSON
+ * object:
+ *
+ *   {"results":[{"name":s, "size":i, "count":i, "elapsed":f,
+ *                "mb_per_sec":f}, ...]}
+ *
+ * The sha1-accel and sha256-accel implementations are skipped if the
+ * CPU lacks the SHA extensions.  The blobref_hash() results show what
+ * the content store sees for each content.hash setting.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/sha1.h"
+#include "src/common/libutil/sha256.h"
+#include "src/common/libutil/sha_accel.h"
+#include "src/common/libutil/blake3.h"
+#include "src/common/libutil/blobref.h"
+
+typedef void (*hash_f)(const void *data, size_t len);
+
+static void hash_sha1 (const void *data, size_t len)
+{
+    SHA1_CTX ctx;
+    uint8_t digest[SHA1_DIGEST_SIZE];
+
+    SHA1_Init (&ctx);
+    SHA1_Update (&ctx, data, len);
+    SHA1_Final (&ctx, digest);
+}
+
+static void hash_sha256 (const void *data, size_t len)
+{
+    SHA256_CTX ctx;
+    uint8_t digest[SHA256_BLOCK_SIZE];
+
+    sha256_init (&ctx);
+    sha256_update (&ctx, data, len);
+    sha256_final (&ctx, digest);
+}
+
+static void hash_sha1_accel (const void *data, size_t len)
+{
+    uint8_t digest[20];
+
+    sha1_accel (data, len, digest);
+}
+
+static void hash_sha256_accel (const void *data, size_t len)
+{
+    uint8_t digest[32];
+
+    sha256_accel (data, len, digest);
+}
+
+static void hash_blake3 (const void *data, size_t len)
+{
+    BLAKE3_CTX ctx;
+    uint8_t hash[BLAKE3_OUT_LEN];
+
+    blake3_init (&ctx);
+    blake3_update (&ctx, data, len);
+    blake3_final (&ctx, hash);
+}
+
+static void blobref (const char *hashtype, const void *data, size_t len)
+{
+    char ref[BLOBREF_MAX_STRING_SIZE];
+
+    if (blobref_hash (hashtype, data, len, ref, sizeof (ref)) < 0)
+        log_err_exit ("blobref_hash %s", hashtype);
+}
+
+static void blobref_sha1 (const void *data, size_t len)
+{
+    blobref ("sha1", data, len);
+}
+
+static void blobref_sha256 (const void *data, size_t len)
+{
+    blobref ("sha256", data, len);
+}
+
+static void blobref_blake3 (const void *data, size_t len)
+{
+    blobref ("blake3", data, len);
+}
+
+static struct {
+    const char *name;
+    hash_f fun;
+    bool accel;
+} impls[] = {
+    { "sha1", hash_sha1, false },
+    { "sha1-accel", hash_sha1_accel, true },
+    { "sha256", hash_sha256, false },
+    { "sha256-accel", hash_sha256_accel, true },
+    { "blake3", hash_blake3, false },
+    { "blobref-sha1", blobref_sha1, false },
+    { "blobref-sha256", blobref_sha256, false },
+    { "blobref-blake3", blobref_blake3, false },
+};
+
+static size_t sizes[] = { 64, 1024, 4096, 65536, 1048576 };
+
+int main (int argc, char *argv[])
+{
+    size_t total = 256;
+    size_t maxsize = sizes[sizeof (sizes) / sizeof (sizes[0]) - 1];
+    bool first = true;
+    uint8_t *data;
+    size_t i, j;
+
+    log_init ("hashbench");
+
+    if (argc > 2 || (argc == 2 && (total = strtoul (argv[1], NULL, 10)) == 0))
+        log_msg_exit ("Usage: hashbench [MBYTES]");
+    total *= 1024 * 1024;
+
+    if (!(data = malloc (maxsize)))
+        log_err_exit ("malloc");
+    for (i = 0; i < maxsize; i++)
+        data[i] = i % 251;
+
+    printf ("{\"results\":[");
+    for (i = 0; i < sizeof (impls) / sizeof (impls[0]); i++) {
+        if (impls[i].accel && !sha_accel_available ())
+            continue;
+        for (j = 0; j < sizeof (sizes) / sizeof (sizes[0]); j++) {
+            size_t count = total / sizes[j];
+            struct timespec t0;
+            double elapsed;
+            size_t k;
+
+            monotime (&t0);
+            for (k = 0; k < count; k++)
+                impls[i].fun (data, sizes[j]);
+            elapsed = monotime_since (t0) * 1E-3;
+
+            printf ("%s\n {\"name\":\"%s\", \"size\":%zu, \"count\":%zu,"
+                    " \"elapsed\":%.6f, \"mb_per_sec\":%.1f}",
+                    first ? "" : ",",
+                    impls[i].name,
+                    sizes[j],
+                    count,
+                    elapsed,
+                    elapsed > 0 ? (count * sizes[j]) / elapsed / 1048576 : 0);
+            first = false;
+        }
+    }
+    printf ("\n]}\n");
+
+    free (data);
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,125 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <stdlib.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/sha1.h"
+#include "src/common/libutil/sha256.h"
+#include "src/common/libutil/sha_accel.h"
+
+static void sha1_portable (const void *data, size_t len, uint8_t *digest)
+{
+    SHA1_CTX ctx;
+
+    SHA1_Init (&ctx);
+    SHA1_Update (&ctx, data, len);
+    SHA1_Final (&ctx, digest);
+}
+
+static void sha256_portable (const void *data, size_t len, uint8_t *digest)
+{
+    SHA256_CTX ctx;
+
+    sha256_init (&ctx);
+    sha256_update (&ctx, data, len);
+    sha256_final (&ctx, digest);
+}
+
+/* Compare against the portable code for every length up to a few
+ * blocks, which covers the one and two block padding cases, and some
+ * larger lengths.
+ */
+static void test_lengths (const uint8_t *data)
+{
+    size_t big[] = { 1000, 4096, 65535, 65536, 1048577 };
+    uint8_t d1[32], d2[32];
+    int sha1_errors = 0;
+    int sha256_errors = 0;
+    size_t len;
+    int i;
+
+    for (len = 0; len <= 300; len++) {
+        sha1_portable (data, len, d1);
+        sha1_accel (data, len, d2);
+        if (memcmp (d1, d2, SHA1_DIGEST_SIZE) != 0)
+            sha1_errors++;
+        sha256_portable (data, len, d1);
+        sha256_accel (data, len, d2);
+        if (memcmp (d1, d2, SHA256_BLOCK_SIZE) != 0)
+            sha256_errors++;
+    }
+    for (i = 0; i < sizeof (big) / sizeof (big[0]); i++) {
+        sha1_portable (data, big[i], d1);
+        sha1_accel (data, big[i], d2);
+        if (memcmp (d1, d2, SHA1_DIGEST_SIZE) != 0)
+            sha1_errors++;
+        sha256_portable (data, big[i], d1);
+        sha256_accel (data, big[i], d2);
+        if (memcmp (d1, d2, SHA256_BLOCK_SIZE) != 0)
+            sha256_errors++;
+    }
+    ok (sha1_errors == 0,
+        "sha1_accel matches the portable sha1");
+    ok (sha256_errors == 0,
+        "sha256_accel matches the portable sha256");
+}
+
+static void test_unaligned (const uint8_t *data)
+{
+    uint8_t d1[32], d2[32];
+    int errors = 0;
+    int off;
+
+    for (off = 1; off < 16; off++) {
+        sha256_portable (data + off, 1000, d1);
+        sha256_accel (data + off, 1000, d2);
+        if (memcmp (d1, d2, SHA256_BLOCK_SIZE) != 0)
+            errors++;
+        sha1_portable (data + off, 1000, d1);
+        sha1_accel (data + off, 1000, d2);
+        if (memcmp (d1, d2, SHA1_DIGEST_SIZE) != 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "unaligned input is handled");
+}
+
+int main (int argc, char *argv[])
+{
+    size_t size = 1048577 + 16;
+    uint8_t *data;
+    size_t i;
+
+    if (!sha_accel_available ())
+        plan (SKIP_ALL, "CPU does not support the SHA extensions");
+    plan (NO_PLAN);
+
+    if (!(data = malloc (size)))
+        BAIL_OUT ("out of memory");
+    srand (42);
+    for (i = 0; i < size; i++)
+        data[i] = rand ();
+
+    test_lengths (data);
+    test_unaligned (data);
+
+    free (data);
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -25,6 +25,54 @@
 
 #include "msg_zsock.h"
 
+/* Payload frames at least this large are passed to zmq by reference
+ * instead of being copied.  Smaller frames are cheaper to copy than to
+ * track, and zmq stores very small messages inline anyway.
+ */
+static const size_t zerocopy_threshold = 4096;
+
+static void payload_free (void *data, void *hint)
+{
+    msg_payload_decref (hint);
+}
+
+static void zmsg_free (void *arg)
+{
+    zmq_msg_t *msgdata = arg;
+
+    zmq_msg_close (msgdata);
+    free (msgdata);
+}
+
+/* Send payload frame without copying.  zmq holds a reference on the
+ * payload until the frame has been transmitted, and drops it from its
+ * I/O thread.
+ */
+static int send_payload_ref (void *handle,
+                             const flux_msg_t *msg,
+                             const struct msg_iovec *iov,
+                             int flags)
+{
+    struct msg_payload *p;
+    zmq_msg_t zmsg;
+
+    if (!(p = msg_payload_share (msg)))
+        return -1;
+    if (zmq_msg_init_data (&zmsg,
+                           (void *)iov->data,
+                           iov->size,
+                           payload_free,
+                           p) < 0) {
+        ERRNO_SAFE_WRAP (msg_payload_decref, p);
+        return -1;
+    }
+    if (zmq_msg_send (&zmsg, handle, flags) < 0) {
+        ERRNO_SAFE_WRAP (zmq_msg_close, &zmsg);
+        return -1;
+    }
+    return 0;
+}
+
 int zmqutil_msg_send_ex (void *sock, const flux_msg_t *msg, bool nonblock)
 {
     void *handle;
@@ -32,6 +80,8 @@ int zmqutil_msg_send_ex (void *sock, const flux_msg_t *msg, bool nonblock)
     struct msg_iovec *iov = NULL;
     int iovcnt;
     uint8_t proto[PROTO_SIZE];
+    const void *payload = NULL;
+    int payload_size = 0;
     int count = 0;
     int rc = -1;
 
@@ -45,15 +95,23 @@ int zmqutil_msg_send_ex (void *sock, const flux_msg_t *msg, bool nonblock)
 
     if (nonblock)
         flags |= ZMQ_DONTWAIT;
+    if (flux_msg_has_payload (msg)
+        && flux_msg_get_payload (msg, &payload, &payload_size) < 0)
+        goto error;
 
     handle = zsock_resolve (sock);
     while (count < iovcnt) {
         if ((count + 1) == iovcnt)
             flags &= ~ZMQ_SNDMORE;
-        if (zmq_send (handle,
-                      iov[count].data,
-                      iov[count].size,
-                      flags) < 0)
+        if (iov[count].data == payload
+            && iov[count].size >= zerocopy_threshold) {
+            if (send_payload_ref (handle, msg, &iov[count], flags) < 0)
+                goto error;
+        }
+        else if (zmq_send (handle,
+                           iov[count].data,
+                           iov[count].size,
+                           flags) < 0)
             goto error;
         count++;
     }
@@ -85,7 +143,8 @@ flux_msg_t *zmqutil_msg_recv (void *sock)
     /* N.B. we need to store a zmq_msg_t for each iovec entry so that
      * the memory is available during the call to iovec_to_msg().  We
      * use the msg_iovec's "transport_data" field to store the entry
-     * and then clear/free it later.
+     * and then clear/free it later.  Large frames are instead wrapped in
+     * a shared payload, which the message adopts without copying.
      */
     handle = zsock_resolve (sock);
     while (true) {
@@ -110,6 +169,16 @@ flux_msg_t *zmqutil_msg_recv (void *sock)
         iov[iovcnt].transport_data = msgdata;
         iov[iovcnt].data = zmq_msg_data (msgdata);
         iov[iovcnt].size = zmq_msg_size (msgdata);
+        iov[iovcnt].payload = NULL;
+        if (iov[iovcnt].size >= zerocopy_threshold) {
+            if (!(iov[iovcnt].payload = msg_payload_create (NULL,
+                                                            zmsg_free,
+                                                            msgdata))) {
+                ERRNO_SAFE_WRAP (zmsg_free, msgdata);
+                goto error;
+            }
+            iov[iovcnt].transport_data = NULL;
+        }
         iovcnt++;
         if (!zsock_rcvmore (handle))
             break;
@@ -117,17 +186,19 @@ flux_msg_t *zmqutil_msg_recv (void *sock)
 
     if (!(msg = flux_msg_create (FLUX_MSGTYPE_ANY)))
         goto error;
-    if (iovec_to_msg (msg, iov, iovcnt) < 0)
+    if (iovec_to_msg (msg, iov, iovcnt) < 0) {
+        ERRNO_SAFE_WRAP (flux_msg_destroy, msg);
         goto error;
+    }
     rv = msg;
 error:
     if (iov) {
         int save_errno = errno;
         int i;
         for (i = 0; i < iovcnt; i++) {
-            zmq_msg_t *msgdata = iov[i].transport_data;
-            zmq_msg_close (msgdata);
-            free (msgdata);
+            if (iov[i].transport_data)
+                zmsg_free (iov[i].transport_data);
+            msg_payload_decref (iov[i].payload);
         }
         free (iov);
         errno = save_errno;
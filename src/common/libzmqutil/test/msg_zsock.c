@@ -20,6 +20,13 @@
 #include "src/common/libzmqutil/msg_zsock.h"
 #include "src/common/libtap/tap.h"
 
+static int bigfree_count = 0;
+static void bigfree (void *arg)
+{
+    __atomic_add_fetch (&bigfree_count, 1, __ATOMIC_SEQ_CST);
+    free (arg);
+}
+
 void check_sendzsock (void)
 {
     zsock_t *zsock[2] = { NULL, NULL };
@@ -87,6 +94,37 @@ void check_sendzsock (void)
     flux_msg_destroy (msg2);
     flux_msg_destroy (msg);
 
+    /* Send a large payload, which is passed to zmq without copying.
+     */
+    const int bigsize = 1024*1024;
+    char *big;
+    const void *buf;
+    int len;
+    if (!(big = malloc (bigsize)))
+        BAIL_OUT ("out of memory");
+    memset (big, 'x', bigsize);
+    ok ((msg = flux_msg_create (FLUX_MSGTYPE_REQUEST)) != NULL
+            && flux_msg_set_topic (msg, "foo.big") == 0
+            && flux_msg_set_payload_ref (msg, big, bigsize, bigfree, big) == 0,
+        "created test message with 1M payload reference");
+    ok (zmqutil_msg_send (zsock[1], msg) == 0,
+        "big: zmqutil_msg_send works");
+    flux_msg_destroy (msg);
+    ok (__atomic_load_n (&bigfree_count, __ATOMIC_SEQ_CST) == 0,
+        "big: payload is held by zmq after sender destroys message");
+    ok ((msg2 = zmqutil_msg_recv (zsock[0])) != NULL,
+        "big: zmqutil_msg_recv works");
+    ok (flux_msg_get_topic (msg2, &topic) == 0
+            && !strcmp (topic, "foo.big")
+            && flux_msg_get_payload (msg2, &buf, &len) == 0
+            && len == bigsize
+            && ((const char *)buf)[0] == 'x'
+            && ((const char *)buf)[bigsize - 1] == 'x',
+        "big: decoded message looks like what was sent");
+    flux_msg_destroy (msg2);
+    ok (__atomic_load_n (&bigfree_count, __ATOMIC_SEQ_CST) == 1,
+        "big: payload freed once after receiver destroys message");
+
     zsock_destroy (&zsock[0]);
     zsock_destroy (&zsock[1]);
 
@@ -175,6 +175,19 @@ static int override_retry_count (struct usock_retry_params *retry)
     return 0;
 }
 
+/* If FLUX_LOCAL_CONNECTOR_SHM is set to a nonzero value, try to move the
+ * connection to shared memory, falling back to the socket if the broker
+ * does not support it.
+ */
+static bool shm_requested (void)
+{
+    const char *s;
+
+    if ((s = getenv ("FLUX_LOCAL_CONNECTOR_SHM")))
+        return strtol (s, NULL, 10) != 0;
+    return false;
+}
+
 flux_t *connector_init (const char *path, int flags, flux_error_t *errp)
 {
     struct local_connector *ctx;
@@ -231,6 +244,8 @@ static int local_connect (struct local_connector *ctx)
         || usock_get_cred (ctx->fd, &server_cred) < 0
         || !(ctx->uclient = usock_client_create (ctx->fd)))
         return -1;
+    if (shm_requested ())
+        (void)usock_client_attach_shm (ctx->uclient);
     ctx->owner = server_cred.userid;
     return 0;
 }
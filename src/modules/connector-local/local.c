@@ -55,6 +55,11 @@ struct connector_local {
  */
 static const char *route_auxkey = "flux::route";
 
+/* Size of each shared memory ring, for clients that request one.
+ * Pages are only allocated as the rings are used.
+ */
+static const size_t shm_ring_size = 1024 * 1024;
+
 
 static int client_authenticate (struct connector_local *ctx,
                                 uid_t cuid,
@@ -318,6 +323,7 @@ int mod_main (flux_t *h, int argc, char **argv)
     }
     cleanup_push_string (cleanup_file, sockpath);
     usock_server_set_acceptor (ctx.server, acceptor_cb, &ctx);
+    usock_server_set_shm (ctx.server, shm_ring_size);
 
     if (flux_msg_handler_addvec (h, htab, &ctx, &ctx.handlers) < 0)
         goto done;
@@ -15,7 +15,7 @@
  * As such, it is hungry for inodes and may run the file system out of them
  * if used in anger!
  *
- * There are four main operations (RPC handlers):
+ * There are five main operations (RPC handlers):
  *
  * content-backing.load:
  * Given a hash, lookup blob and return it or a "not found" error.
@@ -30,6 +30,9 @@
  * Given a string key and string value, store it and return.
  * If the key exists, overwrite.
  *
+ * content-backing.gc:
+ * Remove blobs that are unreachable from the KVS (see content-gc.h).
+ *
  * The content operations are per RFC 10 and are the main storage behind
  * the Flux KVS.
  *
@@ -47,11 +50,22 @@
  *
  * Once loaded this module can also be exercised directly using
  * flux-content(1) with the --bypass-cache option.
+ *
+ * Blobs of at least 256 bytes are compressed (lz4 by default) and stored
+ * with a small header recording the codec.  Files without the header are
+ * uncompressed blobs written by earlier versions.  Large blobs are hashed
+ * and (de)compressed in worker threads.
  */
 
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
 #include <flux/core.h>
 #include <jansson.h>
 
@@ -59,19 +73,181 @@
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/dirwalk.h"
 #include "src/common/libutil/unlink_recursive.h"
+#include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/bloom.h"
 
 #include "src/common/libcontent/content-util.h"
+#include "src/common/libcontent/content-codec.h"
+#include "src/common/libcontent/content-workpool.h"
+#include "src/common/libcontent/content-gc.h"
 
 #include "filedb.h"
 
+static const int compression_threshold = 256; // compress blobs >= this size
+static const int offload_threshold = 65536; // use worker if >= this size
+static const int default_compression_threads = 2;
+static const size_t bloom_min_capacity = 1024*1024;
+static const double bloom_fp_target = 0.01;
+static const int bloom_rescan_chunk = 4096; // directory entries per slice
+
+/* Bloom filter over the stored blobrefs.  A negative check means the
+ * module has not stored the blob, so loads of missing blobs and stores
+ * of new blobs skip the filesystem lookup.  Unlike a database, dbpath is
+ * not locked, so if blob files may be added there behind the module's
+ * back, the confirm_negatives option makes loads confirm a negative
+ * before failing.
+ */
+struct bloom_stats {
+    unsigned long negatives;        // filter said no
+    unsigned long false_negatives;  // filter said no, load found file
+    unsigned long false_positives;  // filter said maybe, file not found
+    unsigned long duplicates;       // stores skipped, file exists
+    unsigned long rebuilds;
+};
+
 struct content_files {
     flux_msg_handler_t **handlers;
     char *dbpath;
     flux_t *h;
     const char *hashfun;
     int hash_size;
+    int codec;
+    int nthreads;
+    struct content_workpool *pool;
+    bool confirm_negatives;
+    struct bloom *bloom;
+    struct bloom *bloom_next;   // filled in by a rescan of dbpath
+    DIR *bloom_dir;             // open while the rescan is in progress
+    flux_watcher_t *bloom_prep_w;
+    flux_watcher_t *bloom_check_w;
+    flux_watcher_t *bloom_idle_w;
+    struct bloom_stats bloom_stats;
+    struct content_gc *collector;
+    struct timespec stored_since; // files stored since gc listed them
+    struct timespec stored_from;  //   have mtime at or after this
+    bool stored_scan;           // gc is listing stored files
+    DIR *stored_dir;            // open while the listing is in progress
+    DIR *sweep_dir;             // open while the sweep is in progress
 };
 
+/* A large blob being hashed and compressed (store) or uncompressed (load)
+ * in a worker thread.  The work functions must not use the flux_t handle.
+ */
+struct offload {
+    struct content_files *ctx;
+    const flux_msg_t *msg;
+    const void *data;
+    int size;
+    void *file;                 // load: file contents
+    void *buf;                  // store: header + compressed blob
+    int bufsize;                // load: uncompressed blob
+    int codec;
+    char hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_size;
+    int errnum;
+};
+
+static void offload_destroy (struct offload *off)
+{
+    if (off) {
+        int saved_errno = errno;
+        flux_msg_decref (off->msg);
+        free (off->file);
+        free (off->buf);
+        free (off);
+        errno = saved_errno;
+    }
+}
+
+static struct offload *offload_create (struct content_files *ctx,
+                                       const flux_msg_t *msg)
+{
+    struct offload *off;
+
+    if (!(off = calloc (1, sizeof (*off))))
+        return NULL;
+    off->ctx = ctx;
+    off->msg = flux_msg_incref (msg);
+    return off;
+}
+
+/* Compress 'data' into a newly allocated buffer with a codec header.
+ * Returns the size of the buffer, or -1 on error with errno set.
+ */
+static int compress_blob (int codec, const void *data, int size, void **bufp)
+{
+    void *buf;
+    int bound;
+    int n;
+
+    if ((bound = content_codec_bound (codec, size)) < 0
+        || !(buf = malloc (CONTENT_CODEC_HEADER_SIZE + bound)))
+        return -1;
+    if ((n = content_codec_compress (codec,
+                                     data,
+                                     size,
+                                     (char *)buf + CONTENT_CODEC_HEADER_SIZE,
+                                     bound)) < 0) {
+        ERRNO_SAFE_WRAP (free, buf);
+        return -1;
+    }
+    content_codec_header_encode (buf, codec, size);
+    *bufp = buf;
+    return CONTENT_CODEC_HEADER_SIZE + n;
+}
+
+/* Interpret file contents 'file' of length 'filesize'.  If the file has
+ * a codec header, the blob is uncompressed into a new buffer returned in
+ * 'bufp' (or points into 'file' if it is not compressed).  Otherwise the
+ * file is the blob.  Returns the blob size, or -1 on error with errno set.
+ */
+static int uncompress_blob (const void *file,
+                            int filesize,
+                            const void **datap,
+                            void **bufp)
+{
+    int codec;
+    int size;
+    void *buf;
+
+    *bufp = NULL;
+    if (content_codec_header_decode (file, filesize, &codec, &size) < 0) {
+        *datap = file;
+        return filesize;
+    }
+    file = (char *)file + CONTENT_CODEC_HEADER_SIZE;
+    filesize -= CONTENT_CODEC_HEADER_SIZE;
+    if (codec == CONTENT_CODEC_NONE) {
+        if (size != filesize) {
+            errno = EINVAL;
+            return -1;
+        }
+        *datap = file;
+        return size;
+    }
+    if (!(buf = malloc (size > 0 ? size : 1)))
+        return -1;
+    if (content_codec_decompress (codec, file, filesize, buf, size) < 0) {
+        ERRNO_SAFE_WRAP (free, buf);
+        return -1;
+    }
+    *datap = buf;
+    *bufp = buf;
+    return size;
+}
+
+/* Return true if the file header says it holds a large compressed blob.
+ */
+static bool worth_offloading (const void *file, int filesize)
+{
+    int codec;
+    int size;
+
+    if (content_codec_header_decode (file, filesize, &codec, &size) < 0)
+        return false;
+    return codec != CONTENT_CODEC_NONE && size >= offload_threshold;
+}
+
 static int file_count_cb (dirwalk_t *d, void *arg)
 {
     int *count = arg;
@@ -89,6 +265,192 @@ static int get_object_count (const char *path)
     return count;
 }
 
+static void bloom_rescan_stop (struct content_files *ctx)
+{
+    flux_watcher_stop (ctx->bloom_prep_w);
+    flux_watcher_stop (ctx->bloom_check_w);
+    flux_watcher_stop (ctx->bloom_idle_w);
+    if (ctx->bloom_dir) {
+        closedir (ctx->bloom_dir);
+        ctx->bloom_dir = NULL;
+    }
+    bloom_destroy (ctx->bloom_next);
+    ctx->bloom_next = NULL;
+}
+
+/* Start rebuilding the Bloom filter from the blob files in dbpath,
+ * sized for at least twice 'count' objects.  The directory is read a
+ * slice at a time from the reactor loop, and the new filter replaces
+ * the current one when the rescan is complete.  Until then, checks use
+ * the current filter and new blobs are added to both.  A rescan that is
+ * already in progress is restarted.
+ */
+static int bloom_rescan_start (struct content_files *ctx, size_t count)
+{
+    size_t capacity = count * 2;
+
+    bloom_rescan_stop (ctx);
+    if (capacity < bloom_min_capacity)
+        capacity = bloom_min_capacity;
+    if (!(ctx->bloom_next = bloom_create (capacity, bloom_fp_target))
+        || !(ctx->bloom_dir = opendir (ctx->dbpath))) {
+        ERRNO_SAFE_WRAP (bloom_rescan_stop, ctx);
+        return -1;
+    }
+    flux_watcher_start (ctx->bloom_prep_w);
+    flux_watcher_start (ctx->bloom_check_w);
+    return 0;
+}
+
+/* Add blobs from up to 'max' directory entries to the new filter.
+ * Returns 1 if there is more to do, 0 if the rescan is complete, or -1
+ * on error.  The rescan is left in progress on error.
+ */
+static int bloom_rescan_step (struct content_files *ctx, int max)
+{
+    char hash[BLOBREF_MAX_DIGEST_SIZE];
+    struct dirent *dent;
+    int count = 0;
+
+    while (count++ < max) {
+        errno = 0;
+        if (!(dent = readdir (ctx->bloom_dir))) {
+            if (errno != 0)
+                return -1;
+            bloom_destroy (ctx->bloom);
+            ctx->bloom = ctx->bloom_next;
+            ctx->bloom_next = NULL;
+            bloom_rescan_stop (ctx);
+            ctx->bloom_stats.rebuilds++;
+            return 0;
+        }
+        // skip checkpoints and anything else not named by a blobref
+        if (blobref_strtohash (dent->d_name,
+                               hash,
+                               sizeof (hash)) == ctx->hash_size)
+            bloom_add (ctx->bloom_next, hash, ctx->hash_size);
+    }
+    return 1;
+}
+
+/* Build the Bloom filter synchronously, for use at module load.
+ * On failure, there is no filter and all checks fall through to the
+ * filesystem.
+ */
+static int bloom_rebuild (struct content_files *ctx, size_t count)
+{
+    int rc;
+
+    if (bloom_rescan_start (ctx, count) < 0)
+        return -1;
+    while ((rc = bloom_rescan_step (ctx, bloom_rescan_chunk)) > 0)
+        ;
+    if (rc < 0) {
+        ERRNO_SAFE_WRAP (bloom_rescan_stop, ctx);
+        return -1;
+    }
+    return 0;
+}
+
+static void bloom_prep_cb (flux_reactor_t *r,
+                           flux_watcher_t *w,
+                           int revents,
+                           void *arg)
+{
+    struct content_files *ctx = arg;
+
+    flux_watcher_start (ctx->bloom_idle_w);
+}
+
+static void bloom_check_cb (flux_reactor_t *r,
+                            flux_watcher_t *w,
+                            int revents,
+                            void *arg)
+{
+    struct content_files *ctx = arg;
+
+    flux_watcher_stop (ctx->bloom_idle_w);
+    if (ctx->bloom_dir
+        && bloom_rescan_step (ctx, bloom_rescan_chunk) < 0) {
+        flux_log_error (ctx->h, "error rebuilding bloom filter");
+        bloom_rescan_stop (ctx);
+    }
+}
+
+/* Add 'hash' to the Bloom filter, and to the one being rebuilt if a
+ * rescan is in progress.  Start a rescan at twice the size once the
+ * filter holds more objects than it was sized for.
+ */
+static void bloom_add_hash (struct content_files *ctx,
+                            const void *hash,
+                            int hash_size)
+{
+    if (ctx->bloom)
+        bloom_add (ctx->bloom, hash, hash_size);
+    if (ctx->bloom_next)
+        bloom_add (ctx->bloom_next, hash, hash_size);
+    else if (ctx->bloom
+             && bloom_count (ctx->bloom) > bloom_capacity (ctx->bloom)
+             && bloom_rescan_start (ctx, bloom_count (ctx->bloom)) < 0)
+        flux_log_error (ctx->h, "error resizing bloom filter");
+}
+
+/* Return true if a blob file for 'hash' already exists.  A blob file
+ * added behind the module's back may be missed, in which case it is
+ * rewritten with the same content.  An existing file is touched, since
+ * gc must list a blob that is stored again as recently stored.
+ */
+static bool blob_exists (struct content_files *ctx,
+                         const void *hash,
+                         int hash_size)
+{
+    char blobref[BLOBREF_MAX_STRING_SIZE];
+
+    if (!bloom_check (ctx->bloom, hash, hash_size)) {
+        ctx->bloom_stats.negatives++;
+        return false;
+    }
+    if (blobref_hashtostr (ctx->hashfun,
+                           hash,
+                           hash_size,
+                           blobref,
+                           sizeof (blobref)) < 0)
+        return false;
+    if (filedb_touch (ctx->dbpath, blobref) == 0) {
+        ctx->bloom_stats.duplicates++;
+        return true;
+    }
+    if (ctx->bloom)
+        ctx->bloom_stats.false_positives++;
+    return false;
+}
+
+static json_t *pack_bloom_stats (struct content_files *ctx)
+{
+    struct bloom_stats *bs = &ctx->bloom_stats;
+    unsigned long misses = bs->negatives + bs->false_positives;
+    json_t *o;
+
+    if (!(o = json_pack ("{s:b s:I s:I s:I s:f s:f s:I s:I s:I s:I s:I}",
+                         "enabled", ctx->bloom ? 1 : 0,
+                         "entries", (json_int_t)bloom_count (ctx->bloom),
+                         "capacity", (json_int_t)bloom_capacity (ctx->bloom),
+                         "size", (json_int_t)bloom_size (ctx->bloom),
+                         "fp_rate_estimate", bloom_fp_rate (ctx->bloom),
+                         "fp_rate_observed",
+                           misses > 0 ? (double)bs->false_positives / misses
+                                      : 0.,
+                         "negatives", (json_int_t)bs->negatives,
+                         "false_negatives", (json_int_t)bs->false_negatives,
+                         "false_positives", (json_int_t)bs->false_positives,
+                         "duplicates", (json_int_t)bs->duplicates,
+                         "rebuilds", (json_int_t)bs->rebuilds))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
 static void stats_get_cb (flux_t *h,
                           flux_msg_handler_t *mh,
                           const flux_msg_t *msg,
@@ -96,19 +458,93 @@ static void stats_get_cb (flux_t *h,
 {
     struct content_files *ctx = arg;
     int count;
+    json_t *bloom = NULL;
+    json_t *gcstats = NULL;
 
-    if ((count = get_object_count (ctx->dbpath)) < 0)
+    if ((count = get_object_count (ctx->dbpath)) < 0
+        || !(bloom = pack_bloom_stats (ctx))
+        || !(gcstats = content_gc_stats (ctx->collector)))
         goto error;
 
-    if (flux_respond_pack (h, msg, "{s:i}", "object_count", count) < 0)
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:i s:{s:s s:i s:i} s:O s:O}",
+                           "object_count", count,
+                           "compression",
+                             "codec", content_codec_name (ctx->codec),
+                             "threads", ctx->nthreads,
+                             "pending",
+                               content_workpool_pending (ctx->pool),
+                           "bloom", bloom,
+                           "gc", gcstats) < 0)
         flux_log_error (h, "error responding to stats-get request");
+    json_decref (bloom);
+    json_decref (gcstats);
     return;
 error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         flux_log_error (h, "error responding to stats-get request");
+    json_decref (bloom);
+    json_decref (gcstats);
 }
 
 
+static void load_offload_work (void *arg)
+{
+    struct offload *off = arg;
+    const void *data;
+
+    if ((off->bufsize = uncompress_blob (off->file,
+                                         off->size,
+                                         &data,
+                                         &off->buf)) < 0)
+        off->errnum = errno;
+}
+
+static void load_offload_done (void *arg)
+{
+    struct offload *off = arg;
+    flux_t *h = off->ctx->h;
+
+    if (off->errnum != 0) {
+        if (flux_respond_error (h,
+                                off->msg,
+                                off->errnum,
+                                "error uncompressing blob") < 0)
+            flux_log_error (h, "error responding to load request");
+    }
+    else {
+        if (flux_respond_raw (h, off->msg, off->buf, off->bufsize) < 0)
+            flux_log_error (h, "error responding to load request");
+    }
+    offload_destroy (off);
+}
+
+/* Uncompress 'file' in a worker thread.  On success, the offload takes
+ * ownership of 'file'.
+ */
+static int load_offload (struct content_files *ctx,
+                         const flux_msg_t *msg,
+                         void *file,
+                         int filesize)
+{
+    struct offload *off;
+
+    if (!(off = offload_create (ctx, msg)))
+        return -1;
+    off->file = file;
+    off->size = filesize;
+    if (content_workpool_submit (ctx->pool,
+                                 load_offload_work,
+                                 load_offload_done,
+                                 off) < 0) {
+        off->file = NULL;
+        offload_destroy (off);
+        return -1;
+    }
+    return 0;
+}
+
 /* Handle a content-backing.load request from the rank 0 broker's
  * content-cache service.  The raw request payload is a hash digest.
  * The raw response payload is the blob content.
@@ -123,9 +559,13 @@ static void load_cb (flux_t *h,
     const void *hash;
     int hash_size;
     char blobref[BLOBREF_MAX_STRING_SIZE];
-    void *data = NULL;
-    size_t size;
+    void *file = NULL;
+    size_t filesize;
+    const void *data;
+    void *buf = NULL;
+    int size;
     const char *errstr = NULL;
+    bool maybe;
 
     if (flux_request_decode_raw (msg, NULL, &hash, &hash_size) < 0)
         goto error;
@@ -133,22 +573,167 @@ static void load_cb (flux_t *h,
         errno = EPROTO;
         goto error;
     }
+    if (!(maybe = bloom_check (ctx->bloom, hash, hash_size))) {
+        ctx->bloom_stats.negatives++;
+        if (!ctx->confirm_negatives) {
+            errno = ENOENT;
+            goto error;
+        }
+    }
     if (blobref_hashtostr (ctx->hashfun,
                            hash,
                            hash_size,
                            blobref,
                            sizeof (blobref)) < 0)
         goto error;
-    if (filedb_get (ctx->dbpath, blobref, &data, &size, &errstr) < 0)
+    if (filedb_get (ctx->dbpath, blobref, &file, &filesize, &errstr) < 0) {
+        if (errno == ENOENT && ctx->bloom && maybe)
+            ctx->bloom_stats.false_positives++;
         goto error;
+    }
+    if (!maybe) {
+        ctx->bloom_stats.false_negatives++;
+        bloom_add_hash (ctx, hash, hash_size);
+    }
+    if (ctx->pool && worth_offloading (file, filesize)) {
+        content_gc_mark (ctx->collector, hash, hash_size, NULL, 0);
+        if (load_offload (ctx, msg, file, filesize) < 0)
+            goto error;
+        return;
+    }
+    if ((size = uncompress_blob (file, filesize, &data, &buf)) < 0) {
+        errstr = "error uncompressing blob";
+        goto error;
+    }
+    content_gc_mark (ctx->collector, hash, hash_size, data, size);
     if (flux_respond_raw (h, msg, data, size) < 0)
         flux_log_error (h, "error responding to load request");
-    free (data);
+    free (buf);
+    free (file);
     return;
 error:
     if (flux_respond_error (h, msg, errno, errstr) < 0)
         flux_log_error (h, "error responding to load request");
-    free (data);
+    free (buf);
+    free (file);
+}
+
+/* Write blob file named by 'hash'.  The compressed blob with codec header
+ * ('zdata', 'zsize') is written if it is smaller than the blob ('data',
+ * 'size').  'zdata' may be NULL if the blob was not compressed.
+ */
+static int store_blob (struct content_files *ctx,
+                       const void *hash,
+                       int hash_size,
+                       const void *zdata,
+                       int zsize,
+                       const void *data,
+                       int size,
+                       const char **errstr)
+{
+    char blobref[BLOBREF_MAX_STRING_SIZE];
+    void *buf = NULL;
+    int rc;
+
+    if (blobref_hashtostr (ctx->hashfun,
+                           hash,
+                           hash_size,
+                           blobref,
+                           sizeof (blobref)) < 0)
+        return -1;
+    if (zdata && zsize < size) {
+        data = zdata;
+        size = zsize;
+    }
+    /* An uncompressed blob that happens to begin with the header magic
+     * must get a header too, so it is not mistaken for one on load.
+     */
+    else if (content_codec_header_check (data, size)) {
+        if ((size = compress_blob (CONTENT_CODEC_NONE, data, size, &buf)) < 0)
+            return -1;
+        data = buf;
+    }
+    rc = filedb_put (ctx->dbpath, blobref, data, size, errstr);
+    ERRNO_SAFE_WRAP (free, buf);
+    if (rc == 0)
+        bloom_add_hash (ctx, hash, hash_size);
+    return rc;
+}
+
+static void store_offload_work (void *arg)
+{
+    struct offload *off = arg;
+
+    if ((off->hash_size = blobref_hash_raw (off->ctx->hashfun,
+                                            off->data,
+                                            off->size,
+                                            off->hash,
+                                            sizeof (off->hash))) < 0
+        || (off->bufsize = compress_blob (off->codec,
+                                          off->data,
+                                          off->size,
+                                          &off->buf)) < 0)
+        off->errnum = errno;
+}
+
+static void store_offload_done (void *arg)
+{
+    struct offload *off = arg;
+    flux_t *h = off->ctx->h;
+    const char *errstr = NULL;
+
+    if (off->errnum != 0) {
+        errno = off->errnum;
+        goto error;
+    }
+    content_gc_mark (off->ctx->collector,
+                     off->hash,
+                     off->hash_size,
+                     off->data,
+                     off->size);
+    if (!blob_exists (off->ctx, off->hash, off->hash_size)
+        && store_blob (off->ctx,
+                       off->hash,
+                       off->hash_size,
+                       off->buf,
+                       off->bufsize,
+                       off->data,
+                       off->size,
+                       &errstr) < 0)
+        goto error;
+    if (flux_respond_raw (h, off->msg, off->hash, off->hash_size) < 0)
+        flux_log_error (h, "error responding to store request");
+    offload_destroy (off);
+    return;
+error:
+    if (flux_respond_error (h, off->msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to store request");
+    offload_destroy (off);
+}
+
+/* Hash and compress 'data' in a worker thread.  The request message
+ * holds a reference on the payload until done.
+ */
+static int store_offload (struct content_files *ctx,
+                          const flux_msg_t *msg,
+                          const void *data,
+                          int size)
+{
+    struct offload *off;
+
+    if (!(off = offload_create (ctx, msg)))
+        return -1;
+    off->data = data;
+    off->size = size;
+    off->codec = ctx->codec;
+    if (content_workpool_submit (ctx->pool,
+                                 store_offload_work,
+                                 store_offload_done,
+                                 off) < 0) {
+        offload_destroy (off);
+        return -1;
+    }
+    return 0;
 }
 
 /* Handle a content-backing.store request from the rank 0 broker's
@@ -164,33 +749,52 @@ void store_cb (flux_t *h,
     struct content_files *ctx = arg;
     const void *data;
     int size;
-    char blobref[BLOBREF_MAX_STRING_SIZE];
     char hash[BLOBREF_MAX_DIGEST_SIZE];
     int hash_size;
+    void *buf = NULL;
+    int bufsize = 0;
     const char *errstr = NULL;
 
     if (flux_request_decode_raw (msg, NULL, &data, &size) < 0)
         goto error;
+    if (ctx->pool
+        && ctx->codec != CONTENT_CODEC_NONE
+        && size >= offload_threshold) {
+        if (store_offload (ctx, msg, data, size) < 0)
+            goto error;
+        return;
+    }
     if ((hash_size = blobref_hash_raw (ctx->hashfun,
                                        data,
                                        size,
                                        hash,
                                        sizeof (hash))) < 0)
         goto error;
-    if (blobref_hashtostr (ctx->hashfun,
-                           hash,
-                           hash_size,
-                           blobref,
-                           sizeof (blobref)) < 0)
-        goto error;
-    if (filedb_put (ctx->dbpath, blobref, data, size, &errstr) < 0)
+    content_gc_mark (ctx->collector, hash, hash_size, data, size);
+    if (blob_exists (ctx, hash, hash_size))
+        goto done;
+    if (ctx->codec != CONTENT_CODEC_NONE && size >= compression_threshold) {
+        if ((bufsize = compress_blob (ctx->codec, data, size, &buf)) < 0)
+            goto error;
+    }
+    if (store_blob (ctx,
+                    hash,
+                    hash_size,
+                    buf,
+                    bufsize,
+                    data,
+                    size,
+                    &errstr) < 0)
         goto error;
+done:
     if (flux_respond_raw (h, msg, hash, hash_size) < 0)
         flux_log_error (h, "error responding to store request");
+    free (buf);
     return;
 error:
     if (flux_respond_error (h, msg, errno, errstr) < 0)
         flux_log_error (h, "error responding to store request");
+    free (buf);
 }
 
 /* Handle a content-backing.checkpoint-get request from the rank 0 kvs module.
@@ -278,6 +882,242 @@ error:
     free (value);
 }
 
+/* Garbage collection (see content-gc.h).
+ */
+static int gc_load (const void *hash,
+                    int hash_size,
+                    void **datap,
+                    int *sizep,
+                    void *arg)
+{
+    struct content_files *ctx = arg;
+    char blobref[BLOBREF_MAX_STRING_SIZE];
+    void *file;
+    size_t filesize;
+    const void *data;
+    void *buf;
+    int size;
+
+    if (blobref_hashtostr (ctx->hashfun,
+                           hash,
+                           hash_size,
+                           blobref,
+                           sizeof (blobref)) < 0
+        || filedb_get (ctx->dbpath, blobref, &file, &filesize, NULL) < 0)
+        return -1;
+    if ((size = uncompress_blob (file, filesize, &data, &buf)) < 0) {
+        ERRNO_SAFE_WRAP (free, file);
+        return -1;
+    }
+    if (buf) {
+        free (file);
+        *datap = buf;
+    }
+    else {
+        memmove (file, data, size);
+        *datap = file;
+    }
+    *sizep = size;
+    return 0;
+}
+
+/* Checkpoints are the files in dbpath that are not named by a blobref.
+ */
+static json_t *gc_checkpoints (void *arg)
+{
+    struct content_files *ctx = arg;
+    char hash[BLOBREF_MAX_DIGEST_SIZE];
+    DIR *dir;
+    struct dirent *dent;
+    json_t *values;
+
+    if (!(values = json_array ())) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (!(dir = opendir (ctx->dbpath)))
+        goto error;
+    while ((dent = readdir (dir))) {
+        void *data;
+        size_t size;
+        json_t *o;
+
+        if (dent->d_name[0] == '.'
+            || blobref_strtohash (dent->d_name, hash, sizeof (hash)) >= 0)
+            continue;
+        if (filedb_get (ctx->dbpath, dent->d_name, &data, &size, NULL) < 0)
+            continue;
+        o = json_loadb (data, size, 0, NULL);
+        free (data);
+        if (o && json_array_append_new (values, o) < 0) {
+            json_decref (o);
+            errno = ENOMEM;
+            goto error;
+        }
+    }
+    closedir (dir);
+    return values;
+error:
+    if (dir)
+        closedir (dir);
+    ERRNO_SAFE_WRAP (json_decref, values);
+    return NULL;
+}
+
+/* Blob file timestamps come from the kernel's coarse clock, so
+ * CLOCK_REALTIME_COARSE read before a file is written is never after
+ * its mtime.
+ */
+static bool stored_since (struct stat *sb, struct timespec *ts)
+{
+    return sb->st_mtim.tv_sec > ts->tv_sec
+        || (sb->st_mtim.tv_sec == ts->tv_sec
+            && sb->st_mtim.tv_nsec >= ts->tv_nsec);
+}
+
+/* List up to 'max' blob files stored since the previous cycle began
+ * listing them, by mtime.  The directory stays open across calls until
+ * it has been read through.
+ */
+static int gc_stored (struct content_gc *gc, int max, void *arg)
+{
+    struct content_files *ctx = arg;
+    char hash[BLOBREF_MAX_DIGEST_SIZE];
+    struct dirent *dent;
+    int count = 0;
+
+    if (!ctx->stored_scan) {
+        ctx->stored_scan = true;
+        ctx->stored_from = ctx->stored_since;
+        clock_gettime (CLOCK_REALTIME_COARSE, &ctx->stored_since);
+    }
+    if (!ctx->stored_dir && !(ctx->stored_dir = opendir (ctx->dbpath)))
+        return -1;
+    while (count < max) {
+        struct stat sb;
+
+        errno = 0;
+        if (!(dent = readdir (ctx->stored_dir))) {
+            if (errno != 0)
+                return -1;
+            break;
+        }
+        if (blobref_strtohash (dent->d_name,
+                               hash,
+                               sizeof (hash)) != ctx->hash_size)
+            continue;
+        count++;
+        if (fstatat (dirfd (ctx->stored_dir), dent->d_name, &sb, 0) < 0
+            || !stored_since (&sb, &ctx->stored_from))
+            continue;
+        if (content_gc_add_stored (gc, hash, ctx->hash_size) < 0)
+            return -1;
+    }
+    if (!dent) {
+        closedir (ctx->stored_dir);
+        ctx->stored_dir = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+/* Examine up to 'max' directory entries, unlinking unmarked blob files.
+ * The directory stays open across calls until it has been read through.
+ */
+static int gc_sweep (struct content_gc *gc, int max, void *arg)
+{
+    struct content_files *ctx = arg;
+    char hash[BLOBREF_MAX_DIGEST_SIZE];
+    struct dirent *dent;
+    int count = 0;
+    int removed = 0;
+    size_t reclaimed = 0;
+
+    if (!ctx->sweep_dir && !(ctx->sweep_dir = opendir (ctx->dbpath)))
+        return -1;
+    while (count < max) {
+        struct stat sb;
+
+        errno = 0;
+        if (!(dent = readdir (ctx->sweep_dir))) {
+            if (errno != 0)
+                return -1;
+            break;
+        }
+        if (blobref_strtohash (dent->d_name,
+                               hash,
+                               sizeof (hash)) != ctx->hash_size)
+            continue;
+        count++;
+        if (content_gc_is_live (gc, hash, ctx->hash_size))
+            continue;
+        if (fstatat (dirfd (ctx->sweep_dir), dent->d_name, &sb, 0) == 0)
+            reclaimed += sb.st_size;
+        if (unlinkat (dirfd (ctx->sweep_dir), dent->d_name, 0) < 0) {
+            if (errno == ENOENT)
+                continue;
+            flux_log_error (ctx->h, "gc: unlink %s", dent->d_name);
+            return -1;
+        }
+        removed++;
+    }
+    content_gc_swept (gc, count, removed, reclaimed);
+    if (!dent) {
+        closedir (ctx->sweep_dir);
+        ctx->sweep_dir = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+/* If the cycle failed, the next one must list what this one did.
+ * Rebuild the Bloom filter, since removed objects remain in it.
+ * It is sized for the current filter's count, which includes them.
+ */
+static void gc_finish (struct content_gc *gc, int errnum, void *arg)
+{
+    struct content_files *ctx = arg;
+
+    if (ctx->stored_dir) {
+        closedir (ctx->stored_dir);
+        ctx->stored_dir = NULL;
+    }
+    if (ctx->stored_scan) {
+        if (errnum)
+            ctx->stored_since = ctx->stored_from;
+        ctx->stored_scan = false;
+    }
+    if (ctx->sweep_dir) {
+        closedir (ctx->sweep_dir);
+        ctx->sweep_dir = NULL;
+    }
+    if (bloom_rescan_start (ctx, bloom_count (ctx->bloom)) < 0)
+        flux_log_error (ctx->h, "error rebuilding bloom filter");
+}
+
+static const struct content_gc_ops gc_ops = {
+    .load = gc_load,
+    .checkpoints = gc_checkpoints,
+    .stored = gc_stored,
+    .sweep = gc_sweep,
+    .finish = gc_finish,
+};
+
+static void gc_request_cb (flux_t *h,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           void *arg)
+{
+    struct content_files *ctx = arg;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0) {
+        if (flux_respond_error (h, msg, errno, NULL) < 0)
+            flux_log_error (h, "error responding to gc request");
+        return;
+    }
+    content_gc_request (ctx->collector, msg);
+}
+
 /* Destroy module context.
  */
 static void content_files_destroy (struct content_files *ctx)
@@ -285,6 +1125,17 @@ static void content_files_destroy (struct content_files *ctx)
     if (ctx) {
         int saved_errno = errno;
         flux_msg_handler_delvec (ctx->handlers);
+        content_workpool_destroy (ctx->pool);
+        content_gc_destroy (ctx->collector);
+        if (ctx->stored_dir)
+            closedir (ctx->stored_dir);
+        if (ctx->sweep_dir)
+            closedir (ctx->sweep_dir);
+        bloom_rescan_stop (ctx);
+        flux_watcher_destroy (ctx->bloom_prep_w);
+        flux_watcher_destroy (ctx->bloom_check_w);
+        flux_watcher_destroy (ctx->bloom_idle_w);
+        bloom_destroy (ctx->bloom);
         free (ctx->dbpath);
         free (ctx);
         errno = saved_errno;
@@ -299,6 +1150,7 @@ static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "content-backing.store",   store_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.checkpoint-get", checkpoint_get_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.checkpoint-put", checkpoint_put_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.gc",      gc_request_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-files.stats-get", stats_get_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
 };
@@ -307,8 +1159,10 @@ static const struct flux_msg_handler_spec htab[] = {
  */
 static struct content_files *content_files_create (flux_t *h, bool truncate)
 {
+    flux_reactor_t *r = flux_get_reactor (h);
     struct content_files *ctx;
     const char *dbdir;
+    int count;
 
     if (!(ctx = calloc (1, sizeof (*ctx))))
         return NULL;
@@ -323,6 +1177,9 @@ static struct content_files *content_files_create (flux_t *h, bool truncate)
         flux_log_error (h, "content.hash");
         goto error;
     }
+    if (!(ctx->collector = content_gc_create (h, ctx->hashfun, &gc_ops, ctx)))
+        goto error;
+    clock_gettime (CLOCK_REALTIME_COARSE, &ctx->stored_since);
 
     /* Prefer 'statedir' as the location for the content.files directory,
      * if set.  Otherwise use 'rundir'.  If the directory exists, the
@@ -342,6 +1199,17 @@ static struct content_files *content_files_create (flux_t *h, bool truncate)
         flux_log_error (h, "could not create %s", ctx->dbpath);
         goto error;
     }
+    if (!(ctx->bloom_prep_w = flux_prepare_watcher_create (r,
+                                                           bloom_prep_cb,
+                                                           ctx))
+        || !(ctx->bloom_check_w = flux_check_watcher_create (r,
+                                                             bloom_check_cb,
+                                                             ctx))
+        || !(ctx->bloom_idle_w = flux_idle_watcher_create (r, NULL, NULL)))
+        goto error;
+    if ((count = get_object_count (ctx->dbpath)) < 0
+        || bloom_rebuild (ctx, count) < 0)
+        flux_log_error (h, "error building bloom filter");
     if (flux_msg_handler_addvec (h, htab, ctx, &ctx->handlers) < 0)
         goto error;
     return ctx;
@@ -354,7 +1222,10 @@ static int parse_args (flux_t *h,
                        int argc,
                        char **argv,
                        bool *testing,
-                       bool *truncate)
+                       bool *truncate,
+                       bool *confirm_negatives,
+                       int *codec,
+                       int *nthreads)
 {
     int i;
     for (i = 0; i < argc; i++) {
@@ -362,6 +1233,26 @@ static int parse_args (flux_t *h,
             *testing = true;
         else if (!strcmp (argv[i], "truncate"))
             *truncate = true;
+        else if (!strcmp (argv[i], "confirm_negatives"))
+            *confirm_negatives = true;
+        else if (!strncmp (argv[i], "compression=", 12)) {
+            if ((*codec = content_codec_lookup (argv[i] + 12)) < 0) {
+                flux_log_error (h, "Invalid compression: %s", argv[i] + 12);
+                return -1;
+            }
+        }
+        else if (!strncmp (argv[i], "compression_threads=", 20)) {
+            char *endptr;
+            errno = 0;
+            *nthreads = strtol (argv[i] + 20, &endptr, 10);
+            if (errno != 0 || *endptr != '\0' || *nthreads < 0) {
+                flux_log (h,
+                          LOG_ERR,
+                          "Invalid compression_threads: %s",
+                          argv[i] + 20);
+                return -1;
+            }
+        }
         else {
             flux_log (h, LOG_ERR, "Unknown module option: %s", argv[i]);
             return -1;
@@ -387,14 +1278,34 @@ int mod_main (flux_t *h, int argc, char **argv)
     struct content_files *ctx;
     bool testing = false;
     bool truncate = false;
+    bool confirm_negatives = false;
+    int codec = CONTENT_CODEC_LZ4;
+    int nthreads = default_compression_threads;
     int rc = -1;
 
-    if (parse_args (h, argc, argv, &testing, &truncate) < 0)
+    if (parse_args (h,
+                    argc,
+                    argv,
+                    &testing,
+                    &truncate,
+                    &confirm_negatives,
+                    &codec,
+                    &nthreads) < 0)
         return -1;
     if (!(ctx = content_files_create (h, truncate))) {
         flux_log_error (h, "content_files_create failed");
         return -1;
     }
+    ctx->codec = codec;
+    ctx->confirm_negatives = confirm_negatives;
+    if (codec != CONTENT_CODEC_NONE && nthreads > 0) {
+        if (!(ctx->pool = content_workpool_create (flux_get_reactor (h),
+                                                   nthreads))) {
+            flux_log_error (h, "could not create compression threads");
+            goto done;
+        }
+        ctx->nthreads = nthreads;
+    }
     if (content_register_service (h, "content-backing") < 0)
         goto done;
     if (!testing) {
@@ -407,6 +1318,10 @@ int mod_main (flux_t *h, int argc, char **argv)
     }
     rc = 0;
 done_unreg:
+    content_workpool_destroy (ctx->pool);
+    ctx->pool = NULL;
+    content_gc_destroy (ctx->collector);
+    ctx->collector = NULL;
     if (!testing)
         (void)content_unregister_backing_store (h);
 done:
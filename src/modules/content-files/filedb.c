@@ -98,6 +98,35 @@ int filedb_put (const char *dbpath,
     return 0;
 }
 
+bool filedb_exists (const char *dbpath, const char *key)
+{
+    char path[1024];
+    struct stat sb;
+
+    if (strlen (key) == 0 || strchr (key, '/') || !strcmp (key, "..")
+                          || !strcmp (key, "."))
+        return false;
+    if (snprintf (path, sizeof (path), "%s/%s", dbpath, key) >= sizeof (path))
+        return false;
+    return stat (path, &sb) == 0 && S_ISREG (sb.st_mode);
+}
+
+int filedb_touch (const char *dbpath, const char *key)
+{
+    char path[1024];
+
+    if (strlen (key) == 0 || strchr (key, '/') || !strcmp (key, "..")
+                          || !strcmp (key, ".")) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (snprintf (path, sizeof (path), "%s/%s", dbpath, key) >= sizeof (path)) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    return utimensat (AT_FDCWD, path, NULL, 0);
+}
+
 /*
  * vi:ts=4 sw=4 expandtab
  */
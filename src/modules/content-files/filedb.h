@@ -11,6 +11,8 @@
 #ifndef _CONTENT_FILES_FILEDB_H
 #define _CONTENT_FILES_FILEDB_H
 
+#include <stdbool.h>
+
 /* Read file named 'key' from the dbpath directory.
  * On success, 'datap' and 'sizep' are assigned the contents and size
  * and 0 is returned (*datap must be freed).
@@ -37,6 +39,17 @@ int filedb_put (const char *dbpath,
                 size_t size,
                 const char **errstr);
 
+/* Return true if file named 'key' exists in the dbpath directory.
+ * An invalid key does not exist.
+ */
+bool filedb_exists (const char *dbpath, const char *key);
+
+/* Set the modification time of file named 'key' to the current time.
+ * On success, 0 is returned.  On failure, -1 is returned with errno set,
+ * e.g. ENOENT if the file does not exist.
+ */
+int filedb_touch (const char *dbpath, const char *key);
+
 #endif /* !_CONTENT_FILES_FILEDB_H */
 
 /*
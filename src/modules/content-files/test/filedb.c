@@ -101,6 +101,38 @@ void test_simple (const char *dbpath)
     free (data);
 }
 
+void test_exists (const char *dbpath)
+{
+    const char *errstr;
+
+    ok (filedb_exists (dbpath, "key2") == false,
+        "filedb_exists key2 returns false before put");
+    ok (filedb_put (dbpath, "key2", "x", 1, &errstr) == 0,
+        "filedb_put key2={x} works");
+    ok (filedb_exists (dbpath, "key2") == true,
+        "filedb_exists key2 returns true after put");
+    ok (filedb_exists (dbpath, "..") == false
+        && filedb_exists (dbpath, "") == false
+        && filedb_exists (dbpath, "a/b") == false,
+        "filedb_exists returns false for invalid keys");
+}
+
+void test_touch (const char *dbpath)
+{
+    const char *errstr;
+
+    errno = 0;
+    ok (filedb_touch (dbpath, "key3") < 0 && errno == ENOENT,
+        "filedb_touch key3 fails with ENOENT before put");
+    ok (filedb_put (dbpath, "key3", "x", 1, &errstr) == 0,
+        "filedb_put key3={x} works");
+    ok (filedb_touch (dbpath, "key3") == 0,
+        "filedb_touch key3 works after put");
+    errno = 0;
+    ok (filedb_touch (dbpath, "..") < 0 && errno == EINVAL,
+        "filedb_touch fails with EINVAL on invalid key");
+}
+
 int main (int argc, char *argv[])
 {
     char dir[1024];
@@ -118,6 +150,8 @@ int main (int argc, char *argv[])
 
     test_badargs (dir);
     test_simple (dir);
+    test_exists (dir);
+    test_touch (dir);
 
     if (unlink_recursive (dir) < 0)
         BAIL_OUT ("unlink_recursive failed");
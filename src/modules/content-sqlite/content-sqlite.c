@@ -18,8 +18,8 @@
 #include <unistd.h>
 #include <unistd.h>
 #include <sys/statvfs.h>
+#include <stdint.h>
 #include <sqlite3.h>
-#include <lz4.h>
 #include <flux/core.h>
 #include <jansson.h>
 #include <assert.h>
@@ -29,22 +29,50 @@
 #include "src/common/libutil/errno_safe.h"
 #include "src/common/libutil/tstat.h"
 #include "src/common/libutil/monotime.h"
+#include "src/common/libutil/fsd.h"
+#include "src/common/libutil/bloom.h"
 
+#include "src/common/libcontent/content.h"
 #include "src/common/libcontent/content-util.h"
+#include "src/common/libcontent/content-codec.h"
+#include "src/common/libcontent/content-workpool.h"
+#include "src/common/libcontent/content-gc.h"
 
 const size_t lzo_buf_chunksize = 1024*1024;
 const size_t compression_threshold = 256; /* compress blobs >= this size */
+const int offload_threshold = 65536; /* (de)compress in worker if >= this */
+const int default_compression_threads = 2;
+const size_t bloom_min_capacity = 1024*1024;
+const double bloom_fp_target = 0.01;
+const int bloom_rescan_chunk = 4096; /* rows per slice of filter rescan */
+const sqlite3_int64 rowid_none = INT64_MAX;
 
+/* N.B. 'size' is the uncompressed size, or -1 if the object is stored
+ * uncompressed.  'codec' was added later, so rows with a NULL codec and
+ * size != -1 are LZ4 compressed.
+ */
 const char *sql_create_table = "CREATE TABLE if not exists objects("
                                "  hash BLOB PRIMARY KEY,"
                                "  size INT,"
-                               "  object BLOB"
+                               "  object BLOB,"
+                               "  codec INT"
                                ");";
-const char *sql_load = "SELECT object,size FROM objects"
+const char *sql_check_codec_column = "SELECT codec FROM objects LIMIT 1";
+const char *sql_add_codec_column = "ALTER TABLE objects ADD COLUMN codec INT";
+const char *sql_load = "SELECT object,size,codec FROM objects"
                        "  WHERE hash = ?1 LIMIT 1";
-const char *sql_store = "INSERT INTO objects (hash,size,object) "
-                        "  values (?1, ?2, ?3)";
+const char *sql_store = "INSERT INTO objects (hash,size,object,codec) "
+                        "  values (?1, ?2, ?3, ?4)";
 const char *sql_objects_count = "SELECT count(1) FROM objects";
+const char *sql_objects_hashes = "SELECT rowid,hash FROM objects"
+                                 "  WHERE rowid > ?1 ORDER BY rowid LIMIT ?2";
+const char *sql_exists = "SELECT rowid FROM objects WHERE hash = ?1 LIMIT 1";
+const char *sql_touch = "UPDATE objects"
+                        "  SET rowid = (SELECT max(rowid) FROM objects) + 1"
+                        "  WHERE rowid = ?1";
+const char *sql_sweep_select = "SELECT rowid,hash,length(object) FROM objects"
+                               "  WHERE rowid > ?1 ORDER BY rowid LIMIT ?2";
+const char *sql_sweep_delete = "DELETE FROM objects WHERE rowid = ?1";
 
 const char *sql_create_table_checkpt = "CREATE TABLE if not exists checkpt("
                                        "  key TEXT UNIQUE,"
@@ -54,10 +82,54 @@ const char *sql_checkpt_get = "SELECT value FROM checkpt"
                               "  WHERE key = ?1";
 const char *sql_checkpt_put = "REPLACE INTO checkpt (key,value) "
                               "  values (?1, ?2)";
+const char *sql_checkpt_list = "SELECT value FROM checkpt";
+
+const int group_commit_default_max = 256;
 
 struct content_stats {
     tstat_t load;
     tstat_t store;
+    tstat_t load_batch;
+    tstat_t store_batch;
+    tstat_t compress;
+    tstat_t decompress;
+};
+
+/* Bloom filter over the hashes in the objects table.  A negative
+ * check means the module has not stored the object, so loads and the
+ * existence check before storing a new object need not touch the
+ * database.  The database is opened with locking_mode=EXCLUSIVE, so it
+ * cannot be modified behind our back.  A positive check must be
+ * confirmed by query.
+ */
+struct bloom_stats {
+    unsigned long negatives;        // filter said no
+    unsigned long false_positives;  // filter said maybe, query found none
+    unsigned long duplicates;       // stores skipped, object exists
+    unsigned long rebuilds;
+};
+
+/* Group commit:  when enabled (window > 0), stores are made within a
+ * transaction that is held open until the window expires or max_count
+ * blobs have been stored.  Responses are deferred until it is committed.
+ */
+struct group_commit_entry {
+    const flux_msg_t *msg;
+    void *data;             // response payload (one or more hashes)
+    int size;
+};
+
+struct group_commit {
+    double window;
+    int max_count;
+    bool open;
+    int blobs;              // blobs stored in the open transaction
+    struct group_commit_entry *entries;
+    int count;
+    int alloc;
+    flux_watcher_t *timer;
+    tstat_t batch_size;
+    tstat_t commit_time;
 };
 
 struct content_sqlite {
@@ -68,12 +140,39 @@ struct content_sqlite {
     sqlite3_stmt *store_stmt;
     sqlite3_stmt *checkpt_get_stmt;
     sqlite3_stmt *checkpt_put_stmt;
+    sqlite3_stmt *exists_stmt;
+    sqlite3_stmt *touch_stmt;
+    sqlite3_stmt *stored_select_stmt;
+    sqlite3_stmt *sweep_select_stmt;
+    sqlite3_stmt *sweep_delete_stmt;
+    sqlite3_stmt *bloom_select_stmt;
     flux_t *h;
     const char *hashfun;
     int hash_size;
     size_t lzo_bufsize;
     void *lzo_buf;
+    size_t batch_bufsize;
+    void *batch_buf;
     struct content_stats stats;
+    struct group_commit group_commit;
+    struct bloom *bloom;
+    struct bloom *bloom_next;   // filled in by a rescan of objects table
+    sqlite3_int64 bloom_rowid;  // last rowid examined by the rescan
+    flux_watcher_t *bloom_prep_w;
+    flux_watcher_t *bloom_check_w;
+    flux_watcher_t *bloom_idle_w;
+    struct bloom_stats bloom_stats;
+    struct content_gc *collector;
+    sqlite3_int64 stored_rowid; // lowest rowid stored since gc listed them
+    sqlite3_int64 stored_from;  // stored_rowid when gc began listing
+    sqlite3_int64 stored_last;  // last rowid listed by gc
+    bool stored_scan;           // gc is listing stored objects
+    sqlite3_int64 sweep_rowid;  // last rowid examined by the sweep
+    bool sweep_compact;         // sweep has moved on to incremental_vacuum
+    bool auto_vacuum;           // database has auto_vacuum=INCREMENTAL
+    int codec;
+    int nthreads;
+    struct content_workpool *pool;
     const char *journal_mode;
     const char *synchronous;
     bool truncate;
@@ -142,21 +241,172 @@ static int grow_lzo_buf (struct content_sqlite *ctx, size_t size)
     return 0;
 }
 
-/* Load blob from objects table, uncompressing if necessary.
+static void content_sqlite_bloom_rescan_stop (struct content_sqlite *ctx)
+{
+    flux_watcher_stop (ctx->bloom_prep_w);
+    flux_watcher_stop (ctx->bloom_check_w);
+    flux_watcher_stop (ctx->bloom_idle_w);
+    bloom_destroy (ctx->bloom_next);
+    ctx->bloom_next = NULL;
+    ctx->bloom_rowid = 0;
+}
+
+/* Start rebuilding the Bloom filter from the objects table, sized for
+ * at least twice 'count' objects.  The table is read a slice at a time
+ * from the reactor loop, and the new filter replaces the current one
+ * when the rescan is complete.  Until then, checks use the current
+ * filter and new objects are added to both.  A rescan that is already
+ * in progress is restarted.
+ */
+static int content_sqlite_bloom_rescan_start (struct content_sqlite *ctx,
+                                              size_t count)
+{
+    size_t capacity = count * 2;
+
+    content_sqlite_bloom_rescan_stop (ctx);
+    if (capacity < bloom_min_capacity)
+        capacity = bloom_min_capacity;
+    if (!(ctx->bloom_next = bloom_create (capacity, bloom_fp_target)))
+        return -1;
+    flux_watcher_start (ctx->bloom_prep_w);
+    flux_watcher_start (ctx->bloom_check_w);
+    return 0;
+}
+
+/* Add up to 'max' hashes from the objects table to the new filter.
+ * Returns 1 if there is more to do, 0 if the rescan is complete, or -1
+ * on error.  The rescan is left in progress on error.
+ */
+static int content_sqlite_bloom_rescan_step (struct content_sqlite *ctx,
+                                             int max)
+{
+    int count = 0;
+    int rc;
+
+    if (sqlite3_bind_int64 (ctx->bloom_select_stmt,
+                            1,
+                            ctx->bloom_rowid) != SQLITE_OK
+        || sqlite3_bind_int (ctx->bloom_select_stmt, 2, max) != SQLITE_OK) {
+        log_sqlite_error (ctx, "bloom: binding select");
+        goto error;
+    }
+    while ((rc = sqlite3_step (ctx->bloom_select_stmt)) == SQLITE_ROW) {
+        ctx->bloom_rowid = sqlite3_column_int64 (ctx->bloom_select_stmt, 0);
+        bloom_add (ctx->bloom_next,
+                   sqlite3_column_blob (ctx->bloom_select_stmt, 1),
+                   sqlite3_column_bytes (ctx->bloom_select_stmt, 1));
+        count++;
+    }
+    if (rc != SQLITE_DONE) {
+        log_sqlite_error (ctx, "bloom: reading objects hashes");
+        goto error;
+    }
+    sqlite3_reset (ctx->bloom_select_stmt);
+    if (count < max) {
+        bloom_destroy (ctx->bloom);
+        ctx->bloom = ctx->bloom_next;
+        ctx->bloom_next = NULL;
+        content_sqlite_bloom_rescan_stop (ctx);
+        ctx->bloom_stats.rebuilds++;
+        return 0;
+    }
+    return 1;
+error:
+    set_errno_from_sqlite_error (ctx);
+    ERRNO_SAFE_WRAP (sqlite3_reset, ctx->bloom_select_stmt);
+    return -1;
+}
+
+/* Build the Bloom filter synchronously, for use at module load.
+ * On failure, there is no filter and all checks fall through to the
+ * database.
+ */
+static int content_sqlite_bloom_rebuild (struct content_sqlite *ctx,
+                                         size_t count)
+{
+    int rc;
+
+    if (content_sqlite_bloom_rescan_start (ctx, count) < 0)
+        return -1;
+    while ((rc = content_sqlite_bloom_rescan_step (ctx,
+                                                   bloom_rescan_chunk)) > 0)
+        ;
+    if (rc < 0) {
+        ERRNO_SAFE_WRAP (content_sqlite_bloom_rescan_stop, ctx);
+        return -1;
+    }
+    return 0;
+}
+
+static void bloom_prep_cb (flux_reactor_t *r,
+                           flux_watcher_t *w,
+                           int revents,
+                           void *arg)
+{
+    struct content_sqlite *ctx = arg;
+
+    flux_watcher_start (ctx->bloom_idle_w);
+}
+
+static void bloom_check_cb (flux_reactor_t *r,
+                            flux_watcher_t *w,
+                            int revents,
+                            void *arg)
+{
+    struct content_sqlite *ctx = arg;
+
+    flux_watcher_stop (ctx->bloom_idle_w);
+    if (ctx->bloom_next
+        && content_sqlite_bloom_rescan_step (ctx, bloom_rescan_chunk) < 0) {
+        flux_log_error (ctx->h, "error rebuilding bloom filter");
+        content_sqlite_bloom_rescan_stop (ctx);
+    }
+}
+
+/* Add 'hash' to the Bloom filter, and to the one being rebuilt if a
+ * rescan is in progress.  Start a rescan at twice the size once the
+ * filter holds more objects than it was sized for.
+ */
+static void content_sqlite_bloom_add (struct content_sqlite *ctx,
+                                      const void *hash,
+                                      int hash_size)
+{
+    if (ctx->bloom)
+        bloom_add (ctx->bloom, hash, hash_size);
+    if (ctx->bloom_next)
+        bloom_add (ctx->bloom_next, hash, hash_size);
+    else if (ctx->bloom
+             && bloom_count (ctx->bloom) > bloom_capacity (ctx->bloom)
+             && content_sqlite_bloom_rescan_start (ctx,
+                                                   bloom_count (ctx->bloom)) < 0)
+        flux_log_error (ctx->h, "error resizing bloom filter");
+}
+
+/* Look up blob in objects table without uncompressing it.
+ * On success, 'datap' and 'sizep' are assigned the stored object,
+ * 'codecp' its codec, and 'usizep' its uncompressed size.
  * Returns 0 on success, -1 on error with errno set.
  * On successful return, must call sqlite3_reset (ctx->load_stmt),
  * which invalidates returned data.
  */
-static int content_sqlite_load (struct content_sqlite *ctx,
-                                const void *hash,
-                                int hash_size,
-                                const void **datap,
-                                int *sizep)
+static int content_sqlite_lookup (struct content_sqlite *ctx,
+                                  const void *hash,
+                                  int hash_size,
+                                  const void **datap,
+                                  int *sizep,
+                                  int *codecp,
+                                  int *usizep)
 {
     const void *data = NULL;
     int size = 0;
     int uncompressed_size;
+    int codec;
 
+    if (!bloom_check (ctx->bloom, hash, hash_size)) {
+        ctx->bloom_stats.negatives++;
+        errno = ENOENT;
+        return -1;
+    }
     if (sqlite3_bind_text (ctx->load_stmt,
                            1,
                            (char *)hash,
@@ -168,6 +418,8 @@ static int content_sqlite_load (struct content_sqlite *ctx,
     }
     if (sqlite3_step (ctx->load_stmt) != SQLITE_ROW) {
         //log_sqlite_error (ctx, "load: executing stmt");
+        if (ctx->bloom)
+            ctx->bloom_stats.false_positives++;
         errno = ENOENT;
         goto error;
     }
@@ -184,68 +436,195 @@ static int content_sqlite_load (struct content_sqlite *ctx,
         goto error;
     }
     uncompressed_size = sqlite3_column_int (ctx->load_stmt, 1);
-    if (uncompressed_size != -1) {
+    if (uncompressed_size == -1) {
+        codec = CONTENT_CODEC_NONE;
+        uncompressed_size = size;
+    }
+    else if (sqlite3_column_type (ctx->load_stmt, 2) == SQLITE_NULL)
+        codec = CONTENT_CODEC_LZ4;
+    else
+        codec = sqlite3_column_int (ctx->load_stmt, 2);
+    *datap = data;
+    *sizep = size;
+    *codecp = codec;
+    *usizep = uncompressed_size;
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (sqlite3_reset, ctx->load_stmt);
+    return -1;
+}
+
+/* Uncompress object returned by content_sqlite_lookup(), if necessary.
+ * On success, 'datap' and 'sizep' are updated to refer to the blob.
+ * On failure, the load statement is reset.
+ * Returns 0 on success, -1 on error with errno set.
+ */
+static int content_sqlite_uncompress (struct content_sqlite *ctx,
+                                      const void **datap,
+                                      int *sizep,
+                                      int codec,
+                                      int uncompressed_size)
+{
+    if (codec != CONTENT_CODEC_NONE) {
         if (ctx->lzo_bufsize < uncompressed_size
                                 && grow_lzo_buf (ctx, uncompressed_size) < 0)
             goto error;
-        int r = LZ4_decompress_safe (data,
-                                     ctx->lzo_buf,
-                                     size,
-                                     uncompressed_size);
-        if (r < 0) {
-            errno = EINVAL;
+        if (content_codec_decompress (codec,
+                                      *datap,
+                                      *sizep,
+                                      ctx->lzo_buf,
+                                      uncompressed_size) < 0) {
+            flux_log_error (ctx->h,
+                            "load: %s decompression failed",
+                            content_codec_name (codec) ?: "unknown");
             goto error;
         }
-        if (r != uncompressed_size) {
-            flux_log (ctx->h, LOG_ERR, "load: blob size mismatch");
-            errno = EINVAL;
-            goto error;
-        }
-        data = ctx->lzo_buf;
-        size = uncompressed_size;
+        *datap = ctx->lzo_buf;
+        *sizep = uncompressed_size;
     }
-    *datap = data;
-    *sizep = size;
     return 0;
 error:
     ERRNO_SAFE_WRAP (sqlite3_reset, ctx->load_stmt);
     return -1;
 }
 
-/* Store blob to objects table, compressing if necessary.
- * hash over 'data' is stored to 'hash'.
- * Returns hash size on success, -1 on error with errno set.
+/* Load blob from objects table, uncompressing if necessary.
+ * Returns 0 on success, -1 on error with errno set.
+ * On successful return, must call sqlite3_reset (ctx->load_stmt),
+ * which invalidates returned data.
  */
-static int content_sqlite_store (struct content_sqlite *ctx,
-                                 const void *data,
-                                 int size,
-                                 void *hash,
-                                 int hash_len)
+static int content_sqlite_load (struct content_sqlite *ctx,
+                                const void *hash,
+                                int hash_size,
+                                const void **datap,
+                                int *sizep)
 {
-    int uncompressed_size = -1;
-    int hash_size;
+    const void *data;
+    int size;
+    int codec;
+    int uncompressed_size;
 
-    if ((hash_size = blobref_hash_raw (ctx->hashfun,
-                                       data,
-                                       size,
-                                       hash,
-                                       hash_len)) < 0)
+    if (content_sqlite_lookup (ctx,
+                               hash,
+                               hash_size,
+                               &data,
+                               &size,
+                               &codec,
+                               &uncompressed_size) < 0
+        || content_sqlite_uncompress (ctx,
+                                      &data,
+                                      &size,
+                                      codec,
+                                      uncompressed_size) < 0)
         return -1;
-    assert (hash_size == ctx->hash_size);
-    if (size >= compression_threshold) {
-        int r;
-        int out_len = LZ4_compressBound(size);
-        if (ctx->lzo_bufsize < out_len && grow_lzo_buf (ctx, out_len) < 0)
-            return -1;
-        r = LZ4_compress_default (data, ctx->lzo_buf, size, out_len);
-        if (r == 0) {
-            errno = EINVAL;
-            return -1;
-        }
-        uncompressed_size = size;
-        size = r;
-        data = ctx->lzo_buf;
+    *datap = data;
+    *sizep = size;
+    return 0;
+}
+
+/* Look up the rowid of 'hash' in the objects table.
+ * Return true if found.  On query error, return false.
+ */
+static bool content_sqlite_rowid (struct content_sqlite *ctx,
+                                  const void *hash,
+                                  int hash_size,
+                                  sqlite3_int64 *rowid)
+{
+    bool found = false;
+
+    if (sqlite3_bind_text (ctx->exists_stmt,
+                           1,
+                           (char *)hash,
+                           hash_size,
+                           SQLITE_STATIC) == SQLITE_OK
+        && sqlite3_step (ctx->exists_stmt) == SQLITE_ROW) {
+        *rowid = sqlite3_column_int64 (ctx->exists_stmt, 0);
+        found = true;
+    }
+    sqlite3_reset (ctx->exists_stmt);
+    return found;
+}
+
+/* Note that 'rowid' was stored, so gc lists it as recently stored.
+ * Rowids are not strictly increasing once the sweep has deleted the
+ * highest ones, so track the lowest rather than a high water mark.
+ */
+static void content_sqlite_stored (struct content_sqlite *ctx,
+                                   sqlite3_int64 rowid)
+{
+    if (rowid < ctx->stored_rowid)
+        ctx->stored_rowid = rowid;
+}
+
+/* An object that is stored again may be about to be referenced, so it
+ * must be listed by the next gc like a new one.  Unless it was already
+ * stored since gc last listed them, move it to the end of the objects
+ * table.  Returns 0 on success, -1 on error with errno set.
+ */
+static int content_sqlite_touch (struct content_sqlite *ctx,
+                                 const void *hash,
+                                 int hash_size,
+                                 sqlite3_int64 rowid)
+{
+    if (rowid >= ctx->stored_rowid)
+        return 0;
+    if (sqlite3_bind_int64 (ctx->touch_stmt, 1, rowid) != SQLITE_OK
+        || sqlite3_step (ctx->touch_stmt) != SQLITE_DONE) {
+        log_sqlite_error (ctx, "store: moving existing object");
+        set_errno_from_sqlite_error (ctx);
+        ERRNO_SAFE_WRAP (sqlite3_reset, ctx->touch_stmt);
+        return -1;
+    }
+    sqlite3_reset (ctx->touch_stmt);
+    if (!content_sqlite_rowid (ctx, hash, hash_size, &rowid)) {
+        errno = EIO;
+        return -1;
+    }
+    content_sqlite_stored (ctx, rowid);
+    return 0;
+}
+
+/* Return 1 if 'hash' is in the objects table, after noting that it was
+ * stored again, or 0 if it is not.  On query error, return 0 and let
+ * the insert sort it out.  Returns -1 if the object is present but
+ * could not be moved.
+ */
+static int content_sqlite_exists (struct content_sqlite *ctx,
+                                  const void *hash,
+                                  int hash_size)
+{
+    sqlite3_int64 rowid;
+
+    if (!bloom_check (ctx->bloom, hash, hash_size)) {
+        ctx->bloom_stats.negatives++;
+        return 0;
+    }
+    if (!content_sqlite_rowid (ctx, hash, hash_size, &rowid)) {
+        if (ctx->bloom)
+            ctx->bloom_stats.false_positives++;
+        return 0;
     }
+    ctx->bloom_stats.duplicates++;
+    if (content_sqlite_touch (ctx, hash, hash_size, rowid) < 0)
+        return -1;
+    return 1;
+}
+
+/* Insert object into objects table.  If 'codec' is not
+ * CONTENT_CODEC_NONE, 'data' is compressed and 'uncompressed_size'
+ * is its original size.
+ * Returns 0 on success, -1 on error with errno set.
+ */
+static int content_sqlite_insert (struct content_sqlite *ctx,
+                                  const void *hash,
+                                  int hash_size,
+                                  const void *data,
+                                  int size,
+                                  int uncompressed_size,
+                                  int codec)
+{
+    if (codec == CONTENT_CODEC_NONE)
+        uncompressed_size = -1;
     if (sqlite3_bind_text (ctx->store_stmt,
                            1,
                            hash,
@@ -271,87 +650,778 @@ static int content_sqlite_store (struct content_sqlite *ctx,
         set_errno_from_sqlite_error (ctx);
         goto error;
     }
+    if (sqlite3_bind_int (ctx->store_stmt, 4, codec) != SQLITE_OK) {
+        log_sqlite_error (ctx, "store: binding codec");
+        set_errno_from_sqlite_error (ctx);
+        goto error;
+    }
     /* N.B. ignore SQLITE_CONSTRAINT errors - it means the insert failed
      * because it violated the implicit primary key uniqueness constraint.
      * Blob and blobref are indeed stored and storage is conserved - success!
      */
-    if (sqlite3_step (ctx->store_stmt) != SQLITE_DONE
-                    && sqlite3_errcode (ctx->db) != SQLITE_CONSTRAINT) {
+    if (sqlite3_step (ctx->store_stmt) == SQLITE_DONE)
+        content_sqlite_stored (ctx, sqlite3_last_insert_rowid (ctx->db));
+    else if (sqlite3_errcode (ctx->db) != SQLITE_CONSTRAINT) {
         log_sqlite_error (ctx, "store: executing stmt");
         set_errno_from_sqlite_error (ctx);
         goto error;
     }
     sqlite3_reset (ctx->store_stmt);
-    return hash_size;
+    content_sqlite_bloom_add (ctx, hash, hash_size);
+    return 0;
 error:
     ERRNO_SAFE_WRAP (sqlite3_reset, ctx->store_stmt);
     return -1;
 }
 
-static void load_cb (flux_t *h,
-                     flux_msg_handler_t *mh,
-                     const flux_msg_t *msg,
-                     void *arg)
+/* Store blob to objects table, compressing if necessary.
+ * hash over 'data' is stored to 'hash'.
+ * Returns hash size on success, -1 on error with errno set.
+ */
+static int content_sqlite_store (struct content_sqlite *ctx,
+                                 const void *data,
+                                 int size,
+                                 void *hash,
+                                 int hash_len)
+{
+    int uncompressed_size = size;
+    int codec = CONTENT_CODEC_NONE;
+    int hash_size;
+    int rc;
+
+    if ((hash_size = blobref_hash_raw (ctx->hashfun,
+                                       data,
+                                       size,
+                                       hash,
+                                       hash_len)) < 0)
+        return -1;
+    assert (hash_size == ctx->hash_size);
+    content_gc_mark (ctx->collector, hash, hash_size, data, size);
+    if ((rc = content_sqlite_exists (ctx, hash, hash_size)) != 0)
+        return rc < 0 ? -1 : hash_size;
+    if (size >= compression_threshold && ctx->codec != CONTENT_CODEC_NONE) {
+        int out_len;
+        int r;
+
+        if ((out_len = content_codec_bound (ctx->codec, size)) < 0)
+            return -1;
+        if (ctx->lzo_bufsize < out_len && grow_lzo_buf (ctx, out_len) < 0)
+            return -1;
+        if ((r = content_codec_compress (ctx->codec,
+                                         data,
+                                         size,
+                                         ctx->lzo_buf,
+                                         out_len)) < 0)
+            return -1;
+        if (r < size) {
+            codec = ctx->codec;
+            size = r;
+            data = ctx->lzo_buf;
+        }
+    }
+    if (content_sqlite_insert (ctx,
+                               hash,
+                               hash_size,
+                               data,
+                               size,
+                               uncompressed_size,
+                               codec) < 0)
+        return -1;
+    return hash_size;
+}
+
+/* Execute a transaction control statement such as "BEGIN" or "COMMIT".
+ */
+static int content_sqlite_exec (struct content_sqlite *ctx, const char *sql)
+{
+    if (sqlite3_exec (ctx->db, sql, NULL, NULL, NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "%s", sql);
+        set_errno_from_sqlite_error (ctx);
+        return -1;
+    }
+    return 0;
+}
+
+/* Respond to all requests pending in the group commit and reset it.
+ * If errnum is nonzero, respond with that error.
+ */
+static void group_commit_respond (struct content_sqlite *ctx, int errnum)
+{
+    struct group_commit *gcommit = &ctx->group_commit;
+    int i;
+
+    for (i = 0; i < gcommit->count; i++) {
+        struct group_commit_entry *entry = &gcommit->entries[i];
+        if (errnum) {
+            if (flux_respond_error (ctx->h, entry->msg, errnum, NULL) < 0)
+                flux_log_error (ctx->h, "group-commit: flux_respond_error");
+        }
+        else {
+            if (flux_respond_raw (ctx->h,
+                                  entry->msg,
+                                  entry->data,
+                                  entry->size) < 0)
+                flux_log_error (ctx->h, "group-commit: flux_respond_raw");
+        }
+        flux_msg_decref (entry->msg);
+        free (entry->data);
+    }
+    gcommit->count = 0;
+    gcommit->blobs = 0;
+    gcommit->open = false;
+    flux_watcher_stop (gcommit->timer);
+}
+
+/* Commit the open transaction, if any, and respond to pending requests.
+ */
+static int group_commit_flush (struct content_sqlite *ctx)
+{
+    struct group_commit *gcommit = &ctx->group_commit;
+    struct timespec t0;
+
+    if (!gcommit->open)
+        return 0;
+    monotime (&t0);
+    if (content_sqlite_exec (ctx, "COMMIT") < 0) {
+        int saved_errno = errno;
+        if (!sqlite3_get_autocommit (ctx->db))
+            (void)content_sqlite_exec (ctx, "ROLLBACK");
+        group_commit_respond (ctx, saved_errno);
+        errno = saved_errno;
+        return -1;
+    }
+    tstat_push (&gcommit->commit_time, monotime_since (t0));
+    if (gcommit->blobs > 0)
+        tstat_push (&gcommit->batch_size, gcommit->blobs);
+    group_commit_respond (ctx, 0);
+    return 0;
+}
+
+/* Some errors (e.g. SQLITE_FULL, SQLITE_IOERR) cause sqlite to roll back
+ * the entire transaction.  If that happened, fail all pending requests.
+ */
+static void group_commit_check (struct content_sqlite *ctx)
+{
+    if (ctx->group_commit.open && sqlite3_get_autocommit (ctx->db)) {
+        int saved_errno = errno;
+        flux_log (ctx->h, LOG_ERR, "group-commit: transaction was aborted");
+        group_commit_respond (ctx, saved_errno);
+        errno = saved_errno;
+    }
+}
+
+/* Open a transaction for group commit, if one is not already open.
+ */
+static int group_commit_begin (struct content_sqlite *ctx)
+{
+    struct group_commit *gcommit = &ctx->group_commit;
+
+    if (gcommit->open)
+        return 0;
+    if (content_sqlite_exec (ctx, "BEGIN") < 0)
+        return -1;
+    gcommit->open = true;
+    flux_timer_watcher_reset (gcommit->timer, gcommit->window, 0.);
+    flux_watcher_start (gcommit->timer);
+    return 0;
+}
+
+/* Defer the response to 'msg' until the transaction is committed.
+ * The transaction is committed now if max_count blobs have been stored.
+ */
+static int group_commit_append (struct content_sqlite *ctx,
+                                const flux_msg_t *msg,
+                                const void *data,
+                                int size,
+                                int blobs)
+{
+    struct group_commit *gcommit = &ctx->group_commit;
+    struct group_commit_entry *entry;
+
+    if (gcommit->count == gcommit->alloc) {
+        int newalloc = gcommit->alloc ? gcommit->alloc * 2 : 64;
+        struct group_commit_entry *newentries;
+
+        if (!(newentries = realloc (gcommit->entries,
+                                    newalloc * sizeof (*newentries)))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        gcommit->entries = newentries;
+        gcommit->alloc = newalloc;
+    }
+    entry = &gcommit->entries[gcommit->count];
+    if (!(entry->data = malloc (size)))
+        return -1;
+    memcpy (entry->data, data, size);
+    entry->size = size;
+    entry->msg = flux_msg_incref (msg);
+    gcommit->count++;
+    gcommit->blobs += blobs;
+    if (gcommit->blobs >= gcommit->max_count)
+        (void)group_commit_flush (ctx);
+    return 0;
+}
+
+static void group_commit_timer_cb (flux_reactor_t *r,
+                                   flux_watcher_t *w,
+                                   int revents,
+                                   void *arg)
+{
+    struct content_sqlite *ctx = arg;
+
+    if (group_commit_flush (ctx) < 0)
+        flux_log_error (ctx->h, "group-commit");
+}
+
+/* Begin/end a batch.  If a group commit transaction is open, the batch
+ * is nested in it as a savepoint so it can be rolled back independently.
+ */
+static int batch_begin (struct content_sqlite *ctx)
+{
+    return content_sqlite_exec (ctx, ctx->group_commit.open ? "SAVEPOINT batch"
+                                                  : "BEGIN");
+}
+
+static int batch_end (struct content_sqlite *ctx)
+{
+    return content_sqlite_exec (ctx, ctx->group_commit.open ? "RELEASE batch"
+                                                  : "COMMIT");
+}
+
+static void batch_rollback (struct content_sqlite *ctx)
+{
+    int saved_errno = errno;
+
+    if (ctx->group_commit.open) {
+        if (!sqlite3_get_autocommit (ctx->db)) {
+            (void)content_sqlite_exec (ctx, "ROLLBACK TO batch");
+            (void)content_sqlite_exec (ctx, "RELEASE batch");
+        }
+        group_commit_check (ctx);
+    }
+    else
+        (void)content_sqlite_exec (ctx, "ROLLBACK");
+    errno = saved_errno;
+}
+
+/* A large blob being hashed and compressed (store), or uncompressed (load)
+ * by a worker thread.  Only the work function runs in the worker thread,
+ * and it does not touch the sqlite handle or the module context.
+ */
+struct offload {
+    struct content_sqlite *ctx;
+    const flux_msg_t *msg;
+    const void *data;
+    int size;
+    void *buf;
+    int bufsize;
+    int codec;
+    int uncompressed_size;
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_size;
+    int errnum;
+    double work_time;
+    struct timespec t0;
+};
+
+static void offload_destroy (struct offload *off)
+{
+    if (off) {
+        int saved_errno = errno;
+        flux_msg_decref (off->msg);
+        free (off->buf);
+        free (off);
+        errno = saved_errno;
+    }
+}
+
+static struct offload *offload_create (struct content_sqlite *ctx,
+                                       const flux_msg_t *msg)
+{
+    struct offload *off;
+
+    if (!(off = calloc (1, sizeof (*off))))
+        return NULL;
+    off->ctx = ctx;
+    off->msg = flux_msg_incref (msg);
+    monotime (&off->t0);
+    return off;
+}
+
+/* Worker thread: hash and compress the request payload.
+ */
+static void store_offload_work (void *arg)
+{
+    struct offload *off = arg;
+    struct timespec t0;
+    int bound;
+
+    monotime (&t0);
+    if ((off->hash_size = blobref_hash_raw (off->ctx->hashfun,
+                                            off->data,
+                                            off->size,
+                                            off->hash,
+                                            sizeof (off->hash))) < 0
+        || (bound = content_codec_bound (off->codec, off->size)) < 0
+        || !(off->buf = malloc (bound))
+        || (off->bufsize = content_codec_compress (off->codec,
+                                                   off->data,
+                                                   off->size,
+                                                   off->buf,
+                                                   bound)) < 0)
+        off->errnum = errno;
+    off->work_time = monotime_since (t0);
+}
+
+static int store_respond (struct content_sqlite *ctx,
+                          const flux_msg_t *msg,
+                          const void *hash,
+                          int hash_size);
+
+/* Reactor: insert the compressed blob and respond.
+ */
+static void store_offload_done (void *arg)
+{
+    struct offload *off = arg;
+    struct content_sqlite *ctx = off->ctx;
+    int rc;
+
+    if (off->errnum != 0) {
+        errno = off->errnum;
+        goto error;
+    }
+    tstat_push (&ctx->stats.compress, off->work_time);
+    if (ctx->group_commit.window > 0 && group_commit_begin (ctx) < 0)
+        goto error;
+    content_gc_mark (ctx->collector,
+                     off->hash,
+                     off->hash_size,
+                     off->data,
+                     off->size);
+    if ((rc = content_sqlite_exists (ctx, off->hash, off->hash_size)) != 0)
+        rc = rc < 0 ? -1 : 0;
+    else if (off->bufsize < off->size)
+        rc = content_sqlite_insert (ctx,
+                                    off->hash,
+                                    off->hash_size,
+                                    off->buf,
+                                    off->bufsize,
+                                    off->size,
+                                    off->codec);
+    else // incompressible
+        rc = content_sqlite_insert (ctx,
+                                    off->hash,
+                                    off->hash_size,
+                                    off->data,
+                                    off->size,
+                                    off->size,
+                                    CONTENT_CODEC_NONE);
+    if (rc < 0) {
+        group_commit_check (ctx);
+        goto error;
+    }
+    tstat_push (&ctx->stats.store, monotime_since (off->t0));
+    if (store_respond (ctx, off->msg, off->hash, off->hash_size) < 0)
+        goto error;
+    offload_destroy (off);
+    return;
+error:
+    if (flux_respond_error (ctx->h, off->msg, errno, NULL) < 0)
+        flux_log_error (ctx->h, "store: flux_respond_error");
+    offload_destroy (off);
+}
+
+/* Worker thread: uncompress a copy of the stored object.
+ */
+static void load_offload_work (void *arg)
+{
+    struct offload *off = arg;
+    struct timespec t0;
+
+    monotime (&t0);
+    if (!(off->buf = malloc (off->uncompressed_size))
+        || (off->bufsize = content_codec_decompress (off->codec,
+                                                     off->data,
+                                                     off->size,
+                                                     off->buf,
+                                                     off->uncompressed_size))
+                                                        < 0)
+        off->errnum = errno;
+    off->work_time = monotime_since (t0);
+    free ((void *)off->data);
+    off->data = NULL;
+}
+
+/* Reactor: respond with the uncompressed blob.
+ */
+static void load_offload_done (void *arg)
+{
+    struct offload *off = arg;
+    struct content_sqlite *ctx = off->ctx;
+
+    if (off->errnum != 0) {
+        flux_log (ctx->h,
+                  LOG_ERR,
+                  "load: %s decompression failed: %s",
+                  content_codec_name (off->codec) ?: "unknown",
+                  strerror (off->errnum));
+        if (flux_respond_error (ctx->h, off->msg, off->errnum, NULL) < 0)
+            flux_log_error (ctx->h, "load: flux_respond_error");
+        goto done;
+    }
+    tstat_push (&ctx->stats.decompress, off->work_time);
+    tstat_push (&ctx->stats.load, monotime_since (off->t0));
+    if (flux_respond_raw (ctx->h, off->msg, off->buf, off->bufsize) < 0)
+        flux_log_error (ctx->h, "load: flux_respond_raw");
+done:
+    offload_destroy (off);
+}
+
+/* Copy a compressed object returned by content_sqlite_lookup() and hand
+ * it to a worker thread for decompression.  The load statement is reset.
+ * Returns 0 on success, or -1 on error with errno set.
+ */
+static int load_offload (struct content_sqlite *ctx,
+                         const flux_msg_t *msg,
+                         const void *data,
+                         int size,
+                         int codec,
+                         int uncompressed_size)
+{
+    struct offload *off;
+    void *cpy = NULL;
+
+    if (!(off = offload_create (ctx, msg))
+        || !(cpy = malloc (size)))
+        goto error;
+    memcpy (cpy, data, size);
+    (void )sqlite3_reset (ctx->load_stmt);
+    off->data = cpy;
+    off->size = size;
+    off->codec = codec;
+    off->uncompressed_size = uncompressed_size;
+    if (content_workpool_submit (ctx->pool,
+                                 load_offload_work,
+                                 load_offload_done,
+                                 off) < 0) {
+        ERRNO_SAFE_WRAP (free, cpy);
+        offload_destroy (off);
+        return -1;
+    }
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (sqlite3_reset, ctx->load_stmt);
+    offload_destroy (off);
+    return -1;
+}
+
+static void load_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    const void *hash;
+    int hash_size;
+    const void *data;
+    int size;
+    int codec;
+    int uncompressed_size;
+    struct timespec t0;
+
+    if (flux_request_decode_raw (msg,
+                                 NULL,
+                                 &hash,
+                                 &hash_size) < 0)
+        goto error;
+    if (hash_size != ctx->hash_size) {
+        errno = EPROTO;
+        goto error;
+    }
+    monotime (&t0);
+    if (content_sqlite_lookup (ctx,
+                               hash,
+                               hash_size,
+                               &data,
+                               &size,
+                               &codec,
+                               &uncompressed_size) < 0)
+        goto error;
+    if (ctx->pool
+        && codec != CONTENT_CODEC_NONE
+        && uncompressed_size >= offload_threshold) {
+        content_gc_mark (ctx->collector, hash, hash_size, NULL, 0);
+        if (load_offload (ctx,
+                          msg,
+                          data,
+                          size,
+                          codec,
+                          uncompressed_size) < 0)
+            goto error;
+        return;
+    }
+    if (content_sqlite_uncompress (ctx,
+                                   &data,
+                                   &size,
+                                   codec,
+                                   uncompressed_size) < 0)
+        goto error;
+    content_gc_mark (ctx->collector, hash, hash_size, data, size);
+    tstat_push (&ctx->stats.load, monotime_since (t0));
+    if (flux_respond_raw (h, msg, data, size) < 0)
+        flux_log_error (h, "load: flux_respond_raw");
+    (void )sqlite3_reset (ctx->load_stmt);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "load: flux_respond_error");
+}
+
+/* Respond to a store request, or defer the response until the open
+ * group commit transaction is committed.
+ */
+static int store_respond (struct content_sqlite *ctx,
+                          const flux_msg_t *msg,
+                          const void *hash,
+                          int hash_size)
+{
+    if (ctx->group_commit.open)
+        return group_commit_append (ctx, msg, hash, hash_size, 1);
+    if (flux_respond_raw (ctx->h, msg, hash, hash_size) < 0)
+        flux_log_error (ctx->h, "store: flux_respond_raw");
+    return 0;
+}
+
+/* Hand a large blob to a worker thread for hashing and compression.
+ * The request message holds a reference on the payload until done.
+ */
+static int store_offload (struct content_sqlite *ctx,
+                          const flux_msg_t *msg,
+                          const void *data,
+                          int size)
+{
+    struct offload *off;
+
+    if (!(off = offload_create (ctx, msg)))
+        return -1;
+    off->data = data;
+    off->size = size;
+    off->codec = ctx->codec;
+    if (content_workpool_submit (ctx->pool,
+                                 store_offload_work,
+                                 store_offload_done,
+                                 off) < 0) {
+        offload_destroy (off);
+        return -1;
+    }
+    return 0;
+}
+
+void store_cb (flux_t *h,
+               flux_msg_handler_t *mh,
+               const flux_msg_t *msg,
+               void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    const void *data;
+    int size;
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_size;
+    struct timespec t0;
+
+    if (flux_request_decode_raw (msg, NULL, &data, &size) < 0) {
+        flux_log_error (h, "store: request decode failed");
+        goto error;
+    }
+    if (ctx->pool
+        && ctx->codec != CONTENT_CODEC_NONE
+        && size >= offload_threshold) {
+        if (store_offload (ctx, msg, data, size) < 0)
+            goto error;
+        return;
+    }
+    if (ctx->group_commit.window > 0 && group_commit_begin (ctx) < 0)
+        goto error;
+    monotime (&t0);
+    if ((hash_size = content_sqlite_store (ctx,
+                                           data,
+                                           size,
+                                           hash,
+                                           sizeof (hash))) < 0) {
+        group_commit_check (ctx);
+        goto error;
+    }
+    tstat_push (&ctx->stats.store, monotime_since (t0));
+    if (store_respond (ctx, msg, hash, hash_size) < 0)
+        goto error;
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "store: flux_respond_error");
+}
+
+static int grow_batch_buf (struct content_sqlite *ctx, size_t size)
+{
+    size_t newsize = ctx->batch_bufsize;
+    void *newbuf;
+
+    if (newsize >= size)
+        return 0;
+    while (newsize < size)
+        newsize += lzo_buf_chunksize;
+    if (!(newbuf = realloc (ctx->batch_buf, newsize))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    ctx->batch_bufsize = newsize;
+    ctx->batch_buf = newbuf;
+    return 0;
+}
+
+/* Load a batch of blobs within one read transaction.  Missing blobs are
+ * reported individually in the response;  other errors fail the batch.
+ */
+static void load_batch_cb (flux_t *h,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           void *arg)
 {
     struct content_sqlite *ctx = arg;
-    const void *hash;
-    int hash_size;
-    const void *data;
-    int size;
+    const uint8_t *hashes;
+    int hashes_size;
+    int count;
+    size_t offset = 0;
     struct timespec t0;
+    int i;
 
     if (flux_request_decode_raw (msg,
                                  NULL,
-                                 &hash,
-                                 &hash_size) < 0)
+                                 (const void **)&hashes,
+                                 &hashes_size) < 0)
         goto error;
-    if (hash_size != ctx->hash_size) {
+    if (hashes_size == 0 || hashes_size % ctx->hash_size != 0) {
         errno = EPROTO;
         goto error;
     }
+    count = hashes_size / ctx->hash_size;
     monotime (&t0);
-    if (content_sqlite_load (ctx, hash, hash_size, &data, &size) < 0)
+    if (batch_begin (ctx) < 0)
         goto error;
-    tstat_push (&ctx->stats.load, monotime_since (t0));
-    if (flux_respond_raw (h, msg, data, size) < 0)
-        flux_log_error (h, "load: flux_respond_raw");
-    (void )sqlite3_reset (ctx->load_stmt);
+    for (i = 0; i < count; i++) {
+        const void *data = NULL;
+        int size = 0;
+        int errnum = 0;
+
+        if (content_sqlite_load (ctx,
+                                 hashes + i * ctx->hash_size,
+                                 ctx->hash_size,
+                                 &data,
+                                 &size) < 0) {
+            if (errno != ENOENT)
+                goto error_rollback;
+            errnum = errno;
+        }
+        else {
+            content_gc_mark (ctx->collector,
+                             hashes + i * ctx->hash_size,
+                             ctx->hash_size,
+                             data,
+                             size);
+        }
+        if (grow_batch_buf (ctx, offset
+                                 + CONTENT_BATCH_RESULT_OVERHEAD
+                                 + size) < 0) {
+            if (errnum == 0)
+                ERRNO_SAFE_WRAP (sqlite3_reset, ctx->load_stmt);
+            goto error_rollback;
+        }
+        offset += content_batch_encode_result ((char *)ctx->batch_buf + offset,
+                                               errnum,
+                                               0,
+                                               data,
+                                               size);
+        if (errnum == 0)
+            (void )sqlite3_reset (ctx->load_stmt);
+    }
+    if (batch_end (ctx) < 0)
+        goto error_rollback;
+    tstat_push (&ctx->stats.load_batch, monotime_since (t0));
+    if (flux_respond_raw (h, msg, ctx->batch_buf, offset) < 0)
+        flux_log_error (h, "load-batch: flux_respond_raw");
     return;
+error_rollback:
+    batch_rollback (ctx);
 error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
-        flux_log_error (h, "load: flux_respond_error");
+        flux_log_error (h, "load-batch: flux_respond_error");
 }
 
-void store_cb (flux_t *h,
-               flux_msg_handler_t *mh,
-               const flux_msg_t *msg,
-               void *arg)
+/* Store a batch of blobs in one transaction.  The batch is all-or-nothing.
+ * If group commit is enabled, the batch joins the open transaction and
+ * the response is deferred until it is committed.
+ */
+static void store_batch_cb (flux_t *h,
+                            flux_msg_handler_t *mh,
+                            const flux_msg_t *msg,
+                            void *arg)
 {
     struct content_sqlite *ctx = arg;
-    const void *data;
-    int size;
-    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
-    int hash_size;
+    const void *cursor;
+    int remaining;
+    int count = 0;
     struct timespec t0;
 
-    if (flux_request_decode_raw (msg, NULL, &data, &size) < 0) {
-        flux_log_error (h, "store: request decode failed");
+    if (flux_request_decode_raw (msg, NULL, &cursor, &remaining) < 0) {
+        flux_log_error (h, "store-batch: request decode failed");
         goto error;
     }
+    if (ctx->group_commit.window > 0 && group_commit_begin (ctx) < 0)
+        goto error;
     monotime (&t0);
-    if ((hash_size = content_sqlite_store (ctx,
-                                           data,
-                                           size,
-                                           hash,
-                                           sizeof (hash))) < 0)
+    if (batch_begin (ctx) < 0) {
+        group_commit_check (ctx);
         goto error;
-    tstat_push (&ctx->stats.store, monotime_since (t0));
-    if (flux_respond_raw (h, msg, hash, hash_size) < 0)
-        flux_log_error (h, "store: flux_respond_raw");
+    }
+    while (remaining > 0) {
+        const void *data;
+        int size;
+
+        if (content_batch_decode_blob (&cursor, &remaining, &data, &size) < 0
+            || grow_batch_buf (ctx, (count + 1) * ctx->hash_size) < 0
+            || content_sqlite_store (ctx,
+                                     data,
+                                     size,
+                                     (char *)ctx->batch_buf
+                                         + count * ctx->hash_size,
+                                     ctx->hash_size) < 0)
+            goto error_rollback;
+        count++;
+    }
+    if (count == 0) {
+        errno = EPROTO;
+        goto error_rollback;
+    }
+    if (batch_end (ctx) < 0)
+        goto error_rollback;
+    tstat_push (&ctx->stats.store_batch, monotime_since (t0));
+    if (ctx->group_commit.open) {
+        if (group_commit_append (ctx,
+                                 msg,
+                                 ctx->batch_buf,
+                                 count * ctx->hash_size,
+                                 count) < 0)
+            goto error;
+        return;
+    }
+    if (flux_respond_raw (h, msg, ctx->batch_buf, count * ctx->hash_size) < 0)
+        flux_log_error (h, "store-batch: flux_respond_raw");
     return;
+error_rollback:
+    batch_rollback (ctx);
 error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
-        flux_log_error (h, "store: flux_respond_error");
+        flux_log_error (h, "store-batch: flux_respond_error");
 }
 
 void checkpoint_get_cb (flux_t *h,
@@ -440,6 +1510,10 @@ void checkpoint_put_cb (flux_t *h,
         errno = EINVAL;
         goto error;
     }
+    /* Stores that the checkpoint may refer to must be committed first.
+     */
+    if (group_commit_flush (ctx) < 0)
+        goto error;
     if (sqlite3_bind_text (ctx->checkpt_put_stmt,
                            1,
                            (char *)key,
@@ -480,6 +1554,7 @@ static void content_sqlite_closedb (struct content_sqlite *ctx)
 {
     if (ctx) {
         int saved_errno = errno;
+        content_sqlite_bloom_rescan_stop (ctx);
         if (ctx->store_stmt) {
             if (sqlite3_finalize (ctx->store_stmt) != SQLITE_OK)
                 log_sqlite_error (ctx, "sqlite_finalize store_stmt");
@@ -496,6 +1571,30 @@ static void content_sqlite_closedb (struct content_sqlite *ctx)
             if (sqlite3_finalize (ctx->checkpt_put_stmt) != SQLITE_OK)
                 log_sqlite_error (ctx, "sqlite_finalize checkpt_put_stmt");
         }
+        if (ctx->exists_stmt) {
+            if (sqlite3_finalize (ctx->exists_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize exists_stmt");
+        }
+        if (ctx->touch_stmt) {
+            if (sqlite3_finalize (ctx->touch_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize touch_stmt");
+        }
+        if (ctx->stored_select_stmt) {
+            if (sqlite3_finalize (ctx->stored_select_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize stored_select_stmt");
+        }
+        if (ctx->sweep_select_stmt) {
+            if (sqlite3_finalize (ctx->sweep_select_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize sweep_select_stmt");
+        }
+        if (ctx->sweep_delete_stmt) {
+            if (sqlite3_finalize (ctx->sweep_delete_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize sweep_delete_stmt");
+        }
+        if (ctx->bloom_select_stmt) {
+            if (sqlite3_finalize (ctx->bloom_select_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize bloom_select_stmt");
+        }
         if (ctx->db) {
             if (sqlite3_close (ctx->db) != SQLITE_OK)
                 log_sqlite_error (ctx, "sqlite3_close");
@@ -525,6 +1624,268 @@ static int set_count (void *arg, int ncols, char **cols, char **col_names)
     return rc; // returning -1 causes SQLITE_ABORT
 }
 
+/* Garbage collection (see content-gc.h).
+ */
+static int gc_load (const void *hash,
+                    int hash_size,
+                    void **datap,
+                    int *sizep,
+                    void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    const void *data;
+    int size;
+    void *cpy;
+
+    if (content_sqlite_load (ctx, hash, hash_size, &data, &size) < 0)
+        return -1;
+    if (!(cpy = malloc (size > 0 ? size : 1))) {
+        ERRNO_SAFE_WRAP (sqlite3_reset, ctx->load_stmt);
+        return -1;
+    }
+    memcpy (cpy, data, size);
+    (void)sqlite3_reset (ctx->load_stmt);
+    *datap = cpy;
+    *sizep = size;
+    return 0;
+}
+
+static json_t *gc_checkpoints (void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    sqlite3_stmt *stmt = NULL;
+    json_t *values;
+    int rc;
+
+    if (!(values = json_array ())) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_checkpt_list,
+                            -1,
+                            &stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing checkpt list stmt");
+        set_errno_from_sqlite_error (ctx);
+        goto error;
+    }
+    while ((rc = sqlite3_step (stmt)) == SQLITE_ROW) {
+        const char *s = (const char *)sqlite3_column_text (stmt, 0);
+        json_t *o;
+
+        if (!s || !(o = json_loads (s, 0, NULL)))
+            continue;
+        if (json_array_append_new (values, o) < 0) {
+            json_decref (o);
+            errno = ENOMEM;
+            goto error;
+        }
+    }
+    if (rc != SQLITE_DONE) {
+        log_sqlite_error (ctx, "listing checkpoints");
+        set_errno_from_sqlite_error (ctx);
+        goto error;
+    }
+    (void)sqlite3_finalize (stmt);
+    return values;
+error:
+    ERRNO_SAFE_WRAP (sqlite3_finalize, stmt);
+    ERRNO_SAFE_WRAP (json_decref, values);
+    return NULL;
+}
+
+/* Release up to 'max' free pages back to the file system, if the
+ * database was created with auto_vacuum=INCREMENTAL.  Otherwise, freed
+ * pages are reused by later stores.
+ * Returns 1 if there is more to do, 0 when done, -1 on error.
+ */
+static int gc_compact (struct content_sqlite *ctx, int max)
+{
+    char sql[64];
+    int count;
+
+    if (!ctx->auto_vacuum)
+        return 0;
+    snprintf (sql, sizeof (sql), "PRAGMA incremental_vacuum(%d)", max);
+    if (sqlite3_exec (ctx->db, sql, NULL, NULL, NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "incremental_vacuum");
+        set_errno_from_sqlite_error (ctx);
+        return -1;
+    }
+    if (sqlite3_exec (ctx->db,
+                      "PRAGMA freelist_count",
+                      set_count,
+                      &count,
+                      NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "querying freelist_count");
+        set_errno_from_sqlite_error (ctx);
+        return -1;
+    }
+    return count > 0 ? 1 : 0;
+}
+
+/* List objects stored since the previous call of a cycle, which have
+ * rowids at or above the lowest one stored since then.  On the first
+ * call of a cycle, begin tracking stores for the next one.
+ */
+static int gc_stored (struct content_gc *gc, int max, void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    int count = 0;
+    int rc;
+
+    if (!ctx->stored_scan) {
+        ctx->stored_scan = true;
+        ctx->stored_from = ctx->stored_rowid;
+        ctx->stored_last = ctx->stored_rowid - 1;
+        ctx->stored_rowid = rowid_none;
+    }
+    if (ctx->stored_from == rowid_none)
+        return 0;
+    if (sqlite3_bind_int64 (ctx->stored_select_stmt,
+                            1,
+                            ctx->stored_last) != SQLITE_OK
+        || sqlite3_bind_int (ctx->stored_select_stmt, 2, max) != SQLITE_OK) {
+        log_sqlite_error (ctx, "gc: binding stored select");
+        goto error;
+    }
+    while ((rc = sqlite3_step (ctx->stored_select_stmt)) == SQLITE_ROW) {
+        const void *hash = sqlite3_column_blob (ctx->stored_select_stmt, 1);
+        int hash_size = sqlite3_column_bytes (ctx->stored_select_stmt, 1);
+
+        ctx->stored_last = sqlite3_column_int64 (ctx->stored_select_stmt, 0);
+        count++;
+        if (hash_size == ctx->hash_size
+            && content_gc_add_stored (gc, hash, hash_size) < 0) {
+            ERRNO_SAFE_WRAP (sqlite3_reset, ctx->stored_select_stmt);
+            return -1;
+        }
+    }
+    if (rc != SQLITE_DONE) {
+        log_sqlite_error (ctx, "gc: selecting stored objects");
+        goto error;
+    }
+    sqlite3_reset (ctx->stored_select_stmt);
+    return count < max ? 0 : 1;
+error:
+    set_errno_from_sqlite_error (ctx);
+    ERRNO_SAFE_WRAP (sqlite3_reset, ctx->stored_select_stmt);
+    return -1;
+}
+
+static int gc_sweep (struct content_gc *gc, int max, void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    sqlite3_int64 rowids[256];
+    int count = 0;
+    int removed = 0;
+    size_t reclaimed = 0;
+    int rc;
+    int i;
+
+    if (ctx->sweep_compact)
+        return gc_compact (ctx, max);
+    if (max > (int)(sizeof (rowids) / sizeof (rowids[0])))
+        max = sizeof (rowids) / sizeof (rowids[0]);
+    if (sqlite3_bind_int64 (ctx->sweep_select_stmt,
+                            1,
+                            ctx->sweep_rowid) != SQLITE_OK
+        || sqlite3_bind_int (ctx->sweep_select_stmt, 2, max) != SQLITE_OK) {
+        log_sqlite_error (ctx, "sweep: binding select");
+        goto error;
+    }
+    while ((rc = sqlite3_step (ctx->sweep_select_stmt)) == SQLITE_ROW) {
+        sqlite3_int64 rowid = sqlite3_column_int64 (ctx->sweep_select_stmt, 0);
+        const void *hash = sqlite3_column_blob (ctx->sweep_select_stmt, 1);
+        int hash_size = sqlite3_column_bytes (ctx->sweep_select_stmt, 1);
+
+        ctx->sweep_rowid = rowid;
+        count++;
+        if (!content_gc_is_live (gc, hash, hash_size)) {
+            rowids[removed++] = rowid;
+            reclaimed += hash_size
+                + sqlite3_column_int (ctx->sweep_select_stmt, 2);
+        }
+    }
+    if (rc != SQLITE_DONE) {
+        log_sqlite_error (ctx, "sweep: selecting objects");
+        goto error;
+    }
+    sqlite3_reset (ctx->sweep_select_stmt);
+    if (removed > 0) {
+        if (batch_begin (ctx) < 0)
+            return -1;
+        for (i = 0; i < removed; i++) {
+            if (sqlite3_bind_int64 (ctx->sweep_delete_stmt,
+                                    1,
+                                    rowids[i]) != SQLITE_OK
+                || sqlite3_step (ctx->sweep_delete_stmt) != SQLITE_DONE) {
+                log_sqlite_error (ctx, "sweep: deleting object");
+                set_errno_from_sqlite_error (ctx);
+                ERRNO_SAFE_WRAP (sqlite3_reset, ctx->sweep_delete_stmt);
+                batch_rollback (ctx);
+                return -1;
+            }
+            sqlite3_reset (ctx->sweep_delete_stmt);
+        }
+        if (batch_end (ctx) < 0) {
+            batch_rollback (ctx);
+            return -1;
+        }
+    }
+    content_gc_swept (gc, count, removed, reclaimed);
+    if (count == 0)
+        ctx->sweep_compact = true;
+    return 1;
+error:
+    set_errno_from_sqlite_error (ctx);
+    ERRNO_SAFE_WRAP (sqlite3_reset, ctx->sweep_select_stmt);
+    return -1;
+}
+
+/* If the cycle failed, the next one must list what this one did.
+ * Rebuild the Bloom filter, since removed objects remain in it.
+ * It is sized for the current filter's count, which includes them.
+ */
+static void gc_finish (struct content_gc *gc, int errnum, void *arg)
+{
+    struct content_sqlite *ctx = arg;
+
+    if (ctx->stored_scan) {
+        if (errnum)
+            content_sqlite_stored (ctx, ctx->stored_from);
+        ctx->stored_scan = false;
+    }
+    ctx->sweep_rowid = 0;
+    ctx->sweep_compact = false;
+    if (content_sqlite_bloom_rescan_start (ctx, bloom_count (ctx->bloom)) < 0)
+        flux_log_error (ctx->h, "error rebuilding bloom filter");
+}
+
+static const struct content_gc_ops gc_ops = {
+    .load = gc_load,
+    .checkpoints = gc_checkpoints,
+    .stored = gc_stored,
+    .sweep = gc_sweep,
+    .finish = gc_finish,
+};
+
+static void gc_request_cb (flux_t *h,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           void *arg)
+{
+    struct content_sqlite *ctx = arg;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0) {
+        if (flux_respond_error (h, msg, errno, NULL) < 0)
+            flux_log_error (h, "gc: flux_respond_error");
+        return;
+    }
+    content_gc_request (ctx->collector, msg);
+}
+
 static json_t *pack_tstat (tstat_t *ts)
 {
     json_t *o;
@@ -540,6 +1901,31 @@ static json_t *pack_tstat (tstat_t *ts)
     return o;
 }
 
+static json_t *pack_bloom_stats (struct content_sqlite *ctx)
+{
+    struct bloom_stats *bs = &ctx->bloom_stats;
+    unsigned long misses = bs->negatives + bs->false_positives;
+    json_t *o;
+
+    if (!(o = json_pack ("{s:b s:I s:I s:I s:f s:f s:I s:I s:I s:I}",
+                         "enabled", ctx->bloom ? 1 : 0,
+                         "entries", (json_int_t)bloom_count (ctx->bloom),
+                         "capacity", (json_int_t)bloom_capacity (ctx->bloom),
+                         "size", (json_int_t)bloom_size (ctx->bloom),
+                         "fp_rate_estimate", bloom_fp_rate (ctx->bloom),
+                         "fp_rate_observed",
+                           misses > 0 ? (double)bs->false_positives / misses
+                                      : 0.,
+                         "negatives", (json_int_t)bs->negatives,
+                         "false_positives", (json_int_t)bs->false_positives,
+                         "duplicates", (json_int_t)bs->duplicates,
+                         "rebuilds", (json_int_t)bs->rebuilds))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
 static unsigned long long get_file_size (const char *path)
 {
     struct stat sb;
@@ -568,6 +1954,14 @@ void stats_get_cb (flux_t *h,
     const char *errmsg = NULL;
     json_t *load_time = NULL;
     json_t *store_time = NULL;
+    json_t *load_batch_time = NULL;
+    json_t *store_batch_time = NULL;
+    json_t *batch_size = NULL;
+    json_t *commit_time = NULL;
+    json_t *compress_time = NULL;
+    json_t *decompress_time = NULL;
+    json_t *bloom = NULL;
+    json_t *gcstats = NULL;
 
     if (sqlite3_exec (ctx->db,
                       sql_objects_count,
@@ -579,25 +1973,93 @@ void stats_get_cb (flux_t *h,
         goto error;
     }
     if (!(load_time = pack_tstat (&ctx->stats.load))
-        || !(store_time = pack_tstat (&ctx->stats.store)))
+        || !(store_time = pack_tstat (&ctx->stats.store))
+        || !(load_batch_time = pack_tstat (&ctx->stats.load_batch))
+        || !(store_batch_time = pack_tstat (&ctx->stats.store_batch))
+        || !(batch_size = pack_tstat (&ctx->group_commit.batch_size))
+        || !(commit_time = pack_tstat (&ctx->group_commit.commit_time))
+        || !(compress_time = pack_tstat (&ctx->stats.compress))
+        || !(decompress_time = pack_tstat (&ctx->stats.decompress))
+        || !(bloom = pack_bloom_stats (ctx))
+        || !(gcstats = content_gc_stats (ctx->collector)))
         goto error;
     if (flux_respond_pack (h,
                            msg,
-                           "{s:i s:I s:I s:O s:O}",
+                           "{s:i s:I s:I s:O s:O s:O s:O"
+                           " s:{s:f s:i s:O s:O}"
+                           " s:{s:s s:i s:i s:O s:O}"
+                           " s:O s:O}",
                            "object_count", count,
                            "dbfile_size", get_file_size (ctx->dbfile),
                            "dbfile_free", get_fs_free (ctx->dbfile),
                            "load_time", load_time,
-                           "store_time", store_time) < 0)
+                           "store_time", store_time,
+                           "load_batch_time", load_batch_time,
+                           "store_batch_time", store_batch_time,
+                           "group_commit",
+                             "window", ctx->group_commit.window,
+                             "max_count", ctx->group_commit.max_count,
+                             "batch_size", batch_size,
+                             "commit_time", commit_time,
+                           "compression",
+                             "codec", content_codec_name (ctx->codec),
+                             "threads", ctx->nthreads,
+                             "pending", content_workpool_pending (ctx->pool),
+                             "compress_time", compress_time,
+                             "decompress_time", decompress_time,
+                           "bloom", bloom,
+                           "gc", gcstats) < 0)
         flux_log_error (h, "error responding to stats-get request");
     json_decref (load_time);
     json_decref (store_time);
+    json_decref (load_batch_time);
+    json_decref (store_batch_time);
+    json_decref (batch_size);
+    json_decref (commit_time);
+    json_decref (compress_time);
+    json_decref (decompress_time);
+    json_decref (bloom);
+    json_decref (gcstats);
     return;
 error:
     if (flux_respond_error (h, msg, errno, errmsg) < 0)
         flux_log_error (h, "error responding to stats-get request");
     json_decref (load_time);
     json_decref (store_time);
+    json_decref (load_batch_time);
+    json_decref (store_batch_time);
+    json_decref (batch_size);
+    json_decref (commit_time);
+    json_decref (compress_time);
+    json_decref (decompress_time);
+    json_decref (bloom);
+    json_decref (gcstats);
+}
+
+/* Databases created before the codec column was added lack it.
+ */
+static int content_sqlite_add_codec_column (struct content_sqlite *ctx)
+{
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_check_codec_column,
+                            -1,
+                            &stmt,
+                            NULL) == SQLITE_OK) {
+        (void)sqlite3_finalize (stmt);
+        return 0;
+    }
+    if (sqlite3_exec (ctx->db,
+                      sql_add_codec_column,
+                      NULL,
+                      NULL,
+                      NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "adding codec column to object table");
+        return -1;
+    }
+    flux_log (ctx->h, LOG_INFO, "added codec column to object table");
+    return 0;
 }
 
 /* Open the database file ctx->dbfile and set up the database.
@@ -607,6 +2069,7 @@ static int content_sqlite_opendb (struct content_sqlite *ctx, bool truncate)
     int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
     char s[128];
     int count;
+    int av = 0;
 
     if (truncate)
         (void)unlink (ctx->dbfile);
@@ -649,6 +2112,17 @@ static int content_sqlite_opendb (struct content_sqlite *ctx, bool truncate)
         log_sqlite_error (ctx, "setting sqlite 'quick_check' pragma");
         goto error;
     }
+    /* Takes effect only when the database is created.  It allows space
+     * freed by garbage collection to be returned incrementally.
+     */
+    if (sqlite3_exec (ctx->db,
+                      "PRAGMA auto_vacuum=INCREMENTAL",
+                      NULL,
+                      NULL,
+                      NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "setting sqlite 'auto_vacuum' pragma");
+        goto error;
+    }
     if (sqlite3_exec (ctx->db,
                       sql_create_table,
                       NULL,
@@ -657,6 +2131,8 @@ static int content_sqlite_opendb (struct content_sqlite *ctx, bool truncate)
         log_sqlite_error (ctx, "creating object table");
         goto error;
     }
+    if (content_sqlite_add_codec_column (ctx) < 0)
+        goto error;
     if (sqlite3_exec (ctx->db,
                       sql_create_table_checkpt,
                       NULL,
@@ -697,6 +2173,54 @@ static int content_sqlite_opendb (struct content_sqlite *ctx, bool truncate)
         log_sqlite_error (ctx, "preparing checkpt_put stmt");
         goto error;
     }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_exists,
+                            -1,
+                            &ctx->exists_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing exists stmt");
+        goto error;
+    }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_touch,
+                            -1,
+                            &ctx->touch_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing touch stmt");
+        goto error;
+    }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_objects_hashes,
+                            -1,
+                            &ctx->stored_select_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing stored_select stmt");
+        goto error;
+    }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_sweep_select,
+                            -1,
+                            &ctx->sweep_select_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing sweep_select stmt");
+        goto error;
+    }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_sweep_delete,
+                            -1,
+                            &ctx->sweep_delete_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing sweep_delete stmt");
+        goto error;
+    }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_objects_hashes,
+                            -1,
+                            &ctx->bloom_select_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing bloom_select stmt");
+        goto error;
+    }
     if (sqlite3_exec (ctx->db,
                       sql_objects_count,
                       set_count,
@@ -705,13 +2229,33 @@ static int content_sqlite_opendb (struct content_sqlite *ctx, bool truncate)
         log_sqlite_error (ctx, "querying objects count");
         goto error;
     }
+    if (content_sqlite_bloom_rebuild (ctx, count) < 0)
+        flux_log_error (ctx->h, "error building bloom filter");
+    if (sqlite3_exec (ctx->db,
+                      "PRAGMA auto_vacuum",
+                      set_count,
+                      &av,
+                      NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "querying auto_vacuum");
+        goto error;
+    }
+    ctx->auto_vacuum = (av == 2); // INCREMENTAL
     flux_log (ctx->h,
               LOG_DEBUG,
-              "%s (%d objects) journal_mode=%s synchronous=%s",
+              "%s (%d objects) journal_mode=%s synchronous=%s"
+              " compression=%s threads=%d",
               ctx->dbfile,
               count,
               ctx->journal_mode,
-              ctx->synchronous);
+              ctx->synchronous,
+              content_codec_name (ctx->codec),
+              ctx->nthreads);
+    if (ctx->group_commit.window > 0)
+        flux_log (ctx->h,
+                  LOG_DEBUG,
+                  "group commit enabled: window=%.3fs max=%d",
+                  ctx->group_commit.window,
+                  ctx->group_commit.max_count);
     return 0;
 error:
     set_errno_from_sqlite_error (ctx);
@@ -723,8 +2267,18 @@ static void content_sqlite_destroy (struct content_sqlite *ctx)
     if (ctx) {
         int saved_errno = errno;
         flux_msg_handler_delvec (ctx->handlers);
+        content_workpool_destroy (ctx->pool);
+        flux_watcher_destroy (ctx->group_commit.timer);
+        free (ctx->group_commit.entries);
+        flux_watcher_destroy (ctx->bloom_prep_w);
+        flux_watcher_destroy (ctx->bloom_check_w);
+        flux_watcher_destroy (ctx->bloom_idle_w);
+        bloom_destroy (ctx->bloom_next);
         free (ctx->dbfile);
         free (ctx->lzo_buf);
+        free (ctx->batch_buf);
+        bloom_destroy (ctx->bloom);
+        content_gc_destroy (ctx->collector);
         free (ctx);
         errno = saved_errno;
     }
@@ -733,16 +2287,22 @@ static void content_sqlite_destroy (struct content_sqlite *ctx)
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "content-backing.load",    load_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.store",   store_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.load-batch",
+                            load_batch_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.store-batch",
+                            store_batch_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.checkpoint-get",
                             checkpoint_get_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.checkpoint-put",
                             checkpoint_put_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.gc", gc_request_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-sqlite.stats-get", stats_get_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
 static struct content_sqlite *content_sqlite_create (flux_t *h)
 {
+    flux_reactor_t *r = flux_get_reactor (h);
     struct content_sqlite *ctx;
     const char *dbdir;
 
@@ -754,6 +2314,24 @@ static struct content_sqlite *content_sqlite_create (flux_t *h)
     ctx->h = h;
     ctx->journal_mode = "WAL";
     ctx->synchronous = "NORMAL";
+    ctx->group_commit.max_count = group_commit_default_max;
+    ctx->codec = CONTENT_CODEC_LZ4;
+    ctx->nthreads = default_compression_threads;
+    ctx->stored_rowid = rowid_none;
+    ctx->group_commit.timer = flux_timer_watcher_create (r,
+                                                         0.,
+                                                         0.,
+                                                         group_commit_timer_cb,
+                                                         ctx);
+    if (!ctx->group_commit.timer
+        || !(ctx->bloom_prep_w = flux_prepare_watcher_create (r,
+                                                              bloom_prep_cb,
+                                                              ctx))
+        || !(ctx->bloom_check_w = flux_check_watcher_create (r,
+                                                             bloom_check_cb,
+                                                             ctx))
+        || !(ctx->bloom_idle_w = flux_idle_watcher_create (r, NULL, NULL)))
+        goto error;
 
     /* Some tunables:
      * - the hash function, e.g. sha1, sha256
@@ -765,6 +2343,8 @@ static struct content_sqlite *content_sqlite_create (flux_t *h)
         flux_log_error (h, "content.hash");
         goto error;
     }
+    if (!(ctx->collector = content_gc_create (h, ctx->hashfun, &gc_ops, ctx)))
+        goto error;
 
     /* Prefer 'statedir' as the location for content.sqlite file, if set.
      * Otherwise use 'rundir', and enable pragmas that increase performance
@@ -814,6 +2394,50 @@ static int process_args (struct content_sqlite *ctx,
         else if (strncmp ("synchronous=", argv[i], 12) == 0) {
             ctx->synchronous = argv[i] + 12;
         }
+        else if (strncmp ("group_commit_window=", argv[i], 20) == 0) {
+            if (fsd_parse_duration (argv[i] + 20,
+                                    &ctx->group_commit.window) < 0) {
+                flux_log (ctx->h,
+                          LOG_ERR,
+                          "Invalid group_commit_window: '%s'",
+                          argv[i] + 20);
+                return -1;
+            }
+        }
+        else if (strncmp ("group_commit_max=", argv[i], 17) == 0) {
+            char *endptr;
+            errno = 0;
+            ctx->group_commit.max_count = strtol (argv[i] + 17, &endptr, 10);
+            if (errno != 0
+                || *endptr != '\0'
+                || ctx->group_commit.max_count < 1) {
+                flux_log (ctx->h,
+                          LOG_ERR,
+                          "Invalid group_commit_max: '%s'",
+                          argv[i] + 17);
+                return -1;
+            }
+        }
+        else if (strncmp ("compression=", argv[i], 12) == 0) {
+            if ((ctx->codec = content_codec_lookup (argv[i] + 12)) < 0) {
+                flux_log_error (ctx->h,
+                                "Invalid compression: '%s'",
+                                argv[i] + 12);
+                return -1;
+            }
+        }
+        else if (strncmp ("compression_threads=", argv[i], 20) == 0) {
+            char *endptr;
+            errno = 0;
+            ctx->nthreads = strtol (argv[i] + 20, &endptr, 10);
+            if (errno != 0 || *endptr != '\0' || ctx->nthreads < 0) {
+                flux_log (ctx->h,
+                          LOG_ERR,
+                          "Invalid compression_threads: '%s'",
+                          argv[i] + 20);
+                return -1;
+            }
+        }
         else if (strcmp ("truncate", argv[i]) == 0) {
             *truncate = true;
         }
@@ -838,6 +2462,15 @@ int mod_main (flux_t *h, int argc, char **argv)
     // override pragmas set above
     if (process_args (ctx, argc, argv, &truncate) < 0)
         goto done;
+    if (ctx->codec != CONTENT_CODEC_NONE && ctx->nthreads > 0) {
+        if (!(ctx->pool = content_workpool_create (flux_get_reactor (h),
+                                                   ctx->nthreads))) {
+            flux_log_error (h, "could not create compression threads");
+            goto done;
+        }
+    }
+    else
+        ctx->nthreads = 0;
     if (content_sqlite_opendb (ctx, truncate) < 0)
         goto done;
     if (content_register_service (h, "content-backing") < 0)
@@ -850,6 +2483,14 @@ int mod_main (flux_t *h, int argc, char **argv)
     }
     rc = 0;
 done_unreg:
+    /* Finish offloaded work, then commit its stores.
+     */
+    content_workpool_destroy (ctx->pool);
+    ctx->pool = NULL;
+    content_gc_destroy (ctx->collector);
+    ctx->collector = NULL;
+    if (group_commit_flush (ctx) < 0)
+        flux_log_error (h, "group-commit");
     (void)content_unregister_backing_store (h);
 done:
     content_sqlite_closedb (ctx);
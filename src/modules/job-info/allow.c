@@ -20,32 +20,33 @@
 #include "allow.h"
 
 #include "src/common/libeventlog/eventlog.h"
+#include "src/common/libeventlog/eventlog_index.h"
 
 /* Parse the submit userid from the event log.
- * Assume "submit" is the first event.
+ * Assume "submit" is the first event, so only that entry is decoded.
  */
 static int eventlog_get_userid (struct info_ctx *ctx, const char *s,
                                 uint32_t *useridp)
 {
-    json_t *a = NULL;
+    struct eventlog_index *index;
     json_t *entry = NULL;
     const char *name = NULL;
     json_t *context = NULL;
     int userid;
     int rv = -1;
 
-    if (!(a = eventlog_decode (s))) {
-        flux_log_error (ctx->h, "%s: eventlog_decode", __FUNCTION__);
+    if (!(index = eventlog_index_create ())
+        || eventlog_index_append (index, s, strlen (s)) < 0) {
+        flux_log_error (ctx->h, "%s: eventlog_index_append", __FUNCTION__);
+        goto error;
+    }
+    if (!(entry = eventlog_index_entry (index, 0))) {
         /* if eventlog improperly formatted, we'll consider this a
          * protocol error */
-        if (errno == EINVAL)
+        if (errno == EINVAL || errno == ENOENT)
             errno = EPROTO;
         goto error;
     }
-    if (!(entry = json_array_get (a, 0))) {
-        errno = EPROTO;
-        goto error;
-    }
     if (eventlog_entry_parse (entry, NULL, &name, &context) < 0) {
         flux_log_error (ctx->h, "%s: eventlog_decode", __FUNCTION__);
         goto error;
@@ -62,7 +63,7 @@ static int eventlog_get_userid (struct info_ctx *ctx, const char *s,
     (*useridp) = userid;
     rv = 0;
 error:
-    json_decref (a);
+    eventlog_index_destroy (index);
     return rv;
 }
 
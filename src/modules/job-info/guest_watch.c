@@ -22,6 +22,7 @@
 #include "src/common/libczmqcontainers/czmq_containers.h"
 #include "src/common/libjob/job.h"
 #include "src/common/libeventlog/eventlog.h"
+#include "src/common/libeventlog/eventlog_index.h"
 
 #include "job-info.h"
 #include "watch.h"
@@ -113,8 +114,8 @@ struct guest_watch_ctx {
     bool guest_started;
     bool guest_released;
 
-    /* data from guest namespace */
-    int offset;
+    /* sequence number of the next event to send */
+    int seq;
 };
 
 static int get_main_eventlog (struct guest_watch_ctx *gw);
@@ -144,7 +145,8 @@ static struct guest_watch_ctx *guest_watch_ctx_create (struct info_ctx *ctx,
                                                        const flux_msg_t *msg,
                                                        flux_jobid_t id,
                                                        const char *path,
-                                                       int flags)
+                                                       int flags,
+                                                       int start)
 {
     struct guest_watch_ctx *gw = calloc (1, sizeof (*gw));
     int saved_errno;
@@ -159,6 +161,7 @@ static struct guest_watch_ctx *guest_watch_ctx_create (struct info_ctx *ctx,
         goto error;
     }
     gw->flags = flags;
+    gw->seq = start;
     gw->state = GUEST_WATCH_STATE_INIT;
 
     gw->msg = flux_msg_incref (msg);
@@ -574,11 +577,12 @@ static int guest_namespace_watch (struct guest_watch_ctx *gw)
 
     if (!(msg = guest_msg_pack (gw,
                                 topic,
-                                "{s:I s:b s:s s:i}",
+                                "{s:I s:b s:s s:i s:i}",
                                 "id", gw->id,
                                 "guest", true,
                                 "path", gw->path,
-                                "flags", 0)))
+                                "flags", 0,
+                                "start", gw->seq)))
         goto error;
 
     if (!(gw->guest_namespace_watch_f = flux_rpc_message (gw->ctx->h,
@@ -626,8 +630,8 @@ static void guest_namespace_watch_continuation (flux_future_t *f, void *arg)
              *   request to read from it.
              * - racy scenario where data from a kvs-watch is missed
              *   b/c of the namespace removal (see issue #2386 for
-             *   details).  The tracking of data read/sent via the
-             *   offset variable will determine if we have more data
+             *   details).  The tracking of events sent via the
+             *   seq variable will determine if we have more data
              *   to send from the primary KVS namespace.
              */
             /* check for racy cancel - user canceled while this
@@ -662,7 +666,7 @@ static void guest_namespace_watch_continuation (flux_future_t *f, void *arg)
         goto error_cancel;
     }
 
-    gw->offset += strlen (event);
+    gw->seq++;
     flux_future_reset (f);
     return;
 
@@ -749,27 +753,12 @@ error:
     return rv;
 }
 
-static bool eventlog_parse_next (const char **pp, const char **tok,
-                                 size_t *toklen)
-{
-    char *term;
-
-    if (!(term = strchr (*pp, '\n')))
-        return false;
-    *tok = *pp;
-    *toklen = term - *pp + 1;
-    *pp = term + 1;
-    return true;
-}
-
 static void main_namespace_lookup_continuation (flux_future_t *f, void *arg)
 {
     struct guest_watch_ctx *gw = arg;
     struct info_ctx *ctx = gw->ctx;
     const char *s;
-    const char *input;
-    const char *tok;
-    size_t toklen;
+    struct eventlog_index *index = NULL;
     char path[PATH_MAX];
 
     if (full_guest_path (gw, path, PATH_MAX) < 0)
@@ -786,11 +775,19 @@ static void main_namespace_lookup_continuation (flux_future_t *f, void *arg)
         goto cleanup;
     }
 
-    input = s + gw->offset;
-    while (eventlog_parse_next (&input, &tok, &toklen)) {
+    if (!(index = eventlog_index_create ())
+        || eventlog_index_append (index, s, strlen (s)) < 0) {
+        flux_log_error (ctx->h, "%s: eventlog_index_append", __FUNCTION__);
+        goto error;
+    }
+    for (; gw->seq < eventlog_index_count (index); gw->seq++) {
+        const char *entry;
+        size_t len;
+
+        entry = eventlog_index_entry_text (index, gw->seq, &len);
         if (flux_respond_pack (ctx->h, gw->msg,
                                "{s:s#}",
-                               "event", tok, toklen) < 0) {
+                               "event", entry, len) < 0) {
             flux_log_error (ctx->h, "%s: flux_respond_pack",
                             __FUNCTION__);
             goto error;
@@ -805,6 +802,7 @@ error:
     if (flux_respond_error (ctx->h, gw->msg, errno, NULL) < 0)
         flux_log_error (ctx->h, "%s: flux_respond_error", __FUNCTION__);
 cleanup:
+    eventlog_index_destroy (index);
     /* flux future destroyed in guest_watch_ctx_destroy, which is called
      * via zlist_remove() */
     zlist_remove (ctx->guest_watchers, gw);
@@ -814,11 +812,12 @@ int guest_watch (struct info_ctx *ctx,
                  const flux_msg_t *msg,
                  flux_jobid_t id,
                  const char *path,
-                 int flags)
+                 int flags,
+                 int start)
 {
     struct guest_watch_ctx *gw = NULL;
 
-    if (!(gw = guest_watch_ctx_create (ctx, msg, id, path, flags)))
+    if (!(gw = guest_watch_ctx_create (ctx, msg, id, path, flags, start)))
         goto error;
 
     if (get_main_eventlog (gw) < 0)
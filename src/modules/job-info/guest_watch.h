@@ -19,7 +19,8 @@ int guest_watch (struct info_ctx *ctx,
                  const flux_msg_t *msg,
                  flux_jobid_t id,
                  const char *path,
-                 int flags);
+                 int flags,
+                 int start);
 
 /* Cancel all lookups that match msg.
  * match credentials & matchtag if cancel true
@@ -20,6 +20,7 @@
 #include "src/common/libczmqcontainers/czmq_containers.h"
 #include "src/common/libjob/job.h"
 #include "src/common/libeventlog/eventlog.h"
+#include "src/common/libeventlog/eventlog_index.h"
 
 #include "job-info.h"
 #include "watch.h"
@@ -33,6 +34,8 @@ struct watch_ctx {
     bool guest;
     char *path;
     int flags;
+    int start;
+    struct eventlog_index *index;
     flux_future_t *check_f;
     flux_future_t *watch_f;
     bool allow;
@@ -48,6 +51,7 @@ static void watch_ctx_destroy (void *data)
         struct watch_ctx *ctx = data;
         flux_msg_decref (ctx->msg);
         free (ctx->path);
+        eventlog_index_destroy (ctx->index);
         flux_future_destroy (ctx->check_f);
         flux_future_destroy (ctx->watch_f);
         free (ctx);
@@ -59,7 +63,8 @@ static struct watch_ctx *watch_ctx_create (struct info_ctx *ctx,
                                            flux_jobid_t id,
                                            bool guest,
                                            const char *path,
-                                           int flags)
+                                           int flags,
+                                           int start)
 {
     struct watch_ctx *w = calloc (1, sizeof (*w));
     int saved_errno;
@@ -75,6 +80,9 @@ static struct watch_ctx *watch_ctx_create (struct info_ctx *ctx,
         goto error;
     }
     w->flags = flags;
+    w->start = start;
+    if (!(w->index = eventlog_index_create ()))
+        goto error;
 
     w->msg = flux_msg_incref (msg);
 
@@ -189,53 +197,18 @@ done:
     zlist_remove (ctx->watchers, w);
 }
 
-static bool eventlog_parse_next (const char **pp, const char **tok,
-                                 size_t *toklen)
+/* Return true if entry 'seq' is the "clean" event, which is the last
+ * event in the main job eventlog.
+ */
+static bool is_eventlog_end (struct watch_ctx *w, int seq)
 {
-    char *term;
+    json_t *o;
+    const char *name;
 
-    if (!(term = strchr (*pp, '\n')))
+    if (!(o = eventlog_index_entry (w->index, seq))
+        || eventlog_entry_parse (o, NULL, &name, NULL) < 0)
         return false;
-    *tok = *pp;
-    *toklen = term - *pp + 1;
-    *pp = term + 1;
-    return true;
-}
-
-static int check_eventlog_end (struct watch_ctx *w,
-                               const char *tok,
-                               size_t toklen)
-{
-    char *str = NULL;
-    json_t *o = NULL;
-    const char *name = NULL;
-    int saved_errno, rc = -1;
-
-    if (!(str = strndup (tok, toklen))) {
-        flux_log_error (w->ctx->h, "%s: strndup", __FUNCTION__);
-        goto error;
-    }
-
-    if (!(o = eventlog_entry_decode (str))) {
-        flux_log_error (w->ctx->h, "%s: eventlog_entry_decode", __FUNCTION__);
-        goto error;
-    }
-
-    if (eventlog_entry_parse (o, NULL, &name, NULL) < 0) {
-        flux_log_error (w->ctx->h, "%s: eventlog_entry_parse", __FUNCTION__);
-        goto error;
-    }
-
-    if (!strcmp (name, "clean"))
-        rc = 1;
-    else
-        rc = 0;
-error:
-    saved_errno = errno;
-    free (str);
-    json_decref (o);
-    errno = saved_errno;
-    return rc;
+    return !strcmp (name, "clean");
 }
 
 static void watch_continuation (flux_future_t *f, void *arg)
@@ -243,9 +216,8 @@ static void watch_continuation (flux_future_t *f, void *arg)
     struct watch_ctx *w = arg;
     struct info_ctx *ctx = w->ctx;
     const char *s;
-    const char *input;
-    const char *tok;
-    size_t toklen;
+    int seq;
+    int count;
     const char *errmsg = NULL;
 
     if (flux_kvs_lookup_get (f, &s) < 0) {
@@ -275,14 +247,27 @@ static void watch_continuation (flux_future_t *f, void *arg)
         w->allow = true;
     }
 
-    input = s;
-    while (eventlog_parse_next (&input, &tok, &toklen)) {
-        if (flux_respond_pack (ctx->h, w->msg,
-                               "{s:s#}",
-                               "event", tok, toklen) < 0) {
-            flux_log_error (ctx->h, "%s: flux_respond_pack",
-                            __FUNCTION__);
-            goto error_cancel;
+    /* Entries before w->start are indexed but not sent.
+     */
+    seq = eventlog_index_count (w->index);
+    if (eventlog_index_append (w->index, s, strlen (s)) < 0) {
+        flux_log_error (ctx->h, "%s: eventlog_index_append", __FUNCTION__);
+        goto error_cancel;
+    }
+    count = eventlog_index_count (w->index);
+    for (; seq < count; seq++) {
+        if (seq >= w->start) {
+            const char *entry;
+            size_t len;
+
+            entry = eventlog_index_entry_text (w->index, seq, &len);
+            if (flux_respond_pack (ctx->h, w->msg,
+                                   "{s:s#}",
+                                   "event", entry, len) < 0) {
+                flux_log_error (ctx->h, "%s: flux_respond_pack",
+                                __FUNCTION__);
+                goto error_cancel;
+            }
         }
 
         /* When watching the main job eventlog, we return ENODATA back
@@ -292,7 +277,7 @@ static void watch_continuation (flux_future_t *f, void *arg)
          * known ruleset, so it will hang.
          */
         if (!w->guest && !strcmp (w->path, "eventlog")) {
-            if (check_eventlog_end (w, tok, toklen) > 0) {
+            if (is_eventlog_end (w, seq)) {
                 if (flux_kvs_lookup_cancel (w->watch_f) < 0) {
                     flux_log_error (ctx->h, "%s: flux_kvs_lookup_cancel",
                                     __FUNCTION__);
@@ -305,6 +290,9 @@ static void watch_continuation (flux_future_t *f, void *arg)
             }
         }
     }
+    /* Entries that have been sent (or skipped) are not needed again.
+     */
+    eventlog_index_trim (w->index, count);
 
     flux_future_reset (f);
     return;
@@ -334,12 +322,13 @@ int watch (struct info_ctx *ctx,
            flux_jobid_t id,
            const char *path,
            int flags,
+           int start,
            bool guest)
 {
     struct watch_ctx *w = NULL;
     uint32_t rolemask;
 
-    if (!(w = watch_ctx_create (ctx, msg, id, guest, path, flags)))
+    if (!(w = watch_ctx_create (ctx, msg, id, guest, path, flags, start)))
         goto error;
 
     /* if user requested an alternate path and that alternate path is
@@ -401,6 +390,7 @@ void watch_cb (flux_t *h, flux_msg_handler_t *mh,
     int guest = 0;
     const char *path = NULL;
     int flags;
+    int start = 0;
     const char *errmsg = NULL;
 
     if (flux_request_unpack (msg, NULL, "{s:I s:s s:i}",
@@ -417,15 +407,22 @@ void watch_cb (flux_t *h, flux_msg_handler_t *mh,
     }
     /* guest flag indicates to read path from guest namespace */
     (void)flux_request_unpack (msg, NULL, "{s:b}", "guest", &guest);
+    /* optional start indicates the first eventlog entry to send */
+    if (flux_request_unpack (msg, NULL, "{s?i}", "start", &start) < 0
+        || start < 0) {
+        errno = EPROTO;
+        errmsg = "eventlog-watch start must be a non-negative integer";
+        goto error;
+    }
 
     /* if watching a "guest" path, forward to guest watcher for
      * handling */
     if (!strncmp (path, "guest.", 6)) {
-        if (guest_watch (ctx, msg, id, path + 6, flags) < 0)
+        if (guest_watch (ctx, msg, id, path + 6, flags, start) < 0)
             goto error;
     }
     else {
-        if (watch (ctx, msg, id, path, flags, guest) < 0)
+        if (watch (ctx, msg, id, path, flags, start, guest) < 0)
             goto error;
     }
 
@@ -0,0 +1,369 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* decode.c - decode submit requests in worker threads
+ *
+ * Unwrapping J and parsing the jobspec are independent for each job,
+ * so they are handed to a small pool of threads to keep them off the
+ * reactor.  Jobs are queued on 'todo' and picked up by worker threads.
+ * They are also kept in submission order on 'inflight', which is only
+ * accessed from the reactor.  When a worker finishes a job, it marks it
+ * complete and writes a byte to a pipe, whose fd watcher calls the
+ * callback for each complete job at the head of 'inflight'.  Thus jobs
+ * are handed back in the order they were submitted, and are assigned
+ * jobids in that order.
+ *
+ * If the pool has zero threads, jobs are decoded synchronously in
+ * decoder_submit().
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <jansson.h>
+#include <flux/core.h>
+#if HAVE_FLUX_SECURITY
+#include <flux/security/context.h>
+#endif
+
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/tstat.h"
+
+#include "job.h"
+#include "util.h"
+#include "decode.h"
+
+struct work {
+    struct job *job;
+    int errnum;
+    flux_error_t error;
+    bool complete;
+    struct timespec t0;
+    double queue_time;
+    double decode_time;
+    struct work *next;          // todo list (shared)
+    struct work *inflight_next; // inflight list (reactor only)
+};
+
+struct thread {
+    pthread_t t;
+    struct decoder *d;
+#if HAVE_FLUX_SECURITY
+    flux_security_t *sec;
+#else
+    void *sec;
+#endif
+};
+
+struct decoder {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct work *todo_head;
+    struct work *todo_tail;
+    bool shutdown;
+    bool notified;
+
+    struct work *inflight_head;
+    struct work *inflight_tail;
+    int pending;
+
+    int nthreads;
+    struct thread *threads;
+#if HAVE_FLUX_SECURITY
+    flux_security_t *sec;       // for decoding without threads
+#else
+    void *sec;
+#endif
+    int fds[2];
+    flux_watcher_t *w;
+
+    decode_f cb;
+    void *arg;
+
+    tstat_t queue;
+    tstat_t decode;
+};
+
+static void *worker (void *arg)
+{
+    struct thread *t = arg;
+    struct decoder *d = t->d;
+    struct work *w;
+    struct timespec t1;
+
+    pthread_mutex_lock (&d->lock);
+    for (;;) {
+        while (!d->todo_head && !d->shutdown)
+            pthread_cond_wait (&d->cond, &d->lock);
+        if (!(w = d->todo_head))
+            break; // shutdown and nothing left to do
+        if (!(d->todo_head = w->next))
+            d->todo_tail = NULL;
+        pthread_mutex_unlock (&d->lock);
+
+        w->queue_time = monotime_since (w->t0);
+        monotime (&t1);
+        if (job_decode (w->job, t->sec, &w->error) < 0)
+            w->errnum = errno;
+        w->decode_time = monotime_since (t1);
+
+        pthread_mutex_lock (&d->lock);
+        w->complete = true;
+        if (!d->notified) {
+            char c = 0;
+            if (write (d->fds[1], &c, 1) < 0) {
+                // pipe is full, so the reactor is already notified
+            }
+            d->notified = true;
+        }
+    }
+    pthread_mutex_unlock (&d->lock);
+    return NULL;
+}
+
+/* Call the callback for complete jobs at the head of the inflight list.
+ */
+static void decoder_complete (struct decoder *d)
+{
+    struct work *head = NULL;
+    struct work *tail = NULL;
+    struct work *w;
+    char buf[64];
+
+    pthread_mutex_lock (&d->lock);
+    while (read (d->fds[0], buf, sizeof (buf)) > 0)
+        ;
+    d->notified = false;
+    while ((w = d->inflight_head) && w->complete) {
+        if (!(d->inflight_head = w->inflight_next))
+            d->inflight_tail = NULL;
+        w->inflight_next = NULL;
+        if (tail)
+            tail->inflight_next = w;
+        else
+            head = w;
+        tail = w;
+    }
+    pthread_mutex_unlock (&d->lock);
+
+    while ((w = head)) {
+        head = w->inflight_next;
+        d->pending--;
+        tstat_push (&d->queue, w->queue_time);
+        tstat_push (&d->decode, w->decode_time);
+        d->cb (w->job,
+               w->errnum,
+               w->errnum && w->error.text[0] ? w->error.text : NULL,
+               d->arg);
+        free (w);
+    }
+}
+
+static void decoder_cb (flux_reactor_t *r,
+                        flux_watcher_t *w,
+                        int revents,
+                        void *arg)
+{
+    decoder_complete (arg);
+}
+
+static void decode_sync (struct decoder *d, struct job *job)
+{
+    struct timespec t0;
+    flux_error_t error;
+    int errnum = 0;
+
+    monotime (&t0);
+    if (job_decode (job, d->sec, &error) < 0)
+        errnum = errno;
+    tstat_push (&d->queue, 0.);
+    tstat_push (&d->decode, monotime_since (t0));
+    d->cb (job, errnum, errnum && error.text[0] ? error.text : NULL, d->arg);
+}
+
+int decoder_submit (struct decoder *d, struct job *job)
+{
+    struct work *w;
+
+    if (!d || !job) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (d->nthreads == 0) {
+        decode_sync (d, job);
+        return 0;
+    }
+    if (!(w = calloc (1, sizeof (*w))))
+        return -1;
+    w->job = job;
+    monotime (&w->t0);
+    pthread_mutex_lock (&d->lock);
+    if (d->todo_tail)
+        d->todo_tail->next = w;
+    else
+        d->todo_head = w;
+    d->todo_tail = w;
+    if (d->inflight_tail)
+        d->inflight_tail->inflight_next = w;
+    else
+        d->inflight_head = w;
+    d->inflight_tail = w;
+    pthread_cond_signal (&d->cond);
+    pthread_mutex_unlock (&d->lock);
+    d->pending++;
+    return 0;
+}
+
+int decoder_nthreads (struct decoder *d)
+{
+    return d ? d->nthreads : 0;
+}
+
+json_t *decoder_stats_get (struct decoder *d)
+{
+    json_t *queue = NULL;
+    json_t *decode = NULL;
+    json_t *o;
+
+    if (!(queue = util_tstat_pack (&d->queue))
+        || !(decode = util_tstat_pack (&d->decode))
+        || !(o = json_pack ("{s:i s:i s:O s:O}",
+                            "threads", d->nthreads,
+                            "pending", d->pending,
+                            "queue", queue,
+                            "decode", decode)))
+        o = json_null ();
+    json_decref (queue);
+    json_decref (decode);
+    return o;
+}
+
+void decoder_destroy (struct decoder *d)
+{
+    if (d) {
+        int saved_errno = errno;
+        int i;
+
+        pthread_mutex_lock (&d->lock);
+        d->shutdown = true;
+        pthread_cond_broadcast (&d->cond);
+        pthread_mutex_unlock (&d->lock);
+        for (i = 0; i < d->nthreads; i++)
+            (void)pthread_join (d->threads[i].t, NULL);
+        if (d->fds[0] >= 0)
+            decoder_complete (d);
+        if (d->threads) {
+            for (i = 0; i < d->nthreads; i++) {
+#if HAVE_FLUX_SECURITY
+                flux_security_destroy (d->threads[i].sec);
+#endif
+            }
+            free (d->threads);
+        }
+#if HAVE_FLUX_SECURITY
+        flux_security_destroy (d->sec);
+#endif
+        flux_watcher_destroy (d->w);
+        if (d->fds[0] >= 0)
+            (void)close (d->fds[0]);
+        if (d->fds[1] >= 0)
+            (void)close (d->fds[1]);
+        pthread_cond_destroy (&d->cond);
+        pthread_mutex_destroy (&d->lock);
+        free (d);
+        errno = saved_errno;
+    }
+}
+
+#if HAVE_FLUX_SECURITY
+static flux_security_t *security_create (void)
+{
+    flux_security_t *sec;
+
+    if (!(sec = flux_security_create (0)))
+        return NULL;
+    if (flux_security_configure (sec, NULL) < 0) {
+        flux_security_destroy (sec);
+        errno = EINVAL;
+        return NULL;
+    }
+    return sec;
+}
+#endif
+
+struct decoder *decoder_create (flux_reactor_t *r,
+                                int nthreads,
+                                decode_f cb,
+                                void *arg)
+{
+    struct decoder *d;
+    int i;
+    int e;
+
+    if (!r || nthreads < 0 || !cb) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(d = calloc (1, sizeof (*d))))
+        return NULL;
+    pthread_mutex_init (&d->lock, NULL);
+    pthread_cond_init (&d->cond, NULL);
+    d->cb = cb;
+    d->arg = arg;
+    d->fds[0] = d->fds[1] = -1;
+    if (nthreads == 0) {
+#if HAVE_FLUX_SECURITY
+        if (!(d->sec = security_create ()))
+            goto error;
+#endif
+        return d;
+    }
+    if (pipe2 (d->fds, O_CLOEXEC | O_NONBLOCK) < 0)
+        goto error;
+    if (!(d->w = flux_fd_watcher_create (r,
+                                         d->fds[0],
+                                         FLUX_POLLIN,
+                                         decoder_cb,
+                                         d)))
+        goto error;
+    flux_watcher_start (d->w);
+    if (!(d->threads = calloc (nthreads, sizeof (d->threads[0]))))
+        goto error;
+    for (i = 0; i < nthreads; i++) {
+        struct thread *t = &d->threads[i];
+
+        t->d = d;
+#if HAVE_FLUX_SECURITY
+        if (!(t->sec = security_create ()))
+            goto error;
+#endif
+        if ((e = pthread_create (&t->t, NULL, worker, t))) {
+#if HAVE_FLUX_SECURITY
+            flux_security_destroy (t->sec);
+            t->sec = NULL;
+#endif
+            errno = e;
+            goto error;
+        }
+        d->nthreads++;
+    }
+    return d;
+error:
+    decoder_destroy (d);
+    return NULL;
+}
+
+// vi:ts=4 sw=4 expandtab
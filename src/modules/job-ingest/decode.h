@@ -0,0 +1,53 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _JOB_INGEST_DECODE_H
+#define _JOB_INGEST_DECODE_H
+
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "job.h"
+
+/* Called on the reactor thread for each job, in the order that jobs
+ * were submitted.  If decoding failed, 'errnum' is nonzero and 'errmsg'
+ * may contain a message for the submitter.
+ */
+typedef void (*decode_f)(struct job *job,
+                         int errnum,
+                         const char *errmsg,
+                         void *arg);
+
+/* Create a pool of 'nthreads' threads that call job_decode().
+ * Each thread has its own security context.  If 'nthreads' is zero,
+ * jobs are decoded (and the callback called) within decoder_submit().
+ */
+struct decoder *decoder_create (flux_reactor_t *r,
+                                int nthreads,
+                                decode_f cb,
+                                void *arg);
+
+/* Wait for queued jobs to be decoded, call the callback for them,
+ * and free the pool.
+ */
+void decoder_destroy (struct decoder *d);
+
+int decoder_submit (struct decoder *d, struct job *job);
+
+int decoder_nthreads (struct decoder *d);
+
+/* Return {"threads":i "pending":i "queue":{} "decode":{}} where queue
+ * and decode are millisecond latency statistics.
+ */
+json_t *decoder_stats_get (struct decoder *d);
+
+#endif /* !_JOB_INGEST_DECODE_H */
+
+// vi:ts=4 sw=4 expandtab
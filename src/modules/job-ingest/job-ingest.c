@@ -15,19 +15,18 @@
 #include <unistd.h>
 #include <jansson.h>
 #include <flux/core.h>
-#if HAVE_FLUX_SECURITY
-#include <flux/security/context.h>
-#include <flux/security/sign.h>
-#endif
 
 #include "src/common/libczmqcontainers/czmq_containers.h"
 #include "src/common/libutil/fluid.h"
 #include "src/common/libutil/jpath.h"
 #include "src/common/libutil/errprintf.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/tstat.h"
 #include "src/common/libjob/job_hash.h"
 
 #include "util.h"
 #include "job.h"
+#include "decode.h"
 #include "pipeline.h"
 
 /* job-ingest takes in signed jobspec submitted through flux_job_submit(),
@@ -43,9 +42,17 @@
  * arrive within the 'batch_timeout' window, they are combined into one
  * KVS transaction and one job-manager request.
  *
+ * Step 1 and the decoding of jobspec are performed by a pool of
+ * 'decode-threads' worker threads (see decode.c), which hand jobs back
+ * to the reactor in the order they were received.
+ *
  * The jobid is returned to the user in response to the job-ingest.submit RPC.
  * Responses are sent after the job has been successfully ingested.
  *
+ * The job-ingest.submit-bulk RPC accepts an array of submit requests.
+ * Each job is ingested independently, and a single response containing
+ * a jobid or error for each job is sent once all have been processed.
+ *
  * Currently all KVS data is committed under job.<fluid-dothex>,
  * where <fluid-dothex> is the jobid converted to 16-bit, 0-padded hex
  * strings delimited by periods, e.g.
@@ -72,14 +79,26 @@
  */
 static const double batch_timeout = 0.01;
 
+/* The default number of threads used to decode submit requests.
+ */
+static const int default_decode_threads = 4;
+
+/* Latency of ingest stages (milliseconds).  Decoding is reported
+ * by the decoder.
+ */
+struct ingest_stats {
+    tstat_t validate;   // per job: frobnicator + validator
+    tstat_t batch;      // per batch: creation to flush
+    tstat_t commit;     // per batch: KVS commit
+    tstat_t announce;   // per batch: job-manager.submit RPC
+    tstat_t total;      // per job: request to response
+};
+
 struct job_ingest_ctx {
     flux_t *h;
     struct pipeline *pipeline;
-#if HAVE_FLUX_SECURITY
-    flux_security_t *sec;
-#else
-    void *sec;
-#endif
+    struct decoder *decoder;
+    int decode_threads;
     struct fluid_generator gen;
     flux_msg_handler_t **handlers;
 
@@ -88,6 +107,8 @@ struct job_ingest_ctx {
 
     int batch_count;            // if nonzero, batch by count not timer
 
+    struct ingest_stats stats;
+
     bool shutdown;
 };
 
@@ -96,6 +117,7 @@ struct batch {
     flux_kvs_txn_t *txn;
     zlist_t *jobs;
     json_t *joblist;
+    struct timespec t0;         // start time of current batch stage
 };
 
 struct batch_response {
@@ -106,8 +128,102 @@ struct batch_response {
     zhashx_t *errors;
 };
 
+/* A job-ingest.submit-bulk request.  'results' is filled in as each
+ * job is ingested or fails, and the response is sent when 'pending'
+ * reaches zero.
+ */
+struct bulk {
+    const flux_msg_t *msg;
+    json_t *results;
+    int pending;
+};
+
 static int make_key (char *buf, int bufsz, struct job *job, const char *name);
 
+static void bulk_destroy (struct bulk *bulk)
+{
+    if (bulk) {
+        int saved_errno = errno;
+        flux_msg_decref (bulk->msg);
+        json_decref (bulk->results);
+        free (bulk);
+        errno = saved_errno;
+    }
+}
+
+static struct bulk *bulk_create (const flux_msg_t *msg, int njobs)
+{
+    struct bulk *bulk;
+
+    if (!(bulk = calloc (1, sizeof (*bulk))))
+        return NULL;
+    bulk->msg = flux_msg_incref (msg);
+    if (!(bulk->results = json_array ()))
+        goto nomem;
+    for (int i = 0; i < njobs; i++) {
+        if (json_array_append_new (bulk->results, json_null ()) < 0)
+            goto nomem;
+    }
+    bulk->pending = njobs;
+    return bulk;
+nomem:
+    bulk_destroy (bulk);
+    errno = ENOMEM;
+    return NULL;
+}
+
+/* Record the result of one job of a bulk request.  When all jobs have
+ * a result, respond to the request and destroy 'bulk'.
+ */
+static void bulk_set_result (flux_t *h,
+                             struct bulk *bulk,
+                             int index,
+                             json_t *result)
+{
+    if (!result || json_array_set_new (bulk->results, index, result) < 0)
+        flux_log (h, LOG_ERR, "error recording bulk submit result");
+    if (--bulk->pending == 0) {
+        if (flux_respond_pack (h,
+                               bulk->msg,
+                               "{s:O}",
+                               "jobs", bulk->results) < 0)
+            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+        bulk_destroy (bulk);
+    }
+}
+
+/* Respond to the submitter of 'job' with its jobid.
+ */
+static void job_respond (flux_t *h, struct job *job)
+{
+    if (job->bulk) {
+        bulk_set_result (h,
+                         job->bulk,
+                         job->bulk_index,
+                         json_pack ("{s:I}", "id", job->id));
+    }
+    else if (flux_respond_pack (h, job->msg, "{s:I}", "id", job->id) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+}
+
+static void job_respond_error (flux_t *h,
+                               struct job *job,
+                               int errnum,
+                               const char *errmsg)
+{
+    if (job->bulk) {
+        bulk_set_result (h,
+                         job->bulk,
+                         job->bulk_index,
+                         json_pack ("{s:i s:s}",
+                                    "errnum", errnum,
+                                    "errstr", errmsg ? errmsg
+                                                     : strerror (errnum)));
+    }
+    else if (flux_respond_error (h, job->msg, errnum, errmsg) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
 static void batch_destroy (struct batch *batch)
 {
     if (batch) {
@@ -142,6 +258,7 @@ static struct batch *batch_create (struct job_ingest_ctx *ctx)
     if (!(batch->joblist = json_array ()))
         goto nomem;
     batch->ctx = ctx;
+    monotime (&batch->t0);
     return batch;
 nomem:
     errno = ENOMEM;
@@ -237,8 +354,7 @@ static void batch_respond_error (struct batch *batch,
     flux_t *h = batch->ctx->h;
     struct job *job = zlist_first (batch->jobs);
     while (job) {
-        if (flux_respond_error (h, job->msg, errnum, errstr) < 0)
-            flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+        job_respond_error (h, job, errnum, errstr);
         job = zlist_next (batch->jobs);
     }
 }
@@ -258,12 +374,12 @@ static void batch_respond (struct batch *batch, struct batch_response *br)
     }
 
     while (job) {
-        if ((errmsg = zhashx_lookup (br->errors, &job->id))) {
-            if (flux_respond_error (h, job->msg, EINVAL, errmsg) < 0)
-                flux_log_error (h, "batch_respond: flux_respond_error");
+        if ((errmsg = zhashx_lookup (br->errors, &job->id)))
+            job_respond_error (h, job, EINVAL, errmsg);
+        else {
+            job_respond (h, job);
+            tstat_push (&batch->ctx->stats.total, monotime_since (job->t_recv));
         }
-        else if (flux_respond_pack (h, job->msg, "{s:I}", "id", job->id) < 0)
-            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
         job = zlist_next (batch->jobs);
     }
 }
@@ -326,6 +442,7 @@ static void batch_announce_continuation (flux_future_t *f, void *arg)
     struct batch_response *bresp;
     flux_t *h = batch->ctx->h;
 
+    tstat_push (&batch->ctx->stats.announce, monotime_since (batch->t0));
     if (!(bresp = batch_response_create (f)))
         batch_respond_error (batch,
                              errno,
@@ -350,6 +467,7 @@ static void batch_announce (struct batch *batch)
     flux_t *h = batch->ctx->h;
     flux_future_t *f;
 
+    monotime (&batch->t0);
     if (!(f = flux_rpc_pack (h, "job-manager.submit", FLUX_NODEID_ANY, 0,
                              "{s:O}",
                              "jobs", batch->joblist)))
@@ -373,6 +491,7 @@ static void batch_flush_continuation (flux_future_t *f, void *arg)
 {
     struct batch *batch = arg;
 
+    tstat_push (&batch->ctx->stats.commit, monotime_since (batch->t0));
     if (flux_future_get (f, NULL) < 0) {
         batch_respond_error (batch, errno, "KVS commit failed");
         batch_destroy (batch);
@@ -396,6 +515,8 @@ static void batch_flush (struct job_ingest_ctx *ctx)
     batch = ctx->batch;
     ctx->batch = NULL;
 
+    tstat_push (&ctx->stats.batch, monotime_since (batch->t0));
+    monotime (&batch->t0);
     if (!(f = flux_kvs_commit (ctx->h, NULL, 0, batch->txn))) {
         batch_respond_error (batch, errno, "flux_kvs_commit failed");
         goto error;
@@ -496,6 +617,7 @@ error:
 
 static int ingest_add_job (struct job_ingest_ctx *ctx, struct job *job)
 {
+    tstat_push (&ctx->stats.validate, monotime_since (job->t_stage));
     if (fluid_generate (&ctx->gen, &job->id) < 0)
         return -1;
 
@@ -539,31 +661,33 @@ void pipeline_continuation (flux_future_t *f, void *arg)
     flux_future_destroy (f);
     return;
 error:
-    if (flux_respond_error (h, job->msg, errno, errmsg) < 0)
-        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    job_respond_error (h, job, errno, errmsg);
     job_destroy (job);
     flux_future_destroy (f);
 }
 
-/* Handle "job-ingest.submit" request to add a new job.
+/* A job has been decoded by the decoder.  Pass it through the
+ * frobnicator and validator pipeline, then add it to the current batch.
  */
-static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
-                       const flux_msg_t *msg, void *arg)
+static void decode_cb (struct job *job,
+                       int errnum,
+                       const char *errmsg,
+                       void *arg)
 {
     struct job_ingest_ctx *ctx = arg;
-    struct job *job = NULL;
-    const char *errmsg = NULL;
+    flux_t *h = ctx->h;
     flux_error_t error;
     flux_future_t *f = NULL;
 
-    if (ctx->shutdown) {
-        errno = ENOSYS;
+    if (errnum != 0) {
+        errno = errnum;
         goto error;
     }
-    if (!(job = job_create_from_request (msg, ctx->sec, &error))) {
-        errmsg = error.text;
+    if (ctx->shutdown) {
+        errno = ENOSYS;
         goto error;
     }
+    monotime (&job->t_stage);
     if (pipeline_process_job (ctx->pipeline, job, &f, &error) < 0) {
         errmsg = error.text;
         goto error;
@@ -580,12 +704,92 @@ static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
     }
     return;
 error:
-    if (flux_respond_error (h, msg, errno, errmsg) < 0)
-        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    job_respond_error (h, job, errno, errmsg);
     job_destroy (job);
     flux_future_destroy (f);
 }
 
+/* Handle "job-ingest.submit" request to add a new job.
+ */
+static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
+                       const flux_msg_t *msg, void *arg)
+{
+    struct job_ingest_ctx *ctx = arg;
+    struct job *job = NULL;
+
+    if (ctx->shutdown) {
+        errno = ENOSYS;
+        goto error;
+    }
+    if (!(job = job_create (msg)))
+        goto error;
+    if (decoder_submit (ctx->decoder, job) < 0)
+        goto error;
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    job_destroy (job);
+}
+
+/* Handle "job-ingest.submit-bulk" request to add an array of new jobs.
+ * Each entry of the array has the form of a job-ingest.submit request.
+ */
+static void submit_bulk_cb (flux_t *h, flux_msg_handler_t *mh,
+                            const flux_msg_t *msg, void *arg)
+{
+    struct job_ingest_ctx *ctx = arg;
+    json_t *jobs;
+    struct bulk *bulk;
+    size_t index;
+    json_t *entry;
+
+    if (ctx->shutdown) {
+        errno = ENOSYS;
+        goto error;
+    }
+    if (flux_request_unpack (msg, NULL, "{s:o}", "jobs", &jobs) < 0)
+        goto error;
+    if (!json_is_array (jobs)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (json_array_size (jobs) == 0) {
+        if (flux_respond_pack (h, msg, "{s:[]}", "jobs") < 0)
+            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+        return;
+    }
+    if (!(bulk = bulk_create (msg, json_array_size (jobs))))
+        goto error;
+    /* Jobs may complete (and 'bulk' may be destroyed) during this loop
+     * if they are decoded synchronously, so don't access 'bulk' after
+     * the last job is submitted.
+     */
+    json_array_foreach (jobs, index, entry) {
+        struct job *job;
+
+        if (!(job = job_create_bulk (msg, entry))) {
+            bulk_set_result (h,
+                             bulk,
+                             index,
+                             json_pack ("{s:i s:s}",
+                                        "errnum", errno,
+                                        "errstr", strerror (errno)));
+            continue;
+        }
+        job->bulk = bulk;
+        job->bulk_index = index;
+        if (decoder_submit (ctx->decoder, job) < 0) {
+            job_respond_error (h, job, errno, NULL);
+            job_destroy (job);
+        }
+    }
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
 /* Override built-in shutdown handler that calls flux_reactor_stop().
  * Since libsubprocess clients must run in reactive mode,
  * take care of cleaning up the pipeline before exiting reactor.
@@ -631,6 +835,7 @@ error:
  *
  *  [ingest]
  *  batch-count = N
+ *  decode-threads = N
  *
  *  [ingest.validator]
  *  disable = false
@@ -650,9 +855,10 @@ static int job_ingest_configure (struct job_ingest_ctx *ctx,
         return -1;
     if (flux_conf_unpack (conf,
                           &conf_error,
-                          "{s?{s?i}}",
+                          "{s?{s?i s?i}}",
                           "ingest",
-                            "batch-count", &ctx->batch_count) < 0) {
+                            "batch-count", &ctx->batch_count,
+                            "decode-threads", &ctx->decode_threads) < 0) {
         errprintf (error,
                   "error reading [ingest] config table: %s",
                   conf_error.text);
@@ -674,12 +880,47 @@ static int job_ingest_configure (struct job_ingest_ctx *ctx,
                 return -1;
             }
         }
+        else if (!strncmp (argv[i], "decode-threads=", 15)) {
+            char *endptr;
+            errno = 0;
+            ctx->decode_threads = strtol (argv[i]+15, &endptr, 0);
+            if (errno != 0 || *endptr != '\0') {
+                errprintf (error, "Invalid decode-threads: %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+        }
         else {
             errprintf (error, "Invalid option: %s", argv[i]);
             errno = EINVAL;
             return -1;
         }
     }
+    if (ctx->decode_threads < 0) {
+        errprintf (error, "decode-threads must be >= 0");
+        errno = EINVAL;
+        return -1;
+    }
+    /* (Re)create the decoder if the number of threads changed.
+     * Any jobs queued in the old one are finished first.
+     */
+    if (!ctx->decoder
+        || decoder_nthreads (ctx->decoder) != ctx->decode_threads) {
+        struct decoder *decoder;
+
+        if (!(decoder = decoder_create (flux_get_reactor (ctx->h),
+                                        ctx->decode_threads,
+                                        decode_cb,
+                                        ctx))) {
+            errprintf (error,
+                       "error creating decoder with %d threads: %s",
+                       ctx->decode_threads,
+                       strerror (errno));
+            return -1;
+        }
+        decoder_destroy (ctx->decoder);
+        ctx->decoder = decoder;
+    }
     return 0;
 }
 
@@ -716,26 +957,53 @@ static void stats_get_cb (flux_t *h,
 {
     struct job_ingest_ctx *ctx = arg;
     json_t *pstats = NULL;
+    json_t *dstats = NULL;
+    json_t *latency = NULL;
 
     if (flux_request_decode (msg, NULL, NULL) < 0)
         goto error;
     pstats = pipeline_stats_get (ctx->pipeline);
+    dstats = decoder_stats_get (ctx->decoder);
+    if (!(latency = json_pack ("{s:o s:o s:o s:o s:o}",
+                               "validate",
+                               util_tstat_pack (&ctx->stats.validate),
+                               "batch",
+                               util_tstat_pack (&ctx->stats.batch),
+                               "commit",
+                               util_tstat_pack (&ctx->stats.commit),
+                               "announce",
+                               util_tstat_pack (&ctx->stats.announce),
+                               "total",
+                               util_tstat_pack (&ctx->stats.total)))) {
+        errno = ENOMEM;
+        goto error;
+    }
     if (flux_respond_pack (h,
                            msg,
-                           "{s:O}",
-                           "pipeline", pstats) < 0)
+                           "{s:O s:O s:O}",
+                           "pipeline", pstats,
+                           "decode", dstats,
+                           "latency", latency) < 0)
         flux_log_error (h, "error responding to stats-get request");
     json_decref (pstats);
+    json_decref (dstats);
+    json_decref (latency);
     return;
 error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         flux_log_error (h, "error responding to stats-get request");
+    json_decref (pstats);
+    json_decref (dstats);
 }
 
 
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.getinfo", getinfo_cb, 0},
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.submit", submit_cb, FLUX_ROLE_USER },
+    { FLUX_MSGTYPE_REQUEST,
+      "job-ingest.submit-bulk",
+      submit_bulk_cb,
+      FLUX_ROLE_USER },
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.shutdown", shutdown_cb, 0 },
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.config-reload", reload_cb, 0 },
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.stats-get",  stats_get_cb, 0 },
@@ -750,6 +1018,7 @@ int job_ingest_ctx_init (struct job_ingest_ctx *ctx,
     flux_reactor_t *r = flux_get_reactor (h);
     memset (ctx, 0, sizeof (*ctx));
     ctx->h = h;
+    ctx->decode_threads = default_decode_threads;
     flux_error_t error;
 
     if (!(ctx->pipeline = pipeline_create (h))) {
@@ -760,17 +1029,6 @@ int job_ingest_ctx_init (struct job_ingest_ctx *ctx,
         flux_log (h, LOG_ERR, "%s", error.text);
         return -1;
     }
-#if HAVE_FLUX_SECURITY
-    if (!(ctx->sec = flux_security_create (0))) {
-        flux_log_error (h, "flux_security_create");
-        return -1;
-    }
-    if (flux_security_configure (ctx->sec, NULL) < 0) {
-        flux_log_error (h, "flux_security_configure: %s",
-                        flux_security_last_error (ctx->sec));
-        return -1;
-    }
-#endif
     if (flux_msg_handler_addvec (h, htab, ctx, &ctx->handlers) < 0) {
         flux_log_error (h, "flux_msghandler_add");
         return -1;
@@ -860,9 +1118,8 @@ int mod_main (flux_t *h, int argc, char **argv)
 done:
     flux_msg_handler_delvec (ctx.handlers);
     flux_watcher_destroy (ctx.timer);
-#if HAVE_FLUX_SECURITY
-    flux_security_destroy (ctx.sec);
-#endif
+    ctx.shutdown = true; // fail jobs still in the decoder
+    decoder_destroy (ctx.decoder);
     pipeline_destroy (ctx.pipeline);
     return rc;
 }
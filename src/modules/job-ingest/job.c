@@ -22,6 +22,7 @@
 
 #include "src/common/libutil/errprintf.h"
 #include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/monotime.h"
 #include "src/common/libjob/sign_none.h"
 
 #include "job.h"
@@ -31,6 +32,7 @@ void job_destroy (struct job *job)
     if (job) {
         int saved_errno = errno;
         flux_msg_decref (job->msg);
+        json_decref (job->request);
         json_decref (job->jobspec);
         free (job);
         errno = saved_errno;
@@ -47,11 +49,46 @@ static int valid_flags (int flags)
     return 0;
 }
 
-struct job *job_create_from_request (const flux_msg_t *msg,
-                                     void *security_context,
-                                     flux_error_t *error)
+struct job *job_create (const flux_msg_t *msg)
 {
     struct job *job;
+
+    if (!(job = calloc (1, sizeof (*job))))
+        return NULL;
+    job->msg = flux_msg_incref (msg);
+    monotime (&job->t_recv);
+    if (flux_request_decode (job->msg, NULL, &job->payload) < 0
+        || flux_msg_get_cred (job->msg, &job->cred) < 0) {
+        job_destroy (job);
+        return NULL;
+    }
+    return job;
+}
+
+struct job *job_create_bulk (const flux_msg_t *msg, json_t *request)
+{
+    struct job *job;
+
+    if (!request) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(job = calloc (1, sizeof (*job))))
+        return NULL;
+    job->msg = flux_msg_incref (msg);
+    job->request = json_incref (request);
+    monotime (&job->t_recv);
+    if (flux_msg_get_cred (job->msg, &job->cred) < 0) {
+        job_destroy (job);
+        return NULL;
+    }
+    return job;
+}
+
+int job_decode (struct job *job,
+                void *security_context,
+                flux_error_t *error)
+{
     int64_t userid_signer;
     const char *mech_type;
     json_error_t json_error;
@@ -59,19 +96,19 @@ struct job *job_create_from_request (const flux_msg_t *msg,
     int jobspec_strsize;
     char *jobspec_buf = NULL;
 
-    if (!(job = calloc (1, sizeof (*job)))) {
-        errprintf (error, "out of memory decoding job request");
-        return NULL;
-    }
-    job->msg = flux_msg_incref (msg);
-    if (flux_request_unpack (job->msg,
-                             NULL,
-                             "{s:s s:i s:i}",
-                             "J", &job->J,
-                             "urgency", &job->urgency,
-                             "flags", &job->flags) < 0
-        || flux_msg_get_cred (job->msg, &job->cred) < 0) {
-        errprintf (error, "error decoding job request: %s", strerror (errno));
+    /* The request message is not accessed here since its reference
+     * count may be changed concurrently by the reactor thread.
+     */
+    if ((!job->request
+         && (!job->payload
+             || !(job->request = json_loads (job->payload, 0, NULL))))
+        || json_unpack (job->request,
+                        "{s:s s:i s:i}",
+                        "J", &job->J,
+                        "urgency", &job->urgency,
+                        "flags", &job->flags) < 0) {
+        errprintf (error, "error decoding job request: %s", strerror (EPROTO));
+        errno = EPROTO;
         goto error;
     }
     if (valid_flags (job->flags) < 0) {
@@ -160,13 +197,29 @@ struct job *job_create_from_request (const flux_msg_t *msg,
         goto inval;
     }
     free (jobspec_buf);
-    return job;
+    return 0;
 inval:
     errno = EINVAL;
 error:
     ERRNO_SAFE_WRAP (free, jobspec_buf);
-    job_destroy (job);
-    return NULL;
+    return -1;
+}
+
+struct job *job_create_from_request (const flux_msg_t *msg,
+                                     void *security_context,
+                                     flux_error_t *error)
+{
+    struct job *job;
+
+    if (!(job = job_create (msg))) {
+        errprintf (error, "error decoding job request: %s", strerror (errno));
+        return NULL;
+    }
+    if (job_decode (job, security_context, error) < 0) {
+        job_destroy (job);
+        return NULL;
+    }
+    return job;
 }
 
 json_t *job_json_object (struct job *job, flux_error_t *error)
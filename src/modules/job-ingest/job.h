@@ -11,23 +11,55 @@
 #ifndef _JOB_INGEST_JOB_H_
 #define _JOB_INGEST_JOB_H_
 
+#include <time.h>
 #include <jansson.h>
 #include <flux/core.h>
 
+struct bulk;
+
 struct job {
     flux_jobid_t id;
 
     const flux_msg_t *msg; // submit request message
+    const char *payload; // submit request payload
+    json_t *request;    // decoded submit request payload
     const char *J;      // signed jobspec
     struct flux_msg_cred cred;    // submitting user's creds
     int urgency;        // requested job urgency
     int flags;          // submit flags
     json_t *jobspec;    // jobspec modified after unwrap from J
+    struct timespec t_recv; // time submit request was received
+    struct timespec t_stage; // start time of current ingest stage
+    struct bulk *bulk;  // bulk submit request containing this job, if any
+    int bulk_index;     // index of this job in the bulk request
 };
 
 
 void job_destroy (struct job *job);
 
+/* Create a job from a submit request without decoding its payload.
+ * This takes a reference on 'msg' so it must be called from the
+ * reactor thread.
+ */
+struct job *job_create (const flux_msg_t *msg);
+
+/* Create a job from one entry of a bulk submit request, where 'request'
+ * has the same form as a job-ingest.submit request payload.
+ * Like job_create(), this must be called from the reactor thread.
+ */
+struct job *job_create_bulk (const flux_msg_t *msg, json_t *request);
+
+/* Decode the submit request payload, check the submitting user's
+ * permissions, and unwrap J to obtain the jobspec.  This may be called
+ * from a thread other than the reactor provided that 'security_context'
+ * is not shared.
+ */
+int job_decode (struct job *job,
+                void *security_context,
+                flux_error_t *error);
+
+/* job_create() + job_decode()
+ */
 struct job *job_create_from_request (const flux_msg_t *msg,
                                      void *security_context,
                                      flux_error_t *error);
@@ -0,0 +1,526 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* jobspec.c - in-process versions of the built-in validator plugins
+ *
+ * These follow the checks made by the Python Jobspec and JobspecV1
+ * classes and the require-instance plugin, so that a job accepted by one
+ * is accepted by the other.  Error messages are the same where practical.
+ *
+ * N.B. flux_jobspec1_check() in libjob is not used for the checks since
+ * it is stricter than the Python validator, e.g. it rejects exclusive
+ * node vertices and resource count ranges.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <jansson.h>
+#include <flux/core.h>
+#include <flux/idset.h>
+#include <flux/hostlist.h>
+
+#include "src/common/libutil/errprintf.h"
+
+#include "jobspec.h"
+
+static int validate_object (json_t *o,
+                            const char *name,
+                            const char **keys,
+                            bool keys_optional,
+                            bool allow_additional,
+                            flux_error_t *error);
+
+static int validate_constraint (json_t *constraint, flux_error_t *error);
+
+/* Like _validate_keys() in the Python bindings.
+ */
+static int validate_keys (json_t *o,
+                          const char **keys,
+                          bool keys_optional,
+                          bool allow_additional,
+                          flux_error_t *error)
+{
+    const char *key;
+    json_t *value;
+    int i;
+
+    if (!keys_optional) {
+        for (i = 0; keys[i] != NULL; i++) {
+            if (!json_object_get (o, keys[i])) {
+                errprintf (error, "Missing key (%s)", keys[i]);
+                return -1;
+            }
+        }
+    }
+    if (!allow_additional) {
+        json_object_foreach (o, key, value) {
+            for (i = 0; keys[i] != NULL; i++) {
+                if (!strcmp (key, keys[i]))
+                    break;
+            }
+            if (keys[i] == NULL) {
+                errprintf (error, "Extraneous key (%s)", key);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int validate_object (json_t *o,
+                            const char *name,
+                            const char **keys,
+                            bool keys_optional,
+                            bool allow_additional,
+                            flux_error_t *error)
+{
+    if (!json_is_object (o)) {
+        errprintf (error, "%s must be a mapping", name);
+        return -1;
+    }
+    return validate_keys (o, keys, keys_optional, allow_additional, error);
+}
+
+static int validate_range (json_t *count, flux_error_t *error)
+{
+    const char *keys[] = { "min", "max", "operator", "operand", NULL };
+    const char *operator;
+    json_t *value;
+    int i;
+
+    if (!json_object_get (count, "min")) {
+        errprintf (error, "min must be in range");
+        return -1;
+    }
+    if (json_object_size (count) > 1
+        && validate_keys (count, keys, false, false, error) < 0)
+        return -1;
+    for (i = 0; keys[i] != NULL; i++) {
+        if (!strcmp (keys[i], "operator")
+            || !(value = json_object_get (count, keys[i])))
+            continue;
+        if (!json_is_integer (value)) {
+            errprintf (error, "%s must be an int", keys[i]);
+            return -1;
+        }
+        if (json_integer_value (value) < 1) {
+            errprintf (error, "%s must be > 0", keys[i]);
+            return -1;
+        }
+    }
+    if ((value = json_object_get (count, "operator"))) {
+        if (!(operator = json_string_value (value))
+            || (strcmp (operator, "+")
+                && strcmp (operator, "*")
+                && strcmp (operator, "^"))) {
+            errprintf (error, "operator must be one of ['+', '*', '^']");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Check one resource vertex, then its children.
+ */
+static int validate_resource (json_t *res, flux_error_t *error)
+{
+    const char *strkeys[] = { "id", "unit", "label", NULL };
+    const char *type;
+    json_t *count;
+    json_t *value;
+    json_t *with;
+    size_t index;
+    int i;
+
+    if (!json_is_object (res)) {
+        errprintf (error, "resource must be a mapping");
+        return -1;
+    }
+    if (!(value = json_object_get (res, "type"))) {
+        errprintf (error, "type is a required key for resources");
+        return -1;
+    }
+    if (!(type = json_string_value (value))) {
+        errprintf (error, "type must be a string");
+        return -1;
+    }
+    if (!(count = json_object_get (res, "count"))) {
+        errprintf (error, "count is a required key for resources");
+        return -1;
+    }
+    if (json_is_object (count)) {
+        if (validate_range (count, error) < 0)
+            return -1;
+    }
+    else if (!json_is_integer (count)) {
+        errprintf (error, "count must be an int or mapping");
+        return -1;
+    }
+    else {
+        json_int_t n = json_integer_value (count);
+
+        /* node, slot, and core must have count > 0, but allow 0 for
+         * any other resource type.
+         */
+        if ((!strcmp (type, "node")
+             || !strcmp (type, "slot")
+             || !strcmp (type, "core"))
+            && n < 1) {
+            errprintf (error, "node or slot count must be > 0");
+            return -1;
+        }
+        if (n < 0) {
+            errprintf (error, "count must be >= 0");
+            return -1;
+        }
+    }
+    for (i = 0; strkeys[i] != NULL; i++) {
+        if ((value = json_object_get (res, strkeys[i]))
+            && !json_is_string (value)) {
+            errprintf (error, "%s must be a string", strkeys[i]);
+            return -1;
+        }
+    }
+    if ((value = json_object_get (res, "exclusive"))
+        && !json_is_boolean (value)
+        && !(json_is_integer (value)
+             && (json_integer_value (value) == 0
+                 || json_integer_value (value) == 1))) {
+        errprintf (error, "exclusive must be a boolean");
+        return -1;
+    }
+    if (!strcmp (type, "slot") && !json_object_get (res, "label")) {
+        errprintf (error, "slots must have labels");
+        return -1;
+    }
+    if ((with = json_object_get (res, "with"))) {
+        if (!json_is_array (with)) {
+            errprintf (error, "with must be a sequence");
+            return -1;
+        }
+        json_array_foreach (with, index, value) {
+            if (validate_resource (value, error) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static int validate_task (json_t *task, flux_error_t *error)
+{
+    const char *keys[] = { "command", "slot", "count", NULL };
+    json_t *command;
+    json_t *count;
+    json_t *value;
+    size_t index;
+
+    if (!json_is_object (task)) {
+        errprintf (error, "task must be a mapping");
+        return -1;
+    }
+    if (validate_keys (task, keys, false, true, error) < 0)
+        return -1;
+    count = json_object_get (task, "count");
+    if (!json_is_object (count)) {
+        errprintf (error, "count must be a mapping");
+        return -1;
+    }
+    if ((value = json_object_get (count, "total"))) {
+        if (!json_is_integer (value)) {
+            errprintf (error, "count total must be an int");
+            return -1;
+        }
+        if (json_integer_value (value) <= 0) {
+            errprintf (error, "count total must be > 0");
+            return -1;
+        }
+    }
+    if ((value = json_object_get (count, "per_slot"))) {
+        if (!json_is_integer (value)) {
+            errprintf (error, "count per_slot must be an int");
+            return -1;
+        }
+        if (json_integer_value (value) <= 0) {
+            errprintf (error, "count per_slot must be > 0");
+            return -1;
+        }
+    }
+    if (!json_is_string (json_object_get (task, "slot"))) {
+        errprintf (error, "slot must be a string");
+        return -1;
+    }
+    if ((value = json_object_get (task, "attributes"))
+        && !json_is_object (value)) {
+        errprintf (error, "attributes must be a mapping");
+        return -1;
+    }
+    command = json_object_get (task, "command");
+    if (json_is_array (command) && json_array_size (command) == 0) {
+        errprintf (error, "command array cannot have length of zero");
+        return -1;
+    }
+    if (!json_is_array (command)) {
+        errprintf (error, "command must be a list of strings");
+        return -1;
+    }
+    json_array_foreach (command, index, value) {
+        if (!json_is_string (value)) {
+            errprintf (error, "command must be a list of strings");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int validate_dependency (json_t *dep, flux_error_t *error)
+{
+    const char *keys[] = { "scheme", "value", NULL };
+
+    if (validate_object (dep, "dependency", keys, false, true, error) < 0)
+        return -1;
+    if (!json_is_string (json_object_get (dep, "scheme"))) {
+        errprintf (error, "dependency scheme must be a string");
+        return -1;
+    }
+    if (!json_is_string (json_object_get (dep, "value"))) {
+        errprintf (error, "dependency value must be a string");
+        return -1;
+    }
+    return 0;
+}
+
+/* Check one operator of an RFC 31 constraint object.
+ */
+static int validate_constraint_op (const char *op,
+                                   json_t *args,
+                                   flux_error_t *error)
+{
+    size_t index;
+    json_t *value;
+
+    if (!json_is_array (args)) {
+        errprintf (error, "argument to constraint %s must be a sequence", op);
+        return -1;
+    }
+    if (!strcmp (op, "and") || !strcmp (op, "or") || !strcmp (op, "not")) {
+        json_array_foreach (args, index, value) {
+            if (validate_constraint (value, error) < 0)
+                return -1;
+        }
+    }
+    else if (!strcmp (op, "properties")) {
+        json_array_foreach (args, index, value) {
+            const char *name = json_string_value (value);
+
+            if (!name || strpbrk (name, "&'\"`|()")) {
+                errprintf (error,
+                           "invalid character in property '%s'",
+                           name ? name : "");
+                return -1;
+            }
+        }
+    }
+    else if (!strcmp (op, "hostlist")) {
+        json_array_foreach (args, index, value) {
+            const char *s = json_string_value (value);
+            struct hostlist *hl;
+
+            if (!s || !(hl = hostlist_decode (s))) {
+                errprintf (error, "invalid hostlist '%s'", s ? s : "");
+                return -1;
+            }
+            hostlist_destroy (hl);
+        }
+    }
+    else if (!strcmp (op, "ranks")) {
+        json_array_foreach (args, index, value) {
+            const char *s = json_string_value (value);
+            struct idset *ids;
+
+            if (!s || !(ids = idset_decode (s))) {
+                errprintf (error, "invalid idset '%s'", s ? s : "");
+                return -1;
+            }
+            idset_destroy (ids);
+        }
+    }
+    else {
+        errprintf (error, "uknown constraint operator '%s'", op);
+        return -1;
+    }
+    return 0;
+}
+
+static int validate_constraint (json_t *constraint, flux_error_t *error)
+{
+    const char *op;
+    json_t *args;
+
+    if (!json_is_object (constraint)) {
+        errprintf (error, "constraints must be a mapping");
+        return -1;
+    }
+    json_object_foreach (constraint, op, args) {
+        if (validate_constraint_op (op, args, error) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int validate_system (json_t *system, flux_error_t *error)
+{
+    json_t *value;
+    json_t *dep;
+    size_t index;
+
+    if ((value = json_object_get (system, "dependencies"))) {
+        if (!json_is_array (value)) {
+            errprintf (error, "attributes.system.dependencies must be a list");
+            return -1;
+        }
+        json_array_foreach (value, index, dep) {
+            if (validate_dependency (dep, error) < 0)
+                return -1;
+        }
+    }
+    if ((value = json_object_get (system, "constraints"))
+        && validate_constraint (value, error) < 0)
+        return -1;
+    return 0;
+}
+
+/* Additional version 1 requirements.
+ */
+static int validate_v1 (json_t *attributes, flux_error_t *error)
+{
+    json_t *system;
+    json_t *duration;
+
+    if (!(system = json_object_get (attributes, "system"))) {
+        errprintf (error, "attributes.system is a required key");
+        return -1;
+    }
+    if (!json_is_object (system)) {
+        errprintf (error, "attributes.system must be a mapping");
+        return -1;
+    }
+    if (!(duration = json_object_get (system, "duration"))) {
+        errprintf (error, "attributes.system.duration is a required key");
+        return -1;
+    }
+    if (!json_is_number (duration)) {
+        errprintf (error, "attributes.system.duration must be a number");
+        return -1;
+    }
+    return 0;
+}
+
+int jobspec_validate (json_t *jobspec,
+                      int require_version,
+                      flux_error_t *error)
+{
+    const char *top_keys[] = { "resources", "tasks", "version",
+                               "attributes", NULL };
+    const char *attr_keys[] = { "system", "user", NULL };
+    json_t *resources;
+    json_t *tasks;
+    json_t *version;
+    json_t *attributes;
+    json_t *system;
+    json_t *value;
+    size_t index;
+    bool v1;
+
+    if (validate_object (jobspec, "jobspec", top_keys, false, false, error) < 0)
+        goto error;
+    resources = json_object_get (jobspec, "resources");
+    tasks = json_object_get (jobspec, "tasks");
+    version = json_object_get (jobspec, "version");
+    attributes = json_object_get (jobspec, "attributes");
+
+    v1 = (require_version == 1
+          || (json_is_integer (version) && json_integer_value (version) == 1));
+    if (v1 && !(json_is_integer (version) && json_integer_value (version) == 1)) {
+        errprintf (error, "version must be 1");
+        goto error;
+    }
+    if (!json_is_array (resources)) {
+        errprintf (error, "resources must be a sequence");
+        goto error;
+    }
+    if (!json_is_array (tasks)) {
+        errprintf (error, "tasks must be a sequence");
+        goto error;
+    }
+    if (!json_is_integer (version)) {
+        errprintf (error, "version must be an integer");
+        goto error;
+    }
+    if (!json_is_object (attributes)) {
+        errprintf (error, "attributes must be a mapping");
+        goto error;
+    }
+    if (json_integer_value (version) < 1) {
+        errprintf (error, "version must be >= 1");
+        goto error;
+    }
+    json_array_foreach (resources, index, value) {
+        if (validate_resource (value, error) < 0)
+            goto error;
+    }
+    json_array_foreach (tasks, index, value) {
+        if (validate_task (value, error) < 0)
+            goto error;
+    }
+    if (validate_keys (attributes, attr_keys, true, false, error) < 0)
+        goto error;
+    if ((system = json_object_get (attributes, "system"))
+        && json_is_object (system)
+        && validate_system (system, error) < 0)
+        goto error;
+    if (v1 && validate_v1 (attributes, error) < 0)
+        goto error;
+    return 0;
+error:
+    errno = EINVAL;
+    return -1;
+}
+
+int jobspec_validate_instance (json_t *jobspec, flux_error_t *error)
+{
+    json_t *command = NULL;
+    const char *arg0 = NULL;
+    const char *arg1 = NULL;
+
+    if (json_object_get (json_object_get (json_object_get (jobspec,
+                                                           "attributes"),
+                                          "system"),
+                         "batch"))
+        return 0;
+    (void)json_unpack (jobspec, "{s:[{s:o}]}", "tasks", "command", &command);
+    (void)json_unpack (command, "[s,s]", &arg0, &arg1);
+    if (arg0 && arg1) {
+        const char *base = strrchr (arg0, '/');
+
+        base = base ? base + 1 : arg0;
+        if (!strcmp (base, "flux")
+            && (!strcmp (arg1, "broker") || !strcmp (arg1, "start")))
+            return 0;
+    }
+    errprintf (error,
+               "Direct job submission is disabled for this instance."
+               " Please use the batch or alloc subcommands of flux-mini(1)");
+    errno = EINVAL;
+    return -1;
+}
+
+// vi:ts=4 sw=4 expandtab
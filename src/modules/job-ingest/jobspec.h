@@ -0,0 +1,34 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _JOB_INGEST_JOBSPEC_H
+#define _JOB_INGEST_JOBSPEC_H
+
+#include <jansson.h>
+#include <flux/core.h>
+
+/* Check jobspec against RFC 14 and, if version is 1 or 'require_version'
+ * is 1, the RFC 25 version 1 requirements.  Set 'require_version' to 0
+ * to accept any version.  This applies the same rules as the "jobspec"
+ * validator plugin.  On failure, return -1 with errno set to EINVAL
+ * and a message in 'error'.
+ */
+int jobspec_validate (json_t *jobspec,
+                      int require_version,
+                      flux_error_t *error);
+
+/* Check that jobspec describes a new Flux instance, like the
+ * "require-instance" validator plugin.
+ */
+int jobspec_validate_instance (json_t *jobspec, flux_error_t *error);
+
+#endif /* !_JOB_INGEST_JOBSPEC_H */
+
+// vi:ts=4 sw=4 expandtab
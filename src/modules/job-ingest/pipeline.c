@@ -21,15 +21,18 @@
 
 #include "util.h"
 #include "workcrew.h"
+#include "validate.h"
 #include "pipeline.h"
 
 struct pipeline {
     flux_t *h;
     struct workcrew *validate;
     struct workcrew *frobnicate;
+    struct validate *builtin;
     int process_count;
     flux_watcher_t *shutdown_timer;
     bool validator_bypass;
+    bool validator_external;
     bool frobnicate_enable;
 };
 
@@ -87,9 +90,9 @@ static bool validator_bypass (struct pipeline *pl, struct job *job)
     return false;
 }
 
-static flux_future_t *validate_job (struct pipeline *pl,
-                                    struct job *job,
-                                    flux_error_t *error)
+static flux_future_t *validate_external (struct pipeline *pl,
+                                         struct job *job,
+                                         flux_error_t *error)
 {
     json_t *input;
     flux_future_t *f;
@@ -107,6 +110,68 @@ error:
     return NULL;
 }
 
+static void validate_continuation (flux_future_t *f1, void *arg)
+{
+    struct pipeline *pl = arg;
+    struct job *job = flux_future_aux_get (f1, "job");
+    flux_future_t *f2;
+    const char *errmsg = NULL;
+    flux_error_t error;
+
+    if (flux_future_get (f1, NULL) < 0) {
+        errmsg = future_strerror (f1, errno);
+        goto error;
+    }
+    if (!(f2 = validate_external (pl, job, &error))) {
+        errmsg = error.text;
+        goto error;
+    }
+    if (flux_future_continue (f1, f2) < 0) {
+        flux_future_destroy (f2);
+        errmsg = "error continuing validator";
+        goto error;
+    }
+    goto done;
+error:
+    flux_future_continue_error (f1, errno, errmsg);
+done:
+    flux_future_destroy (f1);
+}
+
+/* Run built-in validator plugins in-process, then pass the job to the
+ * external validator if other plugins are configured.  If no future is
+ * needed, set 'fp' to NULL.
+ */
+static int validate_job (struct pipeline *pl,
+                         struct job *job,
+                         flux_future_t **fp,
+                         flux_error_t *error)
+{
+    flux_future_t *f;
+
+    if (validate_run (pl->builtin, job, &f, error) < 0)
+        return -1;
+    if (pl->validator_external) {
+        if (f) {
+            flux_future_t *f_comp;
+
+            if (flux_future_aux_set (f, "job", job, NULL) < 0
+                || !(f_comp = flux_future_and_then (f,
+                                                    validate_continuation,
+                                                    pl))) {
+                errprintf (error, "Error chaining validator");
+                flux_future_destroy (f);
+                return -1;
+            }
+            f = f_comp;
+        }
+        else if (!(f = validate_external (pl, job, error)))
+            return -1;
+    }
+    *fp = f;
+    return 0;
+}
+
 static flux_future_t *frobnicate_job (struct pipeline *pl,
                                       struct job *job,
                                       flux_error_t *error)
@@ -152,11 +217,11 @@ static void frobnicate_continuation (flux_future_t *f1, void *arg)
     if (!validator_bypass (pl, job)) {
         flux_future_t *f2;
 
-        if (!(f2 = validate_job (pl, job, &error))) {
+        if (validate_job (pl, job, &f2, &error) < 0) {
             errmsg = error.text;
             goto error;
         }
-        if (flux_future_continue (f1, f2) < 0) {
+        if (f2 && flux_future_continue (f1, f2) < 0) {
             flux_future_destroy (f2);
             errmsg = "error continuing validator";
             goto error;
@@ -194,14 +259,11 @@ int pipeline_process_job (struct pipeline *pl,
         *fp = f_comp;
     }
     else {
-        flux_future_t *f;
-
         if (validator_bypass (pl, job))
             *fp = NULL;
         else {
-            if (!(f = validate_job (pl, job, error)))
+            if (validate_job (pl, job, fp, error) < 0)
                 return -1;
-            *fp = f;
         }
     }
     return 0;
@@ -277,6 +339,8 @@ int pipeline_configure (struct pipeline *pl,
     char *validator_args = NULL;
     char *frobnicator_plugins = NULL;
     char *frobnicator_args = NULL;
+    char *external_plugins = NULL;
+    char *external_args = NULL;
     bool frobnicator_bypass = false;
     int rc = -1;
 
@@ -361,10 +425,23 @@ int pipeline_configure (struct pipeline *pl,
               validator_plugins,
               validator_args,
               pl->validator_bypass ? "disabled" : "enabled");
+    if (validate_configure (pl->builtin,
+                            validator_plugins,
+                            validator_args,
+                            &external_plugins,
+                            &external_args,
+                            error) < 0)
+        goto error;
+    pl->validator_external = external_plugins ? true : false;
+    flux_log (pl->h,
+              LOG_DEBUG,
+              "validator plugins in-process: %s, external: %s",
+              validate_plugins (pl->builtin),
+              external_plugins);
     if (workcrew_configure (pl->validate,
                             cmd_validator,
-                            validator_plugins,
-                            validator_args) < 0) {
+                            external_plugins,
+                            external_args) < 0) {
         errprintf (error,
                    "Error (re-)configuring validator workcrew: %s",
                    strerror (errno));
@@ -376,6 +453,8 @@ error:
     ERRNO_SAFE_WRAP (free, validator_args);
     ERRNO_SAFE_WRAP (free, frobnicator_plugins);
     ERRNO_SAFE_WRAP (free, frobnicator_args);
+    ERRNO_SAFE_WRAP (free, external_plugins);
+    ERRNO_SAFE_WRAP (free, external_args);
     return rc;
 }
 
@@ -385,11 +464,14 @@ json_t *pipeline_stats_get (struct pipeline *pl)
     if (pl) {
         json_t *fo = workcrew_stats_get (pl->frobnicate);
         json_t *vo = workcrew_stats_get (pl->validate);
-        o = json_pack ("{s:O s:O}",
+        json_t *bo = validate_stats_get (pl->builtin);
+        o = json_pack ("{s:O s:O s:O}",
                        "frobnicator", fo,
-                       "validator", vo);
+                       "validator", vo,
+                       "builtin", bo);
         json_decref (fo);
         json_decref (vo);
+        json_decref (bo);
     }
     return o ? o : json_null ();
 }
@@ -400,6 +482,7 @@ void pipeline_destroy (struct pipeline *pl)
         int saved_errno = errno;
         workcrew_destroy (pl->validate);
         workcrew_destroy (pl->frobnicate);
+        validate_destroy (pl->builtin);
         flux_watcher_destroy (pl->shutdown_timer);
         free (pl);
         errno = saved_errno;
@@ -423,6 +506,8 @@ struct pipeline *pipeline_create (flux_t *h)
     if (!(pl->validate = workcrew_create (pl->h))
         || workcrew_configure (pl->validate, cmd_validator, NULL, NULL) < 0)
         goto error;
+    if (!(pl->builtin = validate_create (pl->h)))
+        goto error;
     if (!(pl->frobnicate = workcrew_create (pl->h))
         || workcrew_configure (pl->frobnicate, cmd_frobnicator, NULL, NULL) < 0)
         goto error;
@@ -0,0 +1,211 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <jansson.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libjob/sign_none.h"
+
+#include "job.h"
+#include "decode.h"
+
+#define NJOBS 256
+
+struct test_ctx {
+    flux_reactor_t *r;
+    struct job *jobs[NJOBS];
+    int count;
+    int errors;
+    int bad_order;
+    int bad_errnum;
+};
+
+static flux_msg_t *pack_request (const char *J, int urgency)
+{
+    flux_msg_t *msg;
+    struct flux_msg_cred cred = {
+        .userid = getuid (),
+        .rolemask = FLUX_ROLE_OWNER,
+    };
+
+    if (!(msg = flux_request_encode ("job-ingest.submit", NULL))
+        || flux_msg_pack (msg,
+                          "{s:s s:i s:i}",
+                          "J", J,
+                          "urgency", urgency,
+                          "flags", 0) < 0
+        || flux_msg_set_cred (msg, cred) < 0)
+        BAIL_OUT ("could not create request");
+    return msg;
+}
+
+/* Every 7th job has an invalid urgency.
+ */
+static bool is_bad (int i)
+{
+    return i % 7 == 3;
+}
+
+static void decode_cb (struct job *job,
+                       int errnum,
+                       const char *errmsg,
+                       void *arg)
+{
+    struct test_ctx *ctx = arg;
+    int i = ctx->count++;
+
+    if (i >= NJOBS || job != ctx->jobs[i])
+        ctx->bad_order++;
+    else if (is_bad (i) ? errnum != EINVAL || !errmsg : errnum != 0)
+        ctx->bad_errnum++;
+    else if (errnum == 0 && !json_is_object (job->jobspec))
+        ctx->bad_errnum++;
+    if (errnum)
+        ctx->errors++;
+    job_destroy (job);
+    if (ctx->count == NJOBS)
+        flux_reactor_stop (ctx->r);
+}
+
+static void test_decode (flux_reactor_t *r, int nthreads, const char *J)
+{
+    struct test_ctx ctx;
+    struct decoder *d;
+    json_t *stats;
+    int count;
+    int pending = -1;
+    int i;
+
+    memset (&ctx, 0, sizeof (ctx));
+    ctx.r = r;
+
+    d = decoder_create (r, nthreads, decode_cb, &ctx);
+    ok (d != NULL,
+        "decoder_create nthreads=%d works", nthreads);
+    if (!d)
+        BAIL_OUT ("decoder_create failed");
+    ok (decoder_nthreads (d) == nthreads,
+        "decoder_nthreads returns %d", nthreads);
+
+    for (i = 0; i < NJOBS; i++) {
+        flux_msg_t *msg = pack_request (J, is_bad (i) ? 9999 : 16);
+        if (!(ctx.jobs[i] = job_create (msg)))
+            BAIL_OUT ("job_create failed");
+        flux_msg_decref (msg);
+    }
+    for (i = 0; i < NJOBS; i++) {
+        if (decoder_submit (d, ctx.jobs[i]) < 0)
+            break;
+    }
+    ok (i == NJOBS,
+        "decoder_submit works for %d jobs", NJOBS);
+    if (nthreads > 0)
+        ok (flux_reactor_run (r, 0) >= 0,
+            "reactor ran until all jobs were decoded");
+    ok (ctx.count == NJOBS,
+        "callback was called for each job");
+    ok (ctx.bad_order == 0,
+        "jobs were returned in the order they were submitted");
+    ok (ctx.bad_errnum == 0 && ctx.errors == (NJOBS + 3) / 7,
+        "decode errors were reported for the bad jobs only");
+
+    stats = decoder_stats_get (d);
+    ok (json_unpack (stats,
+                     "{s:i s:{s:i}}",
+                     "pending", &pending,
+                     "decode",
+                       "count", &count) == 0
+        && pending == 0
+        && count == NJOBS,
+        "decoder_stats_get reports %d decoded jobs", NJOBS);
+    json_decref (stats);
+
+    decoder_destroy (d);
+}
+
+/* Jobs still queued when the decoder is destroyed are handed back.
+ */
+static void test_destroy (flux_reactor_t *r, const char *J)
+{
+    struct test_ctx ctx;
+    struct decoder *d;
+    int i;
+
+    memset (&ctx, 0, sizeof (ctx));
+    ctx.r = r;
+
+    if (!(d = decoder_create (r, 2, decode_cb, &ctx)))
+        BAIL_OUT ("decoder_create failed");
+    for (i = 0; i < NJOBS; i++) {
+        flux_msg_t *msg = pack_request (J, is_bad (i) ? 9999 : 16);
+        if (!(ctx.jobs[i] = job_create (msg))
+            || decoder_submit (d, ctx.jobs[i]) < 0)
+            BAIL_OUT ("could not submit job");
+        flux_msg_decref (msg);
+    }
+    decoder_destroy (d);
+    ok (ctx.count == NJOBS && ctx.bad_order == 0,
+        "decoder_destroy hands back queued jobs in order");
+}
+
+static void test_inval (flux_reactor_t *r)
+{
+    struct job job;
+
+    errno = 0;
+    ok (decoder_create (NULL, 1, decode_cb, NULL) == NULL && errno == EINVAL,
+        "decoder_create r=NULL fails with EINVAL");
+    errno = 0;
+    ok (decoder_create (r, -1, decode_cb, NULL) == NULL && errno == EINVAL,
+        "decoder_create nthreads=-1 fails with EINVAL");
+    errno = 0;
+    ok (decoder_create (r, 1, NULL, NULL) == NULL && errno == EINVAL,
+        "decoder_create cb=NULL fails with EINVAL");
+    errno = 0;
+    ok (decoder_submit (NULL, &job) < 0 && errno == EINVAL,
+        "decoder_submit d=NULL fails with EINVAL");
+    lives_ok ({decoder_destroy (NULL);},
+              "decoder_destroy NULL doesn't crash");
+}
+
+int main (int argc, char *argv[])
+{
+    const char *jobspec = "{\"version\":1}";
+    flux_reactor_t *r;
+    char *J;
+
+    plan (NO_PLAN);
+
+    if (!(r = flux_reactor_create (0)))
+        BAIL_OUT ("flux_reactor_create failed");
+    if (!(J = sign_none_wrap (jobspec, strlen (jobspec), getuid ())))
+        BAIL_OUT ("failed to sign jobspec with none mech: %s",
+                  strerror (errno));
+
+    test_decode (r, 0, J);
+    test_decode (r, 1, J);
+    test_decode (r, 4, J);
+    test_destroy (r, J);
+    test_inval (r);
+
+    free (J);
+    flux_reactor_destroy (r);
+
+    done_testing ();
+}
+
+// vi:ts=4 sw=4 expandtab
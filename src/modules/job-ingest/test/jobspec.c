@@ -0,0 +1,266 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <jansson.h>
+#include <string.h>
+#include <errno.h>
+
+#include "src/common/libtap/tap.h"
+
+#include "jobspec.h"
+
+#define RES_SLOT \
+    "[{\"type\":\"slot\",\"count\":1,\"label\":\"task\"," \
+    "\"with\":[{\"type\":\"core\",\"count\":1}]}]"
+#define TASKS \
+    "[{\"command\":[\"hostname\"],\"slot\":\"task\"," \
+    "\"count\":{\"per_slot\":1}}]"
+#define ATTRS "{\"system\":{\"duration\":0}}"
+
+struct testcase {
+    const char *desc;
+    const char *jobspec;
+    int require_version;
+    const char *errmsg;     // NULL if jobspec is valid
+};
+
+static struct testcase tests[] = {
+    { "minimal jobspec",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      1, NULL },
+    { "exclusive node with slot and gpu",
+      "{\"version\":1,\"resources\":[{\"type\":\"node\",\"count\":2,"
+      "\"exclusive\":true,\"with\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"with\":[{\"type\":\"core\",\"count\":4},"
+      "{\"type\":\"gpu\",\"count\":0}]}]}],\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{\"duration\":3600.5,"
+      "\"environment\":{},\"shell\":{\"options\":{}},"
+      "\"dependencies\":[{\"scheme\":\"afterok\",\"value\":\"f1\"}],"
+      "\"constraints\":{\"and\":[{\"properties\":[\"foo\"]},"
+      "{\"not\":[{\"hostlist\":[\"host[0-3]\"]}]},"
+      "{\"ranks\":[\"0-3\"]}]}},\"user\":{\"a\":1}}}",
+      1, NULL },
+    { "count range",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"label\":\"task\","
+      "\"count\":{\"min\":1,\"max\":8,\"operator\":\"+\",\"operand\":1},"
+      "\"with\":[{\"type\":\"core\",\"count\":{\"min\":1}}]}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      1, NULL },
+    { "version 2 with any version",
+      "{\"version\":2,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":{}}",
+      0, NULL },
+    { "version 2 with version 1 required",
+      "{\"version\":2,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      1, "version must be 1" },
+    { "version 0 with any version",
+      "{\"version\":0,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      0, "version must be >= 1" },
+    { "real version",
+      "{\"version\":4.2,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      0, "version must be an integer" },
+    { "jobspec not an object",
+      "[]",
+      1, "jobspec must be a mapping" },
+    { "missing resources",
+      "{\"version\":1,\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      1, "Missing key (resources)" },
+    { "extra top level key",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS ",\"foo\":1}",
+      1, "Extraneous key (foo)" },
+    { "resources not an array",
+      "{\"version\":1,\"resources\":{},\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      1, "resources must be a sequence" },
+    { "attributes null",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":null}",
+      1, "attributes must be a mapping" },
+    { "unknown attributes section",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{\"duration\":0},\"foo\":1}}",
+      1, "Extraneous key (foo)" },
+    { "missing duration",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{}}}",
+      1, "attributes.system.duration is a required key" },
+    { "string duration",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{\"duration\":\"1h\"}}}",
+      1, "attributes.system.duration must be a number" },
+    { "slot without label",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"with\":[{\"type\":\"core\",\"count\":1}]}],\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      1, "slots must have labels" },
+    { "zero core count",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"with\":[{\"type\":\"core\",\"count\":0}]}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      1, "node or slot count must be > 0" },
+    { "string count",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":\"x\","
+      "\"label\":\"task\",\"with\":[{\"type\":\"core\",\"count\":1}]}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      1, "count must be an int or mapping" },
+    { "count range missing operator",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"label\":\"task\","
+      "\"count\":{\"min\":1,\"max\":8,\"operand\":1}}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      1, "Missing key (operator)" },
+    { "count range bad operator",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"label\":\"task\","
+      "\"count\":{\"min\":1,\"max\":8,\"operator\":\"-\",\"operand\":1}}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      1, "operator must be one of" },
+    { "exclusive not a boolean",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"with\":[{\"type\":\"node\",\"count\":1,"
+      "\"exclusive\":\"blah\"}]}],\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      1, "exclusive must be a boolean" },
+    { "with not an array",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"with\":{}}],\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      1, "with must be a sequence" },
+    { "empty command",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":[{\"command\":[],"
+      "\"slot\":\"task\",\"count\":{\"per_slot\":1}}],"
+      "\"attributes\":" ATTRS "}",
+      1, "command array cannot have length of zero" },
+    { "string command",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":[{\"command\":"
+      "\"hostname\",\"slot\":\"task\",\"count\":{\"per_slot\":1}}],"
+      "\"attributes\":" ATTRS "}",
+      1, "command must be a list of strings" },
+    { "task missing slot",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":[{\"command\":"
+      "[\"hostname\"],\"count\":{\"per_slot\":1}}],"
+      "\"attributes\":" ATTRS "}",
+      1, "Missing key (slot)" },
+    { "zero total task count",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":[{\"command\":"
+      "[\"hostname\"],\"slot\":\"task\",\"count\":{\"total\":0}}],"
+      "\"attributes\":" ATTRS "}",
+      1, "count total must be > 0" },
+    { "dependency value not a string",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{\"duration\":0,\"dependencies\":"
+      "[{\"scheme\":\"foo\",\"value\":1}]}}}",
+      1, "dependency value must be a string" },
+    { "constraints not an object",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{\"duration\":0,\"constraints\":"
+      "[\"foo\"]}}}",
+      1, "constraints must be a mapping" },
+    { "unknown constraint operator",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{\"duration\":0,\"constraints\":"
+      "{\"foo\":[]}}}}",
+      1, "constraint operator 'foo'" },
+    { "bad property name",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{\"duration\":0,\"constraints\":"
+      "{\"properties\":[\"a|b\"]}}}}",
+      1, "invalid character in property 'a|b'" },
+    { "bad idset",
+      "{\"version\":1,\"resources\":" RES_SLOT ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{\"duration\":0,\"constraints\":"
+      "{\"or\":[{\"ranks\":[\"x\"]}]}}}}",
+      1, "invalid idset 'x'" },
+    { NULL, NULL, 0, NULL },
+};
+
+static void test_validate (void)
+{
+    struct testcase *t;
+
+    for (t = &tests[0]; t->desc != NULL; t++) {
+        json_error_t jerror;
+        flux_error_t error;
+        json_t *o;
+        int rc;
+
+        if (!(o = json_loads (t->jobspec, 0, &jerror)))
+            BAIL_OUT ("%s: %s", t->desc, jerror.text);
+        error.text[0] = '\0';
+        errno = 0;
+        rc = jobspec_validate (o, t->require_version, &error);
+        if (t->errmsg == NULL) {
+            ok (rc == 0,
+                "%s is valid", t->desc);
+            if (rc < 0)
+                diag ("%s", error.text);
+        }
+        else {
+            ok (rc < 0 && errno == EINVAL && strstr (error.text, t->errmsg),
+                "%s fails with '%s'", t->desc, t->errmsg);
+            if (rc == 0 || !strstr (error.text, t->errmsg))
+                diag ("%s", rc == 0 ? "success" : error.text);
+        }
+        json_decref (o);
+    }
+}
+
+static int check_instance (const char *command, const char *system)
+{
+    flux_error_t error;
+    json_t *o;
+    int rc;
+
+    if (!(o = json_pack ("{s:[{s:o}] s:{s:o}}",
+                         "tasks",
+                           "command", json_loads (command, 0, NULL),
+                         "attributes",
+                           "system", json_loads (system, 0, NULL))))
+        BAIL_OUT ("error creating jobspec");
+    rc = jobspec_validate_instance (o, &error);
+    json_decref (o);
+    return rc;
+}
+
+static void test_instance (void)
+{
+    ok (check_instance ("[\"flux\",\"start\",\"sleep\",\"1\"]", "{}") == 0,
+        "require-instance accepts flux start");
+    ok (check_instance ("[\"/usr/bin/flux\",\"broker\"]", "{}") == 0,
+        "require-instance accepts /usr/bin/flux broker");
+    ok (check_instance ("[\"hostname\"]", "{\"batch\":{}}") == 0,
+        "require-instance accepts a batch job");
+    errno = 0;
+    ok (check_instance ("[\"hostname\"]", "{}") < 0 && errno == EINVAL,
+        "require-instance rejects hostname");
+    ok (check_instance ("[\"flux\"]", "{}") < 0,
+        "require-instance rejects flux with no arguments");
+    ok (check_instance ("[\"flux\",\"getattr\",\"rank\"]", "{}") < 0,
+        "require-instance rejects flux getattr");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_validate ();
+    test_instance ();
+
+    done_testing ();
+    return 0;
+}
+
+// vi:ts=4 sw=4 expandtab
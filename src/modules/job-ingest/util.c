@@ -53,4 +53,20 @@ char *util_join_arguments (json_t *o)
     return result;
 }
 
+json_t *util_tstat_pack (tstat_t *ts)
+{
+    json_t *o;
+
+    if (!(o = json_pack ("{s:i s:f s:f s:f s:f}",
+                         "count", tstat_count (ts),
+                         "min", tstat_min (ts),
+                         "max", tstat_max (ts),
+                         "mean", tstat_mean (ts),
+                         "stddev", tstat_stddev (ts)))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
 // vi:tabstop=4 shiftwidth=4 expandtab
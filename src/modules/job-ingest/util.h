@@ -13,8 +13,14 @@
 
 #include <jansson.h>
 
+#include "src/common/libutil/tstat.h"
+
 char *util_join_arguments (json_t *o);
 
+/* Return {"count":i "min":f "max":f "mean":f "stddev":f} for 'ts'.
+ */
+json_t *util_tstat_pack (tstat_t *ts);
+
 #endif /* !_JOB_INGEST_UTIL_H */
 
 // vi:ts=4 sw=4 expandtab
@@ -0,0 +1,397 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* validate.c - run built-in validator plugins in the job-ingest module
+ *
+ * The "jobspec", "require-instance", and "feasibility" plugins are
+ * implemented here so that jobs need not be passed to a flux job-validator
+ * worker unless other (e.g. site) plugins are configured.  The options
+ * of these plugins are accepted in the validator args:
+ *
+ *   --require-version=V      (jobspec) require jobspec version V (or any)
+ *   --feasibility-service=S  (feasibility) RPC service name
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <argz.h>
+#include <string.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/errprintf.h"
+#include "src/common/libutil/errno_safe.h"
+
+#include "jobspec.h"
+#include "validate.h"
+
+struct validate_config {
+    bool jobspec;
+    bool require_instance;
+    bool feasibility;
+    int require_version;        // 0 = any
+    char *feasibility_service;
+    char *plugins;              // built-in plugins, comma separated
+};
+
+struct validate {
+    flux_t *h;
+    struct validate_config conf;
+    int requests;
+    int errors;
+};
+
+static const char *default_plugins = "jobspec";
+static const char *default_feasibility_service = "sched.feasibility";
+
+static void config_clear (struct validate_config *conf)
+{
+    free (conf->feasibility_service);
+    free (conf->plugins);
+    memset (conf, 0, sizeof (*conf));
+}
+
+/* Append 'entry' to the argz vector unless it is already there.
+ */
+static int argz_add_unique (char **argz, size_t *argz_len, const char *entry)
+{
+    const char *s = NULL;
+    int e;
+
+    while ((s = argz_next (*argz, *argz_len, s))) {
+        if (!strcmp (s, entry))
+            return 0;
+    }
+    if ((e = argz_add (argz, argz_len, entry))) {
+        errno = e;
+        return -1;
+    }
+    return 0;
+}
+
+static char *argz_to_string (char *argz, size_t argz_len)
+{
+    char *s;
+
+    if (!argz)
+        return NULL;
+    argz_stringify (argz, argz_len, ',');
+    if (!(s = strdup (argz)))
+        return NULL;
+    return s;
+}
+
+static int parse_plugins (struct validate_config *conf,
+                          const char *plugins,
+                          char **ext_plugins,
+                          flux_error_t *error)
+{
+    char *argz = NULL;
+    size_t argz_len = 0;
+    char *builtin = NULL;
+    size_t builtin_len = 0;
+    char *ext = NULL;
+    size_t ext_len = 0;
+    const char *name = NULL;
+    int e;
+
+    if ((e = argz_create_sep (plugins ? plugins : default_plugins,
+                              ',',
+                              &argz,
+                              &argz_len))) {
+        errno = e;
+        goto nomem;
+    }
+    while ((name = argz_next (argz, argz_len, name))) {
+        if (!strcmp (name, "jobspec"))
+            conf->jobspec = true;
+        else if (!strcmp (name, "require-instance"))
+            conf->require_instance = true;
+        else if (!strcmp (name, "feasibility"))
+            conf->feasibility = true;
+        else {
+            if (argz_add_unique (&ext, &ext_len, name) < 0)
+                goto nomem;
+            continue;
+        }
+        if (argz_add_unique (&builtin, &builtin_len, name) < 0)
+            goto nomem;
+    }
+    if ((builtin && !(conf->plugins = argz_to_string (builtin, builtin_len)))
+        || (ext && !(*ext_plugins = argz_to_string (ext, ext_len))))
+        goto nomem;
+    free (argz);
+    free (builtin);
+    free (ext);
+    return 0;
+nomem:
+    errprintf (error, "error parsing validator plugins: %s", strerror (errno));
+    ERRNO_SAFE_WRAP (free, argz);
+    ERRNO_SAFE_WRAP (free, builtin);
+    ERRNO_SAFE_WRAP (free, ext);
+    return -1;
+}
+
+/* If 'arg' is --name=value or --name, return the value (the next argument
+ * in the latter case), otherwise NULL.
+ */
+static const char *option_value (const char *name,
+                                 const char *arg,
+                                 char *argz,
+                                 size_t argz_len,
+                                 const char **next)
+{
+    size_t len = strlen (name);
+
+    if (strncmp (arg, name, len) != 0)
+        return NULL;
+    if (arg[len] == '=')
+        return arg + len + 1;
+    if (arg[len] == '\0') {
+        const char *value = argz_next (argz, argz_len, arg);
+        if (value) {
+            *next = value;
+            return value;
+        }
+    }
+    return NULL;
+}
+
+static int parse_require_version (struct validate_config *conf,
+                                  const char *value,
+                                  flux_error_t *error)
+{
+    if (!strcmp (value, "any"))
+        conf->require_version = 0;
+    else if (!strcmp (value, "1"))
+        conf->require_version = 1;
+    else {
+        errprintf (error, "Invalid argument to --require-version: %s", value);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+static int parse_args (struct validate_config *conf,
+                       const char *args,
+                       char **ext_args,
+                       flux_error_t *error)
+{
+    char *argz = NULL;
+    size_t argz_len = 0;
+    char *ext = NULL;
+    size_t ext_len = 0;
+    const char *arg = NULL;
+    int e;
+
+    conf->require_version = 1;
+    if (args && (e = argz_create_sep (args, ',', &argz, &argz_len))) {
+        errno = e;
+        goto nomem;
+    }
+    while ((arg = argz_next (argz, argz_len, arg))) {
+        const char *next = arg;
+        const char *value;
+
+        if ((value = option_value ("--require-version",
+                                   arg,
+                                   argz,
+                                   argz_len,
+                                   &next))) {
+            if (parse_require_version (conf, value, error) < 0)
+                goto error;
+        }
+        else if ((value = option_value ("--feasibility-service",
+                                        arg,
+                                        argz,
+                                        argz_len,
+                                        &next))) {
+            free (conf->feasibility_service);
+            if (!(conf->feasibility_service = strdup (value)))
+                goto nomem;
+        }
+        else if ((e = argz_add (&ext, &ext_len, arg))) {
+            errno = e;
+            goto nomem;
+        }
+        arg = next;
+    }
+    if (ext && !(*ext_args = argz_to_string (ext, ext_len)))
+        goto nomem;
+    free (argz);
+    free (ext);
+    return 0;
+nomem:
+    errprintf (error, "error parsing validator args: %s", strerror (errno));
+error:
+    ERRNO_SAFE_WRAP (free, argz);
+    ERRNO_SAFE_WRAP (free, ext);
+    return -1;
+}
+
+int validate_configure (struct validate *v,
+                        const char *plugins,
+                        const char *args,
+                        char **ext_pluginsp,
+                        char **ext_argsp,
+                        flux_error_t *error)
+{
+    struct validate_config conf = { 0 };
+    char *ext_plugins = NULL;
+    char *ext_args = NULL;
+
+    if (parse_plugins (&conf, plugins, &ext_plugins, error) < 0
+        || parse_args (&conf, args, &ext_args, error) < 0)
+        goto error;
+    /* Unclaimed arguments are only meaningful to external plugins.
+     */
+    if (ext_args && !ext_plugins) {
+        errprintf (error, "unknown validator argument(s): %s", ext_args);
+        errno = EINVAL;
+        goto error;
+    }
+    config_clear (&v->conf);
+    v->conf = conf;
+    *ext_pluginsp = ext_plugins;
+    *ext_argsp = ext_args;
+    return 0;
+error:
+    config_clear (&conf);
+    ERRNO_SAFE_WRAP (free, ext_plugins);
+    ERRNO_SAFE_WRAP (free, ext_args);
+    return -1;
+}
+
+/* The feasibility plugin treats ENOSYS as success, in case the loaded
+ * scheduler does not support sched.feasibility.
+ */
+static void feasibility_error_cb (flux_future_t *f, void *arg)
+{
+    struct validate *v = arg;
+    flux_future_t *f2;
+
+    if (errno == ENOSYS) {
+        if (!(f2 = flux_future_create (NULL, NULL)))
+            goto error;
+        flux_future_set_flux (f2, v->h);
+        flux_future_fulfill (f2, NULL, NULL);
+        if (flux_future_continue (f, f2) < 0) {
+            flux_future_destroy (f2);
+            goto error;
+        }
+        goto done;
+    }
+    v->errors++;
+error:
+    flux_future_continue_error (f, errno, future_strerror (f, errno));
+done:
+    flux_future_destroy (f);
+}
+
+static flux_future_t *feasibility_check (struct validate *v,
+                                         struct job *job,
+                                         flux_error_t *error)
+{
+    const char *service = v->conf.feasibility_service;
+    json_t *input;
+    flux_future_t *f = NULL;
+    flux_future_t *f_comp;
+
+    if (!(input = job_json_object (job, error)))
+        return NULL;
+    if (!(f = flux_rpc_pack (v->h,
+                             service ? service : default_feasibility_service,
+                             FLUX_NODEID_ANY,
+                             0,
+                             "O",
+                             input))
+        || !(f_comp = flux_future_or_then (f, feasibility_error_cb, v))) {
+        errprintf (error, "Error sending feasibility request");
+        goto error;
+    }
+    json_decref (input);
+    return f_comp;
+error:
+    ERRNO_SAFE_WRAP (json_decref, input);
+    flux_future_destroy (f);
+    return NULL;
+}
+
+int validate_run (struct validate *v,
+                  struct job *job,
+                  flux_future_t **fp,
+                  flux_error_t *error)
+{
+    flux_future_t *f = NULL;
+
+    v->requests++;
+    if ((v->conf.jobspec
+         && jobspec_validate (job->jobspec,
+                              v->conf.require_version,
+                              error) < 0)
+        || (v->conf.require_instance
+            && jobspec_validate_instance (job->jobspec, error) < 0)) {
+        v->errors++;
+        return -1;
+    }
+    if (v->conf.feasibility) {
+        if (!(f = feasibility_check (v, job, error)))
+            return -1;
+    }
+    *fp = f;
+    return 0;
+}
+
+const char *validate_plugins (struct validate *v)
+{
+    return v->conf.plugins;
+}
+
+json_t *validate_stats_get (struct validate *v)
+{
+    json_t *o;
+
+    if (!(o = json_pack ("{s:s s:i s:i}",
+                         "plugins", v->conf.plugins ? v->conf.plugins : "",
+                         "requests", v->requests,
+                         "errors", v->errors)))
+        return json_null ();
+    return o;
+}
+
+void validate_destroy (struct validate *v)
+{
+    if (v) {
+        int saved_errno = errno;
+        config_clear (&v->conf);
+        free (v);
+        errno = saved_errno;
+    }
+}
+
+struct validate *validate_create (flux_t *h)
+{
+    struct validate *v;
+    char *ext_plugins = NULL;
+    char *ext_args = NULL;
+
+    if (!(v = calloc (1, sizeof (*v))))
+        return NULL;
+    v->h = h;
+    if (validate_configure (v, NULL, NULL, &ext_plugins, &ext_args, NULL) < 0) {
+        validate_destroy (v);
+        return NULL;
+    }
+    return v;
+}
+
+// vi:ts=4 sw=4 expandtab
@@ -0,0 +1,55 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _JOB_INGEST_VALIDATE_H
+#define _JOB_INGEST_VALIDATE_H
+
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "job.h"
+
+/* Create with the default configuration (the jobspec plugin only).
+ */
+struct validate *validate_create (flux_t *h);
+void validate_destroy (struct validate *v);
+
+/* Configure with the validator 'plugins' and 'args' (comma separated,
+ * as passed to flux job-validator).  Built-in plugins and their
+ * arguments are claimed;  the remaining plugins and arguments are
+ * returned in 'ext_plugins' and 'ext_args' (NULL if none), to be run
+ * by the external validator.  The caller must free them.
+ */
+int validate_configure (struct validate *v,
+                        const char *plugins,
+                        const char *args,
+                        char **ext_plugins,
+                        char **ext_args,
+                        flux_error_t *error);
+
+/* Run the built-in plugins on 'job'.  Jobspec checks are made
+ * immediately.  If an RPC is needed, a future is returned in 'fp',
+ * otherwise 'fp' is set to NULL.  The future is fulfilled with an
+ * error if the job is rejected.
+ */
+int validate_run (struct validate *v,
+                  struct job *job,
+                  flux_future_t **fp,
+                  flux_error_t *error);
+
+/* Return the list of built-in plugins that are configured, or NULL.
+ */
+const char *validate_plugins (struct validate *v);
+
+json_t *validate_stats_get (struct validate *v);
+
+#endif /* !_JOB_INGEST_VALIDATE_H */
+
+// vi:ts=4 sw=4 expandtab
@@ -105,6 +105,7 @@ static void purge_cb (flux_t *h,
             job_stats_purge (ctx->jsctx->statsctx, job);
             if (job->list_handle)
                 zlistx_delete (ctx->jsctx->inactive, job->list_handle);
+            job_index_remove (ctx->jsctx->jindex, job);
             zhashx_delete (ctx->jsctx->index, &id);
             count++;
         }
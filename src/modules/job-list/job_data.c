@@ -25,6 +25,43 @@
 
 #include "job_data.h"
 
+#define NUMCMP(a,b) ((a)==(b)?0:((a)<(b)?-1:1))
+
+/* Compare items for sorting in list, priority first (higher priority
+ * before lower priority), job id second N.B. zlistx_comparator_fn signature
+ */
+int job_urgency_cmp (const void *a1, const void *a2)
+{
+    const struct job *j1 = a1;
+    const struct job *j2 = a2;
+    int rc;
+
+    if ((rc = (-1)*NUMCMP (j1->priority, j2->priority)) == 0)
+        rc = NUMCMP (j1->id, j2->id);
+    return rc;
+}
+
+/* Compare items for sorting in list by timestamp (note that sorting
+ * is in reverse order, most recently (i.e. bigger timestamp)
+ * running/completed comes first).  N.B. zlistx_comparator_fn
+ * signature
+ */
+int job_running_cmp (const void *a1, const void *a2)
+{
+    const struct job *j1 = a1;
+    const struct job *j2 = a2;
+
+    return NUMCMP (j2->t_run, j1->t_run);
+}
+
+int job_inactive_cmp (const void *a1, const void *a2)
+{
+    const struct job *j1 = a1;
+    const struct job *j2 = a2;
+
+    return NUMCMP (j2->t_inactive, j1->t_inactive);
+}
+
 void job_destroy (void *data)
 {
     struct job *job = data;
@@ -74,6 +111,7 @@ struct job *job_create (flux_t *h, flux_jobid_t id)
     job->states_mask = FLUX_JOB_STATE_NEW;
     job->states_events_mask = FLUX_JOB_STATE_NEW;
     job->eventlog_seq = -1;
+    job->index_list = -1;
     return job;
 }
 
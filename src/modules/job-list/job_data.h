@@ -16,6 +16,9 @@
 
 #include "src/common/libutil/grudgeset.h"
 #include "src/common/libczmqcontainers/czmq_containers.h"
+#include "ccan/list/list.h"
+
+#include "job_index.h"
 
 /* timestamp of when we enter the state
  *
@@ -84,6 +87,11 @@ struct job {
     unsigned int states_events_mask;
     void *list_handle;
 
+    /* secondary index membership, see job_index.h */
+    struct list_node index_node[JOB_INDEX_KEY_COUNT];
+    struct job_index_bucket *index_bucket[JOB_INDEX_KEY_COUNT];
+    int index_list;
+
     int eventlog_seq;           /* last event seq read */
     int submit_version;         /* version number in submit context */
 };
@@ -92,6 +100,13 @@ void job_destroy (void *data);
 
 struct job *job_create (flux_t *h, flux_jobid_t id);
 
+/* Comparators used to sort the pending, running, and inactive lists.
+ * N.B. zlistx_comparator_fn signature
+ */
+int job_urgency_cmp (const void *a1, const void *a2);
+int job_running_cmp (const void *a1, const void *a2);
+int job_inactive_cmp (const void *a1, const void *a2);
+
 /* Parse and internally cache jobspec.  Set values for:
  * - job name
  * - ntasks
@@ -0,0 +1,348 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* job_index.c - secondary indexes for job queries */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <flux/core.h>
+
+#include "src/common/libczmqcontainers/czmq_containers.h"
+#include "ccan/list/list.h"
+
+#include "job_data.h"
+#include "job_index.h"
+
+struct job_index_bucket {
+    enum job_index_key key;
+    struct list_head lists[JOB_INDEX_LIST_COUNT];
+    int count[JOB_INDEX_LIST_COUNT];
+    char value[];
+};
+
+struct job_index {
+    zhashx_t *buckets[JOB_INDEX_KEY_COUNT];
+};
+
+typedef int (*job_cmp_f)(const void *a1, const void *a2);
+
+static const job_cmp_f list_cmp[JOB_INDEX_LIST_COUNT] = {
+    job_urgency_cmp,
+    job_running_cmp,
+    job_inactive_cmp,
+};
+
+static struct job *node_to_job (struct list_node *n, enum job_index_key key)
+{
+    return (struct job *)((char *)n
+                          - offsetof (struct job, index_node)
+                          - key * sizeof (struct list_node));
+}
+
+static int state_to_list (flux_job_state_t state)
+{
+    switch (state) {
+        case FLUX_JOB_STATE_DEPEND:
+        case FLUX_JOB_STATE_PRIORITY:
+        case FLUX_JOB_STATE_SCHED:
+            return JOB_INDEX_PENDING;
+        case FLUX_JOB_STATE_RUN:
+        case FLUX_JOB_STATE_CLEANUP:
+            return JOB_INDEX_RUNNING;
+        case FLUX_JOB_STATE_INACTIVE:
+            return JOB_INDEX_INACTIVE;
+        default:
+            return -1;
+    }
+}
+
+/* Return the bucket value of 'job' for 'key', or NULL if the job
+ * should not be indexed under 'key'.  'buf' is used for integer keys.
+ */
+static const char *job_value (struct job *job,
+                              enum job_index_key key,
+                              int list,
+                              char *buf,
+                              size_t size)
+{
+    switch (key) {
+        case JOB_INDEX_ALL:
+            return "";
+        case JOB_INDEX_USERID:
+            snprintf (buf, size, "%u", job->userid);
+            return buf;
+        case JOB_INDEX_STATE:
+            snprintf (buf, size, "%u", (unsigned int)job->state);
+            return buf;
+        case JOB_INDEX_RESULT:
+            if (list != JOB_INDEX_INACTIVE)
+                return NULL;
+            snprintf (buf, size, "%u", (unsigned int)job->result);
+            return buf;
+        case JOB_INDEX_NAME:
+            return job->name;
+        case JOB_INDEX_QUEUE:
+            return job->queue;
+        default:
+            return NULL;
+    }
+}
+
+static void bucket_destroy (void **item)
+{
+    if (item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+static struct job_index_bucket *bucket_get (struct job_index *jindex,
+                                            enum job_index_key key,
+                                            const char *value)
+{
+    struct job_index_bucket *bucket;
+    int i;
+
+    if ((bucket = zhashx_lookup (jindex->buckets[key], value)))
+        return bucket;
+    if (!(bucket = calloc (1, sizeof (*bucket) + strlen (value) + 1)))
+        return NULL;
+    bucket->key = key;
+    for (i = 0; i < JOB_INDEX_LIST_COUNT; i++)
+        list_head_init (&bucket->lists[i]);
+    strcpy (bucket->value, value);
+    if (zhashx_insert (jindex->buckets[key], bucket->value, bucket) < 0) {
+        free (bucket);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return bucket;
+}
+
+/* Insert job into its sorted position on the bucket list.  Like
+ * zlistx_insert(), search from whichever end the job is likely to be
+ * closest to: pending jobs by priority, otherwise from the head since
+ * the most recent running/inactive jobs sort first.
+ */
+static void bucket_insert (struct job_index_bucket *bucket,
+                           int list,
+                           struct job *job)
+{
+    struct list_head *h = &bucket->lists[list];
+    struct list_node *n = &job->index_node[bucket->key];
+    struct list_node *p;
+    job_cmp_f cmp = list_cmp[list];
+
+    if (list != JOB_INDEX_PENDING
+        || job->priority > (FLUX_JOB_PRIORITY_MAX / 2)) {
+        for (p = h->n.next; p != &h->n; p = p->next) {
+            if (cmp (job, node_to_job (p, bucket->key)) < 0)
+                break;
+        }
+        list_add_before (h, p, n);
+    }
+    else {
+        for (p = h->n.prev; p != &h->n; p = p->prev) {
+            if (cmp (node_to_job (p, bucket->key), job) <= 0)
+                break;
+        }
+        list_add_after (h, p, n);
+    }
+}
+
+static int job_index_add (struct job_index *jindex,
+                          struct job *job,
+                          bool sorted)
+{
+    char buf[32];
+    int list;
+    int key;
+
+    if ((list = state_to_list (job->state)) < 0)
+        return 0;
+    for (key = 0; key < JOB_INDEX_KEY_COUNT; key++) {
+        struct job_index_bucket *bucket;
+        const char *value;
+
+        if (!(value = job_value (job, key, list, buf, sizeof (buf))))
+            continue;
+        if (!(bucket = bucket_get (jindex, key, value)))
+            goto error;
+        if (sorted)
+            list_add_tail (&bucket->lists[list], &job->index_node[key]);
+        else
+            bucket_insert (bucket, list, job);
+        bucket->count[list]++;
+        job->index_bucket[key] = bucket;
+        job->index_list = list;
+    }
+    return 0;
+error:
+    job_index_remove (jindex, job);
+    return -1;
+}
+
+void job_index_remove (struct job_index *jindex, struct job *job)
+{
+    int key;
+
+    if (!jindex || !job || job->index_list < 0)
+        return;
+    for (key = 0; key < JOB_INDEX_KEY_COUNT; key++) {
+        struct job_index_bucket *bucket = job->index_bucket[key];
+        int list = job->index_list;
+
+        if (!bucket)
+            continue;
+        list_del_from (&bucket->lists[list], &job->index_node[key]);
+        job->index_bucket[key] = NULL;
+        if (--bucket->count[list] == 0
+            && bucket->count[JOB_INDEX_PENDING] == 0
+            && bucket->count[JOB_INDEX_RUNNING] == 0
+            && bucket->count[JOB_INDEX_INACTIVE] == 0)
+            zhashx_delete (jindex->buckets[key], bucket->value);
+    }
+    job->index_list = -1;
+}
+
+int job_index_update (struct job_index *jindex, struct job *job)
+{
+    if (!jindex || !job) {
+        errno = EINVAL;
+        return -1;
+    }
+    job_index_remove (jindex, job);
+    return job_index_add (jindex, job, false);
+}
+
+int job_index_append (struct job_index *jindex, struct job *job)
+{
+    if (!jindex || !job) {
+        errno = EINVAL;
+        return -1;
+    }
+    job_index_remove (jindex, job);
+    return job_index_add (jindex, job, true);
+}
+
+struct job_index_bucket *job_index_lookup (struct job_index *jindex,
+                                           enum job_index_key key,
+                                           const char *value)
+{
+    if (!jindex || key < 0 || key >= JOB_INDEX_KEY_COUNT)
+        return NULL;
+    if (key == JOB_INDEX_ALL)
+        value = "";
+    if (!value)
+        return NULL;
+    return zhashx_lookup (jindex->buckets[key], value);
+}
+
+struct job_index_bucket *job_index_lookup_int (struct job_index *jindex,
+                                               enum job_index_key key,
+                                               uint32_t value)
+{
+    char buf[32];
+
+    snprintf (buf, sizeof (buf), "%u", value);
+    return job_index_lookup (jindex, key, buf);
+}
+
+int job_index_count (struct job_index_bucket *bucket,
+                     enum job_index_list list)
+{
+    if (!bucket || list < 0 || list >= JOB_INDEX_LIST_COUNT)
+        return 0;
+    return bucket->count[list];
+}
+
+struct job *job_index_first (struct job_index_bucket *bucket,
+                             enum job_index_list list)
+{
+    struct list_head *h;
+
+    if (!bucket || list < 0 || list >= JOB_INDEX_LIST_COUNT)
+        return NULL;
+    h = &bucket->lists[list];
+    if (h->n.next == &h->n)
+        return NULL;
+    return node_to_job (h->n.next, bucket->key);
+}
+
+struct job *job_index_next (struct job_index_bucket *bucket,
+                            enum job_index_list list,
+                            struct job *job)
+{
+    struct list_head *h;
+    struct list_node *n;
+
+    if (!job_index_contains (bucket, list, job))
+        return NULL;
+    h = &bucket->lists[list];
+    n = job->index_node[bucket->key].next;
+    if (n == &h->n)
+        return NULL;
+    return node_to_job (n, bucket->key);
+}
+
+bool job_index_contains (struct job_index_bucket *bucket,
+                         enum job_index_list list,
+                         struct job *job)
+{
+    if (!bucket || !job)
+        return false;
+    return (job->index_bucket[bucket->key] == bucket
+            && job->index_list == list);
+}
+
+int job_index_list (struct job *job)
+{
+    return job ? job->index_list : -1;
+}
+
+void job_index_destroy (struct job_index *jindex)
+{
+    if (jindex) {
+        int saved_errno = errno;
+        int key;
+        for (key = 0; key < JOB_INDEX_KEY_COUNT; key++)
+            zhashx_destroy (&jindex->buckets[key]);
+        free (jindex);
+        errno = saved_errno;
+    }
+}
+
+struct job_index *job_index_create (void)
+{
+    struct job_index *jindex;
+    int key;
+
+    if (!(jindex = calloc (1, sizeof (*jindex))))
+        return NULL;
+    for (key = 0; key < JOB_INDEX_KEY_COUNT; key++) {
+        if (!(jindex->buckets[key] = zhashx_new ()))
+            goto nomem;
+        zhashx_set_destructor (jindex->buckets[key], bucket_destroy);
+    }
+    return jindex;
+nomem:
+    job_index_destroy (jindex);
+    errno = ENOMEM;
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,106 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_JOB_LIST_JOB_INDEX_H
+#define _FLUX_JOB_LIST_JOB_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Secondary indexes for job queries.
+ *
+ * For each key below, jobs are grouped into buckets by value (e.g. one
+ * bucket per userid).  Each bucket holds a pending, running, and inactive
+ * list, sorted the same way as the corresponding job_state_ctx lists.  A
+ * query can then walk the smallest bucket list that satisfies one of its
+ * filters instead of every job.  The JOB_INDEX_ALL key has a single bucket
+ * containing every job that has left the NEW state.
+ *
+ * Nodes are embedded in struct job, so iteration can resume from any job
+ * (see job_index_next()), which is what makes cursor based paging cheap.
+ */
+
+enum job_index_key {
+    JOB_INDEX_ALL = 0,
+    JOB_INDEX_USERID = 1,
+    JOB_INDEX_STATE = 2,
+    JOB_INDEX_RESULT = 3,   /* inactive jobs only */
+    JOB_INDEX_NAME = 4,
+    JOB_INDEX_QUEUE = 5,
+    JOB_INDEX_KEY_COUNT = 6,
+};
+
+enum job_index_list {
+    JOB_INDEX_PENDING = 0,
+    JOB_INDEX_RUNNING = 1,
+    JOB_INDEX_INACTIVE = 2,
+    JOB_INDEX_LIST_COUNT = 3,
+};
+
+struct job;
+struct job_index;
+struct job_index_bucket;
+
+struct job_index *job_index_create (void);
+void job_index_destroy (struct job_index *jindex);
+
+/* Add a job to the indexes, or move it after a change to its state,
+ * priority, or other indexed attribute.  Jobs in the NEW state are not
+ * indexed.
+ */
+int job_index_update (struct job_index *jindex, struct job *job);
+
+/* Add a job to the tail of its bucket lists without searching for its
+ * sorted position.  Used to bulk load jobs that are already sorted.
+ */
+int job_index_append (struct job_index *jindex, struct job *job);
+
+void job_index_remove (struct job_index *jindex, struct job *job);
+
+/* Look up the bucket for 'key' and 'value' (NULL for JOB_INDEX_ALL).
+ * Integer keys are looked up with job_index_lookup_int().  Returns NULL
+ * if no indexed job has that value.
+ */
+struct job_index_bucket *job_index_lookup (struct job_index *jindex,
+                                           enum job_index_key key,
+                                           const char *value);
+struct job_index_bucket *job_index_lookup_int (struct job_index *jindex,
+                                               enum job_index_key key,
+                                               uint32_t value);
+
+/* Return the number of jobs on 'list' of 'bucket' (0 if bucket is NULL).
+ */
+int job_index_count (struct job_index_bucket *bucket,
+                     enum job_index_list list);
+
+/* Iterate over 'list' of 'bucket' in sorted order.  job_index_next()
+ * returns the job following 'job', which must be a member of the list.
+ */
+struct job *job_index_first (struct job_index_bucket *bucket,
+                             enum job_index_list list);
+struct job *job_index_next (struct job_index_bucket *bucket,
+                            enum job_index_list list,
+                            struct job *job);
+
+/* Return true if 'job' is currently a member of 'list' of 'bucket'.
+ */
+bool job_index_contains (struct job_index_bucket *bucket,
+                         enum job_index_list list,
+                         struct job *job);
+
+/* Return the list a job is indexed on, or -1 if it is not indexed.
+ */
+int job_index_list (struct job *job);
+
+#endif /* ! _FLUX_JOB_LIST_JOB_INDEX_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
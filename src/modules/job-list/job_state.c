@@ -33,8 +33,6 @@
 #include "idsync.h"
 #include "job_util.h"
 
-#define NUMCMP(a,b) ((a)==(b)?0:((a)<(b)?-1:1))
-
 /* REVERT - flag indicates state transition is a revert, avoid certain
  * checks, clear certain bitmasks on revert
  *
@@ -81,41 +79,6 @@ static void process_next_state (struct job_state_ctx *jsctx, struct job *job);
 static int journal_process_events (struct job_state_ctx *jsctx,
                                    const flux_msg_t *msg);
 
-/* Compare items for sorting in list, priority first (higher priority
- * before lower priority), job id second N.B. zlistx_comparator_fn signature
- */
-static int job_urgency_cmp (const void *a1, const void *a2)
-{
-    const struct job *j1 = a1;
-    const struct job *j2 = a2;
-    int rc;
-
-    if ((rc = (-1)*NUMCMP (j1->priority, j2->priority)) == 0)
-        rc = NUMCMP (j1->id, j2->id);
-    return rc;
-}
-
-/* Compare items for sorting in list by timestamp (note that sorting
- * is in reverse order, most recently (i.e. bigger timestamp)
- * running/completed comes first).  N.B. zlistx_comparator_fn
- * signature
- */
-static int job_running_cmp (const void *a1, const void *a2)
-{
-    const struct job *j1 = a1;
-    const struct job *j2 = a2;
-
-    return NUMCMP (j2->t_run, j1->t_run);
-}
-
-static int job_inactive_cmp (const void *a1, const void *a2)
-{
-    const struct job *j1 = a1;
-    const struct job *j2 = a2;
-
-    return NUMCMP (j2->t_inactive, j1->t_inactive);
-}
-
 static void job_destroy_wrapper (void **data)
 {
     struct job **job = (struct job **)data;
@@ -267,6 +230,11 @@ static void update_job_state_and_list (struct job_state_ctx *jsctx,
         zlistx_reorder (jsctx->pending,
                         job->list_handle,
                         search_direction (job));
+
+    if (job_index_update (jsctx->jindex, job) < 0)
+        flux_log_error (jsctx->h,
+                        "error indexing job on state transition to %s",
+                        flux_job_statetostr (newstate, "L"));
 }
 
 static void state_depend_lookup_continuation (flux_future_t *f, void *arg)
@@ -810,6 +778,22 @@ static void sort_job_list (zlistx_t *list)
     }
 }
 
+/* Add jobs on an already sorted list to the secondary indexes.  Appending
+ * in list order avoids a sorted insert per job.
+ */
+static int index_job_list (struct job_state_ctx *jsctx, zlistx_t *list)
+{
+    struct job *job;
+
+    job = zlistx_first (list);
+    while (job) {
+        if (job_index_append (jsctx->jindex, job) < 0)
+            return -1;
+        job = zlistx_next (list);
+    }
+    return 0;
+}
+
 /* Read jobs present in the KVS at startup. */
 int job_state_init_from_kvs (struct job_state_ctx *jsctx)
 {
@@ -824,6 +808,11 @@ int job_state_init_from_kvs (struct job_state_ctx *jsctx)
 
     sort_job_list (jsctx->running);
     sort_job_list (jsctx->inactive);
+
+    if (index_job_list (jsctx, jsctx->pending) < 0
+        || index_job_list (jsctx, jsctx->running) < 0
+        || index_job_list (jsctx, jsctx->inactive) < 0)
+        return -1;
     return 0;
 }
 
@@ -979,10 +968,13 @@ static int journal_priority_event (struct job_state_ctx *jsctx,
         return -1;
 
     if (job->state & FLUX_JOB_STATE_PENDING
-        && job->priority != orig_priority)
+        && job->priority != orig_priority) {
         zlistx_reorder (jsctx->pending,
                         job->list_handle,
                         search_direction (job));
+        if (job_index_update (jsctx->jindex, job) < 0)
+            flux_log_error (jsctx->h, "error indexing job on priority change");
+    }
 
     return job_transition_state (jsctx,
                                  job,
@@ -1515,6 +1507,9 @@ struct job_state_ctx *job_state_create (struct idsync_ctx *isctx)
     if (!(jsctx->processing = zlistx_new ()))
         goto error;
 
+    if (!(jsctx->jindex = job_index_create ()))
+        goto error;
+
     if (!(jsctx->futures = zlistx_new ()))
         goto error;
 
@@ -1558,6 +1553,7 @@ void job_state_destroy (void *data)
         zlistx_destroy (&jsctx->inactive);
         zlistx_destroy (&jsctx->running);
         zlistx_destroy (&jsctx->pending);
+        job_index_destroy (jsctx->jindex);
         zhashx_destroy (&jsctx->index);
         job_stats_ctx_destroy (jsctx->statsctx);
         flux_msglist_destroy (jsctx->backlog);
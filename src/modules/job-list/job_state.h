@@ -18,6 +18,7 @@
 
 #include "idsync.h"
 #include "stats.h"
+#include "job_index.h"
 
 /* To handle the common case of user queries on job state, we will
  * store jobs in three different lists.
@@ -35,6 +36,9 @@
  * There is also an additional list `processing` that stores jobs that
  * cannot yet be stored on one of the lists above.
  *
+ * The same lists are also maintained per userid, state, result, name,
+ * and queue in `jindex`, so that queries can avoid scanning all jobs.
+ *
  * The list `futures` is used to store in process futures.
  */
 
@@ -48,6 +52,7 @@ struct job_state_ctx {
     zlistx_t *inactive;
     zlistx_t *processing;
     zlistx_t *futures;
+    struct job_index *jindex;
 
     /*  Job statistics: */
     struct job_stats_ctx *statsctx;
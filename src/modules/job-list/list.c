@@ -26,6 +26,7 @@
 #include "list.h"
 #include "job_util.h"
 #include "job_data.h"
+#include "job_index.h"
 
 json_t *get_job_by_id (struct job_state_ctx *jsctx,
                        job_list_error_t *errp,
@@ -56,15 +57,86 @@ bool job_filter (struct job *job,
     return true;
 }
 
-/* Put jobs from list onto jobs array, breaking if max_entries has
- * been reached. Returns 1 if jobs array is full, 0 if continue, -1
- * one error with errno set:
+/* Return true if exactly one bit is set in 'mask'.
+ */
+static bool single_bit (int mask)
+{
+    return mask && !(mask & (mask - 1));
+}
+
+/* Choose the smallest index bucket for 'list' that covers one of the
+ * query filters.  Every job in the chosen bucket still has to pass
+ * job_filter(), the bucket only narrows the candidates.  Returns NULL
+ * if no job on 'list' can match.
+ */
+static struct job_index_bucket *plan_query (struct job_state_ctx *jsctx,
+                                            enum job_index_list list,
+                                            int list_states,
+                                            uint32_t userid,
+                                            int states,
+                                            int results,
+                                            const char *name,
+                                            const char *queue)
+{
+    struct job_index_bucket *best;
+    struct job_index_bucket *b[4];
+    int n = 0;
+    int i;
+
+    if (!(best = job_index_lookup (jsctx->jindex, JOB_INDEX_ALL, NULL)))
+        return NULL;
+    if (userid != FLUX_USERID_UNKNOWN) {
+        if (!(b[n++] = job_index_lookup_int (jsctx->jindex,
+                                             JOB_INDEX_USERID,
+                                             userid)))
+            return NULL;
+    }
+    if (name) {
+        if (!(b[n++] = job_index_lookup (jsctx->jindex,
+                                         JOB_INDEX_NAME,
+                                         name)))
+            return NULL;
+    }
+    if (queue) {
+        if (!(b[n++] = job_index_lookup (jsctx->jindex,
+                                         JOB_INDEX_QUEUE,
+                                         queue)))
+            return NULL;
+    }
+    if ((states & list_states) != list_states
+        && single_bit (states & list_states)) {
+        if (!(b[n++] = job_index_lookup_int (jsctx->jindex,
+                                             JOB_INDEX_STATE,
+                                             states & list_states)))
+            return NULL;
+    }
+    else if (list == JOB_INDEX_INACTIVE && single_bit (results)) {
+        if (!(b[n++] = job_index_lookup_int (jsctx->jindex,
+                                             JOB_INDEX_RESULT,
+                                             results)))
+            return NULL;
+    }
+    for (i = 0; i < n; i++) {
+        if (job_index_count (b[i], list) < job_index_count (best, list))
+            best = b[i];
+    }
+    if (job_index_count (best, list) == 0)
+        return NULL;
+    return best;
+}
+
+/* Put jobs from 'list' of 'bucket' onto jobs array, starting at 'job',
+ * breaking if max_entries has been reached.  The id of the last job
+ * added is stored in 'lastp'.  Returns 1 if jobs array is full, 0 if
+ * continue, -1 one error with errno set:
  *
  * ENOMEM - out of memory
  */
 int get_jobs_from_list (json_t *jobs,
                         job_list_error_t *errp,
-                        zlistx_t *list,
+                        struct job_index_bucket *bucket,
+                        enum job_index_list list,
+                        struct job *job,
                         int max_entries,
                         json_t *attrs,
                         uint32_t userid,
@@ -72,11 +144,9 @@ int get_jobs_from_list (json_t *jobs,
                         int results,
                         double since,
                         const char *name,
-                        const char *queue)
+                        const char *queue,
+                        flux_jobid_t *lastp)
 {
-    struct job *job;
-
-    job = zlistx_first (list);
     while (job) {
 
         /*  If job->t_inactive > 0. (we're on the inactive jobs list),
@@ -95,10 +165,11 @@ int get_jobs_from_list (json_t *jobs,
                 errno = ENOMEM;
                 return -1;
             }
+            *lastp = job->id;
             if (json_array_size (jobs) == max_entries)
                 return 1;
         }
-        job = zlistx_next (list);
+        job = job_index_next (bucket, list, job);
     }
 
     return 0;
@@ -106,10 +177,14 @@ int get_jobs_from_list (json_t *jobs,
 
 /* Create a JSON array of 'job' objects.  'max_entries' determines the
  * max number of jobs to return, 0=unlimited. 'since' limits jobs returned
- * to those with t_inactive greater than timestamp.  Returns JSON object
- * which the caller must free.  On error, return NULL with errno set:
+ * to those with t_inactive greater than timestamp.  If 'cursor' is
+ * non-zero, the listing resumes after that job.  If 'max_entries' is
+ * reached, the id of the last job returned is stored in 'next_cursor'.
+ * Returns JSON object which the caller must free.  On error, return NULL
+ * with errno set:
  *
  * EPROTO - malformed or empty attrs array, max_entries out of range
+ * ENOENT - cursor job is unknown or no longer listed
  * ENOMEM - out of memory
  */
 json_t *get_jobs (struct job_state_ctx *jsctx,
@@ -121,67 +196,81 @@ json_t *get_jobs (struct job_state_ctx *jsctx,
                   int states,
                   int results,
                   const char *name,
-                  const char *queue)
+                  const char *queue,
+                  flux_jobid_t cursor,
+                  flux_jobid_t *next_cursor)
 {
+    /* We return jobs in the following order, pending, running,
+     * inactive */
+    const int list_states[JOB_INDEX_LIST_COUNT] = {
+        FLUX_JOB_STATE_PENDING,
+        FLUX_JOB_STATE_RUNNING,
+        FLUX_JOB_STATE_INACTIVE,
+    };
+    struct job *cursor_job = NULL;
+    int cursor_list = -1;
+    flux_jobid_t last = 0;
     json_t *jobs = NULL;
     int saved_errno;
     int ret = 0;
+    int list;
+
+    if (cursor != 0) {
+        if (!(cursor_job = zhashx_lookup (jsctx->index, &cursor))
+            || (cursor_list = job_index_list (cursor_job)) < 0) {
+            seterror (errp, "cursor job %ju not found", (uintmax_t)cursor);
+            errno = ENOENT;
+            return NULL;
+        }
+    }
 
     if (!(jobs = json_array ()))
         goto error_nomem;
 
-    /* We return jobs in the following order, pending, running,
-     * inactive */
+    for (list = 0; list < JOB_INDEX_LIST_COUNT && !ret; list++) {
+        struct job_index_bucket *bucket;
+        struct job *job;
 
-    if (states & FLUX_JOB_STATE_PENDING) {
+        if (!(states & list_states[list]) || list < cursor_list)
+            continue;
+        if (!(bucket = plan_query (jsctx,
+                                   list,
+                                   list_states[list],
+                                   userid,
+                                   states,
+                                   results,
+                                   name,
+                                   queue)))
+            continue;
+        if (list == cursor_list) {
+            /* The cursor job may no longer be in the chosen bucket,
+             * e.g. if its state changed.  Resume from its position in
+             * the list of all jobs instead.
+             */
+            if (!job_index_contains (bucket, list, cursor_job))
+                bucket = job_index_lookup (jsctx->jindex, JOB_INDEX_ALL, NULL);
+            job = job_index_next (bucket, list, cursor_job);
+        }
+        else
+            job = job_index_first (bucket, list);
         if ((ret = get_jobs_from_list (jobs,
                                        errp,
-                                       jsctx->pending,
+                                       bucket,
+                                       list,
+                                       job,
                                        max_entries,
                                        attrs,
                                        userid,
                                        states,
                                        results,
-                                       0.,
+                                       list == JOB_INDEX_INACTIVE ? since : 0.,
                                        name,
-                                       queue)) < 0)
+                                       queue,
+                                       &last)) < 0)
             goto error;
     }
 
-    if (states & FLUX_JOB_STATE_RUNNING) {
-        if (!ret) {
-            if ((ret = get_jobs_from_list (jobs,
-                                           errp,
-                                           jsctx->running,
-                                           max_entries,
-                                           attrs,
-                                           userid,
-                                           states,
-                                           results,
-                                           0.,
-                                           name,
-                                           queue)) < 0)
-                goto error;
-        }
-    }
-
-    if (states & FLUX_JOB_STATE_INACTIVE) {
-        if (!ret) {
-            if ((ret = get_jobs_from_list (jobs,
-                                           errp,
-                                           jsctx->inactive,
-                                           max_entries,
-                                           attrs,
-                                           userid,
-                                           states,
-                                           results,
-                                           since,
-                                           name,
-                                           queue)) < 0)
-                goto error;
-        }
-    }
-
+    *next_cursor = ret == 1 ? last : 0;
     return jobs;
 
 error_nomem:
@@ -207,8 +296,11 @@ void list_cb (flux_t *h, flux_msg_handler_t *mh,
     int results;
     const char *name = NULL;
     const char *queue = NULL;
+    flux_jobid_t cursor = 0;
+    flux_jobid_t next_cursor = 0;
+    int rc;
 
-    if (flux_request_unpack (msg, NULL, "{s:i s:o s:i s:i s:i s?F s?s s?s}",
+    if (flux_request_unpack (msg, NULL, "{s:i s:o s:i s:i s:i s?F s?s s?s s?I}",
                              "max_entries", &max_entries,
                              "attrs", &attrs,
                              "userid", &userid,
@@ -216,7 +308,8 @@ void list_cb (flux_t *h, flux_msg_handler_t *mh,
                              "results", &results,
                              "since", &since,
                              "name", &name,
-                             "queue", &queue) < 0) {
+                             "queue", &queue,
+                             "cursor", &cursor) < 0) {
         seterror (&err, "invalid payload: %s", flux_msg_last_error (msg));
         errno = EPROTO;
         goto error;
@@ -245,10 +338,20 @@ void list_cb (flux_t *h, flux_msg_handler_t *mh,
                    | FLUX_JOB_RESULT_TIMEOUT);
 
     if (!(jobs = get_jobs (ctx->jsctx, &err, max_entries, since,
-                           attrs, userid, states, results, name, queue)))
+                           attrs, userid, states, results, name, queue,
+                           cursor, &next_cursor)))
         goto error;
 
-    if (flux_respond_pack (h, msg, "{s:O}", "jobs", jobs) < 0)
+    /* A cursor is only returned if max_entries was reached, so that
+     * the caller can request the next page of results.
+     */
+    if (next_cursor)
+        rc = flux_respond_pack (h, msg, "{s:O s:I}",
+                                "jobs", jobs,
+                                "cursor", next_cursor);
+    else
+        rc = flux_respond_pack (h, msg, "{s:O}", "jobs", jobs);
+    if (rc < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
 
     json_decref (jobs);
@@ -0,0 +1,255 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/modules/job-list/job_data.h"
+#include "src/modules/job-list/job_index.h"
+
+#define NJOBS 16
+
+static struct job *jobs[NJOBS];
+
+static void create_jobs (void)
+{
+    int i;
+
+    for (i = 0; i < NJOBS; i++) {
+        if (!(jobs[i] = job_create (NULL, i + 1)))
+            BAIL_OUT ("job_create failed");
+        jobs[i]->userid = i % 2 ? 100 : 200;
+        jobs[i]->queue = i % 4 ? "batch" : "debug";
+        jobs[i]->name = "hostname";
+        jobs[i]->priority = 16;
+    }
+}
+
+static void destroy_jobs (void)
+{
+    int i;
+
+    for (i = 0; i < NJOBS; i++)
+        job_destroy (jobs[i]);
+}
+
+/* Return true if 'list' of 'bucket' is in 'cmp' order */
+static bool check_sorted (struct job_index_bucket *bucket,
+                          enum job_index_list list,
+                          int (*cmp)(const void *a1, const void *a2))
+{
+    struct job *prev = NULL;
+    struct job *job;
+
+    job = job_index_first (bucket, list);
+    while (job) {
+        if (prev && cmp (prev, job) > 0)
+            return false;
+        prev = job;
+        job = job_index_next (bucket, list, job);
+    }
+    return true;
+}
+
+static int count_list (struct job_index_bucket *bucket,
+                       enum job_index_list list)
+{
+    struct job *job;
+    int count = 0;
+
+    job = job_index_first (bucket, list);
+    while (job) {
+        count++;
+        job = job_index_next (bucket, list, job);
+    }
+    return count;
+}
+
+static void test_pending (struct job_index *jindex)
+{
+    struct job_index_bucket *all;
+    struct job_index_bucket *bucket;
+    int errors = 0;
+    int i;
+
+    ok (job_index_update (jindex, jobs[0]) == 0
+        && job_index_list (jobs[0]) == -1,
+        "job_index_update does not index a job in NEW state");
+
+    for (i = 0; i < NJOBS; i++) {
+        jobs[i]->state = FLUX_JOB_STATE_DEPEND;
+        if (job_index_update (jindex, jobs[i]) < 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "job_index_update works for %d pending jobs", NJOBS);
+    all = job_index_lookup (jindex, JOB_INDEX_ALL, NULL);
+    ok (job_index_count (all, JOB_INDEX_PENDING) == NJOBS
+        && count_list (all, JOB_INDEX_PENDING) == NJOBS,
+        "all bucket has %d pending jobs", NJOBS);
+    bucket = job_index_lookup_int (jindex, JOB_INDEX_USERID, 100);
+    ok (job_index_count (bucket, JOB_INDEX_PENDING) == NJOBS / 2
+        && count_list (bucket, JOB_INDEX_PENDING) == NJOBS / 2,
+        "userid bucket has %d pending jobs", NJOBS / 2);
+    bucket = job_index_lookup (jindex, JOB_INDEX_QUEUE, "debug");
+    ok (job_index_count (bucket, JOB_INDEX_PENDING) == NJOBS / 4,
+        "queue bucket has %d pending jobs", NJOBS / 4);
+    ok (job_index_lookup (jindex, JOB_INDEX_QUEUE, "nosuchqueue") == NULL,
+        "job_index_lookup returns NULL for unknown value");
+    ok (job_index_lookup (jindex, JOB_INDEX_RESULT, "0") == NULL,
+        "pending jobs are not indexed by result");
+
+    /* raise the priority of the last job, it should move to the head */
+    jobs[NJOBS - 1]->priority = FLUX_JOB_PRIORITY_MAX;
+    jobs[NJOBS - 1]->state = FLUX_JOB_STATE_SCHED;
+    ok (job_index_update (jindex, jobs[NJOBS - 1]) == 0
+        && job_index_first (all, JOB_INDEX_PENDING) == jobs[NJOBS - 1],
+        "job_index_update moves job to head on priority increase");
+    ok (check_sorted (all, JOB_INDEX_PENDING, job_urgency_cmp),
+        "pending list is sorted by priority then id");
+    bucket = job_index_lookup_int (jindex,
+                                   JOB_INDEX_STATE,
+                                   FLUX_JOB_STATE_SCHED);
+    ok (job_index_count (bucket, JOB_INDEX_PENDING) == 1
+        && job_index_first (bucket, JOB_INDEX_PENDING) == jobs[NJOBS - 1],
+        "state bucket follows state change");
+    ok (job_index_contains (all, JOB_INDEX_PENDING, jobs[0])
+        && !job_index_contains (bucket, JOB_INDEX_PENDING, jobs[0]),
+        "job_index_contains works");
+}
+
+static void test_transitions (struct job_index *jindex)
+{
+    struct job_index_bucket *all;
+    struct job_index_bucket *bucket;
+    int errors = 0;
+    int i;
+
+    /* run jobs in id order, then complete them in reverse */
+    for (i = 0; i < NJOBS; i++) {
+        jobs[i]->state = FLUX_JOB_STATE_RUN;
+        jobs[i]->t_run = 100. + i;
+        if (job_index_update (jindex, jobs[i]) < 0)
+            errors++;
+    }
+    for (i = NJOBS - 1; i >= NJOBS / 2; i--) {
+        jobs[i]->state = FLUX_JOB_STATE_INACTIVE;
+        jobs[i]->t_inactive = 300. - i;
+        jobs[i]->result = i % 2 ? FLUX_JOB_RESULT_COMPLETED
+                                : FLUX_JOB_RESULT_FAILED;
+        if (job_index_update (jindex, jobs[i]) < 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "job_index_update works on state transitions");
+    all = job_index_lookup (jindex, JOB_INDEX_ALL, NULL);
+    ok (job_index_count (all, JOB_INDEX_PENDING) == 0
+        && job_index_count (all, JOB_INDEX_RUNNING) == NJOBS / 2
+        && job_index_count (all, JOB_INDEX_INACTIVE) == NJOBS / 2,
+        "jobs moved between lists");
+    ok (check_sorted (all, JOB_INDEX_RUNNING, job_running_cmp)
+        && job_index_first (all, JOB_INDEX_RUNNING) == jobs[NJOBS / 2 - 1],
+        "running list is sorted by most recent run time");
+    ok (check_sorted (all, JOB_INDEX_INACTIVE, job_inactive_cmp)
+        && job_index_first (all, JOB_INDEX_INACTIVE) == jobs[NJOBS / 2],
+        "inactive list is sorted by most recent inactive time");
+    bucket = job_index_lookup_int (jindex,
+                                   JOB_INDEX_RESULT,
+                                   FLUX_JOB_RESULT_COMPLETED);
+    ok (job_index_count (bucket, JOB_INDEX_INACTIVE) == NJOBS / 4
+        && check_sorted (bucket, JOB_INDEX_INACTIVE, job_inactive_cmp),
+        "result bucket has %d sorted inactive jobs", NJOBS / 4);
+    ok (job_index_lookup_int (jindex,
+                              JOB_INDEX_STATE,
+                              FLUX_JOB_STATE_DEPEND) == NULL,
+        "empty state bucket was removed");
+    ok (job_index_next (bucket, JOB_INDEX_INACTIVE, jobs[0]) == NULL,
+        "job_index_next returns NULL for job not in bucket");
+
+    job_index_remove (jindex, jobs[NJOBS / 2]);
+    ok (job_index_list (jobs[NJOBS / 2]) == -1
+        && job_index_count (all, JOB_INDEX_INACTIVE) == NJOBS / 2 - 1
+        && job_index_first (all, JOB_INDEX_INACTIVE) == jobs[NJOBS / 2 + 1],
+        "job_index_remove works");
+    lives_ok ({job_index_remove (jindex, jobs[NJOBS / 2]);},
+        "job_index_remove of unindexed job is a no-op");
+}
+
+static void test_append (void)
+{
+    struct job_index *jindex;
+    struct job_index_bucket *all;
+    int errors = 0;
+    int i;
+
+    if (!(jindex = job_index_create ()))
+        BAIL_OUT ("job_index_create failed");
+    for (i = 0; i < NJOBS; i++) {
+        jobs[i]->state = FLUX_JOB_STATE_INACTIVE;
+        jobs[i]->t_inactive = 1000. - i;
+        if (job_index_append (jindex, jobs[i]) < 0)
+            errors++;
+    }
+    all = job_index_lookup (jindex, JOB_INDEX_ALL, NULL);
+    ok (errors == 0
+        && job_index_count (all, JOB_INDEX_INACTIVE) == NJOBS
+        && job_index_first (all, JOB_INDEX_INACTIVE) == jobs[0]
+        && check_sorted (all, JOB_INDEX_INACTIVE, job_inactive_cmp),
+        "job_index_append preserves order of sorted input");
+    job_index_destroy (jindex);
+}
+
+static void test_inval (void)
+{
+    errno = 0;
+    ok (job_index_update (NULL, jobs[0]) < 0 && errno == EINVAL,
+        "job_index_update jindex=NULL fails with EINVAL");
+    ok (job_index_lookup (NULL, JOB_INDEX_ALL, NULL) == NULL,
+        "job_index_lookup jindex=NULL returns NULL");
+    ok (job_index_count (NULL, JOB_INDEX_PENDING) == 0,
+        "job_index_count bucket=NULL returns 0");
+    ok (job_index_first (NULL, JOB_INDEX_PENDING) == NULL,
+        "job_index_first bucket=NULL returns NULL");
+    lives_ok ({job_index_destroy (NULL);},
+        "job_index_destroy NULL doesn't crash");
+}
+
+int main (int argc, char *argv[])
+{
+    struct job_index *jindex;
+    int i;
+
+    plan (NO_PLAN);
+
+    create_jobs ();
+
+    if (!(jindex = job_index_create ()))
+        BAIL_OUT ("job_index_create failed");
+    test_pending (jindex);
+    test_transitions (jindex);
+    for (i = 0; i < NJOBS; i++)
+        job_index_remove (jindex, jobs[i]);
+    job_index_destroy (jindex);
+
+    test_append ();
+    test_inval ();
+
+    destroy_jobs ();
+
+    done_testing ();
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
@@ -21,6 +21,8 @@
 #include "src/common/libkvs/treeobj.h"
 #include "src/common/libkvs/kvs_util_private.h"
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/errno_safe.h"
+#include "src/common/libcontent/content.h"
 
 /* State for one watcher */
 struct watcher {
@@ -41,6 +43,19 @@ struct watcher {
     struct ns_monitor *nsm;     // back pointer for removal
     json_t *prev;               // previous watch value for KVS_WATCH_FULL/UNIQ
     int append_offset;          // offset for KVS_WATCH_APPEND
+    json_t *append_blobs;       // blobrefs covering append_offset bytes
+    int *append_lens;           // length of each blob in append_blobs
+};
+
+/* Data gathered for an appended delta, attached to a KVS_WATCH_APPEND
+ * lookup (made with FLUX_KVS_TREEOBJ) as aux "append".
+ */
+struct append_delta {
+    bool prepared;              // append_prepare() has been called
+    int errnum;                 // error preparing delta
+    int first;                  // index of first blob not already seen
+    flux_future_t *f;           // load of new blobs, or fallback lookup
+    bool fallback;              // 'f' is a lookup of the value
 };
 
 /* Current KVS root.
@@ -64,6 +79,11 @@ struct ns_monitor {
     int errnum;                 // if non-zero, error pending for all watchers
     struct watch_ctx *ctx;      // back-pointer to watch_ctx
     zlist_t *watchers;          // list of watchers of this namespace
+    zhashx_t *index;            // key => list of watchers of that key
+    zlist_t *full_watchers;     // KVS_WATCH_FULL watchers
+    int lookups;                // lookups sent, for stats
+    int append_lookups;         // lookups answered with appended delta
+    int unsent;                 // watchers that have not yet sent a lookup
     char *topic;                // topic string for subscription
     bool subscribed;            // subscription active
     flux_future_t *getrootf;    // initial getroot future
@@ -90,6 +110,8 @@ static void watcher_destroy (struct watcher *w)
             zlist_destroy (&w->lookups);
         }
         json_decref (w->prev);
+        json_decref (w->append_blobs);
+        free (w->append_lens);
         free (w);
         errno = saved_errno;
     }
@@ -147,11 +169,22 @@ static struct commit *commit_create (const char *rootref, int rootseq,
     return commit;
 }
 
+static void index_list_destructor (void **item)
+{
+    if (item) {
+        zlist_t *l = *item;
+        zlist_destroy (&l);
+        *item = NULL;
+    }
+}
+
 static void namespace_destroy (struct ns_monitor *nsm)
 {
     if (nsm) {
         int saved_errno = errno;
         commit_destroy (nsm->commit);
+        zhashx_destroy (&nsm->index);
+        zlist_destroy (&nsm->full_watchers);
         if (nsm->watchers) {
             struct watcher *w;
             while ((w = zlist_pop (nsm->watchers)))
@@ -174,8 +207,11 @@ static struct ns_monitor *namespace_create (struct watch_ctx *ctx,
     struct ns_monitor *nsm = calloc (1, sizeof (*nsm));
     if (!nsm)
         return NULL;
-    if (!(nsm->watchers = zlist_new ()))
+    if (!(nsm->watchers = zlist_new ())
+        || !(nsm->index = zhashx_new ())
+        || !(nsm->full_watchers = zlist_new ()))
         goto error;
+    zhashx_set_destructor (nsm->index, index_list_destructor);
     if (!(nsm->ns_name = strdup (ns)))
         goto error;
     /* We are subscribing to the kvs.namespace-<NS> substring.
@@ -219,10 +255,58 @@ static bool key_match (json_t *o, const char *key)
     return false;
 }
 
+/* Add watcher to the namespace's change detection index, so that
+ * on setroot, only watchers of changed keys need be visited.
+ * KVS_WATCH_FULL watchers are visited on every setroot.
+ */
+static int watcher_index (struct ns_monitor *nsm, struct watcher *w)
+{
+    zlist_t *l;
+
+    if ((w->flags & FLUX_KVS_WATCH_FULL)) {
+        if (zlist_append (nsm->full_watchers, w) < 0)
+            goto nomem;
+        goto done;
+    }
+    if (!(l = zhashx_lookup (nsm->index, w->key))) {
+        if (!(l = zlist_new ()))
+            goto nomem;
+        if (zhashx_insert (nsm->index, w->key, l) < 0) {
+            zlist_destroy (&l);
+            goto nomem;
+        }
+    }
+    if (zlist_append (l, w) < 0)
+        goto nomem;
+done:
+    if (w->rootseq == -1)
+        nsm->unsent++;
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+static void watcher_unindex (struct ns_monitor *nsm, struct watcher *w)
+{
+    zlist_t *l;
+
+    if (w->rootseq == -1)
+        nsm->unsent--;
+    if ((w->flags & FLUX_KVS_WATCH_FULL))
+        zlist_remove (nsm->full_watchers, w);
+    else if ((l = zhashx_lookup (nsm->index, w->key))) {
+        zlist_remove (l, w);
+        if (zlist_size (l) == 0)
+            zhashx_delete (nsm->index, w->key);
+    }
+}
+
 static void watcher_cleanup (struct ns_monitor *nsm, struct watcher *w)
 {
     /* wait for all in flight lookups to complete before destroying watcher */
     if (zlist_size (w->lookups) == 0) {
+        watcher_unindex (nsm, w);
         zlist_remove (nsm->watchers, w);
         watcher_destroy (w);
     }
@@ -232,6 +316,27 @@ static void watcher_cleanup (struct ns_monitor *nsm, struct watcher *w)
         zhash_delete (nsm->ctx->namespaces, nsm->ns_name);
 }
 
+/* Forget the blobs covering append_offset, e.g. because append_offset
+ * was obtained from a full value.  The next delta loads all blobs.
+ */
+static void append_reset (struct watcher *w)
+{
+    json_decref (w->append_blobs);
+    w->append_blobs = NULL;
+    free (w->append_lens);
+    w->append_lens = NULL;
+}
+
+static void append_delta_destroy (struct append_delta *ad)
+{
+    if (ad) {
+        int saved_errno = errno;
+        flux_future_destroy (ad->f);
+        free (ad);
+        errno = saved_errno;
+    }
+}
+
 static int handle_initial_response (flux_t *h,
                                     struct watcher *w,
                                     json_t *val,
@@ -250,6 +355,7 @@ static int handle_initial_response (flux_t *h,
             flux_log_error (h, "%s: treeobj_decode_val", __FUNCTION__);
             return -1;
         }
+        append_reset (w);
     }
 
     if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
@@ -311,6 +417,7 @@ static int handle_append_response (flux_t *h,
             flux_log_error (h, "%s: treeobj_decode_val", __FUNCTION__);
             return -1;
         }
+        append_reset (w);
 
         if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
             flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
@@ -352,6 +459,7 @@ static int handle_append_response (flux_t *h,
 
         free (new_data);
         w->append_offset = new_offset;
+        append_reset (w);
 
         if (flux_respond_pack (h, w->request, "{ s:o }", "val", new_val) < 0) {
             json_decref (new_val);
@@ -363,6 +471,121 @@ static int handle_append_response (flux_t *h,
     return 0;
 }
 
+/* Respond to an append watcher with the data appended since the last
+ * response.  Blobs up to 'ad->first' were seen before and are skipped;
+ * the remainder were loaded by append_prepare().
+ */
+static int append_respond_blobs (flux_t *h,
+                                 struct watcher *w,
+                                 struct append_delta *ad,
+                                 json_t *valref)
+{
+    int count;
+    int *lens = NULL;
+    char *data = NULL;
+    json_t *val = NULL;
+    int total = 0;
+    int offset;
+    int len = 0;
+    int saved_errno;
+    int rc = -1;
+    int i;
+
+    if ((count = treeobj_get_count (valref)) < 0)
+        return -1;
+    if (!(lens = calloc (count + 1, sizeof (*lens))))
+        return -1;
+    for (i = 0; i < ad->first; i++) {
+        lens[i] = w->append_lens[i];
+        total += lens[i];
+    }
+    offset = total;
+    for (i = ad->first; i < count; i++) {
+        if (content_load_batch_get (ad->f,
+                                    i - ad->first,
+                                    NULL,
+                                    &lens[i],
+                                    NULL) < 0)
+            goto done;
+        total += lens[i];
+    }
+    /* See note on append length check in handle_append_response().
+     */
+    if (total < w->append_offset) {
+        errno = EINVAL;
+        goto done;
+    }
+    if (!(data = malloc (total - w->append_offset + 1)))
+        goto done;
+    for (i = ad->first; i < count; i++) {
+        const char *buf;
+        int skip = 0;
+
+        if (content_load_batch_get (ad->f,
+                                    i - ad->first,
+                                    (const void **)&buf,
+                                    NULL,
+                                    NULL) < 0)
+            goto done;
+        if (offset < w->append_offset)
+            skip = w->append_offset - offset;
+        if (skip < lens[i]) {
+            memcpy (data + len, buf + skip, lens[i] - skip);
+            len += lens[i] - skip;
+        }
+        offset += lens[i];
+    }
+    if (!(val = treeobj_create_val (data, len)))
+        goto done;
+    if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+        goto done;
+    }
+    json_decref (w->append_blobs);
+    w->append_blobs = json_incref (treeobj_get_data (valref));
+    free (w->append_lens);
+    w->append_lens = lens;
+    lens = NULL;
+    w->append_offset = total;
+    rc = 0;
+done:
+    saved_errno = errno;
+    free (lens);
+    free (data);
+    json_decref (val);
+    errno = saved_errno;
+    return rc;
+}
+
+/* Respond to an append watcher using the treeobj returned by a
+ * FLUX_KVS_TREEOBJ lookup, and whatever append_prepare() gathered.
+ */
+static int handle_append_delta (flux_t *h,
+                                struct watcher *w,
+                                struct append_delta *ad,
+                                json_t *treeobj)
+{
+    json_t *val;
+    int errnum;
+
+    if (ad->errnum) {
+        errno = ad->errnum;
+        return -1;
+    }
+    if (ad->fallback) {
+        if (!flux_rpc_get_unpack (ad->f, "{ s:i }", "errno", &errnum)) {
+            errno = errnum;
+            return -1;
+        }
+        if (flux_rpc_get_unpack (ad->f, "{ s:o }", "val", &val) < 0)
+            return -1;
+        return handle_append_response (h, w, val);
+    }
+    if (treeobj_is_val (treeobj))
+        return handle_append_response (h, w, treeobj);
+    return append_respond_blobs (h, w, ad, treeobj);
+}
+
 static int handle_normal_response (flux_t *h,
                                    struct watcher *w,
                                    json_t *val)
@@ -462,7 +685,12 @@ static void handle_lookup_response (flux_future_t *f,
                     goto error;
             }
             else if (w->flags & FLUX_KVS_WATCH_APPEND) {
-                if (handle_append_response (h, w, val) < 0)
+                struct append_delta *ad = flux_future_aux_get (f, "append");
+                if (ad) {
+                    if (handle_append_delta (h, w, ad, val) < 0)
+                        goto error;
+                }
+                else if (handle_append_response (h, w, val) < 0)
                     goto error;
             }
             else {
@@ -480,6 +708,114 @@ error:
     w->finished = true;
 }
 
+static flux_future_t *lookupat (flux_t *h,
+                                struct watcher *w,
+                                const char *blobref,
+                                int root_seq,
+                                const char *ns,
+                                int flags);
+static void lookup_continuation (flux_future_t *f, void *arg);
+
+/* Send a content.load-batch request for blobs of 'valref' starting
+ * at index 'first'.
+ */
+static flux_future_t *append_load (flux_t *h, json_t *valref, int first)
+{
+    char hash[BLOBREF_MAX_DIGEST_SIZE];
+    char *hashes;
+    int hash_size = 0;
+    int count;
+    flux_future_t *f = NULL;
+    int i;
+
+    if ((count = treeobj_get_count (valref)) < 0)
+        return NULL;
+    if (!(hashes = malloc ((count - first) * sizeof (hash))))
+        return NULL;
+    for (i = first; i < count; i++) {
+        const char *ref;
+        int size;
+
+        if (!(ref = treeobj_get_blobref (valref, i))
+            || (size = blobref_strtohash (ref, hash, sizeof (hash))) < 0)
+            goto done;
+        if (hash_size == 0)
+            hash_size = size;
+        else if (size != hash_size) {
+            errno = EPROTO;
+            goto done;
+        }
+        memcpy (hashes + (i - first) * hash_size, hash, hash_size);
+    }
+    f = content_load_batch (h, hashes, hash_size, count - first, 0);
+done:
+    ERRNO_SAFE_WRAP (free, hashes);
+    return f;
+}
+
+/* A lookup 'f' for an append watcher has completed.  If more data is
+ * required to produce the appended delta, start fetching it.
+ * Return true if the watcher must wait for it.
+ */
+static bool append_prepare (struct watcher *w, flux_future_t *f)
+{
+    flux_t *h = w->nsm->ctx->h;
+    struct append_delta *ad;
+    json_t *treeobj;
+    const char *rootref;
+    int rootseq;
+    int count;
+    int n;
+
+    if (!(ad = flux_future_aux_get (f, "append")))
+        return false;
+    if (ad->prepared)
+        return ad->f && !flux_future_is_ready (ad->f);
+    ad->prepared = true;
+
+    /* errors are handled in handle_lookup_response() */
+    if (flux_rpc_get_unpack (f, "{ s:o s:i s:s }",
+                             "val", &treeobj,
+                             "rootseq", &rootseq,
+                             "rootref", &rootref) < 0)
+        return false;
+
+    if (treeobj_is_valref (treeobj)) {
+        if ((count = treeobj_get_count (treeobj)) < 0)
+            goto error;
+        n = json_array_size (w->append_blobs);
+        while (ad->first < n && ad->first < count) {
+            json_t *o = json_array_get (w->append_blobs, ad->first);
+            const char *ref = treeobj_get_blobref (treeobj, ad->first);
+            if (!ref || strcmp (ref, json_string_value (o)) != 0)
+                break;
+            ad->first++;
+        }
+        if (ad->first < count && !(ad->f = append_load (h, treeobj, ad->first)))
+            goto error;
+    }
+    else if (!treeobj_is_val (treeobj)) {
+        /* symlink, directory, etc: fall back to full value lookup */
+        if (!(ad->f = lookupat (h,
+                                w,
+                                rootref,
+                                rootseq,
+                                w->nsm->ns_name,
+                                w->flags)))
+            goto error;
+        ad->fallback = true;
+    }
+    if (!ad->f)
+        return false;
+    if (flux_future_then (ad->f, -1., lookup_continuation, w) < 0)
+        goto error;
+    w->nsm->append_lookups++;
+    return true;
+error:
+    ad->errnum = errno;
+    return false;
+}
+
 /* One lookup has completed.
  * Pop ready futures off w->lookups and send responses, until
  * the list is empty, or a non-ready future is encountered.
@@ -490,6 +826,8 @@ static void lookup_continuation (flux_future_t *f, void *arg)
     struct ns_monitor *nsm = w->nsm;
 
     while ((f = zlist_first (w->lookups)) && flux_future_is_ready (f)) {
+        if (!w->finished && append_prepare (w, f))
+            break;
         f = zlist_pop (w->lookups);
         if (!w->finished)
             handle_lookup_response (f, w);
@@ -519,7 +857,8 @@ static flux_future_t *lookupat (flux_t *h,
                                 struct watcher *w,
                                 const char *blobref,
                                 int root_seq,
-                                const char *ns)
+                                const char *ns,
+                                int flags)
 {
     flux_msg_t *msg;
     json_t *o = NULL;
@@ -532,7 +871,7 @@ static flux_future_t *lookupat (flux_t *h,
         if (flux_msg_pack (msg, "{s:s s:s s:i}",
                            "key", w->key,
                            "namespace", ns,
-                           "flags", w->flags) < 0)
+                           "flags", flags) < 0)
             goto error;
     }
     else {
@@ -540,7 +879,7 @@ static flux_future_t *lookupat (flux_t *h,
             goto error;
         if (flux_msg_pack (msg, "{s:s s:i s:i s:O}",
                            "key", w->key,
-                           "flags", w->flags,
+                           "flags", flags,
                            "rootseq", root_seq,
                            "rootdir", o) < 0)
             goto error;
@@ -574,17 +913,39 @@ error:
     return NULL;
 }
 
+/* Once an append watcher has responded, look up the treeobj rather
+ * than the value, so that only blobs not already seen need be fetched.
+ */
 static int process_lookup_response (struct ns_monitor *nsm, struct watcher *w)
 {
     flux_future_t *f;
+    struct append_delta *ad = NULL;
+    int flags = w->flags;
+
+    if ((w->flags & FLUX_KVS_WATCH_APPEND) && w->responded) {
+        if (!(ad = calloc (1, sizeof (*ad))))
+            return -1;
+        flags |= FLUX_KVS_TREEOBJ;
+    }
     if (!(f = lookupat (nsm->ctx->h,
                         w,
                         nsm->commit->rootref,
                         nsm->commit->rootseq,
-                        nsm->ns_name))) {
+                        nsm->ns_name,
+                        flags))) {
         flux_log_error (nsm->ctx->h, "%s: lookupat", __FUNCTION__);
+        append_delta_destroy (ad);
+        return -1;
+    }
+    if (ad && flux_future_aux_set (f,
+                                   "append",
+                                   ad,
+                                   (flux_free_f)append_delta_destroy) < 0) {
+        append_delta_destroy (ad);
+        flux_future_destroy (f);
         return -1;
     }
+    nsm->lookups++;
     if (zlist_append (w->lookups, f) < 0) {
         flux_future_destroy (f);
         errno = ENOMEM;
@@ -594,6 +955,8 @@ static int process_lookup_response (struct ns_monitor *nsm, struct watcher *w)
         flux_future_destroy (f);
         return -1;
     }
+    if (w->rootseq == -1)
+        nsm->unsent--;
     w->rootseq = nsm->commit->rootseq;
     return 0;
 }
@@ -697,6 +1060,45 @@ static void watcher_respond_ns (struct ns_monitor *nsm)
         flux_log_error (nsm->ctx->h, "%s: zlist_dup", __FUNCTION__);
 }
 
+/* Respond to watchers that may be affected by the current commit:
+ * FLUX_KVS_WATCH_FULL watchers, and watchers of keys in commit->keys.
+ * This avoids visiting every watcher in the namespace on each setroot.
+ * As above, lists are copied since watcher_respond() may alter them.
+ */
+static void watcher_respond_changed (struct ns_monitor *nsm)
+{
+    zlist_t *l;
+    const char *key;
+    json_t *value;
+    struct watcher *w;
+
+    if (!(l = zlist_dup (nsm->full_watchers)))
+        goto error;
+    json_object_foreach (nsm->commit->keys, key, value) {
+        zlist_t *kl;
+
+        if ((kl = zhashx_lookup (nsm->index, key))) {
+            w = zlist_first (kl);
+            while (w) {
+                if (zlist_append (l, w) < 0)
+                    goto error;
+                w = zlist_next (kl);
+            }
+        }
+    }
+    w = zlist_first (l);
+    while (w) {
+        watcher_respond (nsm, w);
+        w = zlist_next (l);
+    }
+    zlist_destroy (&l);
+    return;
+error:
+    zlist_destroy (&l);
+    flux_log (nsm->ctx->h, LOG_ERR, "%s: out of memory", __FUNCTION__);
+    watcher_respond_ns (nsm);
+}
+
 /* Cancel watcher 'w' if it matches:
  * - credentials and matchtag if cancel true
  * - credentials if cancel false
@@ -842,6 +1244,7 @@ static void setroot_cb (flux_t *h, flux_msg_handler_t *mh,
     int owner;
     json_t *keys;
     struct commit *commit;
+    bool scan_all;
 
     if (flux_event_unpack (msg, NULL, "{s:s s:i s:s s:i s:o}",
                            "namespace", &ns,
@@ -855,6 +1258,11 @@ static void setroot_cb (flux_t *h, flux_msg_handler_t *mh,
     if (!(nsm = zhash_lookup (ctx->namespaces, ns))
             || (nsm->commit && rootseq <= nsm->commit->rootseq))
         return;
+    /* Visit all watchers if some have not yet sent a lookup,
+     * e.g. waiting for the namespace to be created, or if the
+     * namespace is in an error state.
+     */
+    scan_all = (!nsm->commit || nsm->errnum != 0 || nsm->unsent > 0);
     if (!(commit = commit_create (rootref, rootseq, keys))) {
         flux_log_error (h, "%s: error creating commit", __FUNCTION__);
         nsm->errnum = errno;
@@ -864,6 +1272,10 @@ static void setroot_cb (flux_t *h, flux_msg_handler_t *mh,
     nsm->commit = commit;
     if (nsm->owner == FLUX_USERID_UNKNOWN)
         nsm->owner = owner;
+    if (!scan_all) {
+        watcher_respond_changed (nsm);
+        return;
+    }
 done:
     watcher_respond_ns (nsm);
 }
@@ -984,6 +1396,11 @@ static void lookup_cb (flux_t *h, flux_msg_handler_t *mh,
         errno = ENOMEM;
         goto error;
     }
+    if (watcher_index (nsm, w) < 0) {
+        zlist_remove (nsm->watchers, w);
+        watcher_destroy (w);
+        goto error;
+    }
     if (nsm->commit)
         watcher_respond (nsm, w);
     return;
@@ -1028,13 +1445,15 @@ static void stats_cb (flux_t *h, flux_msg_handler_t *mh,
         goto nomem;
     nsm = zhash_first (ctx->namespaces);
     while (nsm) {
-        json_t *o = json_pack ("{s:i s:i s:s s:i}",
+        json_t *o = json_pack ("{s:i s:i s:s s:i s:i s:i}",
                                "owner", (int)nsm->owner,
                                "rootseq", nsm->commit ? nsm->commit->rootseq
                                                       : -1,
                                "rootref", nsm->commit ? nsm->commit->rootref
                                                       : "(null)",
-                               "watchers", (int)zlist_size (nsm->watchers));
+                               "watchers", (int)zlist_size (nsm->watchers),
+                               "lookups", nsm->lookups,
+                               "append-lookups", nsm->append_lookups);
         if (!o)
             goto nomem;
         if (json_object_set_new (stats, nsm->ns_name, o) < 0) {
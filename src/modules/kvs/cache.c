@@ -405,6 +405,17 @@ int cache_count_entries (struct cache *cache)
     return zhashx_size (cache->zhx);
 }
 
+int cache_foreach_valid (struct cache *cache, cache_entry_f cb, void *arg)
+{
+    struct cache_entry *entry;
+
+    list_for_each (&cache->entries_list, entry, entries_node) {
+        if (cache_entry_get_valid (entry) && cb (entry, arg) < 0)
+            return -1;
+    }
+    return 0;
+}
+
 static int cache_entry_age (struct cache_entry *entry, struct cache *cache)
 {
     double current_time = cache_now (cache);
@@ -495,6 +506,11 @@ const char *cache_entry_get_blobref (struct cache_entry *entry)
     return entry ? entry->blobref : NULL;
 }
 
+double cache_entry_get_lastuse (struct cache_entry *entry)
+{
+    return entry ? entry->lastuse_time : 0.;
+}
+
 static void cache_entry_destroy_wrapper (void **arg)
 {
     struct cache_entry **entry = (struct cache_entry **)arg;
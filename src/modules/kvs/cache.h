@@ -109,6 +109,10 @@ int cache_entry_wait_valid (struct cache_entry *entry, wait_t *wait);
 /* Get the blobref of this entry */
 const char *cache_entry_get_blobref (struct cache_entry *entry);
 
+/* Get the time this entry was last used (see cache_lookup()).
+ */
+double cache_entry_get_lastuse (struct cache_entry *entry);
+
 /* Create/destroy the cache container and its contents.
  * 'r' is used as a source of relative current time for cache aging.
  * If NULL, the cache never ages.
@@ -138,6 +142,12 @@ int cache_remove_entry (struct cache *cache, const char *ref);
  */
 int cache_count_entries (struct cache *cache);
 
+/* Call 'cb' for each valid cache entry.  Iteration stops if 'cb'
+ * returns -1.  Returns -1 if iteration was stopped, 0 otherwise.
+ */
+typedef int (*cache_entry_f)(struct cache_entry *entry, void *arg);
+int cache_foreach_valid (struct cache *cache, cache_entry_f cb, void *arg);
+
 /* Expire cache entries that are not dirty, not incomplete, and last
  * used more than 'max_age' seconds ago.  If max_age == 0, expire all
  * entries that are not dirty/incomplete.
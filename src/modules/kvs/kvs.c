@@ -46,6 +46,8 @@
 #include "kvsroot.h"
 #include "kvs_wait_version.h"
 #include "kvs_checkpoint.h"
+#include "kvs_replica.h"
+#include "kvs_snapshot.h"
 
 /* heartbeat_sync_cb() is called periodically to manage cached content
  * and namespaces.  Synchronize with the system heartbeat if possible,
@@ -67,16 +69,26 @@ struct kvs_ctx {
     struct cache *cache;    /* blobref => cache_entry */
     kvsroot_mgr_t *krm;
     int faults;                 /* for kvs.stats-get, etc. */
+    int prefetches;             /* for kvs.stats-get, etc. */
+    int lookup_stalls;          /* for kvs.stats-get, etc. */
+    tstat_t lookup_stall_ts;    /* lookup stall latency (msec) */
     flux_t *h;
     uint32_t rank;
     flux_watcher_t *prep_w;
     flux_watcher_t *idle_w;
     flux_watcher_t *check_w;
     int transaction_merge;
+    int dir_shard_threshold;
+    double group_commit_window;
+    int group_commit_count;
+    flux_watcher_t *group_commit_w;
+    double group_commit_deadline;   /* group_commit_w expiry, or -1 */
     bool events_init;            /* flag */
     const char *hash_name;
     unsigned int seq;           /* for commit transactions */
     kvs_checkpoint_t *kcp;
+    kvs_replica_t *replica;     /* NULL unless replica= args given */
+    kvs_snapshot_t *snapshot;   /* rank 0 only */
     struct list_head work_queue;
 };
 
@@ -92,6 +104,8 @@ static void transaction_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
                                  int revents, void *arg);
 static void transaction_check_cb (flux_reactor_t *r, flux_watcher_t *w,
                                   int revents, void *arg);
+static void group_commit_cb (flux_reactor_t *r, flux_watcher_t *w,
+                             int revents, void *arg);
 static void start_root_remove (struct kvs_ctx *ctx, const char *ns);
 static void work_queue_check_append (struct kvs_ctx *ctx,
                                      struct kvsroot *root);
@@ -104,24 +118,35 @@ static void kvs_ctx_destroy (struct kvs_ctx *ctx)
 {
     if (ctx) {
         int saved_errno = errno;
+        kvs_replica_destroy (ctx->replica);
+        kvs_snapshot_destroy (ctx->snapshot);
         cache_destroy (ctx->cache);
         kvsroot_mgr_destroy (ctx->krm);
         flux_watcher_destroy (ctx->prep_w);
         flux_watcher_destroy (ctx->check_w);
         flux_watcher_destroy (ctx->idle_w);
+        flux_watcher_destroy (ctx->group_commit_w);
         kvs_checkpoint_destroy (ctx->kcp);
         free (ctx);
         errno = saved_errno;
     }
 }
 
-static void work_queue_check_append_wrapper (struct kvsroot *root,
-                                             void *arg)
+/* Called after a checkpoint-period transaction has been submitted.
+ * Update the snapshot too, so it is reasonably current after a crash.
+ */
+static void checkpoint_txn_cb (struct kvsroot *root, void *arg)
 {
     struct kvs_ctx *ctx = arg;
     work_queue_check_append (ctx, root);
+    kvs_snapshot_update (ctx->snapshot, root->ref, root->seq);
 }
 
+static void snapshot_warm_cb (const char *ref,
+                              const void *data,
+                              int len,
+                              void *arg);
+
 static struct kvs_ctx *kvs_ctx_create (flux_t *h)
 {
     flux_reactor_t *r = flux_get_reactor (h);
@@ -150,17 +175,35 @@ static struct kvs_ctx *kvs_ctx_create (flux_t *h)
         ctx->idle_w = flux_idle_watcher_create (r, NULL, NULL);
         if (!ctx->idle_w)
             goto error;
+        ctx->group_commit_w = flux_timer_watcher_create (r,
+                                                         0.,
+                                                         0.,
+                                                         group_commit_cb,
+                                                         ctx);
+        if (!ctx->group_commit_w)
+            goto error;
         flux_watcher_start (ctx->prep_w);
         flux_watcher_start (ctx->check_w);
         ctx->kcp = kvs_checkpoint_create (h,
                                           NULL, /* set later */
                                           0.0,  /* default 0.0, set later */
-                                          work_queue_check_append_wrapper,
+                                          checkpoint_txn_cb,
                                           ctx);
         if (!ctx->kcp)
             goto error;
+        ctx->snapshot = kvs_snapshot_create (h,
+                                             ctx->cache,
+                                             ctx->hash_name,
+                                             snapshot_warm_cb,
+                                             ctx);
+        if (!ctx->snapshot)
+            goto error;
     }
     ctx->transaction_merge = 1;
+    ctx->dir_shard_threshold = KVSTXN_SHARD_THRESHOLD;
+    ctx->group_commit_window = KVSTXN_GROUP_COMMIT_WINDOW;
+    ctx->group_commit_count = KVSTXN_GROUP_COMMIT_COUNT;
+    ctx->group_commit_deadline = -1.;
     list_head_init (&ctx->work_queue);
     return ctx;
 error:
@@ -284,6 +327,16 @@ static int check_user (struct kvs_ctx *ctx, struct kvsroot *root,
  * set/get root
  */
 
+/* Apply module options to a newly created root.
+ */
+static void root_configure (struct kvs_ctx *ctx, struct kvsroot *root)
+{
+    kvstxn_mgr_set_shard_threshold (root->ktm, ctx->dir_shard_threshold);
+    kvstxn_mgr_set_group_commit (root->ktm,
+                                 ctx->group_commit_window,
+                                 ctx->group_commit_count);
+}
+
 static void setroot (struct kvs_ctx *ctx, struct kvsroot *root,
                      const char *rootref, int rootseq)
 {
@@ -291,6 +344,10 @@ static void setroot (struct kvs_ctx *ctx, struct kvsroot *root,
         kvsroot_setroot (ctx->krm, root, rootref, rootseq);
         kvs_wait_version_process (root, false);
         root->last_update_time = flux_reactor_now (flux_get_reactor (ctx->h));
+        if (ctx->replica && !strcmp (root->ns_name, KVS_PRIMARY_NAMESPACE)) {
+            if (kvs_replica_update (ctx->replica, rootref) < 0)
+                flux_log_error (ctx->h, "%s: kvs_replica_update", __FUNCTION__);
+        }
     }
 }
 
@@ -338,6 +395,7 @@ static void getroot_completion (flux_future_t *f, void *arg)
             flux_log_error (ctx->h, "%s: kvsroot_mgr_create_root", __FUNCTION__);
             goto error;
         }
+        root_configure (ctx, root);
 
         if (event_subscribe (ctx, ns) < 0) {
             save_errno = errno;
@@ -538,6 +596,58 @@ error:
     return -1;
 }
 
+/* Speculatively load 'ref' into the cache, with no waiter.
+ * Return 0 on success, -1 on error.
+ */
+static int prefetch (struct kvs_ctx *ctx, const char *ref)
+{
+    struct cache_entry *entry;
+
+    if (cache_lookup (ctx->cache, ref))
+        return 0;
+    if (!(entry = cache_entry_create (ref)))
+        return -1;
+    if (cache_insert (ctx->cache, entry) < 0) {
+        cache_entry_destroy (entry);
+        return -1;
+    }
+    if (content_load_request_send (ctx, ref) < 0) {
+        int saved_errno = errno;
+        (void)cache_remove_entry (ctx->cache, ref);
+        errno = saved_errno;
+        return -1;
+    }
+    ctx->prefetches++;
+    return 0;
+}
+
+static int replica_load_cb (const char *ref, void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+    return prefetch (ctx, ref);
+}
+
+/* Insert an object loaded from the snapshot into the cache, unless
+ * it is already there (possibly with a load in progress).
+ */
+static void snapshot_warm_cb (const char *ref,
+                              const void *data,
+                              int len,
+                              void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+    struct cache_entry *entry;
+
+    if (cache_lookup (ctx->cache, ref))
+        return;
+    if (!(entry = cache_entry_create (ref))
+        || cache_entry_set_raw (entry, data, len) < 0
+        || cache_insert (ctx->cache, entry) < 0) {
+        flux_log_error (ctx->h, "%s: error caching %s", __FUNCTION__, ref);
+        cache_entry_destroy (entry);
+    }
+}
+
 /* Return 0 on success, -1 on error.  Set stall variable appropriately
  */
 static int load (struct kvs_ctx *ctx, const char *ref, wait_t *wait, bool *stall)
@@ -1120,11 +1230,58 @@ static void transaction_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
         flux_watcher_start (ctx->idle_w);
 }
 
+static int group_commit_root_cb (struct kvsroot *root, void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+
+    work_queue_check_append (ctx, root);
+    return 0;
+}
+
+/* A group commit hold has expired.  Put roots with ready transactions
+ * back on the work queue.
+ */
+static void group_commit_cb (flux_reactor_t *r, flux_watcher_t *w,
+                             int revents, void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+
+    ctx->group_commit_deadline = -1.;
+    if (kvsroot_mgr_iter_roots (ctx->krm, group_commit_root_cb, ctx) < 0)
+        flux_log_error (ctx->h, "%s: kvsroot_mgr_iter_roots", __FUNCTION__);
+}
+
+/* Hold ready transactions on 'root' so more can be merged into the
+ * same root update.  The root is taken off the work queue until the
+ * hold expires, or until another transaction arrives.
+ * Return true if held.
+ */
+static bool group_commit_hold (struct kvs_ctx *ctx, struct kvsroot *root)
+{
+    double now = flux_reactor_now (flux_get_reactor (ctx->h));
+    double hold;
+
+    if (!ctx->transaction_merge
+        || (hold = kvstxn_mgr_group_commit_hold (root->ktm, now)) == 0.)
+        return false;
+    work_queue_remove (root);
+    if (ctx->group_commit_deadline < 0.
+        || ctx->group_commit_deadline > now + hold) {
+        flux_timer_watcher_reset (ctx->group_commit_w, hold, 0.);
+        flux_watcher_start (ctx->group_commit_w);
+        ctx->group_commit_deadline = now + hold;
+    }
+    return true;
+}
+
 static void kvstxn_check_root_cb (struct kvsroot *root, void *arg)
 {
     struct kvs_ctx *ctx = arg;
     kvstxn_t *kt;
 
+    if (group_commit_hold (ctx, root))
+        return;
+
     if ((kt = kvstxn_mgr_get_ready_transaction (root->ktm))) {
         if (ctx->transaction_merge) {
             /* if merge fails, set errnum in kvstxn_t, let
@@ -1211,6 +1368,75 @@ static void dropcache_event_cb (flux_t *h, flux_msg_handler_t *mh,
                   expcount, size);
 }
 
+struct gc_roots {
+    char *buf;
+    int len;
+    int alloc;
+};
+
+static int gc_roots_append (struct gc_roots *gr, const char *ref)
+{
+    char hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_size;
+
+    if ((hash_size = blobref_strtohash (ref, hash, sizeof (hash))) < 0)
+        return -1;
+    if (gr->len + hash_size > gr->alloc) {
+        int new_alloc = gr->alloc ? gr->alloc * 2 : 4096;
+        char *new_buf;
+
+        while (new_alloc < gr->len + hash_size)
+            new_alloc *= 2;
+        if (!(new_buf = realloc (gr->buf, new_alloc)))
+            return -1;
+        gr->buf = new_buf;
+        gr->alloc = new_alloc;
+    }
+    memcpy (gr->buf + gr->len, hash, hash_size);
+    gr->len += hash_size;
+    return 0;
+}
+
+static int gc_roots_root_cb (struct kvsroot *root, void *arg)
+{
+    return gc_roots_append (arg, root->ref);
+}
+
+static int gc_roots_entry_cb (struct cache_entry *entry, void *arg)
+{
+    return gc_roots_append (arg, cache_entry_get_blobref (entry));
+}
+
+/* Respond with the concatenated hash digests of each namespace root
+ * and each valid cache entry, for content backing store garbage
+ * collection.  Cache entries are included because the KVS does not
+ * store an object again if it is found in the cache.
+ */
+static void gc_roots_request_cb (flux_t *h, flux_msg_handler_t *mh,
+                                 const flux_msg_t *msg, void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+    struct gc_roots gr = { 0 };
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (ctx->rank != 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (kvsroot_mgr_iter_roots (ctx->krm, gc_roots_root_cb, &gr) < 0
+        || cache_foreach_valid (ctx->cache, gc_roots_entry_cb, &gr) < 0)
+        goto error;
+    if (flux_respond_raw (h, msg, gr.buf, gr.len) < 0)
+        flux_log_error (h, "%s: flux_respond_raw", __FUNCTION__);
+    free (gr.buf);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    free (gr.buf);
+}
+
 static int heartbeat_root_cb (struct kvsroot *root, void *arg)
 {
     struct kvs_ctx *ctx = arg;
@@ -1278,6 +1504,51 @@ static int lookup_load_cb (lookup_t *lh, const char *ref, void *data)
     return 0;
 }
 
+static int lookup_prefetch_cb (lookup_t *lh, const char *ref, void *data)
+{
+    struct kvs_ctx *ctx = data;
+
+    /* prefetch is best effort, failure does not affect the lookup */
+    if (prefetch (ctx, ref) < 0)
+        flux_log_error (ctx->h, "%s: prefetch", __FUNCTION__);
+    return 0;
+}
+
+/* Track the time from the first stall of a lookup request to its
+ * completion, across replays, with a timestamp in the message aux
+ * container.
+ */
+static int lookup_stall_start (struct kvs_ctx *ctx,
+                               const flux_msg_t *msg,
+                               wait_t *wait)
+{
+    double *t;
+    double *start;
+
+    if (!(t = malloc (sizeof (*t))))
+        return -1;
+    if ((start = flux_msg_aux_get (msg, "lookup_stall_start")))
+        *t = *start;
+    else
+        *t = flux_reactor_now (flux_get_reactor (ctx->h));
+    if (wait_msg_aux_set (wait, "lookup_stall_start", t, free) < 0) {
+        free (t);
+        return -1;
+    }
+    ctx->lookup_stalls++;
+    return 0;
+}
+
+static void lookup_stall_finish (struct kvs_ctx *ctx, const flux_msg_t *msg)
+{
+    double *start;
+
+    if ((start = flux_msg_aux_get (msg, "lookup_stall_start"))) {
+        double now = flux_reactor_now (flux_get_reactor (ctx->h));
+        tstat_push (&ctx->lookup_stall_ts, (now - *start) * 1000.);
+    }
+}
+
 static void lookup_wait_error_cb (wait_t *w, int errnum, void *arg)
 {
     lookup_t *lh = arg;
@@ -1405,6 +1676,9 @@ static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
         if (wait_msg_aux_set (wait, "lookup_handle", lh, NULL) < 0)
             goto done;
 
+        if (lookup_stall_start (ctx, msg, wait) < 0)
+            goto done;
+
         cbd.ctx = ctx;
         cbd.wait = wait;
         cbd.errnum = 0;
@@ -1425,6 +1699,10 @@ static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
     }
     /* else lret == LOOKUP_PROCESS_FINISHED, fallthrough */
 
+    lookup_stall_finish (ctx, msg);
+    if (lookup_iter_prefetch_refs (lh, lookup_prefetch_cb, ctx) < 0)
+        flux_log_error (h, "%s: lookup_iter_prefetch_refs", __FUNCTION__);
+
     rc = 0;
 done:
     wait_destroy (wait);
@@ -2166,8 +2444,11 @@ static int stats_get_root_cb (struct kvsroot *root, void *arg)
 {
     json_t *nsstats = arg;
     json_t *s;
+    json_t *gstats;
 
-    if (!(s = json_pack ("{ s:i s:i s:i s:i s:i }",
+    if (!(gstats = kvstxn_mgr_get_group_commit_stats (root->ktm)))
+        return -1;
+    if (!(s = json_pack ("{ s:i s:i s:i s:i s:i s:o }",
                          "#versionwaiters",
                          zlist_size (root->wait_version_list),
                          "#no-op stores",
@@ -2176,7 +2457,8 @@ static int stats_get_root_cb (struct kvsroot *root, void *arg)
                          treq_mgr_transactions_count (root->trm),
                          "#readytransactions",
                          kvstxn_mgr_ready_transaction_count (root->ktm),
-                         "store revision", root->seq))) {
+                         "store revision", root->seq,
+                         "group commit", gstats))) {
         errno = ENOMEM;
         return -1;
     }
@@ -2192,6 +2474,7 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
     json_t *tstats = NULL;
     json_t *cstats = NULL;
     json_t *nsstats = NULL;
+    json_t *lstats = NULL;
     tstat_t ts = { .min = 0.0, .max = 0.0, .M = 0.0, .S = 0.0, .newM = 0.0,
                    .newS = 0.0, .n = 0 };
     int size = 0, incomplete = 0, dirty = 0;
@@ -2222,6 +2505,39 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
                               "#faults", ctx->faults)))
         goto nomem;
 
+    if (ctx->replica) {
+        json_t *rstats;
+
+        if (!(rstats = kvs_replica_get_stats (ctx->replica)))
+            goto error;
+        if (json_object_set_new (cstats, "replica", rstats) < 0) {
+            json_decref (rstats);
+            goto nomem;
+        }
+    }
+
+    if (kvs_snapshot_enabled (ctx->snapshot)) {
+        json_t *sstats;
+
+        if (!(sstats = kvs_snapshot_get_stats (ctx->snapshot)))
+            goto nomem;
+        if (json_object_set_new (cstats, "snapshot", sstats) < 0) {
+            json_decref (sstats);
+            goto nomem;
+        }
+    }
+
+    if (!(lstats = json_pack ("{ s:i s:i s:{ s:i s:f s:f s:f s:f } }",
+                              "#prefetches", ctx->prefetches,
+                              "#stalls", ctx->lookup_stalls,
+                              "stall latency (msec)",
+                                "count", tstat_count (&ctx->lookup_stall_ts),
+                                "min", tstat_min (&ctx->lookup_stall_ts),
+                                "mean", tstat_mean (&ctx->lookup_stall_ts),
+                                "stddev", tstat_stddev (&ctx->lookup_stall_ts),
+                                "max", tstat_max (&ctx->lookup_stall_ts))))
+        goto nomem;
+
     if (!(nsstats = json_object ()))
         goto nomem;
 
@@ -2249,12 +2565,14 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
     }
 
     if (flux_respond_pack (h, msg,
-                           "{ s:O s:O }",
+                           "{ s:O s:O s:O }",
                            "cache", cstats,
+                           "lookup", lstats,
                            "namespace", nsstats) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     json_decref (tstats);
     json_decref (cstats);
+    json_decref (lstats);
     json_decref (nsstats);
     return;
 nomem:
@@ -2264,18 +2582,23 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
     json_decref (tstats);
     json_decref (cstats);
+    json_decref (lstats);
     json_decref (nsstats);
 }
 
 static int stats_clear_root_cb (struct kvsroot *root, void *arg)
 {
     kvstxn_mgr_clear_noop_stores (root->ktm);
+    kvstxn_mgr_clear_group_commit_stats (root->ktm);
     return 0;
 }
 
 static void stats_clear (struct kvs_ctx *ctx)
 {
     ctx->faults = 0;
+    ctx->prefetches = 0;
+    ctx->lookup_stalls = 0;
+    memset (&ctx->lookup_stall_ts, 0, sizeof (ctx->lookup_stall_ts));
 
     if (kvsroot_mgr_iter_roots (ctx->krm, stats_clear_root_cb, NULL) < 0)
         flux_log_error (ctx->h, "%s: kvsroot_mgr_iter_roots", __FUNCTION__);
@@ -2329,6 +2652,7 @@ static int namespace_create (struct kvs_ctx *ctx, const char *ns,
         flux_log_error (ctx->h, "%s: kvsroot_mgr_create_root", __FUNCTION__);
         return -1;
     }
+    root_configure (ctx, root);
 
     setroot (ctx, root, rootref, 0);
 
@@ -2739,7 +3063,8 @@ static void config_reload_cb (flux_t *h,
 
     if (flux_conf_reload_decode (msg, &conf) < 0)
         goto error;
-    if (kvs_checkpoint_reload (ctx->kcp, conf, &error) < 0) {
+    if (kvs_checkpoint_reload (ctx->kcp, conf, &error) < 0
+        || kvs_snapshot_config_parse (ctx->snapshot, conf, &error) < 0) {
         errstr = error.text;
         goto error;
     }
@@ -2763,6 +3088,7 @@ static const struct flux_msg_handler_spec htab[] = {
                             getroot_request_cb, FLUX_ROLE_USER },
     { FLUX_MSGTYPE_REQUEST, "kvs.dropcache",  dropcache_request_cb, 0 },
     { FLUX_MSGTYPE_EVENT,   "kvs.dropcache",  dropcache_event_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "kvs.gc-roots",   gc_roots_request_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs.disconnect", disconnect_request_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs.wait-version",
                             wait_version_request_cb, FLUX_ROLE_USER },
@@ -2797,7 +3123,10 @@ static int process_config (struct kvs_ctx *ctx)
     flux_error_t error;
     if (kvs_checkpoint_config_parse (ctx->kcp,
                                      flux_get_conf (ctx->h),
-                                     &error) < 0) {
+                                     &error) < 0
+        || kvs_snapshot_config_parse (ctx->snapshot,
+                                      flux_get_conf (ctx->h),
+                                      &error) < 0) {
         flux_log (ctx->h, LOG_ERR, "%s", error.text);
         return -1;
     }
@@ -2811,6 +3140,24 @@ static void process_args (struct kvs_ctx *ctx, int ac, char **av)
     for (i = 0; i < ac; i++) {
         if (strncmp (av[i], "transaction-merge=", 13) == 0)
             ctx->transaction_merge = strtoul (av[i]+13, NULL, 10);
+        else if (strncmp (av[i], "dir-shard-threshold=", 20) == 0)
+            ctx->dir_shard_threshold = strtoul (av[i]+20, NULL, 10);
+        else if (strncmp (av[i], "group-commit-window=", 20) == 0)
+            ctx->group_commit_window = strtod (av[i]+20, NULL);
+        else if (strncmp (av[i], "group-commit-count=", 19) == 0)
+            ctx->group_commit_count = strtoul (av[i]+19, NULL, 10);
+        else if (strncmp (av[i], "replica=", 8) == 0) {
+            if (!ctx->replica
+                && !(ctx->replica = kvs_replica_create (ctx->h,
+                                                        ctx->cache,
+                                                        replica_load_cb,
+                                                        ctx))) {
+                flux_log_error (ctx->h, "kvs_replica_create");
+                continue;
+            }
+            if (kvs_replica_add_prefix (ctx->replica, av[i]+8) < 0)
+                flux_log_error (ctx->h, "replica=%s", av[i]+8);
+        }
         else
             flux_log (ctx->h, LOG_ERR, "Unknown option `%s'", av[i]);
     }
@@ -2998,6 +3345,7 @@ int mod_main (flux_t *h, int argc, char **argv)
                 flux_log_error (h, "kvsroot_mgr_create_root");
                 goto done;
             }
+            root_configure (ctx, root);
         }
 
         setroot (ctx, root, rootref, seq);
@@ -3008,6 +3356,12 @@ int mod_main (flux_t *h, int argc, char **argv)
         }
 
         kvs_checkpoint_update_root_primary (ctx->kcp, root);
+
+        /* Pre-load the working set saved at the last shutdown, if any,
+         * while requests are being handled.
+         */
+        if (kvs_snapshot_warm (ctx->snapshot) < 0)
+            flux_log_error (h, "error loading KVS snapshot");
     }
     if (flux_msg_handler_addvec (h, htab, ctx, &handlers) < 0) {
         flux_log_error (h, "flux_msg_handler_addvec");
@@ -3043,6 +3397,16 @@ int mod_main (flux_t *h, int argc, char **argv)
                 goto done;
             }
         }
+        if (kvs_snapshot_enabled (ctx->snapshot)) {
+            flux_future_t *f;
+
+            if (!(f = kvs_snapshot_save (ctx->snapshot, root->ref, root->seq))
+                || flux_future_get (f, NULL) < 0) {
+                if (errno != ENOSYS)
+                    flux_log_error (h, "error saving KVS snapshot");
+            }
+            flux_future_destroy (f);
+        }
     }
     rc = 0;
 done:
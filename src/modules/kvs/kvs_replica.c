@@ -0,0 +1,689 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "src/common/libczmqcontainers/czmq_containers.h"
+#include "src/common/libkvs/treeobj.h"
+#include "src/common/libkvs/kvs_util_private.h"
+
+#include "kvs_replica.h"
+
+/* An object to be loaded.  Items with a 'path' are on the key path
+ * leading to a replicated prefix, and are pinned for one walk only.
+ * Items without one are the first load of an object in kr->pins.
+ */
+struct replica_item {
+    kvs_replica_t *kr;
+    char *ref;
+    char *path;
+    int level;              /* hamt nesting level of 'ref' */
+    int errnum;             /* load error */
+    void *handle;           /* in kr->waiting */
+};
+
+/* An object in a replicated subtree.  Since blobrefs are immutable,
+ * an object's children never change, so each pin is loaded and its
+ * children are pinned exactly once, no matter how many roots share it.
+ * 'refs' counts the pinned parents and walk roots that refer to it.
+ */
+struct replica_pin {
+    struct cache_entry *entry;  /* NULL until loaded */
+    int refs;
+    bool raw;               /* 'ref' is value data, not a treeobj */
+    bool failed;            /* load failed, retry on next reference */
+};
+
+typedef int (*replica_ref_f)(kvs_replica_t *kr, const char *ref, bool raw);
+
+struct kvs_replica {
+    flux_t *h;
+    struct cache *cache;
+    kvs_replica_load_f load;
+    void *load_arg;
+    zlist_t *prefixes;
+    char *root_ref;         /* most recent root */
+    char *walk_ref;         /* root of current or last walk */
+    zlist_t *queue;         /* items ready to be processed */
+    zlistx_t *waiting;      /* items waiting for a load */
+    int outstanding;        /* loads in progress */
+    zhashx_t *pins;         /* ref => struct replica_pin */
+    int pins_loaded;        /* pins with a cache entry */
+    zlist_t *roots;         /* subtree roots held by last complete walk */
+    zlist_t *walk_roots;    /* subtree roots held by walk in progress */
+    zhashx_t *spine;        /* path objects of last complete walk */
+    zhashx_t *walk_spine;   /* path objects of walk in progress */
+    bool walking;           /* walk in progress */
+    double walk_start;
+    int walks;
+    int errors;
+    double last_walk_time;
+};
+
+static void replica_item_destroy (struct replica_item *item)
+{
+    if (item) {
+        int saved_errno = errno;
+        free (item->ref);
+        free (item->path);
+        free (item);
+        errno = saved_errno;
+    }
+}
+
+static void replica_item_destructor (void **item)
+{
+    if (item) {
+        replica_item_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static int replica_push (kvs_replica_t *kr,
+                         const char *ref,
+                         const char *path,
+                         int level)
+{
+    struct replica_item *item;
+
+    if (!(item = calloc (1, sizeof (*item))))
+        return -1;
+    item->kr = kr;
+    item->level = level;
+    if (!(item->ref = strdup (ref))
+        || (path && !(item->path = strdup (path))))
+        goto error;
+    if (zlist_append (kr->queue, item) < 0) {
+        errno = ENOMEM;
+        goto error;
+    }
+    return 0;
+error:
+    replica_item_destroy (item);
+    return -1;
+}
+
+static void replica_pin_destructor (void **item)
+{
+    if (item) {
+        struct replica_pin *pin = *item;
+        if (pin) {
+            cache_entry_decref (pin->entry);
+            free (pin);
+        }
+        *item = NULL;
+    }
+}
+
+static void entry_decref (void **item)
+{
+    if (item) {
+        cache_entry_decref (*item);
+        *item = NULL;
+    }
+}
+
+static zhashx_t *spine_create (void)
+{
+    zhashx_t *zh;
+
+    if (!(zh = zhashx_new ())) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    zhashx_set_destructor (zh, entry_decref);
+    return zh;
+}
+
+static void replica_process (kvs_replica_t *kr);
+
+static void replica_wait_error_cb (wait_t *w, int errnum, void *arg)
+{
+    struct replica_item *item = arg;
+    item->errnum = errnum;
+}
+
+static void replica_wait_cb (void *arg)
+{
+    struct replica_item *item = arg;
+    kvs_replica_t *kr = item->kr;
+
+    zlistx_detach (kr->waiting, item->handle);
+    kr->outstanding--;
+    if (item->errnum) {
+        struct replica_pin *pin;
+
+        flux_log (kr->h,
+                  LOG_ERR,
+                  "replica: load %s: %s",
+                  item->ref,
+                  strerror (item->errnum));
+        kr->errors++;
+        if (!item->path && (pin = zhashx_lookup (kr->pins, item->ref)))
+            pin->failed = true;
+        replica_item_destroy (item);
+    }
+    else if (zlist_push (kr->queue, item) < 0) {
+        kr->errors++;
+        replica_item_destroy (item);
+    }
+    replica_process (kr);
+}
+
+/* Arrange for 'item' to be processed again once 'ref' is loaded.
+ * Return 0 if waiting, 1 if 'ref' is already loaded, or -1 on error.
+ */
+static int replica_wait (kvs_replica_t *kr,
+                         struct replica_item *item,
+                         struct cache_entry *entry)
+{
+    wait_t *wait;
+
+    if (!entry) {
+        if (kr->load (item->ref, kr->load_arg) < 0)
+            return -1;
+        if (!(entry = cache_lookup (kr->cache, item->ref))) {
+            errno = ENOENT;
+            return -1;
+        }
+        if (cache_entry_get_valid (entry))
+            return 1;
+    }
+    if (!(wait = wait_create (replica_wait_cb, item)))
+        return -1;
+    if (wait_set_error_cb (wait, replica_wait_error_cb, item) < 0
+        || !(item->handle = zlistx_add_end (kr->waiting, item))) {
+        wait_destroy (wait);
+        errno = ENOMEM;
+        return -1;
+    }
+    if (cache_entry_wait_valid (entry, wait) < 0) {
+        zlistx_detach (kr->waiting, item->handle);
+        wait_destroy (wait);
+        return -1;
+    }
+    kr->outstanding++;
+    return 0;
+}
+
+/* Call 'fn' for each object referenced by 'dirent'.
+ * N.B. symlinks are not followed.
+ */
+static int foreach_dirent_ref (kvs_replica_t *kr,
+                               const json_t *dirent,
+                               replica_ref_f fn)
+{
+    const char *ref;
+    int count;
+    int i;
+
+    if (treeobj_is_dirref (dirent)) {
+        if (!(ref = treeobj_get_blobref (dirent, 0))
+            || fn (kr, ref, false) < 0)
+            return -1;
+    }
+    else if (treeobj_is_valref (dirent)) {
+        if ((count = treeobj_get_count (dirent)) < 0)
+            return -1;
+        for (i = 0; i < count; i++) {
+            if (!(ref = treeobj_get_blobref (dirent, i))
+                || fn (kr, ref, true) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/* Call 'fn' for each object referenced by dir or hamt 'o'.
+ */
+static int foreach_ref (kvs_replica_t *kr, const json_t *o, replica_ref_f fn)
+{
+    const char *name;
+    json_t *dirent;
+    const json_t *shard;
+    const char *ref;
+    int index;
+
+    if (treeobj_is_dir (o)) {
+        json_object_foreach (treeobj_get_data ((json_t *)o), name, dirent) {
+            if (foreach_dirent_ref (kr, dirent, fn) < 0)
+                return -1;
+        }
+        return 0;
+    }
+    if (treeobj_is_hamt (o)) {
+        for (index = 0; index < TREEOBJ_HAMT_WIDTH; index++) {
+            if ((shard = treeobj_peek_shard (o, index))
+                && treeobj_is_dirref (shard)) {
+                if (!(ref = treeobj_get_blobref (shard, 0))
+                    || fn (kr, ref, false) < 0)
+                    return -1;
+            }
+        }
+        return 0;
+    }
+    errno = EPROTO;
+    return -1;
+}
+
+/* Take a reference on the subtree rooted at 'ref'.  If it is not
+ * already pinned, queue it to be loaded and its children pinned.
+ */
+static int replica_hold (kvs_replica_t *kr, const char *ref, bool raw)
+{
+    struct replica_pin *pin;
+
+    if ((pin = zhashx_lookup (kr->pins, ref))) {
+        pin->refs++;
+        if (pin->failed) {
+            if (replica_push (kr, ref, NULL, 0) < 0)
+                return -1;
+            pin->failed = false;
+        }
+        return 0;
+    }
+    if (!(pin = calloc (1, sizeof (*pin))))
+        return -1;
+    pin->refs = 1;
+    pin->raw = raw;
+    if (zhashx_insert (kr->pins, ref, pin) < 0) {
+        free (pin);
+        errno = ENOMEM;
+        return -1;
+    }
+    if (replica_push (kr, ref, NULL, 0) < 0) {
+        zhashx_delete (kr->pins, ref);
+        return -1;
+    }
+    return 0;
+}
+
+/* Drop a reference on the subtree rooted at 'ref', unpinning objects
+ * that are no longer referenced.
+ */
+static int replica_release (kvs_replica_t *kr, const char *ref, bool raw)
+{
+    struct replica_pin *pin;
+    const json_t *o;
+
+    if (!(pin = zhashx_lookup (kr->pins, ref)) || --pin->refs > 0)
+        return 0;
+    if (pin->entry) {
+        if (!pin->raw && (o = cache_entry_get_treeobj (pin->entry)))
+            (void)foreach_ref (kr, o, replica_release);
+        kr->pins_loaded--;
+    }
+    zhashx_delete (kr->pins, ref);
+    return 0;
+}
+
+/* Hold a subtree reached at the end of a prefix for the current walk.
+ */
+static int replica_hold_root (kvs_replica_t *kr, const char *ref, bool raw)
+{
+    char *cpy;
+
+    if (!(cpy = strdup (ref)))
+        return -1;
+    if (zlist_append (kr->walk_roots, cpy) < 0) {
+        free (cpy);
+        errno = ENOMEM;
+        return -1;
+    }
+    zlist_freefn (kr->walk_roots, cpy, free, true);
+    return replica_hold (kr, ref, raw);
+}
+
+static int visit_dir (kvs_replica_t *kr,
+                      const json_t *dir,
+                      const char *path)
+{
+    json_t *dirent;
+    char *cpy;
+    char *next;
+    int rc = 0;
+
+    if (!(cpy = strdup (path)))
+        return -1;
+    if ((next = strchr (cpy, '.')))
+        *next++ = '\0';
+    if ((dirent = (json_t *)treeobj_peek_entry (dir, cpy))) {
+        if (!next)
+            rc = foreach_dirent_ref (kr, dirent, replica_hold_root);
+        else if (treeobj_is_dirref (dirent)) {
+            const char *ref;
+            if (!(ref = treeobj_get_blobref (dirent, 0))
+                || replica_push (kr, ref, next, 0) < 0)
+                rc = -1;
+        }
+    }
+    free (cpy);
+    return rc;
+}
+
+static int visit_hamt (kvs_replica_t *kr,
+                       const json_t *hamt,
+                       const char *path,
+                       int level)
+{
+    const json_t *shard;
+    const char *ref;
+    char *cpy;
+    char *next;
+    int index;
+
+    if (!(cpy = strdup (path)))
+        return -1;
+    if ((next = strchr (cpy, '.')))
+        *next = '\0';
+    index = treeobj_hamt_index (cpy, level);
+    free (cpy);
+    if (index < 0)
+        return -1;
+    if ((shard = treeobj_peek_shard (hamt, index))
+        && treeobj_is_dirref (shard)) {
+        if (!(ref = treeobj_get_blobref (shard, 0))
+            || replica_push (kr, ref, path, level + 1) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* Load the object referenced by 'item'.  Pin it for this walk and
+ * follow its key path, or if it is the first load of a subtree, pin
+ * its children.  Return 0 if done with 'item', 1 if waiting for it to
+ * be loaded, or -1 on error.
+ */
+static int replica_process_item (kvs_replica_t *kr,
+                                 struct replica_item *item)
+{
+    struct cache_entry *entry;
+    struct replica_pin *pin = NULL;
+    const json_t *o;
+    int rc;
+
+    if (!item->path) {
+        if (!(pin = zhashx_lookup (kr->pins, item->ref)) || pin->entry)
+            return 0;
+    }
+    entry = cache_lookup (kr->cache, item->ref);
+    if (!entry || !cache_entry_get_valid (entry)) {
+        if ((rc = replica_wait (kr, item, entry)) < 0)
+            return -1;
+        if (rc == 0)
+            return 1;
+        entry = cache_lookup (kr->cache, item->ref);
+    }
+    if (pin) {
+        pin->entry = entry;
+        cache_entry_incref (entry);
+        kr->pins_loaded++;
+        if (pin->raw)
+            return 0;
+    }
+    else if (!zhashx_lookup (kr->walk_spine, item->ref)) {
+        if (zhashx_insert (kr->walk_spine, item->ref, entry) < 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+        cache_entry_incref (entry);
+    }
+    if (!(o = cache_entry_get_treeobj (entry))) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (pin)
+        return foreach_ref (kr, o, replica_hold);
+    if (treeobj_is_hamt (o))
+        return visit_hamt (kr, o, item->path, item->level);
+    if (treeobj_is_dir (o))
+        return visit_dir (kr, o, item->path);
+    errno = EPROTO;
+    return -1;
+}
+
+static int replica_walk_start (kvs_replica_t *kr)
+{
+    char *prefix;
+    char *cpy;
+
+    if (!(cpy = strdup (kr->root_ref)))
+        return -1;
+    free (kr->walk_ref);
+    kr->walk_ref = cpy;
+    kr->walking = true;
+    if (kr->h)
+        kr->walk_start = flux_reactor_now (flux_get_reactor (kr->h));
+
+    prefix = zlist_first (kr->prefixes);
+    while (prefix) {
+        if (!strcmp (prefix, ".")) {
+            if (replica_hold_root (kr, kr->walk_ref, false) < 0)
+                return -1;
+        }
+        else if (replica_push (kr, kr->walk_ref, prefix, 0) < 0)
+            return -1;
+        prefix = zlist_next (kr->prefixes);
+    }
+    return 0;
+}
+
+/* Release the subtrees held by the previous walk.  Subtrees shared with
+ * the new root were referenced again by this walk, so remain pinned.
+ */
+static void replica_walk_complete (kvs_replica_t *kr)
+{
+    zlist_t *tmp;
+    zhashx_t *tmp_spine;
+    char *ref;
+
+    while ((ref = zlist_pop (kr->roots))) {
+        (void)replica_release (kr, ref, false);
+        free (ref);
+    }
+    tmp = kr->roots;
+    kr->roots = kr->walk_roots;
+    kr->walk_roots = tmp;
+
+    tmp_spine = kr->spine;
+    kr->spine = kr->walk_spine;
+    kr->walk_spine = tmp_spine;
+    zhashx_purge (kr->walk_spine);
+
+    kr->walking = false;
+    kr->walks++;
+    if (kr->h) {
+        kr->last_walk_time = flux_reactor_now (flux_get_reactor (kr->h))
+                             - kr->walk_start;
+    }
+}
+
+/* Process queued items.  When a walk completes and the root has changed
+ * since it started, walk the most recent root.
+ */
+static void replica_process (kvs_replica_t *kr)
+{
+    struct replica_item *item;
+    int rc;
+
+    for (;;) {
+        while ((item = zlist_pop (kr->queue))) {
+            if ((rc = replica_process_item (kr, item)) < 0) {
+                flux_log_error (kr->h, "replica: %s", item->ref);
+                kr->errors++;
+            }
+            if (rc != 1)
+                replica_item_destroy (item);
+        }
+        if (!kr->walking || kr->outstanding > 0)
+            break;
+        replica_walk_complete (kr);
+        if (!strcmp (kr->walk_ref, kr->root_ref))
+            break;
+        if (replica_walk_start (kr) < 0) {
+            flux_log_error (kr->h, "replica: %s", kr->root_ref);
+            kr->errors++;
+        }
+    }
+}
+
+int kvs_replica_update (kvs_replica_t *kr, const char *root_ref)
+{
+    char *cpy;
+    int rc;
+
+    if (!kr || !root_ref) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (kr->root_ref && !strcmp (kr->root_ref, root_ref))
+        return 0;
+    if (!(cpy = strdup (root_ref)))
+        return -1;
+    free (kr->root_ref);
+    kr->root_ref = cpy;
+
+    /* A walk in progress is retargeted to the new root when it completes.
+     */
+    if (kr->walking)
+        return 0;
+    rc = replica_walk_start (kr);
+    replica_process (kr);
+    return rc;
+}
+
+int kvs_replica_add_prefix (kvs_replica_t *kr, const char *prefix)
+{
+    char *key;
+
+    if (!kr || !prefix) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(key = kvs_util_normalize_key (prefix, NULL)))
+        return -1;
+    if (zlist_append (kr->prefixes, key) < 0) {
+        free (key);
+        errno = ENOMEM;
+        return -1;
+    }
+    zlist_freefn (kr->prefixes, key, free, true);
+    return 0;
+}
+
+/* Count pinned objects, including path objects that are not also
+ * part of a replicated subtree.
+ */
+static int replica_count_pinned (kvs_replica_t *kr)
+{
+    int count = kr->pins_loaded;
+    void *entry;
+
+    entry = zhashx_first (kr->spine);
+    while (entry) {
+        if (!zhashx_lookup (kr->pins, zhashx_cursor (kr->spine)))
+            count++;
+        entry = zhashx_next (kr->spine);
+    }
+    return count;
+}
+
+json_t *kvs_replica_get_stats (kvs_replica_t *kr)
+{
+    json_t *o;
+
+    if (!kr) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(o = json_pack ("{s:i s:i s:i s:i s:f}",
+                         "#prefixes", (int)zlist_size (kr->prefixes),
+                         "#pinned", replica_count_pinned (kr),
+                         "#walks", kr->walks,
+                         "#errors", kr->errors,
+                         "last walk time (sec)", kr->last_walk_time))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
+void kvs_replica_destroy (kvs_replica_t *kr)
+{
+    if (kr) {
+        int saved_errno = errno;
+        zlist_destroy (&kr->prefixes);
+        if (kr->queue) {
+            struct replica_item *item;
+            while ((item = zlist_pop (kr->queue)))
+                replica_item_destroy (item);
+            zlist_destroy (&kr->queue);
+        }
+        /* N.B. waits are destroyed with the cache, without callbacks */
+        zlistx_destroy (&kr->waiting);
+        zlist_destroy (&kr->roots);
+        zlist_destroy (&kr->walk_roots);
+        zhashx_destroy (&kr->pins);
+        zhashx_destroy (&kr->spine);
+        zhashx_destroy (&kr->walk_spine);
+        free (kr->root_ref);
+        free (kr->walk_ref);
+        free (kr);
+        errno = saved_errno;
+    }
+}
+
+kvs_replica_t *kvs_replica_create (flux_t *h,
+                                   struct cache *cache,
+                                   kvs_replica_load_f load,
+                                   void *arg)
+{
+    kvs_replica_t *kr;
+
+    if (!cache || !load) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(kr = calloc (1, sizeof (*kr))))
+        return NULL;
+    kr->h = h;
+    kr->cache = cache;
+    kr->load = load;
+    kr->load_arg = arg;
+    if (!(kr->prefixes = zlist_new ())
+        || !(kr->queue = zlist_new ())
+        || !(kr->waiting = zlistx_new ())
+        || !(kr->roots = zlist_new ())
+        || !(kr->walk_roots = zlist_new ())
+        || !(kr->pins = zhashx_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zlistx_set_destructor (kr->waiting, replica_item_destructor);
+    zhashx_set_destructor (kr->pins, replica_pin_destructor);
+    if (!(kr->spine = spine_create ())
+        || !(kr->walk_spine = spine_create ()))
+        goto error;
+    return kr;
+error:
+    kvs_replica_destroy (kr);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,66 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_KVS_REPLICA_H
+#define _FLUX_KVS_REPLICA_H
+
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "cache.h"
+
+/* kvs_replica keeps a local copy of selected parts of the primary
+ * namespace in the KVS cache.  Each time the root changes, all objects
+ * reachable from the new root under the configured key prefixes are
+ * loaded and pinned, so that lookups of those keys are served without
+ * faulting objects from upstream.  Subtrees already pinned for an
+ * earlier root are not walked again, so each walk only loads what
+ * changed.  Objects of the previous root remain pinned until the walk
+ * of the new root is complete.
+ *
+ * Lookups are unaffected: they still use the current root and the
+ * normal fault path, so version semantics are unchanged.
+ */
+
+typedef struct kvs_replica kvs_replica_t;
+
+/* Start loading 'ref' into 'cache', e.g. by inserting an incomplete
+ * cache entry and sending a content load request.
+ * Return 0 on success, -1 on error.
+ */
+typedef int (*kvs_replica_load_f)(const char *ref, void *arg);
+
+kvs_replica_t *kvs_replica_create (flux_t *h,
+                                   struct cache *cache,
+                                   kvs_replica_load_f load,
+                                   void *arg);
+
+/* Release pinned objects.  Must be called before the cache is destroyed.
+ */
+void kvs_replica_destroy (kvs_replica_t *kr);
+
+/* Replicate keys under 'prefix' ("." for the whole namespace).
+ */
+int kvs_replica_add_prefix (kvs_replica_t *kr, const char *prefix);
+
+/* Start replicating a new root.  If a walk of an older root is still
+ * in progress, it runs to completion, then the most recent root is walked.
+ */
+int kvs_replica_update (kvs_replica_t *kr, const char *root_ref);
+
+/* Return stats object for kvs.stats-get.
+ */
+json_t *kvs_replica_get_stats (kvs_replica_t *kr);
+
+#endif /* !_FLUX_KVS_REPLICA_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
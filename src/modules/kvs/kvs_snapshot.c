@@ -0,0 +1,540 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "src/common/libczmqcontainers/czmq_containers.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/errprintf.h"
+#include "src/common/libutil/errno_safe.h"
+#include "src/common/libcontent/content.h"
+
+#include "kvs_snapshot.h"
+
+/* Number of objects requested per content.load-batch RPC, and the
+ * number of those RPCs kept in flight while warming the cache.
+ */
+static const int warm_batch_size = 1024;
+static const int warm_batch_depth = 4;
+
+struct kvs_snapshot {
+    flux_t *h;
+    struct cache *cache;
+    const char *hash_name;
+    int hash_size;
+    int max_objects;            /* 0 = disabled */
+    kvs_snapshot_warm_f warm_cb;
+    void *warm_arg;
+    flux_future_t *f_update;    /* kvs_snapshot_update() in progress */
+    int saves;
+    int save_objects;           /* objects in last saved snapshot */
+
+    flux_future_t *f_warm;      /* checkpoint-get, then snapshot load */
+    zlistx_t *batches;          /* content.load-batch RPCs in flight */
+    char *hashes;
+    int count;
+    int next;
+    double warm_start;
+    int warm_loaded;
+    int warm_errors;
+    double warm_time;
+};
+
+struct snapshot_entry {
+    double lastuse;
+    const char *ref;
+};
+
+struct collect {
+    struct snapshot_entry *entries;
+    int count;
+    int size;
+};
+
+struct save_context {
+    char *rootref;
+    int rootseq;
+    int count;
+};
+
+static void save_context_destroy (struct save_context *sc)
+{
+    if (sc) {
+        int saved_errno = errno;
+        free (sc->rootref);
+        free (sc);
+        errno = saved_errno;
+    }
+}
+
+static int collect_cb (struct cache_entry *entry, void *arg)
+{
+    struct collect *c = arg;
+
+    if (c->count == c->size)
+        return -1;
+    c->entries[c->count].lastuse = cache_entry_get_lastuse (entry);
+    c->entries[c->count].ref = cache_entry_get_blobref (entry);
+    c->count++;
+    return 0;
+}
+
+/* Most recently used first.
+ */
+static int lastuse_cmp (const void *a, const void *b)
+{
+    const struct snapshot_entry *e1 = a;
+    const struct snapshot_entry *e2 = b;
+
+    if (e1->lastuse > e2->lastuse)
+        return -1;
+    if (e1->lastuse < e2->lastuse)
+        return 1;
+    return 0;
+}
+
+/* Build the snapshot blob from cache contents.
+ * The number of digests is placed in 'countp'.
+ */
+static char *snapshot_encode (kvs_snapshot_t *ks, int *countp)
+{
+    struct collect c = { 0 };
+    char *hashes = NULL;
+    int count = 0;
+    int i;
+
+    c.size = cache_count_entries (ks->cache);
+    if (!(c.entries = calloc (c.size + 1, sizeof (c.entries[0]))))
+        return NULL;
+    (void)cache_foreach_valid (ks->cache, collect_cb, &c);
+    qsort (c.entries, c.count, sizeof (c.entries[0]), lastuse_cmp);
+    if (c.count > ks->max_objects)
+        c.count = ks->max_objects;
+    if (!(hashes = malloc ((c.count + 1) * ks->hash_size)))
+        goto done;
+    for (i = 0; i < c.count; i++) {
+        if (blobref_strtohash (c.entries[i].ref,
+                               hashes + count * ks->hash_size,
+                               ks->hash_size) != ks->hash_size)
+            continue;
+        count++;
+    }
+    *countp = count;
+done:
+    free (c.entries);
+    return hashes;
+}
+
+/* The snapshot blob has been stored.  Write the snapshot checkpoint.
+ */
+static void save_store_continuation (flux_future_t *f, void *arg)
+{
+    kvs_snapshot_t *ks = arg;
+    struct save_context *sc = flux_future_aux_get (f, "kvs_snapshot::save");
+    const char *ref;
+    flux_future_t *f2;
+
+    if (content_store_get_blobref (f, &ref) < 0)
+        goto error;
+    if (!(f2 = flux_rpc_pack (ks->h,
+                              "content.checkpoint-put",
+                              0,
+                              0,
+                              "{s:s s:{s:i s:s s:s s:s s:i s:i s:f}}",
+                              "key", KVS_SNAPSHOT_CHECKPOINT,
+                              "value",
+                                "version", 1,
+                                "snapshotref", ref,
+                                "hash", ks->hash_name,
+                                "rootref", sc->rootref,
+                                "sequence", sc->rootseq,
+                                "count", sc->count,
+                                "timestamp", flux_reactor_now (
+                                                flux_get_reactor (ks->h)))))
+        goto error;
+    if (flux_future_continue (f, f2) < 0) {
+        flux_future_destroy (f2);
+        goto error;
+    }
+    ks->saves++;
+    ks->save_objects = sc->count;
+    goto done;
+error:
+    flux_future_continue_error (f, errno, NULL);
+done:
+    flux_future_destroy (f);
+}
+
+flux_future_t *kvs_snapshot_save (kvs_snapshot_t *ks,
+                                  const char *rootref,
+                                  int rootseq)
+{
+    struct save_context *sc;
+    char *hashes = NULL;
+    flux_future_t *f1 = NULL;
+    flux_future_t *f2;
+
+    if (!ks || !rootref) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(sc = calloc (1, sizeof (*sc))))
+        return NULL;
+    if (!(sc->rootref = strdup (rootref))
+        || !(hashes = snapshot_encode (ks, &sc->count))
+        || !(f1 = content_store (ks->h,
+                                 hashes,
+                                 sc->count * ks->hash_size,
+                                 0))) {
+        save_context_destroy (sc);
+        goto error;
+    }
+    sc->rootseq = rootseq;
+    if (flux_future_aux_set (f1,
+                             "kvs_snapshot::save",
+                             sc,
+                             (flux_free_f)save_context_destroy) < 0) {
+        save_context_destroy (sc);
+        goto error;
+    }
+    if (!(f2 = flux_future_and_then (f1, save_store_continuation, ks)))
+        goto error;
+    free (hashes);
+    return f2;
+error:
+    flux_future_destroy (f1);
+    ERRNO_SAFE_WRAP (free, hashes);
+    return NULL;
+}
+
+static void update_continuation (flux_future_t *f, void *arg)
+{
+    kvs_snapshot_t *ks = arg;
+
+    if (flux_future_get (f, NULL) < 0)
+        flux_log_error (ks->h, "error saving KVS snapshot");
+    flux_future_destroy (f);
+    ks->f_update = NULL;
+}
+
+void kvs_snapshot_update (kvs_snapshot_t *ks,
+                          const char *rootref,
+                          int rootseq)
+{
+    flux_future_t *f;
+
+    if (!kvs_snapshot_enabled (ks) || ks->f_update)
+        return;
+    if (!(f = kvs_snapshot_save (ks, rootref, rootseq))
+        || flux_future_then (f, -1., update_continuation, ks) < 0) {
+        flux_log_error (ks->h, "error saving KVS snapshot");
+        flux_future_destroy (f);
+        return;
+    }
+    ks->f_update = f;
+}
+
+static void warm_finish (kvs_snapshot_t *ks)
+{
+    ks->warm_time = flux_reactor_now (flux_get_reactor (ks->h))
+                    - ks->warm_start;
+    flux_log (ks->h,
+              LOG_INFO,
+              "loaded %d/%d objects from KVS snapshot in %.3fs",
+              ks->warm_loaded,
+              ks->count,
+              ks->warm_time);
+    free (ks->hashes);
+    ks->hashes = NULL;
+}
+
+static void warm_batch_continuation (flux_future_t *f, void *arg);
+
+/* Keep up to warm_batch_depth load-batch RPCs in flight.
+ */
+static int warm_send (kvs_snapshot_t *ks)
+{
+    while (zlistx_size (ks->batches) < warm_batch_depth
+           && ks->next < ks->count) {
+        int n = ks->count - ks->next;
+        int *first;
+        flux_future_t *f;
+
+        if (n > warm_batch_size)
+            n = warm_batch_size;
+        if (!(f = content_load_batch (ks->h,
+                                      ks->hashes + ks->next * ks->hash_size,
+                                      ks->hash_size,
+                                      n,
+                                      0)))
+            return -1;
+        if (!(first = malloc (sizeof (*first)))
+            || flux_future_aux_set (f, "kvs_snapshot::first", first, free) < 0) {
+            ERRNO_SAFE_WRAP (free, first);
+            flux_future_destroy (f);
+            return -1;
+        }
+        *first = ks->next;
+        if (flux_future_then (f, -1., warm_batch_continuation, ks) < 0
+            || !zlistx_add_end (ks->batches, f)) {
+            flux_future_destroy (f);
+            errno = ENOMEM;
+            return -1;
+        }
+        ks->next += n;
+    }
+    if (zlistx_size (ks->batches) == 0 && ks->hashes)
+        warm_finish (ks);
+    return 0;
+}
+
+static void warm_batch_continuation (flux_future_t *f, void *arg)
+{
+    kvs_snapshot_t *ks = arg;
+    int *first = flux_future_aux_get (f, "kvs_snapshot::first");
+    int n = ks->count - *first;
+    int i;
+
+    if (n > warm_batch_size)
+        n = warm_batch_size;
+    for (i = 0; i < n; i++) {
+        char ref[BLOBREF_MAX_STRING_SIZE];
+        const void *data;
+        int len;
+
+        if (content_load_batch_get (f, i, &data, &len, NULL) < 0
+            || blobref_hashtostr (ks->hash_name,
+                                  ks->hashes + (*first + i) * ks->hash_size,
+                                  ks->hash_size,
+                                  ref,
+                                  sizeof (ref)) < 0) {
+            ks->warm_errors++;
+            continue;
+        }
+        ks->warm_cb (ref, data, len, ks->warm_arg);
+        ks->warm_loaded++;
+    }
+    zlistx_delete (ks->batches, zlistx_find (ks->batches, f));
+    if (warm_send (ks) < 0) {
+        flux_log_error (ks->h, "error loading KVS snapshot");
+        ks->next = ks->count;
+        if (zlistx_size (ks->batches) == 0)
+            warm_finish (ks);
+    }
+}
+
+/* The snapshot blob has been loaded.  Start loading its objects.
+ */
+static void warm_load_continuation (flux_future_t *f, void *arg)
+{
+    kvs_snapshot_t *ks = arg;
+    const void *buf;
+    int len;
+
+    if (content_load_get (f, &buf, &len) < 0) {
+        flux_log_error (ks->h, "error loading KVS snapshot");
+        goto done;
+    }
+    if (len % ks->hash_size != 0) {
+        flux_log (ks->h, LOG_ERR, "KVS snapshot has invalid size");
+        goto done;
+    }
+    if (!(ks->hashes = malloc (len + 1))) {
+        flux_log_error (ks->h, "error loading KVS snapshot");
+        goto done;
+    }
+    memcpy (ks->hashes, buf, len);
+    ks->count = len / ks->hash_size;
+    ks->next = 0;
+    if (warm_send (ks) < 0) {
+        flux_log_error (ks->h, "error loading KVS snapshot");
+        ks->next = ks->count;
+        if (zlistx_size (ks->batches) == 0)
+            warm_finish (ks);
+    }
+done:
+    flux_future_destroy (f);
+    ks->f_warm = NULL;
+}
+
+static void warm_checkpoint_continuation (flux_future_t *f, void *arg)
+{
+    kvs_snapshot_t *ks = arg;
+    const char *ref;
+    const char *hash_name;
+    int version;
+
+    if (flux_rpc_get_unpack (f,
+                             "{s:{s:i s:s s:s}}",
+                             "value",
+                               "version", &version,
+                               "snapshotref", &ref,
+                               "hash", &hash_name) < 0) {
+        if (errno != ENOENT)
+            flux_log_error (ks->h, "error getting KVS snapshot checkpoint");
+        goto error;
+    }
+    if (version != 1 || strcmp (hash_name, ks->hash_name) != 0) {
+        flux_log (ks->h, LOG_INFO, "ignoring incompatible KVS snapshot");
+        goto error;
+    }
+    ks->f_warm = NULL;
+    if (!(ks->f_warm = content_load_byblobref (ks->h, ref, 0))
+        || flux_future_then (ks->f_warm,
+                             -1.,
+                             warm_load_continuation,
+                             ks) < 0) {
+        flux_log_error (ks->h, "error loading KVS snapshot");
+        flux_future_destroy (ks->f_warm);
+        goto error;
+    }
+    flux_future_destroy (f);
+    return;
+error:
+    flux_future_destroy (f);
+    ks->f_warm = NULL;
+}
+
+int kvs_snapshot_warm (kvs_snapshot_t *ks)
+{
+    if (!kvs_snapshot_enabled (ks))
+        return 0;
+    if (ks->f_warm || ks->hashes) {
+        errno = EBUSY;
+        return -1;
+    }
+    ks->warm_start = flux_reactor_now (flux_get_reactor (ks->h));
+    if (!(ks->f_warm = flux_rpc_pack (ks->h,
+                                      "content.checkpoint-get",
+                                      0,
+                                      0,
+                                      "{s:s}",
+                                      "key", KVS_SNAPSHOT_CHECKPOINT))
+        || flux_future_then (ks->f_warm,
+                             -1.,
+                             warm_checkpoint_continuation,
+                             ks) < 0) {
+        flux_future_destroy (ks->f_warm);
+        ks->f_warm = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int kvs_snapshot_config_parse (kvs_snapshot_t *ks,
+                               const flux_conf_t *conf,
+                               flux_error_t *errp)
+{
+    if (ks) {
+        flux_error_t error;
+        int max_objects = ks->max_objects;
+
+        if (flux_conf_unpack (conf,
+                              &error,
+                              "{s?{s?i}}",
+                              "kvs",
+                                "snapshot-objects", &max_objects) < 0) {
+            errprintf (errp,
+                       "error reading config for kvs: %s",
+                       error.text);
+            return -1;
+        }
+        if (max_objects < 0) {
+            errprintf (errp,
+                       "invalid snapshot-objects config: %d",
+                       max_objects);
+            return -1;
+        }
+        ks->max_objects = max_objects;
+    }
+    return 0;
+}
+
+bool kvs_snapshot_enabled (kvs_snapshot_t *ks)
+{
+    return (ks && ks->max_objects > 0);
+}
+
+json_t *kvs_snapshot_get_stats (kvs_snapshot_t *ks)
+{
+    return json_pack ("{s:i s:i s:i s:i s:i s:f}",
+                      "#saves", ks->saves,
+                      "#saved objects", ks->save_objects,
+                      "#warm objects", ks->count,
+                      "#warm loaded", ks->warm_loaded,
+                      "#warm errors", ks->warm_errors,
+                      "warm time (sec)", ks->warm_time);
+}
+
+static void future_destructor (void **item)
+{
+    if (item) {
+        flux_future_destroy (*item);
+        *item = NULL;
+    }
+}
+
+kvs_snapshot_t *kvs_snapshot_create (flux_t *h,
+                                     struct cache *cache,
+                                     const char *hash_name,
+                                     kvs_snapshot_warm_f warm_cb,
+                                     void *warm_arg)
+{
+    kvs_snapshot_t *ks;
+    ssize_t hash_size;
+
+    if (!h || !cache || !hash_name || !warm_cb) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((hash_size = blobref_validate_hashtype (hash_name)) < 0)
+        return NULL;
+    if (!(ks = calloc (1, sizeof (*ks))))
+        return NULL;
+    ks->h = h;
+    ks->cache = cache;
+    ks->hash_name = hash_name;
+    ks->hash_size = hash_size;
+    ks->warm_cb = warm_cb;
+    ks->warm_arg = warm_arg;
+    if (!(ks->batches = zlistx_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zlistx_set_destructor (ks->batches, future_destructor);
+    return ks;
+error:
+    kvs_snapshot_destroy (ks);
+    return NULL;
+}
+
+void kvs_snapshot_destroy (kvs_snapshot_t *ks)
+{
+    if (ks) {
+        int saved_errno = errno;
+        flux_future_destroy (ks->f_update);
+        flux_future_destroy (ks->f_warm);
+        zlistx_destroy (&ks->batches);
+        free (ks->hashes);
+        free (ks);
+        errno = saved_errno;
+    }
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,90 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_KVS_SNAPSHOT_H
+#define _FLUX_KVS_SNAPSHOT_H
+
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "cache.h"
+
+/* kvs_snapshot records the KVS working set alongside the checkpoint,
+ * so that after a restart it can be loaded back in a few large
+ * content.load-batch requests instead of being faulted in one object
+ * at a time.
+ *
+ * A snapshot is a content blob holding the concatenated hash digests
+ * of up to 'snapshot-objects' valid cache entries, most recently used
+ * first.  Objects pinned by replica mode are valid cache entries, so
+ * e.g. replica=job places job directories and eventlogs in the
+ * snapshot.  The blob is referenced from the "kvs-snapshot" checkpoint.
+ *
+ * The [kvs] snapshot-objects configuration sets the maximum number of
+ * objects in a snapshot.  If 0 (the default), snapshots are disabled.
+ */
+
+#define KVS_SNAPSHOT_CHECKPOINT "kvs-snapshot"
+
+typedef struct kvs_snapshot kvs_snapshot_t;
+
+/* Called for each object loaded by kvs_snapshot_warm().
+ */
+typedef void (*kvs_snapshot_warm_f)(const char *ref,
+                                    const void *data,
+                                    int len,
+                                    void *arg);
+
+kvs_snapshot_t *kvs_snapshot_create (flux_t *h,
+                                     struct cache *cache,
+                                     const char *hash_name,
+                                     kvs_snapshot_warm_f warm_cb,
+                                     void *warm_arg);
+
+void kvs_snapshot_destroy (kvs_snapshot_t *ks);
+
+/* Update snapshot-objects setting from [kvs] table.
+ */
+int kvs_snapshot_config_parse (kvs_snapshot_t *ks,
+                               const flux_conf_t *conf,
+                               flux_error_t *errp);
+
+bool kvs_snapshot_enabled (kvs_snapshot_t *ks);
+
+/* Store a snapshot of the current cache contents and update the
+ * snapshot checkpoint.  'rootref' and 'rootseq' identify the root
+ * the snapshot was taken with, for information only.
+ * The future is fulfilled once the checkpoint has been written.
+ */
+flux_future_t *kvs_snapshot_save (kvs_snapshot_t *ks,
+                                  const char *rootref,
+                                  int rootseq);
+
+/* Like kvs_snapshot_save() but asynchronous, with errors logged.
+ * Does nothing if snapshots are disabled or a save is in progress.
+ */
+void kvs_snapshot_update (kvs_snapshot_t *ks,
+                          const char *rootref,
+                          int rootseq);
+
+/* Start loading objects from the last snapshot, if any, and pass
+ * each to the warm callback.  Does nothing if snapshots are disabled.
+ */
+int kvs_snapshot_warm (kvs_snapshot_t *ks);
+
+/* Return stats object for kvs.stats-get.
+ */
+json_t *kvs_snapshot_get_stats (kvs_snapshot_t *ks);
+
+#endif /* !_FLUX_KVS_SNAPSHOT_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -26,6 +26,7 @@
 #include "src/common/libccan/ccan/base64/base64.h"
 #include "src/common/libutil/macros.h"
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/tstat.h"
 #include "src/common/libkvs/treeobj.h"
 #include "src/common/libkvs/kvs_checkpoint.h"
 #include "src/common/libkvs/kvs_commit.h"
@@ -39,6 +40,18 @@ struct kvstxn_mgr {
     const char *ns_name;
     const char *hash_name;
     int noop_stores;            /* for kvs.stats-get, etc.*/
+    int shard_threshold;
+    int valref_compact_count;
+    double group_commit_window;
+    int group_commit_count;
+    unsigned int arrivals;      /* transactions added */
+    unsigned int sample_arrivals;
+    double sample_time;
+    double arrival_interval;    /* moving average, in seconds */
+    double hold_start;          /* time head was first held, or -1 */
+    int commits;                /* for kvs.stats-get, etc. */
+    int committed_transactions; /* for kvs.stats-get, etc. */
+    tstat_t hold_ts;            /* hold time (msec) */
     zlist_t *ready;
     flux_t *h;
     void *aux;
@@ -384,8 +397,130 @@ static int store_cache (kvstxn_t *kt, json_t *o,
     return -1;
 }
 
+/* Store treeobj 'o' (a dir or hamt) and return a dirref to it.
+ * Return NULL on error with errno set.
+ */
+static json_t *kvstxn_store_dirref (kvstxn_t *kt, json_t *o)
+{
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    struct cache_entry *entry;
+    int ret;
+
+    if ((ret = store_cache (kt, o, false, ref, sizeof (ref), &entry)) < 0)
+        return NULL;
+    if (ret) {
+        if (kvstxn_add_dirty_cache_entry (kt, entry) < 0)
+            return NULL;
+    }
+    return treeobj_create_dirref (ref);
+}
+
+/* Split the entries of directory 'dir' into a new hamt at nesting 'level'.
+ * 'dir' is not modified.
+ */
+static json_t *kvstxn_shard_dir (json_t *dir, int level)
+{
+    json_t *dir_data;
+    json_t *hamt;
+    json_t *shard;
+    json_t *value;
+    const char *name;
+    int saved_errno;
+
+    if (!(dir_data = treeobj_get_data (dir))
+        || !(hamt = treeobj_create_hamt ()))
+        return NULL;
+    json_object_foreach (dir_data, name, value) {
+        int index;
+
+        if ((index = treeobj_hamt_index (name, level)) < 0)
+            goto error;
+        if (!(shard = treeobj_get_shard (hamt, index))) {
+            if (!(shard = treeobj_create_dir ()))
+                goto error;
+            if (treeobj_insert_shard (hamt, index, shard) < 0) {
+                saved_errno = errno;
+                json_decref (shard);
+                errno = saved_errno;
+                goto error;
+            }
+            json_decref (shard);
+        }
+        /* entries were validated when dir was unrolled */
+        if (treeobj_insert_entry_novalidate (shard, name, value) < 0)
+            goto error;
+    }
+    return hamt;
+error:
+    saved_errno = errno;
+    json_decref (hamt);
+    errno = saved_errno;
+    return NULL;
+}
+
+static int kvstxn_unroll (kvstxn_t *kt, json_t *dir);
+
+/* Unroll hamt at nesting 'level', storing shards that were modified by
+ * this transaction and converting them to DIRREFs.  Shards that have
+ * grown beyond the threshold are split, and empty shards are removed.
+ * Return 0 on success, -1 on error
+ */
+static int kvstxn_unroll_hamt (kvstxn_t *kt, json_t *hamt, int level)
+{
+    int threshold = kt->ktm->shard_threshold;
+    int index;
+
+    for (index = 0; index < TREEOBJ_HAMT_WIDTH; index++) {
+        json_t *shard;
+        json_t *split = NULL;
+        json_t *ktmp;
+
+        if (!(shard = treeobj_get_shard (hamt, index))
+            || treeobj_is_dirref (shard))
+            continue;
+        if (treeobj_is_dir (shard)) {
+            if (kvstxn_unroll (kt, shard) < 0)
+                return -1;
+            if (threshold > 0
+                && treeobj_get_count (shard) > threshold
+                && level + 1 < TREEOBJ_HAMT_MAXLEVEL) {
+                if (!(split = kvstxn_shard_dir (shard, level + 1)))
+                    return -1;
+                shard = split;
+            }
+        }
+        if (treeobj_is_hamt (shard)) {
+            if (kvstxn_unroll_hamt (kt, shard, level + 1) < 0) {
+                json_decref (split);
+                return -1;
+            }
+        }
+        else if (!treeobj_is_dir (shard)) {
+            errno = ENOTRECOVERABLE;
+            return -1;
+        }
+        if (treeobj_get_count (shard) == 0) {
+            json_decref (split);
+            if (treeobj_delete_shard (hamt, index) < 0)
+                return -1;
+            continue;
+        }
+        ktmp = kvstxn_store_dirref (kt, shard);
+        json_decref (split);
+        if (!ktmp)
+            return -1;
+        if (treeobj_insert_shard (hamt, index, ktmp) < 0) {
+            json_decref (ktmp);
+            return -1;
+        }
+        json_decref (ktmp);
+    }
+    return 0;
+}
+
 /* Store DIRVAL objects, converting them to DIRREFs.
  * Store (large) FILEVAL objects, converting them to FILEREFs.
+ * Large DIRVAL objects are converted to hamts first.
  * Return 0 on success, -1 on error
  */
 static int kvstxn_unroll (kvstxn_t *kt, json_t *dir)
@@ -411,16 +546,33 @@ static int kvstxn_unroll (kvstxn_t *kt, json_t *dir)
     while (iter) {
         dir_entry = json_object_iter_value (iter);
         if (treeobj_is_dir (dir_entry)) {
+            json_t *hamt = NULL;
+
             if (kvstxn_unroll (kt, dir_entry) < 0) /* depth first */
                 return -1;
-            if ((ret = store_cache (kt, dir_entry,
-                                    false, ref, sizeof (ref), &entry)) < 0)
-                return -1;
-            if (ret) {
-                if (kvstxn_add_dirty_cache_entry (kt, entry) < 0)
+            if (kt->ktm->shard_threshold > 0
+                && treeobj_get_count (dir_entry) > kt->ktm->shard_threshold) {
+                if (!(hamt = kvstxn_shard_dir (dir_entry, 0)))
+                    return -1;
+                if (kvstxn_unroll_hamt (kt, hamt, 0) < 0) {
+                    json_decref (hamt);
                     return -1;
+                }
             }
-            if (!(ktmp = treeobj_create_dirref (ref)))
+            ktmp = kvstxn_store_dirref (kt, hamt ? hamt : dir_entry);
+            json_decref (hamt);
+            if (!ktmp)
+                return -1;
+            if (json_object_iter_set_new (dir, iter, ktmp) < 0) {
+                json_decref (ktmp);
+                errno = ENOMEM;
+                return -1;
+            }
+        }
+        else if (treeobj_is_hamt (dir_entry)) {
+            if (kvstxn_unroll_hamt (kt, dir_entry, 0) < 0)
+                return -1;
+            if (!(ktmp = kvstxn_store_dirref (kt, dir_entry)))
                 return -1;
             if (json_object_iter_set_new (dir, iter, ktmp) < 0) {
                 json_decref (ktmp);
@@ -478,6 +630,103 @@ static int kvstxn_val_data_to_cache (kvstxn_t *kt,
     return 0;
 }
 
+static int add_missing_ref (kvstxn_t *kt, const char *ref);
+
+/* Merge blobs 'count - 2' and 'count - 1' of 'valref' into one.
+ */
+static int kvstxn_merge_blobs (kvstxn_t *kt,
+                               json_t *valref,
+                               int count,
+                               const void *data1,
+                               int len1,
+                               const void *data2,
+                               int len2)
+{
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    json_t *val = NULL;
+    char *buf;
+    int saved_errno;
+    int rc = -1;
+
+    if (!(buf = malloc (len1 + len2 + 1)))
+        return -1;
+    memcpy (buf, data1, len1);
+    memcpy (buf + len1, data2, len2);
+    if (!(val = treeobj_create_val (buf, len1 + len2)))
+        goto done;
+    if (kvstxn_val_data_to_cache (kt, val, ref, sizeof (ref)) < 0)
+        goto done;
+    if (treeobj_truncate_blobrefs (valref, count - 2) < 0
+        || treeobj_append_blobref (valref, ref) < 0)
+        goto done;
+    rc = 0;
+done:
+    saved_errno = errno;
+    json_decref (val);
+    free (buf);
+    errno = saved_errno;
+    return rc;
+}
+
+/* Rope style compaction of a valref that is being appended to.  While
+ * the last two blobs would fit in one KVSTXN_VALREF_BLOB_MAX blob and the
+ * next-to-last blob is no more than twice the size of the last, merge
+ * them.  Blobs not in the cache are added to the missing refs list, to be
+ * loaded before the transaction is replayed.
+ */
+static int kvstxn_compact_valref (kvstxn_t *kt, json_t *valref)
+{
+    int count;
+
+    if (kt->ktm->valref_compact_count == 0)
+        return 0;
+    while ((count = treeobj_get_count (valref))
+                > kt->ktm->valref_compact_count) {
+        struct cache_entry *entry1;
+        struct cache_entry *entry2;
+        const char *ref1;
+        const char *ref2;
+        const void *data1;
+        const void *data2;
+        int len1;
+        int len2;
+
+        if (!(ref1 = treeobj_get_blobref (valref, count - 2))
+            || !(ref2 = treeobj_get_blobref (valref, count - 1)))
+            return -1;
+        entry1 = cache_lookup (kt->ktm->cache, ref1);
+        entry2 = cache_lookup (kt->ktm->cache, ref2);
+        if (!entry1 || !cache_entry_get_valid (entry1)) {
+            if (add_missing_ref (kt, ref1) < 0)
+                return -1;
+        }
+        if (!entry2 || !cache_entry_get_valid (entry2)) {
+            if (add_missing_ref (kt, ref2) < 0)
+                return -1;
+        }
+        if (!entry1 || !cache_entry_get_valid (entry1)
+            || !entry2 || !cache_entry_get_valid (entry2))
+            return 0; /* stall */
+        if (cache_entry_get_raw (entry1, &data1, &len1) < 0
+            || cache_entry_get_raw (entry2, &data2, &len2) < 0) {
+            errno = ENOTRECOVERABLE;
+            return -1;
+        }
+        if (len1 > KVSTXN_VALREF_BLOB_MAX - len2
+            || len1 > 2 * len2)
+            break;
+        if (kvstxn_merge_blobs (kt,
+                                valref,
+                                count,
+                                data1,
+                                len1,
+                                data2,
+                                len2) < 0)
+            return -1;
+    }
+    return 0;
+}
+
 static int kvstxn_append (kvstxn_t *kt, json_t *dirent,
                           json_t *dir, const char *final_name, bool *append)
 {
@@ -517,7 +766,8 @@ static int kvstxn_append (kvstxn_t *kt, json_t *dirent,
         if (!(cpy = treeobj_deep_copy (entry)))
             return -1;
 
-        if (treeobj_append_blobref (cpy, ref) < 0) {
+        if (treeobj_append_blobref (cpy, ref) < 0
+            || kvstxn_compact_valref (kt, cpy) < 0) {
             json_decref (cpy);
             return -1;
         }
@@ -579,7 +829,8 @@ static int kvstxn_append (kvstxn_t *kt, json_t *dirent,
         return -1;
     }
     else if (treeobj_is_dir (entry)
-             || treeobj_is_dirref (entry)) {
+             || treeobj_is_dirref (entry)
+             || treeobj_is_hamt (entry)) {
         errno = EISDIR;
         return -1;
     }
@@ -594,6 +845,85 @@ static int kvstxn_append (kvstxn_t *kt, json_t *dirent,
     return 0;
 }
 
+/* Find the bucket (dir) in sharded directory 'hamt' that holds 'name',
+ * copying shards from the cache into 'hamt' as they are traversed so
+ * that they may be modified.  If the bucket does not exist, create it
+ * if 'create' is true, otherwise set *bucket to NULL.  If a shard is not
+ * in the cache, set *missing_ref and set *bucket to NULL (stall).
+ * Return 0 on success, -1 on error
+ */
+static int kvstxn_resolve_shard (kvstxn_t *kt,
+                                 json_t *hamt,
+                                 const char *name,
+                                 bool create,
+                                 json_t **bucket,
+                                 const char **missing_ref)
+{
+    int level;
+
+    for (level = 0; level < TREEOBJ_HAMT_MAXLEVEL; level++) {
+        json_t *shard;
+        int index;
+
+        if ((index = treeobj_hamt_index (name, level)) < 0)
+            return -1;
+        if (!(shard = treeobj_get_shard (hamt, index))) {
+            if (errno != ENOENT)
+                return -1;
+            if (!create) {
+                *bucket = NULL;
+                return 0;
+            }
+            if (!(shard = treeobj_create_dir ()))
+                return -1;
+            if (treeobj_insert_shard (hamt, index, shard) < 0) {
+                json_decref (shard);
+                return -1;
+            }
+            json_decref (shard);
+            *bucket = shard;
+            return 0;
+        }
+        if (treeobj_is_dirref (shard)) {
+            struct cache_entry *entry;
+            const json_t *shardtmp;
+            const char *ref;
+
+            if (!(ref = treeobj_get_blobref (shard, 0)))
+                return -1;
+            if (!(entry = cache_lookup (kt->ktm->cache, ref))
+                || !cache_entry_get_valid (entry)) {
+                *missing_ref = ref;
+                *bucket = NULL;
+                return 0; /* stall */
+            }
+            if (!(shardtmp = cache_entry_get_treeobj (entry))) {
+                errno = ENOTRECOVERABLE;
+                return -1;
+            }
+            /* do not corrupt store by modifying orig. */
+            if (!(shard = treeobj_deep_copy (shardtmp)))
+                return -1;
+            if (treeobj_insert_shard (hamt, index, shard) < 0) {
+                json_decref (shard);
+                return -1;
+            }
+            json_decref (shard);
+        }
+        if (treeobj_is_dir (shard)) {
+            *bucket = shard;
+            return 0;
+        }
+        if (!treeobj_is_hamt (shard)) {
+            errno = ENOTRECOVERABLE;
+            return -1;
+        }
+        hamt = shard;
+    }
+    errno = ENOTRECOVERABLE;
+    return -1;
+}
+
 /* link (key, dirent) into directory 'dir'.
  */
 static int kvstxn_link_dirent (kvstxn_t *kt,
@@ -629,6 +959,20 @@ static int kvstxn_link_dirent (kvstxn_t *kt,
     while ((next = strchr (name, '.'))) {
         *next++ = '\0';
 
+        if (treeobj_is_hamt (dir)) {
+            if (kvstxn_resolve_shard (kt,
+                                      dir,
+                                      name,
+                                      !json_is_null (dirent),
+                                      &dir,
+                                      missing_ref) < 0) {
+                saved_errno = errno;
+                goto done;
+            }
+            if (!dir) /* stall, or deleted key doesn't exist */
+                goto success;
+        }
+
         if (!treeobj_is_dir (dir)) {
             saved_errno = ENOTRECOVERABLE;
             goto done;
@@ -648,7 +992,8 @@ static int kvstxn_link_dirent (kvstxn_t *kt,
                 goto done;
             }
             json_decref (subdir);
-        } else if (treeobj_is_dir (dir_entry)) {
+        } else if (treeobj_is_dir (dir_entry)
+                   || treeobj_is_hamt (dir_entry)) {
             subdir = dir_entry;
         } else if (treeobj_is_dirref (dir_entry)) {
             struct cache_entry *entry;
@@ -752,6 +1097,19 @@ static int kvstxn_link_dirent (kvstxn_t *kt,
     /* This is the final path component of the key.  Add/modify/delete
      * it in the directory.
      */
+    if (treeobj_is_hamt (dir)) {
+        if (kvstxn_resolve_shard (kt,
+                                  dir,
+                                  name,
+                                  !json_is_null (dirent),
+                                  &dir,
+                                  missing_ref) < 0) {
+            saved_errno = errno;
+            goto done;
+        }
+        if (!dir) /* stall, or deleted key doesn't exist */
+            goto success;
+    }
     if (!json_is_null (dirent)) {
         if (flags & FLUX_KVS_APPEND) {
             if (kvstxn_append (kt, dirent, dir, name, append) < 0) {
@@ -1241,6 +1599,12 @@ kvstxn_mgr_t *kvstxn_mgr_create (struct cache *cache,
     }
     ktm->h = h;
     ktm->aux = aux;
+    ktm->shard_threshold = KVSTXN_SHARD_THRESHOLD;
+    ktm->valref_compact_count = KVSTXN_VALREF_COMPACT_COUNT;
+    ktm->group_commit_window = KVSTXN_GROUP_COMMIT_WINDOW;
+    ktm->group_commit_count = KVSTXN_GROUP_COMMIT_COUNT;
+    ktm->sample_time = -1.;
+    ktm->hold_start = -1.;
     return ktm;
 
  error:
@@ -1287,6 +1651,7 @@ int kvstxn_mgr_add_transaction (kvstxn_mgr_t *ktm,
         return -1;
     }
     zlist_freefn (ktm->ready, kt, (zlist_free_fn *)kvstxn_destroy, true);
+    ktm->arrivals++;
 
     return 0;
 }
@@ -1319,6 +1684,11 @@ void kvstxn_mgr_remove_transaction (kvstxn_mgr_t *ktm, kvstxn_t *kt,
         if (kt->merged)
             kvstxn_is_merged = true;
 
+        if (kt->state == KVSTXN_STATE_FINISHED && !fallback) {
+            ktm->commits++;
+            ktm->committed_transactions += json_array_size (kt->names);
+        }
+
         zlist_remove (ktm->ready, kt);
 
         if (kvstxn_is_merged) {
@@ -1337,6 +1707,22 @@ void kvstxn_mgr_remove_transaction (kvstxn_mgr_t *ktm, kvstxn_t *kt,
     }
 }
 
+void kvstxn_mgr_set_shard_threshold (kvstxn_mgr_t *ktm, int threshold)
+{
+    ktm->shard_threshold = threshold > 0 ? threshold : 0;
+}
+
+void kvstxn_mgr_set_valref_compact_count (kvstxn_mgr_t *ktm, int count)
+{
+    ktm->valref_compact_count = count > 0 ? count : 0;
+}
+
+void kvstxn_mgr_set_group_commit (kvstxn_mgr_t *ktm, double window, int count)
+{
+    ktm->group_commit_window = window > 0. ? window : 0.;
+    ktm->group_commit_count = count > 1 ? count : 1;
+}
+
 int kvstxn_mgr_get_noop_stores (kvstxn_mgr_t *ktm)
 {
     return ktm->noop_stores;
@@ -1488,6 +1874,113 @@ int kvstxn_mgr_merge_ready_transactions (kvstxn_mgr_t *ktm)
     return 0;
 }
 
+/* Update the moving average of the time between transaction arrivals.
+ * Samples are capped so that the average recovers quickly after an
+ * idle period.
+ */
+static void group_commit_sample (kvstxn_mgr_t *ktm, double now)
+{
+    unsigned int n = ktm->arrivals - ktm->sample_arrivals;
+    double interval;
+    double max_interval = 4 * ktm->group_commit_window;
+
+    if (ktm->sample_time < 0.) {
+        ktm->sample_time = now;
+        ktm->sample_arrivals = ktm->arrivals;
+        return;
+    }
+    if (n == 0 || now <= ktm->sample_time)
+        return;
+    interval = (now - ktm->sample_time) / n;
+    if (interval > max_interval)
+        interval = max_interval;
+    if (ktm->arrival_interval > 0.)
+        ktm->arrival_interval = 0.75 * ktm->arrival_interval + 0.25 * interval;
+    else
+        ktm->arrival_interval = interval;
+    ktm->sample_time = now;
+    ktm->sample_arrivals = ktm->arrivals;
+}
+
+static bool group_commit_holdable (kvstxn_t *kt)
+{
+    if (!kt
+        || kt->processing
+        || kt->blocked
+        || kt->merged
+        || kt->errnum != 0
+        || kt->aux_errnum != 0
+        || kt->state != KVSTXN_STATE_INIT
+        || kvstxn_no_merge (kt))
+        return false;
+    return true;
+}
+
+double kvstxn_mgr_group_commit_hold (kvstxn_mgr_t *ktm, double now)
+{
+    int count = zlist_size (ktm->ready);
+    double window;
+    double remaining;
+
+    group_commit_sample (ktm, now);
+
+    if (ktm->group_commit_window == 0.
+        || count >= ktm->group_commit_count
+        || !group_commit_holdable (zlist_first (ktm->ready)))
+        goto proceed;
+
+    /* If transactions are not arriving faster than the window, holding
+     * would only add latency.  Otherwise hold no longer than it should
+     * take for the count limit to be reached.
+     */
+    if (ktm->arrival_interval == 0.
+        || ktm->arrival_interval >= ktm->group_commit_window)
+        goto proceed;
+    window = ktm->arrival_interval * (ktm->group_commit_count - 1);
+    if (window > ktm->group_commit_window)
+        window = ktm->group_commit_window;
+
+    if (ktm->hold_start < 0.)
+        ktm->hold_start = now;
+    remaining = ktm->hold_start + window - now;
+    if (remaining > 0.)
+        return remaining;
+proceed:
+    if (ktm->hold_start >= 0.) {
+        tstat_push (&ktm->hold_ts, (now - ktm->hold_start) * 1000);
+        ktm->hold_start = -1.;
+    }
+    return 0.;
+}
+
+json_t *kvstxn_mgr_get_group_commit_stats (kvstxn_mgr_t *ktm)
+{
+    json_t *o;
+
+    if (!(o = json_pack ("{s:i s:i s:f s:{s:i s:f s:f s:f s:f}}",
+                         "#commits", ktm->commits,
+                         "#transactions", ktm->committed_transactions,
+                         "arrival interval (msec)",
+                         ktm->arrival_interval * 1000,
+                         "hold (msec)",
+                           "count", tstat_count (&ktm->hold_ts),
+                           "min", tstat_min (&ktm->hold_ts),
+                           "mean", tstat_mean (&ktm->hold_ts),
+                           "stddev", tstat_stddev (&ktm->hold_ts),
+                           "max", tstat_max (&ktm->hold_ts)))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
+void kvstxn_mgr_clear_group_commit_stats (kvstxn_mgr_t *ktm)
+{
+    ktm->commits = 0;
+    ktm->committed_transactions = 0;
+    memset (&ktm->hold_ts, 0, sizeof (ktm->hold_ts));
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
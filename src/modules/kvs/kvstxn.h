@@ -200,6 +200,52 @@ kvstxn_t *kvstxn_mgr_get_ready_transaction (kvstxn_mgr_t *ktm);
 void kvstxn_mgr_remove_transaction (kvstxn_mgr_t *ktm, kvstxn_t *kt,
                                     bool fallback);
 
+/* Directories with more than 'threshold' entries are converted to
+ * sharded (hamt) directories when they are next written, so that
+ * subsequent updates rewrite only the affected shards.  Shards are split
+ * when they exceed the same threshold.  A threshold of 0 disables
+ * sharding of new directories (existing sharded directories remain so).
+ * The default is KVSTXN_SHARD_THRESHOLD.
+ */
+#define KVSTXN_SHARD_THRESHOLD 1024
+
+void kvstxn_mgr_set_shard_threshold (kvstxn_mgr_t *ktm, int threshold);
+
+/* When appending to a valref with more than 'count' blobrefs, merge
+ * trailing blobs so that blob sizes grow geometrically toward the start
+ * of the value, up to KVSTXN_VALREF_BLOB_MAX bytes.  A value appended in
+ * small pieces is thus held in a number of blobs logarithmic in its size
+ * (per KVSTXN_VALREF_BLOB_MAX bytes).  A count of 0 disables compaction.
+ * The default is KVSTXN_VALREF_COMPACT_COUNT.
+ */
+#define KVSTXN_VALREF_COMPACT_COUNT 8
+#define KVSTXN_VALREF_BLOB_MAX      1048576
+
+void kvstxn_mgr_set_valref_compact_count (kvstxn_mgr_t *ktm, int count);
+
+/* Group commit: while transactions arrive faster than one per 'window'
+ * seconds, hold the head ready transaction until up to 'window' seconds
+ * have passed or 'count' transactions are ready, so that they can be
+ * merged into a single root update.  The hold time is further limited
+ * to the time 'count' transactions are expected to take to arrive at
+ * the current rate.  A window of 0 disables holding.
+ * The defaults are KVSTXN_GROUP_COMMIT_WINDOW and
+ * KVSTXN_GROUP_COMMIT_COUNT.
+ */
+#define KVSTXN_GROUP_COMMIT_WINDOW  0.001
+#define KVSTXN_GROUP_COMMIT_COUNT   256
+
+void kvstxn_mgr_set_group_commit (kvstxn_mgr_t *ktm, double window, int count);
+
+/* Call before kvstxn_mgr_get_ready_transaction() with the current time.
+ * Returns the number of seconds the head ready transaction should
+ * continue to be held, or 0 if it should be processed now.
+ */
+double kvstxn_mgr_group_commit_hold (kvstxn_mgr_t *ktm, double now);
+
+json_t *kvstxn_mgr_get_group_commit_stats (kvstxn_mgr_t *ktm);
+void kvstxn_mgr_clear_group_commit_stats (kvstxn_mgr_t *ktm);
+
 int kvstxn_mgr_get_noop_stores (kvstxn_mgr_t *ktm);
 void kvstxn_mgr_clear_noop_stores (kvstxn_mgr_t *ktm);
 
@@ -80,6 +80,7 @@ struct lookup {
      */
     const json_t *valref_missing_refs;
     const char *missing_ref;
+    json_t *missing_shard_refs; /* refs missing from sharded dir */
 
     /* for namespace callback */
 
@@ -350,6 +351,68 @@ cleanup:
     return ret;
 }
 
+/* Find the bucket of sharded directory 'hamt' that would contain 'name'.
+ * On success, '*dirp' is set to the bucket, or NULL if it does not exist,
+ * and '*entryp' is updated to the cache entry containing the bucket.
+ */
+static lookup_process_t walk_shard (lookup_t *lh,
+                                    const json_t *hamt,
+                                    const char *name,
+                                    const json_t **dirp,
+                                    struct cache_entry **entryp)
+{
+    int level;
+
+    for (level = 0; level < TREEOBJ_HAMT_MAXLEVEL; level++) {
+        const json_t *shard;
+        int index;
+
+        if ((index = treeobj_hamt_index (name, level)) < 0) {
+            lh->errnum = errno;
+            return LOOKUP_PROCESS_ERROR;
+        }
+        if (!(shard = treeobj_peek_shard (hamt, index))) {
+            if (errno != ENOENT) {
+                lh->errnum = errno;
+                return LOOKUP_PROCESS_ERROR;
+            }
+            (*dirp) = NULL;
+            return LOOKUP_PROCESS_FINISHED;
+        }
+        if (treeobj_is_dirref (shard)) {
+            struct cache_entry *entry;
+            const char *refstr;
+
+            if (!(refstr = treeobj_get_blobref (shard, 0))) {
+                lh->errnum = errno;
+                return LOOKUP_PROCESS_ERROR;
+            }
+            if (!(entry = cache_lookup (lh->cache, refstr))
+                || !cache_entry_get_valid (entry)) {
+                lh->missing_ref = refstr;
+                return LOOKUP_PROCESS_LOAD_MISSING_REFS;
+            }
+            if (!(shard = cache_entry_get_treeobj (entry))) {
+                flux_log (lh->h, LOG_ERR, "shard points to non-treeobj");
+                lh->errnum = ENOTRECOVERABLE;
+                return LOOKUP_PROCESS_ERROR;
+            }
+            (*entryp) = entry;
+        }
+        if (treeobj_is_dir (shard)) {
+            (*dirp) = shard;
+            return LOOKUP_PROCESS_FINISHED;
+        }
+        if (!treeobj_is_hamt (shard)) {
+            lh->errnum = ENOTRECOVERABLE;
+            return LOOKUP_PROCESS_ERROR;
+        }
+        hamt = shard;
+    }
+    lh->errnum = ENOTRECOVERABLE;
+    return LOOKUP_PROCESS_ERROR;
+}
+
 /* Get dirent of the requested path starting at the given root.
  *
  * Return true on success or error, error code is returned in ep and
@@ -410,6 +473,15 @@ static lookup_process_t walk (lookup_t *lh)
                     lh->errnum = ENOTRECOVERABLE;
                 goto error;
             }
+            if (treeobj_is_hamt (dir)) {
+                lookup_process_t sret;
+
+                sret = walk_shard (lh, dir, pathcomp, &dir, &entry);
+                if (sret != LOOKUP_PROCESS_FINISHED)
+                    return sret;
+                if (!dir)
+                    goto done;
+            }
             if (!treeobj_is_dir (dir)) {
                 /* dirref pointed to non-dir error, special case when
                  * root_dirent is bad, is EINVAL from user.
@@ -598,6 +670,7 @@ void lookup_destroy (lookup_t *lh)
         free (lh->root_ref);
         free (lh->path);
         json_decref (lh->val);
+        json_decref (lh->missing_shard_refs);
         free (lh->missing_namespace);
         zlist_destroy (&lh->levels);
         free (lh);
@@ -649,7 +722,16 @@ int lookup_iter_missing_refs (lookup_t *lh, lookup_ref_f cb, void *data)
         && (lh->state == LOOKUP_STATE_CHECK_ROOT
             || lh->state == LOOKUP_STATE_WALK
             || lh->state == LOOKUP_STATE_VALUE)) {
-        if (lh->valref_missing_refs) {
+        if (json_array_size (lh->missing_shard_refs) > 0) {
+            size_t index;
+            json_t *o;
+
+            json_array_foreach (lh->missing_shard_refs, index, o) {
+                if (cb (lh, json_string_value (o), data) < 0)
+                    return -1;
+            }
+        }
+        else if (lh->valref_missing_refs) {
             int refcount, i;
 
             if (!treeobj_is_valref (lh->valref_missing_refs)) {
@@ -687,6 +769,51 @@ int lookup_iter_missing_refs (lookup_t *lh, lookup_ref_f cb, void *data)
     return -1;
 }
 
+static bool ref_is_cached (lookup_t *lh, const char *ref)
+{
+    return cache_lookup (lh->cache, ref) != NULL;
+}
+
+int lookup_iter_prefetch_refs (lookup_t *lh, lookup_ref_f cb, void *data)
+{
+    const char *ref;
+    int count = 0;
+
+    if (!lh || !cb || lh->state != LOOKUP_STATE_FINISHED) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (lh->errnum || !lh->val)
+        return 0;
+    if ((lh->flags & FLUX_KVS_TREEOBJ)) {
+        if (treeobj_is_dirref (lh->val)
+            && treeobj_get_count (lh->val) == 1
+            && (ref = treeobj_get_blobref (lh->val, 0))
+            && !ref_is_cached (lh, ref)) {
+            if (cb (lh, ref, data) < 0)
+                return -1;
+        }
+    }
+    else if ((lh->flags & FLUX_KVS_READDIR) && treeobj_is_dir (lh->val)) {
+        const char *name;
+        json_t *entry;
+
+        json_object_foreach (treeobj_get_data (lh->val), name, entry) {
+            if (count == LOOKUP_PREFETCH_MAX)
+                break;
+            if (!treeobj_is_dirref (entry)
+                || treeobj_get_count (entry) != 1
+                || !(ref = treeobj_get_blobref (entry, 0))
+                || ref_is_cached (lh, ref))
+                continue;
+            if (cb (lh, ref, data) < 0)
+                return -1;
+            count++;
+        }
+    }
+    return 0;
+}
+
 const char *lookup_missing_namespace (lookup_t *lh)
 {
    if (lh
@@ -743,6 +870,105 @@ static int namespace_still_valid (lookup_t *lh)
     return 0;
 }
 
+/* Merge the entries of all buckets of sharded directory 'hamt' into
+ * directory 'dir'.  Refs of shards not in the cache are accumulated in
+ * lh->missing_shard_refs, so they may be loaded in one pass.
+ * Return 0 on success, -1 on failure with lh->errnum set.
+ */
+static int hamt_gather (lookup_t *lh, const json_t *hamt, json_t *dir)
+{
+    int index;
+
+    for (index = 0; index < TREEOBJ_HAMT_WIDTH; index++) {
+        const json_t *shard;
+
+        if (!(shard = treeobj_peek_shard (hamt, index)))
+            continue;
+        if (treeobj_is_dirref (shard)) {
+            struct cache_entry *entry;
+            const char *reftmp;
+
+            if (!(reftmp = treeobj_get_blobref (shard, 0))) {
+                lh->errnum = errno;
+                return -1;
+            }
+            if (!(entry = cache_lookup (lh->cache, reftmp))
+                || !cache_entry_get_valid (entry)) {
+                json_t *o = json_string (reftmp);
+                if (!o || json_array_append_new (lh->missing_shard_refs,
+                                                 o) < 0) {
+                    json_decref (o);
+                    lh->errnum = ENOMEM;
+                    return -1;
+                }
+                continue;
+            }
+            if (!(shard = cache_entry_get_treeobj (entry))) {
+                flux_log (lh->h, LOG_ERR, "shard points to non-treeobj");
+                lh->errnum = ENOTRECOVERABLE;
+                return -1;
+            }
+        }
+        if (treeobj_is_hamt (shard)) {
+            if (hamt_gather (lh, shard, dir) < 0)
+                return -1;
+        }
+        else if (treeobj_is_dir (shard)) {
+            json_t *data;
+            json_t *cpy;
+
+            if (!(data = treeobj_get_data ((json_t *)shard))
+                || !(cpy = json_deep_copy (data))) {
+                lh->errnum = ENOMEM;
+                return -1;
+            }
+            if (json_object_update (treeobj_get_data (dir), cpy) < 0) {
+                json_decref (cpy);
+                lh->errnum = ENOMEM;
+                return -1;
+            }
+            json_decref (cpy);
+        }
+        else {
+            lh->errnum = ENOTRECOVERABLE;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Convert sharded directory 'hamt' to a plain directory in lh->val.
+ * return 0 on success, -1 on failure.  On success, stall should be
+ * checked */
+static int get_hamt_value (lookup_t *lh, const json_t *hamt, bool *stall)
+{
+    json_t *dir;
+
+    if (!lh->missing_shard_refs) {
+        if (!(lh->missing_shard_refs = json_array ())) {
+            lh->errnum = ENOMEM;
+            return -1;
+        }
+    }
+    json_array_clear (lh->missing_shard_refs);
+    if (!(dir = treeobj_create_dir ())) {
+        lh->errnum = errno;
+        return -1;
+    }
+    if (hamt_gather (lh, hamt, dir) < 0) {
+        json_decref (dir);
+        return -1;
+    }
+    if (json_array_size (lh->missing_shard_refs) > 0) {
+        json_decref (dir);
+        (*stall) = true;
+        return 0;
+    }
+    lh->val = dir;
+    (*stall) = false;
+    return 0;
+}
+
 /* return 0 on success, -1 on failure.  On success, stall should be
  * checked */
 static int get_single_blobref_valref_value (lookup_t *lh, bool *stall)
@@ -903,6 +1129,8 @@ lookup_process_t lookup (lookup_t *lh)
     if (lh->errnum)
         return LOOKUP_PROCESS_ERROR;
 
+    json_array_clear (lh->missing_shard_refs);
+
     if (lh->state != LOOKUP_STATE_INIT
         && lh->state != LOOKUP_STATE_FINISHED)
         is_replay = true;
@@ -976,6 +1204,16 @@ lookup_process_t lookup (lookup_t *lh)
                         lh->errnum = EINVAL;
                         goto error;
                     }
+                    if (treeobj_is_hamt (valtmp)) {
+                        /* user may pass a sharded dir as root_ref */
+                        bool stall;
+
+                        if (get_hamt_value (lh, valtmp, &stall) < 0)
+                            goto error;
+                        if (stall)
+                            return LOOKUP_PROCESS_LOAD_MISSING_REFS;
+                        goto done;
+                    }
                     if (!treeobj_is_dir (valtmp)) {
                         /* root_ref points to not dir */
                         lh->errnum = ENOTRECOVERABLE;
@@ -1073,6 +1311,15 @@ lookup_process_t lookup (lookup_t *lh)
                     lh->errnum = ENOTRECOVERABLE;
                     goto error;
                 }
+                if (treeobj_is_hamt (valtmp)) {
+                    bool stall;
+
+                    if (get_hamt_value (lh, valtmp, &stall) < 0)
+                        goto error;
+                    if (stall)
+                        return LOOKUP_PROCESS_LOAD_MISSING_REFS;
+                    goto done;
+                }
                 if (!treeobj_is_dir (valtmp)) {
                     /* dirref points to not dir */
                     lh->errnum = ENOTRECOVERABLE;
@@ -74,6 +74,19 @@ json_t *lookup_get_value (lookup_t *lh);
  */
 int lookup_iter_missing_refs (lookup_t *lh, lookup_ref_f cb, void *data);
 
+/* After lookup() returns LOOKUP_PROCESS_FINISHED, get references that
+ * are likely to be needed by a subsequent lookup but are not in the KVS
+ * cache, so that they may be loaded speculatively: the subdirectories
+ * of a directory read with FLUX_KVS_READDIR, or the directory
+ * referenced by a dirref returned with FLUX_KVS_TREEOBJ.  At most
+ * LOOKUP_PREFETCH_MAX references are returned.
+ *
+ * return -1 in callback to break iteration
+ */
+#define LOOKUP_PREFETCH_MAX 64
+
+int lookup_iter_prefetch_refs (lookup_t *lh, lookup_ref_f cb, void *data);
+
 /* On lookup stall b/c of missing namespace, get missing namespace
  * returned by this function.
  *
@@ -714,6 +714,61 @@ void cache_expiration_tests (void)
     cache_destroy (cache);
 }
 
+static int count_valid_cb (struct cache_entry *entry, void *arg)
+{
+    int *count = arg;
+    (*count)++;
+    return 0;
+}
+
+static int stop_cb (struct cache_entry *entry, void *arg)
+{
+    int *count = arg;
+    (*count)++;
+    return -1;
+}
+
+void cache_foreach_tests (void)
+{
+    struct cache *cache;
+    struct cache_entry *e1, *e2, *e3;
+    int count;
+
+    ok ((cache = cache_create (NULL)) != NULL,
+        "cache_create works");
+    count = 0;
+    ok (cache_foreach_valid (cache, count_valid_cb, &count) == 0
+        && count == 0,
+        "cache_foreach_valid on empty cache visits nothing");
+
+    ok ((e1 = cache_entry_create ("xxx1")) != NULL
+        && cache_insert (cache, e1) == 0,
+        "inserted invalid entry");
+    ok ((e2 = cache_entry_create ("xxx2")) != NULL
+        && cache_entry_set_raw (e2, "foo", 3) == 0
+        && cache_insert (cache, e2) == 0,
+        "inserted valid entry");
+    ok ((e3 = cache_entry_create ("xxx3")) != NULL
+        && cache_entry_set_raw (e3, "bar", 3) == 0
+        && cache_insert (cache, e3) == 0,
+        "inserted another valid entry");
+
+    cache_entry_set_fake_time (e2, 42.);
+    ok (cache_entry_get_lastuse (e2) == 42.,
+        "cache_entry_get_lastuse returns last use time");
+
+    count = 0;
+    ok (cache_foreach_valid (cache, count_valid_cb, &count) == 0
+        && count == 2,
+        "cache_foreach_valid visits only valid entries");
+    count = 0;
+    ok (cache_foreach_valid (cache, stop_cb, &count) == -1
+        && count == 1,
+        "cache_foreach_valid stops when callback returns -1");
+
+    cache_destroy (cache);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -726,6 +781,7 @@ int main (int argc, char *argv[])
     cache_expiration_tests ();
     cache_blobref_tests ();
     cache_remove_entry_tests ();
+    cache_foreach_tests ();
 
     done_testing ();
     return (0);
@@ -0,0 +1,497 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libczmqcontainers/czmq_containers.h"
+#include "src/common/libkvs/treeobj.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libtap/tap.h"
+#include "src/modules/kvs/waitqueue.h"
+#include "src/modules/kvs/cache.h"
+#include "src/modules/kvs/kvs_replica.h"
+
+/* Fake content store.  Loads are queued until deliver() is called,
+ * as if they were waiting for content load responses.
+ */
+struct store {
+    flux_reactor_t *r;
+    struct cache *cache;
+    zhashx_t *objects;      /* ref => encoded object */
+    zlist_t *pending;       /* refs with load outstanding */
+    int loads;
+};
+
+static void store_put (struct store *st,
+                       const void *data,
+                       int len,
+                       char *ref,
+                       int ref_len)
+{
+    char *s;
+
+    if (blobref_hash ("sha1", data, len, ref, ref_len) < 0)
+        BAIL_OUT ("blobref_hash failed");
+    if (!(s = strndup (data, len)))
+        BAIL_OUT ("strndup failed");
+    if (zhashx_insert (st->objects, ref, s) < 0)
+        free (s);
+}
+
+static void store_put_treeobj (struct store *st,
+                               json_t *o,
+                               char *ref,
+                               int ref_len)
+{
+    char *s;
+
+    if (!(s = treeobj_encode (o)))
+        BAIL_OUT ("treeobj_encode failed");
+    store_put (st, s, strlen (s), ref, ref_len);
+    free (s);
+}
+
+static int load_cb (const char *ref, void *arg)
+{
+    struct store *st = arg;
+    struct cache_entry *entry;
+
+    if (cache_lookup (st->cache, ref))
+        return 0;
+    if (!(entry = cache_entry_create (ref))
+        || cache_insert (st->cache, entry) < 0
+        || zlist_append (st->pending, strdup (ref)) < 0)
+        BAIL_OUT ("could not start fake load");
+    st->loads++;
+    return 0;
+}
+
+/* Complete outstanding loads, but not loads started as a result.
+ * Return number of loads completed.
+ */
+static int deliver (struct store *st)
+{
+    char *ref;
+    int n = zlist_size (st->pending);
+    int count = 0;
+
+    while (count < n && (ref = zlist_pop (st->pending))) {
+        struct cache_entry *entry;
+        const char *data;
+
+        if (!(entry = cache_lookup (st->cache, ref)))
+            BAIL_OUT ("pending entry not in cache");
+        if ((data = zhashx_lookup (st->objects, ref))) {
+            if (cache_entry_set_raw (entry, data, strlen (data)) < 0)
+                BAIL_OUT ("cache_entry_set_raw failed");
+        }
+        else {
+            if (cache_entry_set_errnum_on_valid (entry, ENOENT) < 0)
+                BAIL_OUT ("cache_entry_set_errnum_on_valid failed");
+            (void)cache_remove_entry (st->cache, ref);
+        }
+        free (ref);
+        count++;
+    }
+    return count;
+}
+
+static int get_stat (kvs_replica_t *kr, const char *name)
+{
+    json_t *o;
+    int val = -1;
+
+    if (!(o = kvs_replica_get_stats (kr)))
+        BAIL_OUT ("kvs_replica_get_stats failed");
+    (void)json_unpack (o, "{s:i}", name, &val);
+    json_decref (o);
+    return val;
+}
+
+/* wraps treeobj_insert_entry_novalidate(), taking ownership of 'entry'
+ */
+static void insert_entry (json_t *dir, const char *name, json_t *entry)
+{
+    if (!entry || treeobj_insert_entry_novalidate (dir, name, entry) < 0)
+        BAIL_OUT ("treeobj_insert_entry_novalidate failed");
+    json_decref (entry);
+}
+
+/* Build a tree in the store:
+ *   a.x = "foo"
+ *   a.sub.y = 1
+ *   b.z = 2
+ *   c = "bar"
+ * Return the root ref in 'root_ref' and a.sub's ref in 'sub_ref'.
+ */
+static void build_tree (struct store *st,
+                        char *root_ref,
+                        char *sub_ref,
+                        int ref_len)
+{
+    char foo_ref[BLOBREF_MAX_STRING_SIZE];
+    char bar_ref[BLOBREF_MAX_STRING_SIZE];
+    char a_ref[BLOBREF_MAX_STRING_SIZE];
+    char b_ref[BLOBREF_MAX_STRING_SIZE];
+    json_t *sub, *a, *b, *root;
+
+    store_put (st, "foo", 3, foo_ref, sizeof (foo_ref));
+    store_put (st, "bar", 3, bar_ref, sizeof (bar_ref));
+
+    sub = treeobj_create_dir ();
+    insert_entry (sub, "y", treeobj_create_val ("1", 1));
+    store_put_treeobj (st, sub, sub_ref, ref_len);
+
+    a = treeobj_create_dir ();
+    insert_entry (a, "x", treeobj_create_valref (foo_ref));
+    insert_entry (a, "sub", treeobj_create_dirref (sub_ref));
+    store_put_treeobj (st, a, a_ref, sizeof (a_ref));
+
+    b = treeobj_create_dir ();
+    insert_entry (b, "z", treeobj_create_val ("2", 1));
+    store_put_treeobj (st, b, b_ref, sizeof (b_ref));
+
+    root = treeobj_create_dir ();
+    insert_entry (root, "a", treeobj_create_dirref (a_ref));
+    insert_entry (root, "b", treeobj_create_dirref (b_ref));
+    insert_entry (root, "c", treeobj_create_valref (bar_ref));
+    store_put_treeobj (st, root, root_ref, ref_len);
+
+    json_decref (sub);
+    json_decref (a);
+    json_decref (b);
+    json_decref (root);
+}
+
+static void free_wrapper (void **item)
+{
+    if (item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+static void store_init (struct store *st)
+{
+    memset (st, 0, sizeof (*st));
+    if (!(st->r = flux_reactor_create (0))
+        || !(st->cache = cache_create (st->r))
+        || !(st->objects = zhashx_new ())
+        || !(st->pending = zlist_new ()))
+        BAIL_OUT ("could not create fake store");
+    zhashx_set_destructor (st->objects, free_wrapper);
+}
+
+static void store_fini (struct store *st)
+{
+    char *ref;
+
+    while ((ref = zlist_pop (st->pending)))
+        free (ref);
+    zlist_destroy (&st->pending);
+    zhashx_destroy (&st->objects);
+    cache_destroy (st->cache);
+    flux_reactor_destroy (st->r);
+}
+
+static void replica_prefix (void)
+{
+    struct store st;
+    kvs_replica_t *kr;
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    char sub_ref[BLOBREF_MAX_STRING_SIZE];
+    int rounds = 0;
+
+    store_init (&st);
+    build_tree (&st, root_ref, sub_ref, sizeof (root_ref));
+
+    kr = kvs_replica_create (NULL, st.cache, load_cb, &st);
+    ok (kr != NULL,
+        "kvs_replica_create works");
+    ok (kvs_replica_add_prefix (kr, "a.") == 0,
+        "kvs_replica_add_prefix a. works");
+    ok (kvs_replica_update (kr, root_ref) == 0,
+        "kvs_replica_update works");
+    ok (get_stat (kr, "#walks") == 0 && get_stat (kr, "#pinned") == 0,
+        "walk is not complete before objects are loaded");
+    while (deliver (&st) > 0)
+        rounds++;
+    ok (rounds == 3,
+        "walk took 3 rounds of loads");
+    ok (get_stat (kr, "#walks") == 1,
+        "walk is complete");
+    ok (get_stat (kr, "#pinned") == 4,
+        "root, a, a.sub, and a.x are pinned");
+    ok (cache_count_entries (st.cache) == 4,
+        "objects outside of prefix were not loaded");
+
+    ok (cache_expire_entries (st.cache, 0.) == 0
+        && cache_count_entries (st.cache) == 4,
+        "pinned objects do not expire");
+
+    ok (kvs_replica_update (kr, root_ref) == 0
+        && st.loads == 4
+        && get_stat (kr, "#walks") == 1,
+        "kvs_replica_update with unchanged root does nothing");
+
+    ok (get_stat (kr, "#errors") == 0,
+        "no errors were reported");
+
+    kvs_replica_destroy (kr);
+    ok (cache_expire_entries (st.cache, 0.) == 4,
+        "objects are unpinned when replica is destroyed");
+    store_fini (&st);
+}
+
+static void replica_all (void)
+{
+    struct store st;
+    kvs_replica_t *kr;
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    char root2_ref[BLOBREF_MAX_STRING_SIZE];
+    char sub_ref[BLOBREF_MAX_STRING_SIZE];
+    json_t *root2;
+    int loads;
+
+    store_init (&st);
+    build_tree (&st, root_ref, sub_ref, sizeof (root_ref));
+
+    /* second root shares a.sub with the first */
+    root2 = treeobj_create_dir ();
+    insert_entry (root2, "s", treeobj_create_dirref (sub_ref));
+    store_put_treeobj (&st, root2, root2_ref, sizeof (root2_ref));
+    json_decref (root2);
+
+    if (!(kr = kvs_replica_create (NULL, st.cache, load_cb, &st)))
+        BAIL_OUT ("kvs_replica_create failed");
+    ok (kvs_replica_add_prefix (kr, ".") == 0,
+        "kvs_replica_add_prefix . works");
+    ok (kvs_replica_update (kr, root_ref) == 0,
+        "kvs_replica_update works");
+    while (deliver (&st) > 0)
+        ;
+    ok (get_stat (kr, "#walks") == 1 && get_stat (kr, "#pinned") == 6,
+        "all objects of first root are pinned");
+
+    loads = st.loads;
+    ok (kvs_replica_update (kr, root2_ref) == 0,
+        "kvs_replica_update to new root works");
+    ok (get_stat (kr, "#walks") == 1 && get_stat (kr, "#pinned") == 6,
+        "objects of first root remain pinned during walk");
+    while (deliver (&st) > 0)
+        ;
+    ok (get_stat (kr, "#walks") == 2 && get_stat (kr, "#pinned") == 2,
+        "only objects of second root are pinned after walk");
+    ok (st.loads == loads + 1,
+        "shared subtree was not walked again");
+    ok (cache_expire_entries (st.cache, 0.) == 5
+        && cache_count_entries (st.cache) == 2,
+        "objects of first root may now be expired");
+
+    kvs_replica_destroy (kr);
+    store_fini (&st);
+}
+
+static void replica_retarget (void)
+{
+    struct store st;
+    kvs_replica_t *kr;
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    char sub_ref[BLOBREF_MAX_STRING_SIZE];
+    char bad_ref[BLOBREF_MAX_STRING_SIZE];
+
+    store_init (&st);
+    build_tree (&st, root_ref, sub_ref, sizeof (root_ref));
+    if (blobref_hash ("sha1", "missing", 7, bad_ref, sizeof (bad_ref)) < 0)
+        BAIL_OUT ("blobref_hash failed");
+
+    if (!(kr = kvs_replica_create (NULL, st.cache, load_cb, &st)))
+        BAIL_OUT ("kvs_replica_create failed");
+    if (kvs_replica_add_prefix (kr, ".") < 0)
+        BAIL_OUT ("kvs_replica_add_prefix failed");
+
+    ok (kvs_replica_update (kr, bad_ref) == 0,
+        "kvs_replica_update of missing root works");
+    ok (kvs_replica_update (kr, root_ref) == 0
+        && kvs_replica_update (kr, sub_ref) == 0,
+        "kvs_replica_update twice before walk completes works");
+    diag ("expect an ENOENT error to be logged");
+    ok (deliver (&st) == 1,
+        "only the load of the first root was started");
+    ok (get_stat (kr, "#walks") == 1
+        && get_stat (kr, "#pinned") == 0
+        && get_stat (kr, "#errors") == 1,
+        "first walk completed and its load error was counted");
+    ok (deliver (&st) == 1
+        && deliver (&st) == 0,
+        "walk was retargeted to the most recent root");
+    ok (get_stat (kr, "#walks") == 2
+        && get_stat (kr, "#pinned") == 1
+        && st.loads == 2,
+        "intermediate root was skipped");
+
+    diag ("expect an ENOENT error to be logged");
+    ok (kvs_replica_update (kr, bad_ref) == 0 && deliver (&st) == 1,
+        "kvs_replica_update of missing root works");
+    ok (get_stat (kr, "#walks") == 3
+        && get_stat (kr, "#pinned") == 0
+        && get_stat (kr, "#errors") == 2,
+        "load error was counted");
+
+    ok (kvs_replica_update (kr, root_ref) == 0,
+        "kvs_replica_update works");
+    kvs_replica_destroy (kr);
+    ok (true,
+        "kvs_replica_destroy with walk in progress works");
+    store_fini (&st);
+}
+
+/* Build a tree in the store where 'big' is a hamt with keys k0..k31.
+ * Return the number of shards in 'nshards'.
+ */
+static void build_hamt_tree (struct store *st,
+                             char *root_ref,
+                             int ref_len,
+                             int *nshards)
+{
+    json_t *shards[TREEOBJ_HAMT_WIDTH] = { NULL };
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    json_t *hamt, *root;
+    char name[16];
+    int i;
+
+    for (i = 0; i < 32; i++) {
+        int index;
+
+        snprintf (name, sizeof (name), "k%d", i);
+        index = treeobj_hamt_index (name, 0);
+        if (!shards[index] && !(shards[index] = treeobj_create_dir ()))
+            BAIL_OUT ("treeobj_create_dir failed");
+        insert_entry (shards[index], name, treeobj_create_val ("x", 1));
+    }
+    if (!(hamt = treeobj_create_hamt ()))
+        BAIL_OUT ("treeobj_create_hamt failed");
+    *nshards = 0;
+    for (i = 0; i < TREEOBJ_HAMT_WIDTH; i++) {
+        json_t *dirref;
+
+        if (!shards[i])
+            continue;
+        store_put_treeobj (st, shards[i], ref, sizeof (ref));
+        if (!(dirref = treeobj_create_dirref (ref))
+            || treeobj_insert_shard (hamt, i, dirref) < 0)
+            BAIL_OUT ("could not insert shard");
+        json_decref (dirref);
+        json_decref (shards[i]);
+        (*nshards)++;
+    }
+    store_put_treeobj (st, hamt, ref, sizeof (ref));
+
+    if (!(root = treeobj_create_dir ()))
+        BAIL_OUT ("treeobj_create_dir failed");
+    insert_entry (root, "big", treeobj_create_dirref (ref));
+    store_put_treeobj (st, root, root_ref, ref_len);
+
+    json_decref (hamt);
+    json_decref (root);
+}
+
+static void replica_hamt (void)
+{
+    struct store st;
+    kvs_replica_t *kr;
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    int nshards;
+
+    store_init (&st);
+    build_hamt_tree (&st, root_ref, sizeof (root_ref), &nshards);
+    diag ("hamt has %d shards", nshards);
+
+    if (!(kr = kvs_replica_create (NULL, st.cache, load_cb, &st)))
+        BAIL_OUT ("kvs_replica_create failed");
+    ok (kvs_replica_add_prefix (kr, "big.k7") == 0
+        && kvs_replica_update (kr, root_ref) == 0,
+        "replicating one key in a sharded directory works");
+    while (deliver (&st) > 0)
+        ;
+    ok (get_stat (kr, "#walks") == 1 && get_stat (kr, "#pinned") == 3,
+        "root, hamt, and one shard are pinned");
+    kvs_replica_destroy (kr);
+
+    if (!(kr = kvs_replica_create (NULL, st.cache, load_cb, &st)))
+        BAIL_OUT ("kvs_replica_create failed");
+    ok (kvs_replica_add_prefix (kr, "big") == 0
+        && kvs_replica_update (kr, root_ref) == 0,
+        "replicating a sharded directory works");
+    while (deliver (&st) > 0)
+        ;
+    ok (get_stat (kr, "#walks") == 1
+        && get_stat (kr, "#pinned") == 2 + nshards,
+        "root, hamt, and all shards are pinned");
+    kvs_replica_destroy (kr);
+
+    store_fini (&st);
+}
+
+static void replica_inval (void)
+{
+    struct store st;
+    kvs_replica_t *kr;
+
+    store_init (&st);
+    errno = 0;
+    ok (kvs_replica_create (NULL, NULL, load_cb, NULL) == NULL
+        && errno == EINVAL,
+        "kvs_replica_create cache=NULL fails with EINVAL");
+    errno = 0;
+    ok (kvs_replica_create (NULL, st.cache, NULL, NULL) == NULL
+        && errno == EINVAL,
+        "kvs_replica_create load=NULL fails with EINVAL");
+    if (!(kr = kvs_replica_create (NULL, st.cache, load_cb, &st)))
+        BAIL_OUT ("kvs_replica_create failed");
+    errno = 0;
+    ok (kvs_replica_add_prefix (kr, NULL) < 0 && errno == EINVAL,
+        "kvs_replica_add_prefix prefix=NULL fails with EINVAL");
+    errno = 0;
+    ok (kvs_replica_update (kr, NULL) < 0 && errno == EINVAL,
+        "kvs_replica_update root_ref=NULL fails with EINVAL");
+    errno = 0;
+    ok (kvs_replica_get_stats (NULL) == NULL && errno == EINVAL,
+        "kvs_replica_get_stats kr=NULL fails with EINVAL");
+    lives_ok ({kvs_replica_destroy (NULL);},
+        "kvs_replica_destroy kr=NULL doesn't crash");
+    kvs_replica_destroy (kr);
+    store_fini (&st);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    replica_prefix ();
+    replica_all ();
+    replica_retarget ();
+    replica_hamt ();
+    replica_inval ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
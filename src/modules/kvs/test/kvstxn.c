@@ -3004,6 +3004,198 @@ void kvstxn_process_giant_dir (void)
     json_decref (root);
 }
 
+/* Commit keys "dir.key<start>" .. "dir.key<start+count-1>" in a single
+ * transaction, deleting them if 'val' is NULL.  Return the new root ref
+ * in 'newroot'.
+ */
+static void process_sharded_dir_ops (kvstxn_mgr_t *ktm,
+                                     struct cache *cache,
+                                     const char *root_ref,
+                                     int start,
+                                     int count,
+                                     const char *val,
+                                     char *newroot,
+                                     int newroot_len)
+{
+    json_t *ops;
+    kvstxn_t *kt;
+    int i;
+
+    if (!(ops = json_array ()))
+        BAIL_OUT ("json_array failed");
+    for (i = start; i < start + count; i++) {
+        char key[64];
+        snprintf (key, sizeof (key), "dir.key%d", i);
+        ops_append (ops, key, val, 0);
+    }
+    ok (kvstxn_mgr_add_transaction (ktm, "sharded", ops, 0, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    json_decref (ops);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+    snprintf (newroot, newroot_len, "%s", kvstxn_get_newroot_ref (kt));
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+}
+
+/* Return the treeobj referenced by "dir" in root 'root_ref'.
+ */
+static const json_t *get_sharded_dir (struct cache *cache,
+                                      const char *root_ref)
+{
+    struct cache_entry *entry;
+    const json_t *root;
+    const json_t *dirref;
+    const char *ref;
+
+    if (!(entry = cache_lookup (cache, root_ref))
+        || !(root = cache_entry_get_treeobj (entry))
+        || !(dirref = treeobj_peek_entry (root, "dir"))
+        || !treeobj_is_dirref (dirref)
+        || !(ref = treeobj_get_blobref (dirref, 0))
+        || !(entry = cache_lookup (cache, ref)))
+        return NULL;
+    return cache_entry_get_treeobj (entry);
+}
+
+static int readdir_count (struct cache *cache,
+                          kvsroot_mgr_t *krm,
+                          const char *root_ref,
+                          const char *key)
+{
+    struct flux_msg_cred cred = { .rolemask = FLUX_ROLE_OWNER, .userid = 0 };
+    lookup_t *lh;
+    json_t *o;
+    int count = -1;
+
+    if (!(lh = lookup_create (cache,
+                              krm,
+                              KVS_PRIMARY_NAMESPACE,
+                              root_ref,
+                              0,
+                              key,
+                              cred,
+                              FLUX_KVS_READDIR,
+                              NULL)))
+        return -1;
+    if (lookup (lh) == LOOKUP_PROCESS_FINISHED
+        && (o = lookup_get_value (lh))) {
+        if (treeobj_is_dir (o))
+            count = treeobj_get_count (o);
+        json_decref (o);
+    }
+    lookup_destroy (lh);
+    return count;
+}
+
+void kvstxn_process_sharded_dir (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    json_t *root;
+    const json_t *dir;
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    char newroot1[BLOBREF_MAX_STRING_SIZE];
+    char newroot2[BLOBREF_MAX_STRING_SIZE];
+    char newroot3[BLOBREF_MAX_STRING_SIZE];
+
+    ktest_init (&cache, &krm);
+
+    root = treeobj_create_dir ();
+    ok (treeobj_hash ("sha1", root, root_ref, sizeof (root_ref)) == 0,
+        "treeobj_hash worked");
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+    kvstxn_mgr_set_shard_threshold (ktm, 4);
+
+    /* small directory is not sharded
+     */
+    process_sharded_dir_ops (ktm, cache, root_ref, 0, 4, "x",
+                             newroot1, sizeof (newroot1));
+    ok ((dir = get_sharded_dir (cache, newroot1)) != NULL
+        && treeobj_is_dir (dir),
+        "directory at threshold is not sharded");
+
+    /* adding more entries shards it, and shards are split as needed
+     */
+    process_sharded_dir_ops (ktm, cache, newroot1, 4, 60, "y",
+                             newroot2, sizeof (newroot2));
+    ok ((dir = get_sharded_dir (cache, newroot2)) != NULL
+        && treeobj_is_hamt (dir),
+        "directory over threshold is sharded");
+    ok (treeobj_validate (dir) == 0,
+        "sharded directory is valid");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot2, "dir.key0", "x");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot2, "dir.key3", "x");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot2, "dir.key4", "y");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot2, "dir.key63", "y");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot2, "dir.key64", NULL);
+    ok (readdir_count (cache, krm, newroot2, "dir") == 64,
+        "readdir of sharded directory returns all entries");
+
+    /* subdirectory within a sharded directory
+     */
+    create_ready_kvstxn (ktm, "subdir", "dir.sub.a", "z", 0, 0);
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+    ok (kvstxn_process (kt, newroot2, 0) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+    ok (kvstxn_process (kt, newroot2, 0) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+    snprintf (newroot3, sizeof (newroot3), "%s", kvstxn_get_newroot_ref (kt));
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot3, "dir.sub.a", "z");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot3, "dir.key5", "y");
+    ok (readdir_count (cache, krm, newroot3, "dir") == 65,
+        "readdir of sharded directory includes new subdirectory");
+
+    /* delete most entries, including ones that don't exist
+     */
+    process_sharded_dir_ops (ktm, cache, newroot3, 2, 100, NULL,
+                             newroot1, sizeof (newroot1));
+    ok ((dir = get_sharded_dir (cache, newroot1)) != NULL
+        && treeobj_is_hamt (dir)
+        && treeobj_validate (dir) == 0,
+        "directory remains sharded after deletions");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot1, "dir.key1", "x");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot1, "dir.key2", NULL);
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot1, "dir.sub.a", "z");
+    ok (readdir_count (cache, krm, newroot1, "dir") == 3,
+        "readdir of sharded directory returns remaining entries");
+
+    /* appending to a sharded directory fails with EISDIR
+     */
+    create_ready_kvstxn (ktm, "append", "dir", "a", FLUX_KVS_APPEND, 0);
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+    ok (kvstxn_process (kt, newroot1, 0) == KVSTXN_PROCESS_ERROR
+        && kvstxn_get_errnum (kt) == EISDIR,
+        "kvstxn_process fails with EISDIR on append to sharded dir");
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    kvstxn_mgr_destroy (ktm);
+    ktest_finalize (cache, krm);
+    json_decref (root);
+}
+
 void kvstxn_process_append (void)
 {
     struct cache *cache;
@@ -3152,6 +3344,142 @@ void kvstxn_process_append (void)
     json_decref (root);
 }
 
+static int get_valref_count (struct cache *cache,
+                             const char *root_ref,
+                             const char *name)
+{
+    struct cache_entry *entry;
+    const json_t *root;
+    const json_t *valref;
+
+    if (!(entry = cache_lookup (cache, root_ref))
+        || !(root = cache_entry_get_treeobj (entry))
+        || !(valref = treeobj_peek_entry (root, name))
+        || !treeobj_is_valref (valref))
+        return -1;
+    return treeobj_get_count (valref);
+}
+
+void kvstxn_process_append_compact (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    int count = 0;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    json_t *root;
+    json_t *valref;
+    char refA[BLOBREF_MAX_STRING_SIZE];
+    char refB[BLOBREF_MAX_STRING_SIZE];
+    char refC[BLOBREF_MAX_STRING_SIZE];
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    char newroot[BLOBREF_MAX_STRING_SIZE];
+    char expected[128];
+    int i;
+
+    ktest_init (&cache, &krm);
+
+    /* This root is
+     *
+     * root_ref
+     * "log" : valref to [ refA, refB, refC ]
+     *
+     * Only refA is in the cache.
+     */
+
+    blobref_hash ("sha1", "A", 1, refA, sizeof (refA));
+    blobref_hash ("sha1", "B", 1, refB, sizeof (refB));
+    blobref_hash ("sha1", "C", 1, refC, sizeof (refC));
+    (void)cache_insert (cache, create_cache_entry_raw (refA, "A", 1));
+
+    valref = treeobj_create_valref (refA);
+    treeobj_append_blobref (valref, refB);
+    treeobj_append_blobref (valref, refC);
+    root = treeobj_create_dir ();
+    treeobj_insert_entry (root, "log", valref);
+
+    ok (treeobj_hash ("sha1", root, root_ref, sizeof (root_ref)) == 0,
+        "treeobj_hash worked");
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+    kvstxn_mgr_set_valref_compact_count (ktm, 2);
+
+    /* append stalls until the trailing blobs to be merged are loaded
+     */
+    create_ready_kvstxn (ktm, "transaction1", "log", "D", FLUX_KVS_APPEND, 0);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_LOAD_MISSING_REFS,
+        "kvstxn_process returns KVSTXN_PROCESS_LOAD_MISSING_REFS");
+    count = 0;
+    ok (kvstxn_iter_missing_refs (kt, missingref_count_cb, &count) == 0
+        && count == 1,
+        "kvstxn_iter_missing_refs returns last blob of valref");
+    (void)cache_insert (cache, create_cache_entry_raw (refC, "C", 1));
+
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_LOAD_MISSING_REFS,
+        "kvstxn_process returns KVSTXN_PROCESS_LOAD_MISSING_REFS");
+    count = 0;
+    ok (kvstxn_iter_missing_refs (kt, missingref_count_cb, &count) == 0
+        && count == 1,
+        "kvstxn_iter_missing_refs returns next to last blob of valref");
+    (void)cache_insert (cache, create_cache_entry_raw (refB, "B", 1));
+
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+
+    snprintf (newroot, sizeof (newroot), "%s", kvstxn_get_newroot_ref (kt));
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "log", "ABCD");
+    ok (get_valref_count (cache, newroot, "log") == 2,
+        "B, C, and D were merged into one blob");
+
+    /* many small appends are held in a few blobs
+     */
+    snprintf (expected, sizeof (expected), "ABCD");
+    for (i = 0; i < 64; i++) {
+        char val[2] = { 'a' + (i % 26), '\0' };
+
+        create_ready_kvstxn (ktm, "transaction", "log", val, FLUX_KVS_APPEND, 0);
+        if (!(kt = kvstxn_mgr_get_ready_transaction (ktm))
+            || kvstxn_process (kt, newroot, 0)
+                    != KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES
+            || kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) < 0
+            || kvstxn_process (kt, newroot, 0) != KVSTXN_PROCESS_FINISHED)
+            break;
+        snprintf (newroot, sizeof (newroot), "%s", kvstxn_get_newroot_ref (kt));
+        kvstxn_mgr_remove_transaction (ktm, kt, false);
+        strcat (expected, val);
+    }
+    ok (i == 64,
+        "appended 64 more values");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "log", expected);
+    count = get_valref_count (cache, newroot, "log");
+    ok (count > 0 && count <= 8,
+        "68 appends are held in %d blobs", count);
+
+    kvstxn_mgr_destroy (ktm);
+    ktest_finalize (cache, krm);
+    json_decref (valref);
+    json_decref (root);
+}
+
 void kvstxn_process_append_errors (void)
 {
     struct cache *cache;
@@ -3528,12 +3856,124 @@ void kvstxn_process_fallback_merge (void)
     ktest_finalize (cache, krm);
 }
 
+static int group_commit_stat (kvstxn_mgr_t *ktm, const char *name)
+{
+    json_t *o;
+    int val = -1;
+
+    if (!(o = kvstxn_mgr_get_group_commit_stats (ktm)))
+        BAIL_OUT ("kvstxn_mgr_get_group_commit_stats failed");
+    (void)json_unpack (o, "{s:i}", name, &val);
+    json_decref (o);
+    return val;
+}
+
+void kvstxn_mgr_group_commit_tests (void)
+{
+    struct cache *cache;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    char rootref[BLOBREF_MAX_STRING_SIZE];
+    double hold;
+    int count = 0;
+    json_t *o;
+    int held = -1;
+
+    cache = create_cache_with_empty_rootdir (rootref, sizeof (rootref));
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    kvstxn_mgr_set_group_commit (ktm, 0.010, 4);
+
+    /* one transaction per msec: window is limited to 3 msec, the time
+     * expected for the count limit of 4 to be reached.
+     */
+    create_ready_kvstxn (ktm, "transaction1", "key1", "1", 0, 0);
+    ok (kvstxn_mgr_group_commit_hold (ktm, 1.000) == 0.,
+        "first transaction is not held without an arrival rate estimate");
+    create_ready_kvstxn (ktm, "transaction2", "key2", "2", 0, 0);
+    hold = kvstxn_mgr_group_commit_hold (ktm, 1.001);
+    ok (hold > 0.0029 && hold < 0.0031,
+        "ready transactions are held when arriving within the window");
+    create_ready_kvstxn (ktm, "transaction3", "key3", "3", 0, 0);
+    hold = kvstxn_mgr_group_commit_hold (ktm, 1.002);
+    ok (hold > 0.0019 && hold < 0.0021,
+        "hold time is measured from the start of the hold");
+    create_ready_kvstxn (ktm, "transaction4", "key4", "4", 0, 0);
+    ok (kvstxn_mgr_group_commit_hold (ktm, 1.003) == 0.,
+        "hold ends when the count limit is reached");
+
+    ok (kvstxn_mgr_merge_ready_transactions (ktm) == 0,
+        "kvstxn_mgr_merge_ready_transactions success");
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns merged kvstxn");
+    ok (kvstxn_mgr_group_commit_hold (ktm, 1.004) == 0.,
+        "transaction being processed is not held");
+    ok (kvstxn_process (kt, rootref, 0) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_count_dirty_cb, &count) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+    ok (kvstxn_process (kt, rootref, 0) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+    ok (kvstxn_mgr_get_ready_transaction (ktm) == NULL,
+        "all four transactions were committed in one root update");
+
+    ok (group_commit_stat (ktm, "#commits") == 1
+        && group_commit_stat (ktm, "#transactions") == 4,
+        "group commit stats count one commit of four transactions");
+    ok ((o = kvstxn_mgr_get_group_commit_stats (ktm)) != NULL
+        && json_unpack (o, "{s:{s:i}}", "hold (msec)", "count", &held) == 0
+        && held == 1,
+        "group commit stats count one hold");
+    json_decref (o);
+
+    /* after an idle period, transactions are not held */
+    create_ready_kvstxn (ktm, "transaction5", "key5", "5", 0, 0);
+    ok (kvstxn_mgr_group_commit_hold (ktm, 2.000) == 0.,
+        "transaction arriving after idle period is not held");
+    create_ready_kvstxn (ktm, "transaction6", "key6", "6", 0, FLUX_KVS_NO_MERGE);
+    clear_ready_kvstxns (ktm);
+
+    /* FLUX_KVS_NO_MERGE transactions are not held */
+    kvstxn_mgr_set_group_commit (ktm, 10., 1000);
+    create_ready_kvstxn (ktm, "transaction7", "key7", "7", 0, FLUX_KVS_NO_MERGE);
+    ok (kvstxn_mgr_group_commit_hold (ktm, 2.001) == 0.,
+        "FLUX_KVS_NO_MERGE transaction is not held");
+    clear_ready_kvstxns (ktm);
+
+    /* window of 0 disables holding */
+    kvstxn_mgr_set_group_commit (ktm, 0., 1000);
+    create_ready_kvstxn (ktm, "transaction8", "key8", "8", 0, 0);
+    ok (kvstxn_mgr_group_commit_hold (ktm, 2.002) == 0.,
+        "transaction is not held with window of 0");
+    clear_ready_kvstxns (ktm);
+
+    kvstxn_mgr_set_group_commit (ktm, 10., 1000);
+    ok (kvstxn_mgr_group_commit_hold (ktm, 2.003) == 0.,
+        "kvstxn_mgr_group_commit_hold returns 0 with no ready transactions");
+
+    kvstxn_mgr_clear_group_commit_stats (ktm);
+    ok (group_commit_stat (ktm, "#commits") == 0
+        && group_commit_stat (ktm, "#transactions") == 0,
+        "kvstxn_mgr_clear_group_commit_stats works");
+
+    kvstxn_mgr_destroy (ktm);
+    cache_destroy (cache);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
 
     kvstxn_mgr_basic_tests ();
     kvstxn_mgr_merge_tests ();
+    kvstxn_mgr_group_commit_tests ();
     kvstxn_basic_tests ();
     kvstxn_corner_case_tests ();
     kvstxn_basic_kvstxn_process_test ();
@@ -3566,7 +4006,9 @@ int main (int argc, char *argv[])
     kvstxn_process_bad_dirrefs ();
     kvstxn_process_big_fileval ();
     kvstxn_process_giant_dir ();
+    kvstxn_process_sharded_dir ();
     kvstxn_process_append ();
+    kvstxn_process_append_compact ();
     kvstxn_process_append_errors ();
     kvstxn_process_append_no_duplicate ();
     kvstxn_process_fallback_merge ();
@@ -3321,6 +3321,282 @@ void lookup_stall_ref_expire_cache_entries (void) {
     json_decref (root);
 }
 
+/* lookup tests on sharded directories */
+void lookup_sharded (void) {
+    json_t *root;
+    json_t *hamt;
+    json_t *shard1;
+    json_t *shard2;
+    json_t *test;
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    lookup_t *lh1;
+    lookup_t *lh2;
+    lookup_t *lh;
+    char name1[16];
+    char name2[16];
+    char name3[16];
+    char key3[32];
+    int index1, index2;
+    int i;
+    char shard1_ref[BLOBREF_MAX_STRING_SIZE];
+    char shard2_ref[BLOBREF_MAX_STRING_SIZE];
+    char hamt_ref[BLOBREF_MAX_STRING_SIZE];
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+
+    ltest_init (&cache, &krm);
+
+    /* Pick three names that hash to different level 0 shards.
+     */
+    snprintf (name1, sizeof (name1), "key0");
+    index1 = treeobj_hamt_index (name1, 0);
+    index2 = -1;
+    for (i = 1; ; i++) {
+        char name[16];
+        int index;
+        snprintf (name, sizeof (name), "key%d", i);
+        index = treeobj_hamt_index (name, 0);
+        if (index == index1)
+            continue;
+        if (index2 < 0) {
+            snprintf (name2, sizeof (name2), "%s", name);
+            index2 = index;
+        }
+        else if (index != index2) {
+            snprintf (name3, sizeof (name3), "%s", name);
+            break;
+        }
+    }
+
+    /* This cache is
+     *
+     * shard1_ref
+     * name1 : val to "foo"
+     *
+     * shard2_ref
+     * name2 : val to "bar"
+     *
+     * hamt_ref
+     * index1 : dirref to shard1_ref
+     * index2 : dirref to shard2_ref
+     *
+     * root_ref
+     * "dir" : dirref to hamt_ref
+     */
+
+    shard1 = treeobj_create_dir ();
+    _treeobj_insert_entry_val (shard1, name1, "foo", 3);
+    treeobj_hash ("sha1", shard1, shard1_ref, sizeof (shard1_ref));
+
+    shard2 = treeobj_create_dir ();
+    _treeobj_insert_entry_val (shard2, name2, "bar", 3);
+    treeobj_hash ("sha1", shard2, shard2_ref, sizeof (shard2_ref));
+
+    hamt = treeobj_create_hamt ();
+    test = treeobj_create_dirref (shard1_ref);
+    treeobj_insert_shard (hamt, index1, test);
+    json_decref (test);
+    test = treeobj_create_dirref (shard2_ref);
+    treeobj_insert_shard (hamt, index2, test);
+    json_decref (test);
+    treeobj_hash ("sha1", hamt, hamt_ref, sizeof (hamt_ref));
+
+    root = treeobj_create_dir ();
+    _treeobj_insert_entry_dirref (root, "dir", hamt_ref);
+    treeobj_hash ("sha1", root, root_ref, sizeof (root_ref));
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+    (void)cache_insert (cache, create_cache_entry_treeobj (hamt_ref, hamt));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref, 0);
+
+    /* lookup dir.name1, should stall on shard1 */
+    ok ((lh1 = lookup_create (cache,
+                              krm,
+                              KVS_PRIMARY_NAMESPACE,
+                              NULL,
+                              0,
+                              "dir.key0",
+                              owner_cred,
+                              0,
+                              NULL)) != NULL,
+        "lookup_create dir.key0");
+    check_stall (lh1, EAGAIN, 1, shard1_ref, "dir.key0 stall");
+
+    /* readdir dir, should stall on both shards */
+    ok ((lh2 = lookup_create (cache,
+                              krm,
+                              KVS_PRIMARY_NAMESPACE,
+                              NULL,
+                              0,
+                              "dir",
+                              owner_cred,
+                              FLUX_KVS_READDIR,
+                              NULL)) != NULL,
+        "lookup_create dir");
+    check_stall (lh2, EAGAIN, 2, NULL, "readdir dir stall");
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (shard1_ref, shard1));
+    (void)cache_insert (cache, create_cache_entry_treeobj (shard2_ref, shard2));
+
+    test = treeobj_create_val ("foo", 3);
+    check_value (lh1, test, "dir.key0");
+    json_decref (test);
+
+    test = treeobj_create_dir ();
+    _treeobj_insert_entry_val (test, name1, "foo", 3);
+    _treeobj_insert_entry_val (test, name2, "bar", 3);
+    check_value (lh2, test, "readdir dir");
+    json_decref (test);
+
+    /* lookup of name in an empty shard, should be not found */
+    snprintf (key3, sizeof (key3), "dir.%s", name3);
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             key3,
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create %s", key3);
+    check_value (lh, NULL, "name in empty shard");
+
+    ltest_finalize (cache, krm);
+    json_decref (root);
+    json_decref (hamt);
+    json_decref (shard1);
+    json_decref (shard2);
+}
+
+/* prefetch refs tests */
+void lookup_prefetch (void) {
+    json_t *root;
+    json_t *dirref1;
+    json_t *dirref2;
+    json_t *dirref3;
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    lookup_t *lh;
+    struct lookup_ref_data ld;
+    char dirref1_ref[BLOBREF_MAX_STRING_SIZE];
+    char dirref2_ref[BLOBREF_MAX_STRING_SIZE];
+    char dirref3_ref[BLOBREF_MAX_STRING_SIZE];
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+
+    ltest_init (&cache, &krm);
+
+    /* This cache is
+     *
+     * dirref2_ref (not cached)
+     * "val" : val to "foo"
+     *
+     * dirref3_ref (cached)
+     * "val" : val to "bar"
+     *
+     * dirref1_ref
+     * "dirref2" : dirref to dirref2_ref
+     * "dirref3" : dirref to dirref3_ref
+     * "val" : val to "baz"
+     *
+     * root_ref
+     * "dirref1" : dirref to dirref1_ref
+     * "dirref2" : dirref to dirref2_ref
+     */
+
+    dirref2 = treeobj_create_dir ();
+    _treeobj_insert_entry_val (dirref2, "val", "foo", 3);
+    treeobj_hash ("sha1", dirref2, dirref2_ref, sizeof (dirref2_ref));
+
+    dirref3 = treeobj_create_dir ();
+    _treeobj_insert_entry_val (dirref3, "val", "bar", 3);
+    treeobj_hash ("sha1", dirref3, dirref3_ref, sizeof (dirref3_ref));
+
+    dirref1 = treeobj_create_dir ();
+    _treeobj_insert_entry_dirref (dirref1, "dirref2", dirref2_ref);
+    _treeobj_insert_entry_dirref (dirref1, "dirref3", dirref3_ref);
+    _treeobj_insert_entry_val (dirref1, "val", "baz", 3);
+    treeobj_hash ("sha1", dirref1, dirref1_ref, sizeof (dirref1_ref));
+
+    root = treeobj_create_dir ();
+    _treeobj_insert_entry_dirref (root, "dirref1", dirref1_ref);
+    _treeobj_insert_entry_dirref (root, "dirref2", dirref2_ref);
+    treeobj_hash ("sha1", root, root_ref, sizeof (root_ref));
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+    (void)cache_insert (cache, create_cache_entry_treeobj (dirref1_ref, dirref1));
+    (void)cache_insert (cache, create_cache_entry_treeobj (dirref3_ref, dirref3));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref, 0);
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "dirref1",
+                             owner_cred,
+                             FLUX_KVS_READDIR,
+                             NULL)) != NULL,
+        "lookup_create dirref1");
+    errno = 0;
+    ok (lookup_iter_prefetch_refs (lh, lookup_ref, NULL) < 0
+        && errno == EINVAL,
+        "lookup_iter_prefetch_refs fails with EINVAL before lookup");
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "lookup dirref1 finished");
+    memset (&ld, 0, sizeof (ld));
+    ok (lookup_iter_prefetch_refs (lh, lookup_ref, &ld) == 0
+        && ld.count == 1
+        && !strcmp (ld.ref, dirref2_ref),
+        "lookup_iter_prefetch_refs returns uncached subdirectory");
+    lookup_destroy (lh);
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "dirref2",
+                             owner_cred,
+                             FLUX_KVS_TREEOBJ,
+                             NULL)) != NULL,
+        "lookup_create dirref2 treeobj");
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "lookup dirref2 treeobj finished");
+    memset (&ld, 0, sizeof (ld));
+    ok (lookup_iter_prefetch_refs (lh, lookup_ref, &ld) == 0
+        && ld.count == 1
+        && !strcmp (ld.ref, dirref2_ref),
+        "lookup_iter_prefetch_refs returns uncached dirref");
+    lookup_destroy (lh);
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "dirref1.val",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create dirref1.val");
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "lookup dirref1.val finished");
+    memset (&ld, 0, sizeof (ld));
+    ok (lookup_iter_prefetch_refs (lh, lookup_ref, &ld) == 0
+        && ld.count == 0,
+        "lookup_iter_prefetch_refs returns nothing for a value");
+    lookup_destroy (lh);
+
+    ltest_finalize (cache, krm);
+    json_decref (root);
+    json_decref (dirref1);
+    json_decref (dirref2);
+    json_decref (dirref3);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -3343,6 +3619,8 @@ int main (int argc, char *argv[])
     lookup_stall_ref ();
     lookup_stall_namespace_removed ();
     lookup_stall_ref_expire_cache_entries ();
+    lookup_sharded ();
+    lookup_prefetch ();
 
     done_testing ();
     return (0);
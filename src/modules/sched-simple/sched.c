@@ -11,6 +11,7 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <limits.h>
 #include <flux/core.h>
 #include <flux/schedutil.h>
 
@@ -19,6 +20,7 @@
 #include "src/common/libutil/errprintf.h"
 #include "src/common/libjob/job.h"
 #include "src/common/libjob/jj.h"
+#include "src/common/libjob/job_hash.h"
 #include "src/common/librlist/rlist.h"
 
 // e.g. flux module debug --setbit 0x1 sched-simple
@@ -40,6 +42,25 @@ struct jobreq {
     int errnum;
 };
 
+/* A running allocation, tracked only when backfill is enabled so that
+ * the start time of the job at the head of the queue can be estimated.
+ */
+struct allocation {
+    flux_jobid_t id;
+    double expiration;      /* 0 = unknown */
+    struct rlist *rl;
+};
+
+/* Resources reserved for the job at the head of the queue, starting at
+ * 'start'.  Backfilled jobs must finish before 'start' or avoid 'rl'.
+ */
+struct reservation {
+    flux_jobid_t id;
+    double start;
+    struct rlist *rl;
+    bool valid;
+};
+
 struct simple_sched {
     flux_t *h;
     flux_future_t *acquire_f; /* resource.acquire future */
@@ -47,9 +68,12 @@ struct simple_sched {
     char *alloc_mode;             /* allocation mode */
     char *mode;             /* concurrency mode */
     unsigned int alloc_limit; /* 0 = unlimited */
+    unsigned int backfill;  /* EASY backfill queue depth, 0 = disabled */
     int schedutil_flags;
     struct rlist *rlist;    /* list of resources */
     zlistx_t *queue;        /* job queue */
+    zhashx_t *allocs;       /* running allocations (backfill only) */
+    struct reservation resv;
     schedutil_t *util_ctx;
 
     flux_watcher_t *prep;
@@ -71,6 +95,21 @@ static void jobreq_destructor (void **x)
     jobreq_destroy (*x);
 }
 
+static void allocation_destroy (struct allocation *a)
+{
+    if (a) {
+        int saved_errno = errno;
+        rlist_destroy (a->rl);
+        free (a);
+        errno = saved_errno;
+    }
+}
+
+static void allocation_destructor (void **x)
+{
+    allocation_destroy (*x);
+}
+
 #define NUMCMP(a,b) ((a)==(b)?0:((a)<(b)?-1:1))
 
 /* Taken from modules/job-manager/job.c */
@@ -148,6 +187,8 @@ static void simple_sched_destroy (flux_t *h, struct simple_sched *ss)
     }
     flux_future_destroy (ss->acquire_f);
     zlistx_destroy (&ss->queue);
+    zhashx_destroy (&ss->allocs);
+    rlist_destroy (ss->resv.rl);
     flux_watcher_destroy (ss->prep);
     flux_watcher_destroy (ss->check);
     flux_watcher_destroy (ss->idle);
@@ -208,10 +249,235 @@ static struct rlist *sched_alloc (struct simple_sched *ss,
     return rlist_alloc (ss->rlist, &ai, errp);
 }
 
+static void alloc_respond_success (struct simple_sched *ss,
+                                   struct jobreq *job,
+                                   struct rlist *alloc,
+                                   const char *R)
+{
+    char *s = rlist_dumps (alloc);
+
+    if (schedutil_alloc_respond_success_pack (ss->util_ctx,
+                                              job->msg,
+                                              R,
+                                              "{ s:{s:s s:n s:n} }",
+                                              "sched",
+                                              "resource_summary", s,
+                                              "reason_pending",
+                                              "jobs_ahead") < 0)
+        flux_log_error (ss->h, "schedutil_alloc_respond_success_pack");
+
+    flux_log (ss->h, LOG_DEBUG, "alloc: %ju: %s", (uintmax_t) job->id, s);
+    free (s);
+}
+
+/* Track allocation 'rl' of job 'id' if backfill is enabled.
+ * Takes ownership of 'rl'.
+ */
+static void allocation_add (struct simple_sched *ss,
+                            flux_jobid_t id,
+                            struct rlist *rl)
+{
+    struct allocation *a;
+
+    if (!ss->allocs) {
+        rlist_destroy (rl);
+        return;
+    }
+    if (!(a = calloc (1, sizeof (*a)))) {
+        flux_log_error (ss->h, "backfill: error tracking allocation");
+        rlist_destroy (rl);
+        return;
+    }
+    a->id = id;
+    a->expiration = rl->expiration;
+    a->rl = rl;
+    if (zhashx_insert (ss->allocs, &a->id, a) < 0) {
+        flux_log (ss->h,
+                  LOG_ERR,
+                  "backfill: duplicate allocation for %ju",
+                  (uintmax_t)id);
+        allocation_destroy (a);
+    }
+}
+
+static void allocation_remove (struct simple_sched *ss, flux_jobid_t id)
+{
+    if (ss->allocs)
+        zhashx_delete (ss->allocs, &id);
+    ss->resv.valid = false;
+}
+
+static int allocation_cmp (const void *x, const void *y)
+{
+    const struct allocation *a1 = *(const struct allocation **)x;
+    const struct allocation *a2 = *(const struct allocation **)y;
+
+    return NUMCMP (a1->expiration, a2->expiration);
+}
+
+/* Find the earliest time the job at the head of the queue could start,
+ * by releasing running allocations in order of expiration until it fits,
+ * and reserve the resources it would be allocated then.  ss->rlist is
+ * restored before returning.  If no start time can be found, e.g. jobs
+ * without an expiration hold the resources it needs, the reservation
+ * is left invalid and nothing is backfilled.
+ */
+static void reservation_update (struct simple_sched *ss, struct jobreq *head)
+{
+    struct allocation **v;
+    struct allocation *a;
+    struct rlist *rl = NULL;
+    flux_error_t error;
+    size_t released = 0;
+    size_t n = 0;
+    size_t i;
+
+    rlist_destroy (ss->resv.rl);
+    ss->resv.rl = NULL;
+    ss->resv.valid = false;
+    ss->resv.id = head->id;
+
+    if (!(v = calloc (zhashx_size (ss->allocs) + 1, sizeof (*v)))) {
+        flux_log_error (ss->h, "backfill: error computing reservation");
+        return;
+    }
+    a = zhashx_first (ss->allocs);
+    while (a) {
+        if (a->expiration > 0.)
+            v[n++] = a;
+        a = zhashx_next (ss->allocs);
+    }
+    qsort (v, n, sizeof (v[0]), allocation_cmp);
+
+    for (i = 0; i < n && !rl; i++) {
+        if (rlist_free (ss->rlist, v[i]->rl) < 0) {
+            flux_log_error (ss->h, "backfill: rlist_free");
+            break;
+        }
+        released++;
+        if (i + 1 < n && v[i + 1]->expiration == v[i]->expiration)
+            continue;
+        if ((rl = sched_alloc (ss, head, &error)))
+            ss->resv.start = v[i]->expiration;
+        else if (errno != ENOSPC)
+            break;
+    }
+    if (rl && rlist_free (ss->rlist, rl) < 0)
+        goto fatal;
+    for (i = 0; i < released; i++) {
+        if (rlist_set_allocated (ss->rlist, v[i]->rl) < 0)
+            goto fatal;
+    }
+    free (v);
+    if (rl) {
+        ss->resv.rl = rl;
+        ss->resv.valid = true;
+        flux_log (ss->h,
+                  LOG_DEBUG,
+                  "backfill: %ju reserved at %.1f",
+                  (uintmax_t)head->id,
+                  ss->resv.start);
+    }
+    return;
+fatal:
+    /*  As in feasibility_cb(), ss->rlist is now inconsistent, so exit the
+     *  reactor.  The sched module can then be reloaded without loss of jobs.
+     */
+    flux_log_error (ss->h, "backfill: failed to restore resource state");
+    flux_reactor_stop_error (flux_get_reactor (ss->h));
+    rlist_destroy (rl);
+    free (v);
+}
+
+static bool reservation_overlaps (struct simple_sched *ss, struct rlist *alloc)
+{
+    struct rlist *rl;
+    bool overlap = true;
+
+    if ((rl = rlist_intersect (alloc, ss->resv.rl))) {
+        overlap = rlist_count (rl, "core") > 0;
+        rlist_destroy (rl);
+    }
+    return overlap;
+}
+
+/* Allocate 'job' out of order if it will not delay the reserved start of
+ * the job at the head of the queue, i.e. it ends before the reservation
+ * starts or does not use any of the reserved resources.
+ */
+static int try_backfill_job (struct simple_sched *ss,
+                             struct jobreq *job,
+                             double now)
+{
+    struct rlist *alloc;
+    flux_error_t error;
+    double end = 0.;
+    char *R;
+
+    if (!(alloc = sched_alloc (ss, job, &error)))
+        return -1;
+    if (job->jj.duration > 0.)
+        end = now + job->jj.duration;
+    else if (ss->rlist->expiration > 0.)
+        end = ss->rlist->expiration;
+    if ((end == 0. || end > ss->resv.start)
+        && reservation_overlaps (ss, alloc))
+        goto nofit;
+    if (!(R = Rstring_create (ss, alloc, now, job->jj.duration)))
+        goto nofit;
+    alloc_respond_success (ss, job, alloc, R);
+    flux_log (ss->h, LOG_DEBUG, "backfill: %ju", (uintmax_t) job->id);
+    zlistx_delete (ss->queue, job->handle);
+    allocation_add (ss, job->id, alloc);
+    free (R);
+    return 0;
+nofit:
+    if (rlist_free (ss->rlist, alloc) < 0)
+        flux_log_error (ss->h, "try_backfill_job: rlist_free");
+    rlist_destroy (alloc);
+    return -1;
+}
+
+/* EASY backfill: the job at the head of the queue could not be allocated.
+ * Scan up to ss->backfill jobs behind it and start any that can run now
+ * without delaying the head job.
+ */
+static void try_backfill (struct simple_sched *ss)
+{
+    struct jobreq *head = zlistx_first (ss->queue);
+    struct jobreq **candidates;
+    struct jobreq *job;
+    double now = flux_reactor_now (flux_get_reactor (ss->h));
+    unsigned int n = 0;
+    unsigned int i;
+
+    if (!head || !ss->backfill)
+        return;
+    if (!ss->resv.valid || ss->resv.id != head->id)
+        reservation_update (ss, head);
+    if (!ss->resv.valid)
+        return;
+
+    /*  Collect candidates first, since try_backfill_job() removes jobs
+     *  from the queue.
+     */
+    if (!(candidates = calloc (ss->backfill, sizeof (candidates[0])))) {
+        flux_log_error (ss->h, "try_backfill");
+        return;
+    }
+    job = zlistx_next (ss->queue);
+    while (job && n < ss->backfill) {
+        candidates[n++] = job;
+        job = zlistx_next (ss->queue);
+    }
+    for (i = 0; i < n; i++)
+        (void)try_backfill_job (ss, candidates[i], now);
+    free (candidates);
+}
+
 static int try_alloc (flux_t *h, struct simple_sched *ss)
 {
     int rc = -1;
-    char *s = NULL;
     struct rlist *alloc = NULL;
     struct jj_counts *jj = NULL;
     char *R = NULL;
@@ -250,26 +516,15 @@ static int try_alloc (flux_t *h, struct simple_sched *ss)
             flux_log_error (h, "schedutil_alloc_respond_deny");
         goto out;
     }
-    s = rlist_dumps (alloc);
-
-    if (schedutil_alloc_respond_success_pack (ss->util_ctx,
-                                              job->msg,
-                                              R,
-                                              "{ s:{s:s s:n s:n} }",
-                                              "sched",
-                                              "resource_summary", s,
-                                              "reason_pending",
-                                              "jobs_ahead") < 0)
-        flux_log_error (h, "schedutil_alloc_respond_success_pack");
-
-    flux_log (h, LOG_DEBUG, "alloc: %ju: %s", (uintmax_t) job->id, s);
+    alloc_respond_success (ss, job, alloc, R);
+    allocation_add (ss, job->id, alloc);
+    alloc = NULL;
     rc = 0;
 
 out:
     zlistx_delete (ss->queue, job->handle);
     rlist_destroy (alloc);
     free (R);
-    free (s);
     return rc;
 }
 
@@ -318,6 +573,7 @@ static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
      *  watcher, i.e. block. O/w, retry on next loop.
      */
     if (try_alloc (ss->h, ss) < 0 && errno == ENOSPC) {
+        try_backfill (ss);
         annotate_reason_pending (ss);
         flux_watcher_stop (ss->prep);
         flux_watcher_stop (ss->check);
@@ -346,6 +602,7 @@ static int try_free (flux_t *h, struct simple_sched *ss, const char *R)
 void free_cb (flux_t *h, const flux_msg_t *msg, const char *R, void *arg)
 {
     struct simple_sched *ss = arg;
+    flux_jobid_t id;
 
     if (!R) {
         flux_log (h, LOG_ERR, "free: R is NULL");
@@ -359,6 +616,8 @@ void free_cb (flux_t *h, const flux_msg_t *msg, const char *R, void *arg)
             flux_log_error (h, "free_cb: flux_respond_error");
         return;
     }
+    if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) == 0)
+        allocation_remove (ss, id);
     if (schedutil_free_respond (ss->util_ctx, msg) < 0)
         flux_log_error (h, "free_cb: schedutil_free_respond");
 
@@ -523,12 +782,15 @@ static int hello_cb (flux_t *h,
         return -1;
     }
     s = rlist_dumps (alloc);
-    if ((rc = rlist_set_allocated (ss->rlist, alloc)) < 0)
+    if ((rc = rlist_set_allocated (ss->rlist, alloc)) < 0) {
         flux_log_error (h, "hello: rlist_remove (%s)", s);
-    else
+        rlist_destroy (alloc);
+    }
+    else {
         flux_log (h, LOG_DEBUG, "hello: alloc %s", s);
+        allocation_add (ss, id, alloc);
+    }
     free (s);
-    rlist_destroy (alloc);
     return rc;
 }
 
@@ -683,6 +945,7 @@ static int ss_resource_update (struct simple_sched *ss, flux_future_t *f)
         flux_log_error (ss->h, "failed to update resource state");
         goto err;
     }
+    ss->resv.valid = false;
     rc = 0;
 err:
     flux_future_reset (f);
@@ -840,6 +1103,16 @@ static int process_args (flux_t *h, struct simple_sched *ss,
         else if (strncmp ("mode=", argv[i], 5) == 0) {
             set_mode (ss, argv[i]+5);
         }
+        else if (strncmp ("backfill=", argv[i], 9) == 0) {
+            char *endptr;
+            long n = strtol (argv[i]+9, &endptr, 0);
+            if (*endptr != '\0' || n < 0 || n > UINT_MAX) {
+                flux_log (h, LOG_ERR, "invalid backfill value: %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+            ss->backfill = n;
+        }
         else if (strcmp ("test-free-nolookup", argv[i]) == 0) {
             ss->schedutil_flags |= SCHEDUTIL_FREE_NOLOOKUP;
         }
@@ -892,6 +1165,12 @@ int mod_main (flux_t *h, int argc, char **argv)
     zlistx_set_comparator (ss->queue, jobreq_cmp);
     zlistx_set_destructor (ss->queue, jobreq_destructor);
 
+    if (ss->backfill > 0) {
+        if (!(ss->allocs = job_hash_create ()))
+            goto done;
+        zhashx_set_destructor (ss->allocs, allocation_destructor);
+    }
+
     /* Let `flux module load simple-sched` return before synchronous
      * initialization with resource and job-manager modules.
      */
@@ -0,0 +1,151 @@
+/************************************************************\
+ * Copyright 2023 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Usage: content-batch [--bypass] store N
+ *        content-batch [--bypass] load <blobrefs
+ *
+ * store: store N generated blobs in one batch and print their blobrefs
+ * load: load blobrefs from stdin in one batch and print "blobref size"
+ *       or "blobref error-string" for each
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <unistd.h>
+#include <string.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/log.h"
+#include "src/common/libcontent/content.h"
+
+static void usage (void)
+{
+    fprintf (stderr, "Usage: content-batch [--bypass] store N\n"
+                     "   or: content-batch [--bypass] load <blobrefs\n");
+    exit (1);
+}
+
+static void batch_store (flux_t *h, int count, int flags)
+{
+    const void **bufs;
+    int *lens;
+    flux_future_t *f;
+    int i;
+
+    if (!(bufs = calloc (count, sizeof (bufs[0])))
+        || !(lens = calloc (count, sizeof (lens[0]))))
+        log_msg_exit ("out of memory");
+    for (i = 0; i < count; i++) {
+        char *s;
+        if (asprintf (&s, "content-batch seq=%d", i) < 0)
+            log_msg_exit ("out of memory");
+        bufs[i] = s;
+        lens[i] = strlen (s);
+    }
+    if (!(f = content_store_batch (h, bufs, lens, count, flags)))
+        log_err_exit ("content_store_batch");
+    for (i = 0; i < count; i++) {
+        const void *hash;
+        int hash_size;
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+
+        if (content_store_batch_get_hash (f, i, &hash, &hash_size) < 0)
+            log_msg_exit ("store-batch: %s", future_strerror (f, errno));
+        if (blobref_hashtostr (flux_attr_get (h, "content.hash"),
+                               hash,
+                               hash_size,
+                               blobref,
+                               sizeof (blobref)) < 0)
+            log_err_exit ("blobref_hashtostr");
+        printf ("%s\n", blobref);
+    }
+    flux_future_destroy (f);
+    for (i = 0; i < count; i++)
+        free ((void *)bufs[i]);
+    free (bufs);
+    free (lens);
+}
+
+static void batch_load (flux_t *h, int flags)
+{
+    char line[BLOBREF_MAX_STRING_SIZE + 2];
+    char (*blobrefs)[BLOBREF_MAX_STRING_SIZE] = NULL;
+    uint8_t *hashes = NULL;
+    int hash_size = 0;
+    int count = 0;
+    flux_future_t *f;
+    int i;
+
+    while (fgets (line, sizeof (line), stdin)) {
+        uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+        int n;
+
+        line[strcspn (line, "\n")] = '\0';
+        if ((n = blobref_strtohash (line, hash, sizeof (hash))) < 0)
+            log_msg_exit ("%s: invalid blobref", line);
+        if (!(hashes = realloc (hashes, (count + 1) * n))
+            || !(blobrefs = realloc (blobrefs,
+                                     (count + 1) * sizeof (blobrefs[0]))))
+            log_msg_exit ("out of memory");
+        memcpy (hashes + count * n, hash, n);
+        strcpy (blobrefs[count], line);
+        hash_size = n;
+        count++;
+    }
+    if (count == 0)
+        log_msg_exit ("no blobrefs on stdin");
+    if (!(f = content_load_batch (h, hashes, hash_size, count, flags)))
+        log_err_exit ("content_load_batch");
+    for (i = 0; i < count; i++) {
+        const void *buf;
+        int len;
+
+        if (content_load_batch_get (f, i, &buf, &len, NULL) < 0) {
+            if (errno == EPROTO || errno == ENOSYS)
+                log_msg_exit ("load-batch: %s", future_strerror (f, errno));
+            printf ("%s %s\n", blobrefs[i], strerror (errno));
+        }
+        else
+            printf ("%s %d\n", blobrefs[i], len);
+    }
+    flux_future_destroy (f);
+    free (hashes);
+    free (blobrefs);
+}
+
+int main (int argc, char *argv[])
+{
+    flux_t *h;
+    int flags = 0;
+    int optind = 1;
+
+    if (argc > optind && !strcmp (argv[optind], "--bypass")) {
+        flags = CONTENT_FLAG_CACHE_BYPASS;
+        optind++;
+    }
+    if (argc - optind < 1)
+        usage ();
+    if (!(h = flux_open (NULL, 0)))
+        log_err_exit ("flux_open");
+    if (!strcmp (argv[optind], "store") && argc - optind == 2)
+        batch_store (h, strtoul (argv[optind + 1], NULL, 10), flags);
+    else if (!strcmp (argv[optind], "load") && argc - optind == 1)
+        batch_load (h, flags);
+    else
+        usage ();
+    flux_close (h);
+    return 0;
+}
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
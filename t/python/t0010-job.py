@@ -724,7 +724,33 @@ class TestJob(unittest.TestCase):
             dt = job.timeleft(self.fh)
         except OSError:
             pass
-        
+
+    def test_35_submit_bulk(self):
+        jobspec = JobspecV1.from_command(["true"])
+        jobspecs = [jobspec, jobspec.dumps(), "{", jobspec]
+        ids = job.submit_bulk(self.fh, jobspecs)
+        self.assertEqual(len(ids), 4)
+        self.assertIsInstance(ids[2], OSError)
+        self.assertEqual(ids[2].errno, errno.EINVAL)
+        valid = [ids[0], ids[1], ids[3]]
+        for jobid in valid:
+            self.assertIsInstance(jobid, JobID)
+        # jobids are assigned in the order jobs were submitted
+        self.assertEqual(valid, sorted(set(valid)))
+
+        future = job.submit_bulk_async(self.fh, [jobspec, jobspec], urgency=0)
+        ids = future.get_ids()
+        self.assertEqual(len(ids), 2)
+        for jobid in ids:
+            self.assertEqual(job.get_job(self.fh, jobid)["urgency"], 0)
+            job.cancel(self.fh, jobid)
+
+        self.assertEqual(job.submit_bulk(self.fh, []), [])
+
+        with self.assertRaises(EnvironmentError) as error:
+            job.submit_bulk_get_ids(ffi.NULL)
+        self.assertEqual(error.exception.errno, errno.EINVAL)
+
 if __name__ == "__main__":
     from subflux import rerun_under_flux
 
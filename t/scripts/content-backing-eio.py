@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+###############################################################
+# Copyright 2023 Lawrence Livermore National Security, LLC
+# (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+#
+# This file is part of the Flux resource manager framework.
+# For details, see https://github.com/flux-framework.
+#
+# SPDX-License-Identifier: LGPL-3.0
+###############################################################
+#
+# Register a content backing store named NAME that fails every
+# store-batch request with EIO, store a blob, then check that each
+# content.flush request fails with EIO rather than hanging.
+#
+# Usage: flux python content-backing-eio.py NAME
+#
+import errno
+import subprocess
+import sys
+
+import flux
+from flux.constants import FLUX_MSGTYPE_REQUEST
+
+h = flux.Flux()
+batches = [0]
+flushes = [0]
+
+
+def store_batch_cb(h, t, msg, arg):
+    batches[0] += 1
+    h.respond_error(msg, errno.EIO, "injected store failure")
+
+
+def flush_cb(future):
+    try:
+        future.get()
+        print("content.flush unexpectedly succeeded")
+        sys.exit(1)
+    except OSError as exc:
+        if exc.errno != errno.EIO:
+            raise
+    flushes[0] += 1
+    if flushes[0] < 2:
+        h.rpc("content.flush", nodeid=0).then(flush_cb)
+    else:
+        h.reactor_stop()
+
+
+h.service_register("content-backing").get()
+w = h.msg_watcher_create(
+    store_batch_cb, FLUX_MSGTYPE_REQUEST, "content-backing.store-batch"
+)
+w.start()
+h.rpc("content.register-backing", {"name": sys.argv[1]}, nodeid=0).get()
+
+subprocess.run(["flux", "content", "store"], input=b"eio-blob", check=True)
+
+h.rpc("content.flush", nodeid=0).then(flush_cb)
+h.reactor_run()
+
+h.rpc("content.unregister-backing", {"name": sys.argv[1]}, nodeid=0).get()
+print(f"flushes={flushes[0]} batches={batches[0]}")
+if batches[0] < 2:
+    sys.exit(1)
@@ -12,6 +12,8 @@ echo "# $0: flux session size will be ${SIZE}"
 BLOBREF=${FLUX_BUILD_DIR}/t/kvs/blobref
 RPC=${FLUX_BUILD_DIR}/t/request/rpc
 SPAMUTIL=${FLUX_BUILD_DIR}/t/kvs/content-spam
+BATCHUTIL=${FLUX_BUILD_DIR}/t/content/content-batch
+BACKING_EIO="flux python ${SHARNESS_TEST_SRCDIR}/scripts/content-backing-eio.py"
 
 MAXBLOB=`flux getattr content.blob-size-limit`
 HASHFUN=`flux getattr content.hash`
@@ -182,6 +184,39 @@ test_expect_success 'store 1K blobs from all ranks using async RPC' '
 	flux exec -n ${SPAMUTIL} 1024 256 >/dev/null
 '
 
+test_expect_success 'store a batch of 16 blobs on rank 0' '
+	${BATCHUTIL} store 16 >batch.refs &&
+	test $(wc -l <batch.refs) -eq 16
+'
+test_expect_success 'batch blobrefs match individually computed ones' '
+	for i in $(seq 0 15); do \
+	    printf "content-batch seq=$i" | $BLOBREF $HASHFUN; \
+	done >batch.refs.expected &&
+	test_cmp batch.refs.expected batch.refs
+'
+test_expect_success 'load the batch on all ranks' '
+	flux exec -n sh -c "${BATCHUTIL} load <batch.refs" >batch.load.out &&
+	test $(wc -l <batch.load.out) -eq $((16*${SIZE})) &&
+	test_must_fail grep "No such" batch.load.out
+'
+test_expect_success 'store a batch on rank 3 and load it on rank 0' '
+	flux exec -n -r 3 ${BATCHUTIL} store 32 >batch3.refs &&
+	${BATCHUTIL} load <batch3.refs >batch3.load.out &&
+	test $(wc -l <batch3.load.out) -eq 32 &&
+	test_must_fail grep "No such" batch3.load.out
+'
+test_expect_success 'load batch reports a missing blob without failing' '
+	echo nonexistent | $BLOBREF $HASHFUN >missing.ref &&
+	cat missing.ref batch.refs | ${BATCHUTIL} load >missing.out &&
+	head -1 missing.out | grep "No such file or directory" &&
+	test $(grep -v -c "No such" missing.out) -eq 16
+'
+test_expect_success 'load-batch request with bad hash size fails with EPROTO(71)' '
+	echo -n xxx | ${RPC} content.load-batch 71
+'
+test_expect_success 'store-batch request with empty payload fails with EPROTO(71)' '
+	${RPC} content.store-batch 71 </dev/null
+'
 test_expect_success 'load request with empty payload fails with EPROTO(71)' '
 	${RPC} content.load 71 </dev/null
 '
@@ -213,5 +248,9 @@ test_expect_success 'content store --chunksize=-1 fails' '
 test_expect_success 'content load with no blobrefs fails' '
 	test_must_fail flux content load </dev/null
 '
+test_expect_success 'flush fails and dirty entries are retried when backing store fails' '
+	run_timeout 30 $BACKING_EIO foo >backing-eio.out &&
+	grep "flushes=2" backing-eio.out
+'
 
 test_done
@@ -14,6 +14,7 @@ echo "# $0: flux session size will be ${SIZE}"
 BLOBREF=${FLUX_BUILD_DIR}/t/kvs/blobref
 RPC=${FLUX_BUILD_DIR}/t/request/rpc
 SPAMUTIL="${FLUX_BUILD_DIR}/t/kvs/content-spam"
+BATCHUTIL="${FLUX_BUILD_DIR}/t/content/content-batch"
 rc1_kvs=$SHARNESS_TEST_SRCDIR/rc/rc1-kvs
 rc3_kvs=$SHARNESS_TEST_SRCDIR/rc/rc3-kvs
 
@@ -115,10 +116,60 @@ test_expect_success 'exercise batching of synchronous flush to backing store' '
 	test ${NDIRTY} -eq 0
 '
 
+test_expect_success 'content.purge-max-size bounds the clean cache' '
+	flux setattr content.purge-max-size 65536 &&
+	${SPAMUTIL} 1000 200 >/dev/null &&
+	flux content flush &&
+	test $(flux module stats --type int --parse size content) -le 65536 &&
+	test $(flux module stats \
+	    --type int --parse probation.evictions content) -gt 0
+'
+test_expect_success 'a second load promotes an entry to the protected segment' '
+	flux content dropcache &&
+	hash=$(echo protectme | flux content store) &&
+	flux content flush &&
+	flux content dropcache &&
+	flux content load $hash >/dev/null &&
+	test $(flux module stats \
+	    --type int --parse protected.count content) -eq 0 &&
+	flux content load $hash >/dev/null &&
+	test $(flux module stats \
+	    --type int --parse protected.count content) -eq 1 &&
+	test $(flux module stats \
+	    --type int --parse probation.hits content) -ge 1
+'
+test_expect_success 'content.purge-max-size=0 disables the limit' '
+	flux setattr content.purge-max-size 0
+'
 test_expect_success 'drop the cache' '
 	flux content dropcache
 '
 
+test_expect_success 'store a batch of blobs bypassing cache' '
+	${BATCHUTIL} --bypass store 50 >batch.refs &&
+	test $(wc -l <batch.refs) -eq 50 &&
+	test $(flux module stats \
+	    --type int --parse store_batch_time.count content-sqlite) -ge 1
+'
+test_expect_success 'load the batch bypassing cache' '
+	${BATCHUTIL} --bypass load <batch.refs >batch.out &&
+	test_must_fail grep "No such" batch.out &&
+	test $(flux module stats \
+	    --type int --parse load_batch_time.count content-sqlite) -ge 1
+'
+test_expect_success 'load the batch through the cache on all ranks' '
+	flux exec -n sh -c "${BATCHUTIL} load <batch.refs" >batch.all.out &&
+	test_must_fail grep "No such" batch.all.out
+'
+test_expect_success 'cache flush uses store-batch' '
+	count=$(flux module stats \
+	    --type int --parse store_batch_time.count content-sqlite) &&
+	${SPAMUTIL} 100 100 >/dev/null &&
+	flux content flush &&
+	test $(flux module stats \
+	    --type int --parse store_batch_time.count content-sqlite) -gt $count
+'
+
 test_expect_success 'fill the cache with more data for later purging' '
 	${SPAMUTIL} 10000 200 >/dev/null
 '
@@ -168,6 +219,30 @@ test_expect_success 'flush + reload content-sqlite module on rank 0' '
 	flux module reload content-sqlite
 '
 
+test_expect_success 'bloom filter was rebuilt from the objects table' '
+	test $(flux module stats \
+	    --type int --parse bloom.entries content-sqlite) -ge \
+	    $(flux module stats --type int --parse object_count content-sqlite)
+'
+test_expect_success 'load of a missing blob is a bloom filter negative' '
+	count=$(flux module stats \
+	    --type int --parse bloom.negatives content-sqlite) &&
+	echo notstored >notstored.blob &&
+	test_must_fail flux content load --bypass-cache \
+	    $($BLOBREF $HASHFUN <notstored.blob) 2>notstored.err &&
+	grep "No such file or directory" notstored.err &&
+	test $(flux module stats \
+	    --type int --parse bloom.negatives content-sqlite) -gt $count
+'
+test_expect_success 'store of an existing blob is skipped' '
+	count=$(flux module stats \
+	    --type int --parse bloom.duplicates content-sqlite) &&
+	flux content store --bypass-cache <64.0.store >64.0.hash.dup &&
+	test_cmp 64.0.hash 64.0.hash.dup &&
+	test $(flux module stats \
+	    --type int --parse bloom.duplicates content-sqlite) -gt $count
+'
+
 test_expect_success 'checkpoint-get foo still returns rootref baz' '
 	echo baz >rootref3.exp &&
 	checkpoint_get foo | jq -r .value | jq -r .rootref >rootref3.out &&
@@ -327,7 +402,189 @@ test_expect_success 'reload module with no options and verify modes' '
 	flux dmesg >logs2 &&
 	grep "journal_mode=OFF synchronous=OFF" logs2
 '
+test_expect_success 'reload module with unknown compression fails' '
+	flux module remove -f content-sqlite &&
+	test_must_fail flux module load content-sqlite compression=lzo
+'
+test_expect_success 'reload module with compression=lz4 compression_threads=4' '
+	flux dmesg --clear &&
+	flux module load content-sqlite compression=lz4 compression_threads=4 &&
+	flux dmesg >logs4 &&
+	grep "compression=lz4 threads=4" logs4
+'
+test_expect_success 'large blobs are compressed in worker threads' '
+	yes compressible | head -c 1048576 >zblob.large &&
+	flux content store --bypass-cache <zblob.large >zblob.ref &&
+	test $(flux module stats --type int \
+	    --parse compression.compress_time.count content-sqlite) -eq 1 &&
+	flux content load --bypass-cache $(cat zblob.ref) >zblob.large.out &&
+	test_cmp zblob.large zblob.large.out &&
+	test $(flux module stats --type int \
+	    --parse compression.decompress_time.count content-sqlite) -eq 1
+'
+test_expect_success 'incompressible large blobs can be stored' '
+	dd if=/dev/urandom bs=65536 count=4 2>/dev/null >rblob &&
+	flux content store --bypass-cache <rblob >rblob.ref &&
+	flux content load --bypass-cache $(cat rblob.ref) >rblob.out &&
+	test_cmp rblob rblob.out
+'
+test_expect_success 'reload module with compression=none' '
+	flux module reload content-sqlite compression=none &&
+	test "$(flux module stats content-sqlite | jq -r .compression.codec)" \
+	    = "none"
+'
+test_expect_success 'lz4 compressed blobs can be loaded with compression=none' '
+	flux content load --bypass-cache $(cat zblob.ref) >zblob.large.out2 &&
+	test_cmp zblob.large zblob.large.out2
+'
+test_expect_success 'blobs stored with compression=none can be loaded with lz4' '
+	yes uncompressed | head -c 100000 >ublob &&
+	flux content store --bypass-cache <ublob >ublob.ref &&
+	flux module reload content-sqlite compression=lz4 compression_threads=0 &&
+	flux content load --bypass-cache $(cat ublob.ref) >ublob.out &&
+	test_cmp ublob ublob.out
+'
+test_expect_success 'reload module with bad group_commit_window fails' '
+	flux module remove -f content-sqlite &&
+	test_must_fail flux module load content-sqlite group_commit_window=xyz
+'
+test_expect_success 'reload module with bad group_commit_max fails' '
+	test_must_fail flux module load content-sqlite group_commit_max=0
+'
+test_expect_success 'reload module with group commit enabled' '
+	flux dmesg --clear &&
+	flux module load content-sqlite \
+	    group_commit_window=10ms group_commit_max=8 &&
+	flux dmesg >logs3 &&
+	grep "group commit enabled: window=0.010s max=8" logs3
+'
+test_expect_success 'group commit parameters are reported in stats' '
+	test $(flux module stats --type int \
+	    --parse group_commit.max_count content-sqlite) -eq 8
+'
+test_expect_success 'stores complete with group commit enabled' '
+	for i in $(seq 1 20); do \
+	    echo gc$i | flux content store --bypass-cache >gc$i.ref || exit 1; \
+	done &&
+	for i in $(seq 1 20); do \
+	    flux content load --bypass-cache $(cat gc$i.ref) >gc$i.out && \
+	    echo gc$i | test_cmp - gc$i.out || exit 1; \
+	done
+'
+test_expect_success 'concurrent stores are committed in groups' '
+	${SPAMUTIL} 64 16 >/dev/null &&
+	flux content flush &&
+	test $(flux module stats --type int \
+	    --parse group_commit.batch_size.max content-sqlite) -gt 1 &&
+	test $(flux module stats --type int \
+	    --parse group_commit.commit_time.count content-sqlite) -gt 0
+'
+test_expect_success 'store batches join the group commit' '
+	${BATCHUTIL} --bypass store 4 >gcbatch.refs &&
+	${BATCHUTIL} --bypass load <gcbatch.refs >gcbatch.out &&
+	test_must_fail grep "No such" gcbatch.out
+'
+test_expect_success 'stores survive module reload with group commit' '
+	flux module reload content-sqlite group_commit_window=10ms &&
+	flux content load --bypass-cache $(cat gc20.ref) >gc20.out2 &&
+	echo gc20 | test_cmp - gc20.out2
+'
+
 
+test_expect_success 'reload module with truncate option for gc tests' '
+	flux module reload content-sqlite truncate
+'
+test_expect_success 'store a directory that references a value, and garbage' '
+	echo sweepleaf | flux content store --bypass-cache >sweepleaf.ref &&
+	printf "{\"ver\":1,\"type\":\"dir\",\"data\":{\"a\":{\"ver\":1,\"type\":\"valref\",\"data\":[\"%s\"]}}}" \
+	    $(cat sweepleaf.ref) >sweepdir.blob &&
+	flux content store --bypass-cache <sweepdir.blob >sweepdir.ref &&
+	echo sweepgarbage | flux content store --bypass-cache >sweepgarbage.ref &&
+	test $(flux module stats \
+	    --type int --parse object_count content-sqlite) -eq 3
+'
+test_expect_success 'gc with a checkpoint rootref that is not a blobref fails' '
+	checkpoint_backing_put sweep notablobref &&
+	test_must_fail flux content gc 2>sweepbad.err &&
+	grep "checkpoint roots" sweepbad.err &&
+	test $(flux module stats \
+	    --type int --parse object_count content-sqlite) -eq 3
+'
+test_expect_success 'gc keeps blobs stored since the previous gc' '
+	checkpoint_backing_put sweep $(cat sweepdir.ref) &&
+	flux content gc >sweep0.json &&
+	test $(jq .removed sweep0.json) -eq 0 &&
+	test $(jq .stored sweep0.json) -eq 3 &&
+	flux content load --bypass-cache $(cat sweepgarbage.ref)
+'
+test_expect_success 'gc removes only blobs unreachable from the checkpoint' '
+	flux content gc >sweep.json &&
+	test $(jq .removed sweep.json) -eq 1 &&
+	test $(jq .marked sweep.json) -eq 2 &&
+	test $(jq .reclaimed_bytes sweep.json) -gt 0 &&
+	test $(flux module stats \
+	    --type int --parse object_count content-sqlite) -eq 2 &&
+	flux content load --bypass-cache $(cat sweepleaf.ref) &&
+	flux content load --bypass-cache $(cat sweepdir.ref) &&
+	test_must_fail flux content load --bypass-cache $(cat sweepgarbage.ref)
+'
+test_expect_success 'gc is reported in module stats' '
+	flux module stats content-sqlite >sweepstats.json &&
+	test $(jq .gc.state sweepstats.json) = "\"idle\"" &&
+	test $(jq .gc.cycles sweepstats.json) -eq 3 &&
+	test $(jq .gc.failures sweepstats.json) -eq 1 &&
+	test $(jq .gc.removed sweepstats.json) -eq 1
+'
+test_expect_success 'bloom filter forgets removed blobs' '
+	count=$(flux module stats \
+	    --type int --parse bloom.negatives content-sqlite) &&
+	test_must_fail flux content load --bypass-cache \
+	    $(cat sweepgarbage.ref) &&
+	test $(flux module stats \
+	    --type int --parse bloom.negatives content-sqlite) -gt $count
+'
+test_expect_success 'gc keeps a blob stored again since the previous gc' '
+	echo sweepagain | flux content store --bypass-cache >sweepagain.ref &&
+	flux content gc >sweepagain1.json &&
+	test $(jq .stored sweepagain1.json) -eq 1 &&
+	echo sweepagain | flux content store --bypass-cache &&
+	flux content gc >sweepagain2.json &&
+	test $(jq .stored sweepagain2.json) -eq 1 &&
+	test $(jq .removed sweepagain2.json) -eq 0 &&
+	flux content gc >sweepagain3.json &&
+	test $(jq .stored sweepagain3.json) -eq 0 &&
+	test $(jq .removed sweepagain3.json) -eq 1 &&
+	test_must_fail flux content load --bypass-cache $(cat sweepagain.ref)
+'
+test_expect_success 'KVS content survives gc in an instance' '
+	flux start -o,-Sbroker.rc1_path=$rc1_kvs,-Sbroker.rc3_path=$rc3_kvs \
+	    bash -c "flux kvs put sweep.a=old && \
+	        flux kvs put sweep.a=new sweep.b=\$(printf %0500d 0) && \
+	        echo sweepgarbage | flux content store >/dev/null && \
+	        flux content flush && \
+	        flux content gc >/dev/null && \
+	        flux content gc >sweepkvs.json && \
+	        flux content dropcache && \
+	        flux kvs get sweep.a && \
+	        flux kvs get sweep.b >/dev/null" >sweepkvs.out &&
+	echo new >sweepkvs.exp &&
+	test_cmp sweepkvs.exp sweepkvs.out &&
+	test $(jq .removed sweepkvs.json) -gt 0
+'
+test_expect_success 'blob stored before gc can be referenced after it' '
+	cat >sweeplate.sh <<-EOT &&
+	flux content store <sweeplate.blob >sweeplate.ref
+	flux content flush
+	flux content gc >/dev/null
+	flux kvs put --treeobj late="{\"ver\":1,\"type\":\"valref\",\"data\":[\"\$(cat sweeplate.ref)\"]}"
+	flux content dropcache
+	flux kvs get --raw late
+	EOT
+	echo late >sweeplate.blob &&
+	flux start -o,-Sbroker.rc1_path=$rc1_kvs,-Sbroker.rc3_path=$rc3_kvs \
+	    bash -e sweeplate.sh >sweeplate.out &&
+	test_cmp sweeplate.blob sweeplate.out
+'
 
 test_expect_success 'run flux without statedir and verify modes' '
 	flux start -o,-Sbroker.rc1_path=$rc1_kvs,-Sbroker.rc3_path=$rc3_kvs \
@@ -118,6 +118,83 @@ test_expect_success 'load with invalid hash size fails with EPROTO' '
 	grep "Protocol error" badhash.err
 '
 
+test_expect_success 'compressible blobs are stored compressed' '
+	yes compressible | head -c 1048576 >zblob.large &&
+	yes compressible | head -c 1000 >zblob.small &&
+	backing_store <zblob.large >zhash.large &&
+	backing_store <zblob.small >zhash.small &&
+	test $(stat -c %s content.files/$($BLOBREF sha1 <zblob.large)) \
+	    -lt 1048576 &&
+	test $(stat -c %s content.files/$($BLOBREF sha1 <zblob.small)) \
+	    -lt 1000
+'
+test_expect_success 'compressed blobs can be loaded' '
+	backing_load <zhash.large >zblob.large.out &&
+	test_cmp zblob.large zblob.large.out &&
+	backing_load <zhash.small >zblob.small.out &&
+	test_cmp zblob.small zblob.small.out
+'
+test_expect_success 'blob file added behind the module is not found' '
+	yes hidden | head -c 4096 >hidden.blob &&
+	$TEST_STORE $(pwd)/content.files $($BLOBREF sha1 <hidden.blob) \
+	    <hidden.blob &&
+	test_must_fail flux content load --bypass-cache \
+	    $($BLOBREF sha1 <hidden.blob)
+'
+test_expect_success 'reload content-files module with confirm_negatives' '
+	flux module reload content-files testing confirm_negatives
+'
+test_expect_success 'uncompressed blob files from earlier versions can be loaded' '
+	yes legacy | head -c 4096 >legacy.blob &&
+	$TEST_STORE $(pwd)/content.files $($BLOBREF sha1 <legacy.blob) \
+	    <legacy.blob &&
+	flux content load --bypass-cache $($BLOBREF sha1 <legacy.blob) \
+	    >legacy.blob.out &&
+	test_cmp legacy.blob legacy.blob.out
+'
+test_expect_success 'blob file added behind the module was a bloom filter negative' '
+	test $(flux module stats \
+	    --type int --parse bloom.false_negatives content-files) -gt 0
+'
+test_expect_success 'blob that begins with the header magic can be stored' '
+	printf "\211FLXZ\001\001\000\000\000\000\005hello" >magic.blob &&
+	backing_store <magic.blob >magic.hash &&
+	backing_load <magic.hash >magic.blob.out &&
+	test_cmp magic.blob magic.blob.out
+'
+test_expect_success 'content-files module fails with unknown compression' '
+	flux module remove content-files &&
+	test_must_fail flux module load content-files testing compression=lzo
+'
+test_expect_success 'content-files module fails with bad compression_threads' '
+	test_must_fail flux module load content-files testing \
+	    compression_threads=-1
+'
+test_expect_success 'load content-files module with compression=none' '
+	flux module load content-files testing compression=none &&
+	test "$(flux module stats content-files | jq -r .compression.codec)" \
+	    = "none"
+'
+test_expect_success 'compressed blobs can be loaded with compression=none' '
+	backing_load <zhash.large >zblob.large.out2 &&
+	test_cmp zblob.large zblob.large.out2
+'
+test_expect_success 'new blobs are stored uncompressed with compression=none' '
+	yes uncompressed | head -c 1000 >zblob.none &&
+	backing_store <zblob.none >zhash.none &&
+	test_cmp zblob.none content.files/$($BLOBREF sha1 <zblob.none)
+'
+test_expect_success 'reload content-files module with compression_threads=0' '
+	flux module reload content-files testing compression_threads=0 &&
+	test $(flux module stats \
+	    --type int --parse compression.threads content-files) -eq 0 &&
+	backing_load <zhash.large >zblob.large.out3 &&
+	test_cmp zblob.large zblob.large.out3
+'
+test_expect_success 'reload content-files module' '
+	flux module reload content-files testing
+'
+
 ##
 # Tests of the module acting as backing store for content cache
 ##
@@ -150,12 +227,78 @@ test_expect_success 'flux module stats reports nonzero object count' '
 	test $(flux module stats \
 	    --type int --parse object_count content-files) -gt 0
 '
+test_expect_success 'bloom filter was built from existing blob files' '
+	test $(flux module stats \
+	    --type int --parse bloom.entries content-files) -gt 0 &&
+	test $(flux module stats \
+	    --type int --parse bloom.rebuilds content-files) -ge 1
+'
+test_expect_success 'load of a missing blob is a bloom filter negative' '
+	dd if=/dev/urandom bs=20 count=1 2>/dev/null >missing.hash &&
+	count=$(flux module stats \
+	    --type int --parse bloom.negatives content-files) &&
+	test_must_fail backing_load <missing.hash 2>missing.err &&
+	grep "No such file or directory" missing.err &&
+	test $(flux module stats \
+	    --type int --parse bloom.negatives content-files) -gt $count
+'
+test_expect_success 'store of an existing blob is skipped' '
+	count=$(flux module stats \
+	    --type int --parse bloom.duplicates content-files) &&
+	backing_store <zblob.small >zhash.small.dup &&
+	test_cmp zhash.small zhash.small.dup &&
+	test $(flux module stats \
+	    --type int --parse bloom.duplicates content-files) -gt $count
+'
 test_expect_success 'reload content-files with truncate option' '
 	flux module reload content-files truncate
 '
 test_expect_success 'flux module stats reports zero object count' '
 	test $(flux module stats \
-	    --type int --parse object_count content-files) -eq 0
+	    --type int --parse object_count content-files) -eq 0 &&
+	test $(flux module stats \
+	    --type int --parse bloom.entries content-files) -eq 0
+'
+test_expect_success 'store a directory that references a value, and garbage' '
+	echo sweepleaf | backing_store >sweepleaf.hash &&
+	printf "{\"ver\":1,\"type\":\"dir\",\"data\":{\"a\":{\"ver\":1,\"type\":\"valref\",\"data\":[\"%s\"]}}}" \
+	    $(echo sweepleaf | $BLOBREF sha1) >sweepdir.blob &&
+	backing_store <sweepdir.blob >sweepdir.hash &&
+	echo sweepgarbage | backing_store >sweepgarbage.hash &&
+	checkpoint_backing_put sweep $($BLOBREF sha1 <sweepdir.blob)
+'
+test_expect_success 'gc keeps blob files stored since the previous gc' '
+	flux content gc >sweep0.json &&
+	test $(jq .removed sweep0.json) -eq 0 &&
+	backing_load <sweepgarbage.hash >/dev/null
+'
+test_expect_success 'gc removes only blob files unreachable from the checkpoint' '
+	flux content gc >sweep.json &&
+	test $(jq .removed sweep.json) -eq 1 &&
+	test $(jq .examined sweep.json) -eq 3 &&
+	backing_load <sweepleaf.hash >/dev/null &&
+	backing_load <sweepdir.hash >/dev/null &&
+	test_must_fail backing_load <sweepgarbage.hash &&
+	test -f $(pwd)/content.files/sweep
+'
+test_expect_success 'gc is reported in module stats' '
+	test $(flux module stats \
+	    --type int --parse gc.cycles content-files) -eq 2 &&
+	test $(flux module stats \
+	    --type int --parse gc.removed content-files) -eq 1
+'
+
+test_expect_success 'gc keeps a blob file stored again since the previous gc' '
+	echo sweepagain | backing_store >sweepagain.hash &&
+	flux content gc >sweepagain1.json &&
+	test $(jq .stored sweepagain1.json) -eq 1 &&
+	echo sweepagain | backing_store >/dev/null &&
+	flux content gc >sweepagain2.json &&
+	test $(jq .stored sweepagain2.json) -eq 1 &&
+	test $(jq .removed sweepagain2.json) -eq 0 &&
+	flux content gc >sweepagain3.json &&
+	test $(jq .removed sweepagain3.json) -eq 1 &&
+	test_must_fail backing_load <sweepagain.hash
 '
 
 test_expect_success 'checkpoint-put foo w/ rootref bar' '
@@ -486,6 +486,78 @@ test_expect_success NO_ASAN 'kvs: clear stats globally' '
         flux exec -n sh -c "flux module stats --parse \"namespace.primary.#no-op stores\" kvs | grep -q 0"
 '
 
+#
+# test replica mode on a leaf broker
+#
+
+LEAF=$((${SIZE}-1))
+
+replica_stat() {
+	flux exec -n -r ${LEAF} flux module stats --parse "cache.replica.$1" kvs
+}
+
+# arg1 - number of walks to exceed
+# arg2 - timeout (seconds)
+wait_replica_walks() {
+	local i=0
+	local iters=$(($2 * 10))
+	while [ $i -lt ${iters} ]
+	do
+	    n=$(replica_stat "#walks")
+	    if [ "$n" -gt $1 ]
+	    then
+		return 0
+	    fi
+	    sleep 0.1
+	    i=$((i + 1))
+	done
+	return 1
+}
+
+test_expect_success 'kvs: reload kvs on leaf broker with replica prefix' '
+	flux exec -n -r ${LEAF} flux module reload kvs replica=$DIR.replica
+'
+test_expect_success 'kvs: replica stats are reported on leaf broker' '
+	flux exec -n -r ${LEAF} \
+	    flux module stats --parse "cache.replica.#prefixes" kvs \
+	    > prefixes.out &&
+	test $(cat prefixes.out) = 1
+'
+test_expect_success 'kvs: leaf broker with replica follows commits' '
+	WALKS=$(replica_stat "#walks") &&
+	flux kvs put $DIR.replica.a=1 $DIR.replica.b.c=2 &&
+	VERS=$(flux kvs version) &&
+	flux exec -n -r ${LEAF} flux kvs wait ${VERS} &&
+	wait_replica_walks ${WALKS} 10
+'
+test_expect_success 'kvs: replica walk pinned objects on leaf broker' '
+	test $(replica_stat "#pinned") -gt 0 &&
+	test $(replica_stat "#errors") -eq 0
+'
+test_expect_success 'kvs: replicated keys can be read on leaf broker' '
+	flux exec -n -r ${LEAF} flux kvs get $DIR.replica.b.c > replica.out &&
+	test $(cat replica.out) = 2
+'
+test_expect_success 'kvs: replica walk completes during a stream of commits' '
+	WALKS=$(replica_stat "#walks") &&
+	i=0 &&
+	while [ $i -lt 200 ]; do \
+	    i=$((i + 1)); \
+	    flux kvs put $DIR.replica.b.c=$i $DIR.replica.seq.$i=$i \
+	        || return 1; \
+	    test $(replica_stat "#walks") -gt ${WALKS} && break; \
+	done &&
+	test $(replica_stat "#walks") -gt ${WALKS} &&
+	test $(replica_stat "#errors") -eq 0 &&
+	VERS=$(flux kvs version) &&
+	flux exec -n -r ${LEAF} flux kvs wait ${VERS} &&
+	flux exec -n -r ${LEAF} flux kvs get $DIR.replica.b.c > replica2.out &&
+	test $(cat replica2.out) = $i
+'
+test_expect_success 'kvs: reload kvs on leaf broker without replica' '
+	flux exec -n -r ${LEAF} flux module reload kvs
+'
+
 #
 # test fence api
 #
@@ -131,4 +131,46 @@ test_expect_success 'kvs: transaction-merge disabling works' '
 	test "$OUTPUT" = "${THREADS}"
 '
 
+# sharded directory tests
+
+test_expect_success 'kvs: reload kvs with small dir-shard-threshold' '
+	flux module reload kvs transaction-merge=0 dir-shard-threshold=16
+'
+test_expect_success 'kvs: store 1000 keys in one sharded dir' '
+	${FLUX_BUILD_DIR}/t/kvs/torture --prefix $DIR.sharded --count 1000
+'
+test_expect_success 'kvs: sharded dir is listed in full' '
+	test $(flux kvs ls -1 $DIR.sharded | wc -l) = 1000
+'
+test_expect_success 'kvs: sharded dir can be walked with dir --at' '
+	DIRREF=$(flux kvs get --treeobj $DIR.sharded) &&
+	test $(flux kvs dir --at $DIRREF . | wc -l) = 1000
+'
+test_expect_success 'kvs: keys can be removed from sharded dir' '
+	flux kvs put $DIR.sharded.extra=42 &&
+	test $(flux kvs get $DIR.sharded.extra) = 42 &&
+	flux kvs unlink $DIR.sharded.extra &&
+	test_must_fail flux kvs get $DIR.sharded.extra
+'
+
+# group commit tests
+
+test_expect_success 'kvs: reload kvs with long group-commit-window' '
+	flux module reload kvs group-commit-window=0.05 group-commit-count=1000
+'
+test_expect_success 'kvs: concurrent commits work with group commit' '
+	THREADS=64 &&
+	OUTPUT=`${FLUX_BUILD_DIR}/t/kvs/transactionmerge ${THREADS} $(basename ${SHARNESS_TEST_FILE})` &&
+	test "$OUTPUT" = "${THREADS}"
+'
+test_expect_success 'kvs: group commit stats are reported' '
+	COMMITS=$(flux module stats --parse "namespace.primary.group commit.#commits" kvs) &&
+	TXNS=$(flux module stats --parse "namespace.primary.group commit.#transactions" kvs) &&
+	test ${COMMITS} -gt 0 &&
+	test ${TXNS} -ge ${COMMITS}
+'
+test_expect_success 'kvs: reload kvs with group commit disabled' '
+	flux module reload kvs group-commit-window=0
+'
+
 test_done
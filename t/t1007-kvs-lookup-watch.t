@@ -323,6 +323,41 @@ hi
         test_cmp expected append4.out
 '
 
+test_expect_success NO_CHAIN_LINT 'flux kvs get: --append delivers only new data after many appends' '
+        flux kvs unlink -Rf test &&
+        flux kvs put test.append.test="a" &&
+        flux kvs get --watch --append --count=21 \
+                     test.append.test > append_many.out 2>&1 &
+        pid=$! &&
+        wait_watcherscount_nonzero primary &&
+        for i in $(seq 1 19); do \
+            flux kvs put --append test.append.test="$i" || return 1; \
+        done &&
+        i=0 &&
+        while [ "$(flux module stats \
+                   --parse namespaces.primary.append-lookups kvs-watch)" \
+                = "0" ] && [ $i -lt ${KVS_WAIT_ITERS} ]; do \
+            sleep 0.1; \
+            i=$((i + 1)); \
+        done &&
+        test $i -lt ${KVS_WAIT_ITERS} &&
+        flux kvs put --append test.append.test="20" &&
+        wait $pid &&
+        (echo a; seq 1 20) >expected &&
+        test_cmp expected append_many.out
+'
+
+test_expect_success NO_CHAIN_LINT 'flux kvs get: --append fails if key becomes a directory' '
+        flux kvs unlink -Rf test &&
+        flux kvs put test.append.test="abc" &&
+        flux kvs get --watch --append --count=2 \
+                     test.append.test > append_dir.out 2>&1 &
+        pid=$! &&
+        wait_watcherscount_nonzero primary &&
+        flux kvs mkdir test.append.test &&
+        ! wait $pid
+'
+
 test_expect_success 'flux kvs get: --append fails on non-value' '
         flux kvs unlink -Rf test &&
         flux kvs mkdir test.append &&
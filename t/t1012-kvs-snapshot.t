@@ -0,0 +1,108 @@
+#!/bin/sh
+#
+
+test_description='Test kvs module snapshot-objects config.'
+
+. `dirname $0`/kvs/kvs-helper.sh
+
+. `dirname $0`/sharness.sh
+
+RPC=${FLUX_BUILD_DIR}/t/request/rpc
+
+export FLUX_CONF_DIR=$(pwd)
+test_under_flux 1 minimal
+
+checkpoint_get() {
+	jq -j -c -n  "{key:\"$1\"}" | $RPC content.checkpoint-get
+}
+
+# arg1 - timeout (seconds)
+wait_warm_loaded() {
+	local i=0
+	local iters=$(($1 * 10))
+	while [ $i -lt ${iters} ]
+	do
+	    n=$(flux module stats --parse "cache.snapshot.#warm loaded" kvs)
+	    if [ "$n" -gt 0 ]
+	    then
+		return 0
+	    fi
+	    sleep 0.1
+	    i=$((i + 1))
+	done
+	return 1
+}
+
+test_expect_success 'configure bad snapshot-objects in kvs' '
+	cat >kvs.toml <<-EOF &&
+	[kvs]
+	snapshot-objects = -1
+	EOF
+	flux config reload &&
+	test_must_fail flux module load kvs
+'
+
+test_expect_success 'configure snapshot-objects, load kvs' '
+	cat >kvs.toml <<-EOF &&
+	[kvs]
+	snapshot-objects = 1000
+	EOF
+	flux config reload &&
+	flux module load content-sqlite &&
+	flux module load kvs
+'
+
+test_expect_success 'kvs: put some data' '
+	for i in $(seq 1 8); do \
+	    flux kvs put test.dir$i.a=$(seq 1 64 | tr -d "\n") || return 1; \
+	done &&
+	flux kvs get test.dir1.a >get1.out
+'
+
+test_expect_success 'kvs: snapshot stats are reported' '
+	flux module stats --parse "cache.snapshot.#saves" kvs
+'
+
+test_expect_success 'kvs: unload kvs saves a snapshot' '
+	flux module remove kvs &&
+	checkpoint_get kvs-snapshot >snapshot.json &&
+	jq -e ".value.count > 0" snapshot.json &&
+	jq -e ".value.snapshotref" snapshot.json
+'
+
+test_expect_success 'kvs: reload kvs warms cache from snapshot' '
+	flux module load kvs &&
+	wait_warm_loaded 5 &&
+	flux module stats --parse "cache.snapshot.#warm errors" kvs >errors.out &&
+	echo 0 >errors.exp &&
+	test_cmp errors.exp errors.out
+'
+
+test_expect_success 'kvs: data is intact after restart' '
+	flux kvs get test.dir1.a >get2.out &&
+	test_cmp get1.out get2.out
+'
+
+test_expect_success 're-config snapshot-objects to disable snapshots' '
+	cat >kvs.toml <<-EOF &&
+	[kvs]
+	snapshot-objects = 0
+	EOF
+	flux config reload &&
+	test_must_fail flux module stats --parse cache.snapshot kvs
+'
+
+test_expect_success 'configure bad snapshot-objects in kvs on reload' '
+	cat >kvs.toml <<-EOF &&
+	[kvs]
+	snapshot-objects = -1
+	EOF
+	test_must_fail flux config reload
+'
+
+test_expect_success 'kvs: remove modules' '
+	flux module remove kvs &&
+	flux module remove content-sqlite
+'
+
+test_done
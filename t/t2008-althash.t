@@ -7,6 +7,7 @@ Start a session with a non-default hash type for content/kvs.'
 
 nil1="sha1-da39a3ee5e6b4b0d3255bfef95601890afd80709"
 nil256="sha256-e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"
+nilblake3="blake3-af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"
 
 # Append --logfile option if FLUX_TESTS_LOGFILE is set in environment:
 test -n "$FLUX_TESTS_LOGFILE" && set -- "$@" --logfile
@@ -38,6 +39,22 @@ test_expect_success 'Started instance with content.hash=sha256,content-files' '
 	ls -1 content.files | tail -1 | grep sha256
 '
 
+test_expect_success 'Started instance with content.hash=blake3' '
+	OUT=$(flux start -o,-Scontent.hash=blake3 \
+	    flux getattr content.hash) &&
+	test "$OUT" = "blake3"
+'
+test_expect_success 'Content store nil returns correct hash for blake3' '
+	OUT=$(flux start -o,-Scontent.hash=blake3 \
+	    flux content store </dev/null) &&
+	test "$OUT" = "$nilblake3"
+'
+test_expect_success 'KVS works with content.hash=blake3' '
+	OUT=$(flux start -o,-Scontent.hash=blake3 \
+	    sh -c "flux kvs put a.b=42 && flux kvs get a.b") &&
+	test "$OUT" = "42"
+'
+
 test_expect_success S3 'create creds.toml from env' '
 	mkdir -p creds &&
 	cat >creds/creds.toml <<-CREDS
@@ -153,6 +153,72 @@ test_expect_success 'submit request with empty payload fails with EPROTO(71)' '
 	${RPC} job-ingest.submit 71 </dev/null
 '
 
+test_expect_success 'job-ingest: create bulk submit script' '
+	cat >bulk.py <<-EOT
+	import sys
+	import flux
+	from flux.job import submit_bulk
+
+	jobspec = open(sys.argv[1]).read()
+	specs = [jobspec if x != "bad" else "{" for x in sys.argv[2:]]
+	for result in submit_bulk(flux.Flux(), specs):
+	    print(result if isinstance(result, OSError) else int(result))
+	EOT
+'
+
+test_expect_success 'job-ingest: submit-bulk returns jobids in order' '
+	flux python bulk.py basic.json ok ok ok >bulk.out &&
+	test $(wc -l <bulk.out) -eq 3 &&
+	sort -n bulk.out | test_cmp - bulk.out &&
+	test $(sort -u bulk.out | wc -l) -eq 3
+'
+
+test_expect_success 'job-ingest: submit-bulk reports per-job errors' '
+	flux python bulk.py basic.json ok bad ok >bulk2.out &&
+	test $(wc -l <bulk2.out) -eq 3 &&
+	sed -n 2p bulk2.out | grep "invalid JSON"
+'
+
+test_expect_success 'job-ingest: submit-bulk with no jobs works' '
+	flux python bulk.py basic.json >bulk3.out &&
+	test_must_be_empty bulk3.out
+'
+
+test_expect_success 'job-ingest: submit-bulk request without jobs fails' '
+	echo "{}" | ${RPC} job-ingest.submit-bulk 71
+'
+
+test_expect_success 'job-ingest: stats report decode threads and latency' '
+	flux module stats job-ingest >stats.json &&
+	jq -e ".decode.threads == 4" <stats.json &&
+	jq -e ".decode.decode.count > 0" <stats.json &&
+	jq -e ".latency.total.count > 0" <stats.json &&
+	jq -e ".latency.commit.count > 0" <stats.json
+'
+
+test_expect_success 'job-ingest: job-ingest fails with bad decode-threads' '
+	test_must_fail flux module reload job-ingest decode-threads=-1 &&
+	test_must_fail flux module load job-ingest decode-threads=x
+'
+
+test_expect_success 'job-ingest: decode-threads=0 decodes on the reactor' '
+	flux module load job-ingest decode-threads=0 &&
+	flux job submit basic.json &&
+	flux module stats job-ingest >stats0.json &&
+	jq -e ".decode.threads == 0" <stats0.json &&
+	jq -e ".decode.decode.count == 1" <stats0.json
+'
+
+test_expect_success 'job-ingest: decode-threads=0 reports decode errors' '
+	${RPC} job-ingest.submit 71 </dev/null
+'
+
+test_expect_success 'job-ingest: jobs submitted concurrently are ingested' '
+	flux module reload job-ingest decode-threads=8 &&
+	flux submit --cc=1-64 hostname >ids.out &&
+	test $(sort -u ids.out | wc -l) -eq 64
+'
+
 test_expect_success 'job-ingest: reload dummy job-manager in fail mode' '
 	ingest_module reload batch-count=4 &&
 	flux module remove job-manager &&
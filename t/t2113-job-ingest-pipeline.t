@@ -15,17 +15,30 @@ test_expect_success 'no workers are running at the start' '
 test_expect_success 'run a job with no ingest configuration' '
 	flux run /bin/true
 '
-test_expect_success 'one validator, no frobnicator started' '
+test_expect_success 'job was validated in-process, no workers started' '
 	flux module stats job-ingest >stats2.out &&
 	jq -e ".pipeline.frobnicator.running == 0" <stats2.out &&
-	jq -e ".pipeline.validator.running == 1" <stats2.out
+	jq -e ".pipeline.validator.running == 0" <stats2.out &&
+	jq -e ".pipeline.builtin.plugins == \"jobspec\"" <stats2.out &&
+	jq -e ".pipeline.builtin.requests == 1" <stats2.out
 '
-test_expect_success 'configure frobnicator' '
+test_expect_success 'create a site validator plugin' '
+	cat >site.py <<-EOT
+	from flux.job.validator import ValidatorPlugin
+
+	class Validator(ValidatorPlugin):
+	    def validate(self, args):
+	        pass
+	EOT
+'
+test_expect_success 'configure frobnicator and site validator plugin' '
 	flux config load <<-EOT
 	[policy.jobspec.defaults.system]
 	duration = "10s"
 	[ingest.frobnicator]
 	plugins = [ "defaults" ]
+	[ingest.validator]
+	plugins = [ "jobspec", "$(pwd)/site.py" ]
 	EOT
 '
 test_expect_success 'run a job with unspecified duration' '
@@ -84,11 +97,25 @@ test_expect_success 'job was neither frobbed nor validated' '
 test_expect_success 'run a job' '
 	flux run /bin/true
 '
-test_expect_success 'job was validated but not frobbed' '
+test_expect_success 'job was validated in-process but not frobbed' '
 	flux module stats job-ingest >stats8.out &&
 	jq -r ".pipeline.frobnicator.requests" <stats8.out >frob4.count &&
 	jq -r ".pipeline.validator.requests" <stats8.out >val4.count &&
+	jq -r ".pipeline.builtin.requests" <stats7.out >builtin3.count &&
+	jq -r ".pipeline.builtin.requests" <stats8.out >builtin4.count &&
 	test_cmp frob3.count frob4.count &&
-	test_must_fail test_cmp val3.count val4.count
+	test_cmp val3.count val4.count &&
+	test_must_fail test_cmp builtin3.count builtin4.count
+'
+test_expect_success 'invalid jobspec is rejected in-process' '
+	flux run --dry-run /bin/true | jq ".foo = 1" >bad.json &&
+	test_must_fail flux job submit bad.json 2>bad.err &&
+	grep "Extraneous key (foo)" bad.err
+'
+test_expect_success 'unknown validator args require an external plugin' '
+	test_must_fail flux config load <<-EOT
+	[ingest.validator]
+	args = [ "--foo" ]
+	EOT
 '
 test_done
@@ -9,6 +9,7 @@ test_description='Test flux job info service eventlog watch'
 test_under_flux 4 job
 
 RPC=${FLUX_BUILD_DIR}/t/request/rpc
+RPC_STREAM=${FLUX_BUILD_DIR}/t/request/rpc_stream
 
 fj_wait_event() {
 	flux job wait-event --timeout=20 "$@"
@@ -346,6 +347,64 @@ test_expect_success NO_CHAIN_LINT 'flux job wait-event -p guest.exec.eventlog wo
 	flux cancel ${jobidall}
 '
 
+#
+# eventlog-watch start
+#
+
+# Usage: watch_from jobid path start
+watch_from() {
+	printf "{\"id\":%s,\"path\":\"%s\",\"flags\":0,\"start\":%s}" \
+	    $(flux job id $1) $2 $3 \
+	    | run_timeout 20 ${RPC_STREAM} job-info.eventlog-watch
+}
+
+test_expect_success 'eventlog-watch start=2 skips the first two events' '
+	jobid=$(submit_job) &&
+	flux job eventlog -f json $jobid | jq -r .name | tail -n +3 >start2.exp &&
+	test_must_fail watch_from $jobid eventlog 2 >start2.json 2>start2.err &&
+	grep "No data available" start2.err &&
+	jq -r .event start2.json | jq -r .name >start2.out &&
+	test_cmp start2.exp start2.out
+'
+test_expect_success 'eventlog-watch start=0 returns the whole eventlog' '
+	jobid=$(submit_job) &&
+	flux job eventlog -f json $jobid | jq -r .name >start0.exp &&
+	test_must_fail watch_from $jobid eventlog 0 >start0.json &&
+	jq -r .event start0.json | jq -r .name >start0.out &&
+	test_cmp start0.exp start0.out
+'
+test_expect_success 'eventlog-watch start past the end of an inactive job ends' '
+	jobid=$(submit_job) &&
+	test_must_fail watch_from $jobid eventlog 1000 >start1000.json \
+	    2>start1000.err &&
+	grep "No data available" start1000.err &&
+	test_must_be_empty start1000.json
+'
+test_expect_success 'eventlog-watch start works on guest.exec.eventlog' '
+	jobid=$(submit_job) &&
+	flux job eventlog -f json -p guest.exec.eventlog $jobid \
+	    | jq -r .name | tail -n +2 >guest1.exp &&
+	test_must_fail watch_from $jobid guest.exec.eventlog 1 >guest1.json &&
+	jq -r .event guest1.json | jq -r .name >guest1.out &&
+	test_cmp guest1.exp guest1.out
+'
+test_expect_success NO_CHAIN_LINT 'eventlog-watch start works on a live job' '
+	jobid=$(submit_job_live sleeplong.json)
+	watch_from $jobid eventlog 3 >live.json 2>live.err &
+	pid=$! &&
+	wait_watchers_nonzero "watchers" &&
+	flux cancel $jobid &&
+	! wait $pid &&
+	flux job eventlog -f json $jobid | jq -r .name | tail -n +4 >live.exp &&
+	jq -r .event live.json | jq -r .name >live.out &&
+	test_cmp live.exp live.out
+'
+test_expect_success 'eventlog-watch with negative start fails with EPROTO' '
+	jobid=$(submit_job) &&
+	test_must_fail watch_from $jobid eventlog -1 2>negstart.err &&
+	grep "start must be a non-negative integer" negstart.err
+'
+
 #
 # stats & corner cases
 #
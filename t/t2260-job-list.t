@@ -474,6 +474,49 @@ test_expect_success 'flux job list-inactive w/ since (middle timestamp #2)' '
 '
 
 
+# job-list.list cursor
+
+test_expect_success 'job-list.list returns cursor when max_entries is reached' '
+	id=$(id -u) &&
+	state=`${JOB_CONV} strtostate INACTIVE` &&
+	$jq -j -c -n  "{max_entries:5, userid:${id}, states:${state}, results:0, attrs:[]}" \
+	  | $RPC job-list.list > cursor_page1.out &&
+	$jq -e ".jobs | length == 5" cursor_page1.out &&
+	$jq -e ".cursor == .jobs[4].id" cursor_page1.out
+'
+
+test_expect_success 'job-list.list does not return cursor when list is complete' '
+	id=$(id -u) &&
+	state=`${JOB_CONV} strtostate INACTIVE` &&
+	$jq -j -c -n  "{max_entries:1000, userid:${id}, states:${state}, results:0, attrs:[]}" \
+	  | $RPC job-list.list > cursor_all.out &&
+	$jq -e ".cursor == null" cursor_all.out
+'
+
+test_expect_success 'job-list.list pages through all inactive jobs with cursor' '
+	id=$(id -u) &&
+	state=`${JOB_CONV} strtostate INACTIVE` &&
+	cursor=0 &&
+	: >cursor_paged.ids &&
+	for i in $(seq 1 20); do
+		$jq -j -c -n  "{max_entries:5, userid:${id}, states:${state}, results:0, attrs:[], cursor:${cursor}}" \
+		  | $RPC job-list.list > cursor_page.out &&
+		$jq ".jobs[].id" cursor_page.out >> cursor_paged.ids &&
+		cursor=$($jq ".cursor // 0" cursor_page.out) &&
+		if test $cursor -eq 0; then break; fi
+	done &&
+	$jq .id list-inactive.out > cursor_expected.ids &&
+	test_cmp cursor_expected.ids cursor_paged.ids
+'
+
+test_expect_success 'job-list.list fails with unknown cursor' '
+	id=$(id -u) &&
+	$jq -j -c -n  "{max_entries:5, userid:${id}, states:0, results:0, attrs:[], cursor:1}" \
+	  | $listRPC > cursor_bad.out &&
+	grep "errno 2" cursor_bad.out
+'
+
+
 # job list-id
 
 test_expect_success 'flux job list-ids works with a single ID' '
@@ -262,6 +262,38 @@ test_expect_success 'sched-simple: there are no outstanding sched requests' '
 	grep "0 free requests pending to scheduler" queue_status.out
 '
 
+test_expect_success 'sched-simple: load with invalid backfill depth fails' '
+	test_must_fail flux module load sched-simple backfill=foo &&
+	test_must_fail flux module load sched-simple backfill=-1
+'
+test_expect_success 'sched-simple: load sched-simple with backfill enabled' '
+	flux module load sched-simple backfill=8 &&
+	test "$($query)" = "rank[0-1]/core[0-1]"
+'
+test_expect_success 'sched-simple: submit a job using 3 of 4 cores' '
+	flux submit -n3 -t 100s hostname >bf1.id &&
+	flux job wait-event --timeout=5.0 $(cat bf1.id) alloc
+'
+test_expect_success 'sched-simple: job needing all cores is blocked' '
+	flux submit -n4 -t 100s hostname >bf2.id &&
+	flux job wait-event --timeout=5.0 $(cat bf2.id) priority
+'
+test_expect_success 'sched-simple: job without a time limit is not backfilled' '
+	flux submit -n1 hostname >bf3.id &&
+	flux job wait-event --timeout=5.0 $(cat bf3.id) priority &&
+	test_must_fail flux job wait-event --timeout=0.5 $(cat bf3.id) alloc
+'
+test_expect_success 'sched-simple: short job is backfilled ahead of blocked jobs' '
+	flux submit -n1 -t 10s hostname >bf4.id &&
+	flux job wait-event --timeout=5.0 $(cat bf4.id) alloc &&
+	test "$($query)" = "" &&
+	test_must_fail flux job wait-event --timeout=0.1 $(cat bf2.id) alloc
+'
+test_expect_success 'sched-simple: remove sched-simple and cancel backfill jobs' '
+	flux module remove sched-simple &&
+	flux cancel --all
+'
+
 test_expect_success 'sched-simple: load sched-simple and wait for queue drain' '
 	flux module load sched-simple &&
 	run_timeout 30 flux queue drain